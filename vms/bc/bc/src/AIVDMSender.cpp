@@ -1,17 +1,18 @@
 #include "./AIVDMSender.hpp"
 
 #include <boost/archive/text_oarchive.hpp>
-#include <iomanip>
 #include <sstream>
 
 #include "./AIS.hpp"
 #include "./BcProxyMessages.hpp"
-#include "./NMEA.hpp"
+#include "./NMEACodec.hpp"
 
 AivdmSender::AivdmSender(SimulationModel *model, irr::IrrlichtDevice *dev,
-                         std::string snd_address, std::string snd_port) {
+                         std::string snd_address, std::string snd_port,
+                         std::string transport, CoSimChannel *cosim) {
   this->model = model;
   this->device = dev;
+  this->cosim = cosim;
 
   this->messages = std::vector<std::string>();
 
@@ -20,6 +21,18 @@ AivdmSender::AivdmSender(SimulationModel *model, irr::IrrlichtDevice *dev,
 
   this->receiver_endpoint = *resolver.resolve(query);
   this->snd_socket = new asio::ip::udp::socket(io_service);
+
+  this->use_shm = false;
+  if (transport == "shm") {
+    if (this->aivdm_channel.open(SHM_AIVDM_CHANNEL,
+                                 ShmChannel<AivdmRecord>::PRODUCER)) {
+      device->getLogger()->log(
+          "Could not open shared memory channel to the AIS proxy, falling "
+          "back to UDP");
+    } else {
+      this->use_shm = true;
+    }
+  }
 }
 
 void AivdmSender::send_aivdm() {
@@ -38,13 +51,14 @@ void AivdmSender::send_aivdm() {
     std::string ais_payload;
     int fill_bits;
     std::tie(ais_payload, fill_bits) = AIS::generateClassAReport(model, ship);
-    std::ostringstream nmea_s;
-    nmea_s << "!AIVDM," << fragments << "," << fragment_number << ","
-           << "," << radio_channel << "," << ais_payload << "," << fill_bits;
+    NMEASentence nmea;
+    if (!encodeAIVDM(nmea, fragments, fragment_number, radio_channel,
+                     ais_payload.c_str(), fill_bits))
+      continue;
 
     // build AivdmMessae struct with unencoded information
     AivdmMessage message;
-    message.message = add_nmea_checksum(nmea_s.str());
+    message.message.assign(nmea.c_str(), nmea.length());
     // always class A reports
     message.message_type = 1;
     // MMSI of a ship should always exist after at least one
@@ -63,6 +77,13 @@ void AivdmSender::send_aivdm() {
     message.course_over_ground = model->getOtherShipHeading(ship);
     message.true_heading = model->getOtherShipHeading(ship);
 
+    if (this->use_shm) {
+      if (this->aivdm_channel.send(to_record(message)) && this->cosim) {
+        this->cosim->count_sent(COSIM_AIVDM);
+      }
+      continue;
+    }
+
     // serialize and enqueue
     std::ostringstream archive_stream;
     boost::archive::text_oarchive archive(archive_stream);
@@ -78,6 +99,7 @@ void AivdmSender::send_aivdm() {
         this->snd_socket->open(asio::ip::udp::v4());
       for (auto message : this->messages) {
         this->snd_socket->send_to(asio::buffer(message), receiver_endpoint);
+        if (this->cosim) this->cosim->count_sent(COSIM_AIVDM);
       }
       this->messages.clear();
     } catch (std::exception &e) {
@@ -85,17 +107,3 @@ void AivdmSender::send_aivdm() {
     }
   }
 }
-
-std::string AivdmSender::add_nmea_checksum(std::string msg) {
-  irr::u32 len = msg.length();
-  // checksum cannot be a u8 otherwise it will be treated as char by the
-  // ostringstream!
-  irr::u32 checksum = 0;
-  for (int i = 1; i < msg.length(); ++i) {
-    checksum ^= msg.at(i);
-  }
-  std::ostringstream res;
-  res << msg << "*" << std::setfill('0') << std::setw(2) << std::uppercase
-      << std::hex << checksum << "\r\n";
-  return res.str();
-}
@@ -4,7 +4,10 @@
 #include <string>
 #include <vector>
 
+#include "BcProxyMessages.hpp"
+#include "CoSimChannel.h"
 #include "IrrlichtDevice.h"
+#include "ShmChannel.h"
 #include "SimulationModel.hpp"
 #include "libs/asio/include/asio/io_service.hpp"
 #include "libs/asio/include/asio/ip/udp.hpp"
@@ -12,16 +15,21 @@
 class AivdmSender {
  public:
   AivdmSender(SimulationModel* model, irr::IrrlichtDevice* dev,
-              std::string snd_address, std::string snd_port);
+              std::string snd_address, std::string snd_port,
+              std::string transport, CoSimChannel* cosim = nullptr);
   void send_aivdm();
 
  private:
-  std::string add_nmea_checksum(std::string);
-
   asio::io_service io_service;
   asio::ip::udp::endpoint receiver_endpoint;
   asio::ip::udp::socket* snd_socket;
 
+  // shared memory transport for a co-located proxy, UDP otherwise
+  bool use_shm;
+  ShmChannel<AivdmRecord> aivdm_channel;
+  // message counters of the lockstep co-simulation, if enabled
+  CoSimChannel* cosim;
+
   irr::IrrlichtDevice* device;
   SimulationModel* model;
 
@@ -43,7 +43,7 @@ namespace scene
 	TerrainData(patchSize, maxLOD, position, rotation, scale), RenderBuffer(0),
 	VerticesToRender(0), IndicesToRender(0), DynamicSelectorUpdate(false),
 	OverrideDistanceThreshold(false), UseDefaultRotationPivot(true), ForceRecalculation(true),
-	FixedBorderLOD(-1),
+	FixedBorderLOD(-1), TransformationCount(0),
 	CameraMovementDelta(10.0f), CameraRotationDelta(1.0f),CameraFOVDelta(0.1f),
 	TCoordScale1(1.0f), TCoordScale2(1.0f), SmoothFactor(0), FileSystem(fs), dev(device)
 	{
@@ -772,6 +772,7 @@ namespace scene
 
 		calculateDistanceThresholds(true);
 		calculatePatchData();
+		++TransformationCount;
 
 		RenderBuffer->setDirty(EBT_VERTEX);
 	}
@@ -804,8 +805,14 @@ namespace scene
 			return;
 
 		// Determine the camera rotation, based on the camera direction.
-		const core::vector3df cameraPosition = camera->getAbsolutePosition();
-		const core::vector3df cameraRotation = core::line3d<f32>(cameraPosition, camera->getTarget()).getVector().getHorizontalAngle();
+		// JAMES: In the coordinates of the vertices, which are moved by the parent (the world root), not rewritten
+		core::matrix4 toTerrain;
+		AbsoluteTransformation.getInverse(toTerrain);
+		core::vector3df cameraPosition = camera->getAbsolutePosition();
+		core::vector3df cameraTarget = camera->getTarget();
+		toTerrain.transformVect(cameraPosition);
+		toTerrain.transformVect(cameraTarget);
+		const core::vector3df cameraRotation = core::line3d<f32>(cameraPosition, cameraTarget).getVector().getHorizontalAngle();
 		core::vector3df cameraUp = camera->getUpVector();
 		cameraUp.normalize();
 		const f32 CameraFOV = SceneManager->getActiveCamera()->getFOV();
@@ -847,16 +854,21 @@ namespace scene
 		if (!camera)
 			return;
 
-		const core::vector3df cameraPosition = camera->getAbsolutePosition();
+		// JAMES: Camera and frustum brought into the coordinates of the vertices, see preRenderCalculationsIfNeeded()
+		core::matrix4 toTerrain;
+		AbsoluteTransformation.getInverse(toTerrain);
+		core::vector3df cameraPosition = camera->getAbsolutePosition();
+		toTerrain.transformVect(cameraPosition);
 
-		const SViewFrustum* frustum = camera->getViewFrustum();
+		core::aabbox3df frustumBox = camera->getViewFrustum()->getBoundingBox();
+		toTerrain.transformBoxEx(frustumBox);
 
 		// Determine each patches LOD based on distance from camera (and whether or not they are in
 		// the view frustum).
 		const s32 count = TerrainData.PatchCount * TerrainData.PatchCount;
 		for (s32 j = 0; j < count; ++j)
 		{
-			if (frustum->getBoundingBox().intersectsWithBox(TerrainData.Patches[j].BoundingBox))
+			if (frustumBox.intersectsWithBox(TerrainData.Patches[j].BoundingBox))
 			{
 				const f32 distance = cameraPosition.getDistanceFromSQ(TerrainData.Patches[j].Center);
 
@@ -961,7 +973,8 @@ namespace scene
 
 		video::IVideoDriver* driver = SceneManager->getVideoDriver();
 
-		driver->setTransform (video::ETS_WORLD, core::IdentityMatrix);
+		// JAMES: The vertices are in the coordinates of the parent, so moving the parent moves the terrain
+		driver->setTransform (video::ETS_WORLD, AbsoluteTransformation);
 		driver->setMaterial(Mesh->getMeshBuffer(0)->getMaterial());
 
 		RenderBuffer->getIndexBuffer().set_used(IndicesToRender);
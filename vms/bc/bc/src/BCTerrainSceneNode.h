@@ -321,6 +321,8 @@ namespace scene
 		bool UseDefaultRotationPivot;
 		bool ForceRecalculation;
 		s32 FixedBorderLOD;
+		//! Bumped on every applyTransformation(), so the selector knows when its triangles are stale
+		u32 TransformationCount;
 
 		core::vector3df	OldCameraPosition;
 		core::vector3df	OldCameraRotation;
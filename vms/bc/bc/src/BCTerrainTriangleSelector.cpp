@@ -14,7 +14,7 @@ namespace scene
 
 //! constructor
 BCTerrainTriangleSelector::BCTerrainTriangleSelector ( ITerrainSceneNode* node, s32 LOD )
-	: SceneNode(node)
+	: SceneNode(node), LOD(LOD), TransformationCount(0)
 {
 	#ifdef _DEBUG
 	setDebugName ("BCTerrainTriangleSelector");
@@ -34,17 +34,33 @@ BCTerrainTriangleSelector::~BCTerrainTriangleSelector()
 //! Clears and sets triangle data
 void BCTerrainTriangleSelector::setTriangleData(ITerrainSceneNode* node, s32 LOD)
 {
+	this->LOD = LOD;
+	fetchTriangles(node);
+}
+
+
+//! Fetches the triangles of the node at the current LOD
+void BCTerrainTriangleSelector::fetchTriangles(ITerrainSceneNode* node) const
+{
+	BCTerrainSceneNode* terrain = static_cast<BCTerrainSceneNode*>(node);
+	TransformationCount = terrain->TransformationCount;
+
 	// Get pointer to the GeoMipMaps vertices
 	const video::S3DVertex2TCoords* vertices = static_cast<const video::S3DVertex2TCoords*>(node->getRenderBuffer()->getVertices());
 
 	// Clear current data
-	const s32 count = (static_cast<BCTerrainSceneNode*>(node))->TerrainData.PatchCount;
+	const s32 count = terrain->TerrainData.PatchCount;
 	TrianglePatches.TotalTriangles = 0;
 	TrianglePatches.NumPatches = count*count;
 
-	TrianglePatches.TrianglePatchArray.reallocate(TrianglePatches.NumPatches);
-	for (s32 o=0; o<TrianglePatches.NumPatches; ++o)
-		TrianglePatches.TrianglePatchArray.push_back(SGeoMipMapTrianglePatch());
+	// Keep the patches and their triangle arrays when fetching again
+	if (TrianglePatches.TrianglePatchArray.size() != (u32)TrianglePatches.NumPatches)
+	{
+		TrianglePatches.TrianglePatchArray.clear();
+		TrianglePatches.TrianglePatchArray.reallocate(TrianglePatches.NumPatches);
+		for (s32 o=0; o<TrianglePatches.NumPatches; ++o)
+			TrianglePatches.TrianglePatchArray.push_back(SGeoMipMapTrianglePatch());
+	}
 
 	core::triangle3df tri;
 	core::array<u32> indices;
@@ -53,24 +69,182 @@ void BCTerrainTriangleSelector::setTriangleData(ITerrainSceneNode* node, s32 LOD
 	{
 		for(s32 z = 0; z < count; ++z )
 		{
-			TrianglePatches.TrianglePatchArray[tIndex].NumTriangles = 0;
-			TrianglePatches.TrianglePatchArray[tIndex].Box = node->getBoundingBox( x, z );
-			u32 indexCount = node->getIndicesForPatch( indices, x, z, LOD );
-
-			TrianglePatches.TrianglePatchArray[tIndex].Triangles.reallocate(indexCount/3);
-			for(u32 i = 0; i < indexCount; i += 3 )
+			SGeoMipMapTrianglePatch& patch = TrianglePatches.TrianglePatchArray[tIndex];
+			patch.NumTriangles = 0;
+			patch.Box = node->getBoundingBox( x, z );
+			// negative for a patch that is not visible at the current LOD
+			const s32 indexCount = core::max_(node->getIndicesForPatch( indices, x, z, LOD ), 0);
+
+			patch.Triangles.set_used(0);
+			patch.Triangles.reallocate(indexCount/3);
+			for(s32 i = 0; i < indexCount; i += 3 )
 			{
 				tri.pointA = vertices[indices[i+0]].Pos;
 				tri.pointB = vertices[indices[i+1]].Pos;
 				tri.pointC = vertices[indices[i+2]].Pos;
-				TrianglePatches.TrianglePatchArray[tIndex].Triangles.push_back(tri);
-				++TrianglePatches.TrianglePatchArray[tIndex].NumTriangles;
+				patch.Triangles.push_back(tri);
+				++patch.NumTriangles;
 			}
 
-			TrianglePatches.TotalTriangles += TrianglePatches.TrianglePatchArray[tIndex].NumTriangles;
+			TrianglePatches.TotalTriangles += patch.NumTriangles;
 			++tIndex;
 		}
 	}
+
+	PatchTree.set_used(0);
+	PatchTree.reallocate(core::max_(2*TrianglePatches.NumPatches-1, 0));
+	if (TrianglePatches.NumPatches > 0)
+		buildPatchTree(0, TrianglePatches.NumPatches);
+}
+
+
+//! Builds the hierarchy node for a range of patches, returns its index
+s32 BCTerrainTriangleSelector::buildPatchTree(s32 firstPatch, s32 patchCount) const
+{
+	// Children split the range in patch order, so visiting the first child
+	// first yields the patches in the same order as a linear scan
+	const s32 index = PatchTree.size();
+	SPatchTreeNode node;
+	node.Box = TrianglePatches.TrianglePatchArray[firstPatch].Box;
+	node.FirstPatch = firstPatch;
+	node.PatchCount = patchCount;
+	node.SecondChild = -1;
+	PatchTree.push_back(node);
+
+	if (patchCount > 1)
+	{
+		const s32 half = patchCount/2;
+		buildPatchTree(firstPatch, half);
+		const s32 second = buildPatchTree(firstPatch + half, patchCount - half);
+		PatchTree[index].SecondChild = second;
+		PatchTree[index].Box.addInternalBox(PatchTree[index+1].Box);
+		PatchTree[index].Box.addInternalBox(PatchTree[second].Box);
+	}
+	return index;
+}
+
+
+//! Fetches the triangles again if the node has been transformed since
+void BCTerrainTriangleSelector::updateIfTransformed() const
+{
+	if (static_cast<BCTerrainSceneNode*>(SceneNode)->TransformationCount != TransformationCount)
+		fetchTriangles(SceneNode);
+}
+
+
+namespace
+{
+	bool intersects(const core::aabbox3df& patchBox, const core::aabbox3df& box)
+	{
+		return patchBox.intersectsWithBox(box);
+	}
+
+	bool intersects(const core::aabbox3df& patchBox, const core::line3d<f32>& line)
+	{
+		return patchBox.intersectsWithLine(line);
+	}
+
+	// null for the identity, so the triangles can be copied as they are
+	const core::matrix4* nonIdentity(const core::matrix4* transform)
+	{
+		return (transform && !transform->isIdentity()) ? transform : 0;
+	}
+}
+
+
+//! The given transformation followed by the node's absolute one, null for the identity
+const core::matrix4* BCTerrainTriangleSelector::getTransform(const core::matrix4* transform,
+		bool useNodeTransform, core::matrix4& outTransform) const
+{
+	if (!useNodeTransform || SceneNode->getAbsoluteTransformation().isIdentity())
+		return nonIdentity(transform);
+
+	// Multiplied in the same order as CTriangleSelector does
+	if (transform)
+		outTransform = *transform;
+	else
+		outTransform.makeIdentity();
+	outTransform *= SceneNode->getAbsoluteTransformation();
+	return &outTransform;
+}
+
+
+//! Brings a box into the coordinates of the triangles, false if the node is scaled to nothing
+bool BCTerrainTriangleSelector::toNodeSpace(core::aabbox3df& box) const
+{
+	const core::matrix4& absolute = SceneNode->getAbsoluteTransformation();
+	if (absolute.isIdentity())
+		return true;
+
+	core::matrix4 inverse(core::matrix4::EM4CONST_NOTHING);
+	if (!absolute.getInverse(inverse))
+		return false;
+	inverse.transformBoxEx(box);
+	return true;
+}
+
+
+//! Brings a line into the coordinates of the triangles, false if the node is scaled to nothing
+bool BCTerrainTriangleSelector::toNodeSpace(core::line3d<f32>& line) const
+{
+	const core::matrix4& absolute = SceneNode->getAbsoluteTransformation();
+	if (absolute.isIdentity())
+		return true;
+
+	core::matrix4 inverse(core::matrix4::EM4CONST_NOTHING);
+	if (!absolute.getInverse(inverse))
+		return false;
+	inverse.transformVect(line.start);
+	inverse.transformVect(line.end);
+	return true;
+}
+
+
+//! Appends the triangles of the patches in a node which intersect the shape
+template <class T>
+void BCTerrainTriangleSelector::getPatchTriangles(s32 treeNode, const T& shape,
+		core::triangle3df* triangles, s32 count, s32& tIndex,
+		const core::matrix4* transform) const
+{
+	const SPatchTreeNode& node = PatchTree[treeNode];
+	if (!intersects(node.Box, shape))
+		return;
+
+	if (node.SecondChild < 0)
+	{
+		if (tIndex + TrianglePatches.TrianglePatchArray[node.FirstPatch].NumTriangles <= count)
+			copyPatch(node.FirstPatch, triangles, tIndex, transform);
+		return;
+	}
+
+	getPatchTriangles(treeNode+1, shape, triangles, count, tIndex, transform);
+	getPatchTriangles(node.SecondChild, shape, triangles, count, tIndex, transform);
+}
+
+
+//! Appends the triangles of a patch
+void BCTerrainTriangleSelector::copyPatch(s32 patch, core::triangle3df* triangles,
+		s32& tIndex, const core::matrix4* transform) const
+{
+	const SGeoMipMapTrianglePatch& trianglePatch = TrianglePatches.TrianglePatchArray[patch];
+
+	if (!transform)
+	{
+		for (s32 j=0; j<trianglePatch.NumTriangles; ++j)
+			triangles[tIndex++] = trianglePatch.Triangles[j];
+		return;
+	}
+
+	for (s32 j=0; j<trianglePatch.NumTriangles; ++j)
+	{
+		triangles[tIndex] = trianglePatch.Triangles[j];
+
+		transform->transformVect(triangles[tIndex].pointA);
+		transform->transformVect(triangles[tIndex].pointB);
+		transform->transformVect(triangles[tIndex].pointC);
+
+		++tIndex;
+	}
 }
 
 
@@ -80,31 +254,22 @@ void BCTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 			const core::matrix4* transform, bool useNodeTransform, 
 			irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
+	updateIfTransformed();
+
 	s32 count = TrianglePatches.TotalTriangles;
 
 	if (count > arraySize)
 		count = arraySize;
 
-	core::matrix4 mat;
-
-	if (transform)
-		mat = (*transform);
+	core::matrix4 nodeTransform(core::matrix4::EM4CONST_NOTHING);
+	const core::matrix4* mat = getTransform(transform, useNodeTransform, nodeTransform);
 
 	s32 tIndex = 0;
 
 	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
 	{
 		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count)
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
-			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
-
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
-
-				++tIndex;
-			}
+			copyPatch(i, triangles, tIndex, mat);
 	}
 
 	if ( outTriangleInfo )
@@ -127,33 +292,29 @@ void BCTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
+	updateIfTransformed();
+
+	// The box is where the triangles are returned, before the given transformation
+	core::aabbox3df nodeBox(box);
+	if (useNodeTransform && !toNodeSpace(nodeBox))
+	{
+		// Scaled to nothing, so return everything, as CTriangleSelector does
+		getTriangles(triangles, arraySize, outTriangleCount, transform, useNodeTransform, outTriangleInfo);
+		return;
+	}
+
 	s32 count = TrianglePatches.TotalTriangles;
 
 	if (count > arraySize)
 		count = arraySize;
 
-	core::matrix4 mat;
-
-	if (transform)
-		mat = (*transform);
+	core::matrix4 nodeTransform(core::matrix4::EM4CONST_NOTHING);
+	const core::matrix4* mat = getTransform(transform, useNodeTransform, nodeTransform);
 
 	s32 tIndex = 0;
 
-	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
-	{
-		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count &&
-			TrianglePatches.TrianglePatchArray[i].Box.intersectsWithBox(box))
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
-			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
-
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
-
-				++tIndex;
-			}
-	}
+	if (PatchTree.size())
+		getPatchTriangles(0, nodeBox, triangles, count, tIndex, mat);
 
 	if ( outTriangleInfo )
 	{
@@ -174,32 +335,25 @@ void BCTerrainTriangleSelector::getTriangles(core::triangle3df* triangles,
 		const core::matrix4* transform, bool useNodeTransform, 
 		irr::core::array<SCollisionTriangleRange>* outTriangleInfo) const
 {
-	const s32 count = core::min_((s32)TrianglePatches.TotalTriangles, arraySize);
-
-	core::matrix4 mat;
+	updateIfTransformed();
 
-	if (transform)
-		mat = (*transform);
+	// The line is where the triangles are returned, before the given transformation
+	core::line3d<f32> nodeLine(line);
+	if (useNodeTransform && !toNodeSpace(nodeLine))
+	{
+		getTriangles(triangles, arraySize, outTriangleCount, transform, useNodeTransform, outTriangleInfo);
+		return;
+	}
 
-	s32 tIndex = 0;
+	const s32 count = core::min_((s32)TrianglePatches.TotalTriangles, arraySize);
 
-	for (s32 i=0; i<TrianglePatches.NumPatches; ++i)
-	{
-		if (tIndex + TrianglePatches.TrianglePatchArray[i].NumTriangles <= count
-            && TrianglePatches.TrianglePatchArray[i].Box.intersectsWithLine(line))
-		{
-			for (s32 j=0; j<TrianglePatches.TrianglePatchArray[i].NumTriangles; ++j)
-			{
-				triangles[tIndex] = TrianglePatches.TrianglePatchArray[i].Triangles[j];
+	core::matrix4 nodeTransform(core::matrix4::EM4CONST_NOTHING);
+	const core::matrix4* mat = getTransform(transform, useNodeTransform, nodeTransform);
 
-				mat.transformVect(triangles[tIndex].pointA);
-				mat.transformVect(triangles[tIndex].pointB);
-				mat.transformVect(triangles[tIndex].pointC);
+	s32 tIndex = 0;
 
-				++tIndex;
-			}
-		}
-	}
+	if (PatchTree.size())
+		getPatchTriangles(0, nodeLine, triangles, count, tIndex, mat);
 
 	if ( outTriangleInfo )
 	{
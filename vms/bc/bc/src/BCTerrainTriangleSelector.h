@@ -24,6 +24,13 @@ class ITerrainSceneNode;
 developed by Spintz. He made it available for Irrlicht and allowed it to be
 distributed under this license. I only modified some parts. A lot of thanks go
 to him.
+
+The triangles are kept as the node's vertices are, with the node's own
+position, scale and rotation applied, and are only fetched again from the
+node after it has been moved, scaled or rotated. The node's absolute
+transformation, which moves it with its parent, is applied to the triangles
+a query returns when useNodeTransform is set. Box and line queries descend
+a bounding box hierarchy over the patches instead of testing every patch.
 */
 class BCTerrainTriangleSelector : public ITriangleSelector
 {
@@ -73,6 +80,45 @@ private:
 
 	friend class BCTerrainSceneNode;
 
+	//! Node of the bounding box hierarchy over the patches. Each node holds a
+	//! range of patch indices, its first child directly follows it.
+	struct SPatchTreeNode
+	{
+		core::aabbox3df Box;
+		s32 FirstPatch;
+		s32 PatchCount;
+		s32 SecondChild;
+	};
+
+	//! Fetches the triangles of the node at the current LOD
+	void fetchTriangles(ITerrainSceneNode* node) const;
+
+	//! Builds the hierarchy node for a range of patches, returns its index
+	s32 buildPatchTree(s32 firstPatch, s32 patchCount) const;
+
+	//! Fetches the triangles again if the node has been transformed since
+	void updateIfTransformed() const;
+
+	//! The given transformation followed by the node's absolute one, null
+	//! for the identity
+	const core::matrix4* getTransform(const core::matrix4* transform,
+		bool useNodeTransform, core::matrix4& outTransform) const;
+
+	//! Brings a box or line into the coordinates of the triangles, false if
+	//! the node is scaled to nothing
+	bool toNodeSpace(core::aabbox3df& box) const;
+	bool toNodeSpace(core::line3d<f32>& line) const;
+
+	//! Appends the triangles of the patches in a node which intersect the shape
+	template <class T>
+	void getPatchTriangles(s32 treeNode, const T& shape,
+		core::triangle3df* triangles, s32 count, s32& tIndex,
+		const core::matrix4* transform) const;
+
+	//! Appends the triangles of a patch
+	void copyPatch(s32 patch, core::triangle3df* triangles, s32& tIndex,
+		const core::matrix4* transform) const;
+
 	struct SGeoMipMapTrianglePatch
 	{
 		core::array<core::triangle3df> Triangles;
@@ -93,7 +139,12 @@ private:
 	};
 
 	ITerrainSceneNode* SceneNode;
-	SGeoMipMapTrianglePatches TrianglePatches;
+	//! Cache of the node's triangles, fetched again by the const queries
+	mutable SGeoMipMapTrianglePatches TrianglePatches;
+	mutable core::array<SPatchTreeNode> PatchTree;
+	s32 LOD;
+	//! Transformation count of the node the triangles were fetched at
+	mutable u32 TransformationCount;
 };
 
 } // end namespace scene
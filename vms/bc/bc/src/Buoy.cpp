@@ -15,6 +15,7 @@
      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
 
 #include "Buoy.hpp"
+#include "ModelRepository.hpp"
 #include "RadarData.hpp"
 #include "Angles.hpp"
 #include "IniFile.hpp"
@@ -26,7 +27,7 @@
 
 //using namespace irr;
 
-Buoy::Buoy(const std::string& name, const std::string& worldName, const irr::core::vector3df& location, irr::f32 radarCrossSection, bool floating, irr::f32 heightCorrection, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev)
+Buoy::Buoy(const std::string& name, const std::string& worldName, const irr::core::vector3df& location, irr::f32 radarCrossSection, bool floating, irr::f32 heightCorrection, irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev)
 {
 
     std::string basePath = "Models/Buoy/" + name + "/";
@@ -55,21 +56,22 @@ Buoy::Buoy(const std::string& name, const std::string& worldName, const irr::cor
     //The path to the actual model file
     std::string buoyFullPath = basePath + buoyFileName;
 
-    //Load the mesh
-    irr::scene::IMesh* buoyMesh = smgr->getMesh(buoyFullPath.c_str());
+    //Load the mesh, shared with other buoys of the same model
+    ModelRepository* models = ModelRepository::getRepository(smgr);
+    irr::s32 buoyModel = models->getModel(buoyFullPath);
 
 	//add to scene node
-	if (buoyMesh==0) {
+	if (buoyModel<0) {
         //Failed to load mesh - load with dummy and continue
         dev->getLogger()->log("Failed to load buoy model:");
         dev->getLogger()->log(buoyFullPath.c_str());
-        buoy = smgr->addCubeSceneNode(0.1);
+        buoy = smgr->addCubeSceneNode(0.1, parent);
         selector = 0;
     } else {
-        buoy = smgr->addMeshSceneNode( buoyMesh, 0, -1, location );
+        buoy = models->addInstance(buoyModel, parent, -1, location);
         //Add triangle selector and make pickable
         buoy->setID(IDFlag_IsPickable);
-        selector=smgr->createTriangleSelector(buoyMesh,buoy);
+        selector=models->createTriangleSelector(buoyModel,buoy);
         
         //This selector is now set or not depending on the distance from the own ship
         //if(selector) {
@@ -200,16 +202,6 @@ RadarData Buoy::getRadarData(irr::core::vector3df scannerPosition) const
     return radarData;
 }
 
-void Buoy::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
-{
-    irr::core::vector3df currentPos = buoy->getPosition();
-    irr::f32 newPosX = currentPos.X + deltaX;
-    irr::f32 newPosY = currentPos.Y + deltaY;
-    irr::f32 newPosZ = currentPos.Z + deltaZ;
-
-    buoy->setPosition(irr::core::vector3df(newPosX,newPosY,newPosZ));
-}
-
 void Buoy::enableTriangleSelector(bool selectorEnabled)
 {
     
@@ -27,10 +27,11 @@ struct RadarData;
 class Buoy
 {
     public:
-        Buoy(const std::string& name, const std::string& worldName, const irr::core::vector3df& location, irr::f32 radarCrossSection, bool floating, irr::f32 heightCorrection, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev);
+        //The buoy is placed at location on the parent (the world root)
+        Buoy(const std::string& name, const std::string& worldName, const irr::core::vector3df& location, irr::f32 radarCrossSection, bool floating, irr::f32 heightCorrection, irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev);
         virtual ~Buoy();
-        irr::core::vector3df getPosition() const;
-        void setPosition(irr::core::vector3df position);
+        irr::core::vector3df getPosition() const; //In the scene
+        void setPosition(irr::core::vector3df position); //Relative to the parent
         void setRotation(irr::core::vector3df rotation);
         irr::f32 getLength() const;
         irr::f32 getHeight() const;
@@ -38,12 +39,11 @@ class Buoy
         irr::f32 getHeightCorrection() const;
         bool getFloating() const;
         RadarData getRadarData(irr::core::vector3df scannerPosition) const;
-        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
         irr::scene::ISceneNode* getSceneNode() const;
         void enableTriangleSelector(bool selectorEnabled);
     protected:
     private:
-        irr::scene::IMeshSceneNode* buoy; //The scene node for the buoy.
+        irr::scene::ISceneNode* buoy; //The scene node for the buoy.
         irr::scene::ITriangleSelector* selector; //The triangle selector for the buoy. We will set and unset this depending on the distance from the ownship for speed
         irr::f32 length; //For radar calculation
         irr::f32 height; //For radar calculation
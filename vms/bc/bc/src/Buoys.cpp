@@ -38,7 +38,7 @@ Buoys::~Buoys()
     buoysLights.clear();
 }
 
-void Buoys::load(const std::string& worldName, irr::scene::ISceneManager* smgr, SimulationModel* model, irr::IrrlichtDevice* dev)
+void Buoys::load(const std::string& worldName, irr::scene::ISceneManager* smgr, irr::scene::ISceneNode* worldRoot, SimulationModel* model, irr::IrrlichtDevice* dev)
 {
     this->model = model;
 
@@ -72,8 +72,8 @@ void Buoys::load(const std::string& worldName, irr::scene::ISceneManager* smgr,
             floating = false;
         }
 
-        //Create buoy and load into vector
-        buoys.push_back(Buoy (buoyName.c_str(),worldName,irr::core::vector3df(buoyX,0.0f,buoyZ),rcs,floating,heightCorrection,smgr,dev));
+        //Create buoy and load into vector, fixed in the world so it moves with the world root when it is re-centred
+        buoys.push_back(Buoy (buoyName.c_str(),worldName,irr::core::vector3df(buoyX,0.0f,buoyZ),rcs,floating,heightCorrection,worldRoot,smgr,dev));
 
         //Find scene node
         irr::scene::ISceneNode* buoyNode = buoys.back().getSceneNode();
@@ -109,19 +109,19 @@ void Buoys::load(const std::string& worldName, irr::scene::ISceneManager* smgr,
     }
 }
 
-void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength)
+void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::core::vector3df ownShipPosition, irr::f32 ownShipLength)
 {
     for(std::vector<Buoy>::iterator it = buoys.begin(); it != buoys.end(); ++it) {
-        irr::f32 xPos, yPos, zPos;
+        irr::f32 yPos;
         irr::core::vector3df pos = it->getPosition();
-        xPos = pos.X;
         if (it->getFloating()) {
             yPos = tideHeight + model->getWaveHeight(pos.X,pos.Z) + it->getHeightCorrection();
         } else {
             yPos = 0 + it->getHeightCorrection();
         }
-        zPos = pos.Z;
-        it->setPosition(irr::core::vector3df(xPos,yPos,zPos));
+        //Only the height changes, the buoy stays where it is on the world root
+        irr::core::vector3df rootPos = it->getSceneNode()->getPosition();
+        it->setPosition(irr::core::vector3df(rootPos.X,yPos,rootPos.Z));
 
         if (it->getFloating()) {
             irr::f32 angleX, angleZ;
@@ -142,13 +142,7 @@ void Buoys::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeigh
 
     }
 
-    for(std::vector<NavLight*>::iterator it = buoysLights.begin(); it != buoysLights.end(); ++it) {
-
-        //Update light size/visibility etc
-        (*it)->update(scenarioTime, lightLevel);
-
-        //Note that the buoy light is a child of the buoy, so it moves with it
-    }
+    //Note that the buoy lights are updated with all others by the NavLightManager, following their buoy
 }
 
 RadarData Buoys::getRadarData(irr::u32 number, irr::core::vector3df scannerPosition) const
@@ -177,12 +171,3 @@ irr::core::vector3df Buoys::getPosition(int number) const
     }
 
 }
-
-void Buoys::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
-{
-    for(std::vector<Buoy>::iterator it = buoys.begin(); it != buoys.end(); ++it) {
-        it->moveNode(deltaX,deltaY,deltaZ);
-    }
-
-    //Note the light is a child of the buoy, so it moves with it
-}
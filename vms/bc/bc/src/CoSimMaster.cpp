@@ -0,0 +1,138 @@
+#include "./CoSimMaster.hpp"
+
+#include <string>
+#include <thread>
+
+const int CoSimMaster::SETTLE_TIMEOUT;
+const irr::u32 CoSimMaster::RENDER_INTERVAL;
+
+CoSimMaster::CoSimMaster(irr::IrrlichtDevice* dev, irr::u32 step_ms,
+                         irr::f32 speed, irr::u32 clients)
+    : device(dev),
+      enabled(false),
+      phase(AWAIT_CLIENTS),
+      step_ms(step_ms > 0 ? step_ms : 1),
+      speed(speed),
+      clients(clients),
+      awaiting_clients(clients > 0),
+      stalled(false),
+      stall_reported(false),
+      render_steps(RENDER_INTERVAL > this->step_ms
+                       ? RENDER_INTERVAL / this->step_ms
+                       : 1),
+      steps_since_render(0) {}
+
+bool CoSimMaster::open(const char* segment) {
+  if (this->channel.open(CoSimChannel::MASTER, segment)) {
+    this->device->getLogger()->log(
+        "Could not open the co-simulation clock, running in real time");
+    return true;
+  }
+
+  irr::ITimer* timer = this->device->getTimer();
+  timer->stop();
+  timer->setTime(START_TIME);
+  this->channel.publish(static_cast<uint64_t>(START_TIME) * 1000000);
+  this->enabled = true;
+  this->phase = AWAIT_CLIENTS;
+  this->last_step = std::chrono::steady_clock::now();
+  this->steps_since_render = 0;
+  return false;
+}
+
+CoSimChannel* CoSimMaster::get_channel() {
+  return this->enabled ? &this->channel : nullptr;
+}
+
+bool CoSimMaster::settle() {
+  if (this->awaiting_clients) {
+    if (this->channel.clients() < static_cast<int>(this->clients)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_TIMEOUT));
+      return false;
+    }
+    this->awaiting_clients = false;
+    this->device->getLogger()->log("All co-simulation clients attached");
+  }
+
+  if (this->channel.wait_settled(SETTLE_TIMEOUT)) {
+    this->stalled = false;
+    return true;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (!this->stalled) {
+    this->stalled = true;
+    this->stall_reported = false;
+    this->stalled_since = now;
+    return false;
+  }
+  if (this->channel.reap() > 0) {
+    this->device->getLogger()->log("Dropped an exited co-simulation client");
+  }
+
+  auto stalled_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        now - this->stalled_since)
+                        .count();
+  uint32_t lagging = this->channel.lagging_client();
+  if (lagging == 0 && stalled_ms > RESYNC_TIMEOUT) {
+    // every client waits, so whatever is still counted in flight was lost
+    // on the way
+    this->device->getLogger()->log(
+        "Co-simulation messages were lost, resynchronising");
+    this->channel.resync();
+    this->stalled = false;
+  } else if (lagging != 0 && stalled_ms > STALL_WARNING &&
+             !this->stall_reported) {
+    std::string message =
+        "Waiting for co-simulation client " + std::to_string(lagging);
+    this->device->getLogger()->log(message.c_str());
+    this->stall_reported = true;
+  }
+  return false;
+}
+
+bool CoSimMaster::step() {
+  if (!this->enabled) return true;
+
+  if (this->phase == AWAIT_DELIVERY) {
+    // everything sent at the current time must be taken before the clients
+    // may run at the next one
+    if (!this->settle()) return false;
+
+    irr::ITimer* timer = this->device->getTimer();
+    irr::f32 accelerator = timer->getSpeed();
+    if (accelerator <= 0.0) {
+      // paused, hold the time
+      std::this_thread::sleep_for(std::chrono::milliseconds(RENDER_INTERVAL));
+      return false;
+    }
+    if (this->speed > 0.0) {
+      std::chrono::duration<double, std::milli> interval(
+          this->step_ms / (this->speed * accelerator));
+      std::this_thread::sleep_until(
+          this->last_step +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              interval));
+    }
+    this->last_step = std::chrono::steady_clock::now();
+
+    irr::u32 now = timer->getTime() + this->step_ms;
+    timer->setTime(now);
+    this->channel.publish(static_cast<uint64_t>(now) * 1000000);
+    this->phase = AWAIT_CLIENTS;
+  }
+
+  // the clients run their cycles due at the new time
+  if (!this->settle()) return false;
+  this->phase = AWAIT_DELIVERY;
+  return true;
+}
+
+bool CoSimMaster::render_due(bool stepped) {
+  if (!this->enabled) return true;
+  // step() already waited for the clients or the accelerator
+  if (!stepped) return true;
+  if (++this->steps_since_render < this->render_steps) return false;
+  this->steps_since_render = 0;
+  return true;
+}
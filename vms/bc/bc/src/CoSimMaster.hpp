@@ -0,0 +1,76 @@
+#ifndef __COSIM_MASTER_HPP_INCLUDED__
+#define __COSIM_MASTER_HPP_INCLUDED__
+
+#include <chrono>
+
+#include "CoSimChannel.h"
+#include "IrrlichtDevice.h"
+
+// Master of the lockstep co-simulation clock shared with the autopilot.
+//
+// In lockstep the Irrlicht timer is stopped at a fixed start time and only
+// moved on by step(), one fixed step at a time, once every client is done
+// with the current time and has taken everything BC sent it. Everything in
+// BC that reads the timer thus sees the same sequence of times however fast
+// the steps are granted, which makes runs repeatable at any speed.
+//
+// Steps are paced to the given speed factor times the accelerator, 0 runs
+// as fast as the clients allow. Pausing with the accelerator holds the
+// time. While the clients are busy step() returns after a short wait so the
+// GUI stays responsive.
+class CoSimMaster {
+ public:
+  CoSimMaster(irr::IrrlichtDevice* dev, irr::u32 step_ms, irr::f32 speed,
+              irr::u32 clients);
+
+  // stop the timer and publish the start time, returns true on error
+  bool open(const char* segment = COSIM_CLOCK_SEGMENT);
+  bool is_enabled() const { return this->enabled; }
+  // for the message counters, null unless enabled
+  CoSimChannel* get_channel();
+
+  // returns true if the time moved on and the frame should exchange
+  // messages and update the model, always true unless enabled
+  bool step();
+  // the simulation may run far faster than the display, returns true if
+  // the frame should be drawn. Draws are spaced by simulated steps, so a
+  // run draws the same frames at any speed; frames that did not step only
+  // show the held time and are always drawn.
+  bool render_due(bool stepped);
+
+ private:
+  enum Phase { AWAIT_CLIENTS, AWAIT_DELIVERY };
+
+  bool settle();
+
+  // the timer starts here, so that seeding from it is repeatable
+  static const irr::u32 START_TIME = 1000;
+  // ms to wait for the clients in one frame
+  static const int SETTLE_TIMEOUT = 100;
+  // warn about a client that holds the time this long (ms)
+  static const irr::u32 STALL_WARNING = 10000;
+  // ms after which messages that never arrived are given up
+  static const irr::u32 RESYNC_TIMEOUT = 2000;
+  // simulated ms between draws, and between checks while paused
+  static const irr::u32 RENDER_INTERVAL = 16;
+
+  irr::IrrlichtDevice* device;
+  CoSimChannel channel;
+  bool enabled;
+  Phase phase;
+  const irr::u32 step_ms;
+  const irr::f32 speed;
+  const irr::u32 clients;
+  // hold the start time until this many clients have attached
+  bool awaiting_clients;
+
+  std::chrono::steady_clock::time_point last_step;
+  std::chrono::steady_clock::time_point stalled_since;
+  bool stalled;
+  bool stall_reported;
+  // steps between draws, and taken since the last
+  const irr::u32 render_steps;
+  irr::u32 steps_since_render;
+};
+
+#endif
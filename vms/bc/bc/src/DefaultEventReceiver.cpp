@@ -35,6 +35,7 @@
         if (event.EventType == irr::EET_LOG_TEXT_EVENT) {
             //Store these in a global log.
             std::string eventText(event.LogEvent.Text);
+            std::lock_guard<std::mutex> lock(logMutex);
             logMessages->push_back(eventText);
             return true;
         }
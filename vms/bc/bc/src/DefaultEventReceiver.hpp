@@ -20,6 +20,7 @@
 #include "irrlicht.h"
 #include <vector>
 #include <string>
+#include <mutex>
 
 
 class DefaultEventReceiver : public irr::IEventReceiver
@@ -33,6 +34,7 @@ public:
 private:
 
     std::vector<std::string>* logMessages;
+    std::mutex logMutex; //The world loader threads log through here too
     irr::IrrlichtDevice* device;
 
 };
@@ -0,0 +1,354 @@
+#include "./FlightRecorder.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "./SimulationModel.hpp"
+#include "irrlicht.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char LOG_MAGIC[4] = {'B', 'C', 'F', 'R'};
+const uint32_t LOG_VERSION = 2;
+
+// the frame carries the commands applied before its update
+const uint32_t FRAME_COMMANDS = 1;
+// the scene was drawn after the update, which animates the water
+const uint32_t FRAME_DRAWN = 2;
+
+struct LogHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t layout;
+  uint32_t scenario_size;
+  // bytes of the log in use and frames in them, kept current after every
+  // frame so that a log left behind by a crash still reads
+  uint64_t used;
+  uint64_t frames;
+  FlightLogSetup setup;
+};
+
+// followed by the commands if FRAME_COMMANDS, the own ship state and
+// other_ships other ship states
+struct FrameHeader {
+  uint32_t size;  // of the whole frame
+  uint32_t flags;
+  uint32_t loop;
+  uint32_t time;
+  float accelerator;
+  uint32_t seed;
+  uint32_t other_ships;
+  uint32_t reserved;
+};
+
+// sizes of the records, a log from a build that lays them out differently
+// is refused
+const uint32_t LOG_LAYOUT =
+    sizeof(FrameHeader) | sizeof(FlightOwnShipState) << 8 |
+    sizeof(FlightShipState) << 16 | sizeof(ActuatorCommands) << 24;
+
+// every record keeps the frames 8 byte aligned, and the states are compared
+// bytewise so must not have padding
+static_assert(sizeof(LogHeader) % 8 == 0, "log header must keep alignment");
+static_assert(sizeof(FrameHeader) % 8 == 0, "frame header must keep alignment");
+static_assert(sizeof(ActuatorCommands) % 8 == 0,
+              "commands must keep alignment");
+static_assert(sizeof(FlightOwnShipState) == 2 * 8 + 20 * 4,
+              "own ship state must not be padded");
+static_assert(sizeof(FlightShipState) == 4 * 4,
+              "ship state must not be padded");
+
+size_t align8(size_t size) { return (size + 7) & ~static_cast<size_t>(7); }
+
+}  // namespace
+
+const size_t FlightRecorder::CHUNK_SIZE;
+
+FlightRecorder::FlightRecorder(irr::IrrlichtDevice* dev)
+    : device(dev),
+      fd(-1),
+      data(nullptr),
+      mapped(0),
+      used(0),
+      last_frame(0),
+      frames(0),
+      failed(false),
+      time(0),
+      accelerator(0),
+      seed(0),
+      has_commands(false) {
+  std::memset(&this->commands, 0, sizeof(this->commands));
+}
+
+FlightRecorder::~FlightRecorder() { this->close(); }
+
+bool FlightRecorder::open(const std::string& file_name,
+                          const FlightLogSetup& setup,
+                          const std::string& scenario) {
+#ifdef __linux__
+  this->close();
+  this->fd = ::open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (this->fd < 0) {
+    std::string message = "Could not create the flight record " + file_name;
+    this->device->getLogger()->log(message.c_str());
+    return true;
+  }
+  size_t start = align8(sizeof(LogHeader) + scenario.size());
+  if (this->map(start + CHUNK_SIZE)) {
+    std::string message = "Could not map the flight record " + file_name;
+    this->device->getLogger()->log(message.c_str());
+    ::close(this->fd);
+    this->fd = -1;
+    return true;
+  }
+
+  LogHeader* header = reinterpret_cast<LogHeader*>(this->data);
+  std::memcpy(header->magic, LOG_MAGIC, sizeof(header->magic));
+  header->version = LOG_VERSION;
+  header->layout = LOG_LAYOUT;
+  header->scenario_size = static_cast<uint32_t>(scenario.size());
+  header->used = start;
+  header->frames = 0;
+  header->setup = setup;
+  std::memcpy(this->data + sizeof(LogHeader), scenario.data(),
+              scenario.size());
+
+  this->used = start;
+  this->last_frame = 0;
+  this->frames = 0;
+  this->failed = false;
+  this->has_commands = false;
+  this->seeds.seed(std::random_device()());
+  return false;
+#else
+  this->device->getLogger()->log(
+      "Flight recording is only available on Linux");
+  return true;
+#endif
+}
+
+void FlightRecorder::close() {
+#ifdef __linux__
+  if (this->fd < 0) return;
+  this->unmap();
+  // drop the preallocated space that was never used
+  if (ftruncate(this->fd, this->used) != 0) {
+    this->device->getLogger()->log("Could not trim the flight record");
+  }
+  ::close(this->fd);
+  this->fd = -1;
+#endif
+}
+
+bool FlightRecorder::map(size_t size) {
+#ifdef __linux__
+  // allocate the blocks up front, so a full disk fails here instead of
+  // faulting on a write to the mapping
+  if (posix_fallocate(this->fd, 0, size) != 0) return true;
+  void* address;
+  if (this->data) {
+    address = mremap(this->data, this->mapped, size, MREMAP_MAYMOVE);
+  } else {
+    address =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+  }
+  if (address == MAP_FAILED) return true;
+  this->data = static_cast<char*>(address);
+  this->mapped = size;
+  return false;
+#else
+  return true;
+#endif
+}
+
+void FlightRecorder::unmap() {
+#ifdef __linux__
+  if (!this->data) return;
+  munmap(this->data, this->mapped);
+  this->data = nullptr;
+  this->mapped = 0;
+#endif
+}
+
+char* FlightRecorder::reserve(size_t bytes) {
+  if (this->used + bytes > this->mapped) {
+    size_t size = this->mapped + CHUNK_SIZE;
+    while (this->used + bytes > size) size += CHUNK_SIZE;
+    if (this->map(size)) return nullptr;
+  }
+  return this->data + this->used;
+}
+
+void FlightRecorder::begin_frame(irr::u32 time, irr::f32 accelerator) {
+  if (!this->is_open()) return;
+  this->time = time;
+  this->accelerator = accelerator;
+  // a seed of its own for every step, so that the replay does not depend on
+  // what else drew from std::rand between the steps. Reseeding takes around
+  // half a microsecond, more than the rest of the recording put together.
+  this->seed = this->seeds();
+  std::srand(this->seed);
+}
+
+void FlightRecorder::record_commands(const ActuatorCommands& commands) {
+  // commands set every actuator, only the last before a step matters
+  this->commands = commands;
+  this->has_commands = true;
+}
+
+void FlightRecorder::end_frame(const SimulationModel& model) {
+  if (!this->is_open() || this->failed) return;
+  FlightOwnShipState own_ship;
+  model.getFlightState(own_ship, this->other_ships);
+
+  size_t size = sizeof(FrameHeader) + sizeof(FlightOwnShipState) +
+                this->other_ships.size() * sizeof(FlightShipState);
+  if (this->has_commands) size += sizeof(ActuatorCommands);
+  char* out = this->reserve(size);
+  if (!out) {
+    this->device->getLogger()->log(
+        "Could not grow the flight record, recording stopped");
+    this->failed = true;
+    return;
+  }
+
+  FrameHeader frame;
+  frame.size = static_cast<uint32_t>(size);
+  frame.flags = this->has_commands ? FRAME_COMMANDS : 0;
+  frame.loop = model.getLoopNumber();
+  frame.time = this->time;
+  frame.accelerator = this->accelerator;
+  frame.seed = this->seed;
+  frame.other_ships = static_cast<uint32_t>(this->other_ships.size());
+  frame.reserved = 0;
+  std::memcpy(out, &frame, sizeof(frame));
+  out += sizeof(frame);
+  if (this->has_commands) {
+    std::memcpy(out, &this->commands, sizeof(ActuatorCommands));
+    out += sizeof(ActuatorCommands);
+  }
+  std::memcpy(out, &own_ship, sizeof(own_ship));
+  out += sizeof(own_ship);
+  if (!this->other_ships.empty()) {
+    std::memcpy(out, this->other_ships.data(),
+                this->other_ships.size() * sizeof(FlightShipState));
+  }
+
+  this->last_frame = this->used;
+  this->used += size;
+  this->frames++;
+  this->has_commands = false;
+
+  LogHeader* header = reinterpret_cast<LogHeader*>(this->data);
+  header->frames = this->frames;
+  header->used = this->used;
+}
+
+void FlightRecorder::mark_drawn() {
+  if (!this->is_open() || this->frames == 0) return;
+  FrameHeader* frame =
+      reinterpret_cast<FrameHeader*>(this->data + this->last_frame);
+  frame->flags |= FRAME_DRAWN;
+}
+
+FlightReplayer::FlightReplayer()
+    : frames_start(0), frames(0), first_divergence(0), run_seconds(0) {
+  std::memset(&this->setup, 0, sizeof(this->setup));
+}
+
+bool FlightReplayer::open(const std::string& file_name) {
+  std::ifstream file(file_name.c_str(), std::ios::binary | std::ios::ate);
+  if (!file) return true;
+  std::streamoff size = file.tellg();
+  if (size < static_cast<std::streamoff>(sizeof(LogHeader))) return true;
+  this->log.resize(static_cast<size_t>(size));
+  file.seekg(0);
+  if (!file.read(this->log.data(), size)) return true;
+
+  LogHeader header;
+  std::memcpy(&header, this->log.data(), sizeof(header));
+  if (std::memcmp(header.magic, LOG_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != LOG_VERSION || header.layout != LOG_LAYOUT) {
+    return true;
+  }
+  size_t start = align8(sizeof(LogHeader) + header.scenario_size);
+  if (header.used < start || start > this->log.size()) return true;
+  // a log cut short still replays its complete frames
+  if (header.used < this->log.size()) {
+    this->log.resize(static_cast<size_t>(header.used));
+  }
+
+  this->setup = header.setup;
+  this->scenario.assign(this->log.data() + sizeof(LogHeader),
+                        header.scenario_size);
+  this->frames_start = start;
+  this->frames = header.frames;
+  return false;
+}
+
+uint64_t FlightReplayer::run(irr::IrrlichtDevice* device,
+                             SimulationModel* model) {
+  irr::ITimer* timer = device->getTimer();
+  irr::scene::ISceneNode* scene = device->getSceneManager()->getRootSceneNode();
+  FlightOwnShipState own_ship;
+  std::vector<FlightShipState> other_ships;
+  uint64_t divergent = 0;
+  uint64_t replayed = 0;
+  this->first_divergence = 0;
+
+  auto started = std::chrono::steady_clock::now();
+  size_t offset = this->frames_start;
+  while (offset + sizeof(FrameHeader) <= this->log.size()) {
+    FrameHeader frame;
+    std::memcpy(&frame, this->log.data() + offset, sizeof(frame));
+    size_t size = sizeof(FrameHeader) + sizeof(FlightOwnShipState) +
+                  frame.other_ships * sizeof(FlightShipState);
+    if (frame.flags & FRAME_COMMANDS) size += sizeof(ActuatorCommands);
+    if (frame.size != size || offset + size > this->log.size()) break;
+    const char* in = this->log.data() + offset + sizeof(frame);
+
+    timer->setTime(frame.time);
+    timer->setSpeed(frame.accelerator);
+    if (frame.flags & FRAME_COMMANDS) {
+      ActuatorCommands commands;
+      std::memcpy(&commands, in, sizeof(commands));
+      in += sizeof(commands);
+      model->applyActuatorCommands(commands);
+    }
+    std::srand(frame.seed);
+    model->update();
+    if (frame.flags & FRAME_DRAWN) scene->OnAnimate(frame.time);
+
+    model->getFlightState(own_ship, other_ships);
+    bool same = model->getLoopNumber() == frame.loop &&
+                other_ships.size() == frame.other_ships &&
+                std::memcmp(&own_ship, in, sizeof(own_ship)) == 0;
+    in += sizeof(own_ship);
+    if (same && !other_ships.empty()) {
+      same = std::memcmp(other_ships.data(), in,
+                         other_ships.size() * sizeof(FlightShipState)) == 0;
+    }
+    if (!same) {
+      if (divergent == 0) this->first_divergence = frame.loop;
+      divergent++;
+    }
+
+    replayed++;
+    offset += size;
+  }
+
+  this->run_seconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - started)
+                          .count();
+  this->frames = replayed;
+  return divergent;
+}
@@ -0,0 +1,155 @@
+#ifndef __FLIGHT_RECORDER_HPP_INCLUDED__
+#define __FLIGHT_RECORDER_HPP_INCLUDED__
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "BcProxyMessages.hpp"
+#include "IrrlichtDevice.h"
+
+class SimulationModel;
+
+// Flight data recording of the simulation, and its replay.
+//
+// FlightRecorder appends one frame per SimulationModel::update step to a
+// binary log: the timer time the step ran at, the accelerator, the seed
+// std::rand was given for the step, the actuator commands that came in from
+// the BC proxies before it, and the own ship and other ship states after it.
+// The log is memory mapped and grown in preallocated chunks, so recording a
+// step is a copy into memory. The header holds the serialised scenario and
+// the settings the model was built with that change how it moves.
+//
+// FlightReplayer reads a log back. The model is built from its header, then
+// run() sets the timer, seed and commands of every step as recorded, updates
+// the model as fast as it goes and compares the states bit for bit with the
+// recorded ones. Input from the GUI and joysticks is
+// not recorded, a run that used them replays up to the first such input.
+//
+// Frames are native endian and laid out as the structs below, a log only
+// replays on a build with the same layout. Recording is only available on
+// Linux, open() fails elsewhere; logs replay anywhere.
+
+// Settings of the recorded model, other than the scenario
+struct FlightLogSetup {
+  uint32_t start_time;  // timer time when the model was built
+  uint32_t noise_seed;  // of the sensor noise, see SimulationModel
+  uint32_t water_segments;
+  uint32_t limit_terrain_resolution;
+  int32_t contact_points[3];
+  uint32_t reserved;
+};
+
+struct FlightOwnShipState {
+  int64_t offset_x;  // of the world origin, see SimulationModel
+  int64_t offset_z;
+  float scenario_time;
+  float position[3];
+  float heading;
+  float pitch;
+  float roll;
+  float speed;
+  float rate_of_turn;
+  float rudder;
+  float wheel;
+  float port_engine_rpm;
+  float stbd_engine_rpm;
+  float cog;
+  float sog;
+  float depth;
+  float ship_depth;
+  float buoyancy;
+  float tide_height;
+  uint32_t reserved;  // zero, so that no padding is compared
+};
+
+struct FlightShipState {
+  float position_x;
+  float position_z;
+  float heading;
+  float speed;
+};
+
+class FlightRecorder {
+ public:
+  explicit FlightRecorder(irr::IrrlichtDevice* dev);
+  ~FlightRecorder();
+
+  // create the log, returns true on error
+  bool open(const std::string& file_name, const FlightLogSetup& setup,
+            const std::string& scenario);
+  bool is_open() const { return this->data != nullptr; }
+  // trims the log to the frames written
+  void close();
+
+  // start the frame of an update step, seeds std::rand for it
+  void begin_frame(irr::u32 time, irr::f32 accelerator);
+  // commands applied before the update of the frame
+  void record_commands(const ActuatorCommands& commands);
+  // records the states the model is left in by the update
+  void end_frame(const SimulationModel& model);
+  // the scene was drawn after the last frame, which animates the water
+  void mark_drawn();
+
+  uint64_t get_frame_count() const { return this->frames; }
+
+ private:
+  // returns where the next bytes go, growing the log if needed
+  char* reserve(size_t bytes);
+  bool map(size_t size);
+  void unmap();
+
+  // bytes the log is grown by at a time
+  static const size_t CHUNK_SIZE = 8 << 20;
+
+  irr::IrrlichtDevice* device;
+  int fd;
+  char* data;
+  size_t mapped;
+  size_t used;
+  size_t last_frame;
+  uint64_t frames;
+  bool failed;
+
+  std::mt19937 seeds;
+  irr::u32 time;
+  irr::f32 accelerator;
+  uint32_t seed;
+  bool has_commands;
+  ActuatorCommands commands;
+  std::vector<FlightShipState> other_ships;  // reused between frames
+};
+
+class FlightReplayer {
+ public:
+  FlightReplayer();
+
+  // read the log, returns true on error
+  bool open(const std::string& file_name);
+  const FlightLogSetup& get_setup() const { return this->setup; }
+  const std::string& get_scenario() const { return this->scenario; }
+
+  // run every recorded step on a model built from get_setup() and
+  // get_scenario(), with its timer stopped at the start time. Returns the
+  // number of frames whose states differ from the log.
+  uint64_t run(irr::IrrlichtDevice* device, SimulationModel* model);
+
+  uint64_t get_frame_count() const { return this->frames; }
+  // loop number of the first frame that differs, 0 if none did
+  irr::u32 get_first_divergence() const { return this->first_divergence; }
+  // wall clock time run() took
+  double get_run_seconds() const { return this->run_seconds; }
+
+ private:
+  FlightLogSetup setup;
+  std::string scenario;
+  std::vector<char> log;
+  size_t frames_start;
+  uint64_t frames;
+  irr::u32 first_divergence;
+  double run_seconds;
+};
+
+#endif
@@ -86,6 +86,16 @@ void GUIMain::load(irr::IrrlichtDevice* device, Lang* language, std::vector<std:
         nfuPortDown = false;
         nfuStbdDown = false;
 
+        //Nothing bound to the widgets yet, so the first update sets them all
+        for (irr::u32 i = 0; i < BOUND_VALUE_COUNT; i++) {
+            boundValues[i].set = false;
+        }
+        dataDisplayKey.clear();
+        radarTextKey.clear();
+        arpaKey.clear();
+        widgetUpdates = 0;
+        lastWidgetUpdates = 0;
+
         //Default to small radar display
         radarLarge = false;
         //Find available 4:3 rectangle to fit in area for large radar display
@@ -717,6 +727,11 @@ void GUIMain::load(irr::IrrlichtDevice* device, Lang* language, std::vector<std:
 
     irr::core::vector2di GUIMain::getCursorPositionRadar() const
     {
+        //The NULL device, as in the tests, has no cursor
+        if (!device->getCursorControl()) {
+            return irr::core::vector2di(0,0);
+        }
+
         //Basic mouse position
         irr::core::vector2di cursorPosition = device->getCursorControl()->getPosition();
 
@@ -900,63 +915,40 @@ void GUIMain::load(irr::IrrlichtDevice* device, Lang* language, std::vector<std:
         }
 
         //Update scroll bars
-        hdgScrollbar->setPos(Utilities::round(guiData->hdg));
-        spdScrollbar->setPos(Utilities::round(guiData->spd));
-        if (portScrollbar) {portScrollbar->setPos(Utilities::round(guiData->portEng * -100));}//Engine units are +- 1, scale to -+100, inverted as astern is at bottom of scroll bar
-        if (stbdScrollbar) {stbdScrollbar->setPos(Utilities::round(guiData->stbdEng * -100));}
+        bindPos(BOUND_HEADING, hdgScrollbar, Utilities::round(guiData->hdg));
+        bindPos(BOUND_SPEED, spdScrollbar, Utilities::round(guiData->spd));
+        bindPos(BOUND_PORT_ENGINE, portScrollbar, Utilities::round(guiData->portEng * -100));//Engine units are +- 1, scale to -+100, inverted as astern is at bottom of scroll bar
+        bindPos(BOUND_STBD_ENGINE, stbdScrollbar, Utilities::round(guiData->stbdEng * -100));
 
-        if (azimuth1Control) {
 	    // DEE_NOV22 should be read only with the needle showing direction only
 //            azimuth1Control->setMag(Utilities::round(guiData->portEng * 100));
-            azimuth1Control->setMag(Utilities::round(90));
-            azimuth1Control->setPos(Utilities::round(guiData->portAzimuthAngle));
-        }
+        bindMag(BOUND_AZIMUTH_1_MAG, azimuth1Control, Utilities::round(90));
+        bindPos(BOUND_AZIMUTH_1, azimuth1Control, Utilities::round(guiData->portAzimuthAngle));
 
-        if (azimuth2Control) {
 	    // DEE_NOV22 should be read only with the needle showing direction only
 //            azimuth2Control->setMag(Utilities::round(guiData->stbdEng * 100));
-            azimuth2Control->setMag(Utilities::round(90));
-            azimuth2Control->setPos(Utilities::round(guiData->stbdAzimuthAngle));
-        }
+        bindMag(BOUND_AZIMUTH_2_MAG, azimuth2Control, Utilities::round(90));
+        bindPos(BOUND_AZIMUTH_2, azimuth2Control, Utilities::round(guiData->stbdAzimuthAngle));
 
 	// DEE_NOV22 vvvv sets the displayed data in the GUI it does not receive mouse clicks
 
-	if (schottelPort)
-	{ // refers to the GUI object schottelPort as opposed to the value
-		schottelPort->setMag(Utilities::round(90)); // this is because I want a needle of fixed size
-		schottelPort->setPos(Utilities::round(guiData->schottelPort));
-	} // end if schottelPort 
-
-	if (schottelStbd)
-	{ // refers to the GUI object schottelPort as opposed to the value
-		schottelStbd->setMag(Utilities::round(90)); // this is because I want a needle of fixed size
-		schottelStbd->setPos(Utilities::round(guiData->schottelStbd));
-	} // end if schottelStbd
-
-	if (enginePort)
-	{ // refers to the GUI object that represents the engine rpm
-		enginePort->setMag(Utilities::round(90)); // fixed length needle
-		enginePort->setPos(Utilities::round(guiData->enginePort));  // i think this has already been adjusted to be
-									   // * 360, the engine proportion 0..1 
-	}
-
-	if (engineStbd)
-	{ // refers to the GUI object that represents the engine rpm
-		engineStbd->setMag(Utilities::round(90)); // fixed length needle
-		engineStbd->setPos(Utilities::round(guiData->engineStbd));  // i think this has already been adjusted to be
-									   // * 360, the engine proportion 0..1 
-	}
-
-
-	if(clutchPort) 
-	{
-		clutchPort->setChecked(guiData->clutchPort);
-	}
-
-	if(clutchStbd) 
-	{
-		clutchStbd->setChecked(guiData->clutchStbd);
-	}
+	// refers to the GUI object schottelPort as opposed to the value
+	bindMag(BOUND_SCHOTTEL_PORT_MAG, schottelPort, Utilities::round(90)); // this is because I want a needle of fixed size
+	bindPos(BOUND_SCHOTTEL_PORT, schottelPort, Utilities::round(guiData->schottelPort));
+
+	bindMag(BOUND_SCHOTTEL_STBD_MAG, schottelStbd, Utilities::round(90)); // this is because I want a needle of fixed size
+	bindPos(BOUND_SCHOTTEL_STBD, schottelStbd, Utilities::round(guiData->schottelStbd));
+
+	// refers to the GUI object that represents the engine rpm
+	bindMag(BOUND_ENGINE_PORT_MAG, enginePort, Utilities::round(90)); // fixed length needle
+	bindPos(BOUND_ENGINE_PORT, enginePort, Utilities::round(guiData->enginePort));  // i think this has already been adjusted to be
+									   // * 360, the engine proportion 0..1
+
+	bindMag(BOUND_ENGINE_STBD_MAG, engineStbd, Utilities::round(90)); // fixed length needle
+	bindPos(BOUND_ENGINE_STBD, engineStbd, Utilities::round(guiData->engineStbd));
+
+	bindChecked(BOUND_CLUTCH_PORT, clutchPort, guiData->clutchPort);
+	bindChecked(BOUND_CLUTCH_STBD, clutchStbd, guiData->clutchStbd);
 
 	// DEE_NOV22 ^^^^
 
@@ -964,38 +956,31 @@ void GUIMain::load(irr::IrrlichtDevice* device, Lang* language, std::vector<std:
 // DEE_NOV22 would prefer to get rid of all this "master" business never seen it on a ship
 //           as you can steer with one azi dead ahead, steering input with the other
 
-        if (azimuth1Master) {
-            azimuth1Master->setChecked(guiData->azimuth1Master);
-        }
-
-        if (azimuth2Master) {
-            azimuth2Master->setChecked(guiData->azimuth2Master);
-        }
+        bindChecked(BOUND_AZIMUTH_1_MASTER, azimuth1Master, guiData->azimuth1Master);
+        bindChecked(BOUND_AZIMUTH_2_MASTER, azimuth2Master, guiData->azimuth2Master);
 
         //rudderScrollbar->setPos(Utilities::round(guiData->rudder));
-        if (wheelScrollbar) {
-            wheelScrollbar->setSecondary(Utilities::round(guiData->rudder));
-            wheelScrollbar->setPos(Utilities::round(guiData->wheel));
-        }
-        if (bowThrusterScrollbar) {bowThrusterScrollbar->setPos(Utilities::round(guiData->bowThruster * 100));}
-        if (sternThrusterScrollbar) {sternThrusterScrollbar->setPos(Utilities::round(guiData->sternThruster * 100));}
+        bindSecondary(BOUND_RUDDER, wheelScrollbar, Utilities::round(guiData->rudder));
+        bindPos(BOUND_WHEEL, wheelScrollbar, Utilities::round(guiData->wheel));
+        bindPos(BOUND_BOW_THRUSTER, bowThrusterScrollbar, Utilities::round(guiData->bowThruster * 100));
+        bindPos(BOUND_STERN_THRUSTER, sternThrusterScrollbar, Utilities::round(guiData->sternThruster * 100));
 
-        radarGainScrollbar->setPos(Utilities::round(guiData->radarGain));
-        radarClutterScrollbar->setPos(Utilities::round(guiData->radarClutter));
-        radarRainScrollbar->setPos(Utilities::round(guiData->radarRain));
+        bindPos(BOUND_RADAR_GAIN, radarGainScrollbar, Utilities::round(guiData->radarGain));
+        bindPos(BOUND_RADAR_CLUTTER, radarClutterScrollbar, Utilities::round(guiData->radarClutter));
+        bindPos(BOUND_RADAR_RAIN, radarRainScrollbar, Utilities::round(guiData->radarRain));
 
-        radarGainScrollbar2->setPos(Utilities::round(guiData->radarGain));
-        radarClutterScrollbar2->setPos(Utilities::round(guiData->radarClutter));
-        radarRainScrollbar2->setPos(Utilities::round(guiData->radarRain));
+        bindPos(BOUND_RADAR_GAIN_2, radarGainScrollbar2, Utilities::round(guiData->radarGain));
+        bindPos(BOUND_RADAR_CLUTTER_2, radarClutterScrollbar2, Utilities::round(guiData->radarClutter));
+        bindPos(BOUND_RADAR_RAIN_2, radarRainScrollbar2, Utilities::round(guiData->radarRain));
 
-        weatherScrollbar->setPos(Utilities::round(guiData->weather*10.0)); //(Weather scroll bar is 0-120, weather is 0-12)
-        rainScrollbar->setPos(Utilities::round(guiData->rain*10.0)); //(Rain scroll bar is 0-100, rain is 0-10)
-        visibilityScrollbar->setPos(Utilities::round(guiData->visibility*10.0)); //Visibility scroll bar is 1-101, visibility is 0.1 to 10.1 Nm
+        bindPos(BOUND_WEATHER, weatherScrollbar, Utilities::round(guiData->weather*10.0)); //(Weather scroll bar is 0-120, weather is 0-12)
+        bindPos(BOUND_RAIN, rainScrollbar, Utilities::round(guiData->rain*10.0)); //(Rain scroll bar is 0-100, rain is 0-10)
+        bindPos(BOUND_VISIBILITY, visibilityScrollbar, Utilities::round(guiData->visibility*10.0)); //Visibility scroll bar is 1-101, visibility is 0.1 to 10.1 Nm
 
 
 // DEE vvvvv  this should display the rate of turn data on the screen
 // DEE        since internalrate of turn is in rads per second then for deg per min x 3438
-        rateofturnScrollbar->setPos(Utilities::round(3438*guiData->RateOfTurn));
+        bindPos(BOUND_RATE_OF_TURN, rateofturnScrollbar, Utilities::round(3438*guiData->RateOfTurn));
 // DEE ^^^^
 
         //Update text display data
@@ -1039,17 +1024,88 @@ guiTideHeight = guiData->tideHeight;
 
         //Update rudder pump indicators
         if (guiData->pump1On == true) {
-            pump1On->setBackgroundColor(irr::video::SColor(255,0,128,0));
+            bindBackgroundColor(BOUND_PUMP_1, pump1On, irr::video::SColor(255,0,128,0));
         } else {
-            pump1On->setBackgroundColor(irr::video::SColor(255,128,0,0));
+            bindBackgroundColor(BOUND_PUMP_1, pump1On, irr::video::SColor(255,128,0,0));
         }
         if (guiData->pump2On == true) {
-            pump2On->setBackgroundColor(irr::video::SColor(255,0,128,0));
+            bindBackgroundColor(BOUND_PUMP_2, pump2On, irr::video::SColor(255,0,128,0));
         } else {
-            pump2On->setBackgroundColor(irr::video::SColor(255,128,0,0));
+            bindBackgroundColor(BOUND_PUMP_2, pump2On, irr::video::SColor(255,128,0,0));
         }
     }
 
+    bool GUIMain::isBoundValueChanged(BOUND_VALUES bound, irr::s32 value, irr::s32 shown) const
+    {
+        //Changed in the model, or moved by the user since it was set
+        const BoundValue& boundValue = boundValues[bound];
+        return !boundValue.set || boundValue.value != value || boundValue.shown != shown;
+    }
+
+    void GUIMain::setBoundValue(BOUND_VALUES bound, irr::s32 value, irr::s32 shown)
+    {
+        BoundValue& boundValue = boundValues[bound];
+        boundValue.set = true;
+        boundValue.value = value;
+        boundValue.shown = shown; //May differ from the value if the widget clamped it
+        widgetUpdates++;
+    }
+
+    void GUIMain::bindPos(BOUND_VALUES bound, irr::gui::IGUIScrollBar* bar, irr::s32 pos)
+    {
+        if (bar && isBoundValueChanged(bound, pos, bar->getPos())) {
+            bar->setPos(pos);
+            setBoundValue(bound, pos, bar->getPos());
+        }
+    }
+
+    void GUIMain::bindSecondary(BOUND_VALUES bound, irr::gui::OutlineScrollBar* bar, irr::s32 pos)
+    {
+        if (bar && isBoundValueChanged(bound, pos, bar->getSecondary())) {
+            bar->setSecondary(pos);
+            setBoundValue(bound, pos, bar->getSecondary());
+        }
+    }
+
+    void GUIMain::bindMag(BOUND_VALUES bound, irr::gui::AzimuthDial* dial, irr::s32 mag)
+    {
+        if (dial && isBoundValueChanged(bound, mag, dial->getMag())) {
+            dial->setMag(mag);
+            setBoundValue(bound, mag, dial->getMag());
+        }
+    }
+
+    void GUIMain::bindChecked(BOUND_VALUES bound, irr::gui::IGUICheckBox* checkBox, bool checked)
+    {
+        if (checkBox && isBoundValueChanged(bound, checked, checkBox->isChecked())) {
+            checkBox->setChecked(checked);
+            setBoundValue(bound, checked, checkBox->isChecked());
+        }
+    }
+
+    void GUIMain::bindBackgroundColor(BOUND_VALUES bound, irr::gui::IGUIStaticText* text, irr::video::SColor color)
+    {
+        if (text && isBoundValueChanged(bound, color.color, text->getBackgroundColor().color)) {
+            text->setBackgroundColor(color);
+            setBoundValue(bound, color.color, text->getBackgroundColor().color);
+        }
+    }
+
+    bool GUIMain::isTextChanged(std::string& lastKey, const char* key)
+    {
+        //The key holds everything the text is made from, formatted as it is shown
+        if (lastKey == key) {
+            return false;
+        }
+        lastKey = key;
+        return true;
+    }
+
+    irr::u32 GUIMain::getWidgetUpdates() const
+    {
+        return lastWidgetUpdates;
+    }
+
     void GUIMain::showLogWindow()
     {
 
@@ -1100,62 +1156,82 @@ guiTideHeight = guiData->tideHeight;
         irr::u8 latDegrees = (int) displayLat;
         irr::u8 lonDegrees = (int) displayLong;
 
+        //Only rebuild the text when what it shows has changed
+        char key[512];
+        size_t keyLength = snprintf(key,sizeof(key),"%.1f %d %d",guiSpeed,showInterface,guiPaused);
+        if (showInterface && hasDepthSounder && keyLength < sizeof(key)) {
+            if (guiDepth <= maxSounderDepth) {
+                keyLength += snprintf(key+keyLength,sizeof(key)-keyLength,"|%.1f",guiDepth);
+            } else {
+                keyLength += snprintf(key+keyLength,sizeof(key)-keyLength,"|-");
+            }
+        }
+        if (showInterface && hasGPS && keyLength < sizeof(key)) {
+            keyLength += snprintf(key+keyLength,sizeof(key)-keyLength,"|%u %.3f %c %u %.3f %c",
+                                  latDegrees,latMinutes,(char)northSouth,lonDegrees,lonMinutes,(char)eastWest);
+        }
+        if (showInterface && keyLength < sizeof(key)) {
+            snprintf(key+keyLength,sizeof(key)-keyLength,"|%s|%d|%.1f",
+                     guiTime.c_str(),device->getVideoDriver()->getFPS(),guiTideHeight);
+        }
         //update heading display element
         irr::core::stringw displayText;
+        if (isTextChanged(dataDisplayKey, key)) {
+            displayText.append(language->translate("spd"));
+            displayText.append(f32To1dp(guiSpeed).c_str());
+            displayText.append(L" ");
+            displayText.append(language->translate("kts"));
+            displayText.append(L" ");
 
-        displayText.append(language->translate("spd"));
-        displayText.append(f32To1dp(guiSpeed).c_str());
-        displayText.append(L" ");
-        displayText.append(language->translate("kts"));
-        displayText.append(L" ");
-
-        if (showInterface) { //Only show speed in minimal 2d interface
-            displayText.append(L"\n");
-            if (hasDepthSounder) {
-                displayText.append(language->translate("depth"));
-                if (guiDepth <= maxSounderDepth) {
-                    displayText.append(f32To1dp(guiDepth).c_str());
-                } else {
-                    displayText.append(L"-");
+            if (showInterface) { //Only show speed in minimal 2d interface
+                displayText.append(L"\n");
+                if (hasDepthSounder) {
+                    displayText.append(language->translate("depth"));
+                    if (guiDepth <= maxSounderDepth) {
+                        displayText.append(f32To1dp(guiDepth).c_str());
+                    } else {
+                        displayText.append(L"-");
+                    }
+                    displayText.append(L" m \n");
                 }
-                displayText.append(L" m \n");
-            }
 
-            displayText.append(irr::core::stringw(guiTime.c_str()));
-            displayText.append(L"\n");
+                displayText.append(irr::core::stringw(guiTime.c_str()));
+                displayText.append(L"\n");
 
-            if (hasGPS) {
-                displayText.append(language->translate("pos"));
-                displayText.append(irr::core::stringw(latDegrees));
-                displayText.append(language->translate("deg"));
-                displayText.append(f32To3dp(latMinutes).c_str());
-                displayText.append(language->translate("minSymbol"));
-                displayText.append(northSouth);
-                displayText.append(L" ");
+                if (hasGPS) {
+                    displayText.append(language->translate("pos"));
+                    displayText.append(irr::core::stringw(latDegrees));
+                    displayText.append(language->translate("deg"));
+                    displayText.append(f32To3dp(latMinutes).c_str());
+                    displayText.append(language->translate("minSymbol"));
+                    displayText.append(northSouth);
+                    displayText.append(L" ");
 
-                displayText.append(irr::core::stringw(lonDegrees));
-                displayText.append(language->translate("deg"));
-                displayText.append(f32To3dp(lonMinutes).c_str());
-                displayText.append(language->translate("minSymbol"));
-                displayText.append(eastWest);
-                displayText.append(L"\n");
-            }
+                    displayText.append(irr::core::stringw(lonDegrees));
+                    displayText.append(language->translate("deg"));
+                    displayText.append(f32To3dp(lonMinutes).c_str());
+                    displayText.append(language->translate("minSymbol"));
+                    displayText.append(eastWest);
+                    displayText.append(L"\n");
+                }
 
-            displayText.append(language->translate("fps"));
-            displayText.append(irr::core::stringw(device->getVideoDriver()->getFPS()).c_str());
-            displayText.append(L"\n");
+                displayText.append(language->translate("fps"));
+                displayText.append(irr::core::stringw(device->getVideoDriver()->getFPS()).c_str());
+                displayText.append(L"\n");
 
-	    // DEE FEB 23 vvv add height of tide to the display
-	    displayText.append(language->translate("hot"));
-            displayText.append(f32To1dp(guiTideHeight).c_str());
-	    displayText.append(L"\n");
-	    // DEE FEB 23 ^^^
-        }
-        if (guiPaused) {
-            displayText.append(language->translate("paused"));
-            displayText.append(L"\n");
+	        // DEE FEB 23 vvv add height of tide to the display
+	        displayText.append(language->translate("hot"));
+                displayText.append(f32To1dp(guiTideHeight).c_str());
+	        displayText.append(L"\n");
+	        // DEE FEB 23 ^^^
+            }
+            if (guiPaused) {
+                displayText.append(language->translate("paused"));
+                displayText.append(L"\n");
+            }
+            dataDisplay->setText(displayText.c_str());
+            widgetUpdates++;
         }
-        dataDisplay->setText(displayText.c_str());
 
         //add radar text (reuse the displayText)
         irr::f32 displayEBLBearing = guiRadarEBLBrg;
@@ -1169,165 +1245,196 @@ guiTideHeight = guiData->tideHeight;
         while (displayCursorBearing>=360) {displayCursorBearing-=360;}
         while (displayCursorBearing<0) {displayCursorBearing+=360;}
 
-        displayText = language->translate("range");
-        displayText.append(f32To1dp(guiRadarRangeNm).c_str());
-        displayText.append(language->translate("nm"));
-        displayText.append(L"\n");
-
-        displayText.append(language->translate("vrm"));
-        displayText.append(f32To2dp(guiRadarEBLRangeNm).c_str());
-        displayText.append(language->translate("nm"));
-        if (guiRadarCursorRangeNm > 0){
-            displayText.append(" ");
-            displayText.append(language->translate("cursor"));
-            displayText.append(f32To2dp(guiRadarCursorRangeNm).c_str());
-            displayText.append(language->translate("nm"));
+        if (guiRadarCursorRangeNm > 0) {
+            snprintf(key,sizeof(key),"%.1f %.2f %.1f %.2f %.2f",guiRadarRangeNm,guiRadarEBLRangeNm,displayEBLBearing,guiRadarCursorRangeNm,displayCursorBearing);
+        } else {
+            snprintf(key,sizeof(key),"%.1f %.2f %.1f",guiRadarRangeNm,guiRadarEBLRangeNm,displayEBLBearing);
         }
-        displayText.append(L"\n");
-
-        displayText.append(language->translate("ebl"));
-        displayText.append(f32To1dp(displayEBLBearing).c_str());
-        displayText.append(language->translate("deg"));
-        if (guiRadarCursorRangeNm > 0){
-            displayText.append(" ");
-            displayText.append(language->translate("cursor"));
-            displayText.append(f32To2dp(displayCursorBearing).c_str());
+        if (isTextChanged(radarTextKey, key)) {
+            displayText = language->translate("range");
+            displayText.append(f32To1dp(guiRadarRangeNm).c_str());
+            displayText.append(language->translate("nm"));
+            displayText.append(L"\n");
+
+            displayText.append(language->translate("vrm"));
+            displayText.append(f32To2dp(guiRadarEBLRangeNm).c_str());
+            displayText.append(language->translate("nm"));
+            if (guiRadarCursorRangeNm > 0){
+                displayText.append(" ");
+                displayText.append(language->translate("cursor"));
+                displayText.append(f32To2dp(guiRadarCursorRangeNm).c_str());
+                displayText.append(language->translate("nm"));
+            }
+            displayText.append(L"\n");
+
+            displayText.append(language->translate("ebl"));
+            displayText.append(f32To1dp(displayEBLBearing).c_str());
             displayText.append(language->translate("deg"));
+            if (guiRadarCursorRangeNm > 0){
+                displayText.append(" ");
+                displayText.append(language->translate("cursor"));
+                displayText.append(f32To2dp(displayCursorBearing).c_str());
+                displayText.append(language->translate("deg"));
+            }
+            radarText ->setText(displayText.c_str());
+            radarText2->setText(displayText.c_str());
+            widgetUpdates += 2;
         }
-        radarText ->setText(displayText.c_str());
-        radarText2->setText(displayText.c_str());
 
         //Use guiCPAs and guiTCPAs to display ARPA data
         //Todo: Store current position and reset here
         irr::s32 selectedItem = arpaList->getSelected();
         irr::s32 selectedItem2 = arpaList2->getSelected();
-        irr::s32 selectedPosition = 0;
-        irr::s32 selectedPosition2 =0;
-        if (arpaList->getVerticalScrollBar()) {selectedPosition=arpaList->getVerticalScrollBar()->getPos();}
-        if (arpaList2->getVerticalScrollBar()) {selectedPosition2=arpaList2->getVerticalScrollBar()->getPos();}
-        arpaList->clear();
-        arpaList2->clear();
-        arpaText->clear();
-        arpaText2->clear();
 
-        //if (guiCPAs.size() == guiTCPAs.size() && guiCPAs.size() == guiARPAspeeds.size() && guiCPAs.size() == guiARPAheadings.size()) {
-        for (unsigned int i = 0; i < arpaContactStates.size(); i++) {
+        //The lists show one item per contact, and the details of the selected ones
+        keyLength = snprintf(key,sizeof(key),"%u %d %d",(unsigned int)arpaContactStates.size(),selectedItem,selectedItem2);
+        for (unsigned int i = 0; i < arpaContactStates.size() && keyLength < sizeof(key); i++) {
+            if ( (irr::s32)i==selectedItem || (irr::s32)i==selectedItem2 ) {
+                irr::f32 tcpa = arpaContactStates.at(i).tcpa;
+                irr::u32 tcpaMins = 0;
+                irr::u32 tcpaSecs = 60; //Not a time, for a tcpa shown as past
+                if (tcpa >= 0) {
+                    tcpaMins = floor(tcpa);
+                    tcpaSecs = floor(60*(tcpa - tcpaMins));
+                }
+                keyLength += snprintf(key+keyLength,sizeof(key)-keyLength,"|%.2f %u:%u %u %u",
+                                      arpaContactStates.at(i).cpa,tcpaMins,tcpaSecs,
+                                      (irr::u32)round(arpaContactStates.at(i).absHeading),(irr::u32)round(arpaContactStates.at(i).speed));
+            }
+        }
+        if (isTextChanged(arpaKey, key)) {
+            irr::s32 selectedPosition = 0;
+            irr::s32 selectedPosition2 =0;
+            if (arpaList->getVerticalScrollBar()) {selectedPosition=arpaList->getVerticalScrollBar()->getPos();}
+            if (arpaList2->getVerticalScrollBar()) {selectedPosition2=arpaList2->getVerticalScrollBar()->getPos();}
+            arpaList->clear();
+            arpaList2->clear();
+            arpaText->clear();
+            arpaText2->clear();
 
-            //Convert TCPA from decimal minutes into minutes and seconds.
-            //TODO: Filter list based on risk?
+            //if (guiCPAs.size() == guiTCPAs.size() && guiCPAs.size() == guiARPAspeeds.size() && guiCPAs.size() == guiARPAheadings.size()) {
+            for (unsigned int i = 0; i < arpaContactStates.size(); i++) {
 
+                //Convert TCPA from decimal minutes into minutes and seconds.
+                //TODO: Filter list based on risk?
 
 
-            displayText = L"";
 
-            irr::f32 tcpa = arpaContactStates.at(i).tcpa;
-            irr::f32 cpa  = arpaContactStates.at(i).cpa;
-            irr::u32 arpahdg = round(arpaContactStates.at(i).absHeading);
-            irr::u32 arpaspd = round(arpaContactStates.at(i).speed);
+                displayText = L"";
 
-            irr::u32 tcpaMins = floor(tcpa);
-            irr::u32 tcpaSecs = floor(60*(tcpa - tcpaMins));
+                irr::f32 tcpa = arpaContactStates.at(i).tcpa;
+                irr::f32 cpa  = arpaContactStates.at(i).cpa;
+                irr::u32 arpahdg = round(arpaContactStates.at(i).absHeading);
+                irr::u32 arpaspd = round(arpaContactStates.at(i).speed);
 
-            irr::core::stringw tcpaDisplayMins = irr::core::stringw(tcpaMins);
-            if (tcpaDisplayMins.size() == 1) {
-                irr::core::stringw zeroPadded = L"0";
-                zeroPadded.append(tcpaDisplayMins);
-                tcpaDisplayMins = zeroPadded;
-            }
+                irr::u32 tcpaMins = floor(tcpa);
+                irr::u32 tcpaSecs = floor(60*(tcpa - tcpaMins));
 
-            irr::core::stringw tcpaDisplaySecs = irr::core::stringw(tcpaSecs);
-            if (tcpaDisplaySecs.size() == 1) {
-                irr::core::stringw zeroPadded = L"0";
-                zeroPadded.append(tcpaDisplaySecs);
-                tcpaDisplaySecs = zeroPadded;
-            }
+                irr::core::stringw tcpaDisplayMins = irr::core::stringw(tcpaMins);
+                if (tcpaDisplayMins.size() == 1) {
+                    irr::core::stringw zeroPadded = L"0";
+                    zeroPadded.append(tcpaDisplayMins);
+                    tcpaDisplayMins = zeroPadded;
+                }
 
-            displayText.append(language->translate("arpaContact"));
-            displayText.append(L" ");
-            displayText.append(irr::core::stringw(i+1)); //Contact ID (1,2,...)
-            displayText.append(L":");
+                irr::core::stringw tcpaDisplaySecs = irr::core::stringw(tcpaSecs);
+                if (tcpaDisplaySecs.size() == 1) {
+                    irr::core::stringw zeroPadded = L"0";
+                    zeroPadded.append(tcpaDisplaySecs);
+                    tcpaDisplaySecs = zeroPadded;
+                }
 
-            arpaList->addItem(displayText.c_str());
-            arpaList2->addItem(displayText.c_str());
+                displayText.append(language->translate("arpaContact"));
+                displayText.append(L" ");
+                displayText.append(irr::core::stringw(i+1)); //Contact ID (1,2,...)
+                displayText.append(L":");
 
-            if ( i==selectedItem || i==selectedItem2 ) {
-                //Show arpa details
+                arpaList->addItem(displayText.c_str());
+                arpaList2->addItem(displayText.c_str());
 
-                //CPA
-                displayText = L"";
-                displayText.append(language->translate("cpa"));
-                displayText.append(L":");
-                displayText.append(f32To2dp(cpa).c_str());
-                displayText.append(language->translate("nm"));
-                //Add to the correct box
-                if (i==selectedItem) {
-                    arpaText->addItem(displayText.c_str());
-                }
-                if (i==selectedItem2) {
-                    arpaText2->addItem(displayText.c_str());
-                }
+                const bool selected = (irr::s32)i==selectedItem;
+                const bool selected2 = (irr::s32)i==selectedItem2;
 
-                //TCPA
-                displayText = L"";
-                displayText.append(language->translate("tcpa"));
-                displayText.append(L":");
-                if (tcpa >= 0) {
-                    displayText.append(tcpaDisplayMins);
+                if ( selected || selected2 ) {
+                    //Show arpa details
+
+                    //CPA
+                    displayText = L"";
+                    displayText.append(language->translate("cpa"));
                     displayText.append(L":");
-                    displayText.append(tcpaDisplaySecs);
-                } else {
-                    displayText.append(L" ");
-                    displayText.append(language->translate("past"));
-                }
-                //Add to the correct box
-                if (i==selectedItem) {
-                    arpaText->addItem(displayText.c_str());
-                }
-                if (i==selectedItem2) {
-                    arpaText2->addItem(displayText.c_str());
-                }
+                    displayText.append(f32To2dp(cpa).c_str());
+                    displayText.append(language->translate("nm"));
+                    //Add to the correct box
+                    if (selected) {
+                        arpaText->addItem(displayText.c_str());
+                    }
+                    if (selected2) {
+                        arpaText2->addItem(displayText.c_str());
+                    }
+
+                    //TCPA
+                    displayText = L"";
+                    displayText.append(language->translate("tcpa"));
+                    displayText.append(L":");
+                    if (tcpa >= 0) {
+                        displayText.append(tcpaDisplayMins);
+                        displayText.append(L":");
+                        displayText.append(tcpaDisplaySecs);
+                    } else {
+                        displayText.append(L" ");
+                        displayText.append(language->translate("past"));
+                    }
+                    //Add to the correct box
+                    if (selected) {
+                        arpaText->addItem(displayText.c_str());
+                    }
+                    if (selected2) {
+                        arpaText2->addItem(displayText.c_str());
+                    }
+
+                    //Heading and speed
+                    //Pad heading to three decimals
+                    irr::core::stringw headingText = irr::core::stringw(arpahdg);
+                    if (headingText.size() == 1) {
+                        irr::core::stringw zeroPadded = L"00";
+                        zeroPadded.append(headingText);
+                        headingText = zeroPadded;
+                    }
+                    else if (headingText.size() == 2) {
+                        irr::core::stringw zeroPadded = L"0";
+                        zeroPadded.append(headingText);
+                        headingText = zeroPadded;
+                    }
+                    displayText = L"";
+                    displayText.append(headingText);
+                    displayText.append(L"° ");
+                    displayText.append(irr::core::stringw(arpaspd));
+                    displayText.append(L" kts");
+                    //Add to the correct box
+                    if (selected) {
+                        arpaText->addItem(displayText.c_str());
+                    }
+                    if (selected2) {
+                        arpaText2->addItem(displayText.c_str());
+                    }
 
-                //Heading and speed
-                //Pad heading to three decimals
-                irr::core::stringw headingText = irr::core::stringw(arpahdg);
-                if (headingText.size() == 1) {
-                    irr::core::stringw zeroPadded = L"00";
-                    zeroPadded.append(headingText);
-                    headingText = zeroPadded;
-                }
-                else if (headingText.size() == 2) {
-                    irr::core::stringw zeroPadded = L"0";
-                    zeroPadded.append(headingText);
-                    headingText = zeroPadded;
-                }
-                displayText = L"";
-                displayText.append(headingText);
-                displayText.append(L"° ");
-                displayText.append(irr::core::stringw(arpaspd));
-                displayText.append(L" kts");
-                //Add to the correct box
-                if (i==selectedItem) {
-                    arpaText->addItem(displayText.c_str());
-                }
-                if (i==selectedItem2) {
-                    arpaText2->addItem(displayText.c_str());
                 }
 
             }
-
-        }
-        //}
-        if (selectedItem > -1 && (irr::s32)arpaList->getItemCount()>selectedItem) {
-            arpaList->setSelected(selectedItem);
-        }
-        if (selectedItem2 > -1 && (irr::s32)arpaList2->getItemCount()>selectedItem2) {
-            arpaList2->setSelected(selectedItem2);
-        }
-        if(arpaList->getVerticalScrollBar()) {
-            arpaList->getVerticalScrollBar()->setPos(selectedPosition);
-        }
-        if(arpaList2->getVerticalScrollBar()) {
-            arpaList2->getVerticalScrollBar()->setPos(selectedPosition2);
+            //}
+            if (selectedItem > -1 && (irr::s32)arpaList->getItemCount()>selectedItem) {
+                arpaList->setSelected(selectedItem);
+            }
+            if (selectedItem2 > -1 && (irr::s32)arpaList2->getItemCount()>selectedItem2) {
+                arpaList2->setSelected(selectedItem2);
+            }
+            if(arpaList->getVerticalScrollBar()) {
+                arpaList->getVerticalScrollBar()->setPos(selectedPosition);
+            }
+            if(arpaList2->getVerticalScrollBar()) {
+                arpaList2->getVerticalScrollBar()->setPos(selectedPosition2);
+            }
+            widgetUpdates += 4;
         }
 
 
@@ -1388,6 +1495,10 @@ guiTideHeight = guiData->tideHeight;
         if (bearingButton->isPressed()){
             draw2dBearing();
         }
+
+        //Frame finished, start counting the next
+        lastWidgetUpdates = widgetUpdates;
+        widgetUpdates = 0;
     }
 
     void GUIMain::draw2dRadar()
@@ -194,9 +194,59 @@ public:
     void showLogWindow();
     void drawGUI();
     void setExtraControlsWindowVisible(bool windowVisible);
+    irr::u32 getWidgetUpdates() const; //Widgets set by updateGuiData() and drawGUI() for the last frame drawn
 
 private:
 
+    //Values updateGuiData() binds to widgets. Each widget is only set when its rounded value changes, or when the
+    //user has moved it away from the value last set.
+    enum BOUND_VALUES
+    {
+        BOUND_HEADING,
+        BOUND_SPEED,
+        BOUND_PORT_ENGINE,
+        BOUND_STBD_ENGINE,
+        BOUND_AZIMUTH_1,
+        BOUND_AZIMUTH_1_MAG,
+        BOUND_AZIMUTH_2,
+        BOUND_AZIMUTH_2_MAG,
+        BOUND_SCHOTTEL_PORT,
+        BOUND_SCHOTTEL_PORT_MAG,
+        BOUND_SCHOTTEL_STBD,
+        BOUND_SCHOTTEL_STBD_MAG,
+        BOUND_ENGINE_PORT,
+        BOUND_ENGINE_PORT_MAG,
+        BOUND_ENGINE_STBD,
+        BOUND_ENGINE_STBD_MAG,
+        BOUND_CLUTCH_PORT,
+        BOUND_CLUTCH_STBD,
+        BOUND_AZIMUTH_1_MASTER,
+        BOUND_AZIMUTH_2_MASTER,
+        BOUND_RUDDER,
+        BOUND_WHEEL,
+        BOUND_BOW_THRUSTER,
+        BOUND_STERN_THRUSTER,
+        BOUND_RADAR_GAIN,
+        BOUND_RADAR_CLUTTER,
+        BOUND_RADAR_RAIN,
+        BOUND_RADAR_GAIN_2,
+        BOUND_RADAR_CLUTTER_2,
+        BOUND_RADAR_RAIN_2,
+        BOUND_WEATHER,
+        BOUND_RAIN,
+        BOUND_VISIBILITY,
+        BOUND_RATE_OF_TURN,
+        BOUND_PUMP_1,
+        BOUND_PUMP_2,
+        BOUND_VALUE_COUNT
+    };
+
+    struct BoundValue {
+        bool set;
+        irr::s32 value; //Value last set
+        irr::s32 shown; //What the widget showed after it was set
+    };
+
     irr::IrrlichtDevice* device;
     irr::gui::IGUIEnvironment* guienv;
 
@@ -355,6 +405,14 @@ private:
     bool nfuPortDown;
     bool nfuStbdDown;
 
+    BoundValue boundValues[BOUND_VALUE_COUNT];
+    //Formatted values the text widgets were last set from
+    std::string dataDisplayKey;
+    std::string radarTextKey;
+    std::string arpaKey;
+    irr::u32 widgetUpdates;
+    irr::u32 lastWidgetUpdates;
+
     void updateVisibility();
     void hideInSecondary();
     void draw2dRadar();
@@ -365,6 +423,14 @@ private:
     std::wstring f32To3dp(irr::f32 value);
     bool manuallyTriggerClick(irr::gui::IGUIButton* button);
     bool manuallyTriggerScroll(irr::gui::IGUIScrollBar* bar);
+    bool isBoundValueChanged(BOUND_VALUES bound, irr::s32 value, irr::s32 shown) const;
+    void setBoundValue(BOUND_VALUES bound, irr::s32 value, irr::s32 shown);
+    void bindPos(BOUND_VALUES bound, irr::gui::IGUIScrollBar* bar, irr::s32 pos);
+    void bindSecondary(BOUND_VALUES bound, irr::gui::OutlineScrollBar* bar, irr::s32 pos);
+    void bindMag(BOUND_VALUES bound, irr::gui::AzimuthDial* dial, irr::s32 mag);
+    void bindChecked(BOUND_VALUES bound, irr::gui::IGUICheckBox* checkBox, bool checked);
+    void bindBackgroundColor(BOUND_VALUES bound, irr::gui::IGUIStaticText* text, irr::video::SColor color);
+    bool isTextChanged(std::string& lastKey, const char* key);
 
 };
 
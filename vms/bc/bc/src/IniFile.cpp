@@ -16,11 +16,20 @@
 
 #include "IniFile.hpp"
 
-#include <cassert>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream> //for ini loading
 #include <string> //for ini loading
 #include <iostream>
-#include <map>
+#include <locale>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h> //for the cache
 
 #include "Utilities.hpp" //for ini loading
 #ifndef _WIN32
@@ -30,111 +39,343 @@
 // Irrlicht Namespaces
 //using namespace irr;
 
-class IniCache
+//Each ini file is parsed once into a flat open addressing table, keyed by interned key ids, with the values already converted
+//to the types they can be read as. The tables are written to a binary cache in the user directory by IniFile::saveCache(),
+//and a later run takes files whose modification time and size are unchanged from there instead of parsing the text.
+//The cache holds files by their absolute path, as the working directory changes while loading and between runs.
+
+namespace {
+
+    const char CACHE_MAGIC[4] = {'B', 'C', 'I', 'C'};
+    const irr::u32 CACHE_VERSION = 2; //1 held the file names as they were asked for
+    const char CACHE_FILE_NAME[] = "ini.cache";
+
+    enum ValueTypes {
+        HAS_U32 = 1,
+        HAS_S32 = 2,
+        HAS_F32 = 4
+    };
+
+    struct IniValue {
+        std::string text;
+        irr::u8 types; //ValueTypes the text parses as completely
+        irr::u32 u;
+        irr::s32 s;
+        irr::f32 f;
+        bool hasWide;
+        std::wstring wide; //Decoded when first asked for
+    };
+
+    char lowerAscii(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    //FNV-1a of the lower case key
+    irr::u32 hashKey(const std::string& key)
+    {
+        irr::u32 hash = 2166136261u;
+        for (char c : key) {
+            hash = (hash ^ static_cast<irr::u8>(lowerAscii(c))) * 16777619u;
+        }
+        return hash;
+    }
+
+    bool equalsLower(const std::string& lowerKey, const std::string& key)
+    {
+        if (lowerKey.size() != key.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < key.size(); i++) {
+            if (lowerKey[i] != lowerAscii(key[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //Smallest power of two table with at most half of it used
+    irr::u32 tableSize(std::size_t entries)
+    {
+        irr::u32 size = 8;
+        while (size < 2 * entries) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    void parseTypes(IniValue& value)
+    {
+        value.types = 0;
+        value.u = 0;
+        value.s = 0;
+        value.f = 0;
+        value.hasWide = false;
+        if (value.text.empty()) {
+            return;
+        }
+
+        //Only values used up completely count
+        const char *val = value.text.c_str();
+        const char *end = nullptr;
+        value.u = irr::core::strtoul10(val, &end);
+        if (static_cast<std::size_t>(end - val) == value.text.length()) {
+            value.types |= HAS_U32;
+        }
+        value.s = irr::core::strtol10(val, &end);
+        if (static_cast<std::size_t>(end - val) == value.text.length()) {
+            value.types |= HAS_S32;
+        }
+        value.f = irr::core::fast_atof(val, &end);
+        if (static_cast<std::size_t>(end - val) == value.text.length()) {
+            value.types |= HAS_F32;
+        }
+    }
+
+    //The files are read as UTF-8 on Linux/OSX etc, and byte by byte on Windows, as the wide streams did before
+    std::wstring widen(const std::string& text)
+    {
+#ifndef _WIN32
+        try {
+            std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+            return converter.from_bytes(text);
+        } catch (const std::range_error&) {
+            //Not valid UTF-8, fall through
+        }
+#endif
+        std::wstring wide;
+        wide.reserve(text.size());
+        for (char c : text) {
+            wide.push_back(static_cast<wchar_t>(static_cast<unsigned char>(c)));
+        }
+        return wide;
+    }
+
+    bool fileStamp(const std::string& fileName, irr::s64& mtime, irr::s64& size)
+    {
+        struct stat info;
+        if (stat(fileName.c_str(), &info) != 0) {
+            return false;
+        }
+#ifdef __linux__
+        mtime = static_cast<irr::s64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+        mtime = static_cast<irr::s64>(info.st_mtime) * 1000000000;
+#endif
+        size = static_cast<irr::s64>(info.st_size);
+        return true;
+    }
+
+    //Empty if there's no such file
+    std::string absolutePath(const std::string& fileName)
+    {
+#ifdef _WIN32
+        char path[_MAX_PATH];
+        if (_fullpath(path, fileName.c_str(), _MAX_PATH)) {
+            return path;
+        }
+#else
+        char* path = realpath(fileName.c_str(), nullptr);
+        if (path) {
+            std::string absolute(path);
+            free(path);
+            return absolute;
+        }
+#endif
+        return std::string();
+    }
+
+    //Bounds checked reading of the cache file, any read past the end makes it fail
+    class CacheReader {
+        public:
+        CacheReader(const std::string& data):data(data),pos(0),failed(false){}
+
+        bool ok() const {return !failed;}
+        void fail() {failed = true;}
+
+        template <class T> T read()
+        {
+            T value = T();
+            if (failed || data.size() - pos < sizeof(T)) {
+                failed = true;
+                return value;
+            }
+            memcpy(&value, data.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string readString()
+        {
+            irr::u32 length = read<irr::u32>();
+            if (failed || data.size() - pos < length) {
+                failed = true;
+                return std::string();
+            }
+            std::string value = data.substr(pos, length);
+            pos += length;
+            return value;
+        }
+
+        private:
+        const std::string& data;
+        std::size_t pos;
+        bool failed;
+    };
+
+    template <class T> void writeValue(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(std::string& out, const std::string& value)
+    {
+        writeValue<irr::u32>(out, static_cast<irr::u32>(value.size()));
+        out.append(value);
+    }
+}
+
+class IniStore
 {
 public:
-    IniCache() = default;
+    IniStore();
 
-    std::string getStringValue(const std::string &fileName, const std::string &key, const std::string &defValue = "");
-    std::wstring getWStringValue(const std::string &fileName, const std::string &key, const std::wstring &defValue = L"");
+    //Returns nullptr if the file can't be read or doesn't have the key
+    IniValue* find(const std::string &fileName, const std::string &key);
 
-    irr::u32 getUIntValue(const std::string &fileName, const std::string &key, irr::u32 defValue = 0);
-    irr::s32 getSIntValue(const std::string &fileName, const std::string &key, irr::s32 defValue = 0);
-    irr::f32 getFloatValue(const std::string &fileName, const std::string &key, irr::f32 defValue = 0.f);
+    void saveCache();
+    void reset(const std::string& cacheDir);
 
 private:
-    bool readFile(const std::string &fileName);
-
-    bool readWFile(const std::string &fileName);
+    struct Entry {
+        irr::u32 keyId;
+        IniValue value;
+    };
+
+    struct FileTable {
+        std::string path; //Absolute, empty if not worth caching
+        irr::s64 mtime;
+        irr::s64 size;
+        std::vector<Entry> entries;
+        std::vector<irr::u32> slots; //Entry index + 1, 0 for a free slot
+    };
+
+    //Key interning
+    irr::u32 internKey(const std::string& lowerKey);
+    bool findKey(const std::string& key, irr::u32& keyId) const;
+
+    FileTable* getFile(const std::string& fileName);
+    bool readFile(const std::string& fileName, FileTable& table);
+    void addEntry(FileTable& table, const std::string& lowerKey, const IniValue& value);
+    void buildSlots(FileTable& table);
+
+    void loadCache();
+    std::string cacheFileName() const;
 
 private:
-    std::map<std::string, std::map<std::string,  std::string>>  m_stringData;
-    std::map<std::string, std::map<std::wstring, std::wstring>> m_wstringData;
+    std::vector<std::string> m_keys;
+    std::vector<irr::u32> m_keyHashes;
+    std::vector<irr::u32> m_keySlots; //Key id + 1, 0 for a free slot
+
+    std::unordered_map<std::string, FileTable> m_files;
+    const std::string* m_lastFileName; //Most calls are for the same file as the one before
+    FileTable* m_lastFile;
+
+    //Files from the cache file by their absolute path, taken over into m_files when first used
+    bool m_cacheLoaded;
+    bool m_cacheDirty;
+    std::unordered_map<std::string, FileTable> m_cached;
+    std::string m_cacheDir; //The user directory if empty
 };
 
 
-static IniCache g_iniCache;
+static IniStore g_iniStore;
+static std::mutex g_iniMutex;
 
 
-bool IniCache::readFile(const std::string& fileName)
+IniStore::IniStore():m_lastFileName(nullptr),m_lastFile(nullptr),m_cacheLoaded(false),m_cacheDirty(false)
 {
-    if (m_stringData.find(fileName) != m_stringData.end()) {
-        return true; // file already read
-    }
+    m_keySlots.assign(tableSize(0), 0);
+}
 
-    std::ifstream file (fileName.c_str());
 
-    //Set UTF-8 on Linux/OSX etc
-#ifndef _WIN32
-    try {
-#  ifdef __APPLE__
-        char* thisLocale = setlocale(LC_ALL, "");
-        if (thisLocale) {
-            file.imbue(std::locale(thisLocale));
-        }
-#  else
-        file.imbue(std::locale("en_US.UTF8"));
-#  endif
-    } catch (const std::runtime_error& runtimeError) {
-        file.imbue(std::locale(""));
+irr::u32 IniStore::internKey(const std::string& lowerKey)
+{
+    irr::u32 keyId;
+    if (findKey(lowerKey, keyId)) {
+        return keyId;
     }
-#endif
 
-    if (!file.is_open()) {
-        if (IniFile::irrlichtLogger) {
-            std::string logMessage = "Unable to open file: ";
-            logMessage.append(fileName);
-            IniFile::irrlichtLogger->log(logMessage.c_str());
+    keyId = static_cast<irr::u32>(m_keys.size());
+    m_keys.push_back(lowerKey);
+    m_keyHashes.push_back(hashKey(lowerKey));
+
+    if (2 * m_keys.size() > m_keySlots.size()) {
+        m_keySlots.assign(2 * m_keySlots.size(), 0);
+        for (irr::u32 id = 0; id < m_keys.size(); id++) {
+            irr::u32 mask = static_cast<irr::u32>(m_keySlots.size()) - 1;
+            irr::u32 slot = m_keyHashes[id] & mask;
+            while (m_keySlots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            m_keySlots[slot] = id + 1;
         }
-        else {
-            std::cerr << "Unable to open file " << fileName << std::endl;
+    } else {
+        irr::u32 mask = static_cast<irr::u32>(m_keySlots.size()) - 1;
+        irr::u32 slot = m_keyHashes[keyId] & mask;
+        while (m_keySlots[slot] != 0) {
+            slot = (slot + 1) & mask;
         }
-        return false;
+        m_keySlots[slot] = keyId + 1;
     }
+    return keyId;
+}
 
-    std::string line;
-    while ( std::getline (file,line) )
-    {
-        const std::size_t equalsPos = line.find_first_of("=");
-        if (equalsPos != std::string::npos) {
-            std::string key   = Utilities::trim(line.substr(0, equalsPos));
-            std::string value = Utilities::trim(line.substr(equalsPos+1, std::string::npos));
-
-            Utilities::to_lower(key);
-            value = Utilities::trim(value, "\"");
 
-            m_stringData[fileName][key] = value;
+bool IniStore::findKey(const std::string& key, irr::u32& keyId) const
+{
+    //Case insensitive, without making a lower case copy
+    const irr::u32 hash = hashKey(key);
+    const irr::u32 mask = static_cast<irr::u32>(m_keySlots.size()) - 1;
+    for (irr::u32 slot = hash & mask; m_keySlots[slot] != 0; slot = (slot + 1) & mask) {
+        irr::u32 id = m_keySlots[slot] - 1;
+        if (m_keyHashes[id] == hash && equalsLower(m_keys[id], key)) {
+            keyId = id;
+            return true;
         }
     }
-
-    file.close();
-    return true;
+    return false;
 }
 
 
-bool IniCache::readWFile(const std::string& fileName)
+void IniStore::addEntry(FileTable& table, const std::string& lowerKey, const IniValue& value)
 {
-    if (m_stringData.find(fileName) != m_stringData.end()) {
-        return true; // file already read
-    }
+    Entry entry;
+    entry.keyId = internKey(lowerKey);
+    entry.value = value;
+    table.entries.push_back(entry);
+}
 
-    std::wifstream file(fileName.c_str());
 
-    //Set UTF-8 on Linux/OSX etc
-    #ifndef _WIN32
-    try {
-        #  ifdef __APPLE__
-        char* thisLocale = setlocale(LC_ALL, "");
-        if (thisLocale) {
-            file.imbue(std::locale(thisLocale));
+void IniStore::buildSlots(FileTable& table)
+{
+    //A later line with the same key replaces an earlier one
+    table.slots.assign(tableSize(table.entries.size()), 0);
+    const irr::u32 mask = static_cast<irr::u32>(table.slots.size()) - 1;
+    for (irr::u32 i = 0; i < table.entries.size(); i++) {
+        irr::u32 slot = (table.entries[i].keyId * 2654435761u) & mask;
+        while (table.slots[slot] != 0 && table.entries[table.slots[slot] - 1].keyId != table.entries[i].keyId) {
+            slot = (slot + 1) & mask;
         }
-        #  else
-        file.imbue(std::locale("en_US.UTF8"));
-        #  endif
-    } catch (const std::runtime_error& runtimeError) {
-        file.imbue(std::locale(""));
+        table.slots[slot] = i + 1;
     }
-    #endif
+}
+
+
+bool IniStore::readFile(const std::string& fileName, FileTable& table)
+{
+    //Read as bytes, UTF-8 is passed through and only decoded for wide strings
+    std::ifstream file (fileName.c_str(), std::ios::binary);
 
     if (!file.is_open()) {
         if (IniFile::irrlichtLogger) {
@@ -148,128 +389,274 @@ bool IniCache::readWFile(const std::string& fileName)
         return false;
     }
 
-    std::wstring line;
+    IniValue value;
+    std::string line;
     while ( std::getline (file,line) )
     {
-        const std::size_t equalsPos = line.find_first_of(L"=");
-        if (equalsPos != std::wstring::npos) {
-            std::wstring key   = Utilities::trim(line.substr(0, equalsPos));
-            std::wstring value = Utilities::trim(line.substr(equalsPos+1, std::wstring::npos));
+        const std::size_t equalsPos = line.find_first_of("=");
+        if (equalsPos != std::string::npos) {
+            std::string key   = Utilities::trim(line.substr(0, equalsPos));
+            value.text = Utilities::trim(line.substr(equalsPos+1, std::string::npos));
 
             Utilities::to_lower(key);
-            value = Utilities::trim(value, L"\"");
+            value.text = Utilities::trim(value.text, "\"");
+            parseTypes(value);
 
-            m_wstringData[fileName][key] = value;
+            addEntry(table, key, value);
         }
     }
 
     file.close();
+    buildSlots(table);
     return true;
 }
 
 
-std::string IniCache::getStringValue(const std::string& fileName, const std::string& key, const std::string& defValue)
+IniStore::FileTable* IniStore::getFile(const std::string& fileName)
 {
-    std::string keyLow = key;
-    Utilities::to_lower(keyLow);
+    if (m_lastFileName && *m_lastFileName == fileName) {
+        return m_lastFile;
+    }
 
-    auto fileIt = m_stringData.find(fileName);
-    if (fileIt == m_stringData.end()) {
-        if (!readFile(fileName)) {
-            //file not found
-            return defValue;
+    auto fileIt = m_files.find(fileName);
+    if (fileIt == m_files.end()) {
+        if (!m_cacheLoaded) {
+            loadCache();
         }
-        fileIt = m_stringData.find(fileName);
-        assert(fileIt != m_stringData.end());
-    }
 
-    const auto keyIt = fileIt->second.find(keyLow);
-    if (keyIt == (fileIt->second).end()) {
-        return defValue;
+        FileTable table;
+        table.path = absolutePath(fileName);
+        const bool stamped = !table.path.empty() && fileStamp(table.path, table.mtime, table.size);
+        auto cachedIt = m_cached.find(table.path);
+        if (stamped && cachedIt != m_cached.end() &&
+            cachedIt->second.mtime == table.mtime && cachedIt->second.size == table.size) {
+            //Unchanged since it was cached
+            table = std::move(cachedIt->second);
+            m_cached.erase(cachedIt);
+        } else {
+            if (!readFile(fileName, table)) {
+                //file not found, try again next time
+                return nullptr;
+            }
+            if (!stamped) {
+                table.path.clear(); //Can't tell when it changes, so not worth caching
+            }
+            m_cacheDirty = true;
+        }
+        fileIt = m_files.emplace(fileName, std::move(table)).first;
     }
 
-    return keyIt->second;
+    //Keys of an unordered_map and pointers to its elements stay valid
+    m_lastFileName = &fileIt->first;
+    m_lastFile = &fileIt->second;
+    return m_lastFile;
 }
 
-std::wstring IniCache::getWStringValue(const std::string& fileName, const std::string& key, const std::wstring& defValue)
-{
-    std::wstring keyLow = std::wstring(key.begin(), key.end());
-    Utilities::to_lower(keyLow);
 
-    auto fileIt = m_wstringData.find(fileName);
-    if (fileIt == m_wstringData.end()) {
-        if (!readWFile(fileName)) {
-            // file not found
-            return defValue;
-        }
-        fileIt = m_wstringData.find(fileName);
-        assert(fileIt != m_wstringData.end());
+IniValue* IniStore::find(const std::string& fileName, const std::string& key)
+{
+    FileTable* table = getFile(fileName);
+    irr::u32 keyId;
+    if (!table || !findKey(key, keyId)) {
+        return nullptr;
     }
 
-    const auto keyIt = fileIt->second.find(keyLow);
-    if (keyIt == (fileIt->second).end()) {
-        return defValue;
+    const irr::u32 mask = static_cast<irr::u32>(table->slots.size()) - 1;
+    for (irr::u32 slot = (keyId * 2654435761u) & mask; table->slots[slot] != 0; slot = (slot + 1) & mask) {
+        Entry& entry = table->entries[table->slots[slot] - 1];
+        if (entry.keyId == keyId) {
+            return &entry.value;
+        }
     }
+    return nullptr;
+}
 
-    return keyIt->second;
 
+std::string IniStore::cacheFileName() const
+{
+    const std::string folder = m_cacheDir.empty() ? Utilities::getUserDir() : m_cacheDir;
+    return folder.empty() ? folder : folder + CACHE_FILE_NAME;
 }
 
-irr::u32 IniCache::getUIntValue(const std::string& fileName, const std::string& key, irr::u32 defValue)
+
+void IniStore::loadCache()
 {
-    const std::string value = getStringValue(fileName, key, "");
-    if (value == "") {
-        return defValue; // not found
+    m_cacheLoaded = true;
+    const std::string cacheFile = cacheFileName();
+    if (cacheFile.empty()) {
+        return;
     }
 
-    const char *val = value.c_str();
-    const char *end = nullptr;
-    irr::u32 result = irr::core::strtoul10(val, &end);
-    if (end - val == value.length()) {
-        return result;
+    std::ifstream file (cacheFile.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        return; //Not written yet
     }
-    else {
-        return defValue; // failed to parse value
+    //Anything that can't be read whole is parsed again, and replaced on the next save
+    file.seekg(0, std::ios::end);
+    const std::streamoff length = file.tellg();
+    if (length < 0 || static_cast<unsigned long long>(length) > UINT_MAX) {
+        m_cacheDirty = true;
+        return;
+    }
+    std::string data(static_cast<std::size_t>(length), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(&data[0], data.size());
+    if (!file) {
+        m_cacheDirty = true;
+        return;
     }
-}
 
-irr::s32 IniCache::getSIntValue(const std::string& fileName, const std::string& key, irr::s32 defValue)
-{
-    const std::string value = getStringValue(fileName, key, "");
-    if (value == "") {
-        return defValue; // not found
+    CacheReader reader(data);
+    char magic[4];
+    for (char& c : magic) {
+        c = reader.read<char>();
+    }
+    if (memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || reader.read<irr::u32>() != CACHE_VERSION) {
+        return; //From another version, replaced on the next save
     }
 
-    const char *val = value.c_str();
-    const char *end = nullptr;
-    irr::s32 result = irr::core::strtol10(val, &end);
-    if (end - val == value.length()) {
-        return result;
+    //Each key is stored once, and referred to by its index from the entries
+    std::vector<irr::u32> keyIds;
+    irr::u32 keyCount = reader.read<irr::u32>();
+    for (irr::u32 i = 0; i < keyCount && reader.ok(); i++) {
+        keyIds.push_back(internKey(reader.readString()));
     }
-    else {
-        return defValue; // failed to parse value
+
+    irr::u32 fileCount = reader.read<irr::u32>();
+    for (irr::u32 i = 0; i < fileCount && reader.ok(); i++) {
+        FileTable table;
+        table.path = reader.readString();
+        table.mtime = reader.read<irr::s64>();
+        table.size = reader.read<irr::s64>();
+        irr::u32 entryCount = reader.read<irr::u32>();
+        table.entries.reserve(std::min<std::size_t>(entryCount, data.size()));
+        for (irr::u32 j = 0; j < entryCount && reader.ok(); j++) {
+            irr::u32 keyIndex = reader.read<irr::u32>();
+            if (keyIndex >= keyIds.size()) {
+                reader.fail();
+                break;
+            }
+            table.entries.emplace_back();
+            Entry& entry = table.entries.back();
+            entry.keyId = keyIds[keyIndex];
+            entry.value.text = reader.readString();
+            entry.value.types = reader.read<irr::u8>();
+            entry.value.u = reader.read<irr::u32>();
+            entry.value.s = reader.read<irr::s32>();
+            entry.value.f = reader.read<irr::f32>();
+            entry.value.hasWide = false;
+        }
+        if (reader.ok()) {
+            buildSlots(table);
+            const std::string path = table.path;
+            m_cached[path] = std::move(table);
+        }
+    }
+
+    if (!reader.ok()) {
+        //Damaged, parse everything again
+        m_cached.clear();
+        m_cacheDirty = true;
     }
 }
 
-irr::f32 IniCache::getFloatValue(const std::string& fileName, const std::string& key, irr::f32 defValue)
+
+void IniStore::saveCache()
 {
-    const std::string value = getStringValue(fileName, key, "");
-    if (value == "") {
-        return defValue; // not found
+    if (!m_cacheDirty) {
+        return;
+    }
+    const std::string cacheFile = cacheFileName();
+    if (cacheFile.empty()) {
+        return;
+    }
+
+    std::string data(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    writeValue<irr::u32>(data, CACHE_VERSION);
+
+    //Files used in this run, and those cached before that are still unchanged
+    //A file asked for by different names is read for each, but cached once
+    std::vector<const FileTable*> tables;
+    std::unordered_map<std::string, bool> written;
+    for (const auto& file : m_files) {
+        if (!file.second.path.empty() && written.emplace(file.second.path, true).second) {
+            tables.push_back(&file.second);
+        }
+    }
+    for (const auto& file : m_cached) {
+        irr::s64 mtime, size;
+        if (fileStamp(file.first, mtime, size) && mtime == file.second.mtime && size == file.second.size &&
+            written.emplace(file.first, true).second) {
+            tables.push_back(&file.second);
+        }
+    }
+
+    //Keys by their cache index, which is the key id where it's in use
+    std::vector<irr::u32> keyIndices(m_keys.size(), 0);
+    std::vector<irr::u32> usedKeys;
+    for (const FileTable* table : tables) {
+        for (const Entry& entry : table->entries) {
+            if (keyIndices[entry.keyId] == 0) {
+                usedKeys.push_back(entry.keyId);
+                keyIndices[entry.keyId] = static_cast<irr::u32>(usedKeys.size());
+            }
+        }
+    }
+    writeValue<irr::u32>(data, static_cast<irr::u32>(usedKeys.size()));
+    for (irr::u32 keyId : usedKeys) {
+        writeString(data, m_keys[keyId]);
+    }
+
+    writeValue<irr::u32>(data, static_cast<irr::u32>(tables.size()));
+    for (const FileTable* table : tables) {
+        writeString(data, table->path);
+        writeValue<irr::s64>(data, table->mtime);
+        writeValue<irr::s64>(data, table->size);
+        writeValue<irr::u32>(data, static_cast<irr::u32>(table->entries.size()));
+        for (const Entry& entry : table->entries) {
+            writeValue<irr::u32>(data, keyIndices[entry.keyId] - 1);
+            writeString(data, entry.value.text);
+            writeValue<irr::u8>(data, entry.value.types);
+            writeValue<irr::u32>(data, entry.value.u);
+            writeValue<irr::s32>(data, entry.value.s);
+            writeValue<irr::f32>(data, entry.value.f);
+        }
     }
 
-    const char *val = value.c_str();
-    const char *end = nullptr;
-    irr::f32 result = irr::core::fast_atof(val, &end);
-    if (end - val == value.length()) {
-        return result;
+    //Write a temporary file first, so a cache file is never left half written
+    const std::string tempFileName = cacheFile + ".tmp";
+    {
+        std::ofstream file (tempFileName.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        file.write(data.data(), data.size());
+        if (!file) {
+            return;
+        }
     }
-    else {
-        return defValue; // failed to parse value
+#ifdef _WIN32
+    remove(cacheFile.c_str());
+#endif
+    if (rename(tempFileName.c_str(), cacheFile.c_str()) == 0) {
+        m_cacheDirty = false;
     }
 }
 
 
+void IniStore::reset(const std::string& cacheDir)
+{
+    //Interned keys are kept, they are only ids
+    m_files.clear();
+    m_cached.clear();
+    m_lastFileName = nullptr;
+    m_lastFile = nullptr;
+    m_cacheLoaded = false;
+    m_cacheDirty = false;
+    m_cacheDir = cacheDir;
+}
+
+
 //Utility functions
 namespace IniFile
 {
@@ -287,32 +674,59 @@ namespace IniFile
 
     std::string iniFileToString(const std::string &fileName, const std::string &key, const std::string &defValue)
     {
-        return g_iniCache.getStringValue(fileName, key, defValue);
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        const IniValue* value = g_iniStore.find(fileName, key);
+        return value ? value->text : defValue;
     }
 
     std::wstring iniFileToWString(const std::string &fileName, const std::string &key, const std::wstring &defValue)
     {
-        return g_iniCache.getWStringValue(fileName, key, defValue);
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        IniValue* value = g_iniStore.find(fileName, key);
+        if (!value) {
+            return defValue;
+        }
+        if (!value->hasWide) {
+            value->wide = widen(value->text);
+            value->hasWide = true;
+        }
+        return value->wide;
     }
 
     //Load unsigned integer from an ini file
     irr::u32 iniFileTou32(const std::string &fileName, const std::string &key, irr::u32 defValue)
     {
-        return g_iniCache.getUIntValue(fileName, key, defValue);
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        const IniValue* value = g_iniStore.find(fileName, key);
+        return (value && (value->types & HAS_U32)) ? value->u : defValue;
     }
 
     //Load signed integer from an ini file
     irr::s32 iniFileTos32(const std::string &fileName, const std::string &key, irr::s32 defValue)
     {
-        return g_iniCache.getSIntValue(fileName, key, defValue);
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        const IniValue* value = g_iniStore.find(fileName, key);
+        return (value && (value->types & HAS_S32)) ? value->s : defValue;
     }
 
     //Load float from an ini file
     irr::f32 iniFileTof32(const std::string &fileName, const std::string &key, irr::f32 defValue)
     {
-        return g_iniCache.getFloatValue(fileName, key, defValue);
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        const IniValue* value = g_iniStore.find(fileName, key);
+        return (value && (value->types & HAS_F32)) ? value->f : defValue;
     }
 
-}
+    void saveCache()
+    {
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        g_iniStore.saveCache();
+    }
 
+    void resetCache(const std::string &cacheDir)
+    {
+        std::lock_guard<std::mutex> lock(g_iniMutex);
+        g_iniStore.reset(cacheDir);
+    }
 
+}
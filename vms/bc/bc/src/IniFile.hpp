@@ -33,6 +33,13 @@ namespace IniFile
     irr::u32 iniFileTou32(const std::string &fileName, const std::string &key, irr::u32 defValue = 0);
     irr::s32 iniFileTos32(const std::string &fileName, const std::string &key, irr::s32 defValue = 0);
     irr::f32 iniFileTof32(const std::string &fileName, const std::string &key, irr::f32 defValue = 0.f);
+
+    //Writes the ini files read so far to a cache in the user directory, so the next start does not parse them again while they are unchanged
+    void saveCache();
+
+    //Forgets the files read so far, so they are read again from the cache or the files as at a start. The cache is then
+    //read from and saved to cacheDir, which ends with a slash, or the user directory if it's empty. For tests and benchmarks.
+    void resetCache(const std::string &cacheDir = "");
 }
 
 #endif
@@ -68,27 +68,14 @@ void LandLights::load(const std::string& worldName, irr::scene::ISceneManager* s
             lightRange = lightRange * M_IN_NM;
 
 
-            landLights.push_back(new NavLight (0,smgr, irr::core::vector3df(lightX,lightY,lightZ),irr::video::SColor(255,lightR,lightG,lightB),lightStart,lightEnd,lightRange, lightSequence, phaseStart));
+            //Fixed on the world root, so the light moves with it when the world is re-centred
+            landLights.push_back(new NavLight (terrain.getWorldRoot(),smgr, irr::core::vector3df(lightX,lightY,lightZ),irr::video::SColor(255,lightR,lightG,lightB),lightStart,lightEnd,lightRange, lightSequence, phaseStart));
         }
     }
 
 }
 
-void LandLights::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::u32 lightLevel)
-{
-    for(std::vector<NavLight*>::iterator it = landLights.begin(); it != landLights.end(); ++it) {
-        (*it)->update(scenarioTime, lightLevel);
-    }
-}
-
 irr::u32 LandLights::getNumber() const
 {
     return landLights.size();
 }
-
-void LandLights::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
-{
-    for(std::vector<NavLight*>::iterator it = landLights.begin(); it != landLights.end(); ++it) {
-        (*it)->moveNode(deltaX,deltaY,deltaZ);
-    }
-}
@@ -15,10 +15,12 @@
      51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
 
 #include "LandObject.hpp"
+#include "ModelRepository.hpp"
 #include "IniFile.hpp"
 #include "Utilities.hpp"
 #include "Constants.hpp"
 #include "Terrain.hpp"
+#include "RayPicker.hpp"
 
 #include <iostream>
 
@@ -51,16 +53,17 @@ LandObject::LandObject(const std::string& name, const std::string& worldName, co
 
     std::string objectFullPath = basePath + objectFileName;
 
-    //Load the mesh
-    irr::scene::IMesh* objectMesh = smgr->getMesh(objectFullPath.c_str());
+    //Load the mesh, shared with other objects of the same model
+    ModelRepository* models = ModelRepository::getRepository(smgr);
+    irr::s32 objectModel = models->getModel(objectFullPath);
 	//add to scene node
-	if (objectMesh==0) {
+	if (objectModel<0) {
         //Failed to load mesh - load with dummy and continue
         dev->getLogger()->log("Failed to load land object model:");
         dev->getLogger()->log(objectFullPath.c_str());
-        landObject = smgr->addCubeSceneNode(0.1, 0, -1, location);
+        landObject = smgr->addCubeSceneNode(0.1, terrain->getWorldRoot(), -1, location);
     } else {
-        landObject = smgr->addMeshSceneNode( objectMesh, 0, -1, location);
+        landObject = models->addInstance(objectModel, terrain->getWorldRoot(), -1, location);
     }
 
     //Set ID as a flag if we should model collisions with this, also used to get radar points
@@ -68,9 +71,12 @@ LandObject::LandObject(const std::string& name, const std::string& worldName, co
         landObject->setID(IDFlag_IsPickable);
 
         //Add a triangle selector
-        irr::scene::ITriangleSelector* selector=smgr->createTriangleSelector(objectMesh,landObject);
-        if(selector) {
-            landObject->setTriangleSelector(selector);
+        if (objectModel>=0) {
+            irr::scene::ITriangleSelector* selector=models->createTriangleSelector(objectModel,landObject);
+            if(selector) {
+                landObject->setTriangleSelector(selector);
+                selector->drop();
+            }
         }
     }
 
@@ -89,41 +95,12 @@ LandObject::LandObject(const std::string& name, const std::string& worldName, co
     landObject->setName("LandObject");
 
     //===========================================
-    //Get contact points for radar detection here
+    //Get contact points for radar detection: the rays are cast by findRadarHeights(), against the scene as it is now
+    radarPicker = 0;
     if (radarObject) {
         landObject->updateAbsolutePosition();
-
-        irr::core::aabbox3df boundingBox = landObject->getTransformedBoundingBox();
-        irr::f32 minX = boundingBox.MinEdge.X;
-        irr::f32 maxX = boundingBox.MaxEdge.X;
-        irr::f32 minY = boundingBox.MinEdge.Y;
-        irr::f32 maxY = boundingBox.MaxEdge.Y;
-        irr::f32 minZ = boundingBox.MinEdge.Z;
-        irr::f32 maxZ = boundingBox.MaxEdge.Z;
-
-        //Grid from above looking down (hard coded 129x129 points)
-        std::vector<std::vector<irr::f32>> generatedMap;
-        for (int i = 0; i<129; i++) {
-            std::vector<irr::f32> generatedMapLine;
-            for (int j = 0; j<129; j++) {
-
-                irr::f32 xTestPos = minX + (maxX-minX)*(irr::f32)j/(irr::f32)(129-1);
-                irr::f32 zTestPos = minZ + (maxZ-minZ)*(irr::f32)i/(irr::f32)(129-1);
-
-                irr::core::line3df ray; //Make a ray. This will start outside the mesh, looking down
-                ray.start.X = xTestPos; ray.start.Y = maxY+0.1; ray.start.Z = zTestPos;
-                ray.end = ray.start;
-                ray.end.Y = minY-0.1;
-
-                //Check the ray and add the contact point if it exists
-                irr::f32 pointY = findContactYFromRay(ray);
-                generatedMapLine.push_back(pointY);
-            }
-            generatedMap.push_back(generatedMapLine);
-        }
-
-        //use the 'generatedMap' to add an invisible dummy terrain here
-        terrain->addRadarReflectingTerrain(generatedMap, minX, minZ, maxX-minX, maxZ-minZ);
+        radarBox = landObject->getTransformedBoundingBox();
+        radarPicker = new RayPicker(smgr->getRootSceneNode(), IDFlag_IsPickable);
     }
     //We don't want to do further triangle selection, unless it's a collision object
     if (!collisionObject) {
@@ -140,20 +117,66 @@ LandObject::~LandObject()
     //dtor
 }
 
-irr::f32 LandObject::findContactYFromRay(irr::core::line3d<irr::f32> ray)
+void LandObject::findRadarHeights()
+{
+    if (!radarPicker) {
+        return;
+    }
+
+    irr::f32 minX = radarBox.MinEdge.X;
+    irr::f32 maxX = radarBox.MaxEdge.X;
+    irr::f32 minY = radarBox.MinEdge.Y;
+    irr::f32 maxY = radarBox.MaxEdge.Y;
+    irr::f32 minZ = radarBox.MinEdge.Z;
+    irr::f32 maxZ = radarBox.MaxEdge.Z;
+
+    //Grid from above looking down (hard coded 129x129 points)
+    radarHeights.clear();
+    for (int i = 0; i<129; i++) {
+        std::vector<irr::f32> generatedMapLine;
+        for (int j = 0; j<129; j++) {
+
+            irr::f32 xTestPos = minX + (maxX-minX)*(irr::f32)j/(irr::f32)(129-1);
+            irr::f32 zTestPos = minZ + (maxZ-minZ)*(irr::f32)i/(irr::f32)(129-1);
+
+            irr::core::line3df ray; //Make a ray. This will start outside the mesh, looking down
+            ray.start.X = xTestPos; ray.start.Y = maxY+0.1; ray.start.Z = zTestPos;
+            ray.end = ray.start;
+            ray.end.Y = minY-0.1;
+
+            //Check the ray and add the contact point if it exists
+            irr::f32 pointY = findContactYFromRay(ray);
+            generatedMapLine.push_back(pointY);
+        }
+        radarHeights.push_back(generatedMapLine);
+    }
+}
+
+void LandObject::addRadarTerrain(Terrain* terrain)
+{
+    if (!radarPicker) {
+        return;
+    }
+
+    //use the heights to add an invisible dummy terrain here
+    terrain->addRadarReflectingTerrain(radarHeights, radarBox.MinEdge.X, radarBox.MinEdge.Z, radarBox.MaxEdge.X-radarBox.MinEdge.X, radarBox.MaxEdge.Z-radarBox.MinEdge.Z);
+
+    radarHeights.clear();
+    delete radarPicker;
+    radarPicker = 0;
+}
+
+irr::f32 LandObject::findContactYFromRay(irr::core::line3d<irr::f32> ray) const
 {
     irr::core::vector3df intersection;
     irr::core::triangle3df hitTriangle;
 
-    irr::scene::ISceneNode * selectedSceneNode =
-        device->getSceneManager()->getSceneCollisionManager()->getSceneNodeAndCollisionPointFromRay(
+    bool hit = radarPicker->pick(
         ray,
         intersection, // This will be the position of the collision
-        hitTriangle, // This will be the triangle hit in the collision
-        IDFlag_IsPickable, // (bitmask)
-        0); // Check all nodes
+        hitTriangle); // This will be the triangle hit in the collision
 
-    if(selectedSceneNode) {
+    if(hit) {
         return intersection.Y;
     } else {
         return -1e3; //A big negative value
@@ -165,13 +188,3 @@ irr::core::vector3df LandObject::getPosition() const
     landObject->updateAbsolutePosition();//ToDo: This may be needed, but seems odd that it's required
     return landObject->getAbsolutePosition();
 }
-
-void LandObject::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
-{
-    irr::core::vector3df currentPos = landObject->getPosition();
-    irr::f32 newPosX = currentPos.X + deltaX;
-    irr::f32 newPosY = currentPos.Y + deltaY;
-    irr::f32 newPosZ = currentPos.Z + deltaZ;
-
-    landObject->setPosition(irr::core::vector3df(newPosX,newPosY,newPosZ));
-}
@@ -20,22 +20,30 @@
 #include "irrlicht.h"
 
 #include <string>
+#include <vector>
 
 //Forward declarations
 class Terrain;
+class RayPicker;
 
 class LandObject
 {
     public:
         LandObject(const std::string& name, const std::string& worldName, const irr::core::vector3df& location, irr::f32 rotation, bool collisionObject, bool radarObject, Terrain* terrain, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* dev);
         virtual ~LandObject();
-        irr::core::vector3df getPosition() const;
-        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+        irr::core::vector3df getPosition() const; //In the scene, the object is fixed on the terrain's world root
+        //A radar object's heights are found by rays cast down on the scene as it was when the object was made.
+        //findRadarHeights() casts them, and can run on a loader thread; addRadarTerrain() then adds them to the terrain.
+        void findRadarHeights();
+        void addRadarTerrain(Terrain* terrain);
     protected:
     private:
-        irr::scene::IMeshSceneNode* landObject; //The scene node for the object.
+        irr::scene::ISceneNode* landObject; //The scene node for the object.
         irr::IrrlichtDevice* device;
-        irr::f32 findContactYFromRay(irr::core::line3d<irr::f32> ray);
+        irr::f32 findContactYFromRay(irr::core::line3d<irr::f32> ray) const;
+        RayPicker* radarPicker; //Until addRadarTerrain(), shared by copies of the object
+        irr::core::aabbox3df radarBox;
+        std::vector<std::vector<irr::f32>> radarHeights;
 };
 
 #endif
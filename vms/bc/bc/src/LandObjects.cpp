@@ -78,10 +78,16 @@ irr::u32 LandObjects::getNumber() const
     return landObjects.size();
 }
 
-void LandObjects::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
+void LandObjects::findRadarHeights(irr::u32 number)
 {
-    for(std::vector<LandObject>::iterator it = landObjects.begin(); it != landObjects.end(); ++it) {
-        it->moveNode(deltaX,deltaY,deltaZ);
+    if (number < landObjects.size()) {
+        landObjects[number].findRadarHeights();
     }
 }
 
+void LandObjects::addRadarTerrain(Terrain* terrain)
+{
+    for(std::vector<LandObject>::iterator it = landObjects.begin(); it != landObjects.end(); ++it) {
+        it->addRadarTerrain(terrain);
+    }
+}
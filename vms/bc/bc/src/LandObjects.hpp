@@ -34,7 +34,10 @@ class LandObjects
         virtual ~LandObjects();
         void load(const std::string& worldName, irr::scene::ISceneManager* smgr, SimulationModel* model, Terrain* terrain, irr::IrrlichtDevice* dev);
         irr::u32 getNumber() const;
-        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+        //Radar heights of one object, can run on a loader thread after load(), for different objects at once
+        void findRadarHeights(irr::u32 number);
+        //Adds the radar heights found to the terrain, on the main thread
+        void addRadarTerrain(Terrain* terrain);
 
     private:
         std::vector<LandObject> landObjects;
@@ -0,0 +1,270 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "LoadPipeline.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+//using namespace irr;
+
+namespace {
+    irr::f32 millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<irr::f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+LoadPipeline::LoadPipeline(irr::u32 threads, irr::ILogger* logger)
+{
+    this->threads = threads;
+    this->logger = logger;
+    totalTime = 0;
+    stopping = false;
+}
+
+LoadPipeline::~LoadPipeline()
+{
+    stopWorkers();
+    for (std::vector<Stage>::iterator it = stages.begin(); it != stages.end(); ++it) {
+        delete it->stage;
+    }
+}
+
+irr::u32 LoadPipeline::addStage(const std::string& name, LoadStage* stage)
+{
+    Stage newStage;
+    newStage.name = name;
+    newStage.stage = stage;
+    newStage.dependencies = 0;
+    newStage.waitingFor = 0;
+    newStage.partsLeft = 0;
+    newStage.decodeTime = 0;
+    newStage.waitTime = 0;
+    newStage.commitTime = 0;
+    stages.push_back(newStage);
+    return stages.size() - 1;
+}
+
+void LoadPipeline::addDependency(irr::u32 stage, irr::u32 dependsOn)
+{
+    //Stages commit in the order they were added, so a stage can only wait for one before it
+    if (stage >= stages.size() || dependsOn >= stage) {
+        if (logger) {
+            logger->log("Load stage dependency ignored, stages can only depend on stages added before them");
+        }
+        return;
+    }
+    stages.at(dependsOn).dependents.push_back(stage);
+    stages.at(stage).dependencies++;
+}
+
+void LoadPipeline::run()
+{
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        for (irr::u32 i = 0; i < stages.size(); i++) {
+            Stage& stage = stages.at(i);
+            stage.waitingFor = stage.dependencies;
+            stage.partsLeft = 0;
+            stage.error = std::exception_ptr();
+            stage.decodeTime = 0;
+            stage.waitTime = 0;
+            stage.commitTime = 0;
+        }
+        if (threads > 0) {
+            for (irr::u32 i = 0; i < stages.size(); i++) {
+                if (stages.at(i).waitingFor == 0) {
+                    schedule(i);
+                }
+            }
+        }
+    }
+    for (irr::u32 i = 0; i < threads; i++) {
+        workers.push_back(std::thread(&LoadPipeline::workerLoop, this));
+    }
+
+    for (irr::u32 i = 0; i < stages.size(); i++) {
+        Stage& stage = stages.at(i);
+
+        if (threads == 0) {
+            //Everything in turn on this thread
+            irr::u32 parts = stage.stage->getParts();
+            for (irr::u32 part = 0; part < parts; part++) {
+                decodePart(i, part);
+            }
+        } else {
+            //The stages before this one have committed, so its decode is queued or done
+            std::chrono::steady_clock::time_point waitStarted = std::chrono::steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex);
+            while (stage.partsLeft > 0) {
+                //Rather than wait for its parts to come up behind those of later stages, decode them here
+                std::deque<Task>::iterator queued = tasks.begin();
+                while (queued != tasks.end() && queued->stage != i) {
+                    ++queued;
+                }
+                if (queued != tasks.end()) {
+                    Task task = *queued;
+                    tasks.erase(queued);
+                    lock.unlock();
+                    decodePart(task.stage, task.part);
+                    lock.lock();
+                } else {
+                    stageDecoded.wait(lock);
+                }
+            }
+            stage.waitTime = millisecondsSince(waitStarted);
+        }
+
+        if (stage.error) {
+            stopWorkers();
+            std::rethrow_exception(stage.error);
+        }
+
+        std::chrono::steady_clock::time_point commitStarted = std::chrono::steady_clock::now();
+        stage.stage->commit();
+        stage.commitTime = millisecondsSince(commitStarted);
+
+        if (threads > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::vector<irr::u32>::iterator it = stage.dependents.begin(); it != stage.dependents.end(); ++it) {
+                if (--stages.at(*it).waitingFor == 0) {
+                    schedule(*it);
+                }
+            }
+        }
+    }
+
+    stopWorkers();
+    totalTime = millisecondsSince(started);
+
+    if (logger) {
+        for (irr::u32 i = 0; i < stages.size(); i++) {
+            const Stage& stage = stages.at(i);
+            std::ostringstream message;
+            message << std::fixed << std::setprecision(1) << "Loaded " << stage.name << ": decode " << stage.decodeTime << " ms, wait " << stage.waitTime << " ms, commit " << stage.commitTime << " ms";
+            logger->log(message.str().c_str());
+        }
+        std::ostringstream message;
+        message << std::fixed << std::setprecision(1) << "Loaded the world in " << totalTime << " ms with " << threads << " loader threads";
+        logger->log(message.str().c_str());
+    }
+}
+
+void LoadPipeline::schedule(irr::u32 stage)
+{
+    irr::u32 parts = stages.at(stage).stage->getParts();
+    stages.at(stage).partsLeft = parts;
+    for (irr::u32 part = 0; part < parts; part++) {
+        Task task;
+        task.stage = stage;
+        task.part = part;
+        tasks.push_back(task);
+    }
+    if (parts > 0) {
+        taskReady.notify_all();
+    }
+}
+
+void LoadPipeline::decodePart(irr::u32 stage, irr::u32 part)
+{
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::exception_ptr error;
+    try {
+        stages.at(stage).stage->decode(part);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    irr::f32 elapsed = millisecondsSince(started);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Stage& decoded = stages.at(stage);
+    decoded.decodeTime += elapsed;
+    if (error && !decoded.error) {
+        decoded.error = error;
+    }
+    if (decoded.partsLeft > 0 && --decoded.partsLeft == 0) {
+        stageDecoded.notify_all();
+    }
+}
+
+void LoadPipeline::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        while (tasks.empty() && !stopping) {
+            taskReady.wait(lock);
+        }
+        if (tasks.empty()) {
+            return;
+        }
+        Task task = tasks.front();
+        tasks.pop_front();
+
+        lock.unlock();
+        decodePart(task.stage, task.part);
+        lock.lock();
+    }
+}
+
+void LoadPipeline::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        tasks.clear();
+    }
+    taskReady.notify_all();
+    for (std::vector<std::thread>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        it->join();
+    }
+    workers.clear();
+}
+
+irr::u32 LoadPipeline::getStageCount() const
+{
+    return stages.size();
+}
+
+const std::string& LoadPipeline::getStageName(irr::u32 stage) const
+{
+    return stages.at(stage).name;
+}
+
+irr::f32 LoadPipeline::getDecodeTime(irr::u32 stage) const
+{
+    return stages.at(stage).decodeTime;
+}
+
+irr::f32 LoadPipeline::getWaitTime(irr::u32 stage) const
+{
+    return stages.at(stage).waitTime;
+}
+
+irr::f32 LoadPipeline::getCommitTime(irr::u32 stage) const
+{
+    return stages.at(stage).commitTime;
+}
+
+irr::f32 LoadPipeline::getTotalTime() const
+{
+    return totalTime;
+}
@@ -0,0 +1,135 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef __LOADPIPELINE_HPP_INCLUDED__
+#define __LOADPIPELINE_HPP_INCLUDED__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "irrlicht.h"
+
+//One step of loading the world. decode() reads files and works on data, and runs on a loader thread, so it must not
+//change the scene or the video driver state; it can be split into parts that run on different threads. commit() then
+//does the scene graph work on the main thread.
+class LoadStage
+{
+    public:
+        virtual ~LoadStage() {}
+        //Number of parts decode() is split into, asked on the main thread once the stages depended on have committed
+        virtual irr::u32 getParts() { return 1; }
+        virtual void decode(irr::u32) {}
+        virtual void commit() {}
+};
+
+//A stage calling member functions of an object, any of which can be left out
+template <class T>
+class LoadStep : public LoadStage
+{
+    public:
+        typedef void (T::*CommitFunction)();
+        typedef void (T::*DecodeFunction)(irr::u32 part);
+        typedef irr::u32 (T::*PartsFunction)();
+
+        LoadStep(T* object, CommitFunction commitFunction, DecodeFunction decodeFunction = 0, PartsFunction partsFunction = 0)
+            : object(object), commitFunction(commitFunction), decodeFunction(decodeFunction), partsFunction(partsFunction) {}
+
+        virtual irr::u32 getParts() { return partsFunction ? (object->*partsFunction)() : 1; }
+        virtual void decode(irr::u32 part) { if (decodeFunction) (object->*decodeFunction)(part); }
+        virtual void commit() { if (commitFunction) (object->*commitFunction)(); }
+
+    private:
+        T* object;
+        CommitFunction commitFunction;
+        DecodeFunction decodeFunction;
+        PartsFunction partsFunction;
+};
+
+//Runs the stages of loading as a dependency graph. A stage is decoded on the loader threads as soon as the stages it
+//depends on have committed, and the main thread commits the stages one by one in the order they were added, waiting
+//for each one's decode and taking on any of its parts still queued. With the commits in a fixed order the scene comes out the same however the decodes are
+//scheduled, and with no threads the stages are decoded and committed in turn on the main thread.
+class LoadPipeline
+{
+    public:
+        LoadPipeline(irr::u32 threads, irr::ILogger* logger);
+        ~LoadPipeline();
+
+        //Takes ownership of the stage. Returns its index for addDependency().
+        irr::u32 addStage(const std::string& name, LoadStage* stage);
+        //The stage depended on must have been added before the stage
+        void addDependency(irr::u32 stage, irr::u32 dependsOn);
+
+        //Decode and commit every stage, logging the time each took. An exception from a decode is thrown again
+        //here when its stage would commit.
+        void run();
+
+        //Times of the last run, in milliseconds. The decode time is summed over the parts, the wait is how long the
+        //main thread spent on the decode, waiting or decoding parts itself, before it could commit.
+        irr::u32 getStageCount() const;
+        const std::string& getStageName(irr::u32 stage) const;
+        irr::f32 getDecodeTime(irr::u32 stage) const;
+        irr::f32 getWaitTime(irr::u32 stage) const;
+        irr::f32 getCommitTime(irr::u32 stage) const;
+        irr::f32 getTotalTime() const;
+
+    private:
+        LoadPipeline(const LoadPipeline&);
+        LoadPipeline& operator=(const LoadPipeline&);
+
+        struct Stage {
+            std::string name;
+            LoadStage* stage;
+            std::vector<irr::u32> dependents;
+            irr::u32 dependencies;
+            irr::u32 waitingFor; //Dependencies not committed yet
+            irr::u32 partsLeft;
+            std::exception_ptr error;
+            irr::f32 decodeTime;
+            irr::f32 waitTime;
+            irr::f32 commitTime;
+        };
+
+        struct Task {
+            irr::u32 stage;
+            irr::u32 part;
+        };
+
+        void schedule(irr::u32 stage); //Call with the mutex held
+        void decodePart(irr::u32 stage, irr::u32 part);
+        void workerLoop();
+        void stopWorkers();
+
+        irr::u32 threads;
+        irr::ILogger* logger;
+        std::vector<Stage> stages;
+        irr::f32 totalTime;
+
+        std::mutex mutex;
+        std::condition_variable taskReady;
+        std::condition_variable stageDecoded;
+        std::deque<Task> tasks;
+        bool stopping;
+        std::vector<std::thread> workers;
+};
+
+#endif
@@ -0,0 +1,403 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "ModelRepository.hpp"
+
+#include <algorithm>
+
+//using namespace irr;
+
+namespace {
+    const irr::scene::ESCENE_NODE_TYPE MODEL_REPOSITORY_TYPE = (irr::scene::ESCENE_NODE_TYPE)MAKE_IRR_ID('m','o','d','l');
+    const irr::scene::ESCENE_NODE_TYPE MODEL_INSTANCE_TYPE = (irr::scene::ESCENE_NODE_TYPE)MAKE_IRR_ID('m','o','d','i');
+
+    //Back to front, as the scene manager sorts transparent nodes
+    struct FartherFrom {
+        irr::core::vector3df camera;
+        bool operator()(const irr::scene::ISceneNode* a, const irr::scene::ISceneNode* b) const {
+            return a->getAbsolutePosition().getDistanceFromSQ(camera) > b->getAbsolutePosition().getDistanceFromSQ(camera);
+        }
+    };
+
+    //The selector of one instance: the shared model triangles, moved by the instance's transformation
+    class ModelInstanceSelector : public irr::scene::ITriangleSelector {
+        public:
+            ModelInstanceSelector(irr::scene::ITriangleSelector* triangles, irr::scene::ISceneNode* node) : triangles(triangles), node(node)
+            {
+                triangles->grab();
+            }
+
+            ~ModelInstanceSelector()
+            {
+                triangles->drop();
+            }
+
+            virtual irr::s32 getTriangleCount() const
+            {
+                return triangles->getTriangleCount();
+            }
+
+            virtual void getTriangles(irr::core::triangle3df* outTriangles, irr::s32 arraySize, irr::s32& outTriangleCount, const irr::core::matrix4* transform, bool useNodeTransform, irr::core::array<irr::scene::SCollisionTriangleRange>* outTriangleInfo) const
+            {
+                irr::u32 firstRange = outTriangleInfo ? outTriangleInfo->size() : 0;
+                irr::core::matrix4 mat = getTransform(transform, useNodeTransform);
+                triangles->getTriangles(outTriangles, arraySize, outTriangleCount, &mat, false, outTriangleInfo);
+                claimRanges(outTriangleInfo, firstRange);
+            }
+
+            virtual void getTriangles(irr::core::triangle3df* outTriangles, irr::s32 arraySize, irr::s32& outTriangleCount, const irr::core::aabbox3d<irr::f32>& box, const irr::core::matrix4* transform, bool useNodeTransform, irr::core::array<irr::scene::SCollisionTriangleRange>* outTriangleInfo) const
+            {
+                //Bring the box into model coordinates
+                irr::core::aabbox3df modelBox(box);
+                if (node && useNodeTransform) {
+                    irr::core::matrix4 inverse(irr::core::matrix4::EM4CONST_NOTHING);
+                    if (!node->getAbsoluteTransformation().getInverse(inverse)) {
+                        //Scaled to nothing, so return everything, as CTriangleSelector does
+                        getTriangles(outTriangles, arraySize, outTriangleCount, transform, useNodeTransform, outTriangleInfo);
+                        return;
+                    }
+                    inverse.transformBoxEx(modelBox);
+                }
+
+                irr::u32 firstRange = outTriangleInfo ? outTriangleInfo->size() : 0;
+                irr::core::matrix4 mat = getTransform(transform, useNodeTransform);
+                triangles->getTriangles(outTriangles, arraySize, outTriangleCount, modelBox, &mat, false, outTriangleInfo);
+                claimRanges(outTriangleInfo, firstRange);
+            }
+
+            virtual void getTriangles(irr::core::triangle3df* outTriangles, irr::s32 arraySize, irr::s32& outTriangleCount, const irr::core::line3d<irr::f32>& line, const irr::core::matrix4* transform, bool useNodeTransform, irr::core::array<irr::scene::SCollisionTriangleRange>* outTriangleInfo) const
+            {
+                irr::core::aabbox3df box(line.start);
+                box.addInternalPoint(line.end);
+                getTriangles(outTriangles, arraySize, outTriangleCount, box, transform, useNodeTransform, outTriangleInfo);
+            }
+
+            virtual irr::u32 getSelectorCount() const
+            {
+                return 1;
+            }
+
+            virtual irr::scene::ITriangleSelector* getSelector(irr::u32 index)
+            {
+                return index == 0 ? this : 0;
+            }
+
+            virtual const irr::scene::ITriangleSelector* getSelector(irr::u32 index) const
+            {
+                return index == 0 ? this : 0;
+            }
+
+            virtual irr::scene::ISceneNode* getSceneNodeForTriangle(irr::u32) const
+            {
+                return node;
+            }
+
+        private:
+            irr::core::matrix4 getTransform(const irr::core::matrix4* transform, bool useNodeTransform) const
+            {
+                irr::core::matrix4 mat;
+                if (transform) {
+                    mat = *transform;
+                }
+                if (node && useNodeTransform) {
+                    mat *= node->getAbsoluteTransformation();
+                }
+                return mat;
+            }
+
+            //The shared selector reports itself and no node, so hits have to be credited to this instance
+            void claimRanges(irr::core::array<irr::scene::SCollisionTriangleRange>* outTriangleInfo, irr::u32 firstRange) const
+            {
+                if (!outTriangleInfo) {
+                    return;
+                }
+                for (irr::u32 i = firstRange; i < outTriangleInfo->size(); i++) {
+                    (*outTriangleInfo)[i].Selector = const_cast<ModelInstanceSelector*>(this);
+                    (*outTriangleInfo)[i].SceneNode = node;
+                }
+            }
+
+            irr::scene::ITriangleSelector* triangles; //Grabbed
+            irr::scene::ISceneNode* node; //Not grabbed, as for the selectors made by the scene manager
+    };
+}
+
+ModelRepository* ModelRepository::getRepository(irr::scene::ISceneManager* smgr)
+{
+    irr::scene::ISceneNode* root = smgr->getRootSceneNode();
+    const irr::core::list<irr::scene::ISceneNode*>& children = root->getChildren();
+    for (irr::core::list<irr::scene::ISceneNode*>::ConstIterator it = children.begin(); it != children.end(); ++it) {
+        if ((*it)->getType() == MODEL_REPOSITORY_TYPE) {
+            return static_cast<ModelRepository*>(*it);
+        }
+    }
+
+    ModelRepository* repository = new ModelRepository(root, smgr);
+    repository->drop(); //Kept by the root node
+    return repository;
+}
+
+ModelRepository::ModelRepository(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr) : irr::scene::ISceneNode(parent, smgr)
+{
+    instanceCount = 0;
+    drawCount = 0;
+    batchCount = 0;
+
+    //Instances are culled one by one as they register
+    setAutomaticCulling(irr::scene::EAC_OFF);
+}
+
+ModelRepository::~ModelRepository()
+{
+    for (std::vector<Model>::iterator it = models.begin(); it != models.end(); ++it) {
+        if (it->triangles) {
+            it->triangles->drop();
+        }
+        it->animatedMesh->drop();
+    }
+}
+
+irr::s32 ModelRepository::getModel(const std::string& fileName)
+{
+    std::map<std::string, irr::u32>::const_iterator it = modelIds.find(fileName);
+    if (it != modelIds.end()) {
+        return it->second;
+    }
+
+    irr::scene::IAnimatedMesh* animatedMesh = SceneManager->getMesh(fileName.c_str());
+    if (animatedMesh == 0 || animatedMesh->getMesh(0) == 0) {
+        return -1;
+    }
+
+    Model model;
+    model.animatedMesh = animatedMesh;
+    model.animatedMesh->grab();
+    model.mesh = animatedMesh->getMesh(0);
+    model.animated = animatedMesh->getFrameCount() > 1;
+    if (animatedMesh->getMeshType() == irr::scene::EAMT_SKINNED && !static_cast<irr::scene::ISkinnedMesh*>(animatedMesh)->isStatic()) {
+        model.animated = true;
+    }
+    for (irr::u32 i = 0; i < model.mesh->getMeshBufferCount(); i++) {
+        model.materials.push_back(model.mesh->getMeshBuffer(i)->getMaterial());
+    }
+    model.triangles = 0;
+    model.instanceCount = 0;
+
+    irr::u32 id = models.size();
+    models.push_back(model);
+    modelIds[fileName] = id;
+    return id;
+}
+
+irr::scene::ISceneNode* ModelRepository::addInstance(irr::u32 model, irr::scene::ISceneNode* parent, irr::s32 id, const irr::core::vector3df& position)
+{
+    if (model >= models.size()) {
+        return 0;
+    }
+    if (parent == 0) {
+        parent = SceneManager->getRootSceneNode();
+    }
+
+    if (models[model].animated) {
+        return SceneManager->addAnimatedMeshSceneNode(models[model].animatedMesh, parent, id, position);
+    }
+
+    ModelInstanceNode* instance = new ModelInstanceNode(parent, SceneManager, id, this, model);
+    instance->setPosition(position);
+    instance->drop(); //Kept by the parent
+    models[model].instanceCount++;
+    instanceCount++;
+    return instance;
+}
+
+irr::scene::ITriangleSelector* ModelRepository::createTriangleSelector(irr::u32 model, irr::scene::ISceneNode* node)
+{
+    if (model >= models.size()) {
+        return 0;
+    }
+    if (models[model].triangles == 0) {
+        models[model].triangles = SceneManager->createTriangleSelector(models[model].mesh, 0);
+        if (models[model].triangles == 0) {
+            return 0;
+        }
+    }
+    return new ModelInstanceSelector(models[model].triangles, node);
+}
+
+irr::u32 ModelRepository::getModelCount() const
+{
+    return models.size();
+}
+
+irr::scene::IMesh* ModelRepository::getMesh(irr::u32 model) const
+{
+    if (model >= models.size()) {
+        return 0;
+    }
+    return models[model].mesh;
+}
+
+irr::u32 ModelRepository::getInstanceCount() const
+{
+    return instanceCount;
+}
+
+irr::u32 ModelRepository::getDrawCount() const
+{
+    return drawCount;
+}
+
+irr::u32 ModelRepository::getBatchCount() const
+{
+    return batchCount;
+}
+
+void ModelRepository::queueInstance(irr::u32 model, ModelInstanceNode* instance)
+{
+    //Instances are only drawn along with the repository
+    if (IsVisible) {
+        models[model].queued.push_back(instance);
+    }
+}
+
+void ModelRepository::removeInstance(irr::u32 model, ModelInstanceNode* instance)
+{
+    std::vector<ModelInstanceNode*>& queued = models[model].queued;
+    queued.erase(std::remove(queued.begin(), queued.end(), instance), queued.end());
+    models[model].instanceCount--;
+    instanceCount--;
+}
+
+void ModelRepository::OnRegisterSceneNode()
+{
+    //The instances register after or before this, so which passes are needed is only known when drawing
+    if (IsVisible && instanceCount > 0) {
+        SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_SOLID);
+        SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_TRANSPARENT);
+    }
+    ISceneNode::OnRegisterSceneNode();
+}
+
+void ModelRepository::render()
+{
+    irr::video::IVideoDriver* driver = SceneManager->getVideoDriver();
+    const bool transparentPass = SceneManager->getSceneNodeRenderPass() == irr::scene::ESNRP_TRANSPARENT;
+    if (!transparentPass) {
+        drawCount = 0;
+        batchCount = 0;
+    }
+
+    irr::scene::ICameraSceneNode* camera = SceneManager->getActiveCamera();
+    for (std::vector<Model>::iterator model = models.begin(); model != models.end(); ++model) {
+        if (model->queued.empty()) {
+            continue;
+        }
+        if (transparentPass && camera) {
+            FartherFrom fartherFrom;
+            fartherFrom.camera = camera->getAbsolutePosition();
+            std::sort(model->queued.begin(), model->queued.end(), fartherFrom);
+        }
+
+        for (irr::u32 i = 0; i < model->materials.size(); i++) {
+            const irr::video::SMaterial& material = model->materials[i];
+            const irr::video::IMaterialRenderer* renderer = driver->getMaterialRenderer(material.MaterialType);
+            const bool transparent = renderer && renderer->isTransparent();
+            if (transparent != transparentPass) {
+                continue;
+            }
+
+            const irr::scene::IMeshBuffer* meshBuffer = model->mesh->getMeshBuffer(i);
+            driver->setMaterial(material);
+            batchCount++;
+            for (std::vector<ModelInstanceNode*>::const_iterator instance = model->queued.begin(); instance != model->queued.end(); ++instance) {
+                driver->setTransform(irr::video::ETS_WORLD, (*instance)->getAbsoluteTransformation());
+                driver->drawMeshBuffer(meshBuffer);
+                drawCount++;
+            }
+        }
+
+        //The transparent pass is the last, so start again for the next frame
+        if (transparentPass) {
+            model->queued.clear();
+        }
+    }
+}
+
+const irr::core::aabbox3d<irr::f32>& ModelRepository::getBoundingBox() const
+{
+    return box;
+}
+
+irr::scene::ESCENE_NODE_TYPE ModelRepository::getType() const
+{
+    return MODEL_REPOSITORY_TYPE;
+}
+
+ModelInstanceNode::ModelInstanceNode(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr, irr::s32 id, ModelRepository* repository, irr::u32 model) : irr::scene::ISceneNode(parent, smgr, id)
+{
+    this->repository = repository;
+    this->model = model;
+    repository->grab();
+}
+
+ModelInstanceNode::~ModelInstanceNode()
+{
+    repository->removeInstance(model, this);
+    repository->drop();
+}
+
+void ModelInstanceNode::OnRegisterSceneNode()
+{
+    if (IsVisible) {
+        if (!SceneManager->isCulled(this)) {
+            repository->queueInstance(model, this);
+        }
+        ISceneNode::OnRegisterSceneNode();
+    }
+}
+
+void ModelInstanceNode::render()
+{
+    //Drawn by the repository
+}
+
+const irr::core::aabbox3d<irr::f32>& ModelInstanceNode::getBoundingBox() const
+{
+    return repository->models[model].mesh->getBoundingBox();
+}
+
+irr::u32 ModelInstanceNode::getMaterialCount() const
+{
+    return repository->models[model].materials.size();
+}
+
+irr::video::SMaterial& ModelInstanceNode::getMaterial(irr::u32 i)
+{
+    if (i >= repository->models[model].materials.size()) {
+        return ISceneNode::getMaterial(i);
+    }
+    return repository->models[model].materials[i];
+}
+
+irr::scene::ESCENE_NODE_TYPE ModelInstanceNode::getType() const
+{
+    return MODEL_INSTANCE_TYPE;
+}
+
+irr::u32 ModelInstanceNode::getModel() const
+{
+    return model;
+}
@@ -0,0 +1,110 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __MODELREPOSITORY_HPP_INCLUDED__
+#define __MODELREPOSITORY_HPP_INCLUDED__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "irrlicht.h"
+
+class ModelInstanceNode;
+
+//The models used by other ships, buoys and land objects, each loaded once however many times it is placed.
+//A model keeps one mesh, one set of materials and one set of collision triangles. Its instances are scene nodes
+//holding just a transform, and render() draws the instances seen by the camera model by model, so each material is
+//set once for all of them.
+class ModelRepository : public irr::scene::ISceneNode {
+
+    public:
+        //The repository of the scene, added to its root on first use
+        static ModelRepository* getRepository(irr::scene::ISceneManager* smgr);
+
+        //Loads the model from the file (or the mesh cache) the first time. Returns the model id, or -1 if it can't be loaded.
+        irr::s32 getModel(const std::string& fileName);
+
+        //Adds a scene node drawing the model. The materials of a static model are shared by all its instances, so
+        //setting them on one sets them on all. Animated models get a normal animated mesh scene node instead.
+        irr::scene::ISceneNode* addInstance(irr::u32 model, irr::scene::ISceneNode* parent=0, irr::s32 id=-1, const irr::core::vector3df& position=irr::core::vector3df(0,0,0));
+
+        //A selector for the node, over the collision triangles of its model. Drop it when done, as for ISceneManager::createTriangleSelector.
+        irr::scene::ITriangleSelector* createTriangleSelector(irr::u32 model, irr::scene::ISceneNode* node);
+
+        irr::u32 getModelCount() const;
+        irr::scene::IMesh* getMesh(irr::u32 model) const; //The first frame, or 0 if there is no such model
+        irr::u32 getInstanceCount() const;
+        irr::u32 getDrawCount() const; //Mesh buffers drawn in the last frame
+        irr::u32 getBatchCount() const; //Materials set in the last frame
+
+        //Scene node
+        virtual void OnRegisterSceneNode();
+        virtual void render();
+        virtual const irr::core::aabbox3d<irr::f32>& getBoundingBox() const;
+        virtual irr::scene::ESCENE_NODE_TYPE getType() const;
+
+    private:
+        friend class ModelInstanceNode;
+
+        ModelRepository(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr);
+        ~ModelRepository();
+
+        void queueInstance(irr::u32 model, ModelInstanceNode* instance);
+        void removeInstance(irr::u32 model, ModelInstanceNode* instance);
+
+        struct Model {
+            irr::scene::IAnimatedMesh* animatedMesh; //Grabbed
+            irr::scene::IMesh* mesh; //First frame of animatedMesh
+            bool animated;
+            std::vector<irr::video::SMaterial> materials; //Per mesh buffer
+            irr::scene::ITriangleSelector* triangles; //In model coordinates, made on first use
+            irr::u32 instanceCount;
+            std::vector<ModelInstanceNode*> queued; //To draw this frame
+        };
+
+        std::vector<Model> models;
+        std::map<std::string, irr::u32> modelIds;
+        irr::u32 instanceCount;
+        irr::u32 drawCount;
+        irr::u32 batchCount;
+        irr::core::aabbox3d<irr::f32> box;
+};
+
+//An instance of a static model. It only holds its transform, and leaves drawing to the repository.
+class ModelInstanceNode : public irr::scene::ISceneNode {
+
+    public:
+        virtual void OnRegisterSceneNode();
+        virtual void render();
+        virtual const irr::core::aabbox3d<irr::f32>& getBoundingBox() const;
+        virtual irr::u32 getMaterialCount() const;
+        virtual irr::video::SMaterial& getMaterial(irr::u32 i);
+        virtual irr::scene::ESCENE_NODE_TYPE getType() const;
+
+        irr::u32 getModel() const; //The id in the repository
+
+    private:
+        friend class ModelRepository;
+
+        ModelInstanceNode(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr, irr::s32 id, ModelRepository* repository, irr::u32 model);
+        ~ModelInstanceNode();
+
+        ModelRepository* repository; //Grabbed, so it outlives its instances
+        irr::u32 model;
+};
+
+#endif
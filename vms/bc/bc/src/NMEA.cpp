@@ -25,10 +25,128 @@
 #include "AIS.hpp"
 #include "Autopilot.hpp"
 #include "Constants.hpp"
+#include "NMEACodec.hpp"
 #include "NMEASentences.hpp"
 #include "SimulationModel.hpp"
 #include "Utilities.hpp"
 
+namespace {
+// Where each sensor value is in NMEAValues::values
+enum SensorValue {
+  SOG = 0,
+  COG,
+  RUDDER,
+  HEADING,
+  RATE_OF_TURN,
+  DEPTH,
+  SHAFT,
+  SHAFT_RPM,
+  TARGET,
+  TARGET_RANGE,
+  TARGET_BEARING,
+  TARGET_SPEED,
+  TARGET_COURSE,
+  TARGET_CPA,
+  TARGET_TCPA
+};
+
+// EN 61162-1:2011 sentences, field by field after the address
+
+// 8.3.69 Recommended minimum navigation information
+const NMEAField RMC_FIELDS[] = {
+    {NMEA_FIELD_TIME},         {NMEA_FIELD_TEXT, 0, 0, 0, "A"},
+    {NMEA_FIELD_POSITION},     {NMEA_FIELD_FIXED, SOG, 1},
+    {NMEA_FIELD_FIXED, COG, 1}, {NMEA_FIELD_DATE},
+    {NMEA_FIELD_EMPTY},        {NMEA_FIELD_EMPTY},
+    {NMEA_FIELD_TEXT, 0, 0, 0, "A"}, {NMEA_FIELD_TEXT, 0, 0, 0, "S"}};
+// 8.3.71 Rate of turn, A = data valid
+const NMEAField ROT_FIELDS[] = {{NMEA_FIELD_FIXED, RATE_OF_TURN, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"}};
+// 8.3.36 Geographic position – Latitude/longitude
+const NMEAField GLL_FIELDS[] = {{NMEA_FIELD_POSITION},
+                                {NMEA_FIELD_TIME},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"}};
+// 8.3.73 Rudder sensor angle: starboard (or single), A is valid, port sensor
+// is null, thus V for invalid
+const NMEAField RSA_FIELDS[] = {{NMEA_FIELD_FIXED, RUDDER, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"},
+                                {NMEA_FIELD_EMPTY},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "V"}};
+// 8.3.72 Revolutions: 'S' is for shaft, '100' is pitch (fixed)
+const NMEAField RPM_FIELDS[] = {{NMEA_FIELD_TEXT, 0, 0, 0, "S"},
+                                {NMEA_FIELD_INT, SHAFT},
+                                {NMEA_FIELD_INT, SHAFT_RPM},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "100"},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"}};
+// 8.3.44 Heading true, T = true north
+const NMEAField HDT_FIELDS[] = {{NMEA_FIELD_FIXED, HEADING, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "T"}};
+// 8.3.85 Tracked target message
+const NMEAField TTM_FIELDS[] = {{NMEA_FIELD_INT, TARGET, 0, 2},
+                                {NMEA_FIELD_FIXED, TARGET_RANGE, 1},
+                                {NMEA_FIELD_FIXED, TARGET_BEARING, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "T"},
+                                {NMEA_FIELD_FIXED, TARGET_SPEED, 1},
+                                {NMEA_FIELD_FIXED, TARGET_COURSE, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "T"},
+                                {NMEA_FIELD_FIXED, TARGET_CPA, 1},
+                                {NMEA_FIELD_FIXED, TARGET_TCPA, 1},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "N"},
+                                {NMEA_FIELD_INT, TARGET, 0, 2, "TGT"},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "T"},
+                                {NMEA_FIELD_EMPTY},
+                                {NMEA_FIELD_TIME},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "A"}};
+// 8.3.35 Global positioning system (GPS) fix data
+const NMEAField GGA_FIELDS[] = {
+    {NMEA_FIELD_TIME},        {NMEA_FIELD_POSITION},
+    {NMEA_FIELD_TEXT, 0, 0, 0, "1"},   {NMEA_FIELD_TEXT, 0, 0, 0, "12"},
+    {NMEA_FIELD_TEXT, 0, 0, 0, "0.0"}, {NMEA_FIELD_TEXT, 0, 0, 0, "0.0"},
+    {NMEA_FIELD_TEXT, 0, 0, 0, "M"},   {NMEA_FIELD_TEXT, 0, 0, 0, "0.0"},
+    {NMEA_FIELD_TEXT, 0, 0, 0, "M"},   {NMEA_FIELD_EMPTY},
+    {NMEA_FIELD_EMPTY}};
+// 8.3.106 Time and date
+const NMEAField ZDA_FIELDS[] = {{NMEA_FIELD_TIME},
+                                {NMEA_FIELD_DAY},
+                                {NMEA_FIELD_MONTH},
+                                {NMEA_FIELD_YEAR},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "00"},
+                                {NMEA_FIELD_TEXT, 0, 0, 0, "00"}};
+// 8.3.27 Datum reference
+const NMEAField DTM_FIELDS[] = {
+    {NMEA_FIELD_TEXT, 0, 0, 0, "W84"}, {NMEA_FIELD_EMPTY}, {NMEA_FIELD_EMPTY},
+    {NMEA_FIELD_EMPTY}, {NMEA_FIELD_EMPTY}, {NMEA_FIELD_EMPTY},
+    {NMEA_FIELD_EMPTY}, {NMEA_FIELD_EMPTY}};
+// Depth, Offset from transducer: Positive - distance from transducer to water
+// line, or Negative - distance from transducer to keel, max depth measurable
+const NMEAField DPT_FIELDS[] = {{NMEA_FIELD_FIXED, DEPTH, 1},
+                                {NMEA_FIELD_EMPTY},
+                                {NMEA_FIELD_EMPTY}};
+
+template <irr::u32 N>
+NMEAFormat makeFormat(char start, const char* address,
+                      const NMEAField (&fields)[N]) {
+  NMEAFormat format = {start, address, fields, N};
+  return format;
+}
+
+// Indexed by NMEA::NMEAMessage
+const NMEAFormat SENSOR_FORMATS[] = {
+    makeFormat('$', "GPRMC", RMC_FIELDS), makeFormat('$', "GPROT", ROT_FIELDS),
+    makeFormat('$', "GPGLL", GLL_FIELDS), makeFormat('$', "IIRSA", RSA_FIELDS),
+    makeFormat('$', "IIRPM", RPM_FIELDS), makeFormat('$', "GPHDT", HDT_FIELDS),
+    makeFormat('$', "HEROT", ROT_FIELDS), makeFormat('$', "RATTM", TTM_FIELDS),
+    makeFormat('$', "GPGGA", GGA_FIELDS), makeFormat('$', "RAZDA", ZDA_FIELDS),
+    makeFormat('$', "RADTM", DTM_FIELDS), makeFormat('$', "HEHDT", HDT_FIELDS),
+    makeFormat('$', "TIROT", ROT_FIELDS), makeFormat('$', "SDDPT", DPT_FIELDS)};
+
+// Received sentences, by field: see NMEAReceivedSentence::decode
+const char APB_LAYOUT[] = "ccfccccfctfcfc";
+const char RMB_LAYOUT[] = "cfctttctcfffc";
+const char RMB_MODE_LAYOUT[] = "cfctttctcfffcc";  // NMEA 2.3 and later
+}  // namespace
+
 NMEA::NMEA(SimulationModel* model, std::string serialPortName,
            irr::u32 serialBaudrate, std::string udpHostname,
            std::string udpPortName, std::string udpListenPortName,
@@ -40,6 +158,7 @@ NMEA::NMEA(SimulationModel* model, std::string serialPortName,
   device = dev;         // Store pointer to irrlicht device
 
   messageQueue = {};
+  queuedMessages = 0;
   lastSendEvent = 0;
   currentMessageType = 0;
 
@@ -59,9 +178,7 @@ NMEA::NMEA(SimulationModel* model, std::string serialPortName,
   // set up listening thread
   terminateNmeaReceive = 0;
   receivedNmeaMessages = std::vector<std::string>();
-  std::thread* receiveThreadObject = 0;
-  receiveThreadObject =
-      new std::thread(&NMEA::ReceiveThread, this, udpListenPortName);
+  receiveThread = std::thread(&NMEA::ReceiveThread, this, udpListenPortName);
 
   // create send socket
   socket = new asio::ip::udp::socket(io_service);
@@ -97,6 +214,8 @@ NMEA::~NMEA() {
   terminateNmeaReceiveMutex.lock();
   terminateNmeaReceive = 1;
   terminateNmeaReceiveMutex.unlock();
+  // it notices within its socket's timeout
+  if (receiveThread.joinable()) receiveThread.join();
 }
 
 void NMEA::ReceiveThread(std::string udpListenPortName) {
@@ -116,6 +235,20 @@ void NMEA::ReceiveThread(std::string udpListenPortName) {
     return;
   }
 
+// set socket timeout as in AISOverUDP
+#ifdef WIN32
+  DWORD timeout = 1000;
+  setsockopt(rcvSocket.native_handle(), SOL_SOCKET, SO_RCVTIMEO,
+             (char*)&timeout, sizeof(DWORD));
+#else
+  struct timeval tv = {1, 0};
+  setsockopt(rcvSocket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv,
+             sizeof(tv));
+#endif
+
+  // One datagram, which may hold several sentences
+  char buf[1500];
+
   for (;;) {
     try {
       // terminate thread?
@@ -126,19 +259,6 @@ void NMEA::ReceiveThread(std::string udpListenPortName) {
       }
       terminateNmeaReceiveMutex.unlock();
 
-      char* buf = new char[128]();
-
-// set socket timeout as in AISOverUDP
-#ifdef WIN32
-      DWORD timeout = 1000;
-      setsockopt(rcvSocket.native_handle(), SOL_SOCKET, SO_RCVTIMEO,
-                 (char*)&timeout, sizeof(DWORD)) != 0;
-#else
-      struct timeval tv = {1, 0};
-      setsockopt(rcvSocket.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv,
-                 sizeof(tv));
-#endif
-
 // read from socket
 #ifdef WIN32
       int nread = ::recv(rcvSocket.native_handle(), buf, sizeof(buf), 0);
@@ -150,11 +270,10 @@ void NMEA::ReceiveThread(std::string udpListenPortName) {
         // first char $ or !, otherwise ignore
         if (!(buf[0] == '$' || buf[0] == '!')) continue;
 
-        // convert char buffer to string and add it to shared vector
-        // subsequent processing is handled by NMEA::receive
-        std::string message(buf);
+        // add it to shared vector, subsequent processing is handled by
+        // NMEA::receive
         receivedNmeaMessagesMutex.lock();
-        receivedNmeaMessages.push_back(message);
+        receivedNmeaMessages.push_back(std::string(buf, nread));
         receivedNmeaMessagesMutex.unlock();
       }
 
@@ -164,186 +283,146 @@ void NMEA::ReceiveThread(std::string udpListenPortName) {
   }
 }
 
-void NMEA::receive() {
-  // check the receivedNmeaMessages shared vector for new messages
-  // if it is non-empty, parse the messages
+irr::u32 NMEA::receive() {
+  // take the new messages from the receive thread, and parse them without
+  // holding it up
   receivedNmeaMessagesMutex.lock();
-  if (!receivedNmeaMessages.empty()) {
-    for (int i = 0; i < receivedNmeaMessages.size(); i++) {
-      std::string message = receivedNmeaMessages[i];
-
-      // get all sentences and strip \r\n
-      std::vector<std::string> sentences;
-      int last_pos = 0;
-      int pos = message.find("\r\n");
-      while (pos != std::string::npos) {
-        int sentence_len = pos - last_pos;
-        sentences.push_back(message.substr(last_pos, sentence_len));
-        last_pos = pos;
-        pos = message.find("\r\n", pos + 3);
-      }
+  processingNmeaMessages.swap(receivedNmeaMessages);
+  receivedNmeaMessagesMutex.unlock();
 
-      // iterate over sentences and handle them one by one
-      for (int i = 0; i < sentences.size(); i++) {
-        std::string sentence = sentences[i];
-
-        if (sentence.length() < 10) continue;
-
-        // parse the provided checksum and verify it
-        irr::u32 providedChecksum;
-        irr::u32 checksum;
-        try {
-          providedChecksum =
-              std::stoi(sentence.substr(sentence.length() - 2, 2), 0, 16);
-          checksum = sentence.at(1);
-          for (auto character : sentence.substr(2, sentence.length() - 5))
-            checksum ^= character;
-          if (checksum != providedChecksum) {
-            std::cerr << "invalid checksum: " << sentence << " expected "
-                      << std::hex << checksum << std::endl;
-            continue;
-          }
-        } catch (const std::invalid_argument& e) {
-          continue;
-        } catch (const std::out_of_range& e) {
-          continue;
-        }
-
-        // construct vector of fields
-        std::vector<std::string> fields;
-        char last_char;
-        std::string field = "";
-        for (int i = 7; i < sentence.length(); i++) {
-          last_char = sentence[i];
-          if (last_char == '*') break;
-          if (last_char == ',') {
-            fields.push_back(field);
-            field = "";
-          } else {
-            field += last_char;
-          }
-        }
-        fields.push_back(field);
-
-        std::string type = sentence.substr(0, 1);
-
-        if (!type.compare("!")) continue;  // AIS sentence
-
-        if (!type.compare("$")) {  // normal sentence
-          if (!sentence.substr(1, 1).compare("P")) {
-            // proprietary sentence
-            continue;
-          } else {
-            std::string id = sentence.substr(3, 3);
-
-            if (!id.compare("APB")) {  // autopilot sentence B
-
-              if (fields.size() != 14) continue;  // we expect exactly 14 fields
-
-              APB apb;
-              try {
-                apb.status = fields[0][0];
-                apb.warning = fields[1][0];
-                apb.cross_track_error = std::stof(fields[2]);
-                apb.direction = fields[3][0];
-                apb.cross_track_units = fields[4][0];
-                apb.arrival_circle_entered = fields[5][0];
-                apb.perpendicular_passed = fields[6][0];
-                apb.bearing_orig_to_dest = std::stof(fields[7]);
-                apb.bearing_orig_to_dest_type = fields[8][0];
-                apb.dest_waypoint_id = fields[9];
-                apb.bearing_to_dest = std::stof(fields[10]);
-                apb.bearing_orig_to_dest_type = fields[11][0];
-                apb.heading_to_dest = std::stof(fields[12]);
-                apb.heading_to_dest_type = fields[13][0];
-              } catch (const std::invalid_argument& e) {
-                std::cerr << "error while parsing a float value for APB"
-                          << std::endl;
-                continue;
-              }
-
-              autopilot.receiveAPB(apb);
-
-            } else if (!id.compare("RMB")) {  // recommended minimum navigation
-                                              // information B
-
-              if (fields.size() != 13 && fields.size() != 14)
-                continue;  // 13 or 14 fields based on NMEA version
-
-              RMB rmb;
-              try {
-                rmb.status = fields[0][0];
-                rmb.cross_track_error = std::stof(fields[1]);
-                rmb.direction = fields[2][0];
-                rmb.dest_waypoint_id = fields[3];
-                rmb.orig_waypoint_id = fields[4];
-                rmb.dest_waypoint_latitude = fields[5];
-                rmb.dest_waypoint_latitude_dir = fields[6][0];
-                rmb.dest_waypoint_longitude = fields[7];
-                rmb.dest_waypoint_longitude_dir = fields[8][0];
-                rmb.range_to_dest = std::stof(fields[9]);
-                rmb.bearing_to_dest = std::stof(fields[10]);
-                rmb.dest_closing_velocity = std::stof(fields[11]);
-                rmb.arrival_status = fields[12][0];
-                rmb.faa_mode = '\0';
-                if (fields.size() == 14) rmb.faa_mode = fields[13][0];
-              } catch (const std::invalid_argument& e) {
-                std::cerr << "error while parsing a float value for RMB"
-                          << std::endl;
-                continue;
-              }
-
-              autopilot.receiveRMB(rmb);
-            }
-          }
-        }
-      }
+  irr::u32 handled = 0;
+  for (irr::u32 i = 0; i < processingNmeaMessages.size(); i++) {
+    const std::string& message = processingNmeaMessages[i];
+
+    // handle the sentences one by one, ending at <CR><LF> or the end of the
+    // datagram
+    const char* text = message.data();
+    const irr::u32 length = message.length();
+    irr::u32 sentenceStart = 0;
+    while (sentenceStart < length) {
+      irr::u32 sentenceEnd = sentenceStart;
+      while (sentenceEnd < length && text[sentenceEnd] != '\n') sentenceEnd++;
+      if (handleSentence(text + sentenceStart, sentenceEnd - sentenceStart))
+        handled++;
+      sentenceStart = sentenceEnd + 1;
     }
-    receivedNmeaMessages.clear();
   }
-  receivedNmeaMessagesMutex.unlock();
+  processingNmeaMessages.clear();
+  return handled;
 }
 
-void NMEA::updateNMEA() {
-  char messageBuffer[maxSentenceChars];
-  for (int i = 0; i < maxSentenceChars;
-       i++) {  // Avoid error about variable size object initialization
-    messageBuffer[i] = 0;
+bool NMEA::handleSentence(const char* text, irr::u32 length) {
+  NMEAReceivedSentence sentence;
+  if (!sentence.parse(text, length)) {
+    if (length > 2) {  // Not just a line ending
+      std::cerr << "invalid NMEA sentence: " << std::string(text, length)
+                << std::endl;
+    }
+    return false;
   }
 
+  // AIS and proprietary sentences are ignored
+  if (sentence.getStart() != '$' || sentence.isProprietary()) return false;
+
+  if (sentence.getFormatter() == NMEA_APB) {  // autopilot sentence B
+    APB apb;
+    if (!decodeAPB(sentence, apb)) {
+      std::cerr << "error while parsing a float value for APB" << std::endl;
+      return false;
+    }
+    autopilot.receiveAPB(apb);
+    return true;
+  } else if (sentence.getFormatter() == NMEA_RMB) {  // recommended minimum
+                                                     // navigation information B
+    RMB rmb;
+    if (!decodeRMB(sentence, rmb)) {
+      std::cerr << "error while parsing a float value for RMB" << std::endl;
+      return false;
+    }
+    autopilot.receiveRMB(rmb);
+    return true;
+  }
+  return false;
+}
+
+bool NMEA::decodeAPB(const NMEAReceivedSentence& sentence, APB& apb) {
+  if (sentence.getFieldCount() != 14) return false;  // exactly 14 fields
+
+  void* const targets[] = {&apb.status,
+                           &apb.warning,
+                           &apb.cross_track_error,
+                           &apb.direction,
+                           &apb.cross_track_units,
+                           &apb.arrival_circle_entered,
+                           &apb.perpendicular_passed,
+                           &apb.bearing_orig_to_dest,
+                           &apb.bearing_orig_to_dest_type,
+                           apb.dest_waypoint_id,
+                           &apb.bearing_to_dest,
+                           &apb.bearing_to_dest_type,
+                           &apb.heading_to_dest,
+                           &apb.heading_to_dest_type};
+  return sentence.decode(APB_LAYOUT, targets, NMEA_TEXT_LENGTH);
+}
+
+bool NMEA::decodeRMB(const NMEAReceivedSentence& sentence, RMB& rmb) {
+  if (sentence.getFieldCount() != 13 && sentence.getFieldCount() != 14)
+    return false;  // 13 or 14 fields based on NMEA version
+
+  void* const targets[] = {&rmb.status,
+                           &rmb.cross_track_error,
+                           &rmb.direction,
+                           rmb.dest_waypoint_id,
+                           rmb.orig_waypoint_id,
+                           rmb.dest_waypoint_latitude,
+                           &rmb.dest_waypoint_latitude_dir,
+                           rmb.dest_waypoint_longitude,
+                           &rmb.dest_waypoint_longitude_dir,
+                           &rmb.range_to_dest,
+                           &rmb.bearing_to_dest,
+                           &rmb.dest_closing_velocity,
+                           &rmb.arrival_status,
+                           &rmb.faa_mode};
+  rmb.faa_mode = '\0';
+  const char* layout =
+      sentence.getFieldCount() == 14 ? RMB_MODE_LAYOUT : RMB_LAYOUT;
+  return sentence.decode(layout, targets, NMEA_TEXT_LENGTH);
+}
+
+std::string& NMEA::nextMessage() {
+  if (queuedMessages == messageQueue.size()) messageQueue.push_back("");
+  std::string& message = messageQueue[queuedMessages++];
+  message.clear();  // Keeps its capacity
+  return message;
+}
+
+void NMEA::updateNMEA() {
+  NMEASentence sentence;
+
   irr::u32 now = device->getTimer()->getTime();
 
   // AIS messages are scheduled based on amount of otherShips and their speed
   // check each frame if a new report should be sent
   if (model->getNumberOfOtherShips() >=
       0) {  // only consider AIS if there are other ships
-    std::string messageToSend = "";
+    std::string* messageToSend = 0;
     // which ships are ready to send?
     std::vector<irr::u32> readyShips = AIS::getReadyShips(model, now);
     for (auto ship : readyShips) {
       // 8.3.90 AIS VHF data-link message (6-bit, iaw ITU-R M.1371)
       // Position Report Class A
-      int fragments = 1;
-      int fragmentNumber = 1;
-      char radioChannel = 'B';
       std::string data;
       int fillBits;
-      bool done;
       std::tie(data, fillBits) = AIS::generateClassAReport(model, ship);
+      if (!encodeAIVDM(sentence, 1, 1, 'B', data.c_str(), fillBits)) continue;
 
-      snprintf(messageBuffer, maxSentenceChars, "!AIVDM,%d,%d,,%c,%s,%d",
-               fragments, fragmentNumber, radioChannel, data.c_str(), fillBits);
-      messageToSend.append(addChecksum(std::string(messageBuffer)));
-      if (messageToSend.length() >
+      if (!messageToSend) messageToSend = &nextMessage();
+      messageToSend->append(sentence.c_str(), sentence.length());
+      if (messageToSend->length() >
           800) {  // ensure we don't build too big of a UDP packet
-        messageQueue.push_back(messageToSend);
-        messageToSend = "";
+        messageToSend = 0;
       }
     }
-    readyShips.clear();
-    if (messageToSend != "") {
-      messageQueue.push_back(messageToSend);
-    }
   }
 
   // if sufficient time elapsed since the last sensor report was sent,
@@ -352,221 +431,63 @@ void NMEA::updateNMEA() {
     return;
   }
 
-  std::string dateTimeString = Utilities::ttos(model->getTimestamp());
-
-  std::string dateString = dateTimeString.substr(0, 8);
-  std::string timeString = dateTimeString.substr(8, 6);
-
-  const char* year = dateString.substr(0, 4).c_str();
-  const char* mon = dateString.substr(4, 2).c_str();
-  const char* mday = dateString.substr(6, 2).c_str();
-
-  const char* hour = timeString.substr(0, 4).c_str();
-  const char* min = timeString.substr(4, 2).c_str();
-  const char* sec = timeString.substr(6, 2).c_str();
-
-  irr::f32 rudderAngle = model->getRudder();
-
-  int engineRPM[] = {
-      Utilities::round(model->getStbdEngineRPM()),  // idx=1, odd (starboard)
-      Utilities::round(model->getPortEngineRPM())   // idx=2, even (port)
-  };
-
-  irr::f32 lat = model->getLat();
-  irr::f32 lon = model->getLong();
-
-  irr::f32 cog = model->getCOG();
-  irr::f32 sog = model->getSOG() * MPS_TO_KTS;
-
-  irr::f32 hdg = model->getHeading();
-  irr::f32 rot = model->getRateOfTurn() * RAD_PER_S_IN_DEG_PER_MINUTE;
-
-  irr::f32 depth = model->getDepth();
-
-  char eastWest = easting[lon < 0];
-  char northSouth = northing[lat < 0];
-
-  lat = fabs(lat);
-  lon = fabs(lon);
-  irr::f32 latMinutes = (lat - (int)lat) * 60;
-  irr::f32 lonMinutes = (lon - (int)lon) * 60;
-  irr::u8 latDegrees = (int)lat;
-  irr::u8 lonDegrees = (int)lon;
-
-  switch (currentMessageType) {  // EN 61162-1:2011
-    case RMC:  // 8.3.69 Recommended minimum navigation information
-    {
-      snprintf(messageBuffer, maxSentenceChars,
-               "$GPRMC,%s%s%s.00,A,%02u%06.3f,%c,%03u%06.3f,%c,%.1f,%.1f,%s%s%"
-               "s,,,A,S",
-               hour, min, sec, latDegrees, latMinutes, northSouth, lonDegrees,
-               lonMinutes, eastWest, sog, cog, year, mon,
-               mday);  // FIXME: SOG -> knots, COG->degrees
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case GLL:  // 8.3.36 Geographic position – Latitude/longitude
-    {
-      snprintf(messageBuffer, maxSentenceChars,
-               "$GPGLL,%02u%06.3f,%c,%03u%06.3f,%c,%s%s%s.00,A,A", latDegrees,
-               latMinutes, northSouth, lonDegrees, lonMinutes, eastWest, hour,
-               min, sec);
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case GGA:  // 8.3.35 Global positioning system (GPS) fix data
-    {
-      snprintf(
-          messageBuffer, maxSentenceChars,
-          "$GPGGA,%s%s%s.00,%02u%06.3f,%c,%03u%06.3f,%c,1,12,0.0,0.0,M,0.0,M,,",
-          hour, min, sec, latDegrees, latMinutes, northSouth, lonDegrees,
-          lonMinutes,
-          eastWest);  // Hardcoded NMEA Quality 8, Satellites 8, HDOP 0.9
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case RSA:  // 8.3.73 Rudder sensor angle
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$IIRSA,%.1f,A,,V",
-               rudderAngle);  // starboard (or single), A is valid, port sensor
-                              // is null, thus V for invalid
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case RPM:  // 8.3.72 Revolutions
-    {
-      std::string messageToSend = "";
+  NMEAValues values;
+  values.setTimestamp(model->getTimestamp());
+  values.latitude = model->getLat();
+  values.longitude = model->getLong();
+  values.payload = 0;
+
+  const NMEAFormat& format = SENSOR_FORMATS[currentMessageType];
+  switch (currentMessageType) {
+    case RPM: {
+      std::string& messageToSend = nextMessage();
+      int engineRPM[] = {
+          Utilities::round(model->getStbdEngineRPM()),  // idx=1, odd (stbd)
+          Utilities::round(model->getPortEngineRPM())   // idx=2, even (port)
+      };
       for (int i = 0; i < 2; i++) {
-        snprintf(messageBuffer, maxSentenceChars, "$IIRPM,S,%d,%d,100,A", i + 1,
-                 engineRPM[i]);  // 'S' is for shaft, '100' is pitch (fixed)
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
+        values.values[SHAFT] = i + 1;
+        values.values[SHAFT_RPM] = engineRPM[i];
+        if (encodeNMEASentence(sentence, format, values))
+          messageToSend.append(sentence.c_str(), sentence.length());
       }
-      messageQueue.push_back(messageToSend);
       break;
     }
-    case TTM:  // 8.3.85 Tracked target message
-    {
-      if (model->getARPATracks() > 0) {
-        std::string messageToSend = "";
-        // To think about/add: Lost contacts? Manually aquired contacts?
-        for (int i = 0; i < model->getARPATracks(); i++) {
-          ARPAContact contact = model->getARPATrack(i);
-          ARPAEstimatedState state = contact.estimate;
-          snprintf(messageBuffer, maxSentenceChars,
-                   "$RATTM,%02d,%.1f,%.1f,T,%.1f,%.1f,T,%.1f,%.1f,N,TGT%02d,T,,"
-                   "%s.00,A",
-                   state.displayID - 1, state.range, state.bearing, state.speed,
-                   state.absHeading, state.cpa, state.tcpa, state.displayID - 1,
-                   timeString.c_str());
-          messageToSend.append(addChecksum(std::string(messageBuffer)));
-        }
-        if (messageToSend != "") messageQueue.push_back(messageToSend);
+    case TTM: {
+      // To think about/add: Lost contacts? Manually aquired contacts?
+      std::string* messageToSend = 0;
+      for (irr::u32 i = 0; i < model->getARPATracks(); i++) {
+        ARPAContact contact = model->getARPATrack(i);
+        ARPAEstimatedState state = contact.estimate;
+        values.values[TARGET] = (irr::s32)(state.displayID - 1);
+        values.values[TARGET_RANGE] = state.range;
+        values.values[TARGET_BEARING] = state.bearing;
+        values.values[TARGET_SPEED] = state.speed;
+        values.values[TARGET_COURSE] = state.absHeading;
+        values.values[TARGET_CPA] = state.cpa;
+        values.values[TARGET_TCPA] = state.tcpa;
+        if (!encodeNMEASentence(sentence, format, values)) continue;
+        if (!messageToSend) messageToSend = &nextMessage();
+        messageToSend->append(sentence.c_str(), sentence.length());
       }
       break;
     }
-    /*
-    case RSD: // 8.3.74 Radar system data
-        snprintf(messageBuffer,maxSentenceChars,"$RARSD,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    case ZDA:  // 8.3.106 Time and date
-    {
-      snprintf(messageBuffer, maxSentenceChars,
-               "$RAZDA,%s%s%s.00,%s,%s,%s,00,00", hour, min, sec, mday, mon,
-               year);
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    /*
-    case OSD: // 8.3.64 Own ship data
-        snprintf(messageBuffer,maxSentenceChars,"$RAOSD,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    /*
-    /*
-    case POS: // 8.3.65 Device position and ship dimensions report or
-    configuration command snprintf(messageBuffer,maxSentenceChars,"$INPOS,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    case DTM:  // 8.3.27 Datum reference
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$RADTM,W84,,,,,,,");
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case HEHDT:  // 8.3.44 Heading true
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$HEHDT,%.1f,T",
-               hdg);  // T = true north
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case GPHDT:  // 8.3.44 Heading true
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$GPHDT,%.1f,T",
-               hdg);  // T = true north
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case DPT:  // Depth
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$SDDPT,%.1f,,",
-               depth);  // Depth, Offset from transducer: Positive - distance
-                        // from transducer to water line, or Negative - distance
-                        // from transducer to keel, max depth measurable
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case TIROT:  // 8.3.71 Rate of turn
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$TIROT,%.1f,A",
-               rot);  // A = data valid
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    case GPROT:  // 8.3.71 Rate of turn
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$GPROT,%.1f,A",
-               rot);  // A = data valid
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
+    default: {
+      // The sensors each sentence may need, as f32 like the model keeps them
+      values.values[SOG] = (irr::f32)(model->getSOG() * MPS_TO_KTS);
+      values.values[COG] = model->getCOG();
+      values.values[RUDDER] = model->getRudder();
+      values.values[HEADING] = model->getHeading();
+      values.values[RATE_OF_TURN] =
+          (irr::f32)(model->getRateOfTurn() * RAD_PER_S_IN_DEG_PER_MINUTE);
+      values.values[DEPTH] = model->getDepth();
+      if (encodeNMEASentence(sentence, format, values))
+        nextMessage().assign(sentence.c_str(), sentence.length());
       break;
     }
-    case HEROT:  // 8.3.71 Rate of turn
-    {
-      snprintf(messageBuffer, maxSentenceChars, "$HEROT,%.1f,A",
-               rot);  // A = data valid
-      messageQueue.push_back(addChecksum(std::string(messageBuffer)));
-      break;
-    }
-    /*
-    case VTG: // 8.3.98 Course over ground and ground speed
-        snprintf(messageBuffer,maxSentenceChars,"$VDVTG,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    /*
-    case HRM: // _, Heel angle, roll period, and roll amplitude
-        snprintf(messageBuffer,maxSentenceChars,"$IIHRM,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    /*
-    case HBT: // 8.3.42 Heartbeat supervision sentence (for engine room)
-        snprintf(messageBuffer,maxSentenceChars,"$ERHBT,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    /*
-    case VDO: // 8.3.91 AIS VHF data-link own-vessel report (6-bit, iaw ITU-R
-    M.1371) snprintf(messageBuffer,maxSentenceChars,"!AIVDO,");
-        messageToSend.append(addChecksum(std::string(messageBuffer)));
-        break;
-    */
-    default:
-      break;
   }
+  // not implemented: RSD (8.3.74), OSD (8.3.64), POS (8.3.65), VTG (8.3.98),
+  // HRM, HBT (8.3.42), VDO (8.3.91)
 
   lastSendEvent = now;
 
@@ -574,37 +495,25 @@ void NMEA::updateNMEA() {
   currentMessageType %= maxMessages;
 }
 
-void NMEA::clearQueue() { messageQueue.clear(); }
+void NMEA::clearQueue() { queuedMessages = 0; }
 
 void NMEA::sendNMEASerial() {
   if (mySerialPort.isOpen()) {
-    for (auto message : messageQueue) {
-      mySerialPort.write(message);
+    for (irr::u32 i = 0; i < queuedMessages; i++) {
+      mySerialPort.write(messageQueue[i]);
     }
   }
 }
 
 void NMEA::sendNMEAUDP() {
-  if (!messageQueue.empty()) {
+  if (queuedMessages > 0) {
     try {
       if (!socket->is_open()) socket->open(asio::ip::udp::v4());
-      for (auto message : messageQueue) {
-        socket->send_to(asio::buffer(message), receiver_endpoint);
+      for (irr::u32 i = 0; i < queuedMessages; i++) {
+        socket->send_to(asio::buffer(messageQueue[i]), receiver_endpoint);
       }
     } catch (std::exception& e) {
       device->getLogger()->log(e.what());
     }
   }
 }
-
-std::string NMEA::addChecksum(std::string messageIn) {
-  char checksumBuffer[3];
-  // Get checksum
-  unsigned char checksum = 0;
-  irr::u8 s = messageIn.length();
-  for (int i = 1; i < s; i++) {
-    checksum ^= messageIn.at(i);
-  }
-  snprintf(checksumBuffer, sizeof(checksumBuffer), "%02X", checksum);
-  return messageIn + "*" + std::string(checksumBuffer) + "\r\n";
-}
@@ -19,6 +19,7 @@
 
 #include <asio.hpp>  // For UDP
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <string>
 
@@ -41,7 +42,13 @@ class NMEA {
   void sendNMEAUDP();
   void clearQueue();
   void ReceiveThread(std::string udpListenPortName);
-  void receive();
+  // Hands the APB and RMB sentences received since the last call to the
+  // autopilot, returns how many there were
+  irr::u32 receive();
+  // The fields of a received sentence, false if it has the wrong number of
+  // fields or one is invalid
+  static bool decodeAPB(const NMEAReceivedSentence& sentence, APB& apb);
+  static bool decodeRMB(const NMEAReceivedSentence& sentence, RMB& rmb);
   // not implemented: RSD, OSD, POS, VTG, HRM, VDO, HBT
   enum NMEAMessage {
     RMC = 0,
@@ -68,14 +75,13 @@ class NMEA {
   irr::u32 lastSendEvent;  // when was the last time an NMEA message was sent
   static const irr::u32 sensorReportInterval =
       100;  // milliseconds between sensor reports
+  // Messages to send this frame. The strings are kept between frames and
+  // reused, so only the first queuedMessages are current.
   std::vector<std::string> messageQueue;
-  std::string messageToSend;
-  std::string addChecksum(std::string messageIn);
+  irr::u32 queuedMessages;
+  std::string& nextMessage();
+  bool handleSentence(const char* text, irr::u32 length);
   const int maxMessages = (DPT - RMC) + 1;  // how many messages are defined
-  static const int maxSentenceChars =
-      79 + 1 + 1;  // iaw EN 61162-1:2011 + start char + null termination
-  const char northing[2] = {'N', 'S'};
-  const char easting[2] = {'E', 'W'};
   int currentMessageType;  // sequentially send different sentences
   asio::io_service io_service;
   asio::ip::udp::endpoint receiver_endpoint;
@@ -84,7 +90,9 @@ class NMEA {
   irr::u32 terminateNmeaReceive;
   std::mutex terminateNmeaReceiveMutex;
   std::vector<std::string> receivedNmeaMessages;
+  std::vector<std::string> processingNmeaMessages;  // Swapped out of the lock
   std::mutex receivedNmeaMessagesMutex;
+  std::thread receiveThread;  // Joined before the above go
 };
 
 #endif  // __NMEA_HPP_INCLUDED__
@@ -0,0 +1,470 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2015 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "NMEACodec.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+const irr::f64 POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,
+                                  1e7,  1e8,  1e9,  1e10, 1e11, 1e12, 1e13,
+                                  1e14, 1e15, 1e16, 1e17, 1e18};
+const irr::u32 MAX_DECIMALS = 9;
+
+// Formatter ids are placed by (7 * a + 10 * b + c) & 31, which has no
+// collisions among those BC knows. A new formatter may need new multipliers.
+const irr::u32 FORMATTER_SLOTS = 32;
+
+irr::u32 formatterSlot(const char* id) {
+  return (7 * (irr::u8)id[0] + 10 * (irr::u8)id[1] + (irr::u8)id[2]) &
+         (FORMATTER_SLOTS - 1);
+}
+
+struct FormatterTable {
+  char ids[FORMATTER_SLOTS][3];
+  NMEAFormatter formatters[FORMATTER_SLOTS];
+
+  FormatterTable() {
+    memset(ids, 0, sizeof(ids));
+    for (irr::u32 i = 0; i < FORMATTER_SLOTS; i++) formatters[i] = NMEA_UNKNOWN;
+    add("APB", NMEA_APB);
+    add("DPT", NMEA_DPT);
+    add("DTM", NMEA_DTM);
+    add("GGA", NMEA_GGA);
+    add("GLL", NMEA_GLL);
+    add("HDT", NMEA_HDT);
+    add("RMB", NMEA_RMB);
+    add("RMC", NMEA_RMC);
+    add("ROT", NMEA_ROT);
+    add("RPM", NMEA_RPM);
+    add("RSA", NMEA_RSA);
+    add("TTM", NMEA_TTM);
+    add("VDM", NMEA_VDM);
+    add("ZDA", NMEA_ZDA);
+  }
+
+  void add(const char* id, NMEAFormatter formatter) {
+    irr::u32 slot = formatterSlot(id);
+    memcpy(ids[slot], id, 3);
+    formatters[slot] = formatter;
+  }
+};
+
+const FormatterTable& formatterTable() {
+  static const FormatterTable table;
+  return table;
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+}  // namespace
+
+NMEAFormatter lookupNMEAFormatter(const char* id) {
+  const FormatterTable& table = formatterTable();
+  irr::u32 slot = formatterSlot(id);
+  if (memcmp(table.ids[slot], id, 3) != 0) return NMEA_UNKNOWN;
+  return table.formatters[slot];
+}
+
+NMEASentence::NMEASentence() {
+  buffer[0] = 0;
+  size = 0;
+  checksum = 0;
+  overflow = false;
+}
+
+void NMEASentence::begin(char start, const char* address) {
+  size = 0;
+  checksum = 0;
+  overflow = false;
+  buffer[size++] = start;  // Not part of the checksum
+  putText(address);
+  buffer[size] = 0;
+}
+
+void NMEASentence::put(char c) {
+  // Leave room for *hh<CR><LF>
+  if (size + 5 >= MAX_LENGTH) {
+    overflow = true;
+    return;
+  }
+  buffer[size++] = c;
+  checksum ^= (irr::u8)c;
+}
+
+void NMEASentence::putText(const char* text) {
+  while (*text) put(*text++);
+}
+
+void NMEASentence::putUnsigned(irr::u64 value, irr::u32 width) {
+  char digits[20];
+  irr::u32 count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+  for (irr::u32 i = count; i < width; i++) put('0');
+  while (count) put(digits[--count]);
+}
+
+void NMEASentence::putFixed(irr::f64 value, irr::u32 decimals,
+                            irr::u32 width) {
+  if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+  const bool negative = std::signbit(value);
+  const irr::f64 magnitude = std::fabs(value);
+  const irr::f64 scaled = magnitude * POWERS_OF_TEN[decimals];
+
+  // Below 2^52 the scaled value keeps its halves. Rounding it to the nearest
+  // gives printf's digits, unless it is exactly a half: then the scaling may
+  // have rounded, as for 0.05, and only printf knows which way to go. An f32
+  // times 10^3 or less is exact, so that is rare.
+  if (!(scaled < 4503599627370496.0) || scaled - std::floor(scaled) == 0.5) {
+    // Also huge, infinite or not a number: never sensible in a sentence
+    char text[512];
+    snprintf(text, sizeof(text), "%0*.*f", (int)width, (int)decimals, value);
+    putText(text);
+    return;
+  }
+
+  const irr::u64 units = (irr::u64)std::nearbyint(scaled);
+  const irr::u64 scale = (irr::u64)POWERS_OF_TEN[decimals];
+  const irr::u64 whole = units / scale;
+
+  irr::u32 wholeDigits = 1;
+  for (irr::u64 rest = whole / 10; rest; rest /= 10) wholeDigits++;
+  irr::u32 length = (negative ? 1 : 0) + wholeDigits + (decimals ? decimals + 1 : 0);
+
+  if (negative) put('-');
+  for (; length < width; length++) put('0');
+  putUnsigned(whole, 0);
+  if (decimals) {
+    put('.');
+    putUnsigned(units % scale, decimals);
+  }
+}
+
+void NMEASentence::putPosition(irr::f32 angle, irr::u32 degreeDigits) {
+  // Degrees and minutes as f32, as the sentences have always been written
+  angle = std::fabs(angle);
+  irr::u32 degrees = (int)angle;
+  irr::f32 minutes = (angle - (int)angle) * 60;
+  irr::u64 thousandths = (irr::u64)std::nearbyint((irr::f64)minutes * 1000);
+  if (thousandths >= 60000) {
+    // Rounded up to a whole degree
+    degrees++;
+    thousandths -= 60000;
+  }
+  putUnsigned(degrees, degreeDigits);
+  putUnsigned(thousandths / 1000, 2);
+  put('.');
+  putUnsigned(thousandths % 1000, 3);
+}
+
+void NMEASentence::addEmpty() { put(','); }
+
+void NMEASentence::addText(const char* text) {
+  put(',');
+  putText(text);
+}
+
+void NMEASentence::addChar(char c) {
+  put(',');
+  put(c);
+}
+
+void NMEASentence::addInt(irr::s32 value, irr::u32 width, const char* prefix) {
+  put(',');
+  if (prefix) putText(prefix);
+  irr::u64 magnitude = value < 0 ? -(irr::s64)value : value;
+  if (value < 0) {
+    put('-');
+    if (width) width--;
+  }
+  putUnsigned(magnitude, width);
+}
+
+void NMEASentence::addFixed(irr::f64 value, irr::u32 decimals, irr::u32 width) {
+  put(',');
+  putFixed(value, decimals, width);
+}
+
+void NMEASentence::addLatitude(irr::f32 latitude) {
+  put(',');
+  putPosition(latitude, 2);
+  addChar(latitude < 0 ? 'S' : 'N');
+}
+
+void NMEASentence::addLongitude(irr::f32 longitude) {
+  put(',');
+  putPosition(longitude, 3);
+  addChar(longitude < 0 ? 'W' : 'E');
+}
+
+void NMEASentence::addTime(irr::u32 hour, irr::u32 minute, irr::u32 second) {
+  put(',');
+  putUnsigned(hour, 2);
+  putUnsigned(minute, 2);
+  putUnsigned(second, 2);
+  putText(".00");
+}
+
+void NMEASentence::addDate(irr::u32 day, irr::u32 month, irr::u32 year) {
+  put(',');
+  putUnsigned(day, 2);
+  putUnsigned(month, 2);
+  putUnsigned(year % 100, 2);
+}
+
+bool NMEASentence::finish() {
+  if (overflow || size + 5 > MAX_LENGTH) {
+    buffer[size] = 0;
+    return false;
+  }
+  buffer[size++] = '*';
+  buffer[size++] = HEX_DIGITS[checksum >> 4];
+  buffer[size++] = HEX_DIGITS[checksum & 0xF];
+  buffer[size++] = '\r';
+  buffer[size++] = '\n';
+  buffer[size] = 0;
+  return true;
+}
+
+void NMEAValues::setTimestamp(irr::s64 timestamp) {
+  // Civil date from days since 1970 (H. Hinnant, chrono-compatible low-level
+  // date algorithms), so no gmtime and no locking
+  irr::s64 days = timestamp / 86400;
+  irr::s64 seconds = timestamp % 86400;
+  if (seconds < 0) {
+    seconds += 86400;
+    days--;
+  }
+  hour = (irr::u32)(seconds / 3600);
+  minute = (irr::u32)(seconds / 60 % 60);
+  second = (irr::u32)(seconds % 60);
+
+  days += 719468;
+  const irr::s64 era = (days >= 0 ? days : days - 146096) / 146097;
+  const irr::s64 dayOfEra = days - era * 146097;
+  const irr::s64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+                              dayOfEra / 146096) / 365;
+  const irr::s64 dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const irr::s64 monthFromMarch = (5 * dayOfYear + 2) / 153;
+  day = (irr::u32)(dayOfYear - (153 * monthFromMarch + 2) / 5 + 1);
+  month = (irr::u32)(monthFromMarch < 10 ? monthFromMarch + 3
+                                         : monthFromMarch - 9);
+  year = (irr::u32)(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+bool encodeNMEASentence(NMEASentence& sentence, const NMEAFormat& format,
+                        const NMEAValues& values) {
+  sentence.begin(format.start, format.address);
+  for (irr::u32 i = 0; i < format.fieldCount; i++) {
+    const NMEAField& field = format.fields[i];
+    switch (field.type) {
+      case NMEA_FIELD_TEXT:
+        sentence.addText(field.text);
+        break;
+      case NMEA_FIELD_EMPTY:
+        sentence.addEmpty();
+        break;
+      case NMEA_FIELD_INT:
+        sentence.addInt((irr::s32)values.values[field.value], field.width,
+                        field.text);
+        break;
+      case NMEA_FIELD_FIXED:
+        sentence.addFixed(values.values[field.value], field.decimals,
+                          field.width);
+        break;
+      case NMEA_FIELD_POSITION:
+        sentence.addLatitude(values.latitude);
+        sentence.addLongitude(values.longitude);
+        break;
+      case NMEA_FIELD_TIME:
+        sentence.addTime(values.hour, values.minute, values.second);
+        break;
+      case NMEA_FIELD_DATE:
+        sentence.addDate(values.day, values.month, values.year);
+        break;
+      case NMEA_FIELD_DAY:
+        sentence.addInt(values.day, 2);
+        break;
+      case NMEA_FIELD_MONTH:
+        sentence.addInt(values.month, 2);
+        break;
+      case NMEA_FIELD_YEAR:
+        sentence.addInt(values.year, 4);
+        break;
+      case NMEA_FIELD_PAYLOAD:
+        sentence.addText(values.payload ? values.payload : "");
+        break;
+    }
+  }
+  return sentence.finish();
+}
+
+bool encodeAIVDM(NMEASentence& sentence, irr::s32 fragments,
+                 irr::s32 fragmentNumber, char radioChannel,
+                 const char* payload, irr::s32 fillBits) {
+  // 8.3.90 AIS VHF data-link message
+  sentence.begin('!', "AIVDM");
+  sentence.addInt(fragments);
+  sentence.addInt(fragmentNumber);
+  sentence.addEmpty();  // Sequential message identifier
+  sentence.addChar(radioChannel);
+  sentence.addText(payload);
+  sentence.addInt(fillBits);
+  return sentence.finish();
+}
+
+NMEAReceivedSentence::NMEAReceivedSentence() {
+  start = 0;
+  proprietary = false;
+  formatter = NMEA_UNKNOWN;
+  fieldCount = 0;
+}
+
+bool NMEAReceivedSentence::parse(const char* text, irr::u32 length) {
+  start = 0;
+  proprietary = false;
+  formatter = NMEA_UNKNOWN;
+  fieldCount = 0;
+
+  while (length > 0 && (text[length - 1] == '\r' || text[length - 1] == '\n'))
+    length--;
+  // Far longer than any sentence, and field lengths fit a u8 below it
+  if (length < 5 || length > 255) return false;
+  if (text[0] != '$' && text[0] != '!') return false;
+
+  // Checksum, which is required
+  if (text[length - 3] != '*') return false;
+  int high = hexValue(text[length - 2]);
+  int low = hexValue(text[length - 1]);
+  if (high < 0 || low < 0) return false;
+  const irr::u32 end = length - 3;
+  irr::u8 checksum = 0;
+  for (irr::u32 i = 1; i < end; i++) {
+    const char c = text[i];
+    if (c < 0x20 || c > 0x7E || c == '*' || c == '$' || c == '!') return false;
+    checksum ^= (irr::u8)c;
+  }
+  if (checksum != (irr::u8)(high * 16 + low)) return false;
+
+  // Address, then the fields
+  irr::u32 i = 1;
+  while (i < end && text[i] != ',') i++;
+  const irr::u32 addressLength = i - 1;
+  if (addressLength < 1) return false;
+  proprietary = text[1] == 'P';
+  if (!proprietary) {
+    if (addressLength != 5) return false;
+    formatter = lookupNMEAFormatter(text + 3);
+  }
+
+  while (i < end) {
+    if (fieldCount == MAX_FIELDS) return false;
+    const irr::u32 fieldBegin = ++i;  // Past the comma
+    while (i < end && text[i] != ',') i++;
+    fieldStart[fieldCount] = text + fieldBegin;
+    fieldLength[fieldCount] = (irr::u8)(i - fieldBegin);
+    fieldCount++;
+  }
+
+  start = text[0];
+  return true;
+}
+
+bool NMEAReceivedSentence::decode(const char* layout, void* const* targets,
+                                  irr::u32 textCapacity) const {
+  for (irr::u32 i = 0; layout[i]; i++) {
+    if (i >= fieldCount) return false;
+    const char* field = fieldStart[i];
+    const irr::u32 length = fieldLength[i];
+    switch (layout[i]) {
+      case 'c':
+        *(char*)targets[i] = length ? field[0] : '\0';
+        break;
+      case 'f':
+        if (!parseNMEADecimal(field, field + length, *(irr::f32*)targets[i]))
+          return false;
+        break;
+      case 't':
+        if (length >= textCapacity) return false;
+        memcpy(targets[i], field, length);
+        ((char*)targets[i])[length] = '\0';
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool parseNMEADecimal(const char* begin, const char* end, irr::f32& value) {
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+
+  // Up to 15 significant digits are exact in an f64, far beyond an f32
+  irr::u64 mantissa = 0;
+  irr::u32 significant = 0;
+  irr::s32 exponent = 0;
+  bool digits = false;
+  for (; p < end && *p >= '0' && *p <= '9'; p++) {
+    digits = true;
+    if (significant < 15) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa) significant++;
+    } else {
+      exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+      digits = true;
+      if (significant < 15) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa) significant++;
+        exponent--;
+      }
+    }
+  }
+  if (!digits || p != end) return false;
+
+  irr::f64 result = (irr::f64)mantissa;
+  // Zeros after the point count down the exponent past the table
+  for (; exponent < -18; exponent += 18) result /= POWERS_OF_TEN[18];
+  if (exponent < 0) {
+    result /= POWERS_OF_TEN[-exponent];
+  } else if (exponent > 0) {
+    if (exponent > 18) return false;
+    result *= POWERS_OF_TEN[exponent];
+  }
+  if (result > 3.4028234663852886e38) return false;  // Beyond an f32
+  value = (irr::f32)(negative ? -result : result);
+  return true;
+}
@@ -0,0 +1,178 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2015 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __NMEACODEC_HPP_INCLUDED__
+#define __NMEACODEC_HPP_INCLUDED__
+
+#include "irrTypes.h"
+
+// Writing and reading of NMEA 0183 (EN 61162-1) sentences in fixed size
+// buffers, so that neither allocates.
+
+// The sentence formatters BC sends or understands
+enum NMEAFormatter {
+  NMEA_UNKNOWN = 0,
+  NMEA_APB,
+  NMEA_DPT,
+  NMEA_DTM,
+  NMEA_GGA,
+  NMEA_GLL,
+  NMEA_HDT,
+  NMEA_RMB,
+  NMEA_RMC,
+  NMEA_ROT,
+  NMEA_RPM,
+  NMEA_RSA,
+  NMEA_TTM,
+  NMEA_VDM,
+  NMEA_ZDA
+};
+
+// Formatter of a three letter sentence id, NMEA_UNKNOWN if not one of the above
+NMEAFormatter lookupNMEAFormatter(const char* id);
+
+// A sentence being written. Fields are appended one by one, and the checksum is
+// kept up to date as characters are added.
+class NMEASentence {
+ public:
+  // Longest sentence, from the start character to <CR><LF>
+  static const irr::u32 MAX_LENGTH = 82;
+
+  NMEASentence();
+  void begin(char start, const char* address);  // eg '$', "GPRMC"
+  void addEmpty();
+  void addText(const char* text);
+  void addChar(char c);
+  // Zero padded to width, as printf's %0*d. The prefix goes before the number.
+  void addInt(irr::s32 value, irr::u32 width = 0, const char* prefix = 0);
+  // As printf's %0*.*f, digit for digit
+  void addFixed(irr::f64 value, irr::u32 decimals, irr::u32 width = 0);
+  void addLatitude(irr::f32 latitude);    // ddmm.mmm,N
+  void addLongitude(irr::f32 longitude);  // dddmm.mmm,E
+  void addTime(irr::u32 hour, irr::u32 minute, irr::u32 second);  // hhmmss.00
+  void addDate(irr::u32 day, irr::u32 month, irr::u32 year);      // ddmmyy
+  // Adds *hh<CR><LF>. False if the sentence was too long, and is unusable.
+  bool finish();
+
+  const char* c_str() const { return buffer; }
+  irr::u32 length() const { return size; }
+
+ private:
+  void put(char c);
+  void putText(const char* text);
+  void putUnsigned(irr::u64 value, irr::u32 width);
+  void putFixed(irr::f64 value, irr::u32 decimals, irr::u32 width);
+  void putPosition(irr::f32 angle, irr::u32 degreeDigits);
+
+  char buffer[MAX_LENGTH + 1];
+  irr::u32 size;
+  irr::u8 checksum;
+  bool overflow;
+};
+
+// Table driven sentences: each field of a format names how its value is
+// written, and where in NMEAValues it comes from.
+enum NMEAFieldType {
+  NMEA_FIELD_TEXT,      // The field's text
+  NMEA_FIELD_EMPTY,
+  NMEA_FIELD_INT,       // values[value], width, after the field's text if any
+  NMEA_FIELD_FIXED,     // values[value], decimals, width
+  NMEA_FIELD_POSITION,  // Latitude and longitude, four fields
+  NMEA_FIELD_TIME,
+  NMEA_FIELD_DATE,      // ddmmyy
+  NMEA_FIELD_DAY,
+  NMEA_FIELD_MONTH,
+  NMEA_FIELD_YEAR,
+  NMEA_FIELD_PAYLOAD    // NMEAValues::payload
+};
+
+struct NMEAField {
+  NMEAFieldType type;
+  irr::u8 value;
+  irr::u8 decimals;
+  irr::u8 width;
+  const char* text;
+};
+
+struct NMEAFormat {
+  char start;
+  const char* address;
+  const NMEAField* fields;
+  irr::u32 fieldCount;
+};
+
+struct NMEAValues {
+  static const irr::u32 MAX_VALUES = 16;
+
+  void setTimestamp(irr::s64 timestamp);  // Unix time in s, as UTC
+
+  irr::f64 values[MAX_VALUES];  // Indexed as the caller's formats choose
+  irr::f32 latitude;
+  irr::f32 longitude;
+  irr::u32 year;
+  irr::u32 month;
+  irr::u32 day;
+  irr::u32 hour;
+  irr::u32 minute;
+  irr::u32 second;
+  const char* payload;
+};
+
+// Writes a whole sentence. False if it didn't fit.
+bool encodeNMEASentence(NMEASentence& sentence, const NMEAFormat& format,
+                        const NMEAValues& values);
+
+// !AIVDM sentence for an AIS payload
+bool encodeAIVDM(NMEASentence& sentence, irr::s32 fragments,
+                 irr::s32 fragmentNumber, char radioChannel,
+                 const char* payload, irr::s32 fillBits);
+
+// A received sentence, checked and split into fields where it lies. The text
+// must outlive the fields.
+class NMEAReceivedSentence {
+ public:
+  static const irr::u32 MAX_FIELDS = 40;
+
+  NMEAReceivedSentence();
+  // Checks the start character, address and checksum, then finds the fields.
+  // The text is one sentence, with or without <CR><LF>. False if malformed.
+  bool parse(const char* text, irr::u32 length);
+
+  char getStart() const { return start; }  // '$' or '!'
+  bool isProprietary() const { return proprietary; }
+  NMEAFormatter getFormatter() const { return formatter; }
+  irr::u32 getFieldCount() const { return fieldCount; }
+
+  // Table driven decoding of the first fields into targets, one per layout
+  // character: 'c' a char ('\0' if empty), 'f' an f32 (field required), 't'
+  // text into a char[textCapacity]. False if a field is missing or invalid.
+  bool decode(const char* layout, void* const* targets,
+              irr::u32 textCapacity) const;
+
+ private:
+  char start;
+  bool proprietary;
+  NMEAFormatter formatter;
+  const char* fieldStart[MAX_FIELDS];
+  irr::u8 fieldLength[MAX_FIELDS];
+  irr::u32 fieldCount;
+};
+
+// Reads a plain decimal ([+-]digits[.digits]), as NMEA writes numbers. The
+// whole of [begin, end) has to be the number.
+bool parseNMEADecimal(const char* begin, const char* end, irr::f32& value);
+
+#endif  // __NMEACODEC_HPP_INCLUDED__
@@ -18,51 +18,50 @@
 #define __NMEASENTENCES_HPP_INCLUDED__
 
 #include "irrTypes.h"
-#include <stdexcept>
-#include <string>
-#include <sys/types.h>
+#include "NMEACodec.hpp"
+#include <cstring>
 
 const irr::f32 INVALID_LAT = 9999.99;
 const irr::f32 INVALID_LONG = 9999.99;
 
+// Text fields are kept in place, as no field can be longer than a sentence
+const irr::u32 NMEA_TEXT_LENGTH = 80;
 
-inline irr::f32 parseNmeaLat(std::string latitude, char direction)
+
+inline irr::f32 parseNmeaLat(const char* latitude, char direction)
 {
     // hhmm.mm [N/S] to [+/-]x.xxxxx
-    if (latitude.length() != 7 || (direction != 'N' && direction != 'S')) return INVALID_LAT;
+    if (strlen(latitude) != 7 || (direction != 'N' && direction != 'S')) return INVALID_LAT;
 
     irr::s32 mod = 1;
     if (direction == 'S') mod = -1;
 
-    try 
-    {
-        irr::f32 hours = std::stof(latitude.substr(0, 2));
-        irr::f32 minutes = std::stof(latitude.substr(2, 5));
-        return mod * (hours + (minutes / 60.0));
-    } catch (const std::invalid_argument& e) 
+    irr::f32 hours;
+    irr::f32 minutes;
+    if (!parseNMEADecimal(latitude, latitude + 2, hours) ||
+        !parseNMEADecimal(latitude + 2, latitude + 7, minutes))
     {
         return INVALID_LAT;
     }
-
+    return mod * (hours + (minutes / 60.0));
 }
 
-inline irr::f32 parseNmeaLong(std::string longitude, char direction)
+inline irr::f32 parseNmeaLong(const char* longitude, char direction)
 {
     // hhhmm.mm [N/S] to [+/-]x.xxxxx
-    if (longitude.length() != 8 || (direction != 'W' && direction != 'E')) return INVALID_LONG;
+    if (strlen(longitude) != 8 || (direction != 'W' && direction != 'E')) return INVALID_LONG;
 
     irr::s32 mod = 1;
     if (direction == 'W') mod = -1;
 
-    try 
+    irr::f32 hours;
+    irr::f32 minutes;
+    if (!parseNMEADecimal(longitude, longitude + 3, hours) ||
+        !parseNMEADecimal(longitude + 3, longitude + 8, minutes))
     {
-        irr::f32 hours = std::stof(longitude.substr(0, 3));
-        irr::f32 minutes = std::stof(longitude.substr(3, 5));
-        return mod * (hours + (minutes / 60.0));
-    } catch (const std::invalid_argument& e)
-    {
-        return INVALID_LAT;
+        return INVALID_LONG;
     }
+    return mod * (hours + (minutes / 60.0));
 }
 
 struct APB
@@ -76,7 +75,7 @@ struct APB
     char perpendicular_passed; // perpendicular passed at waypoint, A-> true, V -> false
     irr::f32 bearing_orig_to_dest;
     char bearing_orig_to_dest_type; // M -> magnetic, T -> true
-    std::string dest_waypoint_id;
+    char dest_waypoint_id[NMEA_TEXT_LENGTH];
     irr::f32 bearing_to_dest; // bearing of current pos to dest
     char bearing_to_dest_type;
     irr::f32 heading_to_dest; // heading to steer to 
@@ -88,11 +87,11 @@ struct RMB
     char status;
     irr::f32 cross_track_error;
     char direction;
-    std::string dest_waypoint_id;
-    std::string orig_waypoint_id;
-    std::string dest_waypoint_latitude; // original hhmm.mm format
+    char dest_waypoint_id[NMEA_TEXT_LENGTH];
+    char orig_waypoint_id[NMEA_TEXT_LENGTH];
+    char dest_waypoint_latitude[NMEA_TEXT_LENGTH]; // original hhmm.mm format
     char dest_waypoint_latitude_dir; // N or S
-    std::string dest_waypoint_longitude; // original hhhmm.mm format
+    char dest_waypoint_longitude[NMEA_TEXT_LENGTH]; // original hhhmm.mm format
     char dest_waypoint_longitude_dir; // W or E
     irr::f32 range_to_dest; // in NM
     irr::f32 bearing_to_dest; // degrees true
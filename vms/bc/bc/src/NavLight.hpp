@@ -21,27 +21,24 @@
 
 #include "irrlicht.h"
 
+class NavLightManager;
+
+//A light drawn by the NavLightManager of the scene, which also works out when it is seen
 class NavLight {
 
     public:
         NavLight(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr, irr::core::vector3df position, irr::video::SColor colour, irr::f32 lightStartAngle, irr::f32 lightEndAngle, irr::f32 lightRange, std::string lightSequence="", irr::u32 phaseStart=0);
         ~NavLight();
-        void update(irr::f32 scenarioTime, irr::u32 lightLevel);
         irr::core::vector3df getPosition() const;
         void setPosition(irr::core::vector3df position);
-        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+        bool isVisible() const; //As of the last NavLightManager::update()
 
     private:
-        irr::scene::ISceneManager* smgr;
-        irr::scene::IMeshSceneNode* lightNode;
-		irr::video::ITexture* lightTexture;
-        irr::f32 startAngle;
-        irr::f32 endAngle;
-        irr::f32 range;
-        std::string sequence;
-        irr::f32 charTime; //Time in seconds per character in sequence
-        irr::f32 timeOffset;
-        irr::u16 currentAlpha; //Note that this is u16 not u8 so we can indicate an initial implausible value.
+        NavLight(const NavLight&);
+        NavLight& operator=(const NavLight&);
+
+        NavLightManager* manager;
+        irr::u32 lightId;
         //bool setAlpha(irr::u8 alpha, irr::video::ITexture* tex);
         //irr::f32 lightLevel;
 };
@@ -0,0 +1,353 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "NavLightManager.hpp"
+#include "Angles.hpp"
+
+#include <cmath> //For fmod()
+
+//using namespace irr;
+
+namespace {
+    const irr::scene::ESCENE_NODE_TYPE NAV_LIGHT_MANAGER_TYPE = (irr::scene::ESCENE_NODE_TYPE)MAKE_IRR_ID('n','a','v','l');
+
+    //Each light is drawn as a fan of triangles around its centre
+    const irr::u32 DISC_POINTS = 8;
+    const irr::u32 LIGHT_VERTICES = DISC_POINTS + 1;
+    const irr::u32 BATCH_LIGHTS = 65536 / LIGHT_VERTICES; //So 16 bit indices are enough
+}
+
+const irr::f32 NavLightManager::CHAR_TIME = 0.25;
+
+NavLightManager* NavLightManager::getManager(irr::scene::ISceneManager* smgr)
+{
+    irr::scene::ISceneNode* root = smgr->getRootSceneNode();
+    const irr::core::list<irr::scene::ISceneNode*>& children = root->getChildren();
+    for (irr::core::list<irr::scene::ISceneNode*>::ConstIterator it = children.begin(); it != children.end(); ++it) {
+        if ((*it)->getType() == NAV_LIGHT_MANAGER_TYPE) {
+            return static_cast<NavLightManager*>(*it);
+        }
+    }
+
+    NavLightManager* manager = new NavLightManager(root, smgr);
+    manager->drop(); //Kept by the root node
+    return manager;
+}
+
+NavLightManager::NavLightManager(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr) : irr::scene::ISceneNode(parent, smgr)
+{
+    sizeScale = 0;
+    alpha = 255;
+    visibleCount = 0;
+
+    material.MaterialType = irr::video::EMT_TRANSPARENT_VERTEX_ALPHA;
+    material.Lighting = false;
+    material.FogEnable = true;
+    material.BackfaceCulling = false;
+
+    //The lights are spread over the whole world, so always render and skip them one by one instead
+    setAutomaticCulling(irr::scene::EAC_OFF);
+}
+
+NavLightManager::~NavLightManager()
+{
+    for (std::vector<irr::scene::ISceneNode*>::iterator it = parents.begin(); it != parents.end(); ++it) {
+        if (*it) {
+            (*it)->drop();
+        }
+    }
+}
+
+irr::u32 NavLightManager::compileSequence(const std::string& sequence)
+{
+    std::map<std::string, irr::u32>::const_iterator it = compiledSequences.find(sequence);
+    if (it != compiledSequences.end()) {
+        return it->second;
+    }
+
+    irr::u32 start = sequenceBits.size() * 32;
+    sequenceBits.resize(sequenceBits.size() + (sequence.length() + 31) / 32, 0);
+    for (std::string::size_type i = 0; i < sequence.length(); i++) {
+        if (sequence[i] != 'D' && sequence[i] != 'd') {
+            sequenceBits[(start + i) / 32] |= 1u << ((start + i) % 32);
+        }
+    }
+    compiledSequences[sequence] = start;
+    return start;
+}
+
+irr::u32 NavLightManager::addLight(irr::scene::ISceneNode* parent, irr::core::vector3df position, irr::video::SColor colour, irr::f32 startAngle, irr::f32 endAngle, irr::f32 range, const std::string& sequence, irr::f32 timeOffset)
+{
+    irr::u32 id;
+    if (freeIds.empty()) {
+        id = parents.size();
+        parents.push_back(0);
+        used.push_back(0);
+        relativePositions.push_back(irr::core::vector3df());
+        colours.push_back(irr::video::SColor());
+        startAngles.push_back(0);
+        endAngles.push_back(0);
+        ranges.push_back(0);
+        timeOffsets.push_back(0);
+        sequenceStarts.push_back(0);
+        sequenceLengths.push_back(0);
+        posX.push_back(0);
+        posY.push_back(0);
+        posZ.push_back(0);
+        parentAngles.push_back(0);
+        distances.push_back(0);
+        visible.push_back(0);
+    } else {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+
+    if (parent) {
+        parent->grab();
+    }
+    parents[id] = parent;
+    used[id] = 1;
+    relativePositions[id] = position;
+    colours[id] = colour;
+
+    //Bring the start angle into 0-360 once here, changing both angles together so their difference is maintained
+    while (startAngle < 0) {
+        startAngle += 360;
+        endAngle += 360;
+    }
+    while (startAngle >= 360) {
+        startAngle -= 360;
+        endAngle -= 360;
+    }
+    startAngles[id] = startAngle;
+    endAngles[id] = endAngle;
+    ranges[id] = range;
+
+    timeOffsets[id] = timeOffset;
+    sequenceStarts[id] = compileSequence(sequence);
+    sequenceLengths[id] = sequence.length();
+    visible[id] = 0;
+
+    return id;
+}
+
+void NavLightManager::removeLight(irr::u32 id)
+{
+    if (id >= used.size() || !used[id]) {
+        return;
+    }
+    if (parents[id]) {
+        parents[id]->drop();
+        parents[id] = 0;
+    }
+    if (visible[id]) {
+        visibleCount--;
+    }
+    used[id] = 0;
+    visible[id] = 0;
+    freeIds.push_back(id);
+}
+
+irr::core::vector3df NavLightManager::getLightPosition(irr::u32 id) const
+{
+    irr::core::vector3df position = relativePositions.at(id);
+    if (parents[id]) {
+        parents[id]->getAbsoluteTransformation().transformVect(position);
+    }
+    return position;
+}
+
+irr::core::vector3df NavLightManager::getLightRelativePosition(irr::u32 id) const
+{
+    return relativePositions.at(id);
+}
+
+void NavLightManager::setLightPosition(irr::u32 id, irr::core::vector3df position)
+{
+    relativePositions.at(id) = position;
+}
+
+void NavLightManager::update(irr::f32 scenarioTime, irr::u32 lightLevel)
+{
+    //Find the active camera
+    irr::scene::ICameraSceneNode* camera = SceneManager->getActiveCamera();
+    if (camera == 0) {
+        return; //If we don't know where the camera is, we can't update lights etc, so give up here.
+    }
+    camera->updateAbsolutePosition();
+    const irr::core::vector3df viewPosition = camera->getAbsolutePosition();
+
+    //find the HFOV
+    irr::f32 hFOV = 2*atan(tan(camera->getFOV()/2)*camera->getAspectRatio()); //Convert from VFOV to hFOV
+    irr::f32 zoom = hFOV / (irr::core::PI/2.0); //Zoom compared to standard 90 degree field of view
+
+    //scale so lights appear same size independent of range
+    sizeScale = 0.5*0.01*zoom;
+
+    //set transparency dependent on light level
+    alpha = 255 - lightLevel;
+
+    //find light positions, as of the last update of their parents
+    const irr::u32 count = parents.size();
+    for (irr::u32 i = 0; i < count; i++) {
+        irr::core::vector3df position = relativePositions[i];
+        irr::f32 parentAngle = 0;
+        if (parents[i]) {
+            parents[i]->getAbsoluteTransformation().transformVect(position);
+            parentAngle = parents[i]->getRotation().Y;
+        }
+        posX[i] = position.X;
+        posY[i] = position.Y;
+        posZ[i] = position.Z;
+        parentAngles[i] = parentAngle;
+    }
+
+    //range to each light
+    for (irr::u32 i = 0; i < count; i++) {
+        irr::f32 deltaX = posX[i] - viewPosition.X;
+        irr::f32 deltaY = posY[i] - viewPosition.Y;
+        irr::f32 deltaZ = posZ[i] - viewPosition.Z;
+        distances[i] = sqrtf(deltaX*deltaX + deltaY*deltaY + deltaZ*deltaZ);
+    }
+
+    //visibility depending on range, angle and light sequence, only working out angle and sequence for lights in range
+    visibleCount = 0;
+    for (irr::u32 i = 0; i < count; i++) {
+        bool lit = used[i] && !(distances[i] > ranges[i]) && (parents[i] == 0 || parents[i]->isTrulyVisible());
+
+        if (lit) {
+            //Angle from the light to the viewpoint, relative to the light's parent coordinate system
+            irr::f32 toViewX = viewPosition.X - posX[i];
+            irr::f32 toViewZ = viewPosition.Z - posZ[i];
+            irr::f32 relativeAngleDeg = atan2((irr::f64)toViewX, (irr::f64)toViewZ) * irr::core::RADTODEG64;
+            if (relativeAngleDeg < 0) {
+                relativeAngleDeg += 360;
+            }
+            if (relativeAngleDeg >= 360) {
+                relativeAngleDeg -= 360;
+            }
+            lit = Angles::isAngleBetween(relativeAngleDeg - parentAngles[i], startAngles[i], endAngles[i]);
+        }
+
+        irr::u32 sequenceLength = sequenceLengths[i];
+        if (lit && sequenceLength > 0) {
+            irr::f32 timeInSequence = std::fmod(((scenarioTime+timeOffsets[i]) / CHAR_TIME),sequenceLength);
+            irr::u32 positionInSequence = timeInSequence;
+            if (positionInSequence>=sequenceLength) {positionInSequence = sequenceLength-1;} //Should not be required, but double check we're not off the end of the sequence
+            irr::u32 bit = sequenceStarts[i] + positionInSequence;
+            lit = (sequenceBits[bit / 32] >> (bit % 32)) & 1;
+        }
+
+        visible[i] = lit;
+        visibleCount += lit;
+    }
+}
+
+bool NavLightManager::isLightVisible(irr::u32 id) const
+{
+    return visible.at(id) != 0;
+}
+
+irr::u32 NavLightManager::getVisibleCount() const
+{
+    return visibleCount;
+}
+
+void NavLightManager::OnRegisterSceneNode()
+{
+    if (IsVisible && visibleCount > 0) {
+        SceneManager->registerNodeForRendering(this, irr::scene::ESNRP_TRANSPARENT);
+    }
+    ISceneNode::OnRegisterSceneNode();
+}
+
+void NavLightManager::render()
+{
+    irr::video::IVideoDriver* driver = SceneManager->getVideoDriver();
+    irr::scene::ICameraSceneNode* camera = SceneManager->getActiveCamera();
+    if (!driver || !camera || visibleCount == 0) {
+        return;
+    }
+
+    //Discs in the plane of the camera's right and up directions
+    const irr::core::matrix4& view = camera->getViewMatrix();
+    irr::core::vector3df right(view[0], view[4], view[8]);
+    irr::core::vector3df up(view[1], view[5], view[9]);
+    right.normalize();
+    up.normalize();
+    irr::core::vector3df normal = right.crossProduct(up);
+
+    irr::core::vector3df rim[DISC_POINTS];
+    for (irr::u32 j = 0; j < DISC_POINTS; j++) {
+        irr::f32 angle = j * 2 * irr::core::PI / DISC_POINTS;
+        rim[j] = right * cos(angle) + up * sin(angle);
+    }
+
+    vertices.resize(visibleCount * LIGHT_VERTICES);
+    irr::u32 vertex = 0;
+    for (irr::u32 i = 0; i < visible.size() && vertex < vertices.size(); i++) {
+        if (!visible[i]) {
+            continue;
+        }
+        irr::core::vector3df centre(posX[i], posY[i], posZ[i]);
+        irr::f32 radius = distances[i] * sizeScale;
+        irr::video::SColor colour = colours[i];
+        colour.setAlpha(alpha);
+
+        vertices[vertex++] = irr::video::S3DVertex(centre, normal, colour, irr::core::vector2df(0.5, 0.5));
+        for (irr::u32 j = 0; j < DISC_POINTS; j++) {
+            vertices[vertex++] = irr::video::S3DVertex(centre + rim[j] * radius, normal, colour, irr::core::vector2df(0.5, 0.5));
+        }
+    }
+
+    //Index pattern is the same for each light, so only extend it when more lights are drawn than before
+    irr::u32 batchLights = irr::core::min_(visibleCount, BATCH_LIGHTS);
+    for (irr::u32 light = indices.size() / (3 * DISC_POINTS); light < batchLights; light++) {
+        irr::u16 centre = light * LIGHT_VERTICES;
+        for (irr::u32 j = 0; j < DISC_POINTS; j++) {
+            indices.push_back(centre);
+            indices.push_back(centre + 1 + j);
+            indices.push_back(centre + 1 + (j + 1) % DISC_POINTS);
+        }
+    }
+
+    driver->setTransform(irr::video::ETS_WORLD, irr::core::IdentityMatrix);
+    driver->setMaterial(material);
+    for (irr::u32 first = 0; first < visibleCount; first += BATCH_LIGHTS) {
+        irr::u32 lights = irr::core::min_(visibleCount - first, BATCH_LIGHTS);
+        driver->drawVertexPrimitiveList(&vertices[first * LIGHT_VERTICES], lights * LIGHT_VERTICES, &indices[0], lights * DISC_POINTS, irr::video::EVT_STANDARD, irr::scene::EPT_TRIANGLES, irr::video::EIT_16BIT);
+    }
+}
+
+const irr::core::aabbox3d<irr::f32>& NavLightManager::getBoundingBox() const
+{
+    return box;
+}
+
+irr::u32 NavLightManager::getMaterialCount() const
+{
+    return 1;
+}
+
+irr::video::SMaterial& NavLightManager::getMaterial(irr::u32)
+{
+    return material;
+}
+
+irr::scene::ESCENE_NODE_TYPE NavLightManager::getType() const
+{
+    return NAV_LIGHT_MANAGER_TYPE;
+}
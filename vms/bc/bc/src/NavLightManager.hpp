@@ -0,0 +1,99 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __NAVLIGHTMANAGER_HPP_INCLUDED__
+#define __NAVLIGHTMANAGER_HPP_INCLUDED__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "irrlicht.h"
+
+//All navigation lights of a scene, in one scene node.
+//The lights are kept as arrays per property rather than a scene node each. update() finds which are seen from the
+//active camera in one pass over those arrays, and render() draws all of them as camera facing discs in one buffer.
+class NavLightManager : public irr::scene::ISceneNode {
+
+    public:
+        //The manager of the scene, added to its root on first use. Grab it to keep it.
+        static NavLightManager* getManager(irr::scene::ISceneManager* smgr);
+
+        //Position is relative to the parent, which may be 0. Returns the id of the light.
+        irr::u32 addLight(irr::scene::ISceneNode* parent, irr::core::vector3df position, irr::video::SColor colour, irr::f32 startAngle, irr::f32 endAngle, irr::f32 range, const std::string& sequence, irr::f32 timeOffset);
+        void removeLight(irr::u32 id);
+        irr::core::vector3df getLightPosition(irr::u32 id) const; //Absolute
+        irr::core::vector3df getLightRelativePosition(irr::u32 id) const;
+        void setLightPosition(irr::u32 id, irr::core::vector3df position); //Relative to the parent
+
+        //Finds the lights seen from the active camera, and their size, at this scenario time
+        void update(irr::f32 scenarioTime, irr::u32 lightLevel);
+        bool isLightVisible(irr::u32 id) const; //As of the last update
+        irr::u32 getVisibleCount() const;
+
+        static const irr::f32 CHAR_TIME; //Time in seconds per character in a sequence
+
+        //Scene node
+        virtual void OnRegisterSceneNode();
+        virtual void render();
+        virtual const irr::core::aabbox3d<irr::f32>& getBoundingBox() const;
+        virtual irr::u32 getMaterialCount() const;
+        virtual irr::video::SMaterial& getMaterial(irr::u32 i);
+        virtual irr::scene::ESCENE_NODE_TYPE getType() const;
+
+    private:
+        NavLightManager(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* smgr);
+        ~NavLightManager();
+
+        irr::u32 compileSequence(const std::string& sequence);
+
+        //Per light, indexed by id. Ids of removed lights are reused.
+        std::vector<irr::scene::ISceneNode*> parents; //Grabbed, 0 if none or removed
+        std::vector<irr::u8> used;
+        std::vector<irr::core::vector3df> relativePositions;
+        std::vector<irr::video::SColor> colours;
+        std::vector<irr::f32> startAngles; //Start in 0-360, end up to 360 above it
+        std::vector<irr::f32> endAngles;
+        std::vector<irr::f32> ranges;
+        std::vector<irr::f32> timeOffsets;
+        std::vector<irr::u32> sequenceStarts; //First bit in sequenceBits
+        std::vector<irr::u32> sequenceLengths; //0 for a steady light
+        std::vector<irr::u32> freeIds;
+
+        //Found by update()
+        std::vector<irr::f32> posX;
+        std::vector<irr::f32> posY;
+        std::vector<irr::f32> posZ;
+        std::vector<irr::f32> parentAngles;
+        std::vector<irr::f32> distances;
+        std::vector<irr::u8> visible;
+        irr::f32 sizeScale; //Radius of a light per metre of distance
+        irr::u8 alpha;
+        irr::u32 visibleCount;
+
+        //Flash sequences, a bit per character, set where the light is lit. Equal sequences share their bits.
+        std::vector<irr::u32> sequenceBits;
+        std::map<std::string, irr::u32> compiledSequences;
+
+        //Render buffers, indices only change with the number of lights drawn
+        std::vector<irr::video::S3DVertex> vertices;
+        std::vector<irr::u16> indices;
+
+        irr::video::SMaterial material;
+        irr::core::aabbox3d<irr::f32> box;
+};
+
+#endif
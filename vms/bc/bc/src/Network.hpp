@@ -34,6 +34,7 @@ class Network
     virtual void connectToServer(std::string hostnames) = 0;
     virtual void setModel(SimulationModel* model) = 0;
     virtual void getScenarioFromNetwork(std::string& dataString) = 0; //Not used by primary
+    virtual void setLegacyScenarioFormat(bool legacy) = 0; //Send the scenario as SCN1 text, for secondaries older than SCN2. Not used by secondary
     virtual void update() = 0;
     virtual int getPort() = 0;
     virtual ~Network();
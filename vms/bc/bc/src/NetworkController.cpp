@@ -17,9 +17,12 @@ NetworkController::NetworkController(SimulationModel* model,
                                      irr::IrrlichtDevice* dev,
                                      std::string snd_address,
                                      std::string snd_port,
-                                     std::string rcv_port) {
+                                     std::string rcv_port,
+                                     std::string transport,
+                                     CoSimChannel* cosim) {
   this->model = model;
   this->device = dev;
+  this->cosim = cosim;
 
   last_send = 0;
   fresh_cmd = false;
@@ -29,6 +32,20 @@ NetworkController::NetworkController(SimulationModel* model,
   receiver_endpoint = *resolver.resolve(query);
   snd_socket = new asio::ip::udp::socket(io_service);
 
+  use_shm = false;
+  if (transport == "shm") {
+    if (sensor_channel.open(SHM_SENSORS_CHANNEL,
+                            ShmChannel<SensorReport>::PRODUCER) ||
+        actuator_channel.open(SHM_ACTUATORS_CHANNEL,
+                              ShmChannel<ActuatorCommands>::CONSUMER)) {
+      std::cerr << "Could not open shared memory channels to the BC proxies, "
+                   "falling back to UDP"
+                << std::endl;
+    } else {
+      use_shm = true;
+    }
+  }
+
   terminate_rcv_thread = false;
   std::thread* receive_thread = 0;
   receive_thread =
@@ -42,6 +59,11 @@ NetworkController::~NetworkController() {
 }
 
 void NetworkController::receive_loop(std::string rcv_port) {
+  if (use_shm) {
+    shm_receive_loop();
+    return;
+  }
+
   asio::io_context io_context;
   asio::ip::udp::socket rcv_socket(io_context);
 
@@ -71,6 +93,7 @@ void NetworkController::receive_loop(std::string rcv_port) {
       boost::archive::text_iarchive archive(archive_stream);
       archive >> actuator_cmd;
       fresh_cmd = true;
+      if (cosim) cosim->count_received(COSIM_ACTUATORS);
 
       // clear buffer
       for (int i = 0; i <= nread; ++i) {
@@ -86,15 +109,30 @@ void NetworkController::receive_loop(std::string rcv_port) {
   }
 }
 
+void NetworkController::shm_receive_loop() {
+  ActuatorCommands commands;
+  for (;;) {
+    terminate_rcv_mutex.lock();
+    if (terminate_rcv_thread) {
+      terminate_rcv_mutex.unlock();
+      break;
+    }
+    terminate_rcv_mutex.unlock();
+
+    // wake up regularly to check for termination
+    if (!actuator_channel.receive(commands, 100)) continue;
+    actuator_cmd_mutex.lock();
+    actuator_cmd = commands;
+    fresh_cmd = true;
+    if (cosim) cosim->count_received(COSIM_ACTUATORS);
+    actuator_cmd_mutex.unlock();
+  }
+}
+
 void NetworkController::update_model() {
   if (!fresh_cmd) return;
   actuator_cmd_mutex.lock();
-  model->setWheel(actuator_cmd.rudder_angle);
-  model->setPortEngine(actuator_cmd.engine_throttle_port);
-  model->setStbdEngine(actuator_cmd.engine_throttle_stbd);
-  model->setBowThruster(actuator_cmd.thruster_throttle_bow);
-  model->setSternThruster(actuator_cmd.thruster_throttle_stern);
-  model->setBallastTankPump(actuator_cmd.ballast_tank_pump);
+  model->applyActuatorCommands(actuator_cmd);
   // clang-format off
   /*
   std::cout << "passing actuator commands to model:" << std::endl;
@@ -153,6 +191,15 @@ void NetworkController::send_report() {
   sensors.ship_depth = ship_depth;
   sensors.buoyancy = buoyancy;
 
+  if (use_shm) {
+    // a full ring means the proxy is not keeping up, drop the report
+    if (sensor_channel.send(sensors) && cosim) {
+      cosim->count_sent(COSIM_SENSORS);
+    }
+    last_send = now;
+    return;
+  }
+
   // serialize
   std::ostringstream archive_stream;
   boost::archive::text_oarchive archive(archive_stream);
@@ -170,6 +217,7 @@ void NetworkController::send_report() {
 
   if (!snd_socket->is_open()) snd_socket->open(asio::ip::udp::v4());
   snd_socket->send_to(asio::buffer(archive_stream.str()), receiver_endpoint);
+  if (cosim) cosim->count_sent(COSIM_SENSORS);
 
   last_send = now;
 }
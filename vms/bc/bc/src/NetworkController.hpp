@@ -5,7 +5,9 @@
 #include <string>
 
 #include "BcProxyMessages.hpp"
+#include "CoSimChannel.h"
 #include "IrrlichtDevice.h"
+#include "ShmChannel.h"
 #include "SimulationModel.hpp"
 #include "libs/asio/include/asio/io_service.hpp"
 #include "libs/asio/include/asio/ip/udp.hpp"
@@ -14,17 +16,26 @@ class NetworkController {
  public:
   NetworkController(SimulationModel* model, irr::IrrlichtDevice* dev,
                     std::string snd_address, std::string snd_port,
-                    std::string rcv_port);
+                    std::string rcv_port, std::string transport,
+                    CoSimChannel* cosim = nullptr);
   ~NetworkController();
   void send_report();
   void update_model();
   void receive_loop(std::string rcv_port);
+  void shm_receive_loop();
 
  private:
   asio::io_service io_service;
   asio::ip::udp::endpoint receiver_endpoint;
   asio::ip::udp::socket* snd_socket;
 
+  // shared memory transport for co-located proxies, UDP otherwise
+  bool use_shm;
+  ShmChannel<SensorReport> sensor_channel;
+  ShmChannel<ActuatorCommands> actuator_channel;
+  // message counters of the lockstep co-simulation, if enabled
+  CoSimChannel* cosim;
+
   irr::IrrlichtDevice* device;
   SimulationModel* model;
   irr::u32 last_send;
@@ -17,6 +17,7 @@
 #include "NetworkPrimary.hpp"
 
 #include "SimulationModel.hpp"
+#include "ScenarioDataStructure.hpp"
 #include "Utilities.hpp"
 #include "Constants.hpp"
 #include "Leg.hpp"
@@ -28,6 +29,7 @@ NetworkPrimary::NetworkPrimary(int port, irr::IrrlichtDevice* dev) //Constructor
 {
 
     model=0; //Not linked at the moment
+    legacyScenarioFormat = false;
     this->port = port;
     device = dev;
 
@@ -144,6 +146,12 @@ void NetworkPrimary::getScenarioFromNetwork(std::string& dataString)
     //Not used by primary
 }
 
+void NetworkPrimary::setLegacyScenarioFormat(bool legacy)
+{
+    legacyScenarioFormat = legacy;
+    legacyScenario.clear();
+}
+
 void NetworkPrimary::setModel(SimulationModel* model) //This MUST be called before update()
 {
     this->model = model;
@@ -380,7 +388,7 @@ void NetworkPrimary::sendNetwork()
     if (stringToSend.length() > 0) {
         /* Create a packet */
         ENetPacket * packet = enet_packet_create (stringToSend.c_str(),
-        strlen (stringToSend.c_str()) + 1,
+        stringToSend.size() + 1, //Scenario data is binary, so may contain zeros
         /*ENET_PACKET_FLAG_RELIABLE*/0);
 
         /* Send the packet to all connected peers over channel id 0. */
@@ -544,6 +552,14 @@ std::string NetworkPrimary::generateSendString()
 
 std::string NetworkPrimary::generateSendStringScn()
 {
+    if (legacyScenarioFormat) {
+        if (legacyScenario.empty()) {
+            ScenarioData scenarioData;
+            scenarioData.deserialiseBinary(model->getSerialisedScenario());
+            legacyScenario = scenarioData.serialise();
+        }
+        return legacyScenario;
+    }
     std::string stringToSend = model->getSerialisedScenario();
     return stringToSend;
 }
@@ -34,6 +34,7 @@ public:
 
     void connectToServer(std::string hostnames);
     void getScenarioFromNetwork(std::string& dataString);
+    void setLegacyScenarioFormat(bool legacy);
     void setModel(SimulationModel* model);
     void update();
     int getPort();
@@ -45,6 +46,9 @@ private:
 
     bool networkRequested;
 
+    bool legacyScenarioFormat; //Send SCN1 text rather than the model's SCN2
+    std::string legacyScenario; //Converted on first use
+
     ENetHost* client; //One client
     ENetEvent event;
 
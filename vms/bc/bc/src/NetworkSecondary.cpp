@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "NetworkSecondary.hpp"
+#include "ScenarioDataStructure.hpp"
 #include "SimulationModel.hpp"
 #include "Utilities.hpp"
 #include "Constants.hpp"
@@ -90,17 +91,16 @@ void NetworkSecondary::getScenarioFromNetwork(std::string& dataString) //Not use
      if (enet_host_service (server, & event, 1000) > 0) { //Wait 1s for event
         if (event.type ==ENET_EVENT_TYPE_RECEIVE) {
 
-            //receive it
-            char tempString[8192]; //Fixme: Think if this is long enough
-            snprintf(tempString,8192,"%s",event.packet -> data);
-            std::string receivedString(tempString);
+            //receive it, binary scenario data may contain zeros, so use the packet length without the terminating zero
+            std::string receivedString;
+            if (event.packet -> dataLength > 0) {
+                receivedString.assign(reinterpret_cast<const char*>(event.packet -> data), event.packet -> dataLength - 1);
+            }
 
             //Basic checks
-            if (receivedString.length() > 4) { //Check if more than 4 chars long, ie we have at least some data
-                if (receivedString.substr(0,4).compare("SCN1") == 0 ) { //Check if it starts with SCN1
-                    //If valid, use this string
-                    dataString = receivedString;
-                }
+            if (ScenarioData::isSerialised(receivedString)) { //Check if it starts with SCN1 or SCN2
+                //If valid, use this string
+                dataString = receivedString;
             }
         }
         /* Clean up the packet now that we're done using it. */
@@ -108,6 +108,11 @@ void NetworkSecondary::getScenarioFromNetwork(std::string& dataString) //Not use
      }
 }
 
+void NetworkSecondary::setLegacyScenarioFormat(bool legacy)
+{
+    //Not used by secondary
+}
+
 void NetworkSecondary::setModel(SimulationModel* model) //This MUST be called before update()
 {
     this->model = model;
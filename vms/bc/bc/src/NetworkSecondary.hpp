@@ -34,6 +34,7 @@ public:
 
     void connectToServer(std::string hostnames);
     void getScenarioFromNetwork(std::string& dataString);
+    void setLegacyScenarioFormat(bool legacy);
     void setModel(SimulationModel* model);
     void update();
     int getPort();
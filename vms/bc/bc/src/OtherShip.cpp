@@ -20,6 +20,7 @@
 #include "RadarData.hpp"
 #include "Constants.hpp"
 #include "OtherShip.hpp"
+#include "ModelRepository.hpp"
 #include "Utilities.hpp"
 
 #include <iostream>
@@ -73,20 +74,22 @@ OtherShip::OtherShip (const std::string& name, const irr::u32& mmsi, const irr::
 
     std::string shipFullPath = basePath + shipFileName;
 
-    //load mesh
-    irr::scene::IAnimatedMesh* shipMesh = smgr->getMesh(shipFullPath.c_str());
+    //load mesh, shared with other ships of the same model
+    ModelRepository* models = ModelRepository::getRepository(smgr);
+    irr::s32 shipModel = models->getModel(shipFullPath);
 
     //Set mesh vertical correction (world units)
     heightCorrection = yCorrection*scaleFactor;
 
     //add to scene node
-	if (shipMesh==0) {
+	if (shipModel<0) {
         //Failed to load mesh - load with dummy and continue
         dev->getLogger()->log("Failed to load other ship model:");
         dev->getLogger()->log(shipFullPath.c_str());
-        shipMesh = smgr->addSphereMesh("Dummy");
+        smgr->addSphereMesh("Dummy");
+        shipModel = models->getModel("Dummy");
     }
-    ship = smgr->addAnimatedMeshSceneNode( shipMesh, 0, -1);
+    ship = models->addInstance(shipModel, 0, -1);
     ship->setScale(irr::core::vector3df(scaleFactor,scaleFactor,scaleFactor));
     ship->setPosition(irr::core::vector3df(0,heightCorrection,0));
 
@@ -106,7 +109,7 @@ OtherShip::OtherShip (const std::string& name, const irr::u32& mmsi, const irr::
 
     //Add triangle selector and make pickable
     ship->setID(IDFlag_IsPickable);
-    selector=smgr->createTriangleSelector(shipMesh,ship);
+    selector=models->createTriangleSelector(shipModel,ship);
     //This is applied depending on distance to own ship, for speed
     triangleSelectorEnabled=false;
     
@@ -170,9 +173,13 @@ OtherShip::~OtherShip()
         delete (*it);
     }
     navLights.clear();
+
+    if (selector) {
+        selector->drop();
+    }
 }
 
-void OtherShip::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel)
+void OtherShip::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight)
 {
 
     //move according to leg information
@@ -204,10 +211,7 @@ void OtherShip::update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideH
     ship->setRotation(irr::core::vector3df(angleCorrectionPitch, hdg+angleCorrection, angleCorrectionRoll)); //Global vectors
     // DEE_DEC22 ^^^^
 
-    //for each light, find range and angle
-    for(std::vector<NavLight*>::size_type currentLight = 0; currentLight<navLights.size(); currentLight++) {
-        navLights[currentLight]->update(scenarioTime, lightLevel);
-    }
+    //The lights are updated with all others by the NavLightManager, following the ship
 
 }
 
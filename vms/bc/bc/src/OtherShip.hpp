@@ -44,7 +44,7 @@ class OtherShip : public Ship
         void deleteLeg(int legNumber, irr::f32 scenarioTime);
         void resetLegs(irr::f32 course, irr::f32 speedKts, irr::f32 distanceNm, irr::f32 scenarioTime);
         RadarData getRadarData(irr::core::vector3df scannerPosition) const;
-        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight, irr::u32 lightLevel);
+        void update(irr::f32 deltaTime, irr::f32 scenarioTime, irr::f32 tideHeight);
         void enableTriangleSelector(bool selectorEnabled);
         void setRateOfTurn(irr::f32 rateOfTurn); // This could be moved to Ship.hpp
 
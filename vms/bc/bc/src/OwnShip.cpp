@@ -23,6 +23,7 @@
 #include "Angles.hpp"
 #include "Constants.hpp"
 #include "IniFile.hpp"
+#include "RayPicker.hpp"
 #include "ScenarioDataStructure.hpp"
 #include "SimulationModel.hpp"
 #include "Terrain.hpp"
@@ -665,8 +666,9 @@ void OwnShip::load(OwnShipData ownShipData,
 
   // Detect sample points for terrain interaction here (think separately about
   // how to do this for 360 models, probably with a separate collision model)
-  // Add a triangle selector
-  irr::scene::ITriangleSelector* selector = smgr->createTriangleSelector(ship);
+  // Add a triangle selector (the own ship node is always an animated mesh node)
+  irr::scene::ITriangleSelector* selector = smgr->createTriangleSelector(
+      static_cast<irr::scene::IAnimatedMeshSceneNode*>(ship));
   if (selector) {
     device->getLogger()->log("Created triangle selector");
     ship->setTriangleSelector(selector);
@@ -698,8 +700,8 @@ void OwnShip::load(OwnShipData ownShipData,
       ray.end = ray.start;
       ray.end.Y = maxY + 0.1;
 
-      // Check the ray and add the contact point if it exists
-      addContactPointFromRay(ray);
+      // Check the ray later, see findContactPoints()
+      contactRays.push_back(ray);
     }
   }
 
@@ -719,12 +721,12 @@ void OwnShip::load(OwnShipData ownShipData,
       ray.end = ray.start;
       ray.end.Z = minZ - 0.1;
 
-      // Check the ray and add the contact point if it exists
-      addContactPointFromRay(ray);
+      // Check the ray later, see findContactPoints()
+      contactRays.push_back(ray);
       // swap ray direction and check again
       ray.start.Z = minZ - 0.1;
       ray.end.Z = maxZ + 0.1;
-      addContactPointFromRay(ray);
+      contactRays.push_back(ray);
     }
   }
 
@@ -744,20 +746,24 @@ void OwnShip::load(OwnShipData ownShipData,
       ray.end = ray.start;
       ray.end.X = minX - 0.1;
 
-      // Check the ray and add the contact point if it exists
-      addContactPointFromRay(ray);
+      // Check the ray later, see findContactPoints()
+      contactRays.push_back(ray);
       // swap ray direction and check again
       ray.start.X = minX - 0.1;
       ray.end.X = maxX + 0.1;
-      addContactPointFromRay(ray);
+      contactRays.push_back(ray);
     }
   }
 
+  // The rays are cast against a snapshot of the scene as it is now, which
+  // keeps the selector, so the scene can move on while they are
+  contactPicker = new RayPicker(smgr->getRootSceneNode(), IDFlag_IsPickable);
+  contactRayPoints.resize(contactRays.size());
+  contactRayHits.assign(contactRays.size(), 0);
+
   // We don't want to do further triangle selection with the ship, so set the
   // selector to null
   ship->setTriangleSelector(0);
-  device->getLogger()->log("Own ship points found: ");
-  device->getLogger()->log(irr::core::stringw(contactPoints.size()).c_str());
 
   // our custom "submarine" specs
   ballastTankVolume =
@@ -773,6 +779,7 @@ void OwnShip::load(OwnShipData ownShipData,
   yVelocity = 0.0;
   buoyancy = -1.0;
   is_submerged = false;
+  shipDepth = 0.0;  // only moved by the submarine dynamics
 
   irr::f32 uw_axial_drag_mod =
       IniFile::iniFileTof32(shipIniFilename, "UnderWaterAxialDragModifier");
@@ -795,22 +802,44 @@ void OwnShip::load(OwnShipData ownShipData,
   underWaterDynamicsLateralDragB = dynamicsLateralDragB * uw_lateral_drag_mod;
 }
 
-void OwnShip::addContactPointFromRay(irr::core::line3d<irr::f32> ray) {
+irr::u32 OwnShip::getContactRayCount() const { return contactRays.size(); }
+
+void OwnShip::findContactPoints(irr::u32 firstRay, irr::u32 endRay) {
+  endRay = std::min(endRay, (irr::u32)contactRays.size());
+  for (irr::u32 i = firstRay; i < endRay; i++) {
+    // Check the ray and keep the contact point if it exists
+    contactRayHits.at(i) =
+        findContactPointFromRay(contactRays.at(i), contactRayPoints.at(i));
+  }
+}
+
+void OwnShip::addContactPoints() {
+  for (irr::u32 i = 0; i < contactRays.size(); i++) {
+    if (contactRayHits.at(i)) {
+      contactPoints.push_back(contactRayPoints.at(i));  // Store
+    }
+  }
+  contactRays.clear();
+  contactRayPoints.clear();
+  contactRayHits.clear();
+  delete contactPicker;
+  contactPicker = 0;
+
+  device->getLogger()->log("Own ship points found: ");
+  device->getLogger()->log(irr::core::stringw(contactPoints.size()).c_str());
+}
+
+bool OwnShip::findContactPointFromRay(irr::core::line3d<irr::f32> ray,
+                                      ContactPoint& contactPoint) const {
   irr::core::vector3df intersection;
   irr::core::triangle3df hitTriangle;
 
-  irr::scene::ISceneNode* selectedSceneNode =
-      device->getSceneManager()
-          ->getSceneCollisionManager()
-          ->getSceneNodeAndCollisionPointFromRay(
-              ray,
-              intersection,  // This will be the position of the collision
-              hitTriangle,   // This will be the triangle hit in the collision
-              IDFlag_IsPickable,  // (bitmask)
-              0);                 // Check all nodes
-
-  if (selectedSceneNode) {
-    ContactPoint contactPoint;
+  bool hit = contactPicker->pick(
+      ray,
+      intersection,  // This will be the position of the collision
+      hitTriangle);  // This will be the triangle hit in the collision
+
+  if (hit) {
     contactPoint.position = intersection;
     contactPoint.normal = hitTriangle.getNormal().normalize();
     contactPoint.position.Y -= heightCorrection;  // Adjust for height
@@ -821,17 +850,12 @@ void OwnShip::addContactPointFromRay(irr::core::line3d<irr::f32> ray) {
     ray.start = contactPoint.position;
     ray.end = ray.start - 100 * contactPoint.normal;
     // Check for the internal node
-    selectedSceneNode =
-        device->getSceneManager()
-            ->getSceneCollisionManager()
-            ->getSceneNodeAndCollisionPointFromRay(
-                ray,
-                intersection,  // This will be the position of the collision
-                hitTriangle,   // This will be the triangle hit in the collision
-                IDFlag_IsPickable,  // (bitmask)
-                0);                 // Check all nodes
-
-    if (selectedSceneNode) {
+    hit = contactPicker->pick(
+        ray,
+        intersection,  // This will be the position of the collision
+        hitTriangle);  // This will be the triangle hit in the collision
+
+    if (hit) {
       contactPoint.internalPosition = intersection;
       contactPoint.internalPosition.Y -=
           heightCorrection;  // Adjust for height correction
@@ -841,14 +865,13 @@ void OwnShip::addContactPointFromRay(irr::core::line3d<irr::f32> ray) {
           contactPoint.position.crossProduct(contactPoint.normal);
       contactPoint.torqueEffect = crossProduct.Y;
 
-      // Store the contact point that we have found
-      contactPoints.push_back(contactPoint);  // Store
-
       // Debugging
       // contactDebugPoints.push_back(device->getSceneManager()->addSphereSceneNode(0.1));
       // contactDebugPoints.push_back(device->getSceneManager()->addCubeSceneNode(0.1));
+      return true;
     }
   }
+  return false;
 }
 
 void OwnShip::setRateOfTurn(
@@ -26,6 +26,7 @@
 class SimulationModel;
 class OwnShipData;
 class Terrain;
+class RayPicker;
 
 struct ContactPoint {
   irr::core::vector3df
@@ -211,6 +212,13 @@ class OwnShip : public Ship {
   bool isBuoyCollision() const;
   bool isOtherShipCollision() const;
 
+  // load() only sets up the rays the contact points are found with. They are
+  // cast by findContactPoints(), which can run on a loader thread, in ranges
+  // [firstRay, endRay); addContactPoints() then keeps the hits in ray order.
+  irr::u32 getContactRayCount() const;
+  void findContactPoints(irr::u32 firstRay, irr::u32 endRay);
+  void addContactPoints();
+
  protected:
  private:
   void collisionDetectAndRespond(irr::f32& reaction, irr::f32& lateralReaction,
@@ -218,7 +226,8 @@ class OwnShip : public Ship {
   irr::f32 requiredEngineProportion(irr::f32 speed);
   irr::f32 sign(irr::f32 inValue) const;
   irr::f32 sign(irr::f32 inValue, irr::f32 threshold) const;
-  void addContactPointFromRay(irr::core::line3d<irr::f32> ray);
+  bool findContactPointFromRay(irr::core::line3d<irr::f32> ray,
+                               ContactPoint& contactPoint) const;
 
   irr::IrrlichtDevice* device;
   std::vector<irr::core::vector3df>
@@ -447,6 +456,12 @@ class OwnShip : public Ship {
   bool otherShipCollision;
 
   std::vector<ContactPoint> contactPoints;
+  // Rays for the contact points, cast against the hull as it was at load
+  std::vector<irr::core::line3df> contactRays;
+  RayPicker* contactPicker;
+  std::vector<ContactPoint> contactRayPoints;
+  std::vector<irr::u8> contactRayHits;  // Per ray, bytes so threads can set
+                                        // their own
   // Debugging
   // std::vector<irr::scene::IMeshSceneNode*> contactDebugPoints;
 };
@@ -0,0 +1,160 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#include "RayPicker.hpp"
+
+#include <cfloat>
+#include <cmath>
+
+//using namespace irr;
+
+RayPicker::RayPicker(irr::scene::ISceneNode* root, irr::s32 idBitMask)
+{
+    addNodes(root, idBitMask);
+}
+
+RayPicker::~RayPicker()
+{
+    for (std::vector<PickableNode>::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        it->selector->drop();
+    }
+}
+
+irr::u32 RayPicker::getNodeCount() const
+{
+    return nodes.size();
+}
+
+void RayPicker::addNodes(irr::scene::ISceneNode* root, irr::s32 idBitMask)
+{
+    //Same walk and tests as the collision manager, so the nodes are tested in the same order
+    const irr::scene::ISceneNodeList& children = root->getChildren();
+    for (irr::scene::ISceneNodeList::ConstIterator it = children.begin(); it != children.end(); ++it) {
+        irr::scene::ISceneNode* current = *it;
+        irr::scene::ITriangleSelector* selector = current->getTriangleSelector();
+
+        if (selector && current->isVisible() && (idBitMask == 0 || (current->getID() & idBitMask))) {
+            PickableNode node;
+            //A node scaled to nothing can't be hit, and the collision manager skips its children too
+            if (!current->getAbsoluteTransformation().getInverse(node.inverse)) {
+                continue;
+            }
+            //Multiplied onto the identity, as the selectors do, to get the same bits
+            node.transformation.makeIdentity();
+            node.transformation *= current->getAbsoluteTransformation();
+            node.boundingBox = current->getBoundingBox();
+            node.selector = selector;
+            selector->grab();
+            nodes.push_back(node);
+        }
+
+        addNodes(current, idBitMask);
+    }
+}
+
+bool RayPicker::pick(const irr::core::line3df& ray, irr::core::vector3df& outCollisionPoint, irr::core::triangle3df& outTriangle) const
+{
+    //Test every node whose box the ray passes through, shortening the ray to the nearest hit so far
+    irr::core::line3df rayRest(ray);
+    irr::f32 bestDistanceSquared = FLT_MAX;
+    bool hit = false;
+
+    for (std::vector<PickableNode>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        //Box test in node coordinates
+        irr::core::line3df line(rayRest);
+        it->inverse.transformVect(line.start);
+        it->inverse.transformVect(line.end);
+        if (!it->boundingBox.intersectsWithLine(line)) {
+            continue;
+        }
+
+        irr::core::vector3df intersection;
+        irr::core::triangle3df triangle;
+        if (getCollisionPoint(*it, rayRest, intersection, triangle)) {
+            const irr::f32 distanceSquared = (intersection - rayRest.start).getLengthSQ();
+            if (distanceSquared < bestDistanceSquared) {
+                bestDistanceSquared = distanceSquared;
+                outCollisionPoint = intersection;
+                outTriangle = triangle;
+                hit = true;
+                const irr::core::vector3df rayVector = rayRest.getVector().normalize();
+                rayRest.end = rayRest.start + (rayVector * sqrtf(distanceSquared));
+            }
+        }
+    }
+
+    return hit;
+}
+
+bool RayPicker::getCollisionPoint(const PickableNode& node, const irr::core::line3df& ray, irr::core::vector3df& outCollisionPoint, irr::core::triangle3df& outTriangle) const
+{
+    //Each thread fills its own buffer, in place of the collision manager's member
+    static thread_local std::vector<irr::core::triangle3df> triangles;
+
+    const irr::s32 totalCount = node.selector->getTriangleCount();
+    if (totalCount <= 0) {
+        return false;
+    }
+    if (triangles.size() < (irr::u32)totalCount) {
+        triangles.resize(totalCount);
+    }
+
+    //Triangles near the ray, found in node coordinates and moved by the snapshot transformation rather than the node's
+    irr::core::aabbox3df box(ray.start);
+    box.addInternalPoint(ray.end);
+    node.inverse.transformBoxEx(box);
+    irr::s32 count = 0;
+    node.selector->getTriangles(&triangles[0], totalCount, count, box, &node.transformation, false, 0);
+
+    const irr::core::vector3df lineVector = ray.getVector().normalize();
+    const irr::f32 rayLength = ray.getLengthSQ();
+    const irr::f32 minX = irr::core::min_(ray.start.X, ray.end.X);
+    const irr::f32 maxX = irr::core::max_(ray.start.X, ray.end.X);
+    const irr::f32 minY = irr::core::min_(ray.start.Y, ray.end.Y);
+    const irr::f32 maxY = irr::core::max_(ray.start.Y, ray.end.Y);
+    const irr::f32 minZ = irr::core::min_(ray.start.Z, ray.end.Z);
+    const irr::f32 maxZ = irr::core::max_(ray.start.Z, ray.end.Z);
+
+    irr::f32 nearest = FLT_MAX;
+    bool hit = false;
+    irr::core::vector3df intersection;
+
+    for (irr::s32 i = 0; i < count; i++) {
+        const irr::core::triangle3df& triangle = triangles[i];
+
+        if (minX > triangle.pointA.X && minX > triangle.pointB.X && minX > triangle.pointC.X) continue;
+        if (maxX < triangle.pointA.X && maxX < triangle.pointB.X && maxX < triangle.pointC.X) continue;
+        if (minY > triangle.pointA.Y && minY > triangle.pointB.Y && minY > triangle.pointC.Y) continue;
+        if (maxY < triangle.pointA.Y && maxY < triangle.pointB.Y && maxY < triangle.pointC.Y) continue;
+        if (minZ > triangle.pointA.Z && minZ > triangle.pointB.Z && minZ > triangle.pointC.Z) continue;
+        if (maxZ < triangle.pointA.Z && maxZ < triangle.pointB.Z && maxZ < triangle.pointC.Z) continue;
+
+        if (triangle.getIntersectionWithLine(ray.start, lineVector, intersection)) {
+            const irr::f32 distanceToStart = intersection.getDistanceFromSQ(ray.start);
+            const irr::f32 distanceToEnd = intersection.getDistanceFromSQ(ray.end);
+
+            if (distanceToStart < rayLength && distanceToEnd < rayLength && distanceToStart < nearest) {
+                nearest = distanceToStart;
+                outTriangle = triangle;
+                outCollisionPoint = intersection;
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
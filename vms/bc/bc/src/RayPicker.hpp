@@ -0,0 +1,59 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef __RAYPICKER_HPP_INCLUDED__
+#define __RAYPICKER_HPP_INCLUDED__
+
+#include <vector>
+
+#include "irrlicht.h"
+
+//Finds where a ray first hits the pickable nodes, as ISceneCollisionManager::getSceneNodeAndCollisionPointFromRay does,
+//but from a snapshot of the nodes taken when the picker is made. The collision manager fills a triangle buffer it
+//keeps as a member, so only one pick can run at a time; a picker only reads its snapshot, so loader threads can cast
+//rays while the main thread goes on building the scene. Nodes added or unpicked after the snapshot are not seen.
+//The selectors are grabbed and used directly, so their triangles must not change while the picker is in use.
+class RayPicker
+{
+    public:
+        //Snapshot of the nodes under root that the collision manager would test with this id bitmask
+        RayPicker(irr::scene::ISceneNode* root, irr::s32 idBitMask);
+        ~RayPicker();
+
+        //Nearest hit along the ray, returns false if nothing is hit. Can be called from several threads at once.
+        bool pick(const irr::core::line3df& ray, irr::core::vector3df& outCollisionPoint, irr::core::triangle3df& outTriangle) const;
+
+        irr::u32 getNodeCount() const;
+
+    private:
+        RayPicker(const RayPicker&);
+        RayPicker& operator=(const RayPicker&);
+
+        struct PickableNode {
+            irr::scene::ITriangleSelector* selector; //Grabbed
+            irr::core::matrix4 transformation; //Absolute, as the selector applies it
+            irr::core::matrix4 inverse;
+            irr::core::aabbox3df boundingBox; //In node coordinates
+        };
+
+        void addNodes(irr::scene::ISceneNode* root, irr::s32 idBitMask);
+        bool getCollisionPoint(const PickableNode& node, const irr::core::line3df& ray, irr::core::vector3df& outCollisionPoint, irr::core::triangle3df& outTriangle) const;
+
+        std::vector<PickableNode> nodes;
+};
+
+#endif
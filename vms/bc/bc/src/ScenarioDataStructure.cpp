@@ -17,8 +17,163 @@
 #include "ScenarioDataStructure.hpp"
 #include "Utilities.hpp"
 
+#include <cstdint>
+#include <cstring>
 #include <iostream> //Debuggung
 
+//Binary format (SCN2):
+//"SCN2", then sections of a tag byte, a varint payload length and the payload.
+//Unsigned integers are LEB128 varints, floats are little endian IEEE 754 and strings are a varint length and the bytes.
+//Readers skip sections they don't know and bytes after the fields they know, so fields can be added at the end of a section.
+
+namespace {
+
+    const char BINARY_MAGIC[] = "SCN2";
+    const char TEXT_MAGIC[] = "SCN1";
+    const size_t MAGIC_LENGTH = 4;
+
+    enum SectionTag {
+        SECTION_SCENARIO = 1,
+        SECTION_OWN_SHIP = 2,
+        SECTION_OTHER_SHIPS = 3
+    };
+
+    //Smallest encoded other ship and leg, bounds counts read from the data
+    const size_t MIN_SHIP_BYTES = 1 + 1 + 4 + 4 + 1;
+    const size_t MIN_LEG_BYTES = 3 * 4;
+
+    void putVarint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void putFloat(std::string& out, irr::f32 value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; i++) {
+            out.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+        }
+    }
+
+    void putString(std::string& out, const std::string& value)
+    {
+        putVarint(out, value.size());
+        out.append(value);
+    }
+
+    void putSection(std::string& out, SectionTag tag, const std::string& payload)
+    {
+        out.push_back(static_cast<char>(tag));
+        putVarint(out, payload.size());
+        out.append(payload);
+    }
+
+    //Cursor over a byte range, any read past the end or out of range value makes it fail and all later reads return zero
+    class BinaryReader {
+        public:
+        BinaryReader(const char* begin, const char* end):pos(begin),end(end),failed(false){}
+
+        bool ok() const {return !failed;}
+        size_t remaining() const {return end - pos;}
+
+        uint64_t varint()
+        {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) {
+                    break;
+                }
+                uint8_t byte = static_cast<uint8_t>(*pos++);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            failed = true;
+            return 0;
+        }
+
+        irr::u32 u32()
+        {
+            uint64_t value = varint();
+            if (value > 0xffffffffu) {
+                failed = true;
+                return 0;
+            }
+            return static_cast<irr::u32>(value);
+        }
+
+        irr::f32 f32()
+        {
+            if (remaining() < 4) {
+                failed = true;
+                pos = end;
+                return 0;
+            }
+            uint32_t bits = 0;
+            for (int i = 0; i < 4; i++) {
+                bits |= static_cast<uint32_t>(static_cast<uint8_t>(pos[i])) << (8 * i);
+            }
+            pos += 4;
+            irr::f32 value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        std::string string()
+        {
+            uint64_t length = varint();
+            if (failed || length > remaining()) {
+                failed = true;
+                pos = end;
+                return std::string();
+            }
+            std::string value(pos, static_cast<size_t>(length));
+            pos += length;
+            return value;
+        }
+
+        //Reads a count of items, each taking at least minBytes
+        size_t count(size_t minBytes)
+        {
+            uint64_t value = varint();
+            if (value > remaining() / minBytes) {
+                failed = true;
+                return 0;
+            }
+            return static_cast<size_t>(value);
+        }
+
+        //Splits off the next length prefixed section
+        bool section(uint8_t& tag, BinaryReader& payload)
+        {
+            if (pos == end || failed) {
+                return false;
+            }
+            tag = static_cast<uint8_t>(*pos++);
+            uint64_t length = varint();
+            if (failed || length > remaining()) {
+                failed = true;
+                return false;
+            }
+            payload = BinaryReader(pos, pos + length);
+            pos += length;
+            return true;
+        }
+
+        private:
+        const char* pos;
+        const char* end;
+        bool failed;
+    };
+
+}
+
 //Serialisers:
 //Separators (largest first: # , | / ?
 
@@ -68,7 +223,7 @@ void OtherShipData::deserialise(std::string data)
     std::vector<std::string> splitData = Utilities::split(data,'|');
     if (splitData.size() == 5) {
         shipName = splitData.at(0);
-        mmsi = Utilities::lexical_cast<irr::f32>(splitData.at(1));
+        mmsi = Utilities::lexical_cast<irr::u32>(splitData.at(1)); //Not through f32, which rounds nine digit MMSIs
         initialLong = Utilities::lexical_cast<irr::f32>(splitData.at(2));
         initialLat = Utilities::lexical_cast<irr::f32>(splitData.at(3));
         //clear any existing legs data
@@ -146,8 +301,131 @@ std::string ScenarioData::serialise()
     return serialised;
 }
 
+std::string ScenarioData::serialiseBinary() const
+{
+    std::string serialised(BINARY_MAGIC, MAGIC_LENGTH);
+    std::string payload;
+
+    putString(payload, scenarioName);
+    putString(payload, worldName);
+    putFloat(payload, startTime);
+    putVarint(payload, startDay);
+    putVarint(payload, startMonth);
+    putVarint(payload, startYear);
+    putFloat(payload, sunRise);
+    putFloat(payload, sunSet);
+    putFloat(payload, weather);
+    putFloat(payload, rainIntensity);
+    putFloat(payload, visibilityRange);
+    putSection(serialised, SECTION_SCENARIO, payload);
+
+    payload.clear();
+    putString(payload, ownShipData.ownShipName);
+    putFloat(payload, ownShipData.initialSpeed);
+    putFloat(payload, ownShipData.initialLong);
+    putFloat(payload, ownShipData.initialLat);
+    putFloat(payload, ownShipData.initialBearing);
+    putSection(serialised, SECTION_OWN_SHIP, payload);
+
+    payload.clear();
+    putVarint(payload, otherShipsData.size());
+    for (const OtherShipData& ship : otherShipsData) {
+        putString(payload, ship.shipName);
+        putVarint(payload, ship.mmsi);
+        putFloat(payload, ship.initialLong);
+        putFloat(payload, ship.initialLat);
+        putVarint(payload, ship.legs.size());
+        for (const LegData& leg : ship.legs) {
+            putFloat(payload, leg.bearing);
+            putFloat(payload, leg.speed);
+            putFloat(payload, leg.distance);
+        }
+    }
+    putSection(serialised, SECTION_OTHER_SHIPS, payload);
+
+    return serialised;
+}
+
+bool ScenarioData::deserialiseBinary(const std::string& data)
+{
+    if (data.size() < MAGIC_LENGTH || data.compare(0, MAGIC_LENGTH, BINARY_MAGIC) != 0) {
+        return false;
+    }
+
+    //Parse into a copy, so malformed data leaves this scenario as it was
+    ScenarioData parsed;
+    bool hasScenario = false;
+    bool hasOwnShip = false;
+    bool hasOtherShips = false;
+
+    BinaryReader reader(data.data() + MAGIC_LENGTH, data.data() + data.size());
+    uint8_t tag;
+    BinaryReader in(nullptr, nullptr);
+    while (reader.section(tag, in)) {
+        if (tag == SECTION_SCENARIO) {
+            parsed.scenarioName = in.string();
+            parsed.worldName = in.string();
+            parsed.startTime = in.f32();
+            parsed.startDay = in.u32();
+            parsed.startMonth = in.u32();
+            parsed.startYear = in.u32();
+            parsed.sunRise = in.f32();
+            parsed.sunSet = in.f32();
+            parsed.weather = in.f32();
+            parsed.rainIntensity = in.f32();
+            parsed.visibilityRange = in.f32();
+            hasScenario = true;
+        } else if (tag == SECTION_OWN_SHIP) {
+            parsed.ownShipData.ownShipName = in.string();
+            parsed.ownShipData.initialSpeed = in.f32();
+            parsed.ownShipData.initialLong = in.f32();
+            parsed.ownShipData.initialLat = in.f32();
+            parsed.ownShipData.initialBearing = in.f32();
+            hasOwnShip = true;
+        } else if (tag == SECTION_OTHER_SHIPS) {
+            size_t ships = in.count(MIN_SHIP_BYTES);
+            parsed.otherShipsData.resize(ships);
+            for (OtherShipData& ship : parsed.otherShipsData) {
+                ship.shipName = in.string();
+                ship.mmsi = in.u32();
+                ship.initialLong = in.f32();
+                ship.initialLat = in.f32();
+                ship.legs.resize(in.count(MIN_LEG_BYTES));
+                for (LegData& leg : ship.legs) {
+                    leg.bearing = in.f32();
+                    leg.speed = in.f32();
+                    leg.distance = in.f32();
+                }
+            }
+            hasOtherShips = true;
+        } else {
+            continue; //From a later version
+        }
+        if (!in.ok()) {
+            return false;
+        }
+    }
+
+    if (!reader.ok() || !hasScenario || !hasOwnShip || !hasOtherShips) {
+        return false;
+    }
+    *this = parsed;
+    return true;
+}
+
+bool ScenarioData::isSerialised(const std::string& data)
+{
+    return data.size() > MAGIC_LENGTH &&
+           (data.compare(0, MAGIC_LENGTH, BINARY_MAGIC) == 0 ||
+            data.compare(0, MAGIC_LENGTH, TEXT_MAGIC) == 0);
+}
+
 void ScenarioData::deserialise(std::string data)
 {
+    if (data.compare(0, MAGIC_LENGTH, BINARY_MAGIC) == 0) {
+        deserialiseBinary(data);
+        return;
+    }
 
     std::vector<std::string> splitData = Utilities::split(data,'#');
     if (splitData.size() == 14) {
@@ -23,6 +23,8 @@
 
 //These classes are used as structures to hold a scenario definition, and therefore have all members as public.
 //Methods for serialisation and deserialisation are included for utility
+//A whole scenario can be serialised as '#' separated text (SCN1, legacy) or in a compact binary form (SCN2), deserialise accepts both
+//The network sends SCN2, releases before it only read SCN1: set legacy_scenario_format in bc5.ini or mph.ini to send SCN1 to them
 
 class OwnShipData {
     public:
@@ -67,8 +69,12 @@ class ScenarioData {
 
     ScenarioData():startTime(0),sunRise(0),sunSet(0),weather(0),rainIntensity(0),visibilityRange(0),startDay(0),startMonth(0),startYear(0){}
 
-    std::string serialise();
-    void deserialise(std::string data);
+    std::string serialise(); //Legacy text format
+    std::string serialiseBinary() const; //Binary format, used for the network
+    void deserialise(std::string data); //Either format, unchanged if the data is malformed
+    bool deserialiseBinary(const std::string& data); //Returns false and leaves the scenario unchanged if the data is malformed
+
+    static bool isSerialised(const std::string& data); //Checks for the header of either format
 };
 
 #endif
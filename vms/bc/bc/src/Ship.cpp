@@ -36,9 +36,9 @@ Ship::~Ship()
     //dtor
 }
 
-irr::scene::IMeshSceneNode* Ship::getSceneNode() const
+irr::scene::ISceneNode* Ship::getSceneNode() const
 {
-    return (irr::scene::IMeshSceneNode*)ship;
+    return ship;
 }
 
 irr::core::vector3df Ship::getRotation() const
@@ -31,7 +31,7 @@ class Ship
         Ship();
         virtual ~Ship();
 
-        irr::scene::IMeshSceneNode* getSceneNode() const;
+        irr::scene::ISceneNode* getSceneNode() const;
         irr::core::vector3df getRotation() const;
         irr::core::vector3df getPosition() const;
         irr::f32 getLength() const;
@@ -48,7 +48,7 @@ class Ship
 
     protected:
 
-        irr::scene::IAnimatedMeshSceneNode* ship; //The scene node for the own ship.
+        irr::scene::ISceneNode* ship; //The scene node for the ship.
         irr::f32 hdg;
         irr::f32 xPos;
         irr::f32 yPos;
@@ -22,8 +22,11 @@
 
 #include "Buoys.hpp"
 #include "Constants.hpp"
+#include "FlightRecorder.hpp"
 #include "GUIMain.hpp"
 #include "IniFile.hpp"
+#include "LoadPipeline.hpp"
+#include "NavLightManager.hpp"
 #include "ScenarioDataStructure.hpp"
 #include "Sky.hpp"
 #include "Sound.hpp"
@@ -40,18 +43,243 @@
 
 // using namespace irr;
 
+// Loads the world into a SimulationModel as the stages of a LoadPipeline.
+// Reading the files and casting the rays for the own ship contact points and
+// the land object radar heights are decoded on the loader threads, the scene
+// graph is built on the main thread. The stages commit in the order they are
+// added here, which is the order the world was loaded in before.
+class WorldLoader {
+ public:
+  WorldLoader(SimulationModel* model, const ScenarioData& scenarioData,
+              const std::string& worldPath, irr::f32 sunRise, irr::f32 sunSet,
+              irr::f32 lookAngle, irr::f32 cameraMinDistance,
+              irr::f32 cameraMaxDistance, irr::u32 disableShaders,
+              irr::u32 waterSegments,
+              irr::core::vector3di numberOfContactPoints,
+              irr::u32 limitTerrainResolution)
+      : model(model),
+        scenarioData(scenarioData),
+        worldPath(worldPath),
+        sunRise(sunRise),
+        sunSet(sunSet),
+        lookAngle(lookAngle),
+        cameraMinDistance(cameraMinDistance),
+        cameraMaxDistance(cameraMaxDistance),
+        disableShaders(disableShaders),
+        waterSegments(waterSegments),
+        numberOfContactPoints(numberOfContactPoints),
+        limitTerrainResolution(limitTerrainResolution) {}
+
+  void load(irr::u32 loadThreads) {
+    LoadPipeline pipeline(loadThreads, model->device->getLogger());
+    typedef LoadStep<WorldLoader> Step;
+
+    // Terrain needs to be first, so the terrain parameters are available
+    irr::u32 terrain =
+        pipeline.addStage("terrain", new Step(this, &WorldLoader::commitTerrain,
+                                              &WorldLoader::decodeTerrain));
+    pipeline.addStage("sky", new Step(this, &WorldLoader::commitSky));
+    irr::u32 ownShip = pipeline.addStage(
+        "own ship", new Step(this, &WorldLoader::commitOwnShip));
+    irr::u32 water =
+        pipeline.addStage("water", new Step(this, &WorldLoader::commitWater));
+    irr::u32 radar =
+        pipeline.addStage("radar", new Step(this, &WorldLoader::commitRadar));
+    irr::u32 camera =
+        pipeline.addStage("camera", new Step(this, &WorldLoader::commitCamera));
+    irr::u32 light =
+        pipeline.addStage("light", new Step(this, &WorldLoader::commitLight));
+    irr::u32 otherShips = pipeline.addStage(
+        "other ships", new Step(this, &WorldLoader::commitOtherShips));
+    irr::u32 buoys =
+        pipeline.addStage("buoys", new Step(this, &WorldLoader::commitBuoys));
+    irr::u32 landObjects = pipeline.addStage(
+        "land objects", new Step(this, &WorldLoader::commitLandObjects));
+    irr::u32 landLights = pipeline.addStage(
+        "land lights", new Step(this, &WorldLoader::commitLandLights));
+    // Decoding the terrain may change the working directory, so read the tide
+    // files after it
+    irr::u32 tide =
+        pipeline.addStage("tide", new Step(this, 0, &WorldLoader::decodeTide));
+    irr::u32 rain =
+        pipeline.addStage("rain", new Step(this, &WorldLoader::commitRain));
+    // The rays are cast against the scene as it was when the own ship and each
+    // land object were loaded, see RayPicker
+    irr::u32 contactPoints = pipeline.addStage(
+        "own ship contact points",
+        new Step(this, &WorldLoader::commitContactPoints,
+                 &WorldLoader::decodeContactPoints,
+                 &WorldLoader::getContactPointParts));
+    irr::u32 radarTerrain = pipeline.addStage(
+        "land object radar", new Step(this, &WorldLoader::commitRadarTerrain,
+                                      &WorldLoader::decodeRadarTerrain,
+                                      &WorldLoader::getRadarTerrainParts));
+
+    pipeline.addDependency(ownShip, terrain);
+    pipeline.addDependency(water, ownShip);
+    pipeline.addDependency(radar, ownShip);
+    pipeline.addDependency(camera, ownShip);
+    pipeline.addDependency(light, camera);
+    pipeline.addDependency(otherShips, terrain);
+    pipeline.addDependency(buoys, terrain);
+    pipeline.addDependency(landObjects, terrain);
+    pipeline.addDependency(landLights, terrain);
+    pipeline.addDependency(tide, terrain);
+    pipeline.addDependency(rain, camera);
+    pipeline.addDependency(contactPoints, ownShip);
+    pipeline.addDependency(radarTerrain, landObjects);
+
+    pipeline.run();
+  }
+
+ private:
+  // Own ship rays cast by each loader task
+  static const irr::u32 RAYS_PER_PART = 256;
+
+  void decodeTerrain(irr::u32) {
+    model->terrain.decode(worldPath, model->device, limitTerrainResolution);
+  }
+
+  void commitTerrain() { model->terrain.commit(model->smgr); }
+
+  void commitSky() {
+    // sky box/dome
+    Sky sky(model->smgr);
+  }
+
+  void commitOwnShip() {
+    // Load own ship model, its contact points are found later
+    model->ownShip.load(scenarioData.ownShipData, numberOfContactPoints,
+                        model->smgr, model, &model->terrain, model->device);
+    if (model->mode == OperatingMode::Secondary) {
+      model->ownShip.setSpeed(0);  // Don't start moving if in secondary mode
+    }
+  }
+
+  void commitWater() {
+    model->water.load(model->smgr, model->ownShip.getSceneNode(),
+                      model->weather, disableShaders, waterSegments);
+  }
+
+  void commitRadar() {
+    // Load the radar with config parameters
+    model->radarCalculation.load(model->ownShip.getRadarConfigFile(),
+                                 model->device);
+  }
+
+  void commitCamera() {
+    // set camera zoom to 1
+    model->zoom = 1.0;
+
+    // make a camera, setting parent and offset
+    std::vector<irr::core::vector3df> views =
+        model->ownShip.getCameraViews();  // Get the initial camera offset from
+                                          // the own ship model
+    std::vector<bool> isHighView =
+        model->ownShip.getCameraIsHighView();  // Are these special 'looking
+                                               // down' views
+    irr::f32 angleCorrection = model->ownShip.getAngleCorrection();
+    model->camera.load(model->smgr, model->device->getLogger(),
+                       model->ownShip.getSceneNode(), views, isHighView,
+                       irr::core::degToRad(model->viewAngle), lookAngle,
+                       angleCorrection);
+    model->camera.setNearValue(cameraMinDistance);
+    model->camera.setFarValue(cameraMaxDistance);
+  }
+
+  void commitLight() {
+    // make ambient light
+    model->light.load(model->smgr, sunRise, sunSet,
+                      model->camera.getSceneNode());
+  }
+
+  void commitOtherShips() {
+    model->otherShips.load(scenarioData.otherShipsData, model->scenarioTime,
+                           model->mode, model->smgr, model, model->device);
+  }
+
+  void commitBuoys() {
+    model->buoys.load(worldPath, model->smgr, model->terrain.getWorldRoot(),
+                      model, model->device);
+  }
+
+  void commitLandObjects() {
+    // Radar heights of the land objects are found later
+    model->landObjects.load(worldPath, model->smgr, model, &model->terrain,
+                            model->device);
+  }
+
+  void commitLandLights() {
+    model->landLights.load(worldPath, model->smgr, model, model->terrain);
+  }
+
+  void decodeTide(irr::u32) {
+    // Load tidal information
+    model->tide.load(worldPath);
+  }
+
+  void commitRain() {
+    model->rain.load(model->smgr, model->camera.getSceneNode(), model->device);
+  }
+
+  irr::u32 getContactPointParts() {
+    return (model->ownShip.getContactRayCount() + RAYS_PER_PART - 1) /
+           RAYS_PER_PART;
+  }
+
+  void decodeContactPoints(irr::u32 part) {
+    model->ownShip.findContactPoints(part * RAYS_PER_PART,
+                                     (part + 1) * RAYS_PER_PART);
+  }
+
+  void commitContactPoints() { model->ownShip.addContactPoints(); }
+
+  irr::u32 getRadarTerrainParts() { return model->landObjects.getNumber(); }
+
+  void decodeRadarTerrain(irr::u32 part) {
+    model->landObjects.findRadarHeights(part);
+  }
+
+  void commitRadarTerrain() {
+    model->landObjects.addRadarTerrain(&model->terrain);
+  }
+
+  SimulationModel* model;
+  const ScenarioData& scenarioData;
+  std::string worldPath;
+  irr::f32 sunRise;
+  irr::f32 sunSet;
+  irr::f32 lookAngle;
+  irr::f32 cameraMinDistance;
+  irr::f32 cameraMaxDistance;
+  irr::u32 disableShaders;
+  irr::u32 waterSegments;
+  irr::core::vector3di numberOfContactPoints;
+  irr::u32 limitTerrainResolution;
+};
+
+const irr::u32 WorldLoader::RAYS_PER_PART;
+
 SimulationModel::SimulationModel(
     irr::IrrlichtDevice* dev, irr::scene::ISceneManager* scene, GUIMain* gui,
     Sound* sound, ScenarioData scenarioData, OperatingMode::Mode mode,
     irr::f32 viewAngle, irr::f32 lookAngle, irr::f32 cameraMinDistance,
     irr::f32 cameraMaxDistance, irr::u32 disableShaders, irr::u32 waterSegments,
-    irr::core::vector3di numberOfContactPoints, irr::u32 limitTerrainResolution)
+    irr::core::vector3di numberOfContactPoints, irr::u32 limitTerrainResolution,
+    irr::u32 loadThreads)
     : manOverboard(irr::core::vector3df(0, 0, 0), scene, dev, this,
                    &terrain)  // Initialise MOB
 {
   // get reference to scene manager
   device = dev;
   smgr = scene;
+  navLightManager = NavLightManager::getManager(smgr);
+  navLightManager->grab();
+  flightRecorder = 0;
+  // lat and lon have a 95% probability of being offset by at most
+  // 6 meters (two standard deviations).
+  gnss_rng.seed(std::random_device()());
+  gnss_d = std::normal_distribution<double>(0, 3);
   driver = scene->getVideoDriver();
   guiMain = gui;
   this->sound = sound;
@@ -60,7 +288,7 @@ SimulationModel::SimulationModel(
 
   // Store a serialised form of the scenario loaded, as we may want to send this
   // over the network
-  serialisedScenarioData = scenarioData.serialise();
+  serialisedScenarioData = scenarioData.serialiseBinary();
 
   scenarioName = scenarioData.scenarioName;
 
@@ -127,22 +355,13 @@ SimulationModel::SimulationModel(
     worldPath = userFolder + worldPath;
   }
 
-  // Add terrain: Needs to happen first, so the terrain parameters are available
-  terrain.load(worldPath, smgr, device, limitTerrainResolution);
-
-  // sky box/dome
-  Sky sky(smgr);
-
-  // Load own ship model.
-  ownShip.load(scenarioData.ownShipData, numberOfContactPoints, smgr, this,
-               &terrain, device);
-  if (mode == OperatingMode::Secondary) {
-    ownShip.setSpeed(0);  // Don't start moving if in secondary mode
-  }
-
-  // add water
-  water.load(smgr, ownShip.getSceneNode(), weather, disableShaders,
-             waterSegments);
+  // Load the terrain, own ship, other ships, buoys, land objects and the rest
+  // of the world, on loadThreads loader threads (none loads it in turn here)
+  WorldLoader loader(this, scenarioData, worldPath, sunRise, sunSet, lookAngle,
+                     cameraMinDistance, cameraMaxDistance, disableShaders,
+                     waterSegments, numberOfContactPoints,
+                     limitTerrainResolution);
+  loader.load(loadThreads);
 
   /* To be replaced by getting information and passing into gui load method.
   //Tell gui to hide the second engine scroll bar if we have a single engine
@@ -161,47 +380,6 @@ SimulationModel::SimulationModel(
   gui->setInstruments(ownShip.hasDepthSounder(),ownShip.getMaxSounderDepth(),ownShip.hasGPS());
   */
 
-  // Load the radar with config parameters
-  radarCalculation.load(ownShip.getRadarConfigFile(), device);
-
-  // set camera zoom to 1
-  zoom = 1.0;
-
-  // make a camera, setting parent and offset
-  std::vector<irr::core::vector3df> views =
-      ownShip.getCameraViews();  // Get the initial camera offset from the own
-                                 // ship model
-  std::vector<bool> isHighView =
-      ownShip.getCameraIsHighView();  // Are these special 'looking down' views
-  irr::f32 angleCorrection = ownShip.getAngleCorrection();
-  camera.load(smgr, device->getLogger(), ownShip.getSceneNode(), views,
-              isHighView, irr::core::degToRad(viewAngle), lookAngle,
-              angleCorrection);
-  camera.setNearValue(cameraMinDistance);
-  camera.setFarValue(cameraMaxDistance);
-
-  // make ambient light
-  light.load(smgr, sunRise, sunSet, camera.getSceneNode());
-
-  // Load other ships
-  otherShips.load(scenarioData.otherShipsData, scenarioTime, mode, smgr, this,
-                  device);
-
-  // Load buoys
-  buoys.load(worldPath, smgr, this, device);
-
-  // Load land objects
-  landObjects.load(worldPath, smgr, this, &terrain, device);
-
-  // Load land lights
-  landLights.load(worldPath, smgr, this, terrain);
-
-  // Load tidal information
-  tide.load(worldPath);
-
-  // Load rain
-  rain.load(smgr, camera.getSceneNode(), device);
-
   // make a radar screen, setting parent and offset from own ship
   radarScreen.load(
       smgr, ownShip.getSceneNode(), ownShip.getScreenDisplayPosition(),
@@ -302,6 +480,7 @@ SimulationModel::~SimulationModel() {
                                     // when we're finished
 
   delete guiData;
+  navLightManager->drop();
 }
 
 irr::f32 SimulationModel::longToX(irr::f32 longitude) const {
@@ -325,11 +504,6 @@ irr::f32 SimulationModel::getLong() const {
 }
 
 irr::f32 SimulationModel::gnss_noise() const {
-  // lat and lon have a 95% probability of being offset by at most
-  // 6 meters (two standard deviations).
-  static std::random_device random_device;
-  static std::mt19937 gnss_rng(random_device());
-  static std::normal_distribution<double> gnss_d(0, 3);
   irr::f32 offset = gnss_d(gnss_rng);
   // clamp between +- 40 meters of error
   return std::min(std::max(offset, -40.0f), 40.0f);
@@ -972,6 +1146,65 @@ irr::f32 SimulationModel::getAccelerator() const {
   return device->getTimer()->getSpeed();
 }
 
+void SimulationModel::setNoiseSeed(irr::u32 seed) {
+  gnss_rng.seed(seed);
+  gnss_d.reset();
+}
+
+void SimulationModel::applyActuatorCommands(const ActuatorCommands& commands) {
+  if (flightRecorder) flightRecorder->record_commands(commands);
+  setWheel(commands.rudder_angle);
+  setPortEngine(commands.engine_throttle_port);
+  setStbdEngine(commands.engine_throttle_stbd);
+  setBowThruster(commands.thruster_throttle_bow);
+  setSternThruster(commands.thruster_throttle_stern);
+  setBallastTankPump(commands.ballast_tank_pump);
+}
+
+void SimulationModel::setFlightRecorder(FlightRecorder* recorder) {
+  flightRecorder = recorder;
+}
+
+void SimulationModel::getFlightState(
+    FlightOwnShipState& ownShipState,
+    std::vector<FlightShipState>& otherShipStates) const {
+  // Positions relative to the offset, as the model holds them, so nothing is
+  // lost to rounding before the comparison
+  irr::core::vector3df position = ownShip.getPosition();
+  ownShipState.offset_x = offsetPosition.X;
+  ownShipState.offset_z = offsetPosition.Z;
+  ownShipState.scenario_time = scenarioTime;
+  ownShipState.position[0] = position.X;
+  ownShipState.position[1] = position.Y;
+  ownShipState.position[2] = position.Z;
+  ownShipState.heading = ownShip.getHeading();
+  ownShipState.pitch = ownShip.getPitch();
+  ownShipState.roll = ownShip.getRoll();
+  ownShipState.speed = ownShip.getSpeed();
+  ownShipState.rate_of_turn = ownShip.getRateOfTurn();
+  ownShipState.rudder = ownShip.getRudder();
+  ownShipState.wheel = ownShip.getWheel();
+  ownShipState.port_engine_rpm = getPortEngineRPM();
+  ownShipState.stbd_engine_rpm = getStbdEngineRPM();
+  ownShipState.cog = ownShip.getCOG();
+  ownShipState.sog = ownShip.getSOG();
+  ownShipState.depth = ownShip.getDepth();
+  ownShipState.ship_depth = ownShip.getShipDepth();
+  ownShipState.buoyancy = ownShip.getBuoyancy();
+  ownShipState.tide_height = tideHeight;
+  ownShipState.reserved = 0;
+
+  irr::u32 numberOfOtherShips = otherShips.getNumber();
+  otherShipStates.resize(numberOfOtherShips);
+  for (irr::u32 i = 0; i < numberOfOtherShips; i++) {
+    irr::core::vector3df otherPosition = otherShips.getPosition(i);
+    otherShipStates[i].position_x = otherPosition.X;
+    otherShipStates[i].position_z = otherPosition.Z;
+    otherShipStates[i].heading = otherShips.getHeading(i);
+    otherShipStates[i].speed = otherShips.getSpeed(i);
+  }
+}
+
 void SimulationModel::setWeather(irr::f32 weather) { this->weather = weather; }
 
 irr::f32 SimulationModel::getWeather() const { return weather; }
@@ -1298,6 +1531,11 @@ void SimulationModel::update() {
     // increment loop number
     loopNumber++;
 
+    // Seeds std::rand for this update when recording
+    if (flightRecorder) {
+      flightRecorder->begin_frame(currentTime, getAccelerator());
+    }
+
     // end move time along
   }
   {
@@ -1334,22 +1572,21 @@ void SimulationModel::update() {
   {
     IPROF("Update other ships");
     // update other ship positions etc
-    otherShips.update(
-        deltaTime, scenarioTime, tideHeight, lightLevel, ownShip.getPosition(),
-        ownShip.getLength());  // Update other ship motion (based on leg
-                               // information), and light visibility.
+    otherShips.update(deltaTime, scenarioTime, tideHeight,
+                      ownShip.getPosition(),
+                      ownShip.getLength());  // Update other ship motion (based
+                                             // on leg information)
   }
   {
     IPROF("Update buoys");
-    // update buoys (for lights, floating, and if collision detection is turned
-    // on)
-    buoys.update(deltaTime, scenarioTime, tideHeight, lightLevel,
-                 ownShip.getPosition(), ownShip.getLength());
+    // update buoys (for floating, and if collision detection is turned on)
+    buoys.update(deltaTime, scenarioTime, tideHeight, ownShip.getPosition(),
+                 ownShip.getLength());
   }
   {
-    IPROF("Update land lights");
-    // Update land lights
-    landLights.update(deltaTime, scenarioTime, lightLevel);
+    IPROF("Update navigation lights");
+    // Update visibility of the ship, buoy and land lights, in one pass
+    navLightManager->update(scenarioTime, lightLevel);
   }
   {
     IPROF("Update own ship");
@@ -1385,13 +1622,13 @@ void SimulationModel::update() {
       deltaX = 500.0 * Utilities::round(deltaX / 500.0);
       deltaZ = 500.0 * Utilities::round(deltaZ / 500.0);
 
-      // Move all objects
+      // Move the ships and the man overboard, which keep their own positions.
+      // The terrain, buoys, land objects and land lights stay where they were
+      // loaded, in world coordinates on the terrain's world root, and only the
+      // root is moved, whatever the size of the world.
       ownShip.moveNode(deltaX, 0, deltaZ);
-      terrain.moveNode(deltaX, 0, deltaZ);  // SLOW!
+      terrain.moveNode(deltaX, 0, deltaZ);
       otherShips.moveNode(deltaX, 0, deltaZ);
-      buoys.moveNode(deltaX, 0, deltaZ);
-      landObjects.moveNode(deltaX, 0, deltaZ);
-      landLights.moveNode(deltaX, 0, deltaZ);
       manOverboard.moveNode(deltaX, 0, deltaZ);
 
       // Change stored offset
@@ -1549,6 +1786,10 @@ void SimulationModel::update() {
     guiMain->updateGuiData(
         guiData);  // Set GUI heading in degrees and speed (in m/s)
   }
+  if (flightRecorder) {
+    IPROF("Record flight data");
+    flightRecorder->end_frame(*this);
+  }
 }
 
 bool SimulationModel::checkOwnShipCollision() {
@@ -31,6 +31,11 @@ class ScenarioData;
 class GUIMain;
 class GUIData;
 class Sound;
+class NavLightManager;
+class FlightRecorder;
+struct FlightOwnShipState;
+struct FlightShipState;
+struct ActuatorCommands;
 
 #include "Buoys.hpp"
 #include "Camera.hpp"
@@ -58,7 +63,7 @@ class SimulationModel  // Start of the 'Model' part of MVC
                   irr::f32 cameraMaxDistance, irr::u32 disableShaders,
                   irr::u32 waterSegments,
                   irr::core::vector3di numberOfContactPoints,
-                  irr::u32 limitTerrainResolution);
+                  irr::u32 limitTerrainResolution, irr::u32 loadThreads);
   ~SimulationModel();
   irr::f32 longToX(irr::f32 longitude) const;
   irr::f32 latToZ(irr::f32 latitude) const;
@@ -156,6 +161,13 @@ class SimulationModel  // Start of the 'Model' part of MVC
                                     // working
   void setAccelerator(irr::f32 accelerator);  // Set simulation time compression
   irr::f32 getAccelerator() const;
+  void setNoiseSeed(irr::u32 seed);  // Makes the sensor noise repeatable
+  // Actuator commands from the BC proxies, recorded with the next update
+  void applyActuatorCommands(const ActuatorCommands& commands);
+  // Record every update from here on, null to stop. See FlightRecorder.hpp
+  void setFlightRecorder(FlightRecorder* recorder);
+  void getFlightState(FlightOwnShipState& ownShipState,
+                      std::vector<FlightShipState>& otherShipStates) const;
   irr::f32 getSpeed() const;    // Gets the own ship's speed
   irr::f32 getHeading() const;  // Gets the own ship's heading
 
@@ -310,6 +322,9 @@ class SimulationModel  // Start of the 'Model' part of MVC
   void update();
 
  private:
+  friend class WorldLoader;  // Loads the world into the model, see the constructor
+  friend class BenchmarkFixture;  // Runs parts of the model alone, see bench/
+
   irr::IrrlichtDevice* device;
   irr::video::IVideoDriver* driver;
   irr::scene::ISceneManager* smgr;
@@ -341,6 +356,7 @@ class SimulationModel  // Start of the 'Model' part of MVC
   Buoys buoys;
   LandObjects landObjects;
   LandLights landLights;
+  NavLightManager* navLightManager;  // Draws the lights of all of the above
   Camera camera;
   Camera radarCamera;
   Water water;
@@ -372,7 +388,11 @@ class SimulationModel  // Start of the 'Model' part of MVC
   // Offset position handling
   irr::core::vector3d<int64_t> offsetPosition;
 
+  FlightRecorder* flightRecorder;
+
   irr::f32 gnss_noise() const;
+  mutable std::mt19937 gnss_rng;
+  mutable std::normal_distribution<double> gnss_d;
   // store useful information
   std::string scenarioName;
   std::string worldName;
@@ -32,7 +32,7 @@
 
 Terrain::Terrain()
 {
-
+    worldRoot = 0;
 }
 
 Terrain::~Terrain()
@@ -43,12 +43,16 @@ Terrain::~Terrain()
     }
 }
 
-void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* device, irr::u32 terrainResolutionLimit)
+void Terrain::decode(const std::string& worldPath, irr::IrrlichtDevice* device, irr::u32 terrainResolutionLimit)
 {
+    //Runs on a loader thread: only reads files, and must not touch the scene
 
     dev = device;
-    
-    irr::video::IVideoDriver* driver = smgr->getVideoDriver();
+    decodedTerrains.clear();
+    decodeError.clear();
+
+    irr::io::IFileSystem* fileSystem = device->getFileSystem();
+    irr::video::IVideoDriver* driver = device->getVideoDriver();
 
     //Get full path to the main Terrain.ini file
     std::string worldTerrainFile = worldPath;
@@ -59,8 +63,6 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
 
     //If terrain.ini doesn't exist, look for *.bin and *.hdr
     if (!Utilities::pathExists(worldTerrainFile)) {
-        irr::io::IFileSystem* fileSystem = device->getFileSystem();
-        
         //store current dir
         irr::io::path cwd = fileSystem->getWorkingDirectory();
 
@@ -96,59 +98,54 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
     }
 
     if (numberOfTerrains <= 0) {
-        std::cerr << "Could not load terrain. No terrain defined in settings file." << std::endl;
-        exit(EXIT_FAILURE);
+        decodeError = "Could not load terrain. No terrain defined in settings file.";
+        return;
     }
 
     for (unsigned int i = 1; i<=numberOfTerrains; i++) {
 
-        irr::f32 terrainLong;
-        irr::f32 terrainLat;
-        irr::f32 terrainLongExtent;
-        irr::f32 terrainLatExtent;
-        irr::f32 terrainMaxHeight;
-        irr::f32 seaMaxDepth;
-        bool usesRGBEncoding;
+        DecodedTerrain decoded;
+        decoded.texture = 0;
         //Full paths
         std::string heightMapPath;
         std::string textureMapPath;
         
         if (usingHdrFileOnly) {
             //load from 3dem header format, worldTerrainFile is the .hdr file in this case
-            terrainLong = IniFile::iniFileTof32(worldTerrainFile, "left_map_x");
-            terrainLat = IniFile::iniFileTof32(worldTerrainFile, "lower_map_y");
-            terrainLongExtent = IniFile::iniFileTof32(worldTerrainFile, "right_map_x")-terrainLong;
-            terrainLatExtent = IniFile::iniFileTof32(worldTerrainFile, "upper_map_y")-terrainLat;
+            decoded.terrainLong = IniFile::iniFileTof32(worldTerrainFile, "left_map_x");
+            decoded.terrainLat = IniFile::iniFileTof32(worldTerrainFile, "lower_map_y");
+            decoded.terrainLongExtent = IniFile::iniFileTof32(worldTerrainFile, "right_map_x")-decoded.terrainLong;
+            decoded.terrainLatExtent = IniFile::iniFileTof32(worldTerrainFile, "upper_map_y")-decoded.terrainLat;
 
             heightMapPath = worldTerrainFile; //The name of the .hdr file
             
             //assume map is the same path, with .hdr replaced with .bmp
             //Use this as a texture (is this sensible?!)
-            std::string textureMapName = std::string(device->getFileSystem()->getFileBasename(worldTerrainFile.c_str(),false).append(".bmp").c_str());
+            std::string textureMapName = std::string(fileSystem->getFileBasename(worldTerrainFile.c_str(),false).append(".bmp").c_str());
             textureMapPath = worldPath;
             textureMapPath.append("/");
             textureMapPath.append(textureMapName);
 
             //Dummy contents, won't be used in this case
-            terrainMaxHeight=0;
-            seaMaxDepth=0;
-            usesRGBEncoding=false;
+            decoded.terrainMaxHeight=0;
+            decoded.seaMaxDepth=0;
+            decoded.usesRGBEncoding=false;
 
         } else {
             //Load from normal terrain.ini format
-            terrainLong = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLong",i));
-            terrainLat = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLat",i));
-            terrainLongExtent = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLongExtent",i));
-            terrainLatExtent = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLatExtent",i));
+            decoded.terrainLong = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLong",i));
+            decoded.terrainLat = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLat",i));
+            decoded.terrainLongExtent = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLongExtent",i));
+            decoded.terrainLatExtent = IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainLatExtent",i));
 
-            terrainMaxHeight=IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainMaxHeight",i));
-            seaMaxDepth=IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("SeaMaxDepth",i));
+            decoded.terrainMaxHeight=IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainMaxHeight",i));
+            decoded.seaMaxDepth=IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("SeaMaxDepth",i));
             //irr::f32 terrainHeightMapSize=IniFile::iniFileTof32(worldTerrainFile, IniFile::enumerate1("TerrainHeightMapSize",i));
 
             std::string heightMapName = IniFile::iniFileToString(worldTerrainFile, IniFile::enumerate1("HeightMap",i));
             std::string textureMapName = IniFile::iniFileToString(worldTerrainFile, IniFile::enumerate1("Texture",i));
 
-            usesRGBEncoding = IniFile::iniFileTou32(worldTerrainFile, IniFile::enumerate1("UsesRGB",i)) > 0;
+            decoded.usesRGBEncoding = IniFile::iniFileTou32(worldTerrainFile, IniFile::enumerate1("UsesRGB",i)) > 0;
 
             //Full paths
             heightMapPath = worldPath;
@@ -159,44 +156,25 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
             textureMapPath.append("/");
             textureMapPath.append(textureMapName);
         }
-
-        //calculations just needed for terrain loading
-        //irr::f32 scaleX = terrainXWidth / (terrainHeightMapSize);
-        irr::f32 scaleY = (terrainMaxHeight + seaMaxDepth)/ (255.0);
-        //irr::f32 scaleZ = terrainZWidth / (terrainHeightMapSize);
-        irr::f32 terrainY = -1*seaMaxDepth;
-
-        //Add an empty terrain
-        //irr::scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode("",0,-1,irr::core::vector3df(0.f, terrainY, 0.f),irr::core::vector3df(0.f, 0.f, 0.f),irr::core::vector3df(1,1,1),irr::video::SColor(255,255,255,255),5,irr::scene::ETPS_9,0,true);
-
-        irr::scene::BCTerrainSceneNode* terrain = new irr::scene::BCTerrainSceneNode(
-            device,
-            smgr->getRootSceneNode(), 
-            smgr,
-			smgr->getFileSystem(), -1, 5, irr::scene::ETPS_33
-        );
+        decoded.textureMapPath = textureMapPath;
 
         //Load the map
-        irr::io::IReadFile* heightMapFile = smgr->getFileSystem()->createAndOpenFile(heightMapPath.c_str());
-        //Check the height map file has loaded and the terrain exists
-        if (terrain==0 || heightMapFile == 0) {
+        irr::io::IReadFile* heightMapFile = fileSystem->createAndOpenFile(heightMapPath.c_str());
+        //Check the height map file has loaded
+        if (heightMapFile == 0) {
             //Could not load terrain
-            std::cerr << "Could not load terrain. Height map file not loaded. " << heightMapPath << std::endl;
-            std::cerr << "Terrain: " << terrain << " heightMapFile: " << heightMapFile << std::endl;
-            exit(EXIT_FAILURE);
+            decodeError = "Could not load terrain. Height map file not loaded. " + heightMapPath;
+            return;
         }
 
-        //Load the terrain and check success
-        bool loaded = false;
-        irr::f32 terrainXLoadScaling = 1;
-        irr::f32 terrainZLoadScaling = 1;
-        
         //Check extension
         std::string extension = "";
         if (heightMapPath.length() > 3) {
             extension = heightMapPath.substr(heightMapPath.length() - 4,4);
             Utilities::to_lower(extension);
         }
+        //Heights are used directly for these, rather than scaled from the 0-255 range
+        decoded.usesHeightsDirectly = extension.compare(".f32") == 0 || extension.compare(".hdr") == 0 || decoded.usesRGBEncoding;
         
         if (extension.compare(".f32") == 0 ) {
             
@@ -215,29 +193,27 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
             }
 
             //Load from binary file into a vector, 
-            std::vector<std::vector<irr::f32>> heightMapVector = heightMapBinaryToVector(heightMapFile,binaryRows,binaryCols,true);
+            decoded.heightMap = heightMapBinaryToVector(heightMapFile,binaryRows,binaryCols,true);
             
             //limit size if needed
             if (terrainResolutionLimit>0) {
-                heightMapVector = limitSize(heightMapVector,terrainResolutionLimit);
+                decoded.heightMap = limitSize(decoded.heightMap,terrainResolutionLimit);
             }
             
             //Need to flip row and columns for legacy files
             if (flipRowCol) {
-                heightMapVector = transposeHeightMapVector(heightMapVector);
+                decoded.heightMap = transposeHeightMapVector(decoded.heightMap);
             }
-            //Then use this vector to load terrain
-            loaded = terrain->loadHeightMapVector(heightMapVector, terrainXLoadScaling, terrainZLoadScaling, irr::video::SColor(255, 255, 255, 255), 0);
 
         }  else if (extension.compare(".hdr") == 0 ) {
             //3Dem header for binary file
             irr::u32 binaryRows = IniFile::iniFileTou32(heightMapPath, "number_of_rows");
             irr::u32 binaryCols = IniFile::iniFileTou32(heightMapPath, "number_of_columns");
 
-            terrainLong = IniFile::iniFileTof32(heightMapPath, "left_map_x");
-            terrainLat = IniFile::iniFileTof32(heightMapPath, "lower_map_y");
-            terrainLongExtent = IniFile::iniFileTof32(heightMapPath, "right_map_x")-terrainLong;
-            terrainLatExtent = IniFile::iniFileTof32(heightMapPath, "upper_map_y")-terrainLat;
+            decoded.terrainLong = IniFile::iniFileTof32(heightMapPath, "left_map_x");
+            decoded.terrainLat = IniFile::iniFileTof32(heightMapPath, "lower_map_y");
+            decoded.terrainLongExtent = IniFile::iniFileTof32(heightMapPath, "right_map_x")-decoded.terrainLong;
+            decoded.terrainLatExtent = IniFile::iniFileTof32(heightMapPath, "upper_map_y")-decoded.terrainLat;
 
             bool floatingPoint = IniFile::iniFileToString(heightMapPath, "data_format").compare("float32")==0;
 
@@ -252,34 +228,84 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
             heightMapFile->drop();
             heightMapPath.erase(heightMapPath.end()-3,heightMapPath.end());
             heightMapPath.append("bin");
-            irr::io::IReadFile* heightMapFile = smgr->getFileSystem()->createAndOpenFile(heightMapPath.c_str());
+            heightMapFile = fileSystem->createAndOpenFile(heightMapPath.c_str());
             if (heightMapFile) {
                 try {
-                    //Load from binary file into a vector, and then use this vector to load terrain
-                    std::vector<std::vector<irr::f32>> heightMapVector = heightMapBinaryToVector(heightMapFile,binaryRows,binaryCols,floatingPoint);
+                    //Load from binary file into a vector
+                    decoded.heightMap = heightMapBinaryToVector(heightMapFile,binaryRows,binaryCols,floatingPoint);
                     //limit size if needed
                     if (terrainResolutionLimit>0) {
-                        heightMapVector = limitSize(heightMapVector,terrainResolutionLimit);
+                        decoded.heightMap = limitSize(decoded.heightMap,terrainResolutionLimit);
                     }
-                    loaded = terrain->loadHeightMapVector(heightMapVector, terrainXLoadScaling, terrainZLoadScaling, irr::video::SColor(255, 255, 255, 255), 0);
                 } catch (...) {
                     std::cerr << "Exception in loading terrain from binary with hdr." << std::endl;
-                    loaded = false;    
+                    decoded.heightMap.clear();
                 }
             }
 
         } else {
             //Normal image file
-            std::vector<std::vector<irr::f32>> heightMapVector = heightMapImageToVector(heightMapFile,usesRGBEncoding,false,smgr);
+            decoded.heightMap = heightMapImageToVector(heightMapFile,decoded.usesRGBEncoding,false,driver);
             
             //limit size if needed
             if (terrainResolutionLimit>0) {
-                heightMapVector = limitSize(heightMapVector,terrainResolutionLimit);
+                decoded.heightMap = limitSize(decoded.heightMap,terrainResolutionLimit);
             }
+        }
 
-            loaded = terrain->loadHeightMapVector(heightMapVector, terrainXLoadScaling, terrainZLoadScaling, irr::video::SColor(255, 255, 255, 255), 0);
+        if (heightMapFile) {
+            heightMapFile->drop();
         }
 
+        //Decode the texture image here too, commit() makes the texture from it
+        decoded.texture = driver->createImageFromFile(textureMapPath.c_str());
+
+        decodedTerrains.push_back(decoded);
+
+    }
+
+}
+
+void Terrain::commit(irr::scene::ISceneManager* smgr)
+{
+    //Runs on the main thread, builds the terrain nodes from what decode() read
+
+    irr::video::IVideoDriver* driver = smgr->getVideoDriver();
+
+    if (!decodeError.empty()) {
+        std::cerr << decodeError << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    //Everything fixed in the world is placed on this, in world coordinates, so re-centring the world only moves it
+    worldRoot = smgr->addEmptySceneNode();
+    worldRoot->setName("WorldRoot");
+
+    for (unsigned int i = 1; i<=decodedTerrains.size(); i++) {
+
+        DecodedTerrain& decoded = decodedTerrains.at(i-1);
+
+        //calculations just needed for terrain loading
+        //irr::f32 scaleX = terrainXWidth / (terrainHeightMapSize);
+        irr::f32 scaleY = (decoded.terrainMaxHeight + decoded.seaMaxDepth)/ (255.0);
+        //irr::f32 scaleZ = terrainZWidth / (terrainHeightMapSize);
+        irr::f32 terrainY = -1*decoded.seaMaxDepth;
+
+        //Add an empty terrain
+        //irr::scene::ITerrainSceneNode* terrain = smgr->addTerrainSceneNode("",0,-1,irr::core::vector3df(0.f, terrainY, 0.f),irr::core::vector3df(0.f, 0.f, 0.f),irr::core::vector3df(1,1,1),irr::video::SColor(255,255,255,255),5,irr::scene::ETPS_9,0,true);
+
+        irr::scene::BCTerrainSceneNode* terrain = new irr::scene::BCTerrainSceneNode(
+            dev,
+            worldRoot,
+            smgr,
+			smgr->getFileSystem(), -1, 5, irr::scene::ETPS_33
+        );
+
+        //Load the terrain and check success
+        irr::f32 terrainXLoadScaling = 1;
+        irr::f32 terrainZLoadScaling = 1;
+        bool loaded = terrain->loadHeightMapVector(decoded.heightMap, terrainXLoadScaling, terrainZLoadScaling, irr::video::SColor(255, 255, 255, 255), 0);
+
         if (!loaded) {
             //Could not load terrain
             std::cerr << "Could not load terrain at loadHeightMap stage." << std::endl;
@@ -287,13 +313,13 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
         }
 
         //Terrain dimensions in metres
-        irr::f32 terrainXWidth = terrainLongExtent * 2.0 * PI * EARTH_RAD_M * cos( irr::core::degToRad(terrainLat + terrainLatExtent/2.0)) / 360.0;
-        irr::f32 terrainZWidth = terrainLatExtent  * 2.0 * PI * EARTH_RAD_M / 360;
+        irr::f32 terrainXWidth = decoded.terrainLongExtent * 2.0 * PI * EARTH_RAD_M * cos( irr::core::degToRad(decoded.terrainLat + decoded.terrainLatExtent/2.0)) / 360.0;
+        irr::f32 terrainZWidth = decoded.terrainLatExtent  * 2.0 * PI * EARTH_RAD_M / 360;
 
         irr::f32 scaleX = terrainXLoadScaling*terrainXWidth/(terrain->getBoundingBox().MaxEdge.X - terrain->getBoundingBox().MinEdge.X);
         irr::f32 scaleZ = terrainZLoadScaling*terrainZWidth/(terrain->getBoundingBox().MaxEdge.Z - terrain->getBoundingBox().MinEdge.Z);
             
-        if (extension.compare(".f32") == 0 || extension.compare(".hdr") == 0 || usesRGBEncoding) {
+        if (decoded.usesHeightsDirectly) {
             //Set scales etc to be 1.0, so heights are used directly
             terrain->setScale(irr::core::vector3df(scaleX,1.0f,scaleZ));
             terrain->setPosition(irr::core::vector3df(0.f, 0.f, 0.f));
@@ -303,30 +329,39 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
             terrain->setPosition(irr::core::vector3df(0.f, terrainY, 0.f));
         }
 
-        heightMapFile->drop();
         //terrains are dropped in destructor.
 
+        //Add the decoded texture under the name getTexture() files it by, so the lookup below (and any other user of the file) finds it
+        if (decoded.texture) {
+            irr::io::path textureName = smgr->getFileSystem()->getAbsolutePath(decoded.textureMapPath.c_str());
+            if (!driver->findTexture(textureName)) {
+                driver->addTexture(textureName, decoded.texture);
+            }
+            decoded.texture->drop();
+            decoded.texture = 0;
+        }
+
         terrain->setMaterialFlag(irr::video::EMF_FOG_ENABLE, true);
         terrain->setMaterialFlag(irr::video::EMF_NORMALIZE_NORMALS, true); //Normalise normals on scaled meshes, for correct lighting
         //Todo: Anti-aliasing flag?
-        terrain->setMaterialTexture(0, driver->getTexture(textureMapPath.c_str()));
+        terrain->setMaterialTexture(0, driver->getTexture(decoded.textureMapPath.c_str()));
 
         if (i==1) {
             //Private member variables used in further calculations
-            primeTerrainLong = terrainLong;
+            primeTerrainLong = decoded.terrainLong;
             primeTerrainXWidth = terrainXWidth;
-            primeTerrainLongExtent = terrainLongExtent;
-            primeTerrainLat = terrainLat;
+            primeTerrainLongExtent = decoded.terrainLongExtent;
+            primeTerrainLat = decoded.terrainLat;
             primeTerrainZWidth = terrainZWidth;
-            primeTerrainLatExtent = terrainLatExtent;
+            primeTerrainLatExtent = decoded.terrainLatExtent;
 
 
         } else {
             //Non-primary terrains need to be moved to account for their position (primary terrain starts at 0,0)
 
             irr::core::vector3df currentPos = terrain->getPosition();
-            irr::f32 deltaX = (terrainLong - primeTerrainLong) * primeTerrainXWidth / primeTerrainLongExtent;
-            irr::f32 deltaZ = (terrainLat - primeTerrainLat) * primeTerrainZWidth / primeTerrainLatExtent;
+            irr::f32 deltaX = (decoded.terrainLong - primeTerrainLong) * primeTerrainXWidth / primeTerrainLongExtent;
+            irr::f32 deltaZ = (decoded.terrainLat - primeTerrainLat) * primeTerrainZWidth / primeTerrainLatExtent;
             irr::f32 newPosX = currentPos.X + deltaX;
             irr::f32 newPosY = currentPos.Y;
             irr::f32 newPosZ = currentPos.Z + deltaZ;
@@ -337,12 +372,14 @@ void Terrain::load(const std::string& worldPath, irr::scene::ISceneManager* smgr
 
     }
 
+    //The height maps are in the nodes now
+    decodedTerrains.clear();
 
 }
 
-std::vector<std::vector<irr::f32>> Terrain::heightMapImageToVector(irr::io::IReadFile* heightMapFile, bool usesRGBEncoding, bool normaliseSize, irr::scene::ISceneManager* smgr)
+std::vector<std::vector<irr::f32>> Terrain::heightMapImageToVector(irr::io::IReadFile* heightMapFile, bool usesRGBEncoding, bool normaliseSize, irr::video::IVideoDriver* driver)
 {
-    irr::video::IImage* heightMap = smgr->getVideoDriver()->createImageFromFile(heightMapFile);
+    irr::video::IImage* heightMap = driver->createImageFromFile(heightMapFile);
     std::vector<std::vector<irr::f32>> heightMapVector;
 
     if (heightMap==0) {
@@ -452,7 +489,7 @@ void Terrain::addRadarReflectingTerrain(std::vector<std::vector<irr::f32>> heigh
     
     irr::scene::BCTerrainSceneNode* terrain = new irr::scene::BCTerrainSceneNode(
             dev,
-            dev->getSceneManager()->getRootSceneNode(), 
+            worldRoot,
             dev->getSceneManager(),
 			dev->getSceneManager()->getFileSystem(), -1, 5, irr::scene::ETPS_33
         );
@@ -555,7 +592,15 @@ irr::f32 Terrain::getHeight(irr::f32 x, irr::f32 z) const //Get height from glob
 {
     //Fallback minimum value
     irr::f32 terrainHeight = -FLT_MAX;
-    
+    if (terrains.empty()) {
+        return terrainHeight;
+    }
+
+    //The terrains are where they were loaded, relative to the world root, which moveNode() moves instead
+    const irr::core::vector3df& origin = worldRoot->getPosition();
+    x -= origin.X;
+    z -= origin.Z;
+
     //Check down list, find highest return value
     for (int i=(int)terrains.size()-1; i>=0; i--) {
         irr::f32 thisHeight = terrains.at(i)->getHeight(x,z);
@@ -564,7 +609,7 @@ irr::f32 Terrain::getHeight(irr::f32 x, irr::f32 z) const //Get height from glob
         }
     }
 
-    return terrainHeight;
+    return terrainHeight + origin.Y;
 }
 
 irr::f32 Terrain::longToX(irr::f32 longitude) const
@@ -587,11 +632,16 @@ irr::f32 Terrain::zToLat(irr::f32 z) const{
 
 void Terrain::moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ)
 {
-    for (unsigned int i=0; i<terrains.size(); i++) {
-        irr::core::vector3df currentPos = terrains.at(i)->getPosition();
-        irr::f32 newPosX = currentPos.X + deltaX;
-        irr::f32 newPosY = currentPos.Y + deltaY;
-        irr::f32 newPosZ = currentPos.Z + deltaZ;
-        terrains.at(i)->setPosition(irr::core::vector3df(newPosX,newPosY,newPosZ));
+    //Moves the world root, and with it the terrains, buoys, land objects and land lights on it. Their vertices and
+    //positions stay as loaded: the terrain patches and the collision triangles follow the root's transform.
+    if (!worldRoot) {
+        return;
     }
+    worldRoot->setPosition(worldRoot->getPosition() + irr::core::vector3df(deltaX,deltaY,deltaZ));
+    worldRoot->updateAbsolutePosition(); //Otherwise only updated by the next drawAll()
+}
+
+irr::scene::ISceneNode* Terrain::getWorldRoot() const
+{
+    return worldRoot;
 }
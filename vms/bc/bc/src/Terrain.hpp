@@ -27,18 +27,37 @@ class Terrain
     public:
         Terrain();
         virtual ~Terrain();
-        void load(const std::string& worldPath, irr::scene::ISceneManager* smgr, irr::IrrlichtDevice* device, irr::u32 terrainResolutionLimit);
+        //Loading is split for the load pipeline: decode() reads the ini and height map files and decodes the images,
+        //and can run on a loader thread; commit() then builds the terrain nodes from them on the main thread
+        void decode(const std::string& worldPath, irr::IrrlichtDevice* device, irr::u32 terrainResolutionLimit);
+        void commit(irr::scene::ISceneManager* smgr);
         irr::f32 longToX(irr::f32 longitude) const;
         irr::f32 latToZ(irr::f32 latitude) const;
         irr::f32 xToLong(irr::f32 x) const;
         irr::f32 zToLat(irr::f32 z) const;
         irr::f32 getHeight(irr::f32 x, irr::f32 z) const;
-        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ);
+        void moveNode(irr::f32 deltaX, irr::f32 deltaY, irr::f32 deltaZ); //Moves the world root only
+        irr::scene::ISceneNode* getWorldRoot() const; //Parent of everything fixed in the world, 0 until commit()
         void addRadarReflectingTerrain(std::vector<std::vector<irr::f32>> heightVector, irr::f32 positionX, irr::f32 positionZ, irr::f32 widthX, irr::f32 widthZ);
 
     private:
+
+        //A terrain read by decode(), waiting for commit()
+        struct DecodedTerrain {
+            irr::f32 terrainLong;
+            irr::f32 terrainLat;
+            irr::f32 terrainLongExtent;
+            irr::f32 terrainLatExtent;
+            irr::f32 terrainMaxHeight;
+            irr::f32 seaMaxDepth;
+            bool usesRGBEncoding;
+            bool usesHeightsDirectly;
+            std::vector<std::vector<irr::f32>> heightMap;
+            std::string textureMapPath;
+            irr::video::IImage* texture;
+        };
         
-        std::vector<std::vector<irr::f32>> heightMapImageToVector(irr::io::IReadFile* heightMapFile, bool usesRGBEncoding, bool normaliseSize, irr::scene::ISceneManager* smgr);
+        std::vector<std::vector<irr::f32>> heightMapImageToVector(irr::io::IReadFile* heightMapFile, bool usesRGBEncoding, bool normaliseSize, irr::video::IVideoDriver* driver);
         std::vector<std::vector<irr::f32>> heightMapBinaryToVector(irr::io::IReadFile* heightMapFile, irr::u32 binaryWidth, irr::u32 binaryHeight, bool floatingPoint);
         
         std::vector<std::vector<irr::f32>> transposeHeightMapVector(std::vector<std::vector<irr::f32>> inVector);
@@ -46,6 +65,10 @@ class Terrain
 
         irr::IrrlichtDevice* dev;
 
+        std::vector<DecodedTerrain> decodedTerrains;
+        std::string decodeError;
+
+        irr::scene::ISceneNode* worldRoot; //Kept by the scene's root node
         std::vector<irr::scene::ITerrainSceneNode*> terrains;
         irr::f32 primeTerrainLong;
         irr::f32 primeTerrainXWidth;
@@ -0,0 +1,427 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "BenchmarkFixture.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+#include "../AIS.hpp"
+#include "../BCTerrainSceneNode.h"
+#include "../BCTerrainTriangleSelector.h"
+#include "../IniFile.hpp"
+#include "../Lang.hpp"
+#include "../NMEA.hpp"
+#include "../NMEACodec.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "../tests/LegacyNMEA.hpp"
+
+namespace {
+
+// SimpleEstuary covers 10W to 9.9499W, 50N to 50.04N. The own ship starts in
+// the estuary, where the SimpleEstuary scenario puts it.
+const irr::f32 WORLD_LONG = -10.0f;
+const irr::f32 WORLD_LAT = 50.0f;
+const irr::f32 WORLD_LONG_EXTENT = 0.0501f;
+const irr::f32 WORLD_LAT_EXTENT = 0.04008f;
+const irr::f32 OWN_SHIP_LONG = -9.974f;
+const irr::f32 OWN_SHIP_LAT = 50.0347f;
+
+// Terrain and tide are sampled on a grid of this many points a side
+const irr::u32 GRID_SIZE = 64;
+
+// Other ships are on a ring around the own ship, in degrees of latitude
+const irr::f32 RING_RADIUS = 0.01f;
+
+// NMEA::updateNMEA() sends a sensor sentence every this many ms
+const irr::u32 NMEA_INTERVAL = 100;
+
+// Sentences from a chart plotter, received in turn, without <CR><LF>
+const char* const RECEIVED_SENTENCES[] = {
+    "$GPAPB,A,A,0.10,R,N,V,V,011.0,T,DEST,011.0,T,012.0,T*38",
+    "$GPRMB,A,0.10,R,ORIG,DEST,5002.08,N,00958.44,W,1.5,011.0,7.9,V,S*50"};
+const irr::u32 RECEIVED_SENTENCE_COUNT =
+    sizeof(RECEIVED_SENTENCES) / sizeof(RECEIVED_SENTENCES[0]);
+
+// Other ships in the scenario the codecs work on, as a large hub session
+const irr::u32 LARGE_SCENARIO_SHIPS = 1000;
+
+// Height map of the large terrain the rays are cast on, 32 x 32 patches, at
+// this many metres a point
+const irr::u32 LARGE_TERRAIN_SIZE = 1025;
+const irr::f32 LARGE_TERRAIN_SCALE = 10.0f;
+
+// The ini cache of iniWarm() is kept in the working directory, and iniCold()
+// looks for one where there is none
+const char INI_CACHE_DIR[] = "./";
+const char INI_CACHE_FILE[] = "./ini.cache";
+const char NO_INI_CACHE_DIR[] = "./no-ini-cache/";
+
+// hills and valleys, so that rays cross several patches before they hit
+std::vector<std::vector<irr::f32>> makeHeightMap(irr::u32 size) {
+  std::vector<std::vector<irr::f32>> heightMap(size,
+                                               std::vector<irr::f32>(size));
+  for (irr::u32 x = 0; x < size; x++) {
+    for (irr::u32 z = 0; z < size; z++) {
+      heightMap[x][z] = 50.0f * std::sin(x * 0.021f) * std::cos(z * 0.017f) +
+                        20.0f * std::sin((x + 2 * z) * 0.053f);
+    }
+  }
+  return heightMap;
+}
+
+}  // namespace
+
+BenchmarkFixture::BenchmarkFixture()
+    : device(0),
+      language(0),
+      model(0),
+      ocean(0),
+      nmea(0),
+      legacyNmea(0),
+      largeTerrain(0),
+      largeTerrainSelector(0),
+      deltaTime(1.0f / 60.0f),
+      scenarioTime(0),
+      waveTime(0),
+      nmeaTime(0),
+      legacyNmeaTime(0),
+      nextSentence(0),
+      nextHeight(0),
+      nextStream(0),
+      nextShip(0),
+      nextRay(0),
+      checksum(0) {}
+
+BenchmarkFixture::~BenchmarkFixture() {
+  if (!iniFiles.empty()) {
+    std::remove(INI_CACHE_FILE);
+    IniFile::resetCache();
+  }
+  if (largeTerrainSelector) largeTerrainSelector->drop();
+  if (largeTerrain) largeTerrain->drop();
+  delete legacyNmea;
+  delete nmea;
+  delete ocean;
+  delete model;
+  delete language;
+  if (device) device->drop();
+}
+
+ScenarioData BenchmarkFixture::makeScenario(irr::u32 otherShips) {
+  ScenarioData scenario;
+  scenario.scenarioName = "Benchmark";
+  scenario.worldName = "SimpleEstuary";
+  scenario.startTime = 10;
+  scenario.sunRise = 6;
+  scenario.sunSet = 18;
+  scenario.weather = 3;
+  scenario.rainIntensity = 2;
+  scenario.visibilityRange = 8;
+  scenario.startDay = 1;
+  scenario.startMonth = 1;
+  scenario.startYear = 2015;
+
+  scenario.ownShipData.ownShipName = "Protis";
+  scenario.ownShipData.initialLong = OWN_SHIP_LONG;
+  scenario.ownShipData.initialLat = OWN_SHIP_LAT;
+  scenario.ownShipData.initialBearing = 251;
+  scenario.ownShipData.initialSpeed = 8;
+
+  // Alternately a small and a large ship, heading round the ring
+  for (irr::u32 i = 0; i < otherShips; i++) {
+    irr::f32 angle = 360.0f * i / otherShips;
+    OtherShipData ship;
+    ship.shipName = (i % 2 == 0) ? "Yacht_Motoring" : "Cargoship1";
+    ship.mmsi = 235000000 + i;
+    ship.initialLat =
+        OWN_SHIP_LAT + RING_RADIUS * std::cos(angle * irr::core::DEGTORAD);
+    ship.initialLong =
+        OWN_SHIP_LONG + RING_RADIUS * std::sin(angle * irr::core::DEGTORAD) /
+                            std::cos(OWN_SHIP_LAT * irr::core::DEGTORAD);
+    for (irr::u32 j = 0; j < 4; j++) {
+      LegData leg;
+      leg.bearing = std::fmod(angle + 90 * (j + 1), 360.0f);
+      leg.speed = 4 + i % 8;
+      leg.distance = 0.5;
+      ship.legs.push_back(leg);
+    }
+    scenario.otherShipsData.push_back(ship);
+  }
+  return scenario;
+}
+
+bool BenchmarkFixture::load(const std::string& dataPath,
+                            irr::u32 otherShips) {
+  device = irr::createDevice(irr::video::EDT_NULL,
+                             irr::core::dimension2d<irr::u32>(1024, 768));
+  if (!device) return true;
+  device->getLogger()->setLogLevel(irr::ELL_ERROR);
+  IniFile::irrlichtLogger = device->getLogger();
+  // Models and worlds are read relative to the working directory
+  irr::io::IFileSystem* fileSystem = device->getFileSystem();
+  irr::io::path workingDirectory = fileSystem->getWorkingDirectory();
+  if (!fileSystem->changeWorkingDirectoryTo(dataPath.c_str())) return true;
+  device->getTimer()->setSpeed(0);
+  device->getTimer()->setTime(0);
+
+  std::srand(1);
+  ScenarioData scenario = makeScenario(otherShips);
+  model = new SimulationModel(
+      device, device->getSceneManager(), &gui, &sound, scenario,
+      OperatingMode::Normal, 90, 0, 0.5, 10000, 1, 32,
+      irr::core::vector3di(10, 30, 30), 0, 0);
+  language = new Lang("language-en.txt");
+  gui.load(device, language, &logMessages, model->isSingleEngine(),
+           model->isAzimuthDrive(), false, model->hasDepthSounder(),
+           model->getMaxSounderDepth(), model->hasGPS(),
+           model->hasBowThruster(), model->hasSternThruster(),
+           model->hasTurnIndicator());
+  fileSystem->changeWorkingDirectoryTo(workingDirectory);
+  if (model->getNumberOfOtherShips() != otherShips) return true;
+  scenarioTime = model->scenarioTime;
+
+  // As MovingWater builds it, for the default 32 water segments
+  ocean = new cOcean(32, 0.00005f, vector2(32.0f, 32.0f), 100);
+
+  // No serial port, and nothing to listen on
+  nmea = new NMEA(model, "", 0, "localhost", "10110", "", device);
+  legacyNmea = new LegacyNMEA(model);
+
+  largeScenario = makeScenario(LARGE_SCENARIO_SHIPS);
+  largeScenarioBinary = largeScenario.serialiseBinary();
+  largeScenarioText = largeScenario.serialise();
+
+  // Not part of the model, and without a selector on the node, so nothing
+  // else picks on it
+  irr::scene::ISceneManager* smgr = device->getSceneManager();
+  largeTerrain = new irr::scene::BCTerrainSceneNode(
+      device, smgr->getRootSceneNode(), smgr, fileSystem, -1, 5,
+      irr::scene::ETPS_33);
+  irr::f32 xLoadScaling = 1;
+  irr::f32 zLoadScaling = 1;
+  if (!static_cast<irr::scene::BCTerrainSceneNode*>(largeTerrain)
+           ->loadHeightMapVector(makeHeightMap(LARGE_TERRAIN_SIZE),
+                                 xLoadScaling, zLoadScaling)) {
+    return true;
+  }
+  largeTerrain->setScale(irr::core::vector3df(LARGE_TERRAIN_SCALE, 1.0f,
+                                              LARGE_TERRAIN_SCALE));
+  largeTerrain->setVisible(false);
+  largeTerrainSelector =
+      new irr::scene::BCTerrainTriangleSelector(largeTerrain, 0);
+
+  // The cache iniWarm() reads, of the ini files iniCold() parses
+  irr::io::path absoluteData = fileSystem->getAbsolutePath(dataPath.c_str());
+  findIniFiles(fileSystem, absoluteData + "/Models");
+  findIniFiles(fileSystem, absoluteData + "/World");
+  fileSystem->changeWorkingDirectoryTo(workingDirectory);
+  if (iniFiles.empty()) return true;
+  IniFile::resetCache(INI_CACHE_DIR);
+  readIniFiles();
+  IniFile::saveCache();
+  return false;
+}
+
+void BenchmarkFixture::findIniFiles(irr::io::IFileSystem* fileSystem,
+                                    const irr::io::path& dir) {
+  if (!fileSystem->changeWorkingDirectoryTo(dir)) return;
+  irr::io::IFileList* list = fileSystem->createFileList();
+  for (irr::u32 i = 0; i < list->getFileCount(); i++) {
+    const irr::io::path& name = list->getFileName(i);
+    if (list->isDirectory(i)) {
+      if (name != "." && name != "..") {
+        findIniFiles(fileSystem, dir + "/" + name);
+      }
+    } else if (irr::core::hasFileExtension(name, "ini")) {
+      iniFiles.push_back((dir + "/" + name).c_str());
+    }
+  }
+  list->drop();
+}
+
+void BenchmarkFixture::readIniFiles() {
+  for (size_t i = 0; i < iniFiles.size(); i++) {
+    checksum += IniFile::iniFileTof32(iniFiles[i], "Depth");
+  }
+}
+
+void BenchmarkFixture::radarScan() {
+  RadarCalculation& radar = model->radarCalculation;
+  radar.scan(model->offsetPosition, model->terrain, model->ownShip,
+             model->buoys, model->otherShips, model->weather,
+             model->rainIntensity, model->tideHeight, deltaTime,
+             model->absoluteTime);
+}
+
+void BenchmarkFixture::radarRender() {
+  // As after a range change: every sector of every line is drawn again
+  RadarCalculation& radar = model->radarCalculation;
+  for (irr::u32 i = 0; i < radar.angularResolution; i++) {
+    radar.toReplot[i] = true;
+    for (irr::u32 j = 0; j < radar.rangeResolution; j++) {
+      radar.scanArrayToPlotPrevious[i][j] = -1.0;
+    }
+  }
+  radar.render(model->radarImage, model->radarImageOverlaid,
+               model->ownShip.getHeading(), model->ownShip.getSpeed());
+}
+
+void BenchmarkFixture::oceanWaves() {
+  waveTime += deltaTime;
+  ocean->evaluateWavesFFT(waveTime);
+  checksum += ocean->getVertices()[0].y;
+}
+
+void BenchmarkFixture::terrainHeight() {
+  irr::u32 i = nextHeight % GRID_SIZE;
+  irr::u32 j = (nextHeight / GRID_SIZE) % GRID_SIZE;
+  nextHeight++;
+  irr::f32 longitude = WORLD_LONG + WORLD_LONG_EXTENT * (i + 0.5f) / GRID_SIZE;
+  irr::f32 latitude = WORLD_LAT + WORLD_LAT_EXTENT * (j + 0.5f) / GRID_SIZE;
+  const Terrain& terrain = model->terrain;
+  checksum +=
+      terrain.getHeight(terrain.longToX(longitude), terrain.latToZ(latitude));
+}
+
+void BenchmarkFixture::tidalStream() {
+  // A grid of points for each minute of a day
+  irr::u32 i = nextStream % GRID_SIZE;
+  irr::u32 j = (nextStream / GRID_SIZE) % GRID_SIZE;
+  irr::u32 minute = (nextStream / (GRID_SIZE * GRID_SIZE)) % (24 * 60);
+  nextStream++;
+  irr::f32 longitude = WORLD_LONG + WORLD_LONG_EXTENT * (i + 0.5f) / GRID_SIZE;
+  irr::f32 latitude = WORLD_LAT + WORLD_LAT_EXTENT * (j + 0.5f) / GRID_SIZE;
+  irr::core::vector2df stream = model->tide.getTidalStream(
+      longitude, latitude, model->absoluteTime + 60 * minute);
+  checksum += stream.X + stream.Y;
+}
+
+void BenchmarkFixture::aisReport() {
+  irr::u32 ship = nextShip % model->getNumberOfOtherShips();
+  nextShip++;
+  std::string data;
+  int fillBits;
+  std::tie(data, fillBits) = AIS::generateClassAReport(model, ship);
+  checksum += data.size() + fillBits;
+}
+
+void BenchmarkFixture::nmeaSentences() {
+  nmeaTime += NMEA_INTERVAL;
+  device->getTimer()->setTime(nmeaTime);
+  nmea->updateNMEA();
+  nmea->clearQueue();
+}
+
+void BenchmarkFixture::nmeaSentencesLegacy() {
+  legacyNmeaTime += NMEA_INTERVAL;
+  legacyNmea->update(legacyNmeaTime);
+  legacyNmea->clearMessages();
+}
+
+void BenchmarkFixture::nmeaParse() {
+  const char* text = RECEIVED_SENTENCES[nextSentence % RECEIVED_SENTENCE_COUNT];
+  nextSentence++;
+  NMEAReceivedSentence sentence;
+  if (!sentence.parse(text, std::strlen(text))) return;
+  if (sentence.getFormatter() == NMEA_APB) {
+    APB apb;
+    if (NMEA::decodeAPB(sentence, apb)) checksum += apb.bearing_orig_to_dest;
+  } else if (sentence.getFormatter() == NMEA_RMB) {
+    RMB rmb;
+    if (NMEA::decodeRMB(sentence, rmb)) checksum += rmb.range_to_dest;
+  }
+}
+
+void BenchmarkFixture::nmeaParseLegacy() {
+  const char* text = RECEIVED_SENTENCES[nextSentence % RECEIVED_SENTENCE_COUNT];
+  nextSentence++;
+  APB apb;
+  RMB rmb;
+  switch (LegacyNMEA::parse(text, apb, rmb)) {
+    case LegacyNMEA::PARSED_APB:
+      checksum += apb.bearing_orig_to_dest;
+      break;
+    case LegacyNMEA::PARSED_RMB:
+      checksum += rmb.range_to_dest;
+      break;
+    default:
+      break;
+  }
+}
+
+void BenchmarkFixture::scenarioEncode() {
+  checksum += largeScenario.serialiseBinary().size();
+}
+
+void BenchmarkFixture::scenarioDecode() {
+  ScenarioData scenario;
+  scenario.deserialiseBinary(largeScenarioBinary);
+  checksum += scenario.otherShipsData.size();
+}
+
+void BenchmarkFixture::scenarioEncodeText() {
+  checksum += largeScenario.serialise().size();
+}
+
+void BenchmarkFixture::scenarioDecodeText() {
+  ScenarioData scenario;
+  scenario.deserialise(largeScenarioText);
+  checksum += scenario.otherShipsData.size();
+}
+
+void BenchmarkFixture::terrainRayLarge() {
+  // From a grid of points above the terrain, down at a slant, as a pick of
+  // the terrain from the bridge
+  irr::u32 i = nextRay % GRID_SIZE;
+  irr::u32 j = (nextRay / GRID_SIZE) % GRID_SIZE;
+  nextRay++;
+  const irr::core::aabbox3df& box = largeTerrain->getBoundingBox();
+  irr::core::vector3df start(
+      box.MinEdge.X + (box.MaxEdge.X - box.MinEdge.X) * (i + 0.5f) / GRID_SIZE,
+      box.MaxEdge.Y + 20.0f,
+      box.MinEdge.Z + (box.MaxEdge.Z - box.MinEdge.Z) * (j + 0.5f) / GRID_SIZE);
+  irr::core::line3df ray(
+      start, start + irr::core::vector3df(1500.0f, -300.0f, 700.0f));
+  irr::core::vector3df point;
+  irr::core::triangle3df triangle;
+  irr::scene::ISceneNode* node;
+  if (device->getSceneManager()->getSceneCollisionManager()->getCollisionPoint(
+          ray, largeTerrainSelector, point, triangle, node)) {
+    checksum += point.Y;
+  }
+}
+
+void BenchmarkFixture::iniCold() {
+  IniFile::resetCache(NO_INI_CACHE_DIR);
+  readIniFiles();
+}
+
+void BenchmarkFixture::iniWarm() {
+  IniFile::resetCache(INI_CACHE_DIR);
+  readIniFiles();
+}
+
+void BenchmarkFixture::ownShipDynamics() {
+  scenarioTime += deltaTime;
+  model->ownShip.update(deltaTime, scenarioTime, model->tideHeight,
+                        model->weather);
+  checksum += model->ownShip.getHeading();
+}
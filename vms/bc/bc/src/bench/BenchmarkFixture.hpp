@@ -0,0 +1,112 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __BENCHMARKFIXTURE_HPP_INCLUDED__
+#define __BENCHMARKFIXTURE_HPP_INCLUDED__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "../GUIMain.hpp"
+#include "../ScenarioDataStructure.hpp"
+#include "../Sound.hpp"
+#include "irrlicht.h"
+
+class cOcean;
+class Lang;
+class LegacyNMEA;
+class NMEA;
+class SimulationModel;
+
+// The model the benchmarks run on. A scenario is generated in the
+// SimpleEstuary world, with the own ship in the estuary and other ships on a
+// ring around it, and loaded with the GUI on the Irrlicht NULL device, so
+// nothing is drawn or needs a display. The timer is stopped, and only moved by
+// the benchmarks.
+//
+// Each of the step functions is one operation of a benchmark. They go through
+// the parts of the model on their own, which is why this is a friend of
+// SimulationModel and RadarCalculation. Running the same steps in the same
+// order does the same work every time, so runs can be compared.
+class BenchmarkFixture {
+ public:
+  BenchmarkFixture();
+  ~BenchmarkFixture();
+
+  // build the model from the Models and World in dataPath, returns true on
+  // error
+  bool load(const std::string& dataPath, irr::u32 otherShips);
+
+  void radarScan();          // one frame of the radar scan
+  void radarRender();        // redraw of the whole radar picture
+  void oceanWaves();         // one frame of the FFT wave field
+  void terrainHeight();      // height at the next point of a grid on the world
+  void tidalStream();        // stream at the next point and time of a grid
+  void aisReport();          // class A report of the next other ship
+  void nmeaSentences();      // sensor and AIS sentences of one report interval
+  void nmeaSentencesLegacy();  // the same by the code before NMEACodec
+  void nmeaParse();            // decode of the next received APB or RMB
+  void nmeaParseLegacy();      // the same by the code before NMEACodec
+  void ownShipDynamics();    // one frame of own ship motion
+  void scenarioEncode();     // SCN2 of a scenario of 1000 other ships
+  void scenarioDecode();
+  void scenarioEncodeText();  // the same scenario as SCN1 text
+  void scenarioDecodeText();
+  void terrainRayLarge();     // nearest hit of a ray on a 1025 x 1025 terrain
+  void iniCold();  // a key of each ini file of the Models and World, parsed
+  void iniWarm();  // the same from the ini cache
+
+  // of the results, so that the steps are not optimised away
+  irr::f32 getChecksum() const { return checksum; }
+
+  static ScenarioData makeScenario(irr::u32 otherShips);
+
+ private:
+  void findIniFiles(irr::io::IFileSystem* fileSystem, const irr::io::path& dir);
+  void readIniFiles();
+
+  irr::IrrlichtDevice* device;
+  Lang* language;
+  std::vector<std::string> logMessages;
+  GUIMain gui;
+  Sound sound;
+  SimulationModel* model;
+  cOcean* ocean;
+  NMEA* nmea;
+  LegacyNMEA* legacyNmea;
+  ScenarioData largeScenario;
+  std::string largeScenarioBinary;
+  std::string largeScenarioText;
+  irr::scene::ITerrainSceneNode* largeTerrain;
+  irr::scene::ITriangleSelector* largeTerrainSelector;
+  std::vector<std::string> iniFiles;  // absolute paths
+
+  irr::f32 deltaTime;  // of a frame at 60 fps
+  irr::f32 scenarioTime;
+  irr::f32 waveTime;
+  irr::u32 nmeaTime;
+  irr::u32 legacyNmeaTime;
+  irr::u32 nextSentence;
+  irr::u32 nextHeight;
+  irr::u32 nextStream;
+  irr::u32 nextShip;
+  irr::u32 nextRay;
+  irr::f32 checksum;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Compare bridgecommand-bench results with a baseline.
+
+Both files are written by bridgecommand-bench --json. The median time of an
+operation of each benchmark is compared, and a benchmark that has slowed by
+more than the threshold is a regression. The comparison is printed as JSON,
+and the exit status is 1 if there was a regression, so it can stop a build.
+
+    bridgecommand-bench --json baseline.json      (before the change)
+    bridgecommand-bench --json current.json       (after it)
+    compare_baseline.py baseline.json current.json --threshold 0.1
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_medians(file_name):
+    with open(file_name) as f:
+        results = json.load(f)
+    return {b["name"]: b["median_ns"] for b in results["benchmarks"]}
+
+
+def compare(baseline, current, threshold):
+    benchmarks = []
+    for name in sorted(set(baseline) | set(current)):
+        entry = {"name": name,
+                 "baseline_ns": baseline.get(name),
+                 "current_ns": current.get(name)}
+        if name not in current:
+            entry["status"] = "missing"
+        elif name not in baseline:
+            entry["status"] = "new"
+        else:
+            change = current[name] / baseline[name] - 1 if baseline[name] else 0
+            entry["change"] = round(change, 4)
+            if change > threshold:
+                entry["status"] = "regressed"
+            elif change < -threshold:
+                entry["status"] = "improved"
+            else:
+                entry["status"] = "unchanged"
+        benchmarks.append(entry)
+    return benchmarks
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="slowdown allowed, as a fraction (default 0.1)")
+    parser.add_argument("--output", help="write the comparison here as well")
+    args = parser.parse_args()
+
+    benchmarks = compare(load_medians(args.baseline),
+                         load_medians(args.current), args.threshold)
+    regressions = [b["name"] for b in benchmarks if b["status"] == "regressed"]
+    report = {"threshold": args.threshold,
+              "regressions": regressions,
+              "benchmarks": benchmarks}
+
+    text = json.dumps(report, indent=2)
+    print(text)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,189 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// Microbenchmarks of the simulation's hot paths, run headless on the
+// Irrlicht NULL device. Each benchmark times samples of a fixed number of
+// operations on a BenchmarkFixture, and reports the median time of an
+// operation. The results can be written as JSON, and compared with a baseline
+// by compare_baseline.py.
+//
+// bridgecommand-bench [--filter text] [--samples n] [--ships n]
+//                     [--data path] [--json file]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BenchmarkFixture.hpp"
+
+// Global definition for ini logger
+namespace IniFile {
+irr::ILogger* irrlichtLogger = 0;
+}
+
+namespace {
+
+struct Benchmark {
+  const char* name;
+  void (BenchmarkFixture::*step)();
+  irr::u32 operations;  // per sample, enough for a few milliseconds
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"radar_scan", &BenchmarkFixture::radarScan, 60},
+    {"radar_render", &BenchmarkFixture::radarRender, 4},
+    {"ocean_fft", &BenchmarkFixture::oceanWaves, 30},
+    {"terrain_height", &BenchmarkFixture::terrainHeight, 65536},
+    {"tidal_stream", &BenchmarkFixture::tidalStream, 16},
+    {"ais_class_a_report", &BenchmarkFixture::aisReport, 4000},
+    {"nmea_sentences", &BenchmarkFixture::nmeaSentences, 4000},
+    {"nmea_sentences_legacy", &BenchmarkFixture::nmeaSentencesLegacy, 4000},
+    {"nmea_parse", &BenchmarkFixture::nmeaParse, 20000},
+    {"nmea_parse_legacy", &BenchmarkFixture::nmeaParseLegacy, 20000},
+    {"own_ship_dynamics", &BenchmarkFixture::ownShipDynamics, 4},
+    {"scenario_encode", &BenchmarkFixture::scenarioEncode, 20},
+    {"scenario_decode", &BenchmarkFixture::scenarioDecode, 20},
+    {"scenario_encode_text", &BenchmarkFixture::scenarioEncodeText, 1},
+    {"scenario_decode_text", &BenchmarkFixture::scenarioDecodeText, 1},
+    {"terrain_ray_large", &BenchmarkFixture::terrainRayLarge, 8},
+    {"ini_cold", &BenchmarkFixture::iniCold, 4},
+    {"ini_warm", &BenchmarkFixture::iniWarm, 4}};
+
+struct BenchmarkResult {
+  std::string name;
+  irr::u32 operations;
+  double medianNs;  // per operation
+  double minNs;
+  double maxNs;
+};
+
+BenchmarkResult runBenchmark(BenchmarkFixture& fixture,
+                             const Benchmark& benchmark, irr::u32 samples) {
+  // One sample untimed, to warm the caches
+  for (irr::u32 i = 0; i < benchmark.operations; i++) {
+    (fixture.*benchmark.step)();
+  }
+
+  std::vector<double> times;
+  for (irr::u32 sample = 0; sample < samples; sample++) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (irr::u32 i = 0; i < benchmark.operations; i++) {
+      (fixture.*benchmark.step)();
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    times.push_back(elapsed.count() / benchmark.operations);
+  }
+  std::sort(times.begin(), times.end());
+
+  BenchmarkResult result;
+  result.name = benchmark.name;
+  result.operations = benchmark.operations;
+  result.medianNs = times[times.size() / 2];
+  result.minNs = times.front();
+  result.maxNs = times.back();
+  return result;
+}
+
+bool writeJson(const std::string& fileName,
+               const std::vector<BenchmarkResult>& results, irr::u32 samples,
+               irr::u32 otherShips) {
+  FILE* file = std::fopen(fileName.c_str(), "w");
+  if (!file) return true;
+  std::fprintf(file, "{\n  \"samples\": %u,\n  \"other_ships\": %u,\n",
+               samples, otherShips);
+  std::fprintf(file, "  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchmarkResult& result = results[i];
+    std::fprintf(file,
+                 "    {\"name\": \"%s\", \"operations\": %u, "
+                 "\"median_ns\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f}%s\n",
+                 result.name.c_str(), result.operations, result.medianNs,
+                 result.minNs, result.maxNs,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(file, "  ]\n}\n");
+  return std::fclose(file) != 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string filter;
+  std::string jsonFile;
+  std::string dataPath = BENCH_DATA_PATH;
+  irr::u32 samples = 11;
+  irr::u32 otherShips = 16;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << option << std::endl;
+      return 2;
+    }
+    std::string value = argv[++i];
+    if (option == "--filter") {
+      filter = value;
+    } else if (option == "--json") {
+      jsonFile = value;
+    } else if (option == "--data") {
+      dataPath = value;
+    } else if (option == "--samples") {
+      samples = std::max(1, std::atoi(value.c_str()));
+    } else if (option == "--ships") {
+      otherShips = std::max(1, std::atoi(value.c_str()));
+    } else {
+      std::cerr << "Unknown option " << option << std::endl;
+      return 2;
+    }
+  }
+
+  BenchmarkFixture fixture;
+  if (fixture.load(dataPath, otherShips)) {
+    std::cerr << "Could not load the benchmark model from " << dataPath
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<BenchmarkResult> results;
+  std::printf("%-20s %10s %14s %14s %14s\n", "benchmark", "ops", "median ns",
+              "min ns", "max ns");
+  for (size_t i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); i++) {
+    const Benchmark& benchmark = BENCHMARKS[i];
+    if (!filter.empty() && std::strstr(benchmark.name, filter.c_str()) == 0) {
+      continue;
+    }
+    BenchmarkResult result = runBenchmark(fixture, benchmark, samples);
+    std::printf("%-20s %10u %14.1f %14.1f %14.1f\n", result.name.c_str(),
+                result.operations, result.medianNs, result.minNs,
+                result.maxNs);
+    std::fflush(stdout);
+    results.push_back(result);
+  }
+  std::printf("checksum %g\n", fixture.getChecksum());
+
+  if (!jsonFile.empty() && writeJson(jsonFile, results, samples, otherShips)) {
+    std::cerr << "Could not write " << jsonFile << std::endl;
+    return 1;
+  }
+  return 0;
+}
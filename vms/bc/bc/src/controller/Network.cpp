@@ -16,6 +16,7 @@
 
 #include "Network.hpp"
 #include "ControllerModel.hpp"
+#include "../ScenarioDataStructure.hpp"
 #include "../Utilities.hpp"
 
 #include <iostream>
@@ -91,21 +92,19 @@ std::string Network::findWorldName()
 
     if (enet_host_service (server, & event, 10) > 0) {
         if (event.type == ENET_EVENT_TYPE_RECEIVE) {
-            //receive it
-            char tempString[8192]; //Fixme: Think if this is long enough
-            snprintf(tempString,8192,"%s",event.packet -> data);
-            std::string receivedString(tempString);
+            //receive it, binary scenario data may contain zeros, so use the packet length without the terminating zero
+            std::string receivedString;
+            if (event.packet -> dataLength > 0) {
+                receivedString.assign(reinterpret_cast<const char*>(event.packet -> data), event.packet -> dataLength - 1);
+            }
 
             //Basic checks
-            if (receivedString.length() > 4) { //Check if more than 2 chars long, ie we have at least some data
-                if (receivedString.substr(0,4).compare("SCN1") == 0 ) { //Check if it starts with SC
+            if (ScenarioData::isSerialised(receivedString)) { //Check if it starts with SCN1 or SCN2
 
-                    //Find world model from this
-                    std::vector<std::string> receivedData = Utilities::split(receivedString,'#');
-                    if (receivedData.size() > 2) {
-                        worldName = receivedData.at(2);
-                    }
-                }
+                //Find world model from this
+                ScenarioData scenarioData;
+                scenarioData.deserialise(receivedString);
+                worldName = scenarioData.worldName;
             }
 
             /* Clean up the packet now that we're done using it. */
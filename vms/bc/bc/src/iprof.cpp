@@ -3,60 +3,371 @@
 
 #include "iprof.hpp"
 
+#if defined(WITH_PROFILING) && !defined(DISABLE_IPROF)
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unordered_map>
+
 namespace InternalProfiler
 {
-iprof_thread_local Tree tree;
-iprof_thread_local std::vector<RawEntry> entries;
-iprof_thread_local Stats stats;
+iprof_thread_local ThreadBuffer* threadBuffer = nullptr;
+
+namespace
+{
+// Scope names, interned under their own lock so that interning never waits
+// for a collect()
+std::mutex scopeLock;
+std::unordered_map<std::string, ScopeId> scopeIds;
+std::vector<std::string> scopeNames;
+
+struct ThreadState
+{
+   ThreadBuffer* buffer;
+   /// Open scopes as seen by the collector
+   std::vector<Event> open;
+};
+
+// Everything below is only touched by collect() and the exporters
+std::mutex collectLock;
+std::vector<ThreadState> threads;
+uint32_t nextThreadId = 1;
+std::vector<ScopeStats> scopes;
+std::vector<TraceEvent> trace;
+size_t traceNext = 0;
+uint64_t unpaired = 0;
+uint64_t droppedByExited = 0;
 
-#ifndef DISABLE_IPROF_MULTITHREAD
-std::mutex allThreadStatLock;
-Stats allThreadStats;
+int highestBit(uint64_t v)
+{
+#ifdef __GNUC__
+   return 63 - __builtin_clzll(v);
+#else
+   int bit = 0;
+   while (v >>= 1)
+      ++bit;
+   return bit;
 #endif
+}
 
-void aggregateEntries()
+std::string scopeName(ScopeId scope)
 {
-   std::vector<RawEntry> unfinished;
-   if (entries.size() > 4)
-      unfinished.reserve(entries.size() >> 1);
-   for (auto ei : entries)
+   std::lock_guard<std::mutex> bouncer(scopeLock);
+   return scope < scopeNames.size() ? scopeNames[scope] : std::string("?");
+}
+
+void record(uint32_t threadId, const Event& begin, uint64_t end)
+{
+   if (begin.scope >= scopes.size())
    {
-      if (ei.start > ei.end)
+      std::lock_guard<std::mutex> bouncer(scopeLock);
+      size_t known = scopes.size();
+      scopes.resize(scopeNames.size());
+      for (size_t i = known; i < scopes.size(); ++i)
+         scopes[i].name = scopeNames[i];
+   }
+   uint64_t duration = end > begin.time ? end - begin.time : 0;
+   scopes[begin.scope].histogram.add(duration);
+
+   TraceEvent te{begin.time, duration, begin.scope, threadId};
+   if (trace.size() < TRACE_EVENTS)
+      trace.push_back(te);
+   else
+      trace[traceNext] = te;
+   traceNext = (traceNext + 1) % TRACE_EVENTS;
+}
+
+void drain(ThreadState& state)
+{
+   ThreadBuffer& b = *state.buffer;
+   uint64_t t = b.tail.load(std::memory_order_relaxed);
+   const uint64_t h = b.head.load(std::memory_order_acquire);
+   for (; t != h; ++t)
+   {
+      const Event& e = b.events[t & (ThreadBuffer::CAPACITY - 1)];
+      if (e.type == EVENT_BEGIN)
       {
-         unfinished.emplace_back(ei);
+         // a begin at depth d closes whatever was left open at d and below,
+         // which only happens if events were dropped
+         if (state.open.size() > e.depth)
+         {
+            unpaired += state.open.size() - e.depth;
+            state.open.resize(e.depth);
+         }
+         state.open.push_back(e);
          continue;
       }
-      Stat& s = stats[ei.tree];
-      ++s.numVisits;
-      s.totalTime += ei.end - ei.start;
+      if (state.open.size() == size_t(e.depth) + 1 && state.open.back().scope == e.scope)
+      {
+         record(b.threadId, state.open.back(), e.time);
+         state.open.pop_back();
+      }
+      else
+      {
+         ++unpaired;
+         if (state.open.size() > e.depth)
+            state.open.resize(e.depth);
+      }
    }
-   std::swap(entries, unfinished);
+   b.tail.store(t, std::memory_order_release);
 }
 
-#ifndef DISABLE_IPROF_MULTITHREAD
-void addThisThreadEntriesToAllThreadStats()
+/// Drains the buffer of a thread when it exits and frees it, so that
+/// threads which come and go do not leave their rings behind
+struct ThreadRetirer
 {
-   std::lock_guard<std::mutex> bouncer(allThreadStatLock);
-   iprof_thread_local static Stats lastStats;
-   for (auto& s : lastStats)
-      allThreadStats[s.first] -= s.second;
-   for (auto& s : stats)
-      allThreadStats[s.first] += s.second;
-   lastStats = stats;
+   ~ThreadRetirer()
+   {
+      if (!threadBuffer)
+         return;
+      std::lock_guard<std::mutex> bouncer(collectLock);
+      for (size_t i = 0; i < threads.size(); ++i)
+      {
+         if (threads[i].buffer != threadBuffer)
+            continue;
+         drain(threads[i]);
+         droppedByExited += threadBuffer->dropped.load();
+         threads.erase(threads.begin() + i);
+         break;
+      }
+      delete threadBuffer;
+      threadBuffer = nullptr;
+   }
+};
+iprof_thread_local ThreadRetirer retirer;
+}
+
+ScopeId intern(const char* name)
+{
+   std::lock_guard<std::mutex> bouncer(scopeLock);
+   auto it = scopeIds.find(name);
+   if (it != scopeIds.end())
+      return it->second;
+   ScopeId id = static_cast<ScopeId>(scopeNames.size());
+   scopeNames.push_back(name);
+   scopeIds.emplace(scopeNames.back(), id);
+   return id;
+}
+
+ThreadBuffer* registerThread()
+{
+   (void)&retirer;  // constructs it, so it runs at thread exit
+   std::lock_guard<std::mutex> bouncer(collectLock);
+   threadBuffer = new ThreadBuffer(nextThreadId++);
+   threads.push_back(ThreadState{threadBuffer, std::vector<Event>()});
+   return threadBuffer;
+}
+
+void Histogram::add(uint64_t ns)
+{
+   int bucket;
+   if (ns < (1u << SUB_BITS))
+      bucket = static_cast<int>(ns);
+   else
+   {
+      int msb = highestBit(ns);
+      bucket = ((msb - SUB_BITS + 1) << SUB_BITS) + static_cast<int>((ns >> (msb - SUB_BITS)) & ((1u << SUB_BITS) - 1));
+   }
+   ++counts[bucket];
+   ++count;
+   total += ns;
+   max = std::max(max, ns);
+}
+
+uint64_t Histogram::quantile(double q) const
+{
+   if (count == 0)
+      return 0;
+   uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+   uint64_t seen = 0;
+   for (int bucket = 0; bucket < BUCKETS; ++bucket)
+   {
+      seen += counts[bucket];
+      if (seen < rank)
+         continue;
+      if (bucket < (1 << SUB_BITS))
+         return bucket;
+      int msb = (bucket >> SUB_BITS) + SUB_BITS - 1;
+      uint64_t sub = (bucket & ((1 << SUB_BITS) - 1)) + (1u << SUB_BITS);
+      uint64_t upper = ((sub + 1) << (msb - SUB_BITS)) - 1;
+      return std::min(upper, max);
+   }
+   return max;
+}
+
+void collect()
+{
+   std::lock_guard<std::mutex> bouncer(collectLock);
+   for (auto& t : threads)
+      drain(t);
+}
+
+std::vector<ScopeStats> snapshot()
+{
+   std::lock_guard<std::mutex> bouncer(collectLock);
+   return scopes;
+}
+
+uint64_t droppedEvents()
+{
+   std::lock_guard<std::mutex> bouncer(collectLock);
+   uint64_t dropped = droppedByExited + unpaired;
+   for (auto& t : threads)
+      dropped += t.buffer->dropped.load();
+   return dropped;
+}
+
+size_t threadCount()
+{
+   std::lock_guard<std::mutex> bouncer(collectLock);
+   return threads.size();
+}
+
+namespace
+{
+void writeJsonString(std::ostream& os, const std::string& s)
+{
+   os << '"';
+   for (char c : s)
+   {
+      if (c == '"' || c == '\\')
+         os << '\\' << c;
+      else if (static_cast<unsigned char>(c) < 0x20)
+         os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+      else
+         os << c;
+   }
+   os << '"';
+}
+
+void writeLabel(std::ostream& os, const std::string& s)
+{
+   for (char c : s)
+   {
+      if (c == '"' || c == '\\')
+         os << '\\' << c;
+      else if (c == '\n')
+         os << "\\n";
+      else
+         os << c;
+   }
+}
 }
+
+bool writeChromeTrace(const std::string& path)
+{
+   std::vector<TraceEvent> events;
+   std::vector<std::string> names;
+   {
+      std::lock_guard<std::mutex> bouncer(collectLock);
+      events.reserve(trace.size());
+      // oldest first
+      size_t first = trace.size() < TRACE_EVENTS ? 0 : traceNext;
+      for (size_t i = 0; i < trace.size(); ++i)
+         events.push_back(trace[(first + i) % trace.size()]);
+      for (auto& s : scopes)
+         names.push_back(s.name);
+   }
+
+   std::ofstream os(path.c_str());
+   if (!os)
+      return false;
+   uint64_t origin = events.empty() ? 0 : events.front().start;
+   for (auto& e : events)
+      origin = std::min(origin, e.start);
+
+   os << "{\"traceEvents\":[";
+   bool first = true;
+   os << std::fixed << std::setprecision(3);
+   for (auto& e : events)
+   {
+      os << (first ? "\n" : ",\n") << "{\"name\":";
+      first = false;
+      writeJsonString(os, e.scope < names.size() ? names[e.scope] : scopeName(e.scope));
+      os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.threadId
+         << ",\"ts\":" << (e.start - origin) / 1000.0
+         << ",\"dur\":" << e.duration / 1000.0 << "}";
+   }
+   os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+   return static_cast<bool>(os);
+}
+
+bool writePrometheus(const std::string& path)
+{
+   std::vector<ScopeStats> stats = snapshot();
+   uint64_t dropped = droppedEvents();
+
+   std::string tmpPath = path + ".tmp";
+   {
+      std::ofstream os(tmpPath.c_str());
+      if (!os)
+         return false;
+      os << std::setprecision(9);
+      os << "# HELP bc_scope_duration_seconds Time spent in a profiled scope.\n"
+            "# TYPE bc_scope_duration_seconds summary\n";
+      for (auto& s : stats)
+      {
+         const Histogram& h = s.histogram;
+         if (h.count == 0)
+            continue;
+         const double quantiles[] = {0.5, 0.99};
+         for (double q : quantiles)
+         {
+            os << "bc_scope_duration_seconds{scope=\"";
+            writeLabel(os, s.name);
+            os << "\",quantile=\"" << q << "\"} " << h.quantile(q) * 1e-9 << "\n";
+         }
+         os << "bc_scope_duration_seconds_sum{scope=\"";
+         writeLabel(os, s.name);
+         os << "\"} " << h.total * 1e-9 << "\n";
+         os << "bc_scope_duration_seconds_count{scope=\"";
+         writeLabel(os, s.name);
+         os << "\"} " << h.count << "\n";
+      }
+      os << "# HELP bc_scope_duration_max_seconds Longest time spent in a profiled scope.\n"
+            "# TYPE bc_scope_duration_max_seconds gauge\n";
+      for (auto& s : stats)
+      {
+         if (s.histogram.count == 0)
+            continue;
+         os << "bc_scope_duration_max_seconds{scope=\"";
+         writeLabel(os, s.name);
+         os << "\"} " << s.histogram.max * 1e-9 << "\n";
+      }
+      os << "# HELP bc_profiler_dropped_events_total Profiler events lost to full buffers.\n"
+            "# TYPE bc_profiler_dropped_events_total counter\n"
+            "bc_profiler_dropped_events_total " << dropped << "\n";
+      if (!os)
+         return false;
+   }
+#ifdef _WIN32
+   // rename does not replace an existing file here
+   remove(path.c_str());
 #endif
+   return rename(tmpPath.c_str(), path.c_str()) == 0;
 }
 
-std::ostream& operator<<(std::ostream& os, const InternalProfiler::Stats& stats)
+void writeSummary(std::ostream& os)
 {
-   for (auto si : stats)
+   std::vector<ScopeStats> stats = snapshot();
+   os << "WHAT: AVG (P50 / P99 / MAX) TIMES_EXECUTED\n";
+   for (auto& s : stats)
    {
-      for (auto& ti : si.first)
-         os << ti << (&ti != &si.first.back() ? "/" : "");
-      if (si.first.capacity() < si.first.size())
-         os << "/...(" << si.first.size() - si.first.capacity() << ")";
-      os << ": " << MICRO_SECS(si.second.totalTime) / float(si.second.numVisits)
-         << " (" << MICRO_SECS(si.second.totalTime) << " / " << si.second.numVisits << ")\n";
+      const Histogram& h = s.histogram;
+      if (h.count == 0)
+         continue;
+      os << s.name << ": " << h.total / 1000.0 / h.count
+         << " (" << h.quantile(0.5) / 1000.0 << " / " << h.quantile(0.99) / 1000.0
+         << " / " << h.max / 1000.0 << ") " << h.count << "\n";
    }
-   return os;
+   uint64_t dropped = droppedEvents();
+   if (dropped)
+      os << "(" << dropped << " events dropped)\n";
+}
 }
+
+#endif
@@ -3,22 +3,19 @@
 
 #pragma once
 
-#ifndef DISABLE_IPROF
+// Only built with WITH_PROFILING, otherwise IPROF and IPROF_FUNC are empty
+// and there is nothing to link
+#if defined(WITH_PROFILING) && !defined(DISABLE_IPROF)
 
 #if (defined(_MSC_VER) && (_MSC_VER < 1916)) || defined(EMSCRIPTEN) || defined(CC_TARGET_OS_IPHONE) || defined(__ANDROID__)
 #define DISABLE_IPROF_MULTITHREAD
 #endif
 
-#ifndef DISABLE_IPROF_OPTIM
 #include <stdint.h>
-#include <string.h>
-#endif
 
-#include <map>
-#ifndef DISABLE_IPROF_MULTITHREAD
-#include <mutex>
-#endif
+#include <atomic>
 #include <ostream>
+#include <string>
 #include <vector>
 
 #include "hitime.hpp"
@@ -30,141 +27,160 @@
 #define iprof_thread_local thread_local
 #endif
 
+/// Continuous profiler.
+///
+/// Every IPROF scope interns its name once into a ScopeId and then only
+/// appends timestamped begin and end events to a ring buffer of its thread.
+/// The ring is allocated on the thread's first scope and freed when the
+/// thread exits.
+/// The rings have a single producer and a single consumer, so recording
+/// takes no lock. A full ring drops events rather than block.
+///
+/// collect() drains the rings of all threads, pairs begins with ends and
+/// adds the durations to a histogram per scope. The last TRACE_EVENTS
+/// scopes are also kept for a Chrome trace-event export. Call collect()
+/// regularly, e.g. once per frame, so the rings do not fill up.
 namespace InternalProfiler
 {
-/// A faster (for storing within a vector) but limited vector<const char *>
-#ifndef DISABLE_IPROF_OPTIM
-class Tree
-{
-public:
-   typedef uint16_t size_type;
-   typedef const char* value_type;
-
-protected:
-   static const int MAX_DEPTH = 15;
-   // Should make sizeof(RawEntry) == 64 (15*4+2+2) for 32bit systems
-   // and compilers will align it to 128 for 64 bit systems.
-   value_type tree[MAX_DEPTH];
-   size_type fill = 0;
-   size_type osize = 0;  ///< size with overflow
-
-public:
-   size_type size() const
-   {
-      return osize;
-   }
+/// Index of a scope name in snapshot()
+typedef uint32_t ScopeId;
 
-   size_type capacity() const
-   {
-      return fill;
-   }
+/// Returns the id of a scope name. Ids are handed out in order of first
+/// use, and equal names from anywhere share one, as they are looked up by
+/// their text. Takes a lock, so IPROF only calls it once per call site.
+ScopeId intern(const char* name);
 
-   void push_back(value_type node)
-   {
-      ++osize;
-      if (fill >= MAX_DEPTH)
-         return;
-      tree[fill++] = node;
-      return;
-   }
+struct Event
+{
+   uint64_t time;   ///< ns on HighResClock
+   ScopeId scope;
+   uint16_t depth;  ///< nesting depth of the scope on its thread
+   uint16_t type;
+};
 
-   void pop_back()
-   {
-      if (--osize < MAX_DEPTH)
-         --fill;
-   }
+enum EventType
+{
+   EVENT_BEGIN,
+   EVENT_END
+};
+
+/// Events of one thread, written by that thread only and read by collect()
+struct ThreadBuffer
+{
+   /// Power of two. 256 kB, several frames of events between collects.
+   static const uint32_t CAPACITY = 1 << 14;
 
-   const value_type* begin() const { return tree; }
-   const value_type* end() const { return tree + fill; }
-   const value_type& back() const { return *(tree + fill - 1); }
+   ThreadBuffer(uint32_t tid) : head(0), tail(0), cachedTail(0), depth(0), dropped(0), threadId(tid) {}
 
-   bool operator==(const Tree& a) const
-   {
-      return size() == a.size() && 0 == memcmp(tree, a.tree, sizeof(value_type) * fill);
-   }
+   std::atomic<uint64_t> head;
+   std::atomic<uint64_t> tail;
+   uint64_t cachedTail;  ///< producer's last look at tail
+   uint16_t depth;
+   std::atomic<uint64_t> dropped;
+   const uint32_t threadId;
+   Event events[CAPACITY];
 
-   bool operator<(const Tree& a) const
+   void push(ScopeId scope, uint16_t eventDepth, EventType type)
    {
-      if (size() < a.size())
-         return true;
-      else if (size() > a.size())
-         return false;
-      // We are just comparing pointer values here.
-      // The perfect correctness of this depends on compiler putting all
-      // string literals (const char *) under the same pointer, which is
-      // not guaranteed under the specification, thus inline functions
-      // might be a problem for this, and might be threated as different
-      // functions when looked at from different translation units.
-      return memcmp(tree, a.tree, sizeof(value_type) * fill) < 0;
+      uint64_t h = head.load(std::memory_order_relaxed);
+      if (h - cachedTail >= CAPACITY)
+      {
+         cachedTail = tail.load(std::memory_order_acquire);
+         if (h - cachedTail >= CAPACITY)
+         {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+         }
+      }
+      Event& e = events[h & (CAPACITY - 1)];
+      e.time = std::chrono::duration_cast<std::chrono::nanoseconds>(HighResClock::now().time_since_epoch()).count();
+      e.scope = scope;
+      e.depth = eventDepth;
+      e.type = type;
+      head.store(h + 1, std::memory_order_release);
    }
 };
-#else
-typedef std::vector<const char*> Tree;
-#endif
 
-struct RawEntry
+/// The calling thread's buffer, registered on first use. At exit the
+/// thread drains it into the histograms itself and frees it.
+ThreadBuffer* registerThread();
+extern iprof_thread_local ThreadBuffer* threadBuffer;
+
+inline void Begin(ScopeId scope)
 {
-   Tree tree;
-   HighResClock::time_point start;
-   HighResClock::time_point end;
-};
+   ThreadBuffer* b = threadBuffer;
+   if (!b)
+      b = registerThread();
+   b->push(scope, b->depth++, EVENT_BEGIN);
+}
+inline void End(ScopeId scope)
+{
+   ThreadBuffer* b = threadBuffer;
+   b->push(scope, --b->depth, EVENT_END);
+}
 
-struct Stat
+struct ScopedMeasure
 {
-   HighResClock::duration totalTime = HighResClock::duration::zero();
-   size_t numVisits = 0;
-   Stat& operator+=(const Stat& a)
-   {
-      totalTime += a.totalTime;
-      numVisits += a.numVisits;
-      return *this;
-   }
-   Stat& operator-=(const Stat& a)
-   {
-      totalTime -= a.totalTime;
-      numVisits -= a.numVisits;
-      return *this;
-   }
+   ScopeId scope;
+   ScopedMeasure(ScopeId s) : scope(s) { Begin(scope); }
+   ~ScopedMeasure() { End(scope); }
 };
 
-extern iprof_thread_local Tree tree;
-extern iprof_thread_local std::vector<RawEntry> entries;
-typedef std::map<Tree, Stat> Stats;   // we lack hashes for unordered
-extern iprof_thread_local Stats stats;
+/// Durations of a scope in a log-linear histogram: 8 buckets per power of
+/// two, so quantiles are within 12.5% of the true value.
+struct Histogram
+{
+   static const int SUB_BITS = 3;
+   static const int BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
 
-#ifndef DISABLE_IPROF_MULTITHREAD
-extern std::mutex allThreadStatLock;
-extern Stats allThreadStats;
-#endif
+   uint64_t counts[BUCKETS] = {};
+   uint64_t count = 0;
+   uint64_t total = 0;  ///< ns
+   uint64_t max = 0;    ///< ns
 
-void aggregateEntries();
-void addThisThreadEntriesToAllThreadStats();
+   void add(uint64_t ns);
+   /// Upper bound of the bucket holding quantile q, at most max
+   uint64_t quantile(double q) const;
+};
 
-inline void Begin(const char* node)
+struct ScopeStats
 {
-   tree.push_back(node);
-   auto now = HighResClock::now();
-   RawEntry re{tree, now, now - HighResClock::duration(1)};
-   entries.emplace_back(re);
-}
-inline void End()
-{
-   auto s = tree.size();
-   auto rei = entries.rbegin();
-   while (rei->tree.size() != s)
-      ++rei;
-   rei->end = HighResClock::now();
-   tree.pop_back();
-}
+   std::string name;
+   Histogram histogram;
+};
 
-struct ScopedMeasure
+/// A scope that ended, for the trace
+struct TraceEvent
 {
-   ScopedMeasure(const char* node) { Begin(node); }
-   ~ScopedMeasure() { End(); }
+   uint64_t start;  ///< ns on HighResClock
+   uint64_t duration;
+   ScopeId scope;
+   uint32_t threadId;
 };
-}
 
-std::ostream& operator<<(std::ostream& os, const InternalProfiler::Stats& stats);
+static const size_t TRACE_EVENTS = 1 << 18;
+
+/// Drains the rings of all threads into the histograms and the trace
+void collect();
+
+/// Copy of the histograms of all scopes seen so far, indexed by ScopeId
+std::vector<ScopeStats> snapshot();
+/// Events dropped because a ring was full and scopes dropped for not
+/// pairing up as a result
+uint64_t droppedEvents();
+/// Threads holding a ring, those that have run a scope and not exited
+size_t threadCount();
+
+/// Writes the kept scopes as Chrome trace-event JSON (chrome://tracing,
+/// Perfetto), returns false on error
+bool writeChromeTrace(const std::string& path);
+/// Writes p50, p99, max, sum and count per scope in the Prometheus text
+/// format. The file is replaced atomically, so it can be read by the
+/// node exporter textfile collector. Returns false on error.
+bool writePrometheus(const std::string& path);
+/// Prints a line per scope, in microseconds
+void writeSummary(std::ostream& os);
+}
 
 #ifndef __FUNCTION_NAME__
 # ifdef _MSC_VER
@@ -174,8 +190,14 @@ std::ostream& operator<<(std::ostream& os, const InternalProfiler::Stats& stats)
 # endif
 #endif
 
-#define IPROF(n) InternalProfiler::ScopedMeasure InternalProfiler__##__COUNTER__(n)
-#define IPROF_FUNC InternalProfiler::ScopedMeasure InternalProfiler__##__COUNTER__(__FUNCTION_NAME__)
+#define IPROF_CONCAT_(a, b) a##b
+#define IPROF_CONCAT(a, b) IPROF_CONCAT_(a, b)
+#define IPROF_SCOPE_(n, id) \
+   static const InternalProfiler::ScopeId id = InternalProfiler::intern(n); \
+   InternalProfiler::ScopedMeasure IPROF_CONCAT(id, _measure)(id)
+
+#define IPROF(n) IPROF_SCOPE_(n, IPROF_CONCAT(InternalProfiler__, __LINE__))
+#define IPROF_FUNC IPROF_SCOPE_(__FUNCTION_NAME__, IPROF_CONCAT(InternalProfiler__, __LINE__))
 
 #else
 
@@ -21,6 +21,8 @@
 #include <string>
 
 #include "AIVDMSender.hpp"
+#include "CoSimMaster.hpp"
+#include "FlightRecorder.hpp"
 #include "NetworkController.hpp"
 #ifdef WITH_PROFILING
 #include "iprof.hpp"
@@ -32,6 +34,7 @@
 #include <asio.hpp>  // To display hostname
 #include <cstdlib>   // For rand(), srand()
 #include <fstream>   // To save to log
+#include <random>
 #include <sstream>
 #include <vector>
 
@@ -545,6 +548,23 @@ int main(int argc, char **argv) {
     std::cout << "Using Ini file >" << iniFilename << "<" << std::endl;
   }
 
+  // Replay a flight record instead of running the simulator, see
+  // FlightRecorder.hpp
+  bool replaying = false;
+  FlightReplayer replayer;
+
+  char **replay_arg =
+      std::min(std::find(argv, argv_end, std::string("-r")),
+               std::find(argv, argv_end, std::string("--replay")));
+  if (replay_arg < argv_end && ++replay_arg < argv_end) {
+    replaying = true;
+    if (replayer.open(std::string(*replay_arg))) {
+      std::cerr << "Could not read the flight record " << *replay_arg
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
 #ifdef __arm__
   if (IniFile::iniFileTou32(iniFilename, "PA_ALSA_PLUGHW") == 1) {
     setenv("PA_ALSA_PLUGHW", "1", true);
@@ -598,9 +618,24 @@ int main(int argc, char **argv) {
   irr::u32 limitTerrainResolution = IniFile::iniFileTou32(
       iniFilename,
       "max_terrain_resolution");  // Default of zero means unlimited
+  irr::u32 loadThreads = IniFile::iniFileTou32(
+      iniFilename, "load_threads",
+      4);  // Zero loads the world on the main thread alone
 
   irr::core::vector3di numberOfContactPoints(
       numberOfContactPointsX, numberOfContactPointsY, numberOfContactPointsZ);
+
+  if (replaying) {
+    // Build the model as it was recorded. The replay does not draw, so has no
+    // shaders, which only change how the water looks.
+    const FlightLogSetup &setup = replayer.get_setup();
+    disableShaders = 1;
+    waterSegments = setup.water_segments;
+    numberOfContactPoints.set(setup.contact_points[0],
+                              setup.contact_points[1],
+                              setup.contact_points[2]);
+    limitTerrainResolution = setup.limit_terrain_resolution;
+  }
   // Initial view configuration
   irr::f32 viewAngle = IniFile::iniFileTof32(
       iniFilename, "view_angle");  // Horizontal field of view
@@ -811,6 +846,10 @@ int main(int argc, char **argv) {
     }
   }
 
+  if (replaying) {
+    deviceParameters.DriverType = irr::video::EDT_NULL;
+  }
+
   deviceParameters.WindowSize =
       irr::core::dimension2d<irr::u32>(graphicsWidth, graphicsHeight);
   deviceParameters.Bits = graphicsDepth;
@@ -821,6 +860,16 @@ int main(int argc, char **argv) {
   // Start paused initially
   device->getTimer()->setSpeed(0.0);
 
+  // In lockstep with the autopilot the timer only moves on when the
+  // co-simulation master steps it, from here on
+  CoSimMaster cosim(device,
+                    IniFile::iniFileTou32(iniFilename, "LockstepStep", 50),
+                    IniFile::iniFileTof32(iniFilename, "LockstepSpeed", 0.0),
+                    IniFile::iniFileTou32(iniFilename, "LockstepClients", 1));
+  if (IniFile::iniFileTou32(iniFilename, "Lockstep") == 1 && !replaying) {
+    cosim.open();
+  }
+
   // On Windows, redirect console stderr to log file
   std::string userLog = userFolder + "log.txt";
   std::cout << "User log file is " << userLog << std::endl;
@@ -921,11 +970,12 @@ int main(int argc, char **argv) {
   Sound sound;
 
   OperatingMode::Mode mode = OperatingMode::Normal;
-  if (IniFile::iniFileTou32(iniFilename, "secondary_mode") == 1) {
+  if (IniFile::iniFileTou32(iniFilename, "secondary_mode") == 1 &&
+      !replaying) {
     mode = OperatingMode::Secondary;
   }
 
-  if (mode == OperatingMode::Normal) {
+  if (mode == OperatingMode::Normal && !replaying) {
     ScenarioChoice scenarioChoice(device, &language);
     if (!skipScenarioChoice) {
       scenarioChoice.chooseScenario(scenarioName, hostname, udpPort, mode,
@@ -1002,8 +1052,15 @@ int main(int argc, char **argv) {
   device->getGUIEnvironment()->drawAll();
   driver->endScene();
 
+  // The replay runs on the recorded times from the recorded start on
+  if (replaying) {
+    device->getTimer()->stop();
+    device->getTimer()->setTime(replayer.get_setup().start_time);
+  }
+  irr::u32 startTime = device->getTimer()->getTime();
+
   // seed random number generator
-  std::srand(device->getTimer()->getTime());
+  std::srand(startTime);
 
   // create GUI
   GUIMain guiMain;
@@ -1012,12 +1069,16 @@ int main(int argc, char **argv) {
   // Create networking, linked to model, choosing whether to use main or
   // secondary network mode
   Network *network = Network::createNetwork(mode, udpPort, device);
+  network->setLegacyScenarioFormat(
+      IniFile::iniFileTou32(iniFilename, "legacy_scenario_format") == 1);
   // Network network(&model);
   network->connectToServer(hostname);
 
   // Read in scenario data (work in progress)
   ScenarioData scenarioData;
-  if (mode == OperatingMode::Normal) {
+  if (replaying) {
+    scenarioData.deserialiseBinary(replayer.get_scenario());
+  } else if (mode == OperatingMode::Normal) {
     scenarioData = Utilities::getScenarioDataFromFile(
         scenarioPath + scenarioName, scenarioName);
   } else {
@@ -1054,7 +1115,41 @@ int main(int argc, char **argv) {
   SimulationModel model(device, smgr, &guiMain, &sound, scenarioData, mode,
                         viewAngle, lookAngle, cameraMinDistance,
                         cameraMaxDistance, disableShaders, waterSegments,
-                        numberOfContactPoints, limitTerrainResolution);
+                        numberOfContactPoints, limitTerrainResolution,
+                        loadThreads);
+
+  // Sensor noise is repeatable in lockstep, and in recorded runs
+  std::string flightRecordFile =
+      IniFile::iniFileToString(iniFilename, "FlightRecordFile");
+  if (replaying) {
+    model.setNoiseSeed(replayer.get_setup().noise_seed);
+  } else if (cosim.is_enabled()) {
+    model.setNoiseSeed(IniFile::iniFileTou32(iniFilename, "LockstepSeed", 1));
+  }
+
+  // Record every step of the model, to replay with --replay
+  FlightRecorder flightRecorder(device);
+  if (!replaying && !flightRecordFile.empty()) {
+    FlightLogSetup setup = FlightLogSetup();
+    setup.start_time = startTime;
+    setup.noise_seed =
+        cosim.is_enabled()
+            ? IniFile::iniFileTou32(iniFilename, "LockstepSeed", 1)
+            : std::random_device()();
+    setup.water_segments = waterSegments;
+    setup.limit_terrain_resolution = limitTerrainResolution;
+    setup.contact_points[0] = numberOfContactPoints.X;
+    setup.contact_points[1] = numberOfContactPoints.Y;
+    setup.contact_points[2] = numberOfContactPoints.Z;
+    model.setNoiseSeed(setup.noise_seed);
+    if (!flightRecorder.open(flightRecordFile, setup,
+                             model.getSerialisedScenario())) {
+      model.setFlightRecorder(&flightRecorder);
+    }
+  }
+
+  // everything needed to start is loaded, keep it for the next start
+  IniFile::saveCache();
 
   // Load the gui
   bool hideEngineAndRudder = false;
@@ -1070,6 +1165,24 @@ int main(int argc, char **argv) {
   // Give the network class a pointer to the model
   network->setModel(&model);
 
+  // Run the recorded steps as fast as the model goes, without networking,
+  // sound or drawing, and check that they end up where they did
+  if (replaying) {
+    uint64_t divergent = replayer.run(device, &model);
+    std::cout << "Replayed " << replayer.get_frame_count() << " frames in "
+              << replayer.get_run_seconds() << " s";
+    if (divergent == 0) {
+      std::cout << ", all as recorded" << std::endl;
+    } else {
+      std::cout << ", " << divergent
+                << " differ from the record, the first at loop "
+                << replayer.get_first_divergence() << std::endl;
+    }
+    delete network;
+    device->drop();
+    return divergent == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   // load realistic water
   // RealisticWaterSceneNode* realisticWater = new RealisticWaterSceneNode(smgr,
   // 4000, 4000, "./",irr::core::dimension2du(512,
@@ -1089,6 +1202,8 @@ int main(int argc, char **argv) {
   //  nmeaUDPAddressName, nmeaUDPPortName, nmeaUDPListenPortName, device);
 
   // create Controller for communication with BcProxy
+  std::string proxy_transport =
+      IniFile::iniFileToString(iniFilename, "ProxyTransport");
   std::string controller_snd_addr =
       IniFile::iniFileToString(iniFilename, "SensorProxyAddress");
   std::string controller_snd_port =
@@ -1096,13 +1211,15 @@ int main(int argc, char **argv) {
   std::string controller_rcv_port =
       IniFile::iniFileToString(iniFilename, "ActuatorProxyPort");
   NetworkController dds_controller(&model, device, controller_snd_addr,
-                                   controller_snd_port, controller_rcv_port);
+                                   controller_snd_port, controller_rcv_port,
+                                   proxy_transport, cosim.get_channel());
 
   std::string aivdm_snd_addr =
       IniFile::iniFileToString(iniFilename, "AivdmProxyAddress");
   std::string aivdm_snd_port =
       IniFile::iniFileToString(iniFilename, "AivdmProxyPort");
-  AivdmSender aivdm_to_dds(&model, device, aivdm_snd_addr, aivdm_snd_port);
+  AivdmSender aivdm_to_dds(&model, device, aivdm_snd_addr, aivdm_snd_port,
+                           proxy_transport, cosim.get_channel());
 
   // Load sound files
   sound.load(model.getOwnShipEngineSound(), model.getOwnShipWaveSound(),
@@ -1149,6 +1266,16 @@ int main(int argc, char **argv) {
   //    Profiler renderProfile("3d render");
   //    Profiler guiProfile("GUI render");
   //    Profiler renderFinishProfile("Render finish");
+#ifdef WITH_PROFILING
+  // the profiler runs continuously, these export what it gathered
+  std::string profileMetricsFile =
+      IniFile::iniFileToString(iniFilename, "ProfileMetricsFile");
+  std::string profileTraceFile =
+      IniFile::iniFileToString(iniFilename, "ProfileTraceFile");
+  irr::u32 profileMetricsInterval =
+      1000 * IniFile::iniFileTou32(iniFilename, "ProfileMetricsInterval", 10);
+  irr::u32 lastProfileMetrics = device->getTimer()->getRealTime();
+#endif
 
   sound.StartSound();
 
@@ -1158,6 +1285,18 @@ int main(int argc, char **argv) {
 
   // main loop
   while (device->run()) {
+    // in lockstep the frame only runs the simulation once the autopilot is
+    // done with the current time
+    bool stepped = cosim.step();
+#ifdef WITH_PROFILING
+    InternalProfiler::collect();
+    if (!profileMetricsFile.empty() &&
+        device->getTimer()->getRealTime() - lastProfileMetrics >=
+            profileMetricsInterval) {
+      lastProfileMetrics = device->getTimer()->getRealTime();
+      InternalProfiler::writePrometheus(profileMetricsFile);
+    }
+#endif
     {
       IPROF("Network");
       //        networkProfile.tic();
@@ -1168,7 +1307,7 @@ int main(int argc, char **argv) {
       // Update NMEA, check if new sensor or AIS data is ready to be sent
       //        nmeaProfile.tic();
     }
-    {
+    if (stepped) {
       IPROF("NMEA");
       // send sensor values to the BC-DDS proxy
       dds_controller.send_report();
@@ -1200,7 +1339,7 @@ int main(int argc, char **argv) {
 
       //        modelProfile.tic();
     }
-    {
+    if (stepped) {
       IPROF("Model");
       model.update();
       //        modelProfile.toc();
@@ -1209,6 +1348,8 @@ int main(int argc, char **argv) {
 
       //        renderSetupProfile.tic();
     }
+    // lockstep can run far faster than the display
+    if (!cosim.render_due(stepped)) continue;
     {
       IPROF("Render setup");
       driver->setViewPort(irr::core::rect<irr::s32>(
@@ -1264,6 +1405,9 @@ int main(int argc, char **argv) {
         // drawAll3dProfile.tic();
         smgr->drawAll();
         // drawAll3dProfile.toc();
+        // This animates the water the ships float on, so the replay needs
+        // to know
+        flightRecorder.mark_drawn();
       }
 
       //       renderProfile.toc();
@@ -1291,14 +1435,23 @@ int main(int argc, char **argv) {
   }
 
 #ifdef WITH_PROFILING
-  InternalProfiler::aggregateEntries();
+  InternalProfiler::collect();
 
   std::cout << "\nThe profiler stats so far:\n"
-               "WHAT: AVG_TIME (TOTAL_TIME / TIMES_EXECUTED)"
-               "\nAll times in micro seconds\n"
-            << InternalProfiler::stats << std::endl;
+               "All times in micro seconds\n";
+  InternalProfiler::writeSummary(std::cout);
+  std::cout << std::endl;
+  if (!profileMetricsFile.empty()) {
+    InternalProfiler::writePrometheus(profileMetricsFile);
+  }
+  if (!profileTraceFile.empty() &&
+      !InternalProfiler::writeChromeTrace(profileTraceFile)) {
+    device->getLogger()->log("Could not write the profiler trace");
+  }
 #endif
 
+  flightRecorder.close();
+
   // networking should be stopped (presumably with destructor when it goes out
   // of scope?)
   device->getLogger()->log("About to stop network");
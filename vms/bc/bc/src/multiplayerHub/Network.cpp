@@ -141,7 +141,7 @@ void Network::sendString(std::string stringToSend, bool reliable, unsigned int p
 
         if (stringToSend.length() > 0) {
             ENetPacket * packet = enet_packet_create (stringToSend.c_str(),
-            strlen (stringToSend.c_str()) + 1,
+            stringToSend.size() + 1, //Scenario data is binary, so may contain zeros
             reliableFlag); //Flag
 
             // Send the packet to peer over channel id 0.
@@ -136,6 +136,7 @@ int main()
     irr::u32 graphicsHeight = IniFile::iniFileTou32(iniFilename, "graphics_height");
     irr::u32 graphicsDepth = IniFile::iniFileTou32(iniFilename, "graphics_depth");
     int port = IniFile::iniFileTou32(iniFilename, "udp_send_port");
+    bool legacyScenarioFormat = IniFile::iniFileTou32(iniFilename, "legacy_scenario_format") == 1; //SCN1 text for secondaries older than SCN2
 
     //Sensible defaults if not set
     irr::IrrlichtDevice *nulldevice = irr::createDevice(irr::video::EDT_NULL);
@@ -255,7 +256,11 @@ int main()
             thisPeerData.otherShipsData.erase(thisPeerData.otherShipsData.begin()+thisPeer);
 
             //Send initial scenario information (reliable packet)
-            network.sendString(thisPeerData.serialise(),true,thisPeer);
+            if (legacyScenarioFormat) {
+                network.sendString(thisPeerData.serialise(),true,thisPeer);
+            } else {
+                network.sendString(thisPeerData.serialiseBinary(),true,thisPeer);
+            }
 
             //Store the data for this peer
             peerScenarioData.push_back(thisPeerData);
@@ -0,0 +1,67 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __CHECK_HPP_INCLUDED__
+#define __CHECK_HPP_INCLUDED__
+
+// Checks for the tests in this directory. A failed check reports where it
+// failed and the test carries on, main() then returns the exit status ctest
+// expects.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace BcTest {
+
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+// nanoseconds per call of f over n calls
+template <typename F>
+double timePerCall(int n, F f) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) f(i);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / n;
+}
+
+}  // namespace BcTest
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                   #condition);                                             \
+      ++::BcTest::failures();                                               \
+    }                                                                       \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                       \
+  do {                                                                    \
+    double checkA = (a), checkB = (b);                                    \
+    if (!(std::fabs(checkA - checkB) <= (tolerance))) {                   \
+      std::fprintf(stderr, "%s:%d: check failed: %s = %.9g, %s = %.9g\n", \
+                   __FILE__, __LINE__, #a, checkA, #b, checkB);           \
+      ++::BcTest::failures();                                             \
+    }                                                                     \
+  } while (0)
+
+#endif
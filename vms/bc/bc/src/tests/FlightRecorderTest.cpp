@@ -0,0 +1,215 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// A run of the SimpleEstuary model with other ships, commands from a proxy
+// and drawn frames, recorded as main.cpp records it and replayed on a model
+// built from the log alone: every step replays to bit identical states, the
+// replay of a model turned a little diverges, and recording a frame costs
+// little beside the update it records.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../FlightRecorder.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 OTHER_SHIPS = 8;
+const irr::u32 FRAMES = 600;
+const irr::u32 NOISE_SEED = 46;
+const irr::u32 COMMAND_INTERVAL = 40;  // frames
+const irr::u32 DRAW_INTERVAL = 3;      // frames
+
+// frames timed with and without the recorder, in rounds
+const irr::u32 OVERHEAD_ROUNDS = 5;
+const irr::u32 OVERHEAD_FRAMES = 50;
+
+const char* const LOG_FILE = "flight-recorder-test.log";
+const char* const OVERHEAD_LOG_FILE = "flight-recorder-test-overhead.log";
+
+// as SimulationFixture builds the model
+FlightLogSetup fixtureSetup() {
+  FlightLogSetup setup = FlightLogSetup();
+  setup.start_time = 0;
+  setup.noise_seed = NOISE_SEED;
+  setup.water_segments = 32;
+  setup.limit_terrain_resolution = 0;
+  setup.contact_points[0] = 10;
+  setup.contact_points[1] = 30;
+  setup.contact_points[2] = 30;
+  return setup;
+}
+
+ActuatorCommands command(irr::u32 n) {
+  ActuatorCommands commands = ActuatorCommands();
+  commands.rudder_angle = (n % 2 == 0) ? 20.0 - n : -15.0 + n;
+  commands.engine_throttle_port = 0.9 - 0.1 * (n % 4);
+  commands.engine_throttle_stbd = 0.6 + 0.1 * (n % 3);
+  commands.thruster_throttle_bow = (n % 3 == 0) ? 0.5 : 0.0;
+  return commands;
+}
+
+// frames of uneven length, commanded now and then, drawn as main.cpp draws
+// them, which animates the water
+void runFrames(SimulationFixture& fixture, FlightRecorder* recorder,
+               irr::u32 frames) {
+  SimulationModel* model = fixture.getModel();
+  irr::scene::ISceneManager* smgr = fixture.getDevice()->getSceneManager();
+  irr::video::IVideoDriver* driver = fixture.getDevice()->getVideoDriver();
+  for (irr::u32 i = 0; i < frames; i++) {
+    if (i % COMMAND_INTERVAL == 0) {
+      model->applyActuatorCommands(command(i / COMMAND_INTERVAL));
+    }
+    fixture.advance(15 + i % 4);
+    if (i % DRAW_INTERVAL == 0) {
+      driver->beginScene(true, true, irr::video::SColor(255, 0, 0, 0));
+      model->setMainCameraActive();
+      smgr->drawAll();
+      driver->endScene();
+      if (recorder) recorder->mark_drawn();
+    }
+  }
+}
+
+// builds a model from the log and replays it, returns the frames that differ
+uint64_t replay(const std::string& dataPath, bool perturb,
+                FlightReplayer& replayer) {
+  CHECK(!replayer.open(LOG_FILE));
+  ScenarioData scenario;
+  scenario.deserialiseBinary(replayer.get_scenario());
+  SimulationFixture fixture;
+  CHECK(!fixture.load(dataPath, scenario));
+  if (!fixture.getModel()) return 0;
+  CHECK(replayer.get_setup().start_time ==
+        fixture.getDevice()->getTimer()->getTime());
+  fixture.getModel()->setNoiseSeed(replayer.get_setup().noise_seed);
+  if (perturb) {
+    fixture.getModel()->setHeading(fixture.getModel()->getHeading() + 0.01f);
+  }
+  return replayer.run(fixture.getDevice(), fixture.getModel());
+}
+
+// nanoseconds of the fastest round of frames
+double timeFrames(SimulationFixture& fixture) {
+  double fastest = 0;
+  for (irr::u32 round = 0; round < OVERHEAD_ROUNDS; round++) {
+    double perFrame = BcTest::timePerCall(
+        OVERHEAD_FRAMES, [&](int) { fixture.advance(16); });
+    fastest = (round == 0) ? perFrame : std::min(fastest, perFrame);
+  }
+  return fastest;
+}
+
+void testRecordReplay(const std::string& dataPath) {
+  FlightOwnShipState recordedOwnShip;
+  std::vector<FlightShipState> recordedOtherShips;
+  {
+    SimulationFixture fixture;
+    CHECK(!fixture.load(dataPath,
+                        SimulationFixture::makeScenario(OTHER_SHIPS)));
+    if (!fixture.getModel()) return;
+    SimulationModel* model = fixture.getModel();
+    model->setNoiseSeed(NOISE_SEED);
+    FlightRecorder recorder(fixture.getDevice());
+    CHECK(!recorder.open(LOG_FILE, fixtureSetup(),
+                         model->getSerialisedScenario()));
+    model->setFlightRecorder(&recorder);
+    runFrames(fixture, &recorder, FRAMES);
+    model->setFlightRecorder(0);
+    CHECK(recorder.get_frame_count() == FRAMES);
+    recorder.close();
+    model->getFlightState(recordedOwnShip, recordedOtherShips);
+  }
+
+  FlightReplayer replayer;
+  uint64_t divergent = replay(dataPath, false, replayer);
+  std::printf("%llu frames replayed in %.3f s, %llu differ\n",
+              (unsigned long long)replayer.get_frame_count(),
+              replayer.get_run_seconds(), (unsigned long long)divergent);
+  CHECK(replayer.get_frame_count() == FRAMES);
+  CHECK(divergent == 0);
+  CHECK(replayer.get_first_divergence() == 0);
+
+  // a hundredth of a degree of heading the run did not have shows from the
+  // first frame on
+  FlightReplayer perturbed;
+  divergent = replay(dataPath, true, perturbed);
+  std::printf("perturbed: %llu differ, the first at loop %u\n",
+              (unsigned long long)divergent,
+              perturbed.get_first_divergence());
+  CHECK(divergent > 0);
+  CHECK(perturbed.get_first_divergence() == 1);
+
+  // the own ship went somewhere, so the replay had something to match
+  CHECK(recordedOtherShips.size() == OTHER_SHIPS);
+  CHECK(recordedOwnShip.scenario_time > 9.0f);
+  std::remove(LOG_FILE);
+}
+
+void testOverhead(const std::string& dataPath) {
+  SimulationFixture fixture;
+  CHECK(!fixture.load(dataPath, SimulationFixture::makeScenario(OTHER_SHIPS)));
+  if (!fixture.getModel()) return;
+  SimulationModel* model = fixture.getModel();
+  runFrames(fixture, 0, COMMAND_INTERVAL);  // past the first, slow, updates
+
+  FlightRecorder recorder(fixture.getDevice());
+  CHECK(!recorder.open(OVERHEAD_LOG_FILE, fixtureSetup(),
+                       model->getSerialisedScenario()));
+  double without = 0;
+  double with = 0;
+  // alternately, so that both see the same machine
+  for (irr::u32 i = 0; i < 2; i++) {
+    double plain = timeFrames(fixture);
+    without = (i == 0) ? plain : std::min(without, plain);
+    model->setFlightRecorder(&recorder);
+    double recorded = timeFrames(fixture);
+    with = (i == 0) ? recorded : std::min(with, recorded);
+    model->setFlightRecorder(0);
+  }
+
+  // the recorder's own part of a frame, on the real model's states
+  double recording = 0;
+  for (irr::u32 round = 0; round < OVERHEAD_ROUNDS; round++) {
+    double perFrame =
+        BcTest::timePerCall(OVERHEAD_FRAMES * 20, [&](int i) {
+          recorder.begin_frame(i, 1.0f);
+          recorder.end_frame(*model);
+        });
+    recording = (round == 0) ? perFrame : std::min(recording, perFrame);
+  }
+  recorder.close();
+  std::remove(OVERHEAD_LOG_FILE);
+
+  std::printf("%.0f ns a frame, %.0f ns recorded, %.0f ns of recording\n",
+              without, with, recording);
+  // a small part of a frame, and nothing like a second update
+  CHECK(recording < without * 0.05);
+  CHECK(with < without * 1.5);
+}
+
+}  // namespace
+
+void testFlightRecorder(const std::string& dataPath) {
+  testRecordReplay(dataPath);
+  testOverhead(dataPath);
+}
@@ -0,0 +1,133 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// The GUI of a loaded model on the NULL driver, given the same GUIData frame
+// after frame: once the widgets show it, an unchanged state sets none of
+// them, a change sets only what shows it, and a widget the user moves is set
+// back.
+
+#include <cstdio>
+#include <string>
+
+#include "../GUIMain.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 OTHER_SHIPS = 4;
+const irr::u32 UNCHANGED_FRAMES = 20;
+
+// a ship under way with the radar on, as SimulationModel::update() fills it
+GUIData makeGuiData() {
+  GUIData data = GUIData();
+  data.lat = 50.0347f;
+  data.longitude = -9.974f;
+  data.hdg = 251.3f;
+  data.spd = 4.1f;
+  data.portEng = 0.6f;
+  data.stbdEng = 0.55f;
+  data.rudder = 4.2f;
+  data.wheel = 5.0f;
+  data.RateOfTurn = 0.002f;
+  data.depth = 16.8f;
+  data.weather = 3;
+  data.rain = 2;
+  data.visibility = 8;
+  data.radarOn = true;
+  data.radarRangeNm = 3;
+  data.radarGain = 50;
+  data.radarClutter = 20;
+  data.radarRain = 10;
+  data.guiRadarEBLBrg = 30;
+  data.guiRadarEBLRangeNm = 1.5f;
+  data.guiRadarCursorBrg = 45;
+  data.guiRadarCursorRangeNm = 2;
+  data.currentTime = "10:00:00 01 Jan 2015";
+  data.pump1On = true;
+  data.tideHeight = 1.2f;
+  return data;
+}
+
+// widgets set to show data and draw it, as a frame of main.cpp does
+irr::u32 showFrame(SimulationFixture& fixture, GUIData& data) {
+  irr::video::IVideoDriver* driver = fixture.getDevice()->getVideoDriver();
+  fixture.getGui().updateGuiData(&data);
+  driver->beginScene(true, true, irr::video::SColor(255, 0, 0, 0));
+  fixture.getGui().drawGUI();
+  driver->endScene();
+  return fixture.getGui().getWidgetUpdates();
+}
+
+irr::gui::IGUIScrollBar* findScrollBar(SimulationFixture& fixture,
+                                       irr::s32 id) {
+  irr::gui::IGUIElement* element = fixture.getDevice()
+                                       ->getGUIEnvironment()
+                                       ->getRootGUIElement()
+                                       ->getElementFromId(id, true);
+  return element && element->getType() == irr::gui::EGUIET_SCROLL_BAR
+             ? static_cast<irr::gui::IGUIScrollBar*>(element)
+             : 0;
+}
+
+}  // namespace
+
+void testGUIBinding(const std::string& dataPath) {
+  SimulationFixture fixture;
+  CHECK(!fixture.load(dataPath, SimulationFixture::makeScenario(OTHER_SHIPS)));
+  if (!fixture.getModel()) return;
+  // the model's own data first, then ours
+  fixture.advance(100);
+  GUIData data = makeGuiData();
+  irr::u32 firstUpdates = showFrame(fixture, data);
+  std::printf("%u widget updates to show the data\n", firstUpdates);
+  CHECK(firstUpdates > 0);
+
+  irr::u32 unchangedUpdates = 0;
+  for (irr::u32 i = 0; i < UNCHANGED_FRAMES; i++) {
+    unchangedUpdates += showFrame(fixture, data);
+  }
+  std::printf("%u widget updates in %u unchanged frames\n", unchangedUpdates,
+              UNCHANGED_FRAMES);
+  CHECK(unchangedUpdates == 0);
+
+  // within the rounding of the scroll bars, and of what the text shows
+  data.portEng += 0.001f;
+  data.rudder += 0.1f;
+  CHECK(showFrame(fixture, data) == 0);
+
+  // a new heading moves its scroll bar, the other widgets are left alone
+  irr::gui::IGUIScrollBar* heading =
+      findScrollBar(fixture, GUIMain::GUI_ID_HEADING_SCROLL_BAR);
+  CHECK(heading != 0);
+  data.hdg = 260;
+  irr::u32 headingUpdates = showFrame(fixture, data);
+  std::printf("%u widget updates for a new heading\n", headingUpdates);
+  CHECK(headingUpdates > 0);
+  CHECK(headingUpdates < firstUpdates / 2);
+  if (heading) CHECK(heading->getPos() == 260);
+  CHECK(showFrame(fixture, data) == 0);
+
+  // moved by the user, and set back to the model's value on the next frame
+  if (heading) {
+    heading->setPos(100);
+    CHECK(showFrame(fixture, data) == 1);
+    CHECK(heading->getPos() == 260);
+    CHECK(showFrame(fixture, data) == 0);
+  }
+}
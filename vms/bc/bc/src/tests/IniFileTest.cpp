@@ -0,0 +1,178 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The ini store and its cache: UTF-8 in values and paths, files taken from
+// the cache while their time and size are unchanged, cache entries found by
+// the absolute path whatever the working directory, and a damaged or
+// unreadable cache file falling back to parsing the files.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../IniFile.hpp"
+#include "Check.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+// a directory and a file name in UTF-8, as a user's ship might have
+const char* const SHIP_DIR = "\xc3\x85lesund \xe2\x98\x83";
+const char* const SHIP_FILE = "b\xc3\xb8" "at.ini";
+
+// the same size each time, so only the time tells a change
+std::string shipIni(int speed) {
+  return "Name=\"\xc3\x85lesund ferry\"\nSPEED=" + std::to_string(speed) +
+         "\nWidth=3.5\n";
+}
+
+void writeFile(const std::string& path, const std::string& text) {
+  std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+  file << text;
+}
+
+// rewrites the file and puts its modification time back
+void writeKeepingTime(const std::string& path, const std::string& text) {
+  struct stat info;
+  CHECK(stat(path.c_str(), &info) == 0);
+  writeFile(path, text);
+  struct timespec times[2] = {info.st_atim, info.st_mtim};
+  CHECK(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+}
+
+void setTime(const std::string& path, time_t seconds) {
+  struct timespec times[2] = {{seconds, 0}, {seconds, 0}};
+  CHECK(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+}
+
+struct TempDir {
+  std::string path;  // with a trailing slash
+  std::vector<std::string> files;
+  std::vector<std::string> dirs;
+
+  TempDir() {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") +
+                          "/bc-ini-test-XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    if (mkdtemp(&name[0])) path = std::string(&name[0]) + "/";
+  }
+  ~TempDir() {
+    for (size_t i = 0; i < files.size(); i++) std::remove(files[i].c_str());
+    for (size_t i = dirs.size(); i > 0; i--) rmdir(dirs[i - 1].c_str());
+    if (!path.empty()) rmdir(path.c_str());
+  }
+  std::string addDir(const std::string& name) {
+    std::string dir = path + name + "/";
+    mkdir(dir.c_str(), 0700);
+    dirs.push_back(dir);
+    return dir;
+  }
+  std::string addFile(const std::string& name, const std::string& text) {
+    writeFile(path + name, text);
+    files.push_back(path + name);
+    return path + name;
+  }
+};
+
+void checkValues(const std::string& fileName) {
+  CHECK(IniFile::iniFileToString(fileName, "name") ==
+        "\xc3\x85lesund ferry");
+  CHECK(IniFile::iniFileToWString(fileName, "Name") == L"Ålesund ferry");
+  CHECK(IniFile::iniFileTof32(fileName, "width") == 3.5f);
+  CHECK(IniFile::iniFileTou32(fileName, "missing", 7) == 7);
+}
+
+}  // namespace
+
+void testIniFile(const std::string& dataPath) {
+  TempDir temp;
+  CHECK(!temp.path.empty());
+  if (temp.path.empty()) return;
+  char workingDirectory[4096];
+  CHECK(getcwd(workingDirectory, sizeof(workingDirectory)) != 0);
+
+  const std::string shipDir = temp.addDir(SHIP_DIR);
+  const std::string otherDir = temp.addDir("other");
+  const std::string shipPath =
+      temp.addFile(std::string(SHIP_DIR) + "/" + SHIP_FILE, shipIni(12));
+  const std::string otherPath =
+      temp.addFile(std::string("other/") + SHIP_FILE, shipIni(20));
+  setTime(shipPath, 1000000000);
+  setTime(otherPath, 1000000000);
+  temp.files.push_back(temp.path + "ini.cache");
+
+  // parsed, with UTF-8 in the path and the values
+  IniFile::resetCache(temp.path);
+  checkValues(shipPath);
+  CHECK(IniFile::iniFileTou32(shipPath, "speed") == 12);
+  IniFile::saveCache();
+  std::ifstream cache((temp.path + "ini.cache").c_str(), std::ios::binary);
+  char magic[4] = {0, 0, 0, 0};
+  cache.read(magic, sizeof(magic));
+  CHECK(std::string(magic, 4) == "BCIC");
+  cache.close();
+
+  // taken from the cache while the time and size are unchanged, here under a
+  // relative name from another working directory
+  writeKeepingTime(shipPath, shipIni(13));
+  IniFile::resetCache(temp.path);
+  CHECK(chdir(shipDir.c_str()) == 0);
+  checkValues(SHIP_FILE);
+  CHECK(IniFile::iniFileTou32(SHIP_FILE, "speed") == 12);
+
+  // the same relative name in another directory is another file, even with
+  // the same time and size
+  CHECK(chdir(otherDir.c_str()) == 0);
+  IniFile::resetCache(temp.path);
+  CHECK(IniFile::iniFileTou32(SHIP_FILE, "speed") == 20);
+  CHECK(chdir(workingDirectory) == 0);
+
+  // parsed again once the time changes
+  setTime(shipPath, 1000000100);
+  IniFile::resetCache(temp.path);
+  CHECK(IniFile::iniFileTou32(shipPath, "speed") == 13);
+  IniFile::saveCache();
+
+  // a damaged cache is parsed past, and replaced on the next save
+  writeFile(temp.path + "ini.cache", "BCIC\x02\x00\x00\x00\xff\xff\xff\xff");
+  IniFile::resetCache(temp.path);
+  checkValues(shipPath);
+  CHECK(IniFile::iniFileTou32(shipPath, "speed") == 13);
+  IniFile::saveCache();
+  cache.open((temp.path + "ini.cache").c_str(), std::ios::binary);
+  cache.seekg(0, std::ios::end);
+  CHECK(cache.tellg() > 16);
+  cache.close();
+
+  // a cache that can't be read, here a directory in its place
+  const std::string unreadable = temp.addDir("unreadable");
+  temp.addDir("unreadable/ini.cache");
+  IniFile::resetCache(unreadable);
+  checkValues(shipPath);
+  CHECK(IniFile::iniFileTou32(shipPath, "speed") == 13);
+  IniFile::saveCache();
+
+  IniFile::resetCache();
+}
@@ -0,0 +1,340 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "LegacyNMEA.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+#include "../AIS.hpp"
+#include "../Constants.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "../Utilities.hpp"
+
+namespace {
+
+const int maxSentenceChars =
+    79 + 1 + 1;  // iaw EN 61162-1:2011 + start char + null termination
+const irr::u32 sensorReportInterval = 100;
+const int maxMessages = (NMEA::DPT - NMEA::RMC) + 1;
+const char northing[2] = {'N', 'S'};
+const char easting[2] = {'E', 'W'};
+
+std::string addChecksum(std::string messageIn) {
+  char checksumBuffer[3];
+  // Get checksum
+  unsigned char checksum = 0;
+  irr::u8 s = messageIn.length();
+  for (int i = 1; i < s; i++) {
+    checksum ^= messageIn.at(i);
+  }
+  snprintf(checksumBuffer, sizeof(checksumBuffer), "%02X", checksum);
+  return messageIn + "*" + std::string(checksumBuffer) + "\r\n";
+}
+
+// the old APB and RMB held std::strings
+void copyText(char* target, const std::string& text) {
+  std::strncpy(target, text.c_str(), NMEA_TEXT_LENGTH - 1);
+  target[NMEA_TEXT_LENGTH - 1] = '\0';
+}
+
+}  // namespace
+
+LegacyNMEA::LegacyNMEA(SimulationModel* model)
+    : model(model), lastSendEvent(0), currentMessageType(0) {}
+
+void LegacyNMEA::update(irr::u32 now) {
+  // AIS messages are scheduled based on amount of otherShips and their speed
+  // check each frame if a new report should be sent
+  {
+    std::string messageToSend = "";
+    // which ships are ready to send?
+    std::vector<irr::u32> readyShips = AIS::getReadyShips(model, now);
+    for (auto ship : readyShips) {
+      std::string data;
+      int fillBits;
+      std::tie(data, fillBits) = AIS::generateClassAReport(model, ship);
+      messageToSend.append(aivdmSentence(data, fillBits));
+      if (messageToSend.length() >
+          800) {  // ensure we don't build too big of a UDP packet
+        messages.push_back(messageToSend);
+        messageToSend = "";
+      }
+    }
+    readyShips.clear();
+    if (messageToSend != "") {
+      messages.push_back(messageToSend);
+    }
+  }
+
+  // if sufficient time elapsed since the last sensor report was sent,
+  // construct and send sentence(s) for the next sensor
+  if (now - lastSendEvent < sensorReportInterval) {
+    return;
+  }
+  std::string messageToSend =
+      sensorSentences(model, (NMEA::NMEAMessage)currentMessageType);
+  if (messageToSend != "") messages.push_back(messageToSend);
+
+  lastSendEvent = now;
+
+  currentMessageType += 1;
+  currentMessageType %= maxMessages;
+}
+
+std::string LegacyNMEA::aivdmSentence(const std::string& payload,
+                                      int fillBits) {
+  char messageBuffer[maxSentenceChars] = {0};
+  // 8.3.90 AIS VHF data-link message (6-bit, iaw ITU-R M.1371)
+  // Position Report Class A
+  int fragments = 1;
+  int fragmentNumber = 1;
+  char radioChannel = 'B';
+  snprintf(messageBuffer, maxSentenceChars, "!AIVDM,%d,%d,,%c,%s,%d",
+           fragments, fragmentNumber, radioChannel, payload.c_str(),
+           fillBits);
+  return addChecksum(std::string(messageBuffer));
+}
+
+std::string LegacyNMEA::sensorSentences(SimulationModel* model,
+                                        NMEA::NMEAMessage type) {
+  char messageBuffer[maxSentenceChars] = {0};
+
+  std::string dateTimeString = Utilities::ttos(model->getTimestamp());
+
+  std::string dateString = dateTimeString.substr(0, 8);
+  std::string timeString = dateTimeString.substr(8, 6);
+
+  // kept, where the old code took c_str() of the temporaries
+  std::string yearString = dateString.substr(0, 4);
+  std::string monString = dateString.substr(4, 2);
+  std::string mdayString = dateString.substr(6, 2);
+  std::string hourString = timeString.substr(0, 4);
+  std::string minString = timeString.substr(4, 2);
+  std::string secString = timeString.substr(6, 2);
+  const char* year = yearString.c_str();
+  const char* mon = monString.c_str();
+  const char* mday = mdayString.c_str();
+  const char* hour = hourString.c_str();
+  const char* min = minString.c_str();
+  const char* sec = secString.c_str();
+
+  irr::f32 rudderAngle = model->getRudder();
+
+  int engineRPM[] = {
+      Utilities::round(model->getStbdEngineRPM()),  // idx=1, odd (starboard)
+      Utilities::round(model->getPortEngineRPM())   // idx=2, even (port)
+  };
+
+  irr::f32 lat = model->getLat();
+  irr::f32 lon = model->getLong();
+
+  irr::f32 cog = model->getCOG();
+  irr::f32 sog = model->getSOG() * MPS_TO_KTS;
+
+  irr::f32 hdg = model->getHeading();
+  irr::f32 rot = model->getRateOfTurn() * RAD_PER_S_IN_DEG_PER_MINUTE;
+
+  irr::f32 depth = model->getDepth();
+
+  char eastWest = easting[lon < 0];
+  char northSouth = northing[lat < 0];
+
+  lat = fabs(lat);
+  lon = fabs(lon);
+  irr::f32 latMinutes = (lat - (int)lat) * 60;
+  irr::f32 lonMinutes = (lon - (int)lon) * 60;
+  irr::u8 latDegrees = (int)lat;
+  irr::u8 lonDegrees = (int)lon;
+
+  std::string messageToSend = "";
+  switch (type) {  // EN 61162-1:2011
+    case NMEA::RMC:  // 8.3.69 Recommended minimum navigation information
+      snprintf(messageBuffer, maxSentenceChars,
+               "$GPRMC,%s%s%s.00,A,%02u%06.3f,%c,%03u%06.3f,%c,%.1f,%.1f,%s%s%"
+               "s,,,A,S",
+               hour, min, sec, latDegrees, latMinutes, northSouth, lonDegrees,
+               lonMinutes, eastWest, sog, cog, year, mon, mday);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::GLL:  // 8.3.36 Geographic position – Latitude/longitude
+      snprintf(messageBuffer, maxSentenceChars,
+               "$GPGLL,%02u%06.3f,%c,%03u%06.3f,%c,%s%s%s.00,A,A", latDegrees,
+               latMinutes, northSouth, lonDegrees, lonMinutes, eastWest, hour,
+               min, sec);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::GGA:  // 8.3.35 Global positioning system (GPS) fix data
+      snprintf(
+          messageBuffer, maxSentenceChars,
+          "$GPGGA,%s%s%s.00,%02u%06.3f,%c,%03u%06.3f,%c,1,12,0.0,0.0,M,0.0,M,,",
+          hour, min, sec, latDegrees, latMinutes, northSouth, lonDegrees,
+          lonMinutes, eastWest);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::RSA:  // 8.3.73 Rudder sensor angle
+      snprintf(messageBuffer, maxSentenceChars, "$IIRSA,%.1f,A,,V",
+               rudderAngle);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::RPM:  // 8.3.72 Revolutions
+      for (int i = 0; i < 2; i++) {
+        snprintf(messageBuffer, maxSentenceChars, "$IIRPM,S,%d,%d,100,A", i + 1,
+                 engineRPM[i]);
+        messageToSend.append(addChecksum(std::string(messageBuffer)));
+      }
+      break;
+    case NMEA::TTM:  // 8.3.85 Tracked target message
+      for (irr::u32 i = 0; i < model->getARPATracks(); i++) {
+        ARPAContact contact = model->getARPATrack(i);
+        ARPAEstimatedState state = contact.estimate;
+        snprintf(messageBuffer, maxSentenceChars,
+                 "$RATTM,%02d,%.1f,%.1f,T,%.1f,%.1f,T,%.1f,%.1f,N,TGT%02d,T,,"
+                 "%s.00,A",
+                 state.displayID - 1, state.range, state.bearing, state.speed,
+                 state.absHeading, state.cpa, state.tcpa, state.displayID - 1,
+                 timeString.c_str());
+        messageToSend.append(addChecksum(std::string(messageBuffer)));
+      }
+      break;
+    case NMEA::ZDA:  // 8.3.106 Time and date
+      snprintf(messageBuffer, maxSentenceChars,
+               "$RAZDA,%s%s%s.00,%s,%s,%s,00,00", hour, min, sec, mday, mon,
+               year);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::DTM:  // 8.3.27 Datum reference
+      snprintf(messageBuffer, maxSentenceChars, "$RADTM,W84,,,,,,,");
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::HEHDT:  // 8.3.44 Heading true
+      snprintf(messageBuffer, maxSentenceChars, "$HEHDT,%.1f,T", hdg);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::GPHDT:  // 8.3.44 Heading true
+      snprintf(messageBuffer, maxSentenceChars, "$GPHDT,%.1f,T", hdg);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::DPT:  // Depth
+      snprintf(messageBuffer, maxSentenceChars, "$SDDPT,%.1f,,", depth);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::TIROT:  // 8.3.71 Rate of turn
+      snprintf(messageBuffer, maxSentenceChars, "$TIROT,%.1f,A", rot);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::GPROT:  // 8.3.71 Rate of turn
+      snprintf(messageBuffer, maxSentenceChars, "$GPROT,%.1f,A", rot);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+    case NMEA::HEROT:  // 8.3.71 Rate of turn
+      snprintf(messageBuffer, maxSentenceChars, "$HEROT,%.1f,A", rot);
+      messageToSend = addChecksum(std::string(messageBuffer));
+      break;
+  }
+  return messageToSend;
+}
+
+LegacyNMEA::ParseResult LegacyNMEA::parse(const std::string& sentence,
+                                          APB& apb, RMB& rmb) {
+  if (sentence.length() < 10) return REJECTED;
+
+  // parse the provided checksum and verify it
+  irr::u32 providedChecksum;
+  irr::u32 checksum;
+  try {
+    providedChecksum =
+        std::stoi(sentence.substr(sentence.length() - 2, 2), 0, 16);
+    checksum = sentence.at(1);
+    for (auto character : sentence.substr(2, sentence.length() - 5))
+      checksum ^= character;
+    if (checksum != providedChecksum) return REJECTED;
+  } catch (const std::invalid_argument& e) {
+    return REJECTED;
+  } catch (const std::out_of_range& e) {
+    return REJECTED;
+  }
+
+  // construct vector of fields
+  std::vector<std::string> fields;
+  char last_char;
+  std::string field = "";
+  for (size_t i = 7; i < sentence.length(); i++) {
+    last_char = sentence[i];
+    if (last_char == '*') break;
+    if (last_char == ',') {
+      fields.push_back(field);
+      field = "";
+    } else {
+      field += last_char;
+    }
+  }
+  fields.push_back(field);
+
+  std::string type = sentence.substr(0, 1);
+  if (type.compare("$")) return REJECTED;         // AIS or not a sentence
+  if (!sentence.substr(1, 1).compare("P")) return REJECTED;  // proprietary
+
+  std::string id = sentence.substr(3, 3);
+  try {
+    if (!id.compare("APB")) {  // autopilot sentence B
+      if (fields.size() != 14) return REJECTED;  // we expect exactly 14 fields
+      apb.status = fields[0][0];
+      apb.warning = fields[1][0];
+      apb.cross_track_error = std::stof(fields[2]);
+      apb.direction = fields[3][0];
+      apb.cross_track_units = fields[4][0];
+      apb.arrival_circle_entered = fields[5][0];
+      apb.perpendicular_passed = fields[6][0];
+      apb.bearing_orig_to_dest = std::stof(fields[7]);
+      apb.bearing_orig_to_dest_type = fields[8][0];
+      copyText(apb.dest_waypoint_id, fields[9]);
+      apb.bearing_to_dest = std::stof(fields[10]);
+      apb.bearing_orig_to_dest_type = fields[11][0];
+      apb.heading_to_dest = std::stof(fields[12]);
+      apb.heading_to_dest_type = fields[13][0];
+      return PARSED_APB;
+    } else if (!id.compare("RMB")) {  // recommended minimum navigation
+                                      // information B
+      if (fields.size() != 13 && fields.size() != 14)
+        return REJECTED;  // 13 or 14 fields based on NMEA version
+      rmb.status = fields[0][0];
+      rmb.cross_track_error = std::stof(fields[1]);
+      rmb.direction = fields[2][0];
+      copyText(rmb.dest_waypoint_id, fields[3]);
+      copyText(rmb.orig_waypoint_id, fields[4]);
+      copyText(rmb.dest_waypoint_latitude, fields[5]);
+      rmb.dest_waypoint_latitude_dir = fields[6][0];
+      copyText(rmb.dest_waypoint_longitude, fields[7]);
+      rmb.dest_waypoint_longitude_dir = fields[8][0];
+      rmb.range_to_dest = std::stof(fields[9]);
+      rmb.bearing_to_dest = std::stof(fields[10]);
+      rmb.dest_closing_velocity = std::stof(fields[11]);
+      rmb.arrival_status = fields[12][0];
+      rmb.faa_mode = '\0';
+      if (fields.size() == 14) rmb.faa_mode = fields[13][0];
+      return PARSED_RMB;
+    }
+  } catch (const std::invalid_argument& e) {
+    return REJECTED;
+  } catch (const std::out_of_range& e) {
+    return THREW;
+  }
+  return REJECTED;
+}
@@ -0,0 +1,62 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __LEGACYNMEA_HPP_INCLUDED__
+#define __LEGACYNMEA_HPP_INCLUDED__
+
+#include <string>
+#include <vector>
+
+#include "../NMEA.hpp"
+#include "../NMEASentences.hpp"
+#include "irrlicht.h"
+
+class SimulationModel;
+
+// NMEA::updateNMEA() and NMEA::receive() as they were before NMEACodec, with
+// snprintf formats, string copies and std::stof, kept for the tests and
+// benchmarks to compare the codec with. Only the date and time strings are
+// kept alive while they are used, as the old code read them after they were
+// freed; the RMC date is yyyymmdd and APB field 11 overwrites field 8, as
+// before.
+class LegacyNMEA {
+ public:
+  explicit LegacyNMEA(SimulationModel* model);
+
+  // the AIS and sensor sentences of a frame at now ms, as updateNMEA() queued
+  // them
+  void update(irr::u32 now);
+  const std::vector<std::string>& getMessages() const { return messages; }
+  void clearMessages() { messages.clear(); }
+
+  // the sentences of a sensor report, one datagram, empty if there are none
+  static std::string sensorSentences(SimulationModel* model,
+                                     NMEA::NMEAMessage type);
+  static std::string aivdmSentence(const std::string& payload, int fillBits);
+
+  enum ParseResult { REJECTED, PARSED_APB, PARSED_RMB, THREW };
+  // a received sentence, without <CR><LF>; THREW where std::stof's
+  // std::out_of_range escaped receive(), leaving its mutex locked
+  static ParseResult parse(const std::string& sentence, APB& apb, RMB& rmb);
+
+ private:
+  SimulationModel* model;
+  std::vector<std::string> messages;
+  irr::u32 lastSendEvent;
+  int currentMessageType;
+};
+
+#endif
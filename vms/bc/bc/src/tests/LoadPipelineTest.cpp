@@ -0,0 +1,224 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// The SimpleEstuary world loaded in turn on the main thread and through the
+// loader threads: the scene graphs come out node for node the same, down to
+// the terrain heights and the radar terrain of the land objects, and the two
+// own ships then run aground the same, which they only do with the same
+// contact points.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../FlightRecorder.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 OTHER_SHIPS = 16;
+const irr::u32 LOAD_THREADS = 4;
+const irr::u32 FRAMES = 1200;  // of 100 ms, long enough to run aground
+const irr::u32 HEIGHT_SAMPLES = 32;  // a side, on each terrain node
+
+struct SceneComparison {
+  irr::u32 nodes;
+  irr::u32 differences;
+};
+
+std::string textureName(const irr::video::SMaterial& material) {
+  irr::video::ITexture* texture = material.getTexture(0);
+  return texture ? std::string(texture->getName().getPath().c_str()) : "";
+}
+
+bool sameMatrix(const irr::core::matrix4& a, const irr::core::matrix4& b) {
+  return std::memcmp(a.pointer(), b.pointer(), 16 * sizeof(irr::f32)) == 0;
+}
+
+bool sameMesh(irr::scene::IMesh* a, irr::scene::IMesh* b) {
+  if (!a || !b) return a == b;
+  if (a->getMeshBufferCount() != b->getMeshBufferCount()) return false;
+  for (irr::u32 i = 0; i < a->getMeshBufferCount(); i++) {
+    if (a->getMeshBuffer(i)->getVertexCount() !=
+            b->getMeshBuffer(i)->getVertexCount() ||
+        a->getMeshBuffer(i)->getIndexCount() !=
+            b->getMeshBuffer(i)->getIndexCount()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// heights on a grid over the node, bit for bit
+bool sameHeights(irr::scene::ITerrainSceneNode* a,
+                 irr::scene::ITerrainSceneNode* b) {
+  irr::core::aabbox3df box = a->getTransformedBoundingBox();
+  irr::core::vector3df extent = box.getExtent();
+  for (irr::u32 i = 0; i < HEIGHT_SAMPLES; i++) {
+    for (irr::u32 j = 0; j < HEIGHT_SAMPLES; j++) {
+      irr::f32 x = box.MinEdge.X + extent.X * (i + 0.5f) / HEIGHT_SAMPLES;
+      irr::f32 z = box.MinEdge.Z + extent.Z * (j + 0.5f) / HEIGHT_SAMPLES;
+      irr::f32 heightA = a->getHeight(x, z);
+      irr::f32 heightB = b->getHeight(x, z);
+      if (std::memcmp(&heightA, &heightB, sizeof(irr::f32)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool sameNode(irr::scene::ISceneNode* a, irr::scene::ISceneNode* b) {
+  if (a->getType() != b->getType() || a->getID() != b->getID() ||
+      std::strcmp(a->getName(), b->getName()) != 0 ||
+      a->isVisible() != b->isVisible() ||
+      a->getPosition() != b->getPosition() ||
+      a->getRotation() != b->getRotation() || a->getScale() != b->getScale() ||
+      !sameMatrix(a->getAbsoluteTransformation(),
+                  b->getAbsoluteTransformation()) ||
+      a->getBoundingBox() != b->getBoundingBox() ||
+      a->getMaterialCount() != b->getMaterialCount()) {
+    return false;
+  }
+  for (irr::u32 i = 0; i < a->getMaterialCount(); i++) {
+    if (textureName(a->getMaterial(i)) != textureName(b->getMaterial(i))) {
+      return false;
+    }
+  }
+  switch (a->getType()) {
+    case irr::scene::ESNT_MESH:
+      return sameMesh(static_cast<irr::scene::IMeshSceneNode*>(a)->getMesh(),
+                      static_cast<irr::scene::IMeshSceneNode*>(b)->getMesh());
+    case irr::scene::ESNT_TERRAIN:
+      return sameHeights(static_cast<irr::scene::ITerrainSceneNode*>(a),
+                         static_cast<irr::scene::ITerrainSceneNode*>(b));
+    default:
+      return true;
+  }
+}
+
+// walks the nodes under a and b together, children in the order they were
+// added
+void compareChildren(irr::scene::ISceneNode* a, irr::scene::ISceneNode* b,
+                     SceneComparison& comparison) {
+  const irr::core::list<irr::scene::ISceneNode*>& childrenA = a->getChildren();
+  const irr::core::list<irr::scene::ISceneNode*>& childrenB = b->getChildren();
+  if (childrenA.size() != childrenB.size()) {
+    comparison.differences++;
+    return;
+  }
+  irr::core::list<irr::scene::ISceneNode*>::ConstIterator itA =
+      childrenA.begin();
+  irr::core::list<irr::scene::ISceneNode*>::ConstIterator itB =
+      childrenB.begin();
+  for (; itA != childrenA.end(); ++itA, ++itB) {
+    comparison.nodes++;
+    if (!sameNode(*itA, *itB)) comparison.differences++;
+    compareChildren(*itA, *itB, comparison);
+  }
+}
+
+double load(SimulationFixture& fixture, const std::string& dataPath,
+            irr::u32 loadThreads) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  CHECK(!fixture.load(dataPath, SimulationFixture::makeScenario(OTHER_SHIPS),
+                      loadThreads));
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// the states after each of FRAMES frames. The timer is shared by all the
+// devices, so the models are run one after the other, each from the time it
+// was loaded at.
+void run(SimulationFixture& fixture, std::vector<FlightOwnShipState>& ownShip,
+         std::vector<FlightShipState>& otherShips) {
+  SimulationModel* model = fixture.getModel();
+  fixture.getDevice()->getTimer()->setTime(0);
+  model->setHeading(270);
+  model->setPortEngine(1);
+  model->setStbdEngine(1);
+  FlightOwnShipState ownShipState;
+  std::vector<FlightShipState> otherShipStates;
+  for (irr::u32 i = 0; i < FRAMES; i++) {
+    std::srand(i);
+    fixture.advance(100);
+    model->getFlightState(ownShipState, otherShipStates);
+    ownShip.push_back(ownShipState);
+    otherShips.insert(otherShips.end(), otherShipStates.begin(),
+                      otherShipStates.end());
+  }
+}
+
+}  // namespace
+
+void testLoadPipeline(const std::string& dataPath) {
+  SimulationFixture serial;
+  SimulationFixture parallel;
+  double serialSeconds = load(serial, dataPath, 0);
+  double parallelSeconds = load(parallel, dataPath, LOAD_THREADS);
+  std::printf("loaded in %.2f s in turn, %.2f s on %u threads\n",
+              serialSeconds, parallelSeconds, LOAD_THREADS);
+  if (!serial.getModel() || !parallel.getModel()) return;
+
+  SceneComparison comparison = SceneComparison();
+  compareChildren(serial.getDevice()->getSceneManager()->getRootSceneNode(),
+                parallel.getDevice()->getSceneManager()->getRootSceneNode(),
+                comparison);
+  std::printf("%u scene nodes, %u differ\n", comparison.nodes,
+              comparison.differences);
+  CHECK(comparison.nodes > OTHER_SHIPS * 2);
+  CHECK(comparison.differences == 0);
+
+  // the own ship run aground on the west shore, where the contact points
+  // stop it, with the same draws of std::rand
+  std::vector<FlightOwnShipState> serialOwnShip;
+  std::vector<FlightShipState> serialOtherShips;
+  std::vector<FlightOwnShipState> parallelOwnShip;
+  std::vector<FlightShipState> parallelOtherShips;
+  run(serial, serialOwnShip, serialOtherShips);
+  run(parallel, parallelOwnShip, parallelOtherShips);
+  irr::u32 divergentFrames = 0;
+  size_t shipsPerFrame = serialOtherShips.size() / FRAMES;
+  CHECK(parallelOtherShips.size() == serialOtherShips.size());
+  for (irr::u32 i = 0; i < FRAMES; i++) {
+    if (std::memcmp(&serialOwnShip[i], &parallelOwnShip[i],
+                    sizeof(FlightOwnShipState)) != 0 ||
+        std::memcmp(&serialOtherShips[i * shipsPerFrame],
+                    &parallelOtherShips[i * shipsPerFrame],
+                    shipsPerFrame * sizeof(FlightShipState)) != 0) {
+      divergentFrames++;
+    }
+  }
+  // at full speed by halfway, then stopped by the shore
+  irr::f32 fastest = serialOwnShip[FRAMES / 2].speed;
+  irr::f32 slowest = fastest;
+  for (irr::u32 i = FRAMES / 2; i < FRAMES; i++) {
+    slowest = std::min(slowest, serialOwnShip[i].speed);
+  }
+  std::printf("%u of %u frames differ, slowed from %.2f to %.2f m/s\n",
+              divergentFrames, FRAMES, fastest, slowest);
+  CHECK(slowest < fastest / 2);
+  CHECK(divergentFrames == 0);
+}
@@ -0,0 +1,153 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The main loop of main.cpp in lockstep with a client on a clock segment of
+// its own: the timer moves on by exactly one step per stepped frame, frames
+// are drawn every few steps whatever the wall clock does, pausing holds the
+// time, and a run gives the same model states with a fast client as with a
+// slow one.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CoSimMaster.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 STEP_MS = 5;
+const irr::u32 STEPS = 600;
+// of the client, as the autopilot's control cycle
+const uint64_t CYCLE_NS = 250 * 1000000ull;
+// frames paused half way through
+const irr::u32 PAUSED_FRAMES = 5;
+
+// state of the model when a frame is drawn
+struct Frame {
+  irr::u32 time;
+  irr::f32 lat;
+  irr::f32 lon;
+  irr::f32 heading;
+  irr::f32 otherX;
+  irr::f32 otherZ;
+
+  bool operator==(const Frame& other) const {
+    return time == other.time && lat == other.lat && lon == other.lon &&
+           heading == other.heading && otherX == other.otherX &&
+           otherZ == other.otherZ;
+  }
+};
+
+// waits for one cycle after the other until the master goes away, a slow
+// client takes up to a few ms for each
+void runClient(const std::string& segment, bool slow) {
+  CoSimChannel channel;
+  if (channel.open(CoSimChannel::CLIENT, segment.c_str())) return;
+  if (channel.attach()) return;
+  std::mt19937 random(1);
+  uint64_t cycle = channel.time() + CYCLE_NS;
+  while (channel.wait_until(cycle)) {
+    if (slow) {
+      std::this_thread::sleep_for(std::chrono::microseconds(random() % 3000));
+    }
+    cycle += CYCLE_NS;
+  }
+}
+
+std::vector<Frame> runLockstep(const std::string& dataPath, bool slowClient) {
+  std::vector<Frame> drawn;
+  SimulationFixture fixture;
+  if (fixture.load(dataPath, SimulationFixture::makeScenario(2))) {
+    CHECK(!"the model loads");
+    return drawn;
+  }
+  irr::IrrlichtDevice* device = fixture.getDevice();
+  SimulationModel* model = fixture.getModel();
+  irr::ITimer* timer = device->getTimer();
+  timer->setSpeed(1.0f);
+
+  std::string segment = "/bc-test-cosim-" + std::to_string(getpid());
+  std::thread client;
+  irr::u32 steps = 0;
+  irr::u32 heldDraws = 0;
+  bool onGrid = true;
+  {
+    CoSimMaster cosim(device, STEP_MS, 0.0f, 1);
+    CHECK(!cosim.open(segment.c_str()));
+    if (!cosim.is_enabled()) return drawn;
+    client = std::thread(runClient, segment, slowClient);
+
+    irr::u32 expected = timer->getTime();
+    irr::u32 pausedFrames = 0;
+    while (steps < STEPS) {
+      if (steps == STEPS / 2 && pausedFrames < PAUSED_FRAMES) {
+        timer->setSpeed(0.0f);
+        pausedFrames++;
+      } else {
+        timer->setSpeed(1.0f);
+      }
+      bool stepped = cosim.step();
+      if (stepped) {
+        // the first frame runs at the start time
+        if (steps > 0) expected += STEP_MS;
+        steps++;
+        model->update();
+      }
+      onGrid &= timer->getTime() == expected;
+      if (!cosim.render_due(stepped)) continue;
+      if (!stepped) {
+        heldDraws++;
+        continue;
+      }
+      Frame frame = {timer->getTime(),          model->getLat(),
+                     model->getLong(),          model->getHeading(),
+                     model->getOtherShipPosX(0), model->getOtherShipPosZ(0)};
+      drawn.push_back(frame);
+    }
+    // at least the paused frames, and any that waited for the client
+    CHECK(heldDraws >= PAUSED_FRAMES);
+  }
+  // the master closed, which releases the client
+  client.join();
+
+  CHECK(onGrid);
+  std::printf("%s client: %u steps of %u ms, %u frames drawn, %u held\n",
+              slowClient ? "slow" : "fast", steps, STEP_MS,
+              static_cast<irr::u32>(drawn.size()), heldDraws);
+  return drawn;
+}
+
+}  // namespace
+
+void testLockstep(const std::string& dataPath) {
+  std::vector<Frame> fast = runLockstep(dataPath, false);
+  std::vector<Frame> slow = runLockstep(dataPath, true);
+  // a frame every 16 ms of simulated time, rounded down to whole steps
+  CHECK(fast.size() == STEPS / (16 / STEP_MS));
+  CHECK(fast == slow);
+  // and the model did move
+  CHECK(!fast.empty() && fast.front().lat != fast.back().lat);
+}
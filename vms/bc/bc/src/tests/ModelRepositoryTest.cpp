@@ -0,0 +1,195 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// 500 other ships on the NULL driver, drawn and picked through the
+// ModelRepository and, for comparison, through a mesh scene node and a mesh
+// triangle selector per instance, as they were before the repository: the
+// models are loaded once, the same primitives are drawn with far fewer
+// material changes, and rays hit the same points on the same ships.
+
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../ModelRepository.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+#include "irrlicht.h"
+
+namespace {
+
+const irr::u32 SHIPS = 500;
+const irr::u32 RAYS = 200;
+
+const irr::scene::ESCENE_NODE_TYPE MODEL_INSTANCE_TYPE =
+    (irr::scene::ESCENE_NODE_TYPE)MAKE_IRR_ID('m', 'o', 'd', 'i');
+
+void findInstances(irr::scene::ISceneNode* node,
+                   std::vector<ModelInstanceNode*>& instances) {
+  if (node->getType() == MODEL_INSTANCE_TYPE) {
+    instances.push_back(static_cast<ModelInstanceNode*>(node));
+  }
+  const irr::core::list<irr::scene::ISceneNode*>& children =
+      node->getChildren();
+  for (irr::core::list<irr::scene::ISceneNode*>::ConstIterator it =
+           children.begin();
+       it != children.end(); ++it) {
+    findInstances(*it, instances);
+  }
+}
+
+// primitives drawn in a frame of the 3d view
+irr::u32 drawFrame(SimulationFixture& fixture) {
+  irr::video::IVideoDriver* driver = fixture.getDevice()->getVideoDriver();
+  driver->beginScene(true, true, irr::video::SColor(255, 0, 0, 0));
+  fixture.getModel()->setMainCameraActive();
+  fixture.getDevice()->getSceneManager()->drawAll();
+  driver->endScene();
+  return driver->getPrimitiveCountDrawn();
+}
+
+}  // namespace
+
+void testModelRepository(const std::string& dataPath) {
+  SimulationFixture fixture;
+  CHECK(!fixture.load(dataPath, SimulationFixture::makeScenario(SHIPS)));
+  if (!fixture.getModel()) return;
+  fixture.advance(100);
+
+  irr::IrrlichtDevice* device = fixture.getDevice();
+  irr::scene::ISceneManager* smgr = device->getSceneManager();
+  ModelRepository* repository = ModelRepository::getRepository(smgr);
+  std::vector<ModelInstanceNode*> instances;
+  findInstances(smgr->getRootSceneNode(), instances);
+  std::printf("%u instances of %u models\n", repository->getInstanceCount(),
+              repository->getModelCount());
+  CHECK(instances.size() == repository->getInstanceCount());
+  CHECK(instances.size() >= SHIPS);
+  // each model loaded once: two ship models, and the buoys and land
+  // objects of the estuary
+  CHECK(repository->getModelCount() < instances.size() / 10);
+  std::set<irr::scene::IMesh*> meshes;
+  for (irr::u32 i = 0; i < repository->getModelCount(); i++) {
+    meshes.insert(repository->getMesh(i));
+  }
+  CHECK(meshes.size() == repository->getModelCount());
+  std::vector<irr::u32> modelInstances(repository->getModelCount(), 0);
+  for (size_t i = 0; i < instances.size(); i++) {
+    modelInstances[instances[i]->getModel()]++;
+  }
+  irr::u32 sharedModels = 0;
+  for (size_t i = 0; i < modelInstances.size(); i++) {
+    if (modelInstances[i] >= SHIPS / 2) sharedModels++;
+  }
+  CHECK(sharedModels >= 2);
+
+  // each instance as a mesh scene node beside it, with the shared materials
+  std::map<irr::scene::ISceneNode*, irr::scene::ISceneNode*> references;
+  irr::scene::IMetaTriangleSelector* instanceSelectors =
+      smgr->createMetaTriangleSelector();
+  irr::scene::IMetaTriangleSelector* referenceSelectors =
+      smgr->createMetaTriangleSelector();
+  for (size_t i = 0; i < instances.size(); i++) {
+    ModelInstanceNode* instance = instances[i];
+    irr::scene::IMesh* mesh = repository->getMesh(instance->getModel());
+    CHECK(mesh != 0);
+    if (!mesh) continue;
+    irr::scene::IMeshSceneNode* reference = smgr->addMeshSceneNode(
+        mesh, instance->getParent(), -1, instance->getPosition(),
+        instance->getRotation(), instance->getScale());
+    reference->setReadOnlyMaterials(false);
+    for (irr::u32 j = 0; j < instance->getMaterialCount(); j++) {
+      reference->getMaterial(j) = instance->getMaterial(j);
+    }
+    references[reference] = instance;
+
+    irr::scene::ITriangleSelector* selector =
+        repository->createTriangleSelector(instance->getModel(), instance);
+    instanceSelectors->addTriangleSelector(selector);
+    selector->drop();
+    selector = smgr->createTriangleSelector(mesh, reference);
+    referenceSelectors->addTriangleSelector(selector);
+    selector->drop();
+  }
+
+  // drawn once by the repository, and once by the scene nodes
+  repository->setVisible(false);
+  irr::u32 referencePrimitives = drawFrame(fixture);
+  repository->setVisible(true);
+  for (std::map<irr::scene::ISceneNode*, irr::scene::ISceneNode*>::iterator
+           it = references.begin();
+       it != references.end(); ++it) {
+    it->first->setVisible(false);
+  }
+  irr::u32 instancePrimitives = drawFrame(fixture);
+  std::printf("%u primitives by reference, %u by the repository\n",
+              referencePrimitives, instancePrimitives);
+  std::printf("%u draws, %u material changes\n", repository->getDrawCount(),
+              repository->getBatchCount());
+  CHECK(instancePrimitives == referencePrimitives);
+  CHECK(repository->getDrawCount() > 0);
+  // once per buffer of each model seen, not once per instance
+  CHECK(repository->getBatchCount() < repository->getDrawCount() / 10);
+
+  // rays down through and across the ships, hitting the same triangles
+  std::mt19937 random(44);
+  std::uniform_real_distribution<irr::f32> unit(0.0f, 1.0f);
+  irr::scene::ISceneCollisionManager* collision =
+      smgr->getSceneCollisionManager();
+  irr::u32 hits = 0;
+  irr::u32 differences = 0;
+  for (irr::u32 i = 0; i < RAYS; i++) {
+    irr::core::aabbox3df box =
+        instances[i % instances.size()]->getTransformedBoundingBox();
+    irr::core::vector3df extent = box.getExtent();
+    irr::core::vector3df target(box.MinEdge.X + extent.X * unit(random),
+                                box.MinEdge.Y + extent.Y * unit(random),
+                                box.MinEdge.Z + extent.Z * unit(random));
+    irr::core::vector3df from(target.X + 200 * (unit(random) - 0.5f),
+                              box.MaxEdge.Y + 50,
+                              target.Z + 200 * (unit(random) - 0.5f));
+    irr::core::line3df ray(from, from + (target - from) * 2);
+
+    irr::core::vector3df instancePoint, referencePoint;
+    irr::core::triangle3df instanceTriangle, referenceTriangle;
+    irr::scene::ISceneNode* instanceNode = 0;
+    irr::scene::ISceneNode* referenceNode = 0;
+    bool instanceHit =
+        collision->getCollisionPoint(ray, instanceSelectors, instancePoint,
+                                     instanceTriangle, instanceNode);
+    bool referenceHit =
+        collision->getCollisionPoint(ray, referenceSelectors, referencePoint,
+                                     referenceTriangle, referenceNode);
+    if (instanceHit != referenceHit ||
+        (instanceHit &&
+         (instanceNode != references[referenceNode] ||
+          instancePoint.getDistanceFrom(referencePoint) > 1e-3f))) {
+      differences++;
+    }
+    if (instanceHit) hits++;
+  }
+  std::printf("%u of %u rays hit, %u differ\n", hits, RAYS, differences);
+  CHECK(hits > RAYS / 2);
+  CHECK(differences == 0);
+
+  instanceSelectors->drop();
+  referenceSelectors->drop();
+}
@@ -0,0 +1,484 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// NMEACodec against the NMEA code it replaced, kept as LegacyNMEA: numbers
+// are written digit for digit as printf wrote them, a running own ship and
+// its AIS targets send the same sentences over UDP, and APB and RMB read the
+// same fields from valid and fuzzed input. Then the fixes: RMC dates are
+// ddmmyy, minutes that round up carry into the degrees, APB field 11 is the
+// bearing to destination's type, and a datagram of several sentences is
+// read whole, also after a number std::stof threw on.
+
+#include <asio.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../NMEA.hpp"
+#include "../NMEACodec.hpp"
+#include "../NMEASentences.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "../Utilities.hpp"
+#include "Check.hpp"
+#include "LegacyNMEA.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+#include "irrlicht.h"
+
+namespace {
+
+const irr::u32 NUMBERS = 200000;
+const irr::u32 FRAMES = 14 * 30;  // each sensor sentence 30 times
+const irr::u32 FUZZ_SENTENCES = 300000;
+const char* const FUZZ_CHARACTERS = ",.*-+0123456789AELMNRSTVW$\r\n ";
+
+std::vector<std::string> split(const std::string& text,
+                               const std::string& separator) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  for (;;) {
+    size_t end = text.find(separator, start);
+    if (end == std::string::npos) {
+      parts.push_back(text.substr(start));
+      return parts;
+    }
+    parts.push_back(text.substr(start, end - start));
+    start = end + separator.length();
+  }
+}
+
+// the fields of a sentence being written
+std::string fieldsOf(NMEASentence& sentence) {
+  sentence.finish();
+  std::string text = sentence.c_str();
+  return text.substr(0, text.rfind('*'));
+}
+
+bool parses(const std::string& sentence) {
+  NMEAReceivedSentence received;
+  return received.parse(sentence.c_str(), sentence.length());
+}
+
+// replaces or adds *hh for the characters before it
+std::string withChecksum(std::string sentence) {
+  size_t star = sentence.rfind('*');
+  if (star != std::string::npos) sentence.erase(star);
+  irr::u8 checksum = 0;
+  for (size_t i = 1; i < sentence.length(); i++) checksum ^= sentence[i];
+  char hex[4];
+  std::snprintf(hex, sizeof(hex), "*%02X", checksum);
+  return sentence + hex;
+}
+
+// a port nothing listens on now
+unsigned short freePort(asio::io_context& io) {
+  asio::ip::udp::socket socket(
+      io, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+  return socket.local_endpoint().port();
+}
+
+void testNumbers() {
+  std::mt19937 random(45);
+  std::uniform_real_distribution<irr::f32> value(-2000.0f, 2000.0f);
+  std::uniform_int_distribution<irr::s32> integer(-100000, 100000);
+  irr::u32 differences = 0;
+  for (irr::u32 i = 0; i < NUMBERS; i++) {
+    // f32, as the model keeps them, and some whole and half values
+    irr::f64 number = value(random);
+    if (i % 7 == 0) number = std::floor(number);
+    if (i % 11 == 0) number = std::floor(number) + 0.5;
+    irr::u32 decimals = i % 4;
+    irr::u32 width = (i / 4) % 9;
+    NMEASentence sentence;
+    sentence.begin('$', "IIXXX");
+    sentence.addFixed(number, decimals, width);
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "%0*.*f", (int)width,
+                  (int)decimals, number);
+    if (fieldsOf(sentence) != std::string("$IIXXX,") + expected)
+      differences++;
+
+    irr::s32 whole = integer(random);
+    sentence.begin('$', "IIXXX");
+    sentence.addInt(whole, width % 5);
+    std::snprintf(expected, sizeof(expected), "%0*d", (int)(width % 5), whole);
+    if (fieldsOf(sentence) != std::string("$IIXXX,") + expected)
+      differences++;
+  }
+  std::printf("numbers: %u differ from printf\n", differences);
+  CHECK(differences == 0);
+
+  // zeros beyond the powers of ten the parser keeps
+  irr::f32 parsed = -1;
+  const char* tiny = "0.000000000000000000000000000012";
+  CHECK(parseNMEADecimal(tiny, tiny + std::strlen(tiny), parsed));
+  CHECK_NEAR(parsed, 1.2e-29, 1e-35);
+}
+
+void testFixes() {
+  // minutes rounding up to a whole degree
+  NMEASentence sentence;
+  sentence.begin('$', "GPGLL");
+  sentence.addLatitude(50.999996f);
+  sentence.addLongitude(-9.999995f);
+  CHECK(fieldsOf(sentence) == "$GPGLL,5100.000,N,01000.000,W");
+  irr::f32 latitude = 50.999996f;
+  char legacy[32];
+  std::snprintf(legacy, sizeof(legacy), "%02u%06.3f", (irr::u8)latitude,
+                (latitude - (int)latitude) * 60);
+  CHECK(std::strcmp(legacy, "5060.000") == 0);
+
+  // dates without gmtime, as Utilities::ttos() gives them by it
+  std::mt19937 random(46);
+  std::uniform_int_distribution<irr::s64> timestamp(0, 4102444800LL);
+  irr::u32 wrongDates = 0;
+  for (irr::u32 i = 0; i < 10000; i++) {
+    irr::s64 time = i == 0 ? 951782400 : timestamp(random);  // 29 Feb 2000
+    NMEAValues values;
+    values.setTimestamp(time);
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04u%02u%02u%02u%02u%02u", values.year,
+                  values.month, values.day, values.hour, values.minute,
+                  values.second);
+    if (Utilities::ttos(time) != text) wrongDates++;
+  }
+  CHECK(wrongDates == 0);
+
+  // field 11 is the bearing to destination's type, not field 8's
+  std::string apbText = withChecksum(
+      "$GPAPB,A,A,0.10,R,N,V,V,011.0,M,DEST,012.0,T,013.0,T");
+  NMEAReceivedSentence received;
+  CHECK(received.parse(apbText.c_str(), apbText.length()));
+  APB apb;
+  CHECK(NMEA::decodeAPB(received, apb));
+  CHECK(apb.bearing_orig_to_dest_type == 'M');
+  CHECK(apb.bearing_to_dest_type == 'T');
+  CHECK(std::strcmp(apb.dest_waypoint_id, "DEST") == 0);
+  APB legacyApb;
+  RMB legacyRmb;
+  CHECK(LegacyNMEA::parse(apbText, legacyApb, legacyRmb) ==
+        LegacyNMEA::PARSED_APB);
+  CHECK(legacyApb.bearing_orig_to_dest_type == 'T');
+}
+
+// sensor sentences, with the fixes the codec made to them
+void compareSensorSentences(const std::string& sent,
+                            const std::string& expected, irr::u32& carries,
+                            irr::u32& differences) {
+  std::vector<std::string> sentSentences = split(sent, "\r\n");
+  std::vector<std::string> expectedSentences = split(expected, "\r\n");
+  if (sentSentences.size() != expectedSentences.size()) {
+    differences++;
+    return;
+  }
+  for (size_t i = 0; i < sentSentences.size(); i++) {
+    if (sentSentences[i].empty() && expectedSentences[i].empty()) continue;
+    CHECK(parses(sentSentences[i]));
+    std::vector<std::string> sentFields =
+        split(sentSentences[i].substr(0, sentSentences[i].rfind('*')), ",");
+    std::vector<std::string> expectedFields = split(
+        expectedSentences[i].substr(0, expectedSentences[i].rfind('*')), ",");
+    if (sentFields.size() != expectedFields.size()) {
+      differences++;
+      continue;
+    }
+    for (size_t j = 0; j < sentFields.size(); j++) {
+      const std::string& field = sentFields[j];
+      const std::string& old = expectedFields[j];
+      if (field == old) continue;
+      if (sentFields[0] == "$GPRMC" && j == 9 && old.length() == 8) {
+        // yyyymmdd before, ddmmyy now
+        if (field == old.substr(6, 2) + old.substr(4, 2) + old.substr(2, 2))
+          continue;
+      }
+      if (old.find("60.000") == old.length() - 6) {
+        carries++;
+        continue;
+      }
+      std::fprintf(stderr, "%s\n%s\n", sentSentences[i].c_str(),
+                   expectedSentences[i].c_str());
+      differences++;
+    }
+  }
+}
+
+void testSentences(const std::string& dataPath) {
+  SimulationFixture fixture;
+  CHECK(!fixture.load(dataPath, SimulationFixture::makeScenario(4)));
+  SimulationModel* model = fixture.getModel();
+  if (!model) return;
+
+  asio::io_context io;
+  asio::ip::udp::socket listener(
+      io, asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+  unsigned short nmeaListenPort = freePort(io);
+  NMEA nmea(model, "", 0, "127.0.0.1",
+            std::to_string(listener.local_endpoint().port()),
+            std::to_string(nmeaListenPort), fixture.getDevice());
+
+  // turning, with the engines apart, so that rudder, rate of turn and RPM
+  // are not all zero
+  model->setWheel(-12);
+  model->setPortEngine(0.8f);
+  model->setStbdEngine(0.6f);
+
+  irr::u32 sensorSentences = 0;
+  irr::u32 aisSentences = 0;
+  irr::u32 rmcSentences = 0;
+  irr::u32 carries = 0;
+  irr::u32 differences = 0;
+  char datagram[2048];
+  for (irr::u32 frame = 0; frame < FRAMES; frame++) {
+    fixture.advance(100);
+    nmea.updateNMEA();
+    nmea.sendNMEAUDP();
+    nmea.clearQueue();
+    std::string expected = LegacyNMEA::sensorSentences(
+        model, (NMEA::NMEAMessage)(frame % 14));
+    bool sensorsSent = false;
+    while (listener.available() > 0) {
+      size_t length = listener.receive(asio::buffer(datagram));
+      std::string sent(datagram, length);
+      if (sent[0] == '!') {
+        CHECK(sent.length() <= 800 + NMEASentence::MAX_LENGTH);
+        std::vector<std::string> sentences = split(sent, "\r\n");
+        for (size_t i = 0; i + 1 < sentences.size(); i++) {
+          CHECK(parses(sentences[i]));
+          std::vector<std::string> fields = split(sentences[i], ",");
+          CHECK(fields.size() == 7);
+          if (fields.size() != 7) continue;
+          std::string old = LegacyNMEA::aivdmSentence(
+              fields[5], std::atoi(fields[6].c_str()));
+          if (old != sentences[i] + "\r\n") differences++;
+          aisSentences++;
+        }
+      } else {
+        CHECK(!sensorsSent);
+        sensorsSent = true;
+        if (sent.compare(0, 6, "$GPRMC") == 0) {
+          // the scenario starts on 1 January 2015
+          CHECK(split(sent, ",")[9] == "010115");
+          rmcSentences++;
+        }
+        compareSensorSentences(sent, expected, carries, differences);
+        sensorSentences++;
+      }
+    }
+    CHECK(sensorsSent == !expected.empty());
+  }
+  std::printf(
+      "%u sensor and %u AIS sentences sent, %u minute carries, %u differ\n",
+      sensorSentences, aisSentences, carries, differences);
+  CHECK(sensorSentences >= FRAMES - FRAMES / 14);  // no TTM without targets
+  CHECK(rmcSentences == FRAMES / 14);
+  CHECK(aisSentences >= 4);
+  CHECK(differences == 0);
+
+  // received: several sentences in one datagram, past the 8 bytes the
+  // thread read before, also after a number too large for std::stof
+  std::string apbText =
+      withChecksum("$GPAPB,A,A,0.10,R,N,V,V,011.0,T,DEST,011.0,T,012.0,T");
+  std::string rmbText = withChecksum(
+      "$GPRMB,A,0.10,R,ORIG,DEST,5002.08,N,00958.44,W,1.5,011.0,7.9,V,S");
+  std::string hugeRmbText = withChecksum(
+      "$GPRMB,A,0.10,R,ORIG,DEST,5002.08,N,00958.44,W,1" +
+      std::string(60, '0') + ",011.0,7.9,V,S");
+  APB apb;
+  RMB rmb;
+  CHECK(LegacyNMEA::parse(hugeRmbText, apb, rmb) == LegacyNMEA::THREW);
+  asio::ip::udp::socket sender(io, asio::ip::udp::v4());
+  asio::ip::udp::endpoint nmeaEndpoint(asio::ip::address_v4::loopback(),
+                                       nmeaListenPort);
+  std::string datagrams[] = {
+      apbText + "\r\n" + hugeRmbText + "\r\n" + rmbText + "\r\n",
+      rmbText + "\r\n" + apbText};
+  irr::u32 expectedHandled[] = {2, 2};
+  for (irr::u32 i = 0; i < 2; i++) {
+    sender.send_to(asio::buffer(datagrams[i]), nmeaEndpoint);
+    irr::u32 handled = 0;
+    for (irr::u32 wait = 0; wait < 200 && handled < expectedHandled[i];
+         wait++) {
+      handled += nmea.receive();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(handled == expectedHandled[i]);
+  }
+}
+
+std::string randomText(std::mt19937& random, irr::u32 maxLength) {
+  static const char ALPHANUMERIC[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  std::string text;
+  irr::u32 length = random() % (maxLength + 1);
+  for (irr::u32 i = 0; i < length; i++)
+    text += ALPHANUMERIC[random() % (sizeof(ALPHANUMERIC) - 1)];
+  return text;
+}
+
+std::string randomSentence(std::mt19937& random) {
+  std::uniform_real_distribution<irr::f32> value(0.0f, 360.0f);
+  NMEASentence sentence;
+  if (random() % 2) {
+    sentence.begin('$', "GPAPB");
+    sentence.addChar("AV"[random() % 2]);
+    sentence.addChar("AV"[random() % 2]);
+    sentence.addFixed(value(random) / 100, 2);
+    sentence.addChar("LR"[random() % 2]);
+    sentence.addText("N");
+    sentence.addChar("AV"[random() % 2]);
+    sentence.addChar("AV"[random() % 2]);
+    sentence.addFixed(value(random), 1);
+    sentence.addChar("MT"[random() % 2]);
+    sentence.addText(randomText(random, 8).c_str());
+    sentence.addFixed(value(random), 1);
+    sentence.addChar("MT"[random() % 2]);
+    sentence.addFixed(value(random), 1);
+    sentence.addChar("MT"[random() % 2]);
+  } else {
+    sentence.begin('$', "GPRMB");
+    sentence.addChar("AV"[random() % 2]);
+    sentence.addFixed(value(random) / 100, 2);
+    sentence.addChar("LR"[random() % 2]);
+    sentence.addText(randomText(random, 6).c_str());
+    sentence.addText(randomText(random, 6).c_str());
+    sentence.addLatitude(value(random) / 4 - 45);
+    sentence.addLongitude(value(random) - 180);
+    sentence.addFixed(value(random) / 10, 1);
+    sentence.addFixed(value(random), 1);
+    sentence.addFixed(value(random) / 20, 1);
+    sentence.addChar("AV"[random() % 2]);
+    if (random() % 2) sentence.addChar("ADEMSN"[random() % 6]);
+  }
+  sentence.finish();
+  std::string text(sentence.c_str(), sentence.length() - 2);  // no <CR><LF>
+  return text;
+}
+
+bool sameApb(const APB& a, const APB& b) {
+  // but for the types of the bearings, which the old code mixed up
+  return a.status == b.status && a.warning == b.warning &&
+         a.cross_track_error == b.cross_track_error &&
+         a.direction == b.direction &&
+         a.cross_track_units == b.cross_track_units &&
+         a.arrival_circle_entered == b.arrival_circle_entered &&
+         a.perpendicular_passed == b.perpendicular_passed &&
+         a.bearing_orig_to_dest == b.bearing_orig_to_dest &&
+         std::strcmp(a.dest_waypoint_id, b.dest_waypoint_id) == 0 &&
+         a.bearing_to_dest == b.bearing_to_dest &&
+         a.heading_to_dest == b.heading_to_dest &&
+         a.heading_to_dest_type == b.heading_to_dest_type;
+}
+
+bool sameRmb(const RMB& a, const RMB& b) {
+  return a.status == b.status && a.cross_track_error == b.cross_track_error &&
+         a.direction == b.direction &&
+         std::strcmp(a.dest_waypoint_id, b.dest_waypoint_id) == 0 &&
+         std::strcmp(a.orig_waypoint_id, b.orig_waypoint_id) == 0 &&
+         std::strcmp(a.dest_waypoint_latitude, b.dest_waypoint_latitude) ==
+             0 &&
+         a.dest_waypoint_latitude_dir == b.dest_waypoint_latitude_dir &&
+         std::strcmp(a.dest_waypoint_longitude, b.dest_waypoint_longitude) ==
+             0 &&
+         a.dest_waypoint_longitude_dir == b.dest_waypoint_longitude_dir &&
+         a.range_to_dest == b.range_to_dest &&
+         a.bearing_to_dest == b.bearing_to_dest &&
+         a.dest_closing_velocity == b.dest_closing_velocity &&
+         a.arrival_status == b.arrival_status && a.faa_mode == b.faa_mode;
+}
+
+void testFuzz() {
+  std::mt19937 random(47);
+  irr::u32 accepted = 0;
+  irr::u32 legacyAccepted = 0;
+  irr::u32 legacyThrew = 0;
+  irr::u32 onlyNew = 0;
+  irr::u32 differences = 0;
+  for (irr::u32 i = 0; i < FUZZ_SENTENCES; i++) {
+    std::string text = randomSentence(random);
+    // unchanged, or with up to three characters replaced, added or removed
+    irr::u32 mutations = i % 8 == 0 ? 0 : 1 + random() % 3;
+    for (irr::u32 j = 0; j < mutations; j++) {
+      size_t at = random() % text.length();
+      char c = random() % 4 == 0
+                   ? (char)(random() % 256)
+                   : FUZZ_CHARACTERS[random() % std::strlen(FUZZ_CHARACTERS)];
+      switch (random() % 3) {
+        case 0:
+          text[at] = c;
+          break;
+        case 1:
+          text.insert(at, 1, c);
+          break;
+        default:
+          if (text.length() > 1) text.erase(at, 1);
+          break;
+      }
+    }
+    // mostly with a checksum that fits, to get past it
+    if (mutations && random() % 4 != 0) text = withChecksum(text);
+
+    APB apb, legacyApb;
+    RMB rmb, legacyRmb;
+    std::memset(&apb, 0, sizeof(apb));
+    std::memset(&rmb, 0, sizeof(rmb));
+    std::memset(&legacyApb, 0, sizeof(legacyApb));
+    std::memset(&legacyRmb, 0, sizeof(legacyRmb));
+    NMEAReceivedSentence received;
+    LegacyNMEA::ParseResult result = LegacyNMEA::ParseResult::REJECTED;
+    if (received.parse(text.c_str(), text.length()) &&
+        received.getStart() == '$' && !received.isProprietary()) {
+      if (received.getFormatter() == NMEA_APB && NMEA::decodeAPB(received, apb))
+        result = LegacyNMEA::PARSED_APB;
+      if (received.getFormatter() == NMEA_RMB && NMEA::decodeRMB(received, rmb))
+        result = LegacyNMEA::PARSED_RMB;
+    }
+    LegacyNMEA::ParseResult legacy =
+        LegacyNMEA::parse(text, legacyApb, legacyRmb);
+    if (legacy == LegacyNMEA::THREW) legacyThrew++;
+    if (legacy == LegacyNMEA::PARSED_APB || legacy == LegacyNMEA::PARSED_RMB)
+      legacyAccepted++;
+    if (result == LegacyNMEA::REJECTED) continue;
+    accepted++;
+    if (legacy != result) {
+      onlyNew++;
+      std::fprintf(stderr, "only accepted now: %s\n", text.c_str());
+    } else if (result == LegacyNMEA::PARSED_APB ? !sameApb(apb, legacyApb)
+                                                : !sameRmb(rmb, legacyRmb)) {
+      differences++;
+      std::fprintf(stderr, "read differently: %s\n", text.c_str());
+    }
+  }
+  std::printf(
+      "fuzz: %u of %u sentences accepted, %u before, %u threw before, %u "
+      "only accepted now, %u read differently\n",
+      accepted, FUZZ_SENTENCES, legacyAccepted, legacyThrew, onlyNew,
+      differences);
+  CHECK(accepted >= FUZZ_SENTENCES / 8);
+  CHECK(onlyNew == 0);
+  CHECK(differences == 0);
+}
+
+}  // namespace
+
+void testNMEACodec(const std::string& dataPath) {
+  testNumbers();
+  testFixes();
+  testSentences(dataPath);
+  testFuzz();
+}
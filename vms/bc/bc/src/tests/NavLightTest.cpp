@@ -0,0 +1,270 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The navigation lights of the NavLightManager against the per-light update
+// they replaced, kept here as ReferenceLight: on moving, rotating and hidden
+// parents, over sectors, flash sequences and phases, a light is seen and
+// placed exactly where the old NavLight would have drawn it.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Angles.hpp"
+#include "../NavLight.hpp"
+#include "../NavLightManager.hpp"
+#include "Check.hpp"
+#include "Tests.hpp"
+#include "irrlicht.h"
+
+namespace {
+
+const irr::u32 PARENTS = 40;
+const irr::u32 LIGHTS = 2000;
+const irr::u32 FRAMES = 200;
+const irr::f32 FRAME_TIME = 0.37f;  // s, not a multiple of a character
+
+// sequences of the worlds, and a steady light
+const char* const SEQUENCES[] = {
+    "",
+    "LLDDDDDD",
+    "LLLLLLDD",
+    "LLDDD",
+    "LLDDDLLDDDLLDDDLLDDDLLDDDLLDDDLLDDDLLDDDLLDDDDDDDDDDDDDDDDDD",
+    "LLDDDLLDDDLLDDDLLDDDLLDDDLLDDLLLLLLDDDDD",
+    "lldd"};
+
+// NavLight::update() before the NavLightManager, but for the sphere it drew
+class ReferenceLight {
+ public:
+  ReferenceLight(irr::scene::ISceneNode* parent,
+                 irr::scene::ISceneManager* smgr,
+                 irr::core::vector3df position, irr::f32 lightStartAngle,
+                 irr::f32 lightEndAngle, irr::f32 lightRange,
+                 std::string lightSequence, irr::u32 phaseStart)
+      : smgr(smgr) {
+    lightNode = smgr->addEmptySceneNode(parent);
+    lightNode->setPosition(position);
+    while (lightStartAngle < 0) {
+      lightStartAngle += 360;
+      lightEndAngle += 360;
+    }
+    startAngle = lightStartAngle;
+    endAngle = lightEndAngle;
+    range = lightRange;
+    charTime = 0.25;
+    sequence = lightSequence;
+    if (phaseStart == 0) {
+      timeOffset = 60.0 * ((irr::f32)std::rand() / RAND_MAX);
+    } else {
+      timeOffset = (phaseStart - 1) * charTime;
+    }
+  }
+  ~ReferenceLight() { lightNode->remove(); }
+
+  irr::core::vector3df getPosition() const {
+    lightNode->updateAbsolutePosition();
+    return lightNode->getAbsolutePosition();
+  }
+
+  // drawn as of the last update, with its parents
+  bool isDrawn() const { return lightNode->isTrulyVisible(); }
+
+  void update(irr::f32 scenarioTime) {
+    lightNode->updateAbsolutePosition();
+    irr::core::vector3df lightPosition = lightNode->getAbsolutePosition();
+    irr::scene::ICameraSceneNode* camera = smgr->getActiveCamera();
+    if (camera == 0) return;
+    camera->updateAbsolutePosition();
+    irr::core::vector3df viewPosition = camera->getAbsolutePosition();
+
+    irr::f32 lightDistance = lightPosition.getDistanceFrom(viewPosition);
+    lightNode->setVisible(!(lightDistance > range));
+
+    irr::f32 relativeAngleDeg =
+        (viewPosition - lightPosition).getHorizontalAngle().Y;
+    irr::f32 parentAngleDeg = lightNode->getParent()->getRotation().Y;
+    irr::f32 localRelativeAngleDeg = relativeAngleDeg - parentAngleDeg;
+    if (!Angles::isAngleBetween(localRelativeAngleDeg, startAngle, endAngle)) {
+      lightNode->setVisible(false);
+    }
+
+    std::string::size_type sequenceLength = sequence.length();
+    if (sequenceLength > 0) {
+      irr::f32 timeInSequence = std::fmod(
+          ((scenarioTime + timeOffset) / charTime), sequenceLength);
+      irr::u32 positionInSequence = timeInSequence;
+      if (positionInSequence >= sequenceLength) {
+        positionInSequence = sequenceLength - 1;
+      }
+      if (sequence[positionInSequence] == 'D' ||
+          sequence[positionInSequence] == 'd') {
+        lightNode->setVisible(false);
+      }
+    }
+  }
+
+ private:
+  irr::scene::ISceneManager* smgr;
+  irr::scene::ISceneNode* lightNode;
+  irr::f32 startAngle;
+  irr::f32 endAngle;
+  irr::f32 range;
+  irr::f32 charTime;
+  irr::f32 timeOffset;
+  std::string sequence;
+};
+
+struct LightPair {
+  NavLight* light;
+  ReferenceLight* reference;
+};
+
+// the same light both ways, with the same random phase if it has none
+LightPair addLight(irr::scene::ISceneManager* smgr,
+                   const std::vector<irr::scene::ISceneNode*>& parents,
+                   std::mt19937& random) {
+  std::uniform_real_distribution<irr::f32> unit(0.0f, 1.0f);
+  irr::scene::ISceneNode* parent =
+      random() % 8 == 0 ? 0 : parents[random() % parents.size()];
+  irr::core::vector3df position((unit(random) - 0.5f) * 40.0f,
+                                unit(random) * 30.0f,
+                                (unit(random) - 0.5f) * 40.0f);
+  if (!parent) position *= 100.0f;
+  // wrapped, negative, full circle and inverted sectors
+  irr::f32 start = (unit(random) - 0.5f) * 720.0f;
+  irr::f32 end;
+  switch (random() % 4) {
+    case 0:
+      end = start + 360.0f;
+      break;
+    case 1:
+      end = start - unit(random) * 90.0f;
+      break;
+    default:
+      end = start + unit(random) * 270.0f;
+      break;
+  }
+  irr::f32 range = 500.0f + unit(random) * 4500.0f;
+  std::string sequence =
+      SEQUENCES[random() % (sizeof(SEQUENCES) / sizeof(SEQUENCES[0]))];
+  irr::u32 phaseStart = random() % 3 == 0 ? 0 : 1 + random() % 40;
+
+  unsigned seed = random();
+  LightPair pair;
+  std::srand(seed);
+  pair.light = new NavLight(parent, smgr, position,
+                            irr::video::SColor(255, 255, 0, 0), start, end,
+                            range, sequence, phaseStart);
+  std::srand(seed);
+  pair.reference = new ReferenceLight(parent, smgr, position, start, end,
+                                      range, sequence, phaseStart);
+  return pair;
+}
+
+}  // namespace
+
+void testNavLight(const std::string& dataPath) {
+  irr::IrrlichtDevice* device = irr::createDevice(
+      irr::video::EDT_NULL, irr::core::dimension2d<irr::u32>(1024, 768));
+  CHECK(device != 0);
+  if (!device) return;
+  device->getLogger()->setLogLevel(irr::ELL_ERROR);
+  irr::scene::ISceneManager* smgr = device->getSceneManager();
+  irr::scene::ICameraSceneNode* camera = smgr->addCameraSceneNode();
+
+  std::mt19937 random(43);
+  std::uniform_real_distribution<irr::f32> unit(0.0f, 1.0f);
+  std::vector<irr::scene::ISceneNode*> parents;
+  for (irr::u32 i = 0; i < PARENTS; i++) {
+    irr::scene::ISceneNode* parent = smgr->addEmptySceneNode();
+    parent->setPosition(irr::core::vector3df((unit(random) - 0.5f) * 6000.0f,
+                                             0,
+                                             (unit(random) - 0.5f) * 6000.0f));
+    parents.push_back(parent);
+  }
+  std::vector<LightPair> lights;
+  for (irr::u32 i = 0; i < LIGHTS; i++) {
+    lights.push_back(addLight(smgr, parents, random));
+  }
+
+  NavLightManager* manager = NavLightManager::getManager(smgr);
+  irr::u32 checks = 0;
+  irr::u32 visibleDiffer = 0;
+  irr::u32 positionDiffer = 0;
+  irr::u32 seen = 0;
+  for (irr::u32 frame = 0; frame < FRAMES; frame++) {
+    // times well past a day, where the phase loses precision
+    const irr::f32 scenarioTime =
+        (frame < FRAMES / 2 ? 0.0f : 2e5f) + frame * FRAME_TIME;
+
+    // the parents move and turn, and some are hidden for a while
+    for (irr::u32 i = 0; i < parents.size(); i++) {
+      irr::scene::ISceneNode* parent = parents[i];
+      irr::f32 heading = std::fmod(i * 37.0f + frame * (i % 5) * 3.1f, 360.0f);
+      parent->setRotation(irr::core::vector3df(0, heading, 0));
+      parent->setPosition(parent->getPosition() +
+                          irr::core::vector3df(std::sin(heading * 0.01745f),
+                                               0,
+                                               std::cos(heading * 0.01745f)));
+      parent->setVisible((frame / 10 + i) % 7 != 0);
+      parent->updateAbsolutePosition();
+    }
+    camera->setPosition(
+        irr::core::vector3df(std::sin(frame * 0.05f) * 2000.0f, 10.0f + frame,
+                             std::cos(frame * 0.03f) * 2000.0f));
+
+    // some lights go, and others come, reusing their ids
+    if (frame % 20 == 10) {
+      for (irr::u32 j = 0; j < 50; j++) {
+        irr::u32 i = random() % lights.size();
+        delete lights[i].light;
+        delete lights[i].reference;
+        lights[i] = addLight(smgr, parents, random);
+      }
+    }
+
+    manager->update(scenarioTime, 0);
+    for (irr::u32 i = 0; i < lights.size(); i++) {
+      lights[i].reference->update(scenarioTime);
+      const bool drawn = lights[i].reference->isDrawn();
+      if (lights[i].light->isVisible() != drawn) visibleDiffer++;
+      if (!lights[i].light->getPosition().equals(
+              lights[i].reference->getPosition(), 0.001f)) {
+        positionDiffer++;
+      }
+      seen += drawn;
+      checks++;
+    }
+  }
+  std::printf("%u checks, %u seen, %u differ in visibility, %u in position\n",
+              checks, seen, visibleDiffer, positionDiffer);
+  CHECK(visibleDiffer == 0);
+  CHECK(positionDiffer == 0);
+  // enough lights both ways to tell
+  CHECK(seen > checks / 20);
+  CHECK(seen < checks / 2);
+
+  for (irr::u32 i = 0; i < lights.size(); i++) {
+    delete lights[i].light;
+    delete lights[i].reference;
+  }
+  device->drop();
+}
@@ -0,0 +1,190 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The profiler, built into this test whether or not BC is built with it:
+// scopes on several threads nest as they ran while a collector drains them,
+// the rings of threads that exit are freed, and an empty scope costs little
+// to record.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../iprof.hpp"
+#include "Check.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const int THREADS = 4;
+const int OUTER_SCOPES = 2000;  // per thread
+const int INNER_SCOPES = 3;     // per outer scope
+
+// an empty scope at a time, a round fits in a ring without a collect()
+const int OVERHEAD_ROUNDS = 20;
+const int OVERHEAD_SCOPES = 4000;
+
+const char* const OUTER = "profiler test outer";
+const char* const INNER = "profiler test inner";
+
+volatile int sink = 0;
+
+void nestedScopes() {
+  IPROF(OUTER);
+  for (int i = 0; i < INNER_SCOPES; i++) {
+    IPROF(INNER);
+    sink = sink + 1;
+  }
+}
+
+const InternalProfiler::ScopeStats* findScope(
+    const std::vector<InternalProfiler::ScopeStats>& stats,
+    const std::string& name) {
+  for (size_t i = 0; i < stats.size(); i++) {
+    if (stats[i].name == name) return &stats[i];
+  }
+  return 0;
+}
+
+struct Span {
+  double start;  // us
+  double end;
+  int inner;
+};
+
+// every inner scope of the trace lies in an outer scope of its thread, and
+// every outer scope holds all of its inner ones
+void checkTraceNesting(const std::string& path) {
+  std::ifstream file(path.c_str());
+  CHECK(file.good());
+  std::map<int, std::vector<Span> > outer;
+  std::vector<std::pair<int, Span> > inner;
+  std::string line;
+  char name[64];
+  int tid;
+  Span span = {0, 0, 0};
+  double duration;
+  while (std::getline(file, line)) {
+    if (std::sscanf(line.c_str(),
+                    "{\"name\":\"%63[^\"]\",\"ph\":\"X\",\"pid\":1,"
+                    "\"tid\":%d,\"ts\":%lf,\"dur\":%lf}",
+                    name, &tid, &span.start, &duration) != 4) {
+      continue;
+    }
+    span.end = span.start + duration;
+    if (name == std::string(OUTER)) outer[tid].push_back(span);
+    if (name == std::string(INNER)) inner.push_back(std::make_pair(tid, span));
+  }
+
+  size_t outerCount = 0;
+  for (std::map<int, std::vector<Span> >::iterator it = outer.begin();
+       it != outer.end(); ++it) {
+    std::sort(it->second.begin(), it->second.end(),
+              [](const Span& a, const Span& b) { return a.start < b.start; });
+    outerCount += it->second.size();
+  }
+  CHECK(outerCount == size_t(THREADS * OUTER_SCOPES));
+  CHECK(inner.size() == size_t(THREADS * OUTER_SCOPES * INNER_SCOPES));
+
+  // times are written to the ns
+  const double slack = 0.001;
+  size_t unnested = 0;
+  for (size_t i = 0; i < inner.size(); i++) {
+    std::vector<Span>& spans = outer[inner[i].first];
+    const Span& in = inner[i].second;
+    std::vector<Span>::iterator it = std::upper_bound(
+        spans.begin(), spans.end(), in.start + slack,
+        [](double start, const Span& s) { return start < s.start; });
+    if (it == spans.begin() || in.end > (it - 1)->end + slack) {
+      unnested++;
+      continue;
+    }
+    (it - 1)->inner++;
+  }
+  CHECK(unnested == 0);
+  for (std::map<int, std::vector<Span> >::iterator it = outer.begin();
+       it != outer.end(); ++it) {
+    for (size_t i = 0; i < it->second.size(); i++) {
+      CHECK(it->second[i].inner == INNER_SCOPES);
+      if (it->second[i].inner != INNER_SCOPES) return;
+    }
+  }
+}
+
+}  // namespace
+
+void testProfiler(const std::string& dataPath) {
+  const size_t threadsBefore = InternalProfiler::threadCount();
+  const uint64_t droppedBefore = InternalProfiler::droppedEvents();
+
+  // drains the rings while the threads record, as BC does every frame
+  std::atomic<bool> done(false);
+  std::thread collector([&done] {
+    while (!done) {
+      InternalProfiler::collect();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  std::vector<std::thread> workers;
+  for (int i = 0; i < THREADS; i++) {
+    workers.push_back(std::thread([] {
+      for (int j = 0; j < OUTER_SCOPES; j++) nestedScopes();
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+  done = true;
+  collector.join();
+  InternalProfiler::collect();
+
+  // the workers drained and freed their rings as they exited
+  CHECK(InternalProfiler::threadCount() == threadsBefore);
+  CHECK(InternalProfiler::droppedEvents() == droppedBefore);
+
+  std::vector<InternalProfiler::ScopeStats> stats =
+      InternalProfiler::snapshot();
+  const InternalProfiler::ScopeStats* outer = findScope(stats, OUTER);
+  const InternalProfiler::ScopeStats* inner = findScope(stats, INNER);
+  CHECK(outer && inner);
+  if (!outer || !inner) return;
+  CHECK(outer->histogram.count == uint64_t(THREADS * OUTER_SCOPES));
+  CHECK(inner->histogram.count ==
+        uint64_t(THREADS * OUTER_SCOPES * INNER_SCOPES));
+  CHECK(outer->histogram.total >= inner->histogram.total);
+
+  const std::string tracePath = "profiler-test-trace.json";
+  CHECK(InternalProfiler::writeChromeTrace(tracePath));
+  checkTraceNesting(tracePath);
+  std::remove(tracePath.c_str());
+
+  // the fastest round, so that a busy machine does not fail the test
+  double perScope = 1e9;
+  for (int round = 0; round < OVERHEAD_ROUNDS; round++) {
+    perScope = std::min(perScope, BcTest::timePerCall(OVERHEAD_SCOPES, [](int) {
+                          IPROF("profiler test empty");
+                        }));
+    InternalProfiler::collect();
+  }
+  std::printf("an empty scope takes %.1f ns to record\n", perScope);
+  CHECK(perScope < 1000.0);
+  CHECK(InternalProfiler::droppedEvents() == droppedBefore);
+}
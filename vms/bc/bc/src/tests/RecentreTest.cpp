@@ -0,0 +1,270 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+// The own ship moved round the SimpleEstuary world, far enough each frame
+// for the model to re-centre the world every few frames: a frame which
+// re-centres takes no longer than one which does not, and the depth under
+// the ship, a pick of the terrain below it and the buoys are where they were
+// at the same point of the world, whatever the world's offset is there.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../BCTerrainSceneNode.h"
+#include "../BCTerrainTriangleSelector.h"
+#include "../FlightRecorder.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 OTHER_SHIPS = 4;
+
+// a loop round the estuary, in world metres, well inside the terrain
+const irr::f32 LOOP_MIN_X = 400.0f;
+const irr::f32 LOOP_MAX_X = 3200.0f;
+const irr::f32 LOOP_MIN_Z = 400.0f;
+const irr::f32 LOOP_MAX_Z = 4000.0f;
+const irr::f32 STEP = 200.0f;  // a frame, so the world re-centres often
+const irr::u32 LAPS = 3;       // alternately one way round and the other
+
+struct Sample {
+  irr::core::vector3df world;  // the ship's position, from the model
+  int64_t offsetX;
+  int64_t offsetZ;
+  irr::f32 depth;
+  irr::f32 pickHeight;
+  double seconds;  // of the frame
+  bool recentred;
+};
+
+// the points of the loop, a step apart
+std::vector<irr::core::vector2df> makeLoop() {
+  const irr::core::vector2df corners[] = {
+      irr::core::vector2df(LOOP_MIN_X, LOOP_MIN_Z),
+      irr::core::vector2df(LOOP_MAX_X, LOOP_MIN_Z),
+      irr::core::vector2df(LOOP_MAX_X, LOOP_MAX_Z),
+      irr::core::vector2df(LOOP_MIN_X, LOOP_MAX_Z)};
+  std::vector<irr::core::vector2df> loop;
+  for (irr::u32 i = 0; i < 4; i++) {
+    const irr::core::vector2df& from = corners[i];
+    const irr::core::vector2df& to = corners[(i + 1) % 4];
+    const irr::u32 steps = (irr::u32)((to - from).getLength() / STEP);
+    for (irr::u32 j = 0; j < steps; j++) {
+      loop.push_back(from + (to - from) * ((irr::f32)j / steps));
+    }
+  }
+  return loop;
+}
+
+// the terrains the model placed on its world root
+std::vector<irr::scene::BCTerrainSceneNode*> findTerrains(
+    irr::scene::ISceneManager* smgr) {
+  std::vector<irr::scene::BCTerrainSceneNode*> terrains;
+  irr::scene::ISceneNode* worldRoot = smgr->getSceneNodeFromName("WorldRoot");
+  if (!worldRoot) return terrains;
+  const irr::core::list<irr::scene::ISceneNode*>& children =
+      worldRoot->getChildren();
+  for (irr::core::list<irr::scene::ISceneNode*>::ConstIterator it =
+           children.begin();
+       it != children.end(); ++it) {
+    if ((*it)->getType() == irr::scene::ESNT_TERRAIN) {
+      terrains.push_back(static_cast<irr::scene::BCTerrainSceneNode*>(*it));
+    }
+  }
+  return terrains;
+}
+
+// the highest terrain straight below a point of the scene, through the
+// collision manager as a pick of the terrain would go
+irr::f32 pickHeight(
+    irr::scene::ISceneManager* smgr,
+    const std::vector<irr::scene::BCTerrainTriangleSelector*>& selectors,
+    irr::f32 x, irr::f32 z) {
+  const irr::core::line3df ray(x, 1000.0f, z, x, -1000.0f, z);
+  irr::f32 height = -1000.0f;
+  for (size_t i = 0; i < selectors.size(); i++) {
+    irr::core::vector3df point;
+    irr::core::triangle3df triangle;
+    irr::scene::ISceneNode* node;
+    if (smgr->getSceneCollisionManager()->getCollisionPoint(
+            ray, selectors[i], point, triangle, node)) {
+      height = std::max(height, point.Y);
+    }
+  }
+  return height;
+}
+
+// moves the ship to a point of the world and runs a frame as main.cpp does
+Sample runFrame(SimulationFixture& fixture,
+                const std::vector<irr::scene::BCTerrainTriangleSelector*>&
+                    selectors,
+                const irr::core::vector2df& point) {
+  SimulationModel* model = fixture.getModel();
+  irr::scene::ISceneManager* smgr = fixture.getDevice()->getSceneManager();
+  irr::video::IVideoDriver* driver = fixture.getDevice()->getVideoDriver();
+  FlightOwnShipState before;
+  FlightOwnShipState after;
+  std::vector<FlightShipState> otherShips;
+  model->getFlightState(before, otherShips);
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  model->setPos(point.X, point.Y);
+  fixture.advance(100);
+  driver->beginScene(true, true, irr::video::SColor(255, 0, 0, 0));
+  model->setMainCameraActive();
+  smgr->drawAll();
+  driver->endScene();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  model->getFlightState(after, otherShips);
+  Sample sample;
+  sample.world = irr::core::vector3df(model->getPosX(), 0, model->getPosZ());
+  sample.offsetX = after.offset_x;
+  sample.offsetZ = after.offset_z;
+  sample.depth = model->getDepth();
+  sample.pickHeight = pickHeight(smgr, selectors, point.X - after.offset_x,
+                                 point.Y - after.offset_z);
+  sample.seconds = elapsed.count();
+  sample.recentred =
+      after.offset_x != before.offset_x || after.offset_z != before.offset_z;
+  return sample;
+}
+
+double median(std::vector<double> values) {
+  if (values.empty()) return 0;
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+}  // namespace
+
+void testRecentre(const std::string& dataPath) {
+  SimulationFixture fixture;
+  ScenarioData scenario = SimulationFixture::makeScenario(OTHER_SHIPS);
+  scenario.weather = 0;  // so the ship's height only follows the tide
+  CHECK(!fixture.load(dataPath, scenario));
+  if (!fixture.getModel()) return;
+  SimulationModel* model = fixture.getModel();
+  irr::scene::ISceneManager* smgr = fixture.getDevice()->getSceneManager();
+  if (!model->isRadarOn()) model->toggleRadarOn();
+
+  // the model picks nothing on the terrains, so the test makes the selectors
+  // a pick would use
+  std::vector<irr::scene::BCTerrainSceneNode*> terrains = findTerrains(smgr);
+  CHECK(!terrains.empty());
+  std::vector<irr::scene::BCTerrainTriangleSelector*> selectors;
+  for (size_t i = 0; i < terrains.size(); i++) {
+    selectors.push_back(
+        new irr::scene::BCTerrainTriangleSelector(terrains[i], 0));
+  }
+  std::vector<irr::f32> buoyX;
+  std::vector<irr::f32> buoyZ;
+  for (irr::u32 i = 0; i < model->getNumberOfBuoys(); i++) {
+    buoyX.push_back(model->getBuoyPosX(i));
+    buoyZ.push_back(model->getBuoyPosZ(i));
+  }
+
+  // past the first, slow, frames
+  const std::vector<irr::core::vector2df> loop = makeLoop();
+  for (irr::u32 i = 0; i < 10; i++) runFrame(fixture, selectors, loop[0]);
+
+  // samples[lap][point], the reverse laps stored in the loop's order
+  std::vector<std::vector<Sample>> samples(LAPS,
+                                           std::vector<Sample>(loop.size()));
+  for (irr::u32 lap = 0; lap < LAPS; lap++) {
+    for (size_t i = 0; i < loop.size(); i++) {
+      size_t point = (lap % 2 == 0) ? i : loop.size() - 1 - i;
+      samples[lap][point] = runFrame(fixture, selectors, loop[point]);
+    }
+  }
+
+  std::vector<double> recentredSeconds;
+  std::vector<double> otherSeconds;
+  irr::u32 offsetsDiffer = 0;
+  irr::f32 positionDrift = 0;
+  irr::f32 depthDrift = 0;
+  irr::f32 pickDrift = 0;
+  irr::u32 picked = 0;
+  for (irr::u32 lap = 0; lap < LAPS; lap++) {
+    for (size_t i = 0; i < loop.size(); i++) {
+      const Sample& sample = samples[lap][i];
+      const Sample& first = samples[0][i];
+      (sample.recentred ? recentredSeconds : otherSeconds)
+          .push_back(sample.seconds);
+      positionDrift = std::max(
+          positionDrift,
+          sample.world.getDistanceFrom(
+              irr::core::vector3df(loop[i].X, 0, loop[i].Y)));
+      if (lap == 0) {
+        if (sample.pickHeight > -1000.0f) picked++;
+        continue;
+      }
+      if (sample.offsetX != first.offsetX || sample.offsetZ != first.offsetZ) {
+        offsetsDiffer++;
+      }
+      depthDrift = std::max(depthDrift, std::fabs(sample.depth - first.depth));
+      pickDrift = std::max(pickDrift,
+                           std::fabs(sample.pickHeight - first.pickHeight));
+    }
+  }
+
+  // what a shift cost when it rewrote the terrains' vertices
+  double rewriteSeconds = 0;
+  for (size_t i = 0; i < terrains.size(); i++) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    terrains[i]->setPosition(terrains[i]->getPosition());
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    rewriteSeconds += elapsed.count();
+  }
+
+  std::printf(
+      "%u frames re-centred, %.2f ms median, the other %u %.2f ms, a "
+      "rewrite of the terrains %.2f ms\n",
+      (irr::u32)recentredSeconds.size(), median(recentredSeconds) * 1000,
+      (irr::u32)otherSeconds.size(), median(otherSeconds) * 1000,
+      rewriteSeconds * 1000);
+  std::printf(
+      "%u of %u points revisited at another offset, drift of %.4f m in "
+      "position, %.4f m in depth, %.4f m in the pick\n",
+      offsetsDiffer, (irr::u32)(loop.size() * (LAPS - 1)), positionDrift,
+      depthDrift, pickDrift);
+  CHECK(recentredSeconds.size() > loop.size() / 4);
+  CHECK(median(recentredSeconds) < median(otherSeconds) * 1.5);
+  CHECK(offsetsDiffer > loop.size() / 2);
+  CHECK(picked == loop.size());
+  CHECK(positionDrift < 0.01f);
+  CHECK(depthDrift < 0.01f);
+  CHECK(pickDrift < 0.01f);
+
+  CHECK(!buoyX.empty());
+  for (irr::u32 i = 0; i < buoyX.size(); i++) {
+    CHECK_NEAR(model->getBuoyPosX(i), buoyX[i], 0.01);
+    CHECK_NEAR(model->getBuoyPosZ(i), buoyZ[i], 0.01);
+  }
+
+  for (size_t i = 0; i < selectors.size(); i++) selectors[i]->drop();
+}
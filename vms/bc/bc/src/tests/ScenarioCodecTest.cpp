@@ -0,0 +1,194 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The scenario codecs: SCN2 round-trips byte for byte and skips what later
+// versions add, SCN1 text still round-trips, and malformed or mutated SCN2
+// is rejected without touching the scenario it was read into.
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "../ScenarioDataStructure.hpp"
+#include "Check.hpp"
+#include "SimulationFixture.hpp"
+#include "Tests.hpp"
+
+namespace {
+
+const irr::u32 LARGE_SHIPS = 1000;
+const irr::u32 MUTATIONS = 20000;
+
+// with the corners of the format: separators of the text format and UTF-8
+// in names, a ship without legs and the largest values
+ScenarioData makeScenario(irr::u32 otherShips) {
+  ScenarioData scenario = SimulationFixture::makeScenario(otherShips);
+  scenario.scenarioName = "Test #1, \xc3\x85lesund|/?";
+  scenario.startYear = 0xffffffffu;
+  scenario.ownShipData.initialBearing = -0.0f;
+  if (!scenario.otherShipsData.empty()) {
+    scenario.otherShipsData[0].legs.clear();
+    scenario.otherShipsData[0].mmsi = 0xffffffffu;
+  }
+  return scenario;
+}
+
+void testRoundTrip() {
+  ScenarioData scenario = makeScenario(LARGE_SHIPS);
+  std::string binary = scenario.serialiseBinary();
+  CHECK(ScenarioData::isSerialised(binary));
+
+  ScenarioData decoded;
+  CHECK(decoded.deserialiseBinary(binary));
+  CHECK(decoded.serialiseBinary() == binary);
+  CHECK(decoded.scenarioName == scenario.scenarioName);
+  CHECK(decoded.startYear == scenario.startYear);
+  CHECK(decoded.otherShipsData.size() == LARGE_SHIPS);
+  CHECK(decoded.otherShipsData[0].legs.empty());
+  CHECK(decoded.otherShipsData[0].mmsi == 0xffffffffu);
+  CHECK(decoded.otherShipsData[1].legs.size() == 4);
+
+  // deserialise() takes either format
+  ScenarioData viaEither;
+  viaEither.deserialise(binary);
+  CHECK(viaEither.serialiseBinary() == binary);
+
+  // SCN1 has no escaping, so names must not hold its separators
+  ScenarioData plain = SimulationFixture::makeScenario(LARGE_SHIPS);
+  std::string text = plain.serialise();
+  CHECK(ScenarioData::isSerialised(text));
+  ScenarioData fromText;
+  fromText.deserialise(text);
+  CHECK(fromText.serialise() == text);
+  CHECK(fromText.otherShipsData.size() == LARGE_SHIPS);
+  CHECK(!fromText.deserialiseBinary(text));
+
+  std::printf("%u ships: %u bytes as SCN2, %u as SCN1\n", LARGE_SHIPS,
+              static_cast<irr::u32>(binary.size()),
+              static_cast<irr::u32>(text.size()));
+  CHECK(binary.size() < text.size());
+}
+
+// sections and fields of later versions are skipped
+void testForwardCompatible() {
+  ScenarioData scenario = makeScenario(4);
+  std::string binary = scenario.serialiseBinary();
+
+  std::string unknownSection = binary;
+  unknownSection.append("\x09\x03" "abc", 5);
+  ScenarioData decoded;
+  CHECK(decoded.deserialiseBinary(unknownSection));
+  CHECK(decoded.serialiseBinary() == binary);
+
+  // the scenario section comes first, after the magic: tag, one byte of
+  // length, then the payload, to which a field is added at the end
+  std::string longerSection = binary;
+  irr::u32 length = static_cast<unsigned char>(longerSection[5]);
+  CHECK(length < 0x7f);
+  longerSection[5] = static_cast<char>(length + 1);
+  longerSection.insert(6 + length, 1, '\x2a');
+  ScenarioData extended;
+  CHECK(extended.deserialiseBinary(longerSection));
+  CHECK(extended.serialiseBinary() == binary);
+}
+
+void testMalformed() {
+  ScenarioData original = makeScenario(8);
+  const std::string expected = original.serialiseBinary();
+  std::string binary = makeScenario(3).serialiseBinary();
+
+  // every truncation fails and leaves the target alone
+  bool unchanged = true;
+  for (size_t length = 0; length < binary.size(); length++) {
+    ScenarioData target = original;
+    CHECK(!target.deserialiseBinary(binary.substr(0, length)));
+    unchanged &= target.serialiseBinary() == expected;
+  }
+  CHECK(unchanged);
+
+  // a count far beyond the data is not allocated
+  std::string huge("SCN2", 4);
+  huge.append("\x03\x0b", 2);
+  huge.append("\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", 10);
+  huge.push_back('\0');
+  ScenarioData target = original;
+  CHECK(!target.deserialiseBinary(huge));
+  CHECK(target.serialiseBinary() == expected);
+
+  // and a varint of more than 64 bits
+  std::string longVarint("SCN2", 4);
+  longVarint.push_back('\x01');
+  longVarint.append(11, '\xff');
+  CHECK(!target.deserialiseBinary(longVarint));
+}
+
+// random flips, insertions, deletions and truncations
+void testFuzz() {
+  ScenarioData original = makeScenario(8);
+  const std::string expected = original.serialiseBinary();
+  std::string seed = makeScenario(5).serialiseBinary();
+  std::mt19937 random(39);
+
+  irr::u32 accepted = 0;
+  bool unchanged = true;
+  bool stable = true;
+  for (irr::u32 i = 0; i < MUTATIONS; i++) {
+    std::string data = seed;
+    irr::u32 edits = 1 + random() % 4;
+    for (irr::u32 j = 0; j < edits && !data.empty(); j++) {
+      size_t at = random() % data.size();
+      switch (random() % 4) {
+        case 0:
+          data[at] = static_cast<char>(data[at] ^ (1 << (random() % 8)));
+          break;
+        case 1:
+          data[at] = static_cast<char>(random());
+          break;
+        case 2:
+          data.insert(at, 1, static_cast<char>(random()));
+          break;
+        default:
+          data.resize(at);
+          break;
+      }
+    }
+
+    ScenarioData target = original;
+    if (target.deserialiseBinary(data)) {
+      accepted++;
+      // whatever was accepted encodes and decodes to itself
+      std::string again = target.serialiseBinary();
+      ScenarioData copy;
+      stable &= copy.deserialiseBinary(again) &&
+                copy.serialiseBinary() == again;
+    } else {
+      unchanged &= target.serialiseBinary() == expected;
+    }
+  }
+  std::printf("%u mutations: %u accepted\n", MUTATIONS, accepted);
+  CHECK(unchanged);
+  CHECK(stable);
+}
+
+}  // namespace
+
+void testScenarioCodec(const std::string& dataPath) {
+  testRoundTrip();
+  testForwardCompatible();
+  testMalformed();
+  testFuzz();
+}
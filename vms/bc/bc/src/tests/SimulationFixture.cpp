@@ -0,0 +1,122 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "SimulationFixture.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+#include "../IniFile.hpp"
+#include "../Lang.hpp"
+#include "../SimulationModel.hpp"  // and FFTWave.hpp, which has no guard
+
+namespace {
+
+// In the SimpleEstuary scenario's own ship position
+const irr::f32 OWN_SHIP_LONG = -9.974f;
+const irr::f32 OWN_SHIP_LAT = 50.0347f;
+
+// Other ships are on a ring around the own ship, in degrees of latitude
+const irr::f32 RING_RADIUS = 0.01f;
+
+}  // namespace
+
+SimulationFixture::SimulationFixture() : device(0), language(0), model(0) {}
+
+SimulationFixture::~SimulationFixture() {
+  delete model;
+  delete language;
+  if (device) device->drop();
+}
+
+ScenarioData SimulationFixture::makeScenario(irr::u32 otherShips) {
+  ScenarioData scenario;
+  scenario.scenarioName = "Test";
+  scenario.worldName = "SimpleEstuary";
+  scenario.startTime = 10;
+  scenario.sunRise = 6;
+  scenario.sunSet = 18;
+  scenario.weather = 3;
+  scenario.rainIntensity = 2;
+  scenario.visibilityRange = 8;
+  scenario.startDay = 1;
+  scenario.startMonth = 1;
+  scenario.startYear = 2015;
+
+  scenario.ownShipData.ownShipName = "Protis";
+  scenario.ownShipData.initialLong = OWN_SHIP_LONG;
+  scenario.ownShipData.initialLat = OWN_SHIP_LAT;
+  scenario.ownShipData.initialBearing = 251;
+  scenario.ownShipData.initialSpeed = 8;
+
+  // Alternately a small and a large ship, heading round the ring
+  for (irr::u32 i = 0; i < otherShips; i++) {
+    irr::f32 angle = 360.0f * i / otherShips;
+    OtherShipData ship;
+    ship.shipName = (i % 2 == 0) ? "Yacht_Motoring" : "Cargoship1";
+    ship.mmsi = 235000000 + i;
+    ship.initialLat =
+        OWN_SHIP_LAT + RING_RADIUS * std::cos(angle * irr::core::DEGTORAD);
+    ship.initialLong =
+        OWN_SHIP_LONG + RING_RADIUS * std::sin(angle * irr::core::DEGTORAD) /
+                            std::cos(OWN_SHIP_LAT * irr::core::DEGTORAD);
+    for (irr::u32 j = 0; j < 4; j++) {
+      LegData leg;
+      leg.bearing = std::fmod(angle + 90 * (j + 1), 360.0f);
+      leg.speed = 4 + i % 8;
+      leg.distance = 0.5;
+      ship.legs.push_back(leg);
+    }
+    scenario.otherShipsData.push_back(ship);
+  }
+  return scenario;
+}
+
+bool SimulationFixture::load(const std::string& dataPath,
+                             const ScenarioData& scenario,
+                             irr::u32 loadThreads) {
+  device = irr::createDevice(irr::video::EDT_NULL,
+                             irr::core::dimension2d<irr::u32>(1024, 768));
+  if (!device) return true;
+  device->getLogger()->setLogLevel(irr::ELL_ERROR);
+  IniFile::irrlichtLogger = device->getLogger();
+  // Models and worlds are read relative to the working directory
+  irr::io::IFileSystem* fileSystem = device->getFileSystem();
+  irr::io::path workingDirectory = fileSystem->getWorkingDirectory();
+  if (!fileSystem->changeWorkingDirectoryTo(dataPath.c_str())) return true;
+  device->getTimer()->stop();
+  device->getTimer()->setTime(0);
+
+  std::srand(1);
+  model = new SimulationModel(
+      device, device->getSceneManager(), &gui, &sound, scenario,
+      OperatingMode::Normal, 90, 0, 0.5, 10000, 1, 32,
+      irr::core::vector3di(10, 30, 30), 0, loadThreads);
+  language = new Lang("language-en.txt");
+  gui.load(device, language, &logMessages, model->isSingleEngine(),
+           model->isAzimuthDrive(), false, model->hasDepthSounder(),
+           model->getMaxSounderDepth(), model->hasGPS(),
+           model->hasBowThruster(), model->hasSternThruster(),
+           model->hasTurnIndicator());
+  fileSystem->changeWorkingDirectoryTo(workingDirectory);
+  return model->getNumberOfOtherShips() != scenario.otherShipsData.size();
+}
+
+void SimulationFixture::advance(irr::u32 ms) {
+  irr::ITimer* timer = device->getTimer();
+  timer->setTime(timer->getTime() + ms);
+  model->update();
+}
@@ -0,0 +1,64 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef __SIMULATIONFIXTURE_HPP_INCLUDED__
+#define __SIMULATIONFIXTURE_HPP_INCLUDED__
+
+#include <string>
+#include <vector>
+
+#include "../GUIMain.hpp"
+#include "../ScenarioDataStructure.hpp"
+#include "../Sound.hpp"
+#include "irrlicht.h"
+
+class Lang;
+class SimulationModel;
+
+// A model for the tests to run on: a scenario in the SimpleEstuary world,
+// loaded with the GUI on the Irrlicht NULL device, so nothing needs a
+// display. The timer is stopped at 0, the tests move it on.
+class SimulationFixture {
+ public:
+  SimulationFixture();
+  ~SimulationFixture();
+
+  // build the model from the Models and World in dataPath, returns true on
+  // error
+  bool load(const std::string& dataPath, const ScenarioData& scenario,
+            irr::u32 loadThreads = 0);
+
+  // the own ship in the estuary, and other ships on a ring around it
+  static ScenarioData makeScenario(irr::u32 otherShips);
+
+  irr::IrrlichtDevice* getDevice() const { return device; }
+  SimulationModel* getModel() const { return model; }
+  GUIMain& getGui() { return gui; }
+
+  // moves the timer on by ms and updates the model, as a frame of
+  // main.cpp does
+  void advance(irr::u32 ms);
+
+ private:
+  irr::IrrlichtDevice* device;
+  Lang* language;
+  std::vector<std::string> logMessages;
+  GUIMain gui;
+  Sound sound;
+  SimulationModel* model;
+};
+
+#endif
@@ -0,0 +1,205 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// The terrain triangle selector against a linear scan: the nearest hit of a
+// ray through the patch hierarchy is the nearest hit over every triangle of
+// the terrain, and still is after the terrain has been moved, or its parent
+// has, as Terrain::moveNode() moves the world root.
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../BCTerrainSceneNode.h"
+#include "../BCTerrainTriangleSelector.h"
+#include "Check.hpp"
+#include "Tests.hpp"
+#include "irrlicht.h"
+
+namespace {
+
+// 16 x 16 patches of 33 x 33 vertices
+const irr::u32 HEIGHT_MAP_SIZE = 513;
+const irr::f32 TERRAIN_SCALE = 10.0f;
+const irr::u32 RAYS = 1000;
+
+// hills and valleys, so a ray can hit the terrain more than once
+std::vector<std::vector<irr::f32>> makeHeightMap(irr::u32 size) {
+  std::vector<std::vector<irr::f32>> heightMap(size,
+                                               std::vector<irr::f32>(size));
+  for (irr::u32 x = 0; x < size; x++) {
+    for (irr::u32 z = 0; z < size; z++) {
+      heightMap[x][z] = 50.0f * std::sin(x * 0.021f) * std::cos(z * 0.017f) +
+                        20.0f * std::sin((x + 2 * z) * 0.053f);
+    }
+  }
+  return heightMap;
+}
+
+// every triangle of the terrain at LOD 0, read from the node as it is now
+// and moved by its absolute transformation
+std::vector<irr::core::triangle3df> allTriangles(
+    irr::scene::BCTerrainSceneNode* terrain) {
+  const irr::core::matrix4& transformation =
+      terrain->getAbsoluteTransformation();
+  std::vector<irr::core::triangle3df> triangles;
+  const irr::video::S3DVertex2TCoords* vertices =
+      static_cast<const irr::video::S3DVertex2TCoords*>(
+          terrain->getRenderBuffer()->getVertices());
+  irr::core::array<irr::s32> lods;
+  const irr::s32 count = static_cast<irr::s32>(
+      std::sqrt((double)terrain->getCurrentLODOfPatches(lods)));
+  irr::core::array<irr::u32> indices;
+  for (irr::s32 x = 0; x < count; x++) {
+    for (irr::s32 z = 0; z < count; z++) {
+      const irr::s32 indexCount =
+          terrain->getIndicesForPatch(indices, x, z, 0);
+      for (irr::s32 i = 0; i + 2 < indexCount; i += 3) {
+        irr::core::triangle3df triangle(vertices[indices[i]].Pos,
+                                        vertices[indices[i + 1]].Pos,
+                                        vertices[indices[i + 2]].Pos);
+        transformation.transformVect(triangle.pointA);
+        transformation.transformVect(triangle.pointB);
+        transformation.transformVect(triangle.pointC);
+        triangles.push_back(triangle);
+      }
+    }
+  }
+  return triangles;
+}
+
+// nearest hit along the ray, as the collision manager finds it, skipping the
+// triangles outside the ray's box as it does
+bool nearestHit(const irr::core::triangle3df* triangles, irr::s32 count,
+                const irr::core::line3df& ray, irr::core::vector3df& outHit) {
+  const irr::core::vector3df rayVector = ray.getVector().normalize();
+  const irr::f32 rayLength = ray.getLengthSQ();
+  irr::core::aabbox3df rayBox(ray.start);
+  rayBox.addInternalPoint(ray.end);
+  irr::f32 nearest = FLT_MAX;
+  bool hit = false;
+  for (irr::s32 i = 0; i < count; i++) {
+    if (triangles[i].isTotalOutsideBox(rayBox)) continue;
+    irr::core::vector3df intersection;
+    if (triangles[i].getIntersectionWithLine(ray.start, rayVector,
+                                             intersection)) {
+      const irr::f32 distanceToStart =
+          intersection.getDistanceFromSQ(ray.start);
+      const irr::f32 distanceToEnd = intersection.getDistanceFromSQ(ray.end);
+      if (distanceToStart < rayLength && distanceToEnd < rayLength &&
+          distanceToStart < nearest) {
+        nearest = distanceToStart;
+        outHit = intersection;
+        hit = true;
+      }
+    }
+  }
+  return hit;
+}
+
+// rays from above the terrain down at a slant, and nearly level ones which
+// cross many patches, in world coordinates as the collision manager casts
+// them
+void checkRays(irr::scene::BCTerrainSceneNode* terrain,
+               irr::scene::BCTerrainTriangleSelector* selector,
+               irr::u32 seed) {
+  const std::vector<irr::core::triangle3df> triangles = allTriangles(terrain);
+  CHECK((irr::s32)triangles.size() == selector->getTriangleCount());
+  std::vector<irr::core::triangle3df> buffer(selector->getTriangleCount());
+
+  const irr::core::aabbox3df box = terrain->getTransformedBoundingBox();
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<irr::f32> unit(0.0f, 1.0f);
+  irr::u32 hits = 0;
+  irr::u32 mismatches = 0;
+  for (irr::u32 i = 0; i < RAYS; i++) {
+    irr::core::vector3df start(
+        box.MinEdge.X + unit(random) * (box.MaxEdge.X - box.MinEdge.X),
+        box.MaxEdge.Y + 10.0f + unit(random) * 200.0f,
+        box.MinEdge.Z + unit(random) * (box.MaxEdge.Z - box.MinEdge.Z));
+    const bool level = i % 2 == 1;
+    irr::core::vector3df end(
+        start.X + (unit(random) - 0.5f) * (level ? 8000.0f : 2000.0f),
+        level ? box.MinEdge.Y : start.Y - 500.0f,
+        start.Z + (unit(random) - 0.5f) * (level ? 8000.0f : 2000.0f));
+    const irr::core::line3df ray(start, end);
+
+    irr::core::vector3df expected;
+    const bool expectedHit =
+        nearestHit(&triangles[0], triangles.size(), ray, expected);
+
+    irr::s32 count = 0;
+    selector->getTriangles(&buffer[0], buffer.size(), count, ray, 0, true, 0);
+    irr::core::vector3df found;
+    const bool foundHit = nearestHit(&buffer[0], count, ray, found);
+
+    if (foundHit != expectedHit ||
+        (foundHit && !found.equals(expected, 0.001f))) {
+      mismatches++;
+    }
+    if (expectedHit) hits++;
+  }
+  std::printf("%u of %u rays hit the terrain, %u differ\n", hits, RAYS,
+              mismatches);
+  CHECK(mismatches == 0);
+  CHECK(hits > RAYS / 4);
+}
+
+}  // namespace
+
+void testTerrainSelector(const std::string& dataPath) {
+  irr::IrrlichtDevice* device = irr::createDevice(
+      irr::video::EDT_NULL, irr::core::dimension2d<irr::u32>(640, 480));
+  CHECK(device != 0);
+  if (!device) return;
+  device->getLogger()->setLogLevel(irr::ELL_ERROR);
+  irr::scene::ISceneManager* smgr = device->getSceneManager();
+
+  // on a world root, as Terrain::commit() places the terrains
+  irr::scene::ISceneNode* worldRoot = smgr->addEmptySceneNode();
+  irr::scene::BCTerrainSceneNode* terrain = new irr::scene::BCTerrainSceneNode(
+      device, worldRoot, smgr, smgr->getFileSystem(), -1, 5,
+      irr::scene::ETPS_33);
+  irr::f32 xLoadScaling = 1;
+  irr::f32 zLoadScaling = 1;
+  CHECK(terrain->loadHeightMapVector(makeHeightMap(HEIGHT_MAP_SIZE),
+                                     xLoadScaling, zLoadScaling));
+  terrain->setScale(
+      irr::core::vector3df(TERRAIN_SCALE, 1.0f, TERRAIN_SCALE));
+
+  irr::scene::BCTerrainTriangleSelector* selector =
+      new irr::scene::BCTerrainTriangleSelector(terrain, 0);
+  checkRays(terrain, selector, 1);
+
+  // the cached triangles are fetched again after the terrain moves
+  terrain->setPosition(irr::core::vector3df(-3000.0f, -20.0f, 1500.0f));
+  checkRays(terrain, selector, 2);
+
+  // re-centred, which leaves the vertices and the cached triangles where they
+  // are, so the triangles are moved as they are returned
+  worldRoot->setPosition(irr::core::vector3df(2500.0f, 0.0f, -4000.0f));
+  worldRoot->updateAbsolutePosition();
+  terrain->updateAbsolutePosition();
+  checkRays(terrain, selector, 3);
+
+  selector->drop();
+  terrain->drop();
+  device->drop();
+}
@@ -0,0 +1,39 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+#ifndef __TESTS_HPP_INCLUDED__
+#define __TESTS_HPP_INCLUDED__
+
+#include <string>
+
+// The tests run by main.cpp, each checks with CHECK() from Check.hpp.
+// dataPath holds the Models and World the tests load.
+
+void testFlightRecorder(const std::string& dataPath);
+void testGUIBinding(const std::string& dataPath);
+void testIniFile(const std::string& dataPath);
+void testLoadPipeline(const std::string& dataPath);
+void testLockstep(const std::string& dataPath);
+void testModelRepository(const std::string& dataPath);
+void testNavLight(const std::string& dataPath);
+void testNMEACodec(const std::string& dataPath);
+void testProfiler(const std::string& dataPath);
+void testRecentre(const std::string& dataPath);
+void testScenarioCodec(const std::string& dataPath);
+void testTerrainSelector(const std::string& dataPath);
+
+#endif
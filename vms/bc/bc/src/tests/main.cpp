@@ -0,0 +1,97 @@
+/*   Bridge Command 5.0 Ship Simulator
+     Copyright (C) 2014 James Packer
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License version 2 as
+     published by the Free Software Foundation
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY Or FITNESS For A PARTICULAR PURPOSE.  See the
+     GNU General Public License For more details.
+
+     You should have received a copy of the GNU General Public License along
+     with this program; if not, write to the Free Software Foundation, Inc.,
+     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// Tests of the simulation, run headless on the Irrlicht NULL device. Each
+// test is run by its name, ctest runs one at a time; without a name all of
+// them run.
+//
+// bridgecommand-tests [--data path] [name...]
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "Tests.hpp"
+#include "irrlicht.h"
+
+// Global definition for ini logger
+namespace IniFile {
+irr::ILogger* irrlichtLogger = 0;
+}
+
+namespace {
+
+struct Test {
+  const char* name;
+  void (*run)(const std::string& dataPath);
+};
+
+const Test TESTS[] = {{"flight_recorder", &testFlightRecorder},
+                      {"gui_binding", &testGUIBinding},
+                      {"ini_file", &testIniFile},
+                      {"load_pipeline", &testLoadPipeline},
+                      {"lockstep", &testLockstep},
+                      {"model_repository", &testModelRepository},
+                      {"nav_light", &testNavLight},
+                      {"nmea_codec", &testNMEACodec},
+                      {"profiler", &testProfiler},
+                      {"recentre", &testRecentre},
+                      {"scenario_codec", &testScenarioCodec},
+                      {"terrain_selector", &testTerrainSelector}};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string dataPath = TEST_DATA_PATH;
+  std::vector<std::string> names;
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "--data") {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for " << option << std::endl;
+        return 2;
+      }
+      dataPath = argv[++i];
+    } else {
+      names.push_back(option);
+    }
+  }
+
+  irr::u32 run = 0;
+  for (size_t i = 0; i < sizeof(TESTS) / sizeof(TESTS[0]); i++) {
+    const Test& test = TESTS[i];
+    bool selected = names.empty();
+    for (size_t j = 0; j < names.size(); j++) {
+      selected |= names[j] == test.name;
+    }
+    if (!selected) continue;
+    int failuresBefore = BcTest::failures();
+    test.run(dataPath);
+    std::printf("%s: %s\n", test.name,
+                BcTest::failures() > failuresBefore ? "failed" : "passed");
+    std::fflush(stdout);
+    run++;
+  }
+  if (run == 0 || (!names.empty() && run != names.size())) {
+    std::cerr << "Unknown test" << std::endl;
+    return 2;
+  }
+  return BcTest::failures() > 0 ? 1 : 0;
+}
@@ -0,0 +1,415 @@
+#include "AsyncLog.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <ctime>
+
+namespace xluuv_log {
+
+namespace {
+
+const char* const CATEGORY_NAMES[LC_COUNT] = {
+    "general",   "sensors",   "ais", "actuators", "telemetry",
+    "autopilot", "colreg",    "pid", "mission"};
+
+const char* const LEVEL_NAMES[] = {"trace", "debug", "info", "warning",
+                                   "error"};
+
+// binary log layout, host byte order:
+//   header:  "XLOG" 0x01
+//   format:  'F' u32 id, u16 len, len chars
+//   record:  'R' u64 ts, u16 category, u8 level, u8 nargs, u32 format id,
+//            nargs u8 types, nargs u64 args, u8 pool_used, pool_used chars
+const char BINARY_MAGIC[] = {'X', 'L', 'O', 'G', 0x01};
+
+template <typename T>
+void put(std::FILE* out, T value) {
+  std::fwrite(&value, sizeof(value), 1, out);
+}
+
+}  // namespace
+
+const char* category_name(uint16_t category) {
+  return category < LC_COUNT ? CATEGORY_NAMES[category] : "unknown";
+}
+
+const char* level_name(uint8_t level) {
+  return level <= LL_ERROR ? LEVEL_NAMES[level] : "unknown";
+}
+
+void format_record(const char* fmt, const LogRecord& record,
+                   std::string& out) {
+  char spec[32];
+  char buffer[128];
+  std::size_t arg = 0;
+
+  for (const char* c = fmt; *c != '\0'; ++c) {
+    if (*c != '%') {
+      out.push_back(*c);
+      continue;
+    }
+    if (c[1] == '%') {
+      out.push_back('%');
+      ++c;
+      continue;
+    }
+
+    // copy flags, width and precision, drop length modifiers since all
+    // arguments have been widened to 64 bits when they were captured
+    std::size_t len = 0;
+    spec[len++] = '%';
+    ++c;
+    while (*c != '\0' && std::strchr("-+ #0123456789.*", *c) != nullptr &&
+           len < sizeof(spec) - 4) {
+      spec[len++] = *c++;
+    }
+    while (*c != '\0' && std::strchr("hlLqjzt", *c) != nullptr) ++c;
+    if (*c == '\0') break;
+
+    char conversion = *c;
+    if (arg >= record.nargs) {
+      out.append("<?>");
+      continue;
+    }
+    uint8_t type = record.arg_types[arg];
+    uint64_t raw = record.args[arg++];
+
+    int n = 0;
+    switch (conversion) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'c': {
+        int64_t value = static_cast<int64_t>(raw);
+        if (type == LA_DOUBLE) {
+          double d;
+          std::memcpy(&d, &raw, sizeof(d));
+          value = static_cast<int64_t>(d);
+        }
+        if (conversion == 'c') {
+          spec[len++] = 'c';
+          spec[len] = '\0';
+          n = std::snprintf(buffer, sizeof(buffer), spec,
+                            static_cast<int>(value));
+        } else {
+          spec[len++] = 'l';
+          spec[len++] = 'l';
+          spec[len++] = conversion == 'i' ? 'd' : conversion;
+          spec[len] = '\0';
+          n = std::snprintf(buffer, sizeof(buffer), spec,
+                            static_cast<long long>(value));
+        }
+        break;
+      }
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        double value;
+        if (type == LA_DOUBLE) {
+          std::memcpy(&value, &raw, sizeof(value));
+        } else if (type == LA_INT) {
+          value = static_cast<double>(static_cast<int64_t>(raw));
+        } else {
+          value = static_cast<double>(raw);
+        }
+        spec[len++] = conversion;
+        spec[len] = '\0';
+        n = std::snprintf(buffer, sizeof(buffer), spec, value);
+        break;
+      }
+      case 's': {
+        const char* value = type == LA_STRING ? record.pool + raw : "<?>";
+        spec[len++] = 's';
+        spec[len] = '\0';
+        // strings may be longer than the scratch buffer, format directly
+        int needed = std::snprintf(nullptr, 0, spec, value);
+        if (needed > 0) {
+          std::size_t offset = out.size();
+          out.resize(offset + needed + 1);
+          std::snprintf(&out[offset], needed + 1, spec, value);
+          out.resize(offset + needed);
+        }
+        break;
+      }
+      default: {
+        // unsupported conversion (e.g. ACE's %N/%l), print it verbatim
+        out.push_back('%');
+        out.push_back(conversion);
+        --arg;
+      }
+    }
+    if (n > 0) {
+      out.append(buffer, std::min<std::size_t>(n, sizeof(buffer) - 1));
+    }
+  }
+}
+
+Logger& Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger(std::size_t capacity) {
+  std::size_t size = 2;
+  while (size < capacity) size <<= 1;
+  this->mask_ = size - 1;
+  this->cells_ = std::vector<Cell>(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    this->cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < LC_COUNT; ++i) {
+    this->levels_[i].store(LL_DEBUG, std::memory_order_relaxed);
+  }
+  this->text_buffer_.reserve(1024);
+
+  const char* spec = std::getenv("XLUUV_LOG");
+  if (spec != nullptr) this->configure(spec);
+  const char* path = std::getenv("XLUUV_LOG_FILE");
+  if (path != nullptr) this->open_binary(path);
+
+  this->worker_ = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+  this->running_.store(false, std::memory_order_release);
+  if (this->worker_.joinable()) this->worker_.join();
+
+  LogStats s = this->stats();
+  uint64_t suppressed = 0;
+  for (std::size_t i = 0; i < LC_COUNT; ++i) suppressed += s.suppressed[i];
+  if (s.dropped > 0 || suppressed > 0) {
+    std::fprintf(stderr,
+                 "async log: %" PRIu64 " records written, %" PRIu64
+                 " dropped, %" PRIu64 " rate limited\n",
+                 s.written, s.dropped, suppressed);
+  }
+  if (this->binary_out_ != nullptr) std::fclose(this->binary_out_);
+}
+
+bool Logger::configure(const std::string& spec) {
+  bool ok = true;
+  std::size_t start = 0;
+  while (start < spec.size()) {
+    std::size_t end = spec.find(',', start);
+    if (end == std::string::npos) end = spec.size();
+    std::string entry = spec.substr(start, end - start);
+    start = end + 1;
+
+    std::size_t eq = entry.find('=');
+    if (eq == std::string::npos) {
+      ok = false;
+      continue;
+    }
+    std::string category = entry.substr(0, eq);
+    std::string value = entry.substr(eq + 1);
+    std::string level = value;
+    long rate = -1;
+    std::size_t colon = value.find(':');
+    if (colon != std::string::npos) {
+      level = value.substr(0, colon);
+      rate = std::strtol(value.c_str() + colon + 1, nullptr, 10);
+    }
+
+    int level_idx = -1;
+    for (int i = LL_TRACE; i <= LL_ERROR; ++i) {
+      if (level == LEVEL_NAMES[i]) level_idx = i;
+    }
+    if (level == "off") level_idx = LL_ERROR + 1;
+    if (level_idx < 0) {
+      ok = false;
+      continue;
+    }
+
+    bool matched = false;
+    for (uint16_t i = 0; i < LC_COUNT; ++i) {
+      if (category == "all" || category == CATEGORY_NAMES[i]) {
+        matched = true;
+        this->levels_[i].store(level_idx, std::memory_order_relaxed);
+        if (rate >= 0) {
+          this->limits_[i].max_per_second.store(rate,
+                                                std::memory_order_relaxed);
+        }
+      }
+    }
+    ok &= matched;
+  }
+  return ok;
+}
+
+void Logger::set_level(LogCategory category, LogLevel level) {
+  this->levels_[category].store(level, std::memory_order_relaxed);
+}
+
+void Logger::set_rate_limit(LogCategory category, uint32_t max_per_second) {
+  this->limits_[category].max_per_second.store(max_per_second,
+                                               std::memory_order_relaxed);
+}
+
+bool Logger::open_binary(const std::string& path) {
+  std::FILE* out = std::fopen(path.c_str(), "wb");
+  if (out == nullptr) return false;
+  std::fwrite(BINARY_MAGIC, sizeof(BINARY_MAGIC), 1, out);
+  // only safe before the first record has been written
+  this->binary_out_ = out;
+  return true;
+}
+
+bool Logger::admit(uint16_t category, uint64_t ts) {
+  RateLimit& limit = this->limits_[category];
+  uint32_t max = limit.max_per_second.load(std::memory_order_relaxed);
+  if (max == 0) return true;
+
+  uint64_t window = ts / 1000000000ull;
+  uint64_t current = limit.window.load(std::memory_order_relaxed);
+  if (current != window &&
+      limit.window.compare_exchange_strong(current, window,
+                                           std::memory_order_relaxed)) {
+    limit.count.store(0, std::memory_order_relaxed);
+  }
+  if (limit.count.fetch_add(1, std::memory_order_relaxed) >= max) {
+    limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+// bounded multi-producer queue, see D. Vyukov's MPMC queue: a cell is free
+// for the producer at position pos when its sequence equals pos and ready for
+// the consumer when its sequence equals pos + 1
+LogRecord* Logger::claim(std::size_t& pos) {
+  pos = this->enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Cell& cell = this->cells_[pos & this->mask_];
+    std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+    intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (this->enqueue_pos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        return &cell.record;
+      }
+    } else if (diff < 0) {
+      return nullptr;  // full
+    } else {
+      pos = this->enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::publish(std::size_t pos) {
+  this->cells_[pos & this->mask_].sequence.store(pos + 1,
+                                                 std::memory_order_release);
+}
+
+void Logger::capture(LogRecord& record, const char* arg) {
+  if (arg == nullptr) arg = "(null)";
+  std::size_t available = LOG_STRING_POOL - record.pool_used;
+  std::size_t len = std::strlen(arg);
+  if (available == 0) {
+    // out of pool space, point at the terminating zero of the last string
+    record.arg_types[record.nargs] = LA_STRING;
+    record.args[record.nargs++] = LOG_STRING_POOL - 1;
+    return;
+  }
+  if (len >= available) len = available - 1;
+  std::memcpy(record.pool + record.pool_used, arg, len);
+  record.pool[record.pool_used + len] = '\0';
+  record.arg_types[record.nargs] = LA_STRING;
+  record.args[record.nargs++] = record.pool_used;
+  record.pool_used += len + 1;
+}
+
+void Logger::run() {
+  while (true) {
+    bool running = this->running_.load(std::memory_order_acquire);
+    bool idle = true;
+
+    while (true) {
+      Cell& cell = this->cells_[this->dequeue_pos_ & this->mask_];
+      std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+      if (seq != this->dequeue_pos_ + 1) break;
+
+      if (this->binary_out_ != nullptr) {
+        this->write_binary(cell.record);
+      } else {
+        this->write_text(cell.record);
+      }
+      cell.sequence.store(this->dequeue_pos_ + this->mask_ + 1,
+                          std::memory_order_release);
+      ++this->dequeue_pos_;
+      this->written_.fetch_add(1, std::memory_order_relaxed);
+      idle = false;
+    }
+
+    if (idle) {
+      if (!running) break;
+      if (this->binary_out_ != nullptr) std::fflush(this->binary_out_);
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  if (this->binary_out_ != nullptr) std::fflush(this->binary_out_);
+}
+
+void Logger::write_text(const LogRecord& record) {
+  this->text_buffer_.clear();
+  format_record(record.fmt, record, this->text_buffer_);
+  std::fwrite(this->text_buffer_.data(), 1, this->text_buffer_.size(),
+              stderr);
+}
+
+void Logger::write_binary(const LogRecord& record) {
+  std::FILE* out = this->binary_out_;
+  auto it = this->format_ids_.find(record.fmt);
+  uint32_t id;
+  if (it == this->format_ids_.end()) {
+    id = this->format_ids_.size();
+    this->format_ids_.emplace(record.fmt, id);
+    uint16_t len = std::strlen(record.fmt);
+    put<char>(out, 'F');
+    put(out, id);
+    put(out, len);
+    std::fwrite(record.fmt, 1, len, out);
+  } else {
+    id = it->second;
+  }
+
+  put<char>(out, 'R');
+  put(out, record.ts);
+  put(out, record.category);
+  put(out, record.level);
+  put(out, record.nargs);
+  put(out, id);
+  std::fwrite(record.arg_types, 1, record.nargs, out);
+  std::fwrite(record.args, sizeof(uint64_t), record.nargs, out);
+  put(out, record.pool_used);
+  std::fwrite(record.pool, 1, record.pool_used, out);
+}
+
+void Logger::flush() {
+  std::size_t target = this->enqueue_pos_.load(std::memory_order_acquire);
+  while (this->written_.load(std::memory_order_acquire) < target) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (this->binary_out_ == nullptr) std::fflush(stderr);
+}
+
+LogStats Logger::stats() const {
+  LogStats s{};
+  s.written = this->written_.load(std::memory_order_relaxed);
+  s.dropped = this->dropped_.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < LC_COUNT; ++i) {
+    s.suppressed[i] =
+        this->limits_[i].suppressed.load(std::memory_order_relaxed);
+  }
+  return s;
+}
+
+}  // namespace xluuv_log
@@ -0,0 +1,229 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+// Asynchronous logging for the DDS participants' data paths.
+//
+// Call sites only copy the format string pointer and the raw argument values
+// into a preallocated ring buffer, formatting and I/O happen on a background
+// thread. Levels and rate limits are set per category through the XLUUV_LOG
+// environment variable, e.g.
+//
+//   XLUUV_LOG="all=info,sensors=debug:10,pid=warning"
+//
+// sets every category to info, lets sensor reports through at debug level but
+// at most 10 per second, and silences the PID debug output. If XLUUV_LOG_FILE
+// is set, records are written to that file in a compact binary form instead of
+// being formatted, `xluuv-logdecode` turns such a file back into text.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace xluuv_log {
+
+enum LogLevel : uint8_t { LL_TRACE, LL_DEBUG, LL_INFO, LL_WARNING, LL_ERROR };
+
+enum LogCategory : uint16_t {
+  LC_GENERAL,
+  LC_SENSORS,
+  LC_AIS,
+  LC_ACTUATORS,
+  LC_TELEMETRY,
+  LC_AUTOPILOT,
+  LC_COLREG,
+  LC_PID,
+  LC_MISSION,
+  LC_COUNT
+};
+
+enum LogArgType : uint8_t { LA_INT, LA_UINT, LA_DOUBLE, LA_STRING };
+
+const char* category_name(uint16_t category);
+const char* level_name(uint8_t level);
+
+constexpr std::size_t LOG_MAX_ARGS = 16;
+constexpr std::size_t LOG_STRING_POOL = 96;
+
+// A single deferred log call. Numeric arguments are stored as raw 64 bit
+// values, string arguments are copied into the record's string pool since the
+// caller's buffer is gone by the time the record is formatted.
+struct LogRecord {
+  uint64_t ts;  // nanoseconds since epoch
+  const char* fmt;
+  uint16_t category;
+  uint8_t level;
+  uint8_t nargs;
+  uint8_t pool_used;
+  uint8_t arg_types[LOG_MAX_ARGS];
+  uint64_t args[LOG_MAX_ARGS];
+  char pool[LOG_STRING_POOL];
+};
+
+// formats a record the way printf would, appending to out
+void format_record(const char* fmt, const LogRecord& record, std::string& out);
+
+struct LogStats {
+  uint64_t written;
+  uint64_t dropped;  // ring buffer was full
+  uint64_t suppressed[LC_COUNT];  // rate limited
+};
+
+class Logger {
+ public:
+  static Logger& instance();
+
+  // the ring buffer capacity is rounded up to a power of two
+  explicit Logger(std::size_t capacity = 8192);
+  ~Logger();
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  // parse a "category=level[:max_per_second],..." specification
+  bool configure(const std::string& spec);
+  void set_level(LogCategory category, LogLevel level);
+  void set_rate_limit(LogCategory category, uint32_t max_per_second);
+  // write binary records to path instead of formatted text to stderr
+  bool open_binary(const std::string& path);
+
+  bool enabled(uint16_t category, uint8_t level) const {
+    return level >= this->levels_[category].load(std::memory_order_relaxed);
+  }
+
+  template <typename... Args>
+  void log(uint16_t category, uint8_t level, const char* fmt,
+           const Args&... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+    uint64_t ts = now_ns();
+    if (!this->admit(category, ts)) return;
+
+    std::size_t pos;
+    LogRecord* record = this->claim(pos);
+    if (record == nullptr) {
+      this->dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    record->ts = ts;
+    record->fmt = fmt;
+    record->category = category;
+    record->level = level;
+    record->nargs = 0;
+    record->pool_used = 0;
+    capture_all(*record, args...);
+    this->publish(pos);
+  }
+
+  // block until every record logged so far has been written
+  void flush();
+  LogStats stats() const;
+
+ private:
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    LogRecord record;
+  };
+
+  struct RateLimit {
+    std::atomic<uint32_t> max_per_second{0};
+    std::atomic<uint64_t> window{0};
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint64_t> suppressed{0};
+  };
+
+  static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  bool admit(uint16_t category, uint64_t ts);
+  LogRecord* claim(std::size_t& pos);
+  void publish(std::size_t pos);
+  void run();
+  void write_text(const LogRecord& record);
+  void write_binary(const LogRecord& record);
+
+  static void capture_all(LogRecord&) {}
+  template <typename T, typename... Rest>
+  static void capture_all(LogRecord& record, const T& arg,
+                          const Rest&... rest) {
+    capture(record, arg);
+    capture_all(record, rest...);
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  capture(LogRecord& record, T arg) {
+    double d = arg;
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    record.arg_types[record.nargs] = LA_DOUBLE;
+    record.args[record.nargs++] = bits;
+  }
+
+  template <typename T>
+  static typename std::enable_if<(std::is_integral<T>::value ||
+                                  std::is_enum<T>::value) &&
+                                 std::is_signed<T>::value>::type
+  capture(LogRecord& record, T arg) {
+    record.arg_types[record.nargs] = LA_INT;
+    record.args[record.nargs++] = static_cast<uint64_t>(
+        static_cast<int64_t>(arg));
+  }
+
+  template <typename T>
+  static typename std::enable_if<(std::is_integral<T>::value ||
+                                  std::is_enum<T>::value) &&
+                                 !std::is_signed<T>::value>::type
+  capture(LogRecord& record, T arg) {
+    record.arg_types[record.nargs] = LA_UINT;
+    record.args[record.nargs++] = static_cast<uint64_t>(arg);
+  }
+
+  static void capture(LogRecord& record, const char* arg);
+  static void capture(LogRecord& record, const std::string& arg) {
+    capture(record, arg.c_str());
+  }
+
+  std::size_t mask_;
+  std::vector<Cell> cells_;
+  std::atomic<std::size_t> enqueue_pos_{0};
+  std::size_t dequeue_pos_ = 0;
+
+  std::atomic<uint8_t> levels_[LC_COUNT];
+  RateLimit limits_[LC_COUNT];
+
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> written_{0};
+
+  std::FILE* binary_out_ = nullptr;
+  // format string ids already written to the binary log
+  std::unordered_map<const char*, uint32_t> format_ids_;
+  std::string text_buffer_;
+
+  std::atomic<bool> running_{true};
+  std::thread worker_;
+};
+
+}  // namespace xluuv_log
+
+// Log through the asynchronous backend, the arguments are only evaluated if
+// the category is enabled at that level.
+#define XLOG(category, level, ...)                                        \
+  do {                                                                    \
+    if (::xluuv_log::Logger::instance().enabled(::xluuv_log::category,    \
+                                                ::xluuv_log::level)) {    \
+      ::xluuv_log::Logger::instance().log(::xluuv_log::category,          \
+                                          ::xluuv_log::level, __VA_ARGS__); \
+    }                                                                     \
+  } while (0)
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef BC_PROXY_MESSAGES_H
 #define BC_PROXY_MESSAGES_H
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <boost/serialization/string.hpp>
 
@@ -91,4 +95,94 @@ struct AivdmMessage {
   }
 };
 
+// Fixed size form of AivdmMessage for the shared memory transport, which
+// copies messages as-is instead of serializing them.
+struct AivdmRecord {
+  char message[96];  // NMEA sentences are at most 82 characters
+  uint32_t message_type;
+  uint32_t mmsi;
+  uint32_t navigation_status;
+  double latitude;
+  double longitude;
+  double rate_of_turn;
+  double speed_over_ground;
+  double course_over_ground;
+  double true_heading;
+};
+
+inline AivdmRecord to_record(const AivdmMessage& msg) {
+  AivdmRecord record;
+  std::size_t len = std::min(msg.message.size(), sizeof(record.message) - 1);
+  std::memcpy(record.message, msg.message.data(), len);
+  record.message[len] = '\0';
+  record.message_type = msg.message_type;
+  record.mmsi = msg.mmsi;
+  record.navigation_status = msg.navigation_status;
+  record.latitude = msg.latitude;
+  record.longitude = msg.longitude;
+  record.rate_of_turn = msg.rate_of_turn;
+  record.speed_over_ground = msg.speed_over_ground;
+  record.course_over_ground = msg.course_over_ground;
+  record.true_heading = msg.true_heading;
+  return record;
+}
+
+inline AivdmMessage from_record(const AivdmRecord& record) {
+  AivdmMessage msg;
+  msg.message = record.message;
+  msg.message_type = record.message_type;
+  msg.mmsi = record.mmsi;
+  msg.navigation_status = record.navigation_status;
+  msg.latitude = record.latitude;
+  msg.longitude = record.longitude;
+  msg.rate_of_turn = record.rate_of_turn;
+  msg.speed_over_ground = record.speed_over_ground;
+  msg.course_over_ground = record.course_over_ground;
+  msg.true_heading = record.true_heading;
+  return msg;
+}
+
+// The shared memory transport copies these as they are, between BC and the
+// proxies built from separate copies of this file. Any change to them needs
+// a new SHM_LAYOUT_VERSION in ShmChannel.h.
+static_assert(offsetof(SensorReport, course_over_ground) == 0 &&
+                  offsetof(SensorReport, depth) == 8 &&
+                  offsetof(SensorReport, gnss_1) == 16 &&
+                  offsetof(SensorReport, gnss_2) == 32 &&
+                  offsetof(SensorReport, gnss_3) == 48 &&
+                  offsetof(SensorReport, heading) == 64 &&
+                  offsetof(SensorReport, rate_of_turn) == 72 &&
+                  offsetof(SensorReport, rpm_port) == 80 &&
+                  offsetof(SensorReport, rpm_stbd) == 88 &&
+                  offsetof(SensorReport, rudder_angle) == 96 &&
+                  offsetof(SensorReport, speed) == 104 &&
+                  offsetof(SensorReport, speed_over_ground) == 112 &&
+                  offsetof(SensorReport, throttle_port) == 120 &&
+                  offsetof(SensorReport, throttle_stbd) == 128 &&
+                  offsetof(SensorReport, depth_under_keel) == 136 &&
+                  offsetof(SensorReport, ship_depth) == 144 &&
+                  offsetof(SensorReport, buoyancy) == 152 &&
+                  sizeof(SensorReport) == 160,
+              "SensorReport layout changed");
+static_assert(offsetof(ActuatorCommands, rudder_angle) == 0 &&
+                  offsetof(ActuatorCommands, engine_throttle_port) == 8 &&
+                  offsetof(ActuatorCommands, engine_throttle_stbd) == 16 &&
+                  offsetof(ActuatorCommands, thruster_throttle_bow) == 24 &&
+                  offsetof(ActuatorCommands, thruster_throttle_stern) == 32 &&
+                  offsetof(ActuatorCommands, ballast_tank_pump) == 40 &&
+                  sizeof(ActuatorCommands) == 48,
+              "ActuatorCommands layout changed");
+static_assert(offsetof(AivdmRecord, message) == 0 &&
+                  offsetof(AivdmRecord, message_type) == 96 &&
+                  offsetof(AivdmRecord, mmsi) == 100 &&
+                  offsetof(AivdmRecord, navigation_status) == 104 &&
+                  offsetof(AivdmRecord, latitude) == 112 &&
+                  offsetof(AivdmRecord, longitude) == 120 &&
+                  offsetof(AivdmRecord, rate_of_turn) == 128 &&
+                  offsetof(AivdmRecord, speed_over_ground) == 136 &&
+                  offsetof(AivdmRecord, course_over_ground) == 144 &&
+                  offsetof(AivdmRecord, true_heading) == 152 &&
+                  sizeof(AivdmRecord) == 160,
+              "AivdmRecord layout changed");
+
 #endif
@@ -0,0 +1,152 @@
+#ifndef READER_SUPPORT_H
+#define READER_SUPPORT_H
+
+// Shared DataReader plumbing for the autopilot and the proxies: named QoS
+// profiles applied on both ends of a topic, batched take() on loaned samples
+// instead of one take_next_sample() per callback, and counters for the
+// reader status callbacks.
+
+#include <ace/Log_Msg.h>
+#include <dds/DdsDcpsInfrastructureC.h>
+#include <dds/DdsDcpsPublicationC.h>
+#include <dds/DdsDcpsSubscriptionC.h>
+
+#include <atomic>
+#include <cstdint>
+
+enum QosProfile {
+  // high-rate state such as Sensors and Actuators, only the latest sample per
+  // instance matters and stale samples are never retransmitted
+  QOS_STATE,
+  // routes, missions and commands, every sample is delivered in order
+  QOS_COMMAND,
+  // reports and AIS, reliable with a bounded history so a burst can't queue
+  // up without limit
+  QOS_EVENTS
+};
+
+#define QOS_EVENTS_DEPTH 32
+
+// Sensors are published continuously by BC, a gap this long means the link
+// or the simulation is gone
+#define SENSORS_DEADLINE_SEC 1
+
+// samples taken per take() call
+#define TAKE_BATCH_SIZE 32
+
+// deadline_sec enables deadline monitoring, it must be set on both ends
+template <typename Qos>
+void apply_common_profile(Qos& qos, QosProfile profile, int deadline_sec) {
+  switch (profile) {
+    case QOS_STATE:
+      qos.history.kind = DDS::KEEP_LAST_HISTORY_QOS;
+      qos.history.depth = 1;
+      break;
+    case QOS_COMMAND:
+      qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+      qos.history.kind = DDS::KEEP_ALL_HISTORY_QOS;
+      break;
+    case QOS_EVENTS:
+      qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+      qos.history.kind = DDS::KEEP_LAST_HISTORY_QOS;
+      qos.history.depth = QOS_EVENTS_DEPTH;
+      break;
+  }
+  if (deadline_sec > 0) {
+    qos.deadline.period.sec = deadline_sec;
+    qos.deadline.period.nanosec = 0;
+  }
+}
+
+inline void apply_profile(DDS::DataReaderQos& qos, QosProfile profile,
+                          int deadline_sec = 0) {
+  apply_common_profile(qos, profile, deadline_sec);
+  if (profile == QOS_STATE) {
+    qos.reliability.kind = DDS::BEST_EFFORT_RELIABILITY_QOS;
+  }
+}
+
+// writers keep offering reliable delivery so that readers with either
+// reliability setting match, state readers request best effort
+inline void apply_profile(DDS::DataWriterQos& qos, QosProfile profile,
+                          int deadline_sec = 0) {
+  apply_common_profile(qos, profile, deadline_sec);
+  if (profile == QOS_STATE) {
+    qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+  }
+}
+
+// Counters of a single DataReader, fed by its listener.
+class ReaderStats {
+ public:
+  explicit ReaderStats(const char* topic)
+      : topic_(topic),
+        samples_(0),
+        batches_(0),
+        deadline_missed_(0),
+        lost_(0),
+        rejected_(0) {}
+
+  void on_deadline_missed(const DDS::RequestedDeadlineMissedStatus& status) {
+    this->deadline_missed_.store(status.total_count);
+    ACE_ERROR((LM_WARNING,
+               ACE_TEXT("WARNING: %C: no sample within the deadline (%d)\n"),
+               this->topic_, status.total_count));
+  }
+
+  void on_sample_lost(const DDS::SampleLostStatus& status) {
+    this->lost_.store(status.total_count);
+    ACE_ERROR((LM_WARNING, ACE_TEXT("WARNING: %C: %d samples lost\n"),
+               this->topic_, status.total_count));
+  }
+
+  void on_sample_rejected(const DDS::SampleRejectedStatus& status) {
+    this->rejected_.store(status.total_count);
+  }
+
+  void add_batch(uint32_t samples) {
+    this->batches_.fetch_add(1, std::memory_order_relaxed);
+    this->samples_.fetch_add(samples, std::memory_order_relaxed);
+  }
+
+  uint64_t samples() const { return this->samples_.load(); }
+  uint64_t batches() const { return this->batches_.load(); }
+  uint32_t deadline_missed() const { return this->deadline_missed_.load(); }
+  uint32_t lost() const { return this->lost_.load(); }
+  uint32_t rejected() const { return this->rejected_.load(); }
+
+ private:
+  const char* topic_;
+  std::atomic<uint64_t> samples_;
+  std::atomic<uint64_t> batches_;
+  std::atomic<uint32_t> deadline_missed_;
+  std::atomic<uint32_t> lost_;
+  std::atomic<uint32_t> rejected_;
+};
+
+// Drains the reader in batches of loaned samples and calls
+// handler(sample, info) for every sample carrying data, returns true on error.
+template <typename Seq, typename Reader, typename Handler>
+bool take_all(Reader* reader, ReaderStats& stats, Handler handler) {
+  Seq samples;
+  DDS::SampleInfoSeq infos;
+  for (;;) {
+    const DDS::ReturnCode_t error =
+        reader->take(samples, infos, TAKE_BATCH_SIZE, DDS::ANY_SAMPLE_STATE,
+                     DDS::ANY_VIEW_STATE, DDS::ANY_INSTANCE_STATE);
+    if (error == DDS::RETCODE_NO_DATA) return false;
+    if (error != DDS::RETCODE_OK) return true;
+
+    const CORBA::ULong taken = samples.length();
+    stats.add_batch(taken);
+    for (CORBA::ULong i = 0; i < taken; ++i) {
+      if (infos[i].valid_data) handler(samples[i], infos[i]);
+    }
+    reader->return_loan(samples, infos);
+
+    // a short batch means the reader is empty, save the extra call
+    if (taken < TAKE_BATCH_SIZE) return false;
+  }
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "AisTargetStore.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Marmaths.h"
+
+AisTargetStore::AisTargetStore(ACE_hrtime_t ttl, double cell_size_deg)
+    : ttl_(ttl),
+      cell_size_(cell_size_deg),
+      rows_(static_cast<int64_t>(std::ceil(180.0 / cell_size_deg))),
+      cols_(static_cast<int64_t>(std::ceil(360.0 / cell_size_deg))),
+      max_sog_(0.0),
+      last_eviction_(0),
+      evicted_(0),
+      examined_(0) {}
+
+AisTargetStore::CellKey AisTargetStore::cell_of(double lat, double lon) const {
+  int64_t row =
+      static_cast<int64_t>(std::floor((lat + 90.0) / this->cell_size_));
+  int64_t col =
+      static_cast<int64_t>(std::floor((lon + 180.0) / this->cell_size_));
+  row = std::min(std::max(row, int64_t(0)), this->rows_ - 1);
+  col = ((col % this->cols_) + this->cols_) % this->cols_;
+  return row * this->cols_ + col;
+}
+
+void AisTargetStore::remove_from_cell(CellKey cell, uint32_t index) {
+  auto found = this->grid_.find(cell);
+  if (found == this->grid_.end()) return;
+  std::vector<uint32_t>& members = found->second;
+  auto member = std::find(members.begin(), members.end(), index);
+  if (member == members.end()) return;
+  members.erase(member);
+  if (members.empty()) this->grid_.erase(found);
+}
+
+void AisTargetStore::remove_at(uint32_t index) {
+  uint32_t last = static_cast<uint32_t>(this->targets_.size() - 1);
+  this->remove_from_cell(this->target_cells_[index], index);
+  this->index_.erase(this->targets_[index].mmsi);
+
+  if (index != last) {
+    // move the last target into the gap and fix up its references
+    this->targets_[index] = this->targets_[last];
+    this->target_cells_[index] = this->target_cells_[last];
+    this->index_[this->targets_[index].mmsi] = index;
+    std::vector<uint32_t>& members = this->grid_[this->target_cells_[index]];
+    std::replace(members.begin(), members.end(), last, index);
+  }
+  this->targets_.pop_back();
+  this->target_cells_.pop_back();
+}
+
+void AisTargetStore::update(const PhysicalState::AivdmMessage& message,
+                            ACE_hrtime_t now) {
+  AisTarget target{now,
+                   message.navigation_status,
+                   message.mmsi,
+                   message.latitude,
+                   message.longitude,
+                   message.rate_of_turn,
+                   message.course_over_ground,
+                   message.speed_over_ground};
+  CellKey cell = this->cell_of(target.fix_lat_, target.fix_lon_);
+  this->max_sog_ = std::max(this->max_sog_, target.fix_sog_);
+
+  auto found = this->index_.find(target.mmsi);
+  if (found == this->index_.end()) {
+    uint32_t index = static_cast<uint32_t>(this->targets_.size());
+    this->targets_.push_back(target);
+    this->target_cells_.push_back(cell);
+    this->index_[target.mmsi] = index;
+    this->grid_[cell].push_back(index);
+    return;
+  }
+
+  uint32_t index = found->second;
+  this->targets_[index] = target;
+  if (this->target_cells_[index] != cell) {
+    this->remove_from_cell(this->target_cells_[index], index);
+    this->target_cells_[index] = cell;
+    this->grid_[cell].push_back(index);
+  }
+}
+
+void AisTargetStore::evict_expired(ACE_hrtime_t now) {
+  if (now - this->last_eviction_ < EVICTION_INTERVAL) return;
+  this->last_eviction_ = now;
+
+  double max_sog = 0.0;
+  for (uint32_t i = static_cast<uint32_t>(this->targets_.size()); i-- > 0;) {
+    if (now - this->targets_[i].fix_ts_ > this->ttl_) {
+      this->remove_at(i);
+      ++this->evicted_;
+    } else {
+      max_sog = std::max(max_sog, this->targets_[i].fix_sog_);
+    }
+  }
+  this->max_sog_ = max_sog;
+}
+
+void AisTargetStore::query(double lat, double lon, double radius,
+                           std::vector<const AisTarget*>& targets) {
+  targets.clear();
+
+  // no target can have moved further than the fastest one could within the
+  // time to live
+  double reach = radius + this->max_sog_ * this->ttl_ * 1e-9;
+  double lat_reach = reach / (EARTH_RADIUS * DEG_TO_RAD);
+  double widest_lat = std::min(89.0, std::abs(lat) + lat_reach);
+  double lon_reach = lat_reach / std::cos(widest_lat * DEG_TO_RAD);
+
+  int64_t row_min = static_cast<int64_t>(
+      std::floor((lat - lat_reach + 90.0) / this->cell_size_));
+  int64_t row_max = static_cast<int64_t>(
+      std::floor((lat + lat_reach + 90.0) / this->cell_size_));
+  row_min = std::max(row_min, int64_t(0));
+  row_max = std::min(row_max, this->rows_ - 1);
+  int64_t col_min = static_cast<int64_t>(
+      std::floor((lon - lon_reach + 180.0) / this->cell_size_));
+  int64_t col_max = static_cast<int64_t>(
+      std::floor((lon + lon_reach + 180.0) / this->cell_size_));
+  if (col_max - col_min >= this->cols_) {
+    col_min = 0;
+    col_max = this->cols_ - 1;
+  }
+
+  for (int64_t row = row_min; row <= row_max; ++row) {
+    for (int64_t col = col_min; col <= col_max; ++col) {
+      int64_t wrapped = ((col % this->cols_) + this->cols_) % this->cols_;
+      auto cell = this->grid_.find(row * this->cols_ + wrapped);
+      if (cell == this->grid_.end()) continue;
+      for (uint32_t index : cell->second) {
+        targets.push_back(&this->targets_[index]);
+      }
+    }
+  }
+
+  // keep the order of the former map so ties resolve the same way
+  std::sort(targets.begin(), targets.end(),
+            [](const AisTarget* a, const AisTarget* b) {
+              return a->mmsi < b->mmsi;
+            });
+  this->examined_ = targets.size();
+}
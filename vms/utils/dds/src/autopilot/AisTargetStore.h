@@ -0,0 +1,77 @@
+#ifndef AUTOPILOT_AIS_TARGET_STORE_H
+#define AUTOPILOT_AIS_TARGET_STORE_H
+
+#include <ace/OS_NS_time.h>
+#include <tao/Basic_Types.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "PhysicalStateC.h"
+
+struct AisTarget {
+  ACE_hrtime_t fix_ts_;
+  PhysicalState::NavigationStatus fix_status_;
+  CORBA::Long mmsi;
+  double fix_lat_;
+  double fix_lon_;
+  double fix_rot_;  // rot is not available in BC
+  double fix_cog_;  // in degrees
+  double fix_sog_;  // in meters/s
+};
+
+// AIS targets tracked by the autopilot. Targets are dropped once their last
+// fix is older than the time to live, and are binned by fix position into a
+// uniform lat/lon grid so that COLREG only looks at the neighbourhood of own
+// ship instead of every vessel seen during the mission.
+class AisTargetStore {
+ public:
+  AisTargetStore(ACE_hrtime_t ttl, double cell_size_deg);
+
+  void update(const PhysicalState::AivdmMessage& message, ACE_hrtime_t now);
+
+  // drop targets without a fix within the time to live, the sweep only runs
+  // once per EVICTION_INTERVAL so this can be called every cycle
+  void evict_expired(ACE_hrtime_t now);
+
+  // collect all targets that may currently be within radius meters of the
+  // position, allowing for the distance they can have covered since their
+  // fix. The caller still checks the exact distance. Targets are returned in
+  // MMSI order.
+  void query(double lat, double lon, double radius,
+             std::vector<const AisTarget*>& targets);
+
+  std::size_t size() const { return this->targets_.size(); }
+  uint64_t evicted() const { return this->evicted_; }
+  // targets returned by the last query
+  std::size_t examined() const { return this->examined_; }
+
+ private:
+  typedef int64_t CellKey;
+
+  CellKey cell_of(double lat, double lon) const;
+  void remove_from_cell(CellKey cell, uint32_t index);
+  void remove_at(uint32_t index);
+
+  static constexpr ACE_hrtime_t EVICTION_INTERVAL = 1000000000;
+
+  ACE_hrtime_t ttl_;
+  double cell_size_;
+  int64_t rows_;
+  int64_t cols_;
+
+  // targets are stored densely, removal moves the last target into the gap
+  std::vector<AisTarget> targets_;
+  std::vector<CellKey> target_cells_;
+  std::unordered_map<CORBA::Long, uint32_t> index_;
+  std::unordered_map<CellKey, std::vector<uint32_t>> grid_;
+
+  // fastest target held, bounds how far a target can drift from its cell
+  double max_sog_;
+  ACE_hrtime_t last_eviction_;
+  uint64_t evicted_;
+  std::size_t examined_;
+};
+
+#endif
@@ -2,7 +2,9 @@
 
 #include "PhysicalStateTypeSupportC.h"
 
-AivdmMessageDataReaderListenerImpl::AivdmMessageDataReaderListenerImpl() {
+AivdmMessageDataReaderListenerImpl::AivdmMessageDataReaderListenerImpl(
+    CoSimChannel* cosim)
+    : cosim_(cosim), stats_("AivdmMessage") {
   this->new_messages_available_ = false;
   this->latest_messages_ = std::vector<PhysicalState::AivdmMessage>();
 }
@@ -23,14 +25,18 @@ CORBA::Boolean AivdmMessageDataReaderListenerImpl::new_messages_available() {
 
 void AivdmMessageDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void AivdmMessageDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void AivdmMessageDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void AivdmMessageDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -39,7 +45,9 @@ void AivdmMessageDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void AivdmMessageDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void AivdmMessageDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -53,22 +61,20 @@ void AivdmMessageDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  PhysicalState::AivdmMessage ais_message;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(ais_message, info);
-
   // proxy for BC, forward message to CCC
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      this->new_messages_available_ = true;
-      this->latest_messages_.push_back(ais_message);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<PhysicalState::AivdmMessageSeq>(
+      reader_i.in(), this->stats_,
+      [this](const PhysicalState::AivdmMessage &ais_message,
+             const DDS::SampleInfo &) {
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->new_messages_available_ = true;
+        this->latest_messages_.push_back(ais_message);
+        if (this->cosim_ != nullptr) this->cosim_->count_received(COSIM_AIVDM);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
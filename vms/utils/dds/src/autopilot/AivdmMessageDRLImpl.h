@@ -9,12 +9,15 @@
 #include <tao/Basic_Types.h>
 #include <vector>
 
+#include "../cosim/CoSimChannel.h"
+#include "../ReaderSupport.h"
 #include "PhysicalStateC.h"
 
 class AivdmMessageDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
-  AivdmMessageDataReaderListenerImpl();
+  // counts the messages taken on the co-simulation channel if given
+  explicit AivdmMessageDataReaderListenerImpl(CoSimChannel* cosim = nullptr);
   virtual ~AivdmMessageDataReaderListenerImpl() = default;
 
   std::vector<PhysicalState::AivdmMessage> get_messages();
@@ -52,6 +55,8 @@ class AivdmMessageDataReaderListenerImpl
   std::vector<PhysicalState::AivdmMessage> latest_messages_;
   CORBA::Boolean new_messages_available_;
   ACE_Mutex lock_;
+  CoSimChannel* cosim_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -14,7 +14,8 @@
 #include "AutopilotTypeSupportImpl.h"
 
 AutopilotCommandDataReaderListenerImpl::
-    AutopilotCommandDataReaderListenerImpl() {
+    AutopilotCommandDataReaderListenerImpl()
+    : stats_("AutopilotCommand") {
   this->command_changed_ = false;
   this->latest_commands_ = std::vector<Autopilot::AutopilotCommand>();
 }
@@ -38,14 +39,18 @@ AutopilotCommandDataReaderListenerImpl::new_commands_available() {
 
 void AutopilotCommandDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void AutopilotCommandDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void AutopilotCommandDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void AutopilotCommandDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -54,7 +59,9 @@ void AutopilotCommandDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void AutopilotCommandDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void AutopilotCommandDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -68,21 +75,18 @@ void AutopilotCommandDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::AutopilotCommand command;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(command, info);
-
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      this->command_changed_ = true;
-      this->latest_commands_.push_back(command);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::AutopilotCommandSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::AutopilotCommand &command,
+             const DDS::SampleInfo &) {
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->command_changed_ = true;
+        this->latest_commands_.push_back(command);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
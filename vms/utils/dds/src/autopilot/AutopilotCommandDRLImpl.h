@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "../ReaderSupport.h"
 #include "AutopilotC.h"
 
 class AutopilotCommandDataReaderListenerImpl
@@ -54,6 +55,7 @@ class AutopilotCommandDataReaderListenerImpl
   std::vector<Autopilot::AutopilotCommand> latest_commands_;
   CORBA::Boolean command_changed_;
   ACE_Mutex lock_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -6,14 +6,26 @@
 #include <tao/Basic_Types.h>
 
 #include <algorithm>
-#include <array>
 #include <cmath>
 #include <tuple>
 
+#include "../AsyncLog.h"
 #include "AutopilotC.h"
+#include "CpaEngine.h"
+#include "LocalFrame.h"
 #include "Marmaths.h"
-
-AutopilotController::AutopilotController() {
+#include "PositionEstimator.h"
+
+AutopilotController::AutopilotController(ControlClock& clock,
+                                         ACE_hrtime_t period,
+                                         CORBA::Double colreg_check_radius,
+                                         CORBA::Double ais_ttl,
+                                         PositionFilter position_filter)
+    : clock_(clock),
+      colreg_check_radius_(colreg_check_radius),
+      ais_targets_(static_cast<ACE_hrtime_t>(ais_ttl * 1e9),
+                   AIS_GRID_CELL_DEG),
+      position_estimator_(make_position_estimator(position_filter)) {
   this->routes_ = std::unordered_map<CORBA::Long, Autopilot::Route>();
   this->dive_procedures_ =
       std::unordered_map<CORBA::Long, Autopilot::DiveProcedure>();
@@ -39,6 +51,12 @@ AutopilotController::AutopilotController() {
 
   // if not overriden by route, never exceed 5m/s
   this->sog_max_ = 5.0;
+
+  CORBA::Double period_sec = period * 1e-9;
+  this->engine_throttle_pid_.set_period(period_sec);
+  this->bow_thruster_pid_.set_period(period_sec);
+  this->stern_thruster_pid_.set_period(period_sec);
+  this->ballast_tank_pid_.set_period(period_sec);
 }
 
 CORBA::Boolean AutopilotController::is_report_available() {
@@ -84,7 +102,7 @@ Autopilot::APReport AutopilotController::get_report() {
     this->report_.tgt_depth = this->active_dive_procedure_.depth;
   }
 
-  this->last_report_ts_ = ACE_OS::gethrtime();
+  this->last_report_ts_ = this->clock_.now();
   this->report_available_ = false;
   return this->report_;
 }
@@ -132,6 +150,7 @@ CORBA::Boolean AutopilotController::activate_route(CORBA::Long route_id) {
   Autopilot::WaypointSeq waypoint_seq = new_route.waypoints;
 
   this->waypoint_seq_ = waypoint_seq;
+  this->route_geometry_.build(waypoint_seq);
   this->sog_max_ = new_route.planned_speed * KNT_TO_MS;
 
   if (this->route_is_set_ && this->route_id_ == new_route.id) {
@@ -141,6 +160,10 @@ CORBA::Boolean AutopilotController::activate_route(CORBA::Long route_id) {
     if (this->current_waypoint_index_ >= waypoint_seq_.length()) {
       this->current_waypoint_index_ = waypoint_seq_.length() - 1;
     }
+    if (!this->route_geometry_.has_legs()) {
+      this->current_waypoint_index_ = 0;
+    }
+    this->route_geometry_.seek(this->current_waypoint_index_);
     this->current_waypoint_ =
         this->waypoint_seq_[this->current_waypoint_index_];
   } else {
@@ -152,24 +175,14 @@ CORBA::Boolean AutopilotController::activate_route(CORBA::Long route_id) {
   this->route_is_set_ = true;
   this->route_id_ = new_route.id;
 
-  // pre-compute the length of all legs
-  this->leg_len_seq_.length(waypoint_seq.length());
-  for (uint i=0; i < waypoint_seq.length() - 1; ++i) {
-    Autopilot::Coordinates from = waypoint_seq[i].coords;
-    Autopilot::Coordinates to = waypoint_seq[i + 1].coords;
-    this->leg_len_seq_[i] = distance_harvesine(from.latitude, from.longitude,
-                                               to.latitude, to.longitude);
-  }
-
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("Activated route:\n"
-                      "    route name:      %s\n"
-                      "    route length:    %i\n"
-                      "    active waypoint: %s\n"
-                      "    waypoint index:  %i\n"),
-             (const char*)new_route.name, waypoint_seq.length(),
-             (const char*)this->current_waypoint_.name,
-             this->current_waypoint_index_));
+  XLOG(LC_AUTOPILOT, LL_DEBUG, "Activated route:\n"
+                               "    route name:      %s\n"
+                               "    route length:    %i\n"
+                               "    active waypoint: %s\n"
+                               "    waypoint index:  %i\n",
+       (const char*)new_route.name, waypoint_seq.length(),
+       (const char*)this->current_waypoint_.name,
+       this->current_waypoint_index_);
 
   return false;
 }
@@ -411,12 +424,11 @@ CORBA::Boolean AutopilotController::set_route(Autopilot::Route new_route) {
     this->activate_route(new_route.id);
   }
 
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("Stored route:\n"
-                      "    route id:        %i\n"
-                      "    route name:      %s\n"
-                      "    route length:    %i\n"),
-             new_route.id, (const char*)new_route.name, waypoint_seq.length()));
+  XLOG(LC_AUTOPILOT, LL_DEBUG, "Stored route:\n"
+                               "    route id:        %i\n"
+                               "    route name:      %s\n"
+                               "    route length:    %i\n",
+       new_route.id, (const char*)new_route.name, waypoint_seq.length());
 
   return false;
 }
@@ -453,135 +465,37 @@ CORBA::Boolean AutopilotController::set_sensor_vals(
 CORBA::Boolean AutopilotController::update_aivdm(
     const std::vector<PhysicalState::AivdmMessage>& targets) {
   if (!this->sensor_vals_set_) {
-    ACE_DEBUG((LM_DEBUG, ACE_TEXT("No AIVDM message received.")));
+    XLOG(LC_AIS, LL_DEBUG, "No AIVDM message received.");
     return false;
   }
 
-  ACE_hrtime_t now = ACE_OS::gethrtime();
-  ACE_DEBUG((LM_DEBUG, ACE_TEXT("AIVDM message(s) received:\n")));
-  for (auto target : targets) {
-    if (this->ais_targets_.find(target.mmsi) == this->ais_targets_.end()) {
-      this->ais_targets_[target.mmsi] = AisTarget{now,
-                                                  target.navigation_status,
-                                                  target.mmsi,
-                                                  target.latitude,
-                                                  target.longitude,
-                                                  target.rate_of_turn,
-                                                  target.course_over_ground,
-                                                  target.speed_over_ground};
-    } else {
-      this->ais_targets_[target.mmsi].fix_ts_ = now,
-      this->ais_targets_[target.mmsi].fix_status_ = target.navigation_status;
-      this->ais_targets_[target.mmsi].mmsi = target.mmsi,
-      this->ais_targets_[target.mmsi].fix_lat_ = target.latitude;
-      this->ais_targets_[target.mmsi].fix_lon_ = target.longitude;
-      this->ais_targets_[target.mmsi].fix_rot_ = target.rate_of_turn;
-      this->ais_targets_[target.mmsi].fix_cog_ = target.course_over_ground;
-      this->ais_targets_[target.mmsi].fix_sog_ = target.speed_over_ground;
-    }
-    ACE_DEBUG((LM_DEBUG, 
-              ACE_TEXT(
-                "New AIVDM message:\n"
-                "\tTS:\t\t%f\n"
-                "\tStatus:\t\t%i\n"
-                "\tMMSI:\t\t%i\n"
-                "\tLAT:\t\t%f\n"
-                "\tLON:\t\t%f\n"
-                "\tCOG:\t\t%f\n"
-                "\tSOG:\t\t%f\n\n"
-              ),
-              now,
-              target.navigation_status,
-              target.mmsi,
-              target.latitude,
-              target.longitude,
-              target.course_over_ground,
-              target.speed_over_ground
-              ));
+  ACE_hrtime_t now = this->clock_.now();
+  XLOG(LC_AIS, LL_DEBUG, "AIVDM message(s) received:\n");
+  for (const auto& target : targets) {
+    this->ais_targets_.update(target, now);
+    XLOG(LC_AIS, LL_DEBUG, "New AIVDM message:\n"
+                           "\tTS:\t\t%f\n"
+                           "\tStatus:\t\t%i\n"
+                           "\tMMSI:\t\t%i\n"
+                           "\tLAT:\t\t%f\n"
+                           "\tLON:\t\t%f\n"
+                           "\tCOG:\t\t%f\n"
+                           "\tSOG:\t\t%f\n\n",
+         now, target.navigation_status, target.mmsi, target.latitude,
+         target.longitude, target.course_over_ground, target.speed_over_ground);
   }
   return false;
 }
 
 void AutopilotController::estimate_position(PhysicalState::Sensors sensors) {
-  ACE_hrtime_t now = ACE_OS::gethrtime();
-
-  // Sensors values we fuse. Duplication of gnss_2 and gnss_1 are placeholders
-  // in case we can't do dead reckoning or constant movement bias yet due to
-  // lack of previous estimates
-  std::array<CORBA::Double, 5> lat_vals = {
-      sensors.gnss_1.latitude, sensors.gnss_2.latitude, sensors.gnss_3.latitude,
-      sensors.gnss_2.latitude, sensors.gnss_1.latitude};
-  std::array<CORBA::Double, 5> lon_vals = {
-      sensors.gnss_1.longitude, sensors.gnss_2.longitude,
-      sensors.gnss_3.longitude, sensors.gnss_2.longitude,
-      sensors.gnss_1.longitude};
-
-  if (this->sensor_vals_set_) {
-    // Dead reckoning, guess cog and sog by averaging previous and current value
-    // Compute time delta in seconds to extrapolate new position from sog
-    CORBA::Double delta = (now - this->last_pos_estimate_ts_) * 1e-9;
-    CORBA::Double sog =
-        (this->sensor_vals_.speed_over_ground + sensors.speed_over_ground) / 2;
-    CORBA::Double cog =
-        (this->sensor_vals_.course_over_ground + sensors.course_over_ground) /
-        2;
-
-    CORBA::Double lat_shift;
-    CORBA::Double lon_shift;
-    std::tie(lat_shift, lon_shift) = polar_to_cartesian(cog, sog * delta);
-    lat_vals[3] = shift_lat(this->estimated_position_.latitude,
-                            this->estimated_position_.longitude, lat_shift);
-    lon_vals[3] = shift_long(this->estimated_position_.longitude,
-                             this->estimated_position_.longitude, lon_shift);
-
-    if (this->previous_estimated_position_.latitude != 0 &&
-        this->previous_estimated_position_.longitude != 0) {
-      // add bias towards constant movement
-      lat_vals[4] = this->estimated_position_.latitude +
-                    (this->estimated_position_.latitude -
-                     this->previous_estimated_position_.latitude);
-      lon_vals[4] = this->estimated_position_.longitude +
-                    (this->estimated_position_.longitude -
-                     this->previous_estimated_position_.longitude);
-    }
-  }
-
-  std::sort(lat_vals.begin(), lat_vals.end());
-  std::sort(lon_vals.begin(), lon_vals.end());
-
-  CORBA::Long lat_count = 0;
-  CORBA::Long lon_count = 0;
-  CORBA::Double lat_sum = 0.0;
-  CORBA::Double lon_sum = 0.0;
-
-  for (int i = 0; i < 5; ++i) {
-    // discard sensor/estimate lat or lon val if it seems implausible (>10m
-    // error), use the median value as reference as a sort of voting scheme
-    CORBA::Double lat_offset =
-        distance_harvesine(lat_vals[i], lon_vals[2], lat_vals[2], lon_vals[2]);
-    CORBA::Double lon_offset =
-        distance_harvesine(lat_vals[2], lon_vals[i], lat_vals[2], lon_vals[2]);
-    if (std::abs(lat_offset) < 10.0) {
-      lat_sum += lat_vals[i];
-      lat_count++;
-    }
-    if (std::abs(lon_offset) < 10.0) {
-      lon_sum += lon_vals[i];
-      lon_count++;
-    }
-  }
-
-  this->previous_estimated_position_ = this->estimated_position_;
-
-  // compute mean values of plausible sensors to smooth out noise
-  this->estimated_position_.latitude = lat_sum / lat_count;
-  this->estimated_position_.longitude = lon_sum / lon_count;
-
-  this->last_pos_estimate_ts_ = now;
+  this->estimated_position_ =
+      this->position_estimator_->update(sensors, this->clock_.now());
+  this->nav_frame_.follow(this->estimated_position_.latitude,
+                          this->estimated_position_.longitude);
 }
 
 CORBA::Boolean AutopilotController::execute() {
-  ACE_hrtime_t now = ACE_OS::gethrtime();
+  ACE_hrtime_t now = this->clock_.now();
   // have we sent a report recently?
   if (now - this->last_report_ts_ >= REPORT_INTERVAL) {
     this->report_available_ = true;
@@ -644,7 +558,7 @@ CORBA::Boolean AutopilotController::execute() {
 CORBA::Boolean AutopilotController::execute_colreg(
     Autopilot::Coordinates& wpt_override, CORBA::Double& speed_override) {
   if (!this->sensor_vals_set_) return false;
-  ACE_hrtime_t now = ACE_OS::gethrtime();
+  ACE_hrtime_t now = this->clock_.now();
 
   if (now - this->last_colreg_rep_ts_ > COLREG_REPORT_INTERVAL) {
     // prepare a report
@@ -653,32 +567,26 @@ CORBA::Boolean AutopilotController::execute_colreg(
   }
 
   Autopilot::Coordinates own_pos = this->get_position();
-
-  // own position relative to current position
-  // in meters and ignoring earth curvature to reduce expensive trigonometry
-  std::array<Autopilot::Coordinates, 65> future_own_pos{};
-  CORBA::Double own_lat_shift;
-  CORBA::Double own_lon_shift;
-  std::tie(own_lat_shift, own_lon_shift) =
-      polar_to_cartesian(this->sensor_vals_.course_over_ground,
-                         this->sensor_vals_.speed_over_ground);
-  for (uint i = 0; i < future_own_pos.size(); ++i) {
-    future_own_pos[i] =
-        Autopilot::Coordinates{own_lat_shift * i, own_lon_shift * i};
-  }
-
-  // info about the most pressing target
-  CORBA::Double cpa_t_min = DBL_MAX;
-  const AisTarget* tgt_info;
-  CORBA::Double tgt_bearing;
-  Autopilot::Coordinates tgt_estimated_pos{};
-
-  ACE_DEBUG((LM_DEBUG, ACE_TEXT("COLREG check:\n")));
-
-  // iterate over all tracked targets
-  for (const auto& target : this->ais_targets_) {
-    const AisTarget* current_tgt_info = &target.second;
-
+  EnuPoint own_enu =
+      this->nav_frame_.to_local(own_pos.latitude, own_pos.longitude);
+
+  // forget targets that went silent, then only look at the ones that can be
+  // near enough to matter
+  this->ais_targets_.evict_expired(now);
+  this->ais_targets_.query(own_pos.latitude, own_pos.longitude,
+                           this->colreg_check_radius_,
+                           this->colreg_candidates_);
+
+  XLOG(LC_COLREG, LL_DEBUG,
+       "COLREG check: %u targets held, %u examined, %u evicted so far\n",
+       this->ais_targets_.size(), this->ais_targets_.examined(),
+       this->ais_targets_.evicted());
+
+  // positions and velocities relative to own ship, in meters and ignoring
+  // earth curvature to reduce expensive trigonometry
+  this->cpa_batch_.clear();
+  this->colreg_in_range_.clear();
+  for (const AisTarget* current_tgt_info : this->colreg_candidates_) {
     // time since fix in seconds
     CORBA::Double fix_delta = (now - current_tgt_info->fix_ts_) * 1e-9;
 
@@ -689,69 +597,78 @@ CORBA::Boolean AutopilotController::execute_colreg(
         current_tgt_info->fix_cog_, current_tgt_info->fix_sog_);
 
     // estimated current position
-    CORBA::Double estimated_lat =
-        shift_lat(current_tgt_info->fix_lat_, current_tgt_info->fix_lon_,
-                  lat_shift * fix_delta);
-    CORBA::Double estimated_lon =
-        shift_long(current_tgt_info->fix_lat_, current_tgt_info->fix_lon_,
-                   lon_shift * fix_delta);
-
-    ACE_DEBUG((LM_DEBUG, ACE_TEXT("    mmsi: %i"), current_tgt_info->mmsi));
+    EnuPoint estimated = this->nav_frame_.to_local(current_tgt_info->fix_lat_,
+                                                   current_tgt_info->fix_lon_);
+    estimated.north += lat_shift * fix_delta;
+    estimated.east += lon_shift * fix_delta;
 
     // determine current distance, skip targets which we can
     // (probably!) safely ignore for now
-    CORBA::Double current_distance = distance_harvesine(
-        own_pos.latitude, own_pos.longitude, estimated_lat, estimated_lon);
-    if (current_distance > COLREG_CHECK_RADIUS) {
-      ACE_DEBUG((LM_DEBUG, ACE_TEXT(" -> out of range (%f > %f)\n"),
-                 current_distance, COLREG_CHECK_RADIUS));
+    CORBA::Double current_distance =
+        this->nav_frame_.distance(own_enu, estimated);
+    if (current_distance > this->colreg_check_radius_) {
+      XLOG(LC_COLREG, LL_DEBUG, "    mmsi: %i -> out of range (%f > %f)\n",
+           current_tgt_info->mmsi, current_distance,
+           this->colreg_check_radius_);
       continue;
     }
-    CORBA::Double current_bearing = relative_bearing(
-        0.0,  // absolute bearing
-        own_pos.latitude, own_pos.longitude, estimated_lat, estimated_lon);
+    CORBA::Double current_bearing =
+        this->nav_frame_.bearing(0.0,  // absolute bearing
+                                 own_enu, estimated);
     Autopilot::Coordinates relative_pos{};
     std::tie(relative_pos.latitude, relative_pos.longitude) =
         polar_to_cartesian(current_bearing, current_distance);
 
-    // determine cpa
-    CORBA::Double local_cpa_d = DBL_MAX;
-    CORBA::Double current_d;
-    CORBA::Double local_cpa_t;
-    for (uint i = 0; i < future_own_pos.size(); ++i) {
-      current_d = std::sqrt(
-          std::pow(future_own_pos[i].latitude - relative_pos.latitude, 2) +
-          std::pow(future_own_pos[i].longitude - relative_pos.longitude, 2));
-      if (current_d < local_cpa_d) {
-        local_cpa_d = current_d;
-      } else {
-        // we expect the first minimum found to be global, since
-        // heading and speed of both vessels are constant
-        break;
-      }
-      local_cpa_t = i;
-      relative_pos.latitude += lat_shift;
-      relative_pos.longitude += lon_shift;
-    }
+    this->cpa_batch_.add(relative_pos.latitude, relative_pos.longitude,
+                         lat_shift, lon_shift);
+    this->colreg_in_range_.push_back(ColregCandidate{
+        current_tgt_info, current_bearing, estimated});
+  }
 
-    ACE_DEBUG((LM_DEBUG, ACE_TEXT(" -> CPA distance: %f, CPA time: %f\n"),
-               local_cpa_d, local_cpa_t));
+  // closed-form CPA of all targets in range at once
+  this->cpa_batch_.solve(this->sensor_vals_.course_over_ground,
+                         this->sensor_vals_.speed_over_ground);
 
-    if (local_cpa_d < COLREG_CPAD && local_cpa_t - 1.0 < cpa_t_min) {
+  // info about the most pressing target
+  CORBA::Double cpa_t_min = DBL_MAX;
+  const AisTarget* tgt_info = nullptr;
+  CORBA::Double tgt_bearing = 0.0;
+  EnuPoint tgt_estimated_pos{};
+
+  for (std::size_t i = 0; i < this->colreg_in_range_.size(); ++i) {
+    const ColregCandidate& candidate = this->colreg_in_range_[i];
+    CORBA::Double local_cpa_d = this->cpa_batch_.dcpa(i);
+    CORBA::Double local_cpa_t = this->cpa_batch_.tcpa(i);
+
+    XLOG(LC_COLREG, LL_DEBUG,
+         "    mmsi: %i -> CPA distance: %f, CPA time: %f, "
+         "bow crossing range: %f, bow crossing time: %f\n",
+         candidate.target->mmsi, local_cpa_d, local_cpa_t,
+         this->cpa_batch_.bow_crossing_range(i),
+         this->cpa_batch_.bow_crossing_time(i));
+
+    // keep acting on the target of the last override until it is well clear,
+    // our own avoiding action takes its CPA past COLREG_CPAD long before that
+    // and, once it opens, the CPA distance is the range
+    CORBA::Boolean pressing =
+        candidate.target->mmsi == this->colreg_tgt_mmsi_
+            ? local_cpa_d < COLREG_CPAD * COLREG_CLEAR_FACTOR
+            : local_cpa_t <= COLREG_CPA_HORIZON && local_cpa_d < COLREG_CPAD;
+    if (pressing && local_cpa_t - 1.0 < cpa_t_min) {
       // new candidate for most pressing target
       cpa_t_min = local_cpa_t;
-      tgt_info = current_tgt_info;
+      tgt_info = candidate.target;
       tgt_bearing = std::fmod(
-          360.0 + current_bearing - this->sensor_vals_.course_over_ground,
+          360.0 + candidate.bearing - this->sensor_vals_.course_over_ground,
           360.0);
-      tgt_estimated_pos.latitude = estimated_lat;
-      tgt_estimated_pos.longitude = estimated_lon;
+      tgt_estimated_pos = candidate.estimated_pos;
     }
   }
 
-  CORBA::Double wpt_bearing = relative_bearing(
-      this->sensor_vals_.course_over_ground, own_pos.latitude,
-      own_pos.longitude, wpt_override.latitude, wpt_override.longitude);
+  CORBA::Double wpt_bearing = this->nav_frame_.bearing(
+      this->sensor_vals_.course_over_ground, own_enu,
+      this->nav_frame_.to_local(wpt_override.latitude,
+                                wpt_override.longitude));
   if (wpt_bearing > 180.0) wpt_bearing -= 360.0;
 
   if (cpa_t_min != DBL_MAX) {
@@ -764,51 +681,65 @@ CORBA::Boolean AutopilotController::execute_colreg(
     if (tgt_rel_heading > 180.0) tgt_rel_heading -= 360.0;
     if (tgt_bearing > 180.0) tgt_bearing -= 360.0;
 
-    ACE_DEBUG((LM_DEBUG,
-               ACE_TEXT("COLREG execution:\n"
-                        "    mmsi:      %i\n"
-                        "    t_cpa:     %f\n"
-                        "    rel_h:     %f\n"
-                        "    bearing:   %f\n"
-                        "    tgt_pos:   %f, %f\n"),
-               tgt_info->mmsi, cpa_t_min, tgt_rel_heading, tgt_bearing,
-               tgt_estimated_pos.latitude, tgt_estimated_pos.longitude));
-
-    if (std::abs(tgt_rel_heading) <= 22.5 && tgt_info->fix_sog_ > 0.1) {
-      if (std::abs(tgt_bearing) < 45) {
-        // overtaking a moving target, don't change wpt, reduce speed to be a
-        // bit lower than that of the vessel we are overtaking
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("    situation: OVERTAKING\n")));
-        situation = Autopilot::CR_OVERTAKING;
-        speed_override = std::min(speed_override, tgt_info->fix_sog_ * 0.8);
-      } else {
-        // target is behind us, speed up to avoid getting overtaken
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("    situation: OVERTAKEN\n")));
-        situation = Autopilot::CR_OVERTAKEN;
-        speed_override = std::max(speed_override, tgt_info->fix_sog_ * 1.2);
-      }
+    Autopilot::Coordinates tgt_pos{};
+    this->nav_frame_.to_geodetic(tgt_estimated_pos, tgt_pos.latitude,
+                                 tgt_pos.longitude);
+
+    XLOG(LC_COLREG, LL_DEBUG, "COLREG execution:\n"
+                              "    mmsi:      %i\n"
+                              "    t_cpa:     %f\n"
+                              "    rel_h:     %f\n"
+                              "    bearing:   %f\n"
+                              "    tgt_pos:   %f, %f\n",
+         tgt_info->mmsi, cpa_t_min, tgt_rel_heading, tgt_bearing,
+         tgt_pos.latitude, tgt_pos.longitude);
+
+    if (tgt_info->mmsi == this->colreg_tgt_mmsi_ &&
+        this->colreg_situation_ != Autopilot::CR_INACTIVE) {
+      // our own avoiding action changes the relative heading and bearing,
+      // stay with the situation the target was first seen in
+      situation = this->colreg_situation_;
+    } else if (std::abs(tgt_rel_heading) <= 22.5 && tgt_info->fix_sog_ > 0.1) {
+      situation = std::abs(tgt_bearing) < 45 ? Autopilot::CR_OVERTAKING
+                                             : Autopilot::CR_OVERTAKEN;
     } else if (std::abs(tgt_rel_heading) <= 157.5) {
+      situation = Autopilot::CR_CROSSING;
+    } else {
+      situation = Autopilot::CR_HEAD_TO_HEAD;
+    }
+
+    if (situation == Autopilot::CR_OVERTAKING) {
+      // overtaking a moving target, don't change wpt, reduce speed to be a
+      // bit lower than that of the vessel we are overtaking
+      XLOG(LC_COLREG, LL_DEBUG, "    situation: OVERTAKING\n");
+      speed_override = std::min(speed_override, tgt_info->fix_sog_ * 0.8);
+    } else if (situation == Autopilot::CR_OVERTAKEN) {
+      // target is behind us, speed up to avoid getting overtaken
+      XLOG(LC_COLREG, LL_DEBUG, "    situation: OVERTAKEN\n");
+      speed_override = std::max(speed_override, tgt_info->fix_sog_ * 1.2);
+    } else if (situation == Autopilot::CR_CROSSING) {
       // crossing, change wpt to n meters behind tgt vessel, unless wpt is
       // further in the right direction
-      ACE_DEBUG((LM_DEBUG, ACE_TEXT("    situation: CROSSING\n")));
-      situation = Autopilot::CR_CROSSING;
+      XLOG(LC_COLREG, LL_DEBUG, "    situation: CROSSING\n");
 
       CORBA::Double colreg_lat_offset;
       CORBA::Double colreg_lon_offset;
       std::tie(colreg_lat_offset, colreg_lon_offset) = polar_to_cartesian(
           std::fmod(tgt_info->fix_cog_ + 180.0, 360.0), COLREG_CPAD * 1.6);
-      CORBA::Double colreg_lat =
-          shift_lat(tgt_estimated_pos.latitude, tgt_estimated_pos.longitude,
-                    colreg_lat_offset);
-      CORBA::Double colreg_lon =
-          shift_long(tgt_estimated_pos.latitude, tgt_estimated_pos.longitude,
-                     colreg_lon_offset);
-      CORBA::Double colreg_bearing = relative_bearing(
-          this->sensor_vals_.course_over_ground, own_pos.latitude,
-          own_pos.longitude, colreg_lat, colreg_lon);
+      EnuPoint colreg_pos{tgt_estimated_pos.east + colreg_lon_offset,
+                          tgt_estimated_pos.north + colreg_lat_offset};
+      CORBA::Double colreg_bearing = this->nav_frame_.bearing(
+          this->sensor_vals_.course_over_ground, own_enu, colreg_pos);
 
       if (colreg_bearing > 180.0) colreg_bearing -= 360.0;
 
+      this->make_alteration_apparent(own_enu,
+                                     colreg_bearing < 0.0 ? -1.0 : 1.0,
+                                     colreg_pos, colreg_bearing);
+      CORBA::Double colreg_lat;
+      CORBA::Double colreg_lon;
+      this->nav_frame_.to_geodetic(colreg_pos, colreg_lat, colreg_lon);
+
       if (wpt_bearing * colreg_bearing >= 0 &&
           std::abs(wpt_bearing) > std::abs(colreg_bearing)) {
         // only slow down a bit, steering to wpt should be enough
@@ -824,39 +755,45 @@ CORBA::Boolean AutopilotController::execute_colreg(
         }
       }
     } else {
-      ACE_DEBUG((
-          LM_DEBUG,
-          ACE_TEXT("    situation: HEAD-TO-HEAD OR OVERTAKING SLOW TARGET\n")));
+      XLOG(LC_COLREG, LL_DEBUG,
+           "    situation: HEAD-TO-HEAD OR OVERTAKING SLOW TARGET\n");
       // head to head or overtaking a stationary/slow target
       // change wpt to n meters perpendicular to and behind tgt vessel in
       // direction opposite to bearing, unless wpt is further in the right
       // direction
-      situation = Autopilot::CR_HEAD_TO_HEAD;
 
-      // dodge to rel bearing direction as seen from other tgt
-      CORBA::Double inv_bearing = relative_bearing(
-          tgt_info->fix_cog_, tgt_estimated_pos.latitude,
-          tgt_estimated_pos.longitude, own_pos.latitude, own_pos.longitude);
-      CORBA::Double direction = 1.0;
-      if (inv_bearing > 180.0) direction = -1.0;
+      // alter course to starboard, unless we are already well off the
+      // target's starboard bow; once chosen keep the side for this target,
+      // own ship dead ahead of it would otherwise flip it every cycle
+      if (tgt_info->mmsi != this->colreg_tgt_mmsi_ ||
+          this->colreg_dodge_direction_ == 0.0) {
+        CORBA::Double inv_bearing = this->nav_frame_.bearing(
+            tgt_info->fix_cog_, tgt_estimated_pos, own_enu);
+        this->colreg_dodge_direction_ =
+            (inv_bearing > COLREG_KEEP_SIDE_BEARING && inv_bearing < 180.0)
+                ? 1.0
+                : -1.0;
+      }
+      CORBA::Double direction = this->colreg_dodge_direction_;
 
       CORBA::Double colreg_lat_offset;
       CORBA::Double colreg_lon_offset;
       std::tie(colreg_lat_offset, colreg_lon_offset) = polar_to_cartesian(
           std::fmod(360.0 + tgt_info->fix_cog_ + (direction * 156.5), 360.0),
           2.2 * COLREG_CPAD);
-      CORBA::Double colreg_lat =
-          shift_lat(tgt_estimated_pos.latitude, tgt_estimated_pos.longitude,
-                    colreg_lat_offset);
-      CORBA::Double colreg_lon =
-          shift_long(tgt_estimated_pos.latitude, tgt_estimated_pos.longitude,
-                     colreg_lon_offset);
-      CORBA::Double colreg_bearing = relative_bearing(
-          this->sensor_vals_.course_over_ground, own_pos.latitude,
-          own_pos.longitude, colreg_lat, colreg_lon);
+      EnuPoint colreg_pos{tgt_estimated_pos.east + colreg_lon_offset,
+                          tgt_estimated_pos.north + colreg_lat_offset};
+      CORBA::Double colreg_bearing = this->nav_frame_.bearing(
+          this->sensor_vals_.course_over_ground, own_enu, colreg_pos);
 
       if (colreg_bearing > 180.0) colreg_bearing -= 360.0;
 
+      this->make_alteration_apparent(own_enu, -direction, colreg_pos,
+                                     colreg_bearing);
+      CORBA::Double colreg_lat;
+      CORBA::Double colreg_lon;
+      this->nav_frame_.to_geodetic(colreg_pos, colreg_lat, colreg_lon);
+
       // wpt on the same side
       if (wpt_bearing * colreg_bearing >= 0
           // wpt further on that side
@@ -866,23 +803,27 @@ CORBA::Boolean AutopilotController::execute_colreg(
         // only slow down a bit, steering to wpt should be enough
         // to resolve collision threat
         speed_override = 0.95 * speed_override;
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("    action:    override speed\n")));
+        XLOG(LC_COLREG, LL_DEBUG, "    action:    override speed\n");
       } else {
         wpt_override.latitude = colreg_lat;
         wpt_override.longitude = colreg_lon;
         speed_override = 0.84 * speed_override;
-        ACE_DEBUG((LM_DEBUG,
-                   ACE_TEXT("    action:    override speed and steering\n")));
+        XLOG(LC_COLREG, LL_DEBUG,
+             "    action:    override speed and steering\n");
       }
     }
     this->colreg_report_.type = situation;
     this->colreg_report_.tgt_mmsi = tgt_info->mmsi;
     this->colreg_report_.tgt_pos.latitude = tgt_info->fix_lat_;
     this->colreg_report_.tgt_pos.longitude = tgt_info->fix_lon_;
-
-    this->last_colreg_bearing_ = relative_bearing(
-        0.0, own_pos.latitude, own_pos.longitude, wpt_override.latitude,
-        wpt_override.longitude);  // store desired heading
+    this->colreg_tgt_mmsi_ = tgt_info->mmsi;
+    this->colreg_situation_ = situation;
+
+    this->last_colreg_bearing_ = this->nav_frame_.bearing(
+        0.0, own_enu,
+        this->nav_frame_.to_local(
+            wpt_override.latitude,
+            wpt_override.longitude));  // store desired heading
     this->last_colreg_override_ = now;
 
     return true;
@@ -893,17 +834,19 @@ CORBA::Boolean AutopilotController::execute_colreg(
     if (std::abs(wpt_bearing) > 90.0 &&
         now - this->last_colreg_override_ < COLREG_UTURN_SAFEGUARD) {
       // keep heading in last COLREG override direction, let AP handle speed
-      ACE_DEBUG((LM_DEBUG,
-                 ACE_TEXT("COLREG execution: keep previous COLREG heading\n")));
+      XLOG(LC_COLREG, LL_DEBUG,
+           "COLREG execution: keep previous COLREG heading\n");
       CORBA::Double colreg_lat_shift;
       CORBA::Double colreg_lon_shift;
       std::tie(colreg_lat_shift, colreg_lon_shift) = polar_to_cartesian(
           this->last_colreg_bearing_, (1 + speed_override) * 30);
-      wpt_override.latitude =
-          shift_lat(own_pos.latitude, own_pos.longitude, colreg_lat_shift);
-      wpt_override.longitude =
-          shift_long(own_pos.latitude, own_pos.longitude, colreg_lon_shift);
+      this->nav_frame_.to_geodetic(
+          {own_enu.east + colreg_lon_shift, own_enu.north + colreg_lat_shift},
+          wpt_override.latitude, wpt_override.longitude);
     }
+    this->colreg_tgt_mmsi_ = 0;
+    this->colreg_situation_ = Autopilot::CR_INACTIVE;
+    this->colreg_dodge_direction_ = 0.0;
     // don't perform colreg, inform CCC
     this->colreg_report_.type = Autopilot::CR_INACTIVE;
   }
@@ -911,24 +854,76 @@ CORBA::Boolean AutopilotController::execute_colreg(
   return false;
 }
 
+void AutopilotController::make_alteration_apparent(
+    const EnuPoint& own_enu, CORBA::Double side, EnuPoint& colreg_pos,
+    CORBA::Double& colreg_bearing) {
+  if (side * colreg_bearing >= COLREG_MIN_ALTERATION) return;
+
+  // seen from afar a point next to the target is almost dead ahead, steering
+  // for it would only alter course a little at a time
+  CORBA::Double lat_offset;
+  CORBA::Double lon_offset;
+  colreg_bearing = side * COLREG_MIN_ALTERATION;
+  std::tie(lat_offset, lon_offset) = polar_to_cartesian(
+      std::fmod(360.0 + this->sensor_vals_.course_over_ground + colreg_bearing,
+                360.0),
+      this->nav_frame_.distance(own_enu, colreg_pos));
+  colreg_pos = EnuPoint{own_enu.east + lon_offset, own_enu.north + lat_offset};
+}
+
 CORBA::Boolean AutopilotController::execute_route() {
   if (!this->sensor_vals_set_) return false;
 
   Autopilot::Coordinates pos = this->get_position();
-  Autopilot::Waypoint wpt = this->current_waypoint_;
+  Autopilot::Coordinates requested_wpt = this->current_waypoint_.coords;
+
+  if (this->current_waypoint_index_ == 0) {
+    // the route starts at the first waypoint, head straight for it
+    CORBA::Double d_to_waypoint = this->nav_frame_.distance(
+        this->nav_frame_.to_local(pos.latitude, pos.longitude),
+        this->nav_frame_.to_local(requested_wpt.latitude,
+                                  requested_wpt.longitude));
+
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Executing route towards:\n"
+                                 "    target waypoint: %s\n"
+                                 "    distance:        %f\n",
+         (const char*)this->current_waypoint_.name, d_to_waypoint);
+
+    if (d_to_waypoint < WPT_ARRIVAL_RADIUS) {
+      if (!this->route_geometry_.has_legs()) {
+        // single waypoint route, we're done
+        this->reset_current_waypoint();
+        this->set_state(Autopilot::AS_DISABLED);
+        this->action_completed_ = true;
+        return false;
+      }
+      this->current_waypoint_index_ = 1;
+      this->route_geometry_.seek(1);
+    }
+  }
 
-  CORBA::Double d_to_waypoint = distance_harvesine(
-      pos.latitude, pos.longitude, wpt.coords.latitude, wpt.coords.longitude);
+  if (this->current_waypoint_index_ > 0) {
+    // follow the legs, steering towards a point ahead on the track
+    CORBA::Double lookahead =
+        std::max(ROUTE_LOOKAHEAD_MIN,
+                 this->sensor_vals_.speed_over_ground * ROUTE_LOOKAHEAD_TIME);
+    RouteProgress progress =
+        this->route_geometry_.track(pos.latitude, pos.longitude, lookahead);
+    if (progress.waypoint != this->current_waypoint_index_) {
+      this->current_waypoint_index_ = progress.waypoint;
+      this->current_waypoint_ =
+          this->waypoint_seq_[this->current_waypoint_index_];
+    }
 
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("Executing route towards:\n"
-                      "    target waypoint: %s\n"
-                      "    distance:        %f\n"),
-             (const char*)wpt.name, d_to_waypoint));
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Executing route towards:\n"
+                                 "    target waypoint: %s\n"
+                                 "    distance:        %f\n"
+                                 "    cross-track:     %f\n"
+                                 "    along-track:     %f\n",
+         (const char*)this->current_waypoint_.name, progress.leg_end_distance,
+         progress.cross_track, progress.along_track);
 
-  // check if active waypoint needs to be updated
-  if (d_to_waypoint < WPT_ARRIVAL_RADIUS) {
-    if (this->current_waypoint_index_ >= this->waypoint_seq_.length() - 1) {
+    if (progress.last_leg && progress.leg_end_distance < WPT_ARRIVAL_RADIUS) {
       // reached last waypoint, stop autopilot
       // FIXME: Shouldn't we unset the route here?
       this->reset_current_waypoint();
@@ -937,18 +932,11 @@ CORBA::Boolean AutopilotController::execute_route() {
 
       return false;
     }
-    this->current_waypoint_index_++;
-    this->current_waypoint_ =
-        this->waypoint_seq_[this->current_waypoint_index_];
-    wpt = this->current_waypoint_;
-    d_to_waypoint = distance_harvesine(
-        pos.latitude, pos.longitude, wpt.coords.latitude, wpt.coords.longitude);
+    requested_wpt = progress.lookahead;
   }
 
   // This could be improved by adding braking on leg end/tight turns etc.
   CORBA::Double requested_sog = 1.0 * this->sog_max_;
-  Autopilot::Coordinates requested_wpt =
-      Autopilot::Coordinates{wpt.coords.latitude, wpt.coords.longitude};
 
   // let COLREG procedure override speed and course
   this->execute_colreg(requested_wpt, requested_sog);
@@ -979,8 +967,9 @@ CORBA::Boolean AutopilotController::execute_loiter() {
   CORBA::Double target_bearing = this->active_loiter_position_.bearing;
   CORBA::Double bearing = this->sensor_vals_.heading;
 
-  CORBA::Double d_to_target = distance_harvesine(
-      pos.latitude, pos.longitude, target_pos.latitude, target_pos.longitude);
+  CORBA::Double d_to_target = this->nav_frame_.distance(
+      this->nav_frame_.to_local(pos.latitude, pos.longitude),
+      this->nav_frame_.to_local(target_pos.latitude, target_pos.longitude));
 
   if (!loiter_reached && d_to_target < LOITER_ARRIVAL_RADIUS) {
     loiter_reached = true;
@@ -991,11 +980,10 @@ CORBA::Boolean AutopilotController::execute_loiter() {
   }
 
   if (!loiter_reached) {
-    ACE_DEBUG((LM_DEBUG,
-               ACE_TEXT("Executing loiter towards:\n"
-                        "    target:   %f, %f\n"
-                        "    distance: %f\n"),
-               target_pos.latitude, target_pos.longitude, d_to_target));
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Executing loiter towards:\n"
+                                 "    target:   %f, %f\n"
+                                 "    distance: %f\n",
+         target_pos.latitude, target_pos.longitude, d_to_target);
     // route towards target like any a route waypoint, smoothly reducing speed
     // don't use thrusters
     this->actuator_cmds_.thruster_throttle_bow = 0.0;
@@ -1023,7 +1011,7 @@ CORBA::Boolean AutopilotController::execute_loiter() {
       if (throttle > 0.2) {
         // scale engine throttle difference linearly with wheel val
         CORBA::Double diff = 1 + (std::min(60.0, wheel_abs) / 60.0);
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("Engine assist: %f\n"), diff));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "Engine assist: %f\n", diff);
         if (wheel > 0.0) {
           this->actuator_cmds_.engine_throttle_port *= diff;
           this->actuator_cmds_.engine_throttle_stbd /= diff;
@@ -1036,20 +1024,19 @@ CORBA::Boolean AutopilotController::execute_loiter() {
         this->actuator_cmds_.rudder_angle = 0.0;
         CORBA::Double assist = std::min(wheel_abs / 60.0, 0.8);
         assist = (wheel / wheel_abs) * assist;
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("Bow thruster assist: %f\n"), assist));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "Bow thruster assist: %f\n", assist);
         this->actuator_cmds_.thruster_throttle_bow = assist;
       }
     }
 
   } else {
-    ACE_DEBUG((LM_DEBUG,
-               ACE_TEXT("Executing loiter at:\n"
-                        "    target position: %f, %f\n"
-                        "    distance:        %f\n"
-                        "    target bearing:  %f\n"
-                        "    actual bearing:  %f\n"),
-               target_pos.latitude, target_pos.longitude, d_to_target,
-               target_bearing, bearing));
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Executing loiter at:\n"
+                                 "    target position: %f, %f\n"
+                                 "    distance:        %f\n"
+                                 "    target bearing:  %f\n"
+                                 "    actual bearing:  %f\n",
+         target_pos.latitude, target_pos.longitude, d_to_target, target_bearing,
+         bearing);
     // null out speed
     // Note: This doesn't work with sea current, actively maintaining
     //       position would require using thrusters and engines to
@@ -1067,13 +1054,15 @@ CORBA::Boolean AutopilotController::execute_loiter() {
     // coordinates and scaling with magic numbers to convert to
     // throttle/thruster value.
     this->actuator_cmds_.rudder_angle = 0.0;
-    ACE_DEBUG((LM_DEBUG, ACE_TEXT("Bow thruster throttle ")));
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Bow thruster throttle ");
     this->actuator_cmds_.thruster_throttle_bow =
-        this->bow_thruster_pid_.control(bearing, target_bearing);
+        this->bow_thruster_pid_.control(bearing, target_bearing,
+                                        this->clock_.now());
 
-    ACE_DEBUG((LM_DEBUG, ACE_TEXT("Stern thruster throttle ")));
+    XLOG(LC_AUTOPILOT, LL_DEBUG, "Stern thruster throttle ");
     this->actuator_cmds_.thruster_throttle_stern =
-        this->stern_thruster_pid_.control(bearing, target_bearing);
+        this->stern_thruster_pid_.control(bearing, target_bearing,
+                                          this->clock_.now());
   }
 
   return true;
@@ -1085,7 +1074,7 @@ CORBA::Boolean AutopilotController::execute_dive() {
   this->tgt_depth_ = this->active_dive_procedure_.depth;
   this->execute_maintain_depth();
 
-  ACE_hrtime_t now = ACE_OS::gethrtime();
+  ACE_hrtime_t now = this->clock_.now();
   CORBA::Double depth_delta =
       std::abs(this->tgt_depth_adjusted_ - this->sensor_vals_.ship_depth);
   if (depth_delta > this->DEPTH_TOLERANCE) {
@@ -1136,9 +1125,10 @@ CORBA::Boolean AutopilotController::execute_maintain_depth() {
 
   // buoyancy is close to neutral or negative, let PID controller handle the
   // pump
-  ACE_DEBUG((LM_DEBUG, ACE_TEXT("Ballast tank pump throttle ")));
+  XLOG(LC_AUTOPILOT, LL_DEBUG, "Ballast tank pump throttle ");
   CORBA::Double pid_output =
-      this->ballast_tank_pid_.control(current_depth, this->tgt_depth_adjusted_);
+      this->ballast_tank_pid_.control(current_depth, this->tgt_depth_adjusted_,
+                                      this->clock_.now());
 
   // hard cap on buoyancy, we don't ever want to empty or fill the tank to a
   // degree where we introduce too much momentum and end up constantly
@@ -1195,8 +1185,9 @@ CORBA::Double AutopilotController::rudder_towards(Autopilot::Coordinates pos,
   CORBA::Double rot = this->sensor_vals_.rate_of_turn * RAD_TO_DEG;
 
   // Calculate angle to waypoint
-  double bearing = relative_bearing(cog, pos.latitude, pos.longitude,
-                                    wpt.latitude, wpt.longitude);
+  double bearing = this->nav_frame_.bearing(
+      cog, this->nav_frame_.to_local(pos.latitude, pos.longitude),
+      this->nav_frame_.to_local(wpt.latitude, wpt.longitude));
 
   if (bearing >= 180.0) bearing -= 360.0;
   if (bearing <= -180.0) bearing += 360.0;
@@ -1216,14 +1207,13 @@ CORBA::Double AutopilotController::rudder_towards(Autopilot::Coordinates pos,
   // scaled from (-60, 60) --> (-30, 30), maximum rudder extent in BC
   CORBA::Double angle = std::min(std::max(bearing, -60.0), 60.0) / 60 * 30;
 
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("Steering:\n"
-                      "    bearing:   %f\n"
-                      "    rot:       %f\n"
-                      "    steering:  %f\n"
-                      "    dampening: %f\n"
-                      "    angle:   %f\n"),
-             bearing_orig, rot, bearing, dampening, angle));
+  XLOG(LC_AUTOPILOT, LL_DEBUG, "Steering:\n"
+                               "    bearing:   %f\n"
+                               "    rot:       %f\n"
+                               "    steering:  %f\n"
+                               "    dampening: %f\n"
+                               "    angle:   %f\n",
+       bearing_orig, rot, bearing, dampening, angle);
 
   return angle * (1 - dampening);
 }
@@ -1235,6 +1225,7 @@ CORBA::Double AutopilotController::compute_throttle(
   if (this->sensor_vals_.speed < 0.0) {
     sog *= -1.0;
   }
-  ACE_DEBUG((LM_DEBUG, ACE_TEXT("Engine throttle ")));
-  return this->engine_throttle_pid_.control(sog, sog_setpoint);
+  XLOG(LC_AUTOPILOT, LL_DEBUG, "Engine throttle ");
+  return this->engine_throttle_pid_.control(sog, sog_setpoint,
+                                           this->clock_.now());
 }
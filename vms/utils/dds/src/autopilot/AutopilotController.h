@@ -5,28 +5,37 @@
 #include <tao/Basic_Types.h>
 #include <tao/DoubleSeqC.h>
 
-#include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "AisTargetStore.h"
 #include "AutopilotC.h"
+#include "ControlClock.h"
+#include "CpaEngine.h"
+#include "LocalFrame.h"
 #include "PhysicalStateC.h"
 #include "PidController.h"
-
-struct AisTarget {
-  ACE_hrtime_t fix_ts_;
-  PhysicalState::NavigationStatus fix_status_;
-  CORBA::Long mmsi;
-  double fix_lat_;
-  double fix_lon_;
-  double fix_rot_;  // rot is not available in BC
-  double fix_cog_;  // in degrees
-  double fix_sog_;  // in meters/s
-};
+#include "PositionEstimator.h"
+#include "RouteGeometry.h"
 
 class AutopilotController {
  public:
-  AutopilotController();
+  // COLREG thresholds, shared with colreg-bench
+  // radius (m) within which AIS targets are checked unless configured
+  static constexpr CORBA::Double COLREG_DEFAULT_RADIUS = 750.0;
+  // CPA distance under which a target is considered to be dangerous
+  static constexpr CORBA::Double COLREG_CPAD = 57.0;
+  // targets reaching their CPA later than this (s) are not acted on yet
+  static constexpr CORBA::Double COLREG_CPA_HORIZON = 64.0;
+
+  // period of the control loop in nanoseconds, colreg_check_radius in
+  // meters, ais_ttl in seconds
+  AutopilotController(ControlClock& clock, ACE_hrtime_t period,
+                      CORBA::Double colreg_check_radius =
+                          COLREG_DEFAULT_RADIUS,
+                      CORBA::Double ais_ttl = 180.0,
+                      PositionFilter position_filter = PF_MEDIAN);
   ~AutopilotController() = default;
 
   CORBA::Boolean update_state(Autopilot::AutopilotCommandType, CORBA::Boolean);
@@ -69,6 +78,12 @@ class AutopilotController {
   void estimate_position(PhysicalState::Sensors);
 
   CORBA::Boolean execute_colreg(Autopilot::Coordinates&, CORBA::Double&);
+  // moves a COLREG waypoint closer to dead ahead than COLREG_MIN_ALTERATION
+  // out to that bearing on the given side (1.0 starboard, -1.0 port)
+  void make_alteration_apparent(const EnuPoint&, CORBA::Double, EnuPoint&,
+                                CORBA::Double&);
+
+  ControlClock& clock_;
 
   Autopilot::AutopilotState previous_state_;
 
@@ -100,7 +115,6 @@ class AutopilotController {
   Autopilot::WaypointSeq waypoint_seq_;
   CORBA::Long route_id_;
   Autopilot::Waypoint current_waypoint_;
-  CORBA::DoubleSeq leg_len_seq_;
   CORBA::ULong current_waypoint_index_;
   CORBA::Long current_leg_len_;  // Unused for now, would be to adjust throttle
 
@@ -112,6 +126,13 @@ class AutopilotController {
   // arrival radiuses should not be too small
   // or the boat might get stuck in a circle
   const CORBA::Double WPT_ARRIVAL_RADIUS = 35.0;
+  // legs are tracked towards a point this far ahead on the track, at least
+  // ROUTE_LOOKAHEAD_MIN meters or ROUTE_LOOKAHEAD_TIME seconds at the
+  // current speed
+  const CORBA::Double ROUTE_LOOKAHEAD_MIN = 60.0;
+  const CORBA::Double ROUTE_LOOKAHEAD_TIME = 15.0;
+  const CORBA::Double ROUTE_TURN_RADIUS = 60.0;
+  const CORBA::Double ROUTE_GRID_CELL_DEG = 0.01;
   const CORBA::Double LOITER_ARRIVAL_RADIUS = 35.0;
   const CORBA::Double LOITER_STAY_RADIUS =
       45.0;  // must be > LOITER_ARRIVAL_RADIUS
@@ -124,14 +145,38 @@ class AutopilotController {
   // COLREG data
   const ACE_hrtime_t COLREG_REPORT_INTERVAL = 1.45 * 1e9;
   const ACE_hrtime_t COLREG_UTURN_SAFEGUARD = 5 * 1e9;
-  const CORBA::Double COLREG_CHECK_RADIUS = 750.0;
-  // CPA distance under which a target is considered to be dangerous
-  const CORBA::Double COLREG_CPAD = 57.0;
+  // relative bearing (deg) of own ship from a head-to-head target past which
+  // we keep to its starboard side instead of altering to starboard
+  const CORBA::Double COLREG_KEEP_SIDE_BEARING = 10.0;
+  // smallest alteration of course (deg) a COLREG waypoint asks for
+  const CORBA::Double COLREG_MIN_ALTERATION = 30.0;
+  // the target of an override is clear once its CPA distance is past this
+  // many COLREG_CPAD
+  const CORBA::Double COLREG_CLEAR_FACTOR = 1.5;
+  const CORBA::Double colreg_check_radius_;
   ACE_hrtime_t last_colreg_rep_ts_ = 0;
   ACE_hrtime_t last_colreg_override_ = 0;
   CORBA::Double last_colreg_bearing_ = 0.0;
-
-  std::map<CORBA::Long, AisTarget> ais_targets_{};
+  // the target of the last override, its situation and the side a
+  // head-to-head dodge of it took (1.0 to port, -1.0 to starboard), all kept
+  // until it is clear
+  CORBA::Long colreg_tgt_mmsi_ = 0;
+  Autopilot::ColregType colreg_situation_ = Autopilot::CR_INACTIVE;
+  CORBA::Double colreg_dodge_direction_ = 0.0;
+
+  // roughly 1.1 km in latitude
+  const CORBA::Double AIS_GRID_CELL_DEG = 0.01;
+  AisTargetStore ais_targets_;
+  std::vector<const AisTarget*> colreg_candidates_{};
+
+  // targets within the check radius, in the same order as cpa_batch_
+  struct ColregCandidate {
+    const AisTarget* target;
+    CORBA::Double bearing;
+    EnuPoint estimated_pos;
+  };
+  std::vector<ColregCandidate> colreg_in_range_{};
+  CpaBatch cpa_batch_{};
   CORBA::Boolean colreg_report_available_ = false;
   Autopilot::ColregStatus colreg_report_{};
 
@@ -152,9 +197,13 @@ class AutopilotController {
   CORBA::Double tgt_depth_adjusted_ = 0.0;
   ACE_hrtime_t last_outside_depth_interval_ts = 0;
 
+  // navigation geometry is done in a local frame that follows own ship
+  LocalFrame nav_frame_{};
+  // legs of the active route, built on activation
+  RouteGeometry route_geometry_{ROUTE_TURN_RADIUS, ROUTE_GRID_CELL_DEG};
+
+  std::unique_ptr<PositionEstimator> position_estimator_;
   Autopilot::Coordinates estimated_position_{0.0, 0.0};
-  Autopilot::Coordinates previous_estimated_position_{0.0, 0.0};
-  ACE_hrtime_t last_pos_estimate_ts_ = 0;
 
   CORBA::Boolean loiter_reached = false;
 };
@@ -0,0 +1,90 @@
+#ifndef AUTOPILOT_CONTROL_CLOCK_H
+#define AUTOPILOT_CONTROL_CLOCK_H
+
+#include <ace/OS_NS_time.h>
+#include <ace/OS_NS_unistd.h>
+#include <ace/Time_Value.h>
+
+#include "../AsyncLog.h"
+#include "../cosim/CoSimChannel.h"
+
+// Time source of the autopilot. Controllers read the time from here instead
+// of calling gethrtime directly so that the whole control loop can run
+// against a simulated clock.
+class ControlClock {
+ public:
+  virtual ~ControlClock() = default;
+
+  // monotonic time in nanoseconds, never 0
+  virtual ACE_hrtime_t now() const = 0;
+  // block until now() has reached the deadline
+  virtual void sleep_until(ACE_hrtime_t deadline) = 0;
+};
+
+class RealClock : public ControlClock {
+ public:
+  ACE_hrtime_t now() const override { return ACE_OS::gethrtime(); }
+
+  void sleep_until(ACE_hrtime_t deadline) override {
+    ACE_hrtime_t current = this->now();
+    if (deadline <= current) return;
+    ACE_hrtime_t remaining = deadline - current;
+    ACE_OS::sleep(ACE_Time_Value(
+        static_cast<time_t>(remaining / 1000000000),
+        static_cast<suseconds_t>(remaining % 1000000000 / 1000)));
+  }
+};
+
+// Only moves when told to. Sleeping jumps straight to the deadline, so a
+// loop driven by this clock runs as fast as it can compute while seeing
+// exactly the nominal time steps.
+class SimulatedClock : public ControlClock {
+ public:
+  explicit SimulatedClock(ACE_hrtime_t start = 1) : now_(start) {}
+
+  ACE_hrtime_t now() const override { return this->now_; }
+
+  void sleep_until(ACE_hrtime_t deadline) override {
+    if (deadline > this->now_) this->now_ = deadline;
+  }
+
+  void advance(ACE_hrtime_t delta) { this->now_ += delta; }
+
+ private:
+  ACE_hrtime_t now_;
+};
+
+// Follows the simulated time of the BC co-simulation master. Sleeping
+// blocks until the master has granted the deadline, so the loop sees
+// exactly the nominal time steps however fast or slow the master runs. If
+// the master goes away the clock carries on in real time from the last
+// simulated time. The channel must be attached.
+class LockstepClock : public ControlClock {
+ public:
+  explicit LockstepClock(CoSimChannel& channel)
+      : channel_(channel), offset_(0), detached_(false) {}
+
+  ACE_hrtime_t now() const override {
+    if (this->detached_) return this->real_.now() - this->offset_;
+    return this->channel_.time();
+  }
+
+  void sleep_until(ACE_hrtime_t deadline) override {
+    if (!this->detached_) {
+      if (this->channel_.wait_until(deadline)) return;
+      XLOG(LC_AUTOPILOT, LL_ERROR,
+           "Co-simulation master is gone, continuing in real time\n");
+      this->offset_ = this->real_.now() - this->channel_.time();
+      this->detached_ = true;
+    }
+    this->real_.sleep_until(deadline + this->offset_);
+  }
+
+ private:
+  CoSimChannel& channel_;
+  RealClock real_;
+  ACE_hrtime_t offset_;
+  bool detached_;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "CpaEngine.h"
+
+#include <cmath>
+
+#include "Marmaths.h"
+
+// below these rates (m/s) the geometry is considered frozen
+static constexpr double MIN_RELATIVE_SPEED_SQ = 1e-6;
+static constexpr double MIN_CROSSING_RATE = 1e-9;
+
+void CpaBatch::clear() {
+  this->rel_north_.clear();
+  this->rel_east_.clear();
+  this->vel_north_.clear();
+  this->vel_east_.clear();
+}
+
+void CpaBatch::reserve(std::size_t n) {
+  this->rel_north_.reserve(n);
+  this->rel_east_.reserve(n);
+  this->vel_north_.reserve(n);
+  this->vel_east_.reserve(n);
+}
+
+void CpaBatch::add(double rel_north, double rel_east, double vel_north,
+                   double vel_east) {
+  this->rel_north_.push_back(rel_north);
+  this->rel_east_.push_back(rel_east);
+  this->vel_north_.push_back(vel_north);
+  this->vel_east_.push_back(vel_east);
+}
+
+// Kept free of branches and of anything that may set errno or trap, so that
+// it vectorises with -fno-math-errno -fno-trapping-math.
+static void solve_kernel(std::size_t n, const double* __restrict rn,
+                         const double* __restrict re,
+                         const double* __restrict vn,
+                         const double* __restrict ve, double own_vn,
+                         double own_ve, double head_n, double head_e,
+                         double* __restrict tcpa, double* __restrict dcpa,
+                         double* __restrict bct, double* __restrict bcr) {
+  for (std::size_t i = 0; i < n; ++i) {
+    // relative motion r(t) = r + v t, closest at t = -(r.v) / (v.v)
+    const double dvn = vn[i] - own_vn;
+    const double dve = ve[i] - own_ve;
+    const double vv = dvn * dvn + dve * dve;
+    const double rv = rn[i] * dvn + re[i] * dve;
+    const bool moving = vv > MIN_RELATIVE_SPEED_SQ;
+    double t = -rv / (moving ? vv : 1.0);
+    t = moving && t > 0.0 ? t : 0.0;
+    const double cn = rn[i] + dvn * t;
+    const double ce = re[i] + dve * t;
+    tcpa[i] = t;
+    dcpa[i] = std::sqrt(cn * cn + ce * ce);
+
+    // own heading line is crossed where the cross-track offset is zero
+    const double cross = re[i] * head_n - rn[i] * head_e;
+    const double cross_rate = dve * head_n - dvn * head_e;
+    const bool crossing = std::fabs(cross_rate) > MIN_CROSSING_RATE;
+    const double tc = -cross / (crossing ? cross_rate : 1.0);
+    bct[i] = crossing ? tc : -1.0;
+    bcr[i] = (rn[i] + dvn * tc) * head_n + (re[i] + dve * tc) * head_e;
+  }
+}
+
+void CpaBatch::solve(double own_course, double own_speed) {
+  const std::size_t n = this->size();
+  this->tcpa_.resize(n);
+  this->dcpa_.resize(n);
+  this->bct_.resize(n);
+  this->bcr_.resize(n);
+
+  const double head_n = std::cos(own_course * DEG_TO_RAD);
+  const double head_e = std::sin(own_course * DEG_TO_RAD);
+  solve_kernel(n, this->rel_north_.data(), this->rel_east_.data(),
+               this->vel_north_.data(), this->vel_east_.data(),
+               own_speed * head_n, own_speed * head_e, head_n, head_e,
+               this->tcpa_.data(), this->dcpa_.data(), this->bct_.data(),
+               this->bcr_.data());
+}
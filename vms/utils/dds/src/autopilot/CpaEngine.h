@@ -0,0 +1,51 @@
+#ifndef AUTOPILOT_CPA_ENGINE_H
+#define AUTOPILOT_CPA_ENGINE_H
+
+#include <cstddef>
+#include <vector>
+
+// Closest point of approach for a batch of targets, solved in closed form
+// from straight-line relative motion. All quantities are in a local
+// north/east frame centred on own ship, in meters and meters/s.
+//
+// Targets are kept as a structure of arrays so that solve() runs as one
+// branch-free loop the compiler can vectorise.
+class CpaBatch {
+ public:
+  void clear();
+  void reserve(std::size_t n);
+
+  // position of the target relative to own ship and its absolute velocity
+  void add(double rel_north, double rel_east, double vel_north,
+           double vel_east);
+
+  // own_course in degrees, own_speed in meters/s
+  void solve(double own_course, double own_speed);
+
+  std::size_t size() const { return this->rel_north_.size(); }
+
+  // time to CPA in seconds, 0 if the range is already opening
+  double tcpa(std::size_t i) const { return this->tcpa_[i]; }
+  // distance at CPA in meters
+  double dcpa(std::size_t i) const { return this->dcpa_[i]; }
+  // time until the target crosses own ship's heading line, negative if it
+  // never will
+  double bow_crossing_time(std::size_t i) const { return this->bct_[i]; }
+  // distance along own heading at which the target crosses it, positive
+  // ahead of the bow and negative astern, only valid if the crossing time
+  // is not negative
+  double bow_crossing_range(std::size_t i) const { return this->bcr_[i]; }
+
+ private:
+  std::vector<double> rel_north_;
+  std::vector<double> rel_east_;
+  std::vector<double> vel_north_;
+  std::vector<double> vel_east_;
+
+  std::vector<double> tcpa_;
+  std::vector<double> dcpa_;
+  std::vector<double> bct_;
+  std::vector<double> bcr_;
+};
+
+#endif
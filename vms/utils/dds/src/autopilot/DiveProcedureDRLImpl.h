@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "../ReaderSupport.h"
 #include "AutopilotC.h"
 
 class DiveProcedureDataReaderListenerImpl
@@ -53,6 +54,7 @@ class DiveProcedureDataReaderListenerImpl
   std::vector<Autopilot::DiveProcedure> latest_procs_;
   CORBA::Boolean procedure_changed_;
   ACE_Mutex lock_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -0,0 +1,201 @@
+#include "GnssKalmanFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../AsyncLog.h"
+#include "Marmaths.h"
+
+GnssKalmanFilter::GnssKalmanFilter()
+    : initialised_(false),
+      last_ts_(0),
+      east_{0.0, 0.0, 0.0, 0.0, 0.0},
+      north_{0.0, 0.0, 0.0, 0.0, 0.0},
+      sources_{},
+      cycles_without_fix_(0),
+      restarts_(0),
+      fixes_{},
+      in_gate_{} {}
+
+Autopilot::Coordinates GnssKalmanFilter::update(
+    const PhysicalState::Sensors& sensors, ACE_hrtime_t now) {
+  const double lat[] = {sensors.gnss_1.latitude, sensors.gnss_2.latitude,
+                        sensors.gnss_3.latitude};
+  const double lon[] = {sensors.gnss_1.longitude, sensors.gnss_2.longitude,
+                        sensors.gnss_3.longitude};
+
+  this->predict(now);
+  this->update_fixes(lat, lon, 3);
+  this->update_velocity(sensors.speed_over_ground,
+                        sensors.course_over_ground, SOG_SIGMA);
+  this->update_velocity(sensors.speed, sensors.heading, STW_SIGMA);
+  return this->estimate();
+}
+
+void GnssKalmanFilter::predict_axis(Axis& axis, double dt, double q) {
+  axis.pos += axis.vel * dt;
+  axis.p00 += dt * (2.0 * axis.p01 + dt * axis.p11) + q * dt * dt * dt / 3.0;
+  axis.p01 += dt * axis.p11 + q * dt * dt / 2.0;
+  axis.p11 += q * dt;
+}
+
+void GnssKalmanFilter::update_axis_pos(Axis& axis, double z, double r) {
+  double s = axis.p00 + r;
+  double k0 = axis.p00 / s;
+  double k1 = axis.p01 / s;
+  double y = z - axis.pos;
+  axis.pos += k0 * y;
+  axis.vel += k1 * y;
+  axis.p11 -= k1 * axis.p01;
+  axis.p01 -= k0 * axis.p01;
+  axis.p00 -= k0 * axis.p00;
+}
+
+void GnssKalmanFilter::update_axis_vel(Axis& axis, double z, double r) {
+  double s = axis.p11 + r;
+  double k0 = axis.p01 / s;
+  double k1 = axis.p11 / s;
+  double y = z - axis.vel;
+  axis.pos += k0 * y;
+  axis.vel += k1 * y;
+  axis.p00 -= k0 * axis.p01;
+  axis.p01 -= k0 * axis.p11;
+  axis.p11 -= k1 * axis.p11;
+}
+
+void GnssKalmanFilter::predict(ACE_hrtime_t now) {
+  if (!this->initialised_) {
+    this->last_ts_ = now;
+    return;
+  }
+  double dt = (now - this->last_ts_) * 1e-9;
+  this->last_ts_ = now;
+  if (dt > MAX_GAP) {
+    // too uncertain to be worth predicting, start over from the next fixes
+    this->initialised_ = false;
+    return;
+  }
+  predict_axis(this->east_, dt, ACCEL_NOISE);
+  predict_axis(this->north_, dt, ACCEL_NOISE);
+}
+
+void GnssKalmanFilter::initialise(const double* lat, const double* lon,
+                                  std::size_t count) {
+  // the median per axis outvotes a single bad source
+  std::array<double, MAX_SOURCES> lats;
+  std::array<double, MAX_SOURCES> lons;
+  std::copy(lat, lat + count, lats.begin());
+  std::copy(lon, lon + count, lons.begin());
+  std::nth_element(lats.begin(), lats.begin() + count / 2,
+                   lats.begin() + count);
+  std::nth_element(lons.begin(), lons.begin() + count / 2,
+                   lons.begin() + count);
+  this->frame_.anchor(lats[count / 2], lons[count / 2]);
+
+  const double pos_var = GNSS_SIGMA * GNSS_SIGMA;
+  // the velocity is unknown until the first SOG/COG update
+  const double vel_var = 25.0;
+  this->east_ = Axis{0.0, 0.0, pos_var, 0.0, vel_var};
+  this->north_ = Axis{0.0, 0.0, pos_var, 0.0, vel_var};
+  for (SourceHealth& source : this->sources_) {
+    source.faulted = false;
+    source.consecutive_rejects = 0;
+    source.consecutive_accepts = 0;
+  }
+  this->cycles_without_fix_ = 0;
+  this->initialised_ = true;
+}
+
+void GnssKalmanFilter::update_fixes(const double* lat, const double* lon,
+                                    std::size_t count) {
+  count = std::min(count, MAX_SOURCES);
+  if (count == 0) return;
+  if (!this->initialised_) {
+    this->initialise(lat, lon, count);
+    return;
+  }
+
+  // gate all fixes against the prediction before any of them moves it
+  const double r = GNSS_SIGMA * GNSS_SIGMA;
+  std::size_t in_gate = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    this->fixes_[i] = this->frame_.to_local(lat[i], lon[i]);
+    double y_east = this->fixes_[i].east - this->east_.pos;
+    double y_north = this->fixes_[i].north - this->north_.pos;
+    double distance = y_east * y_east / (this->east_.p00 + r) +
+                      y_north * y_north / (this->north_.p00 + r);
+    this->in_gate_[i] = distance < GATE;
+    if (this->in_gate_[i]) ++in_gate;
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    SourceHealth& source = this->sources_[i];
+    if (this->in_gate_[i]) {
+      source.consecutive_rejects = 0;
+      ++source.consecutive_accepts;
+      if (source.faulted && source.consecutive_accepts >= RECOVER_AFTER) {
+        source.faulted = false;
+        XLOG(LC_SENSORS, LL_WARNING, "GNSS source %u recovered\n", i + 1);
+      }
+      if (!source.faulted) {
+        update_axis_pos(this->east_, this->fixes_[i].east, r);
+        update_axis_pos(this->north_, this->fixes_[i].north, r);
+      }
+    } else {
+      ++source.rejected;
+      ++source.consecutive_rejects;
+      source.consecutive_accepts = 0;
+      if (!source.faulted && source.consecutive_rejects >= FAULT_AFTER) {
+        source.faulted = true;
+        XLOG(LC_SENSORS, LL_WARNING,
+             "GNSS source %u faulted, fix %f, %f disagrees with estimate\n",
+             i + 1, lat[i], lon[i]);
+      }
+    }
+  }
+
+  if (in_gate > 0) {
+    this->cycles_without_fix_ = 0;
+  } else if (++this->cycles_without_fix_ >= RESTART_AFTER) {
+    XLOG(LC_SENSORS, LL_WARNING,
+         "No GNSS fix agreed with the position estimate for %u cycles, "
+         "restarting the filter\n",
+         this->cycles_without_fix_);
+    ++this->restarts_;
+    this->initialise(lat, lon, count);
+  }
+}
+
+void GnssKalmanFilter::update_velocity(double speed, double course,
+                                       double sigma) {
+  if (!this->initialised_) return;
+
+  double v_east = speed * std::sin(course * DEG_TO_RAD);
+  double v_north = speed * std::cos(course * DEG_TO_RAD);
+  double r = sigma * sigma;
+  double y_east = v_east - this->east_.vel;
+  double y_north = v_north - this->north_.vel;
+  if (y_east * y_east / (this->east_.p11 + r) +
+          y_north * y_north / (this->north_.p11 + r) >=
+      GATE) {
+    return;
+  }
+  update_axis_vel(this->east_, v_east, r);
+  update_axis_vel(this->north_, v_north, r);
+}
+
+Autopilot::Coordinates GnssKalmanFilter::estimate() {
+  Autopilot::Coordinates position{0.0, 0.0};
+  if (!this->initialised_) return position;
+
+  this->frame_.to_geodetic({this->east_.pos, this->north_.pos},
+                           position.latitude, position.longitude);
+  if (this->frame_.follow(position.latitude, position.longitude)) {
+    // keep the state in the moved frame, the velocity carries over
+    EnuPoint moved =
+        this->frame_.to_local(position.latitude, position.longitude);
+    this->east_.pos = moved.east;
+    this->north_.pos = moved.north;
+  }
+  return position;
+}
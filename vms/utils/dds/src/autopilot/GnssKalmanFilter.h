@@ -0,0 +1,103 @@
+#ifndef AUTOPILOT_GNSS_KALMAN_FILTER_H
+#define AUTOPILOT_GNSS_KALMAN_FILTER_H
+
+#include <ace/OS_NS_time.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "LocalFrame.h"
+#include "PositionEstimator.h"
+
+// Constant velocity Kalman filter over own ship's position and velocity in a
+// local frame. GNSS fixes update the position, SOG/COG and speed through the
+// water along the heading update the velocity.
+//
+// With a diagonal measurement noise the east and north axes never couple,
+// so the state is kept as two independent position/velocity pairs with a
+// 2x2 covariance each. All storage is fixed size, updates do not allocate.
+//
+// Every fix is gated on its normalised innovation before it is used. A
+// source whose fixes keep falling outside the gate is marked faulty and
+// ignored until it agrees with the filter again. If no source has passed
+// the gate for a while the filter is assumed to have diverged and restarts
+// from the median of the fixes.
+class GnssKalmanFilter : public PositionEstimator {
+ public:
+  static constexpr std::size_t MAX_SOURCES = 8;
+
+  GnssKalmanFilter();
+
+  Autopilot::Coordinates update(const PhysicalState::Sensors& sensors,
+                                ACE_hrtime_t now) override;
+  const char* name() const override { return "kalman"; }
+
+  // lower level interface for any number of GNSS sources, call predict()
+  // once per cycle, then the updates, then estimate()
+  void predict(ACE_hrtime_t now);
+  void update_fixes(const double* lat, const double* lon, std::size_t count);
+  // speed in meters/s, course in degrees
+  void update_velocity(double speed, double course, double sigma);
+  Autopilot::Coordinates estimate();
+
+  bool is_faulted(std::size_t source) const {
+    return this->sources_[source].faulted;
+  }
+  uint64_t rejected(std::size_t source) const {
+    return this->sources_[source].rejected;
+  }
+  uint64_t restarts() const { return this->restarts_; }
+
+ private:
+  struct Axis {
+    double pos;
+    double vel;
+    // covariance of pos/vel
+    double p00;
+    double p01;
+    double p11;
+  };
+
+  struct SourceHealth {
+    bool faulted;
+    uint32_t consecutive_rejects;
+    uint32_t consecutive_accepts;
+    uint64_t rejected;
+  };
+
+  void initialise(const double* lat, const double* lon, std::size_t count);
+  static void predict_axis(Axis& axis, double dt, double q);
+  static void update_axis_pos(Axis& axis, double z, double r);
+  static void update_axis_vel(Axis& axis, double z, double r);
+
+  // BC adds 3 m standard deviation of noise per axis
+  static constexpr double GNSS_SIGMA = 3.0;
+  // SOG/COG are precise, speed through the water misses currents
+  static constexpr double SOG_SIGMA = 0.3;
+  static constexpr double STW_SIGMA = 1.5;
+  // white acceleration noise (m^2/s^3), covers the ship's manoeuvring
+  static constexpr double ACCEL_NOISE = 0.05;
+  // chi square of 2 degrees of freedom at 99.9%
+  static constexpr double GATE = 13.8;
+  static constexpr uint32_t FAULT_AFTER = 8;
+  static constexpr uint32_t RECOVER_AFTER = 8;
+  static constexpr uint32_t RESTART_AFTER = 8;
+  // restart instead of predicting over longer gaps (s)
+  static constexpr double MAX_GAP = 10.0;
+
+  LocalFrame frame_{};
+  bool initialised_;
+  ACE_hrtime_t last_ts_;
+  Axis east_;
+  Axis north_;
+  std::array<SourceHealth, MAX_SOURCES> sources_;
+  uint32_t cycles_without_fix_;
+  uint64_t restarts_;
+
+  // scratch for the gating pass
+  std::array<EnuPoint, MAX_SOURCES> fixes_;
+  std::array<bool, MAX_SOURCES> in_gate_;
+};
+
+#endif
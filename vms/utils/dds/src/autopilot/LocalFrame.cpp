@@ -0,0 +1,99 @@
+#include "LocalFrame.h"
+
+#include <cmath>
+
+#include "Marmaths.h"
+
+LocalFrame::LocalFrame(double reanchor_distance)
+    : reanchor_distance_(reanchor_distance),
+      anchored_(false),
+      planar_(false),
+      lat0_(0.0),
+      lon0_(0.0),
+      sin0_(0.0),
+      cos0_(1.0),
+      tan0_(0.0),
+      m_per_deg_lat_(EARTH_RADIUS * DEG_TO_RAD),
+      m_per_deg_lon_(EARTH_RADIUS * DEG_TO_RAD) {}
+
+void LocalFrame::anchor(double lat, double lon) {
+  this->lat0_ = lat;
+  this->lon0_ = lon;
+  this->sin0_ = std::sin(lat * DEG_TO_RAD);
+  this->cos0_ = std::cos(lat * DEG_TO_RAD);
+  this->tan0_ = this->sin0_ / this->cos0_;
+  this->m_per_deg_lon_ = this->m_per_deg_lat_ * this->cos0_;
+  this->planar_ = std::abs(lat) < MAX_PLANAR_LAT;
+  this->anchored_ = true;
+}
+
+bool LocalFrame::follow(double lat, double lon) {
+  if (this->anchored_) {
+    EnuPoint own = this->to_local(lat, lon);
+    if (own.east * own.east + own.north * own.north <
+        this->reanchor_distance_ * this->reanchor_distance_) {
+      return false;
+    }
+  }
+  this->anchor(lat, lon);
+  return true;
+}
+
+EnuPoint LocalFrame::to_local(double lat, double lon) const {
+  double d_lon = lon - this->lon0_;
+  if (d_lon > 180.0) d_lon -= 360.0;
+  if (d_lon < -180.0) d_lon += 360.0;
+  return {d_lon * this->m_per_deg_lon_,
+          (lat - this->lat0_) * this->m_per_deg_lat_};
+}
+
+void LocalFrame::to_geodetic(const EnuPoint& point, double& lat,
+                             double& lon) const {
+  lat = this->lat0_ + point.north / this->m_per_deg_lat_;
+  lon = this->lon0_ + point.east / this->m_per_deg_lon_;
+  if (lon > 180.0) lon -= 360.0;
+  if (lon < -180.0) lon += 360.0;
+}
+
+bool LocalFrame::is_planar(const EnuPoint& point) const {
+  return this->planar_ &&
+         point.east * point.east + point.north * point.north <
+             PLANAR_RANGE * PLANAR_RANGE;
+}
+
+double LocalFrame::distance(const EnuPoint& from, const EnuPoint& to) const {
+  if (!this->is_planar(from) || !this->is_planar(to)) {
+    double lat_a, lon_a, lat_b, lon_b;
+    this->to_geodetic(from, lat_a, lon_a);
+    this->to_geodetic(to, lat_b, lon_b);
+    return distance_harvesine(lat_a, lon_a, lat_b, lon_b);
+  }
+
+  // east distances shrink with cos(latitude), scale them to the mid latitude
+  double mid = 0.5 * (from.north + to.north) / EARTH_RADIUS;
+  double d_east = (to.east - from.east) * (1.0 - this->tan0_ * mid);
+  double d_north = to.north - from.north;
+  return std::sqrt(d_east * d_east + d_north * d_north);
+}
+
+double LocalFrame::bearing(double heading, const EnuPoint& from,
+                           const EnuPoint& to) const {
+  if (!this->is_planar(from) || !this->is_planar(to)) {
+    double lat_a, lon_a, lat_b, lon_b;
+    this->to_geodetic(from, lat_a, lon_a);
+    this->to_geodetic(to, lat_b, lon_b);
+    return relative_bearing(heading, lat_a, lon_a, lat_b, lon_b);
+  }
+
+  double mid = 0.5 * (from.north + to.north) / EARTH_RADIUS;
+  double d_east = to.east - from.east;
+  double d_north = to.north - from.north;
+  double theta = std::atan2(d_east * (1.0 - this->tan0_ * mid), d_north);
+
+  // the great circle leaves at a slightly different angle than the mid
+  // latitude course, by half the meridian convergence between the points
+  double d_lambda = d_east / (EARTH_RADIUS * this->cos0_);
+  theta -= 0.5 * d_lambda * (this->sin0_ + this->cos0_ * mid);
+
+  return std::fmod(theta * RAD_TO_DEG + 720.0 - heading, 360.0);
+}
@@ -0,0 +1,70 @@
+#ifndef AUTOPILOT_LOCAL_FRAME_H
+#define AUTOPILOT_LOCAL_FRAME_H
+
+// position in a local frame, meters east and north of the anchor
+struct EnuPoint {
+  double east;
+  double north;
+};
+
+// Local east-north-up frame anchored near own ship. Positions are projected
+// into it once with plain multiplications, after which distances and
+// bearings between them are planar arithmetic instead of the spherical
+// trigonometry of Marmaths.h.
+//
+// The projection is equirectangular at the anchor latitude. distance() and
+// bearing() correct the east scale and the meridian convergence to first
+// order at the mid latitude of the two points, which keeps them within
+// 1e-5 relative distance error and 0.001 degrees of bearing of
+// distance_harvesine() and relative_bearing() for points up to
+// PLANAR_RANGE from the anchor, below 75 degrees latitude. Points further
+// away, and frames anchored closer to the poles, fall back to those
+// functions.
+class LocalFrame {
+ public:
+  // the frame moves along once own ship is reanchor_distance meters away
+  // from the anchor
+  explicit LocalFrame(double reanchor_distance = 2000.0);
+
+  void anchor(double lat, double lon);
+  // re-anchor on the position if needed, returns true if the frame moved
+  // and points projected before are stale
+  bool follow(double lat, double lon);
+
+  bool is_anchored() const { return this->anchored_; }
+
+  EnuPoint to_local(double lat, double lon) const;
+  void to_geodetic(const EnuPoint& point, double& lat, double& lon) const;
+
+  // distance in meters
+  double distance(const EnuPoint& from, const EnuPoint& to) const;
+  // bearing in degrees relative to heading, same convention as
+  // relative_bearing(), pass 0.0 for the absolute bearing
+  double bearing(double heading, const EnuPoint& from,
+                 const EnuPoint& to) const;
+
+ private:
+  // beyond this distance (m) from the anchor the first order corrections
+  // stop being accurate enough
+  static constexpr double PLANAR_RANGE = 10000.0;
+  // towards the poles the errors grow, the distance error passes 1e-5 at
+  // about 79 degrees
+  static constexpr double MAX_PLANAR_LAT = 75.0;
+
+  bool is_planar(const EnuPoint& point) const;
+
+  const double reanchor_distance_;
+  bool anchored_;
+  bool planar_;
+
+  double lat0_;
+  double lon0_;
+  double sin0_;
+  double cos0_;
+  double tan0_;
+  // meters per degree of latitude and of longitude at the anchor
+  double m_per_deg_lat_;
+  double m_per_deg_lon_;
+};
+
+#endif
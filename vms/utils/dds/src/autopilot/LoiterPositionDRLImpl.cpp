@@ -11,7 +11,8 @@
 #include "AutopilotTypeSupportC.h"
 #include "AutopilotTypeSupportImpl.h"
 
-LoiterPositionDataReaderListenerImpl::LoiterPositionDataReaderListenerImpl() {
+LoiterPositionDataReaderListenerImpl::LoiterPositionDataReaderListenerImpl()
+    : stats_("LoiterPosition") {
   // don't send the initial position to the AP controller
   this->position_changed_ = false;
   this->latest_positions_ = std::vector<Autopilot::LoiterPosition>();
@@ -34,14 +35,18 @@ CORBA::Boolean LoiterPositionDataReaderListenerImpl::new_positions_available() {
 
 void LoiterPositionDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void LoiterPositionDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void LoiterPositionDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void LoiterPositionDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -50,7 +55,9 @@ void LoiterPositionDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void LoiterPositionDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void LoiterPositionDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -64,22 +71,18 @@ void LoiterPositionDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::LoiterPosition loiter_position;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error =
-      reader_i->take_next_sample(loiter_position, info);
-
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      this->position_changed_ = true;
-      this->latest_positions_.push_back(loiter_position);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::LoiterPositionSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::LoiterPosition &loiter_position,
+             const DDS::SampleInfo &) {
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->position_changed_ = true;
+        this->latest_positions_.push_back(loiter_position);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
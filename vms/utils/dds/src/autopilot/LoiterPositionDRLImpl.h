@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "../ReaderSupport.h"
 #include "AutopilotC.h"
 
 class LoiterPositionDataReaderListenerImpl
@@ -53,6 +54,7 @@ class LoiterPositionDataReaderListenerImpl
   std::vector<Autopilot::LoiterPosition> latest_positions_;
   CORBA::Boolean position_changed_;
   ACE_Mutex lock_;
+  ReaderStats stats_;
 };
 
 #endif
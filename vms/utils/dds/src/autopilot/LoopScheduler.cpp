@@ -0,0 +1,79 @@
+#include "LoopScheduler.h"
+
+#include <algorithm>
+
+#include "../AsyncLog.h"
+
+LoopScheduler::LoopScheduler(ControlClock& clock, ACE_hrtime_t period)
+    : clock_(clock),
+      period_(period),
+      release_(0),
+      cycle_start_(0),
+      cycles_(0),
+      overruns_(0),
+      skipped_(0),
+      window_cycles_(0),
+      window_overruns_(0),
+      window_jitter_sum_(0),
+      window_max_jitter_(0),
+      window_max_execution_(0) {}
+
+ACE_hrtime_t LoopScheduler::begin_cycle() {
+  this->cycle_start_ = this->clock_.now();
+  // the first cycle is released whenever it starts
+  if (this->release_ == 0) this->release_ = this->cycle_start_;
+
+  ACE_hrtime_t jitter = this->cycle_start_ - this->release_;
+  this->window_jitter_sum_ += jitter;
+  this->window_max_jitter_ = std::max(this->window_max_jitter_, jitter);
+  return this->cycle_start_;
+}
+
+void LoopScheduler::end_cycle() {
+  ACE_hrtime_t now = this->clock_.now();
+  this->window_max_execution_ =
+      std::max(this->window_max_execution_, now - this->cycle_start_);
+  ++this->cycles_;
+  ++this->window_cycles_;
+
+  ACE_hrtime_t next = this->release_ + this->period_;
+  if (now > next) {
+    // drop the releases we are already late for and resume on the grid
+    uint64_t missed = (now - this->release_) / this->period_;
+    next = this->release_ + (missed + 1) * this->period_;
+    ++this->overruns_;
+    ++this->window_overruns_;
+    this->skipped_ += missed;
+    XLOG(LC_AUTOPILOT, LL_WARNING,
+         "AP loop overran its period by %f ms, skipping %u cycles\n",
+         (now - this->release_ - this->period_) * 1e-6, missed);
+  }
+
+  if (this->window_cycles_ >= STATS_WINDOW) this->log_window();
+
+  this->clock_.sleep_until(next);
+  this->release_ = next;
+}
+
+double LoopScheduler::mean_jitter() const {
+  if (this->window_cycles_ == 0) return 0.0;
+  return static_cast<double>(this->window_jitter_sum_) / this->window_cycles_;
+}
+
+void LoopScheduler::log_window() {
+  XLOG(LC_AUTOPILOT, LL_INFO, "AP loop timing over %u cycles:\n"
+                              "    period:        %f ms\n"
+                              "    jitter mean:   %f ms\n"
+                              "    jitter max:    %f ms\n"
+                              "    execution max: %f ms\n"
+                              "    overruns:      %u (%u total)\n",
+       this->window_cycles_, this->period_ * 1e-6, this->mean_jitter() * 1e-6,
+       this->window_max_jitter_ * 1e-6, this->window_max_execution_ * 1e-6,
+       this->window_overruns_, this->overruns_);
+
+  this->window_cycles_ = 0;
+  this->window_overruns_ = 0;
+  this->window_jitter_sum_ = 0;
+  this->window_max_jitter_ = 0;
+  this->window_max_execution_ = 0;
+}
@@ -0,0 +1,60 @@
+#ifndef AUTOPILOT_LOOP_SCHEDULER_H
+#define AUTOPILOT_LOOP_SCHEDULER_H
+
+#include <ace/OS_NS_time.h>
+
+#include <cstdint>
+
+#include "ControlClock.h"
+
+// Runs the control loop at a fixed period. Cycles are released on a fixed
+// time grid instead of sleeping a constant time after each cycle, so the
+// execution time does not stretch the period. A cycle that runs past the
+// start of the next one is counted as an overrun and the periods it covered
+// are skipped rather than run back to back.
+//
+// Wake-up jitter, execution time and overruns are accumulated over a window
+// and logged once per STATS_WINDOW cycles.
+class LoopScheduler {
+ public:
+  LoopScheduler(ControlClock& clock, ACE_hrtime_t period);
+
+  // call at the start of every cycle, returns the time of the cycle
+  ACE_hrtime_t begin_cycle();
+  // call at the end of every cycle, sleeps until the next one is due
+  void end_cycle();
+
+  ACE_hrtime_t period() const { return this->period_; }
+  uint64_t cycles() const { return this->cycles_; }
+  uint64_t overruns() const { return this->overruns_; }
+  uint64_t skipped() const { return this->skipped_; }
+
+  // statistics of the current window, in nanoseconds
+  ACE_hrtime_t max_jitter() const { return this->window_max_jitter_; }
+  ACE_hrtime_t max_execution() const { return this->window_max_execution_; }
+  double mean_jitter() const;
+
+ private:
+  void log_window();
+
+  static constexpr uint64_t STATS_WINDOW = 240;
+
+  ControlClock& clock_;
+  const ACE_hrtime_t period_;
+
+  // time the current cycle was due and the time it actually started
+  ACE_hrtime_t release_;
+  ACE_hrtime_t cycle_start_;
+
+  uint64_t cycles_;
+  uint64_t overruns_;
+  uint64_t skipped_;
+
+  uint64_t window_cycles_;
+  uint64_t window_overruns_;
+  ACE_hrtime_t window_jitter_sum_;
+  ACE_hrtime_t window_max_jitter_;
+  ACE_hrtime_t window_max_execution_;
+};
+
+#endif
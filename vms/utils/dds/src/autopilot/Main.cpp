@@ -9,13 +9,22 @@
 #include <dds/DdsDcpsPublicationC.h>
 #include <tao/Basic_Types.h>
 
+#include <cstdlib>
+#include <string>
+
+#include "../AsyncLog.h"
+#include "../cosim/CoSimChannel.h"
+#include "../ReaderSupport.h"
 #include "AivdmMessageDRLImpl.h"
 #include "AutopilotC.h"
 #include "AutopilotController.h"
 #include "AutopilotTypeSupportC.h"
+#include "ControlClock.h"
+#include "LoopScheduler.h"
 #include "MissionCommandDRLImpl.h"
 #include "MissionController.h"
 #include "MissionDRLImpl.h"
+#include "PositionEstimator.h"
 #include "ProcedureActivationDRLImpl.h"
 #ifdef ACE_AS_STATIC_LIBS
 #include <dds/DCPS/RTPS/RtpsDiscovery.h>
@@ -30,7 +39,67 @@
 #include "RouteDRLImpl.h"
 #include "SensorsDRLImpl.h"
 
+// period of the AP loop in nanoseconds
+const ACE_hrtime_t AP_LOOP_PERIOD = 250 * 1000000;
+
+int missing_arg(std::string arg) {
+  ACE_ERROR_RETURN((LM_ERROR,
+                    ACE_TEXT("ERROR: %N:%l: main() - missing "
+                             "value for argument %s!\n"),
+                    arg.c_str()),
+                   1);
+}
+
 int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
+  // COLREG only considers AIS targets within this radius (meters), targets
+  // without a fix for ais_ttl seconds are forgotten
+  CORBA::Double colreg_radius = AutopilotController::COLREG_DEFAULT_RADIUS;
+  CORBA::Double ais_ttl = 180.0;
+  // "median" is the median voting the autopilot has always used, "kalman"
+  // opts in to the gated Kalman filter, see tests/PositionFilterTest.cpp
+  PositionFilter position_filter = PF_MEDIAN;
+  std::string position_filter_name = "median";
+  // follow the simulated time of BC instead of the wall clock
+  bool lockstep = false;
+
+  for (int i = 0; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-colreg-radius") {
+      if (i == argc - 1) return missing_arg(arg);
+      colreg_radius = std::atof(argv[i + 1]);
+    } else if (arg == "-ais-ttl") {
+      if (i == argc - 1) return missing_arg(arg);
+      ais_ttl = std::atof(argv[i + 1]);
+    } else if (arg == "-position-filter") {
+      if (i == argc - 1) return missing_arg(arg);
+      position_filter_name = argv[i + 1];
+      if (parse_position_filter(position_filter_name, position_filter)) {
+        ACE_ERROR_RETURN((LM_ERROR,
+                          ACE_TEXT("ERROR: %N:%l: main() - unknown position "
+                                   "filter %C\n"),
+                          position_filter_name.c_str()),
+                         1);
+      }
+    } else if (arg == "-lockstep") {
+      lockstep = true;
+    }
+  }
+  ACE_DEBUG((LM_DEBUG,
+             ACE_TEXT("Parsed args: COLREG radius %f m, AIS target TTL %f s, "
+                      "position filter %C, lockstep %d\n"),
+             colreg_radius, ais_ttl, position_filter_name.c_str(), lockstep));
+
+  // attach before anything is received, BC holds the simulated time from
+  // now on until the first control cycle has run
+  CoSimChannel cosim;
+  if (lockstep && (cosim.open(CoSimChannel::CLIENT) || cosim.attach())) {
+    ACE_ERROR_RETURN((LM_ERROR,
+                      ACE_TEXT("ERROR: %N:%l: main() - could not attach to "
+                               "the co-simulation clock\n")),
+                     1);
+  }
+  CoSimChannel *cosim_counters = lockstep ? &cosim : nullptr;
+
   try {
     // Create the participant
     DDS::DomainParticipantFactory_var dpf =
@@ -210,18 +279,25 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     }
 
     // Create the DataWriter for the Actuators and report topics
+    DDS::DataWriterQos state_writer_qos;
+    publisher->get_default_datawriter_qos(state_writer_qos);
+    apply_profile(state_writer_qos, QOS_STATE);
+    DDS::DataWriterQos events_writer_qos;
+    publisher->get_default_datawriter_qos(events_writer_qos);
+    apply_profile(events_writer_qos, QOS_EVENTS);
+
     DDS::DataWriter_var actuators_base_dw =
-        publisher->create_datawriter(actuators_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(actuators_topic, state_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var ms_report_base_dw =
-        publisher->create_datawriter(ms_report_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(ms_report_topic, events_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var ap_report_base_dw =
-        publisher->create_datawriter(ap_report_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(ap_report_topic, events_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataWriter_var colreg_status_base_dw = publisher->create_datawriter(
-        colreg_status_topic, DATAWRITER_QOS_DEFAULT, 0,
+        colreg_status_topic, events_writer_qos, 0,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     if (!actuators_base_dw || !ms_report_base_dw || !ap_report_base_dw ||
@@ -248,10 +324,17 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
           1);
     }
 
-    // Create the DataReaders
-    DDS::DataReaderQos reader_qos;
-    subscriber->get_default_datareader_qos(reader_qos);
-    reader_qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+    // Create the DataReaders, only the latest Sensors sample is of interest
+    // while routes, missions and commands must all arrive
+    DDS::DataReaderQos command_qos;
+    subscriber->get_default_datareader_qos(command_qos);
+    apply_profile(command_qos, QOS_COMMAND);
+    DDS::DataReaderQos sensors_qos;
+    subscriber->get_default_datareader_qos(sensors_qos);
+    apply_profile(sensors_qos, QOS_STATE, SENSORS_DEADLINE_SEC);
+    DDS::DataReaderQos aivdm_qos;
+    subscriber->get_default_datareader_qos(aivdm_qos);
+    apply_profile(aivdm_qos, QOS_EVENTS);
 
     // Route DataReader
     DDS::DataReaderListener_var route_listener(new RouteDataReaderListenerImpl);
@@ -260,7 +343,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
         dynamic_cast<RouteDataReaderListenerImpl *>(route_listener.in());
 
     DDS::DataReader_var route_dr =
-        subscriber->create_datareader(route_topic, reader_qos, route_listener,
+        subscriber->create_datareader(route_topic, command_qos, route_listener,
                                       OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // LoiterPosition DataReader
@@ -272,7 +355,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
             loiter_position_listener.in());
 
     DDS::DataReader_var loiter_position_dr = subscriber->create_datareader(
-        loiter_position_topic, reader_qos, loiter_position_listener,
+        loiter_position_topic, command_qos, loiter_position_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // DiveProcedure DataReader
@@ -284,7 +367,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
             dive_proc_listener.in());
 
     DDS::DataReader_var dive_proc_dr = subscriber->create_datareader(
-        dive_proc_topic, reader_qos, dive_proc_listener,
+        dive_proc_topic, command_qos, dive_proc_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // Mission DataReader
@@ -295,7 +378,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
         dynamic_cast<MissionDataReaderListenerImpl *>(mission_listener.in());
 
     DDS::DataReader_var mission_dr = subscriber->create_datareader(
-        mission_topic, reader_qos, mission_listener,
+        mission_topic, command_qos, mission_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // Mission Command DataReader
@@ -307,7 +390,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
             mission_cmd_listener.in());
 
     DDS::DataReader_var mission_cmd_dr = subscriber->create_datareader(
-        mission_cmd_topic, reader_qos, mission_cmd_listener,
+        mission_cmd_topic, command_qos, mission_cmd_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // Procedure Activation DataReader
@@ -319,7 +402,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
             proc_act_listener.in());
 
     DDS::DataReader_var proc_act_dr = subscriber->create_datareader(
-        proc_act_topic, reader_qos, proc_act_listener,
+        proc_act_topic, command_qos, proc_act_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // AutopilotCommands DataReader
@@ -331,28 +414,28 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
             ap_command_listener.in());
 
     DDS::DataReader_var ap_command_dr = subscriber->create_datareader(
-        autopilot_command_topic, reader_qos, ap_command_listener,
+        autopilot_command_topic, command_qos, ap_command_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // Sensors DataReader
     DDS::DataReaderListener_var sensors_listener(
-        new SensorsDataReaderListenerImpl);
+        new SensorsDataReaderListenerImpl(cosim_counters));
 
     SensorsDataReaderListenerImpl *sensors_listener_servant =
         dynamic_cast<SensorsDataReaderListenerImpl *>(sensors_listener.in());
 
     DDS::DataReader_var sensors_dr = subscriber->create_datareader(
-        sensors_topic, reader_qos, sensors_listener,
+        sensors_topic, sensors_qos, sensors_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     // AIS DataReader
     DDS::DataReaderListener_var aivdm_listener(
-        new AivdmMessageDataReaderListenerImpl());
+        new AivdmMessageDataReaderListenerImpl(cosim_counters));
     AivdmMessageDataReaderListenerImpl *aivdm_listener_servant =
         dynamic_cast<AivdmMessageDataReaderListenerImpl *>(aivdm_listener.in());
 
     DDS::DataReader_var aivdm_dr =
-        subscriber->create_datareader(aivdm_topic, reader_qos, aivdm_listener,
+        subscriber->create_datareader(aivdm_topic, aivdm_qos, aivdm_listener,
                                       OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     if (!route_dr || !ap_command_dr || !loiter_position_dr || !sensors_dr ||
@@ -434,15 +517,24 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     ACE_DEBUG((LM_DEBUG, ACE_TEXT("C2 is available \n")));
 
     // instantiate controllers
-    AutopilotController ap_controller = AutopilotController();
-    MissionController ms_controller = MissionController(&ap_controller);
+    RealClock real_clock;
+    LockstepClock lockstep_clock(cosim);
+    ControlClock &clock = lockstep ? static_cast<ControlClock &>(lockstep_clock)
+                                   : real_clock;
+    if (lockstep) {
+      XLOG(LC_AUTOPILOT, LL_INFO, "Waiting for the co-simulation master\n");
+      cosim.wait_until(1);
+    }
+    AutopilotController ap_controller(clock, AP_LOOP_PERIOD, colreg_radius,
+                                      ais_ttl, position_filter);
+    MissionController ms_controller = MissionController(&ap_controller, clock);
     CORBA::Boolean ap_error = false;
 
     // Main loop, keep listening until C2 disconnects from command topic
-    // sleep 250 ms every iteration
-    ACE_Time_Value sleep_interval = ACE_Time_Value(0, 250000);
+    // run every 250 ms
+    LoopScheduler loop(clock, AP_LOOP_PERIOD);
     while (true) {
-      ACE_hrtime_t start = ACE_OS::gethrtime();
+      ACE_hrtime_t start = loop.begin_cycle();
       DDS::SubscriptionMatchedStatus matches;
       if (ap_command_dr_i->get_subscription_matched_status(matches) !=
           DDS::RETCODE_OK) {
@@ -454,7 +546,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // C2 matched before but not currently anymore -> disconnect
       if (matches.current_count == 0 && matches.total_count > 0) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("C2 disconnected, shutting down\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "C2 disconnected, shutting down\n");
         break;
       }
 
@@ -462,12 +554,12 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // retrieve the latest procedures and missions
       if (mission_listener_servant->mission_changed()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New mission since last check\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New mission since last check\n");
         ms_controller.set_mission(mission_listener_servant->get_mission());
       }
 
       if (route_listener_servant->new_routes_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New route updates since last check\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New route updates since last check\n");
         std::vector<Autopilot::Route> new_routes =
             route_listener_servant->get_routes();
         for (auto route : new_routes) {
@@ -476,8 +568,8 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
       }
 
       if (loiter_listener_servant->new_positions_available()) {
-        ACE_DEBUG((LM_DEBUG,
-                   ACE_TEXT("New loiter position updates since last check\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "New loiter position updates since last check\n");
         std::vector<Autopilot::LoiterPosition> new_lps =
             loiter_listener_servant->get_positions();
         for (auto lp : new_lps) {
@@ -486,15 +578,15 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
       }
 
       if (aivdm_listener_servant->new_messages_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New AIS Messages since last check\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New AIS Messages since last check\n");
         std::vector<PhysicalState::AivdmMessage> new_ais_msgs =
             aivdm_listener_servant->get_messages();
         ap_controller.update_aivdm(new_ais_msgs);
       }
 
       if (dive_proc_listener_servant->new_procs_available()) {
-        ACE_DEBUG(
-            (LM_DEBUG, ACE_TEXT("New dive procs updates since last check\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "New dive procs updates since last check\n");
         std::vector<Autopilot::DiveProcedure> new_dps =
             dive_proc_listener_servant->get_procedures();
         for (auto dp : new_dps) {
@@ -504,7 +596,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // retrieve procedure activation commands
       if (proc_act_listener_servant->new_commands_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New proc activations received\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New proc activations received\n");
         std::vector<Autopilot::ProcedureActivation> new_acts =
             proc_act_listener_servant->get_latest_commands();
         for (auto act : new_acts) {
@@ -514,7 +606,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // retrieve the latest mission and ap commands
       if (mission_cmd_listener_servant->new_commands_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New mission commands received\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New mission commands received\n");
         std::vector<Autopilot::MissionCommand> new_cmds =
             mission_cmd_listener_servant->get_latest_commands();
         for (auto cmd : new_cmds) {
@@ -523,7 +615,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
       }
 
       if (ap_command_listener_servant->new_commands_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New AP commands received\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New AP commands received\n");
         ms_controller.execute_command(Autopilot::MC_SUSPEND);
         std::vector<Autopilot::AutopilotCommand> new_cmds =
             ap_command_listener_servant->get_latest_commands();
@@ -534,7 +626,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // retrieve the latest sensor values if they changed
       if (sensors_listener_servant->new_readings_available()) {
-        ACE_DEBUG((LM_DEBUG, ACE_TEXT("New sensor values received\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "New sensor values received\n");
         ap_error |= ap_controller.set_sensor_vals(
             sensors_listener_servant->get_readings());
       }
@@ -544,42 +636,40 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
       // run ap controller
       if (!ap_error && ap_controller.execute()) {
-        ACE_DEBUG((LM_DEBUG,
-                   ACE_TEXT("Actuator output available, writing to topic\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "Actuator output available, writing to topic\n");
         PhysicalState::Actuators cmds = ap_controller.get_actuator_cmds();
+        if (lockstep) cosim.count_sent(COSIM_ACTUATORS);
         actuators_dw->write(cmds, DDS::HANDLE_NIL);
       }
 
       // check if status reports are available to write
       if (ms_controller.is_report_available()) {
-        ACE_DEBUG(
-            (LM_DEBUG,
-             ACE_TEXT("Mission Status Report available, writing to topic\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "Mission Status Report available, writing to topic\n");
 
         ms_report_dw->write(ms_controller.get_report(), DDS::HANDLE_NIL);
       }
 
       if (ap_controller.is_report_available()) {
-        ACE_DEBUG((
-            LM_DEBUG,
-            ACE_TEXT("Autopilot Status Report available, writing to topic\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "Autopilot Status Report available, writing to topic\n");
 
         ap_report_dw->write(ap_controller.get_report(), DDS::HANDLE_NIL);
       }
 
       if (ap_controller.is_colreg_report_available()) {
-        ACE_DEBUG((
-            LM_DEBUG,
-            ACE_TEXT("Autopilot COLREG Report available, writing to topic\n")));
+        XLOG(LC_AUTOPILOT, LL_DEBUG,
+             "Autopilot COLREG Report available, writing to topic\n");
         colreg_status_dw->write(ap_controller.get_colreg_report(),
                                 DDS::HANDLE_NIL);
       }
 
-      CORBA::Double delta = (ACE_OS::gethrtime() - start) * 1e-6;
-      ACE_DEBUG((LM_DEBUG,
-                 ACE_TEXT("Executed AP loop in %f ms, going to sleep\n"),
-                 delta));
-      ACE_OS::sleep(sleep_interval);
+      CORBA::Double delta = (clock.now() - start) * 1e-6;
+      XLOG(LC_AUTOPILOT, LL_DEBUG,
+           "Executed AP loop in %f ms, going to sleep\n",
+           delta);
+      loop.end_cycle();
     }
 
     // Cleanup
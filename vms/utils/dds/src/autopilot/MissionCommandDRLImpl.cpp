@@ -13,7 +13,8 @@
 #include "AutopilotTypeSupportC.h"
 #include "AutopilotTypeSupportImpl.h"
 
-MissionCommandDataReaderListenerImpl::MissionCommandDataReaderListenerImpl() {
+MissionCommandDataReaderListenerImpl::MissionCommandDataReaderListenerImpl()
+    : stats_("MissionCommand") {
   this->command_changed_ = false;
   this->latest_commands_ = std::vector<Autopilot::MissionCommand>();
 }
@@ -35,14 +36,18 @@ CORBA::Boolean MissionCommandDataReaderListenerImpl::new_commands_available() {
 
 void MissionCommandDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void MissionCommandDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void MissionCommandDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void MissionCommandDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -51,7 +56,9 @@ void MissionCommandDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void MissionCommandDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void MissionCommandDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -65,21 +72,18 @@ void MissionCommandDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::MissionCommand command;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(command, info);
-
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      this->command_changed_ = true;
-      this->latest_commands_.push_back(command);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::MissionCommandSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::MissionCommand &command,
+             const DDS::SampleInfo &) {
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->command_changed_ = true;
+        this->latest_commands_.push_back(command);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -3,14 +3,24 @@
 #include <ace/Basic_Types.h>
 #include <ace/OS_NS_time.h>
 
+#include "../AsyncLog.h"
 #include "AutopilotC.h"
 
-MissionController::MissionController(AutopilotController *ap_controller) {
+MissionController::MissionController(AutopilotController *ap_controller,
+                                     ControlClock &clock)
+    : clock_(clock),
+      timers_(TIMER_RESOLUTION, clock.now()),
+      item_timer_(TimerWheel::INVALID_HANDLE),
+      report_timer_(TimerWheel::INVALID_HANDLE),
+      item_deadline_(0),
+      item_remaining_(0) {
   this->ap_controller_ = ap_controller;
   this->status_ = Autopilot::MS_DISABLED;
   this->mission_set_ = false;
+  this->mission_index_ = 0;
   this->report_available_ = false;
   this->report_ = Autopilot::MissionReport();
+  this->schedule_report(this->clock_.now());
 }
 
 void MissionController::set_mission(Autopilot::Mission ap_mission) {
@@ -19,13 +29,50 @@ void MissionController::set_mission(Autopilot::Mission ap_mission) {
     return;
   }
   this->mission_ = ap_mission;
-  this->mission_items_ = this->mission_.mission_items;
+  this->compile(this->mission_.mission_items);
   this->mission_set_ = true;
   // changing the mission stops it: we don't support updating in-progress
   // missions
   this->execute_command(Autopilot::MC_STOP);
 }
 
+void MissionController::compile(const Autopilot::MissionItemSeq &items) {
+  this->items_.clear();
+  this->items_.reserve(items.length());
+  for (CORBA::ULong i = 0; i < items.length(); ++i) {
+    const Autopilot::MissionItem &item = items[i];
+    CompiledItem compiled;
+    compiled.action = item.action._d();
+    compiled.activation = Autopilot::ProcedureActivation();
+    compiled.ap_cmd = Autopilot::AutopilotCommandType();
+    switch (compiled.action) {
+      case Autopilot::MIAT_ACT_LP: {
+        compiled.activation = Autopilot::ProcedureActivation(
+            {Autopilot::PROC_LOITERPOSITION, item.action.loiter_pos_id()});
+        break;
+      }
+      case Autopilot::MIAT_ACT_ROUTE: {
+        compiled.activation = Autopilot::ProcedureActivation(
+            {Autopilot::PROC_ROUTE, item.action.route_id()});
+        break;
+      }
+      case Autopilot::MIAT_ACT_DP: {
+        compiled.activation = Autopilot::ProcedureActivation(
+            {Autopilot::PROC_DIVEPROCEDURE, item.action.dive_proc_id()});
+        break;
+      }
+      case Autopilot::MIAT_SET_AP_CMD: {
+        compiled.ap_cmd = item.action.ap_cmd();
+        break;
+      }
+    }
+    compiled.until_completion = item.until_completion;
+    compiled.timeout = item.timeout >= 0 ? (ACE_hrtime_t)(item.timeout * 1e9)
+                                         : ACE_UINT64_MAX;
+    this->items_.push_back(compiled);
+  }
+}
+
 CORBA::Boolean MissionController::is_report_available() {
   return this->report_available_;
 }
@@ -34,16 +81,27 @@ Autopilot::MissionReport MissionController::get_report() {
   if (this->mission_set_) {
     this->report_.name = this->mission_.name;
     this->report_.progress = this->mission_index_ + 1;
-    this->report_.length = this->mission_items_.length();
+    this->report_.length = this->items_.size();
   }
   this->report_.status = this->status_;
 
   this->report_available_ = false;
-  this->last_report_ts_ = ACE_OS::gethrtime();
+  this->schedule_report(this->clock_.now());
 
   return this->report_;
 }
 
+void MissionController::schedule_report(ACE_hrtime_t now) {
+  this->timers_.cancel(this->report_timer_);
+  this->report_timer_ =
+      this->timers_.schedule(now + REPORT_INTERVAL, TE_REPORT);
+}
+
+void MissionController::cancel_item_timer() {
+  this->timers_.cancel(this->item_timer_);
+  this->item_timer_ = TimerWheel::INVALID_HANDLE;
+}
+
 void MissionController::execute_command(Autopilot::MissionCommandType command) {
   switch (this->status_) {
     case Autopilot::MS_DISABLED: {
@@ -51,11 +109,10 @@ void MissionController::execute_command(Autopilot::MissionCommandType command) {
         case Autopilot::MC_START: {
           if (this->mission_set_) {
             this->status_ = Autopilot::MS_ENABLED;
-            ACE_DEBUG(
-                (LM_DEBUG,
-                 ACE_TEXT("Starting Mission\nExecuting mission item %i/%i\n"),
-                 this->mission_index_ + 1, this->mission_items_.length()));
-            this->execute_item(this->mission_items_[this->mission_index_]);
+            XLOG(LC_MISSION, LL_DEBUG,
+                 "Starting Mission\nExecuting mission item %i/%i\n",
+                 this->mission_index_ + 1, this->items_.size());
+            this->execute_item(this->mission_index_);
           }
           break;
         }
@@ -74,20 +131,22 @@ void MissionController::execute_command(Autopilot::MissionCommandType command) {
         case Autopilot::MC_STOP: {
           this->status_ = Autopilot::MS_DISABLED;
           this->mission_index_ = 0;
+          this->cancel_item_timer();
           break;
         }
         case Autopilot::MC_SUSPEND: {
           this->status_ = Autopilot::MS_SUSPENDED;
-          this->pause_start_ts_ = ACE_OS::gethrtime();
+          // hold the item timeout until the mission resumes
+          if (this->item_timer_ != TimerWheel::INVALID_HANDLE) {
+            ACE_hrtime_t now = this->clock_.now();
+            this->item_remaining_ =
+                this->item_deadline_ > now ? this->item_deadline_ - now : 0;
+            this->cancel_item_timer();
+          }
           break;
         }
         case Autopilot::MC_SKIP_STEP: {
-          this->mission_index_++;
-          if (this->mission_index_ == this->mission_items_.length()) {
-            this->execute_command(Autopilot::MC_STOP);
-          } else {
-            this->execute_item(this->mission_items_[mission_index_]);
-          }
+          this->next_item();
           break;
         }
         default: {
@@ -105,9 +164,12 @@ void MissionController::execute_command(Autopilot::MissionCommandType command) {
         }
         case Autopilot::MC_RESUME: {
           this->status_ = Autopilot::MS_ENABLED;
-          ACE_hrtime_t now = ACE_OS::gethrtime();
-          this->item_start_ts_ =
-              now - (this->pause_start_ts_ - this->item_start_ts_);
+          const CompiledItem &item = this->items_[this->mission_index_];
+          if (!item.until_completion && item.timeout != ACE_UINT64_MAX) {
+            this->item_deadline_ = this->clock_.now() + this->item_remaining_;
+            this->item_timer_ =
+                this->timers_.schedule(this->item_deadline_, TE_ITEM_TIMEOUT);
+          }
           break;
         }
         default: {
@@ -128,76 +190,59 @@ void MissionController::execute_command(Autopilot::MissionCommandType command) {
   this->report_available_ = true;
 }
 
-void MissionController::execute_item(Autopilot::MissionItem item) {
+void MissionController::execute_item(CORBA::ULong index) {
   // starting a new item, notify CCC
   this->report_available_ = true;
 
-  ACE_hrtime_t now = ACE_OS::gethrtime();
-  this->item_start_ts_ = now;
-  this->item_timeout_ =
-      item.timeout >= 0 ? (ACE_hrtime_t)(item.timeout * 1e9) : ACE_UINT64_MAX;
-
-  switch (item.action._d()) {
-    case Autopilot::MIAT_ACT_LP: {
-      this->ap_controller_->activate_procedure(
-          Autopilot::ProcedureActivation(
-              {Autopilot::PROC_LOITERPOSITION, item.action.loiter_pos_id()}),
-          true);
-      break;
-    }
-    case Autopilot::MIAT_ACT_ROUTE: {
-      this->ap_controller_->activate_procedure(
-          Autopilot::ProcedureActivation(
-              {Autopilot::PROC_ROUTE, item.action.route_id()}),
-          true);
-      break;
-    }
-    case Autopilot::MIAT_ACT_DP: {
-      this->ap_controller_->activate_procedure(
-          Autopilot::ProcedureActivation(
-              {Autopilot::PROC_DIVEPROCEDURE, item.action.dive_proc_id()}),
-          true);
-      break;
-    }
-    case Autopilot::MIAT_SET_AP_CMD: {
-      this->ap_controller_->update_state(item.action.ap_cmd(), true);
-      break;
-    }
-  }
-}
-
-CORBA::Boolean MissionController::run() {
-  ACE_hrtime_t now = ACE_OS::gethrtime();
-  // have we sent a report recently?
-  if (now - this->last_report_ts_ >= REPORT_INTERVAL) {
-    this->report_available_ = true;
+  const CompiledItem &item = this->items_[index];
+  this->cancel_item_timer();
+  if (!item.until_completion && item.timeout != ACE_UINT64_MAX) {
+    this->item_deadline_ = this->clock_.now() + item.timeout;
+    this->item_timer_ =
+        this->timers_.schedule(this->item_deadline_, TE_ITEM_TIMEOUT);
   }
 
-  if (this->status_ == Autopilot::MS_DISABLED ||
-      this->status_ == Autopilot::MS_SUSPENDED) {
-    return false;
+  if (item.action == Autopilot::MIAT_SET_AP_CMD) {
+    this->ap_controller_->update_state(item.ap_cmd, true);
+  } else {
+    this->ap_controller_->activate_procedure(item.activation, true);
   }
+}
 
-  Autopilot::MissionItem current_item = this->mission_items_[mission_index_];
-  CORBA::Boolean item_complete = false;
-
-  if (current_item.until_completion) {
-    item_complete = this->ap_controller_->is_action_completed();
+void MissionController::next_item() {
+  this->mission_index_++;
+  if (this->mission_index_ == this->items_.size()) {
+    this->execute_command(Autopilot::MC_STOP);
   } else {
-    // check if enough time has elapsed
-    if (now - this->item_start_ts_ >= this->item_timeout_) item_complete = true;
+    XLOG(LC_MISSION, LL_DEBUG, "Executing mission item %i/%i\n",
+         this->mission_index_ + 1, this->items_.size());
+    this->execute_item(this->mission_index_);
   }
+}
 
-  if (item_complete) {
-    this->mission_index_++;
-    if (this->mission_index_ == this->mission_items_.length()) {
-      this->execute_command(Autopilot::MC_STOP);
-    } else {
-      ACE_DEBUG((LM_DEBUG, ACE_TEXT("Executing mission item %i/%i\n"),
-                 this->mission_index_ + 1, this->mission_items_.length()));
-      this->execute_item(this->mission_items_[mission_index_]);
+CORBA::Boolean MissionController::run() {
+  this->fired_.clear();
+  this->timers_.advance(this->clock_.now(), this->fired_);
+  for (uint32_t event : this->fired_) {
+    switch (event) {
+      case TE_REPORT: {
+        this->report_available_ = true;
+        this->report_timer_ = TimerWheel::INVALID_HANDLE;
+        break;
+      }
+      case TE_ITEM_TIMEOUT: {
+        this->item_timer_ = TimerWheel::INVALID_HANDLE;
+        if (this->status_ == Autopilot::MS_ENABLED) this->next_item();
+        break;
+      }
     }
   }
 
+  if (this->status_ == Autopilot::MS_ENABLED &&
+      this->items_[this->mission_index_].until_completion &&
+      this->ap_controller_->is_action_completed()) {
+    this->next_item();
+  }
+
   return false;
 }
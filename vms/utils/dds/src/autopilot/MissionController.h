@@ -2,30 +2,67 @@
 #define MISSION_CONTROLLER_H
 
 #include <ace/OS_NS_time.h>
+
+#include <vector>
+
 #include "AutopilotC.h"
 #include "AutopilotController.h"
+#include "ControlClock.h"
+#include "TimerWheel.h"
+
+// Runs missions item by item. Items are compiled into their activations
+// when the mission is set, and item timeouts and reports are timers on a
+// timer wheel, so run() does nothing between events beyond checking whether
+// the autopilot completed an item that waits for completion.
 class MissionController {
  public:
-  explicit MissionController(AutopilotController *);
+  MissionController(AutopilotController *, ControlClock &);
   void set_mission(Autopilot::Mission);
   void execute_command(Autopilot::MissionCommandType);
   CORBA::Boolean run();
+  // earliest time at which run() has a timeout or report due, items that
+  // wait for the autopilot to complete them are not included
+  ACE_hrtime_t next_event() const { return this->timers_.next_deadline(); }
   CORBA::Boolean is_report_available();
   Autopilot::MissionReport get_report();
 
  private:
-  void execute_item(Autopilot::MissionItem);
+  // a mission item resolved into what starting it does
+  struct CompiledItem {
+    Autopilot::MissionItemActionType action;
+    Autopilot::ProcedureActivation activation;
+    Autopilot::AutopilotCommandType ap_cmd;
+    CORBA::Boolean until_completion;
+    // nanoseconds, ACE_UINT64_MAX if the item never times out
+    ACE_hrtime_t timeout;
+  };
+
+  enum TimerEvent : uint32_t { TE_ITEM_TIMEOUT, TE_REPORT };
+
+  void compile(const Autopilot::MissionItemSeq &);
+  void execute_item(CORBA::ULong index);
+  void next_item();
+  void cancel_item_timer();
+  void schedule_report(ACE_hrtime_t now);
+
   const ACE_hrtime_t REPORT_INTERVAL = 15 * 1e9;
+  const ACE_hrtime_t TIMER_RESOLUTION = 1 * 1e6;
   AutopilotController *ap_controller_;
+  ControlClock &clock_;
   Autopilot::MissionStatus status_;
   Autopilot::Mission mission_;
   CORBA::Boolean mission_set_;
   CORBA::ULong mission_index_;
-  Autopilot::MissionItemSeq mission_items_;
-  ACE_hrtime_t item_start_ts_;
-  ACE_hrtime_t item_timeout_;
-  ACE_hrtime_t pause_start_ts_;
-  ACE_hrtime_t last_report_ts_;
+  std::vector<CompiledItem> items_;
+
+  TimerWheel timers_;
+  std::vector<uint32_t> fired_;
+  TimerWheel::Handle item_timer_;
+  TimerWheel::Handle report_timer_;
+  ACE_hrtime_t item_deadline_;
+  // time left on the item timeout while the mission is suspended
+  ACE_hrtime_t item_remaining_;
+
   CORBA::Boolean report_available_;
   Autopilot::MissionReport report_;
 };
@@ -5,10 +5,12 @@
 #include <dds/DdsDcpsInfrastructureC.h>
 #include <tao/Basic_Types.h>
 
+#include "../AsyncLog.h"
 #include "AutopilotC.h"
 #include "AutopilotTypeSupportC.h"
 
-MissionDataReaderListenerImpl::MissionDataReaderListenerImpl() {
+MissionDataReaderListenerImpl::MissionDataReaderListenerImpl()
+    : stats_("Mission") {
   this->mission_changed_ = false;
 }
 
@@ -27,14 +29,18 @@ Autopilot::Mission MissionDataReaderListenerImpl::get_mission() {
 
 void MissionDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void MissionDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void MissionDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void MissionDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -43,7 +49,9 @@ void MissionDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void MissionDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void MissionDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -57,39 +65,34 @@ void MissionDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::Mission mission;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(mission, info);
-
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_DEBUG((LM_DEBUG,
-                 ACE_TEXT("Received a mission:\n"
-                          "    id:   %i\n"
-                          "    name: %s\n"
-                          "    items:\n"),
-                 mission.id, (const char *)(mission.name)));
-    }
-
-    CORBA::ULong mission_len = mission.mission_items.length();
-
-    for (uint i = 0; i < mission_len; ++i) {
-      ACE_DEBUG((LM_DEBUG,
-                 ACE_TEXT("        - item %i [until completion: %i, timeout: "
-                          "%i, cmd_type: %i]\n"),
-                 i, mission.mission_items[i].until_completion,
-                 mission.mission_items[i].timeout,
-                 mission.mission_items[i].action._d()));
-    }
-
-    ACE_Guard<ACE_Mutex> guard(this->lock_);
-    this->mission_changed_ = true;
-    this->latest_mission_ = mission;
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::MissionSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::Mission &mission, const DDS::SampleInfo &) {
+        XLOG(LC_MISSION, LL_DEBUG, "Received a mission:\n"
+                                   "    id:   %i\n"
+                                   "    name: %s\n"
+                                   "    items:\n",
+             mission.id, (const char *)(mission.name));
+
+        CORBA::ULong mission_len = mission.mission_items.length();
+
+        for (uint i = 0; i < mission_len; ++i) {
+          XLOG(LC_MISSION, LL_DEBUG,
+               "        - item %i [until completion: %i, timeout: "
+               "%i, cmd_type: %i]\n",
+               i, mission.mission_items[i].until_completion,
+               mission.mission_items[i].timeout,
+               mission.mission_items[i].action._d());
+        }
+
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->mission_changed_ = true;
+        this->latest_mission_ = mission;
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
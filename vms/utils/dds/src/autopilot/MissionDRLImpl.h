@@ -5,6 +5,7 @@
 #include <dds/DCPS/LocalObject.h>
 #include <dds/DdsDcpsSubscriptionC.h>
 
+#include "../ReaderSupport.h"
 #include "AutopilotC.h"
 
 class MissionDataReaderListenerImpl
@@ -49,6 +50,7 @@ class MissionDataReaderListenerImpl
   Autopilot::Mission latest_mission_;
   CORBA::Boolean mission_changed_;
   ACE_Mutex lock_;
+  ReaderStats stats_;
 };
 
 #endif
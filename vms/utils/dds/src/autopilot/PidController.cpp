@@ -5,6 +5,10 @@
 #include <ace/OS_NS_time.h>
 #include <ace/ace_wchar.h>
 
+#include <algorithm>
+
+#include "../AsyncLog.h"
+
 PidController::PidController(CORBA::Double kp, CORBA::Double ki,
                              CORBA::Double kd)
     : PidController(kp, ki, kd, 0.0, 1.0, 1.0) {}
@@ -25,7 +29,7 @@ PidController::PidController(CORBA::Double kp, CORBA::Double ki,
       integral_decay_{integral_decay} {
   this->integral_ = 0.0;
   this->previous_error_ = 0.0;
-  this->last_ts_ = 0.0;
+  this->last_ts_ = 0;
 }
 
 CORBA::Double PidController::compute_error(CORBA::Double measured,
@@ -42,16 +46,18 @@ CORBA::Double AngularPidController::compute_error(CORBA::Double measured,
 }
 
 CORBA::Double PidController::control(CORBA::Double measured,
-                                     CORBA::Double setpoint) {
+                                     CORBA::Double setpoint,
+                                     ACE_hrtime_t now) {
   CORBA::Double error = this->compute_error(measured, setpoint);
-  ACE_hrtime_t now = ACE_OS::gethrtime();
-  // convert from ns to seconds
-  CORBA::Double delta = (now - this->last_ts_) * 1e-9;
-
-  // ignore integral and derivative on first iteration
-  if (this->last_ts_ == 0.0) delta = 0.0;
-  // reset integral and ignore derivative after a timeout
-  if (delta > this->TIMEOUT) {
+  // step over the nominal period so that scheduling jitter does not leak
+  // into the output
+  CORBA::Double delta = this->period_;
+
+  if (this->last_ts_ == 0) {
+    // ignore integral and derivative on first iteration
+    delta = 0.0;
+  } else if ((now - this->last_ts_) * 1e-9 > this->TIMEOUT) {
+    // reset integral and ignore derivative after a timeout
     delta = 0.0;
     this->integral_ = 0.0;
   }
@@ -63,35 +69,42 @@ CORBA::Double PidController::control(CORBA::Double measured,
   // decay the integral to reduce potential windup in long scenarios
   // this is probably not always desirable though, so prefer using
   // integral_decay=1.0 if it works
+  CORBA::Double previous_integral = this->integral_;
   this->integral_ = this->integral_ * this->integral_decay_ + (error * delta);
 
+  // the integral term alone never needs to exceed the output range
+  if (this->ki_ != 0.0) {
+    CORBA::Double bound_a = this->min_ / this->ki_;
+    CORBA::Double bound_b = this->max_ / this->ki_;
+    this->integral_ = std::min(std::max(this->integral_,
+                                        std::min(bound_a, bound_b)),
+                               std::max(bound_a, bound_b));
+  }
+
   CORBA::Double output =
       this->kp_ * error + this->ki_ * this->integral_ + this->kd_ * derivative;
 
-  // clamp output
-  CORBA::Boolean saturated = false;
-  if (output > this->max_) {
-    output = this->max_;
-    saturated = true;
-  } else if (output < this->min_) {
-    output = this->min_;
-    saturated = true;
+  // avoid causing windup through process saturation, only hold the integral
+  // while it would push the output further into the limit
+  CORBA::Double push = this->ki_ * error;
+  if ((output > this->max_ && push > 0.0) ||
+      (output < this->min_ && push < 0.0)) {
+    // as it was, undoing the step after the clamp above would overshoot
+    this->integral_ = previous_integral;
   }
 
-  // avoid causing windup through process saturation
-  if (saturated) this->integral_ -= (error * delta);
-
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("PID control:\n"
-                      "    target:     %f\n"
-                      "    current:    %f\n"
-                      "    delta:      %f\n"
-                      "    error:      %f\n"
-                      "    integral:   %f\n"
-                      "    derivative: %f\n"
-                      "    output:     %f\n"),
-             setpoint, measured, delta, error, this->integral_, derivative,
-             output));
+  // clamp output
+  output = std::min(std::max(output, this->min_), this->max_);
+
+  XLOG(LC_PID, LL_DEBUG, "PID control:\n"
+                         "    target:     %f\n"
+                         "    current:    %f\n"
+                         "    delta:      %f\n"
+                         "    error:      %f\n"
+                         "    integral:   %f\n"
+                         "    derivative: %f\n"
+                         "    output:     %f\n",
+       setpoint, measured, delta, error, this->integral_, derivative, output);
 
   return output;
 }
@@ -1,6 +1,7 @@
 #ifndef PIDCONTROLLER_H
 #define PIDCONTROLLER_H
 
+#include <ace/OS_NS_time.h>
 #include <tao/Basic_Types.h>
 
 class PidController {
@@ -12,13 +13,19 @@ class PidController {
                 CORBA::Double min, CORBA::Double max,
                 CORBA::Double integral_decay);
 
-  CORBA::Double control(CORBA::Double measured, CORBA::Double setpoint);
+  // now is the time of the control cycle, the integral and derivative are
+  // taken over the nominal period regardless of when the cycle actually ran
+  CORBA::Double control(CORBA::Double measured, CORBA::Double setpoint,
+                        ACE_hrtime_t now);
+  // nominal control period in seconds
+  void set_period(CORBA::Double period) { this->period_ = period; }
 
  private:
   virtual CORBA::Double compute_error(CORBA::Double measured,
                                       CORBA::Double setpoint);
 
   const CORBA::Double TIMEOUT = 15.0;
+  CORBA::Double period_ = 0.25;
   CORBA::Double kp_;
   CORBA::Double ki_;
   CORBA::Double kd_;
@@ -30,7 +37,7 @@ class PidController {
 
   CORBA::Double integral_;
   CORBA::Double previous_error_;
-  CORBA::Double last_ts_;
+  ACE_hrtime_t last_ts_;
 };
 
 class AngularPidController : public PidController {
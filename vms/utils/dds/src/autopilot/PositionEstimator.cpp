@@ -0,0 +1,119 @@
+#include "PositionEstimator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+
+#include "GnssKalmanFilter.h"
+#include "Marmaths.h"
+
+std::unique_ptr<PositionEstimator> make_position_estimator(
+    PositionFilter filter) {
+  switch (filter) {
+    case PF_KALMAN:
+      return std::unique_ptr<PositionEstimator>(new GnssKalmanFilter());
+    case PF_MEDIAN:
+    default:
+      return std::unique_ptr<PositionEstimator>(new MedianVotingEstimator());
+  }
+}
+
+bool parse_position_filter(const std::string& name, PositionFilter& filter) {
+  if (name == "median") {
+    filter = PF_MEDIAN;
+  } else if (name == "kalman") {
+    filter = PF_KALMAN;
+  } else {
+    return true;
+  }
+  return false;
+}
+
+Autopilot::Coordinates MedianVotingEstimator::update(
+    const PhysicalState::Sensors& sensors, ACE_hrtime_t now) {
+  // Sensors values we fuse. Duplication of gnss_2 and gnss_1 are placeholders
+  // in case we can't do dead reckoning or constant movement bias yet due to
+  // lack of previous estimates
+  std::array<CORBA::Double, 5> lat_vals = {
+      sensors.gnss_1.latitude, sensors.gnss_2.latitude, sensors.gnss_3.latitude,
+      sensors.gnss_2.latitude, sensors.gnss_1.latitude};
+  std::array<CORBA::Double, 5> lon_vals = {
+      sensors.gnss_1.longitude, sensors.gnss_2.longitude,
+      sensors.gnss_3.longitude, sensors.gnss_2.longitude,
+      sensors.gnss_1.longitude};
+
+  if (this->has_previous_) {
+    // Dead reckoning, guess cog and sog by averaging previous and current value
+    // Compute time delta in seconds to extrapolate new position from sog
+    CORBA::Double delta = (now - this->last_estimate_ts_) * 1e-9;
+    CORBA::Double sog = (this->previous_sensors_.speed_over_ground +
+                         sensors.speed_over_ground) /
+                        2;
+    CORBA::Double cog = (this->previous_sensors_.course_over_ground +
+                         sensors.course_over_ground) /
+                        2;
+
+    CORBA::Double lat_shift;
+    CORBA::Double lon_shift;
+    std::tie(lat_shift, lon_shift) = polar_to_cartesian(cog, sog * delta);
+    EnuPoint estimate = this->frame_.to_local(
+        this->estimated_position_.latitude,
+        this->estimated_position_.longitude);
+    this->frame_.to_geodetic(
+        {estimate.east + lon_shift, estimate.north + lat_shift}, lat_vals[3],
+        lon_vals[3]);
+
+    if (this->previous_estimated_position_.latitude != 0 &&
+        this->previous_estimated_position_.longitude != 0) {
+      // add bias towards constant movement
+      lat_vals[4] = this->estimated_position_.latitude +
+                    (this->estimated_position_.latitude -
+                     this->previous_estimated_position_.latitude);
+      lon_vals[4] = this->estimated_position_.longitude +
+                    (this->estimated_position_.longitude -
+                     this->previous_estimated_position_.longitude);
+    }
+  }
+
+  std::sort(lat_vals.begin(), lat_vals.end());
+  std::sort(lon_vals.begin(), lon_vals.end());
+
+  CORBA::Long lat_count = 0;
+  CORBA::Long lon_count = 0;
+  CORBA::Double lat_sum = 0.0;
+  CORBA::Double lon_sum = 0.0;
+
+  // the offsets are a few meters, the scale at the median is exact enough
+  const CORBA::Double m_per_deg_lat = EARTH_RADIUS * DEG_TO_RAD;
+  const CORBA::Double m_per_deg_lon =
+      m_per_deg_lat * std::cos(lat_vals[2] * DEG_TO_RAD);
+
+  for (int i = 0; i < 5; ++i) {
+    // discard sensor/estimate lat or lon val if it seems implausible (>10m
+    // error), use the median value as reference as a sort of voting scheme
+    CORBA::Double lat_offset = (lat_vals[i] - lat_vals[2]) * m_per_deg_lat;
+    CORBA::Double lon_offset = (lon_vals[i] - lon_vals[2]) * m_per_deg_lon;
+    if (std::abs(lat_offset) < 10.0) {
+      lat_sum += lat_vals[i];
+      lat_count++;
+    }
+    if (std::abs(lon_offset) < 10.0) {
+      lon_sum += lon_vals[i];
+      lon_count++;
+    }
+  }
+
+  this->previous_estimated_position_ = this->estimated_position_;
+
+  // compute mean values of plausible sensors to smooth out noise
+  this->estimated_position_.latitude = lat_sum / lat_count;
+  this->estimated_position_.longitude = lon_sum / lon_count;
+  this->frame_.follow(this->estimated_position_.latitude,
+                      this->estimated_position_.longitude);
+
+  this->previous_sensors_ = sensors;
+  this->has_previous_ = true;
+  this->last_estimate_ts_ = now;
+  return this->estimated_position_;
+}
@@ -0,0 +1,48 @@
+#ifndef AUTOPILOT_POSITION_ESTIMATOR_H
+#define AUTOPILOT_POSITION_ESTIMATOR_H
+
+#include <ace/OS_NS_time.h>
+
+#include <memory>
+#include <string>
+
+#include "AutopilotC.h"
+#include "LocalFrame.h"
+#include "PhysicalStateC.h"
+
+enum PositionFilter { PF_MEDIAN, PF_KALMAN };
+
+// Fuses the navigation sensors into an estimate of own ship's position.
+class PositionEstimator {
+ public:
+  virtual ~PositionEstimator() = default;
+
+  // fold in one set of sensor values taken at now, returns the new estimate
+  virtual Autopilot::Coordinates update(const PhysicalState::Sensors& sensors,
+                                        ACE_hrtime_t now) = 0;
+  virtual const char* name() const = 0;
+};
+
+std::unique_ptr<PositionEstimator> make_position_estimator(
+    PositionFilter filter);
+// parses "median" or "kalman", returns true on error
+bool parse_position_filter(const std::string& name, PositionFilter& filter);
+
+// The original estimator: averages the GNSS fixes and two dead reckoning
+// guesses per axis, dropping values more than 10 m from the median.
+class MedianVotingEstimator : public PositionEstimator {
+ public:
+  Autopilot::Coordinates update(const PhysicalState::Sensors& sensors,
+                                ACE_hrtime_t now) override;
+  const char* name() const override { return "median"; }
+
+ private:
+  LocalFrame frame_{};
+  bool has_previous_ = false;
+  PhysicalState::Sensors previous_sensors_{};
+  Autopilot::Coordinates estimated_position_{0.0, 0.0};
+  Autopilot::Coordinates previous_estimated_position_{0.0, 0.0};
+  ACE_hrtime_t last_estimate_ts_ = 0;
+};
+
+#endif
@@ -8,11 +8,13 @@
 
 #include <iostream>
 
+#include "../AsyncLog.h"
 #include "AutopilotC.h"
 #include "AutopilotTypeSupportC.h"
 #include "AutopilotTypeSupportImpl.h"
 
-RouteDataReaderListenerImpl::RouteDataReaderListenerImpl() {
+RouteDataReaderListenerImpl::RouteDataReaderListenerImpl()
+    : stats_("Route") {
   // don't send the initial route to the AP controller
   this->route_changed_ = false;
   this->latest_routes_ = std::vector<Autopilot::Route>();
@@ -34,14 +36,18 @@ CORBA::Boolean RouteDataReaderListenerImpl::new_routes_available() {
 
 void RouteDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void RouteDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void RouteDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void RouteDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -50,7 +56,9 @@ void RouteDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void RouteDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void RouteDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -64,46 +72,39 @@ void RouteDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::Route route;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(route, info);
-
-  if (error == DDS::RETCODE_OK) {
-    ACE_DEBUG((LM_DEBUG,
-               ACE_TEXT("SampleInfo.sample_rank:    %i\n"
-                        "SampleInfo.instance_state: %s\n"),
-               info.sample_rank,
-               OpenDDS::DCPS::InstanceState::instance_state_mask_string(
-                   info.instance_state)
-                   .c_str()));
-    if (info.valid_data) {
-      ACE_DEBUG((LM_DEBUG,
-                 ACE_TEXT("Received a route:\n"
-                          "    id:            %i\n"
-                          "    name:          %s\n"
-                          "    planned speed: %f\n"
-                          "    waypoints:  \n"),
-                 route.id, (const char *)(route.name), route.planned_speed));
-      CORBA::ULong route_len = route.waypoints.length();
-
-      for (uint i = 0; i < route_len; ++i) {
-        ACE_DEBUG(
-            (LM_DEBUG,
-             ACE_TEXT("        - waypoint %i: [name: %s, lat: %f, lon: %f]\n"),
-             i, (const char *)route.waypoints[i].name,
-             route.waypoints[i].coords.latitude,
-             route.waypoints[i].coords.longitude));
-      }
-
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      this->route_changed_ = true;
-      this->latest_routes_.push_back(route);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::RouteSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::Route &route, const DDS::SampleInfo &info) {
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "SampleInfo.sample_rank:    %i\n"
+                                     "SampleInfo.instance_state: %s\n",
+             info.sample_rank,
+             OpenDDS::DCPS::InstanceState::instance_state_mask_string(
+                 info.instance_state)
+                 .c_str());
+        XLOG(LC_AUTOPILOT, LL_DEBUG, "Received a route:\n"
+                                     "    id:            %i\n"
+                                     "    name:          %s\n"
+                                     "    planned speed: %f\n"
+                                     "    waypoints:  \n",
+             route.id, (const char *)(route.name), route.planned_speed);
+        CORBA::ULong route_len = route.waypoints.length();
+
+        for (uint i = 0; i < route_len; ++i) {
+          XLOG(LC_AUTOPILOT, LL_DEBUG,
+               "        - waypoint %i: [name: %s, lat: %f, lon: %f]\n",
+               i, (const char *)route.waypoints[i].name,
+               route.waypoints[i].coords.latitude,
+               route.waypoints[i].coords.longitude);
+        }
+
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        this->route_changed_ = true;
+        this->latest_routes_.push_back(route);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
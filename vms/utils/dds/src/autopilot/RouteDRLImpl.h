@@ -10,6 +10,7 @@
 
 #include <vector>
 
+#include "../ReaderSupport.h"
 #include "AutopilotC.h"
 
 class RouteDataReaderListenerImpl
@@ -54,6 +55,7 @@ class RouteDataReaderListenerImpl
   std::vector<Autopilot::Route> latest_routes_;
   CORBA::Boolean route_changed_;
   ACE_Mutex lock_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -0,0 +1,244 @@
+#include "RouteGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Marmaths.h"
+
+namespace {
+
+double wrap_lon(double lon) {
+  if (lon > 180.0) return lon - 360.0;
+  if (lon < -180.0) return lon + 360.0;
+  return lon;
+}
+
+}  // namespace
+
+RouteGeometry::RouteGeometry(double turn_radius, double cell_size_deg)
+    : turn_radius_(turn_radius),
+      cell_size_(cell_size_deg),
+      rows_(static_cast<int64_t>(std::ceil(180.0 / cell_size_deg))),
+      cols_(static_cast<int64_t>(std::ceil(360.0 / cell_size_deg))),
+      length_(0.0),
+      current_(0),
+      rejoins_(0) {}
+
+RouteGeometry::CellKey RouteGeometry::cell_of(int64_t row, int64_t col) const {
+  row = std::min(std::max(row, int64_t(0)), this->rows_ - 1);
+  col = ((col % this->cols_) + this->cols_) % this->cols_;
+  return row * this->cols_ + col;
+}
+
+void RouteGeometry::build(const Autopilot::WaypointSeq& waypoints) {
+  this->segments_.clear();
+  this->grid_.clear();
+  this->length_ = 0.0;
+  this->current_ = 0;
+
+  for (CORBA::ULong i = 1; i < waypoints.length(); ++i) {
+    const Autopilot::Coordinates& from = waypoints[i - 1].coords;
+    const Autopilot::Coordinates& to = waypoints[i].coords;
+    double d_lat = to.latitude - from.latitude;
+    double d_lon = wrap_lon(to.longitude - from.longitude);
+    double leg = distance_harvesine(from.latitude, from.longitude,
+                                    to.latitude, to.longitude);
+    if (leg < MIN_LEG) continue;
+
+    std::size_t pieces =
+        static_cast<std::size_t>(std::ceil(leg / MAX_SEGMENT));
+    for (std::size_t k = 0; k < pieces; ++k) {
+      double f0 = static_cast<double>(k) / pieces;
+      double f1 = static_cast<double>(k + 1) / pieces;
+      Segment segment;
+      segment.plane.anchor(from.latitude + f0 * d_lat,
+                           wrap_lon(from.longitude + f0 * d_lon));
+      EnuPoint end = segment.plane.to_local(from.latitude + f1 * d_lat,
+                                            from.longitude + f1 * d_lon);
+      segment.length = std::sqrt(end.east * end.east + end.north * end.north);
+      segment.dir_east = end.east / segment.length;
+      segment.dir_north = end.north / segment.length;
+      segment.start = this->length_;
+      segment.wheel_over = 0.0;
+      segment.waypoint = i;
+      this->length_ += segment.length;
+      this->segments_.push_back(segment);
+    }
+    for (std::size_t k = this->segments_.size() - pieces;
+         k < this->segments_.size(); ++k) {
+      this->segments_[k].leg_end = this->length_;
+    }
+  }
+
+  // start turning onto the next leg where a circle of the turn radius
+  // touches both legs, but never so early that the route has to be rejoined
+  for (std::size_t i = 0; i + 1 < this->segments_.size(); ++i) {
+    Segment& current = this->segments_[i];
+    const Segment& next = this->segments_[i + 1];
+    if (current.waypoint == next.waypoint) continue;
+    double cross =
+        current.dir_east * next.dir_north - current.dir_north * next.dir_east;
+    double dot =
+        current.dir_east * next.dir_east + current.dir_north * next.dir_north;
+    double turn = std::abs(std::atan2(cross, dot));
+    double limit = std::min({0.5 * current.length, 0.5 * next.length,
+                             0.5 * REJOIN_DISTANCE});
+    current.wheel_over =
+        turn < 0.5 * M_PI ? this->turn_radius_ * std::tan(0.5 * turn) : limit;
+    current.wheel_over = std::min(current.wheel_over, limit);
+  }
+
+  for (std::size_t i = 0; i < this->segments_.size(); ++i) {
+    const Segment& segment = this->segments_[i];
+    Autopilot::Coordinates start = this->point_at(i, 0.0);
+    Autopilot::Coordinates end = this->point_at(i, segment.length);
+    double lat0 = start.latitude;
+    double lon0 = start.longitude;
+    double lat1 = end.latitude;
+    // unwrapped across the antimeridian, the columns are wrapped
+    double lon1 = lon0 + wrap_lon(end.longitude - lon0);
+    int64_t row_min = static_cast<int64_t>(
+        std::floor((std::min(lat0, lat1) + 90.0) / this->cell_size_));
+    int64_t row_max = static_cast<int64_t>(
+        std::floor((std::max(lat0, lat1) + 90.0) / this->cell_size_));
+    int64_t col_min = static_cast<int64_t>(std::floor(
+        (std::min(lon0, lon1) + 180.0) / this->cell_size_));
+    int64_t col_max = static_cast<int64_t>(std::floor(
+        (std::max(lon0, lon1) + 180.0) / this->cell_size_));
+    for (int64_t row = row_min; row <= row_max; ++row) {
+      for (int64_t col = col_min; col <= col_max; ++col) {
+        this->grid_[this->cell_of(row, col)].push_back(
+            static_cast<uint32_t>(i));
+      }
+    }
+  }
+}
+
+void RouteGeometry::seek(CORBA::ULong waypoint) {
+  auto found = std::lower_bound(
+      this->segments_.begin(), this->segments_.end(), waypoint,
+      [](const Segment& segment, CORBA::ULong value) {
+        return segment.waypoint < value;
+      });
+  if (found == this->segments_.end() && found != this->segments_.begin()) {
+    --found;
+  }
+  this->current_ = found - this->segments_.begin();
+}
+
+void RouteGeometry::project(std::size_t i, double lat, double lon,
+                            double& along, double& cross) const {
+  const Segment& segment = this->segments_[i];
+  EnuPoint point = segment.plane.to_local(lat, lon);
+  along = point.east * segment.dir_east + point.north * segment.dir_north;
+  cross = point.east * segment.dir_north - point.north * segment.dir_east;
+}
+
+double RouteGeometry::distance_to(std::size_t i, double lat,
+                                  double lon) const {
+  double along;
+  double cross;
+  this->project(i, lat, lon, along, cross);
+  double over = std::max({-along, along - this->segments_[i].length, 0.0});
+  return std::sqrt(over * over + cross * cross);
+}
+
+Autopilot::Coordinates RouteGeometry::point_at(std::size_t i,
+                                               double along) const {
+  const Segment& segment = this->segments_[i];
+  Autopilot::Coordinates point;
+  segment.plane.to_geodetic(
+      {along * segment.dir_east, along * segment.dir_north}, point.latitude,
+      point.longitude);
+  return point;
+}
+
+void RouteGeometry::rejoin(double lat, double lon) {
+  ++this->rejoins_;
+  this->candidates_.clear();
+
+  double lat_reach = REJOIN_SEARCH / (EARTH_RADIUS * DEG_TO_RAD);
+  double widest_lat = std::min(89.0, std::abs(lat) + lat_reach);
+  double lon_reach = lat_reach / std::cos(widest_lat * DEG_TO_RAD);
+  int64_t row_min = static_cast<int64_t>(
+      std::floor((lat - lat_reach + 90.0) / this->cell_size_));
+  int64_t row_max = static_cast<int64_t>(
+      std::floor((lat + lat_reach + 90.0) / this->cell_size_));
+  int64_t col_min = static_cast<int64_t>(
+      std::floor((lon - lon_reach + 180.0) / this->cell_size_));
+  int64_t col_max = static_cast<int64_t>(
+      std::floor((lon + lon_reach + 180.0) / this->cell_size_));
+
+  // distance to the closest point of each segment nearby
+  double nearest = REJOIN_SEARCH;
+  for (int64_t row = row_min; row <= row_max; ++row) {
+    for (int64_t col = col_min; col <= col_max; ++col) {
+      auto cell = this->grid_.find(this->cell_of(row, col));
+      if (cell == this->grid_.end()) continue;
+      for (uint32_t index : cell->second) {
+        double distance = this->distance_to(index, lat, lon);
+        if (distance > REJOIN_SEARCH) continue;
+        nearest = std::min(nearest, distance);
+        this->candidates_.push_back(index);
+      }
+    }
+  }
+  if (this->candidates_.empty()) return;
+
+  // among the nearest, prefer the first one at or after the current segment
+  std::size_t best_ahead = this->segments_.size();
+  std::size_t best_behind = this->segments_.size();
+  for (uint32_t index : this->candidates_) {
+    if (this->distance_to(index, lat, lon) > nearest + REJOIN_SLACK) continue;
+    if (index >= this->current_) {
+      best_ahead = std::min<std::size_t>(best_ahead, index);
+    } else {
+      best_behind = std::min<std::size_t>(best_behind, index);
+    }
+  }
+  this->current_ =
+      best_ahead < this->segments_.size() ? best_ahead : best_behind;
+}
+
+RouteProgress RouteGeometry::track(double lat, double lon, double lookahead) {
+  double along;
+  double cross;
+  this->project(this->current_, lat, lon, along, cross);
+  if (std::abs(cross) > REJOIN_DISTANCE || along < -REJOIN_DISTANCE) {
+    this->rejoin(lat, lon);
+    this->project(this->current_, lat, lon, along, cross);
+  }
+  // far off the track with nothing to rejoin nearby, head back to the
+  // current segment instead of skipping ahead
+  while (this->current_ + 1 < this->segments_.size() &&
+         std::abs(cross) <= REJOIN_DISTANCE &&
+         along >= this->segments_[this->current_].length -
+                      this->segments_[this->current_].wheel_over) {
+    ++this->current_;
+    this->project(this->current_, lat, lon, along, cross);
+  }
+
+  const Segment& segment = this->segments_[this->current_];
+  RouteProgress progress;
+  progress.waypoint = segment.waypoint;
+  progress.cross_track = cross;
+  progress.along_track = segment.start + along;
+  progress.leg_remaining = segment.leg_end - progress.along_track;
+  progress.leg_end_distance =
+      std::sqrt(progress.leg_remaining * progress.leg_remaining +
+                cross * cross);
+  progress.last_leg = segment.leg_end == this->length_;
+
+  // the lookahead point may lie on a later segment, it never goes past the
+  // end of the route
+  double target = std::max(progress.along_track + lookahead, segment.start);
+  std::size_t i = this->current_;
+  while (i + 1 < this->segments_.size() &&
+         target > this->segments_[i].start + this->segments_[i].length) {
+    ++i;
+  }
+  progress.lookahead = this->point_at(
+      i, std::min(target - this->segments_[i].start,
+                  this->segments_[i].length));
+  return progress;
+}
@@ -0,0 +1,119 @@
+#ifndef AUTOPILOT_ROUTE_GEOMETRY_H
+#define AUTOPILOT_ROUTE_GEOMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "AutopilotC.h"
+#include "LocalFrame.h"
+
+// where own ship is relative to the route track
+struct RouteProgress {
+  // waypoint at the end of the leg being tracked
+  CORBA::ULong waypoint;
+  // meters right (positive) or left of the track
+  double cross_track;
+  // meters along the route from the first waypoint
+  double along_track;
+  // meters along the track to the end of the leg
+  double leg_remaining;
+  // straight distance to the end of the leg
+  double leg_end_distance;
+  // the leg ends at the end of the route
+  bool last_leg;
+  // point on the track to steer towards
+  Autopilot::Coordinates lookahead;
+};
+
+// Precomputed geometry of a route for line-of-sight waypoint tracking.
+//
+// build() splits every leg into straight segments of at most MAX_SEGMENT
+// meters, each with a LocalFrame anchored at its start as tangent plane, its
+// unit direction, along-track offset and the wheel-over distance needed to
+// turn onto the next leg with the given turn radius. Zero length legs are
+// dropped. Segments are also binned into a uniform lat/lon grid.
+//
+// track() projects the position onto the current segment and moves forward
+// segment by segment, so a cycle costs a few multiplications. Only when own
+// ship is far off the track, e.g. after a COLREG deviation, does it look up
+// the nearby segments in the grid to rejoin the route, preferring the
+// earliest one at or after the current segment so that closed loops are not
+// cut short.
+class RouteGeometry {
+ public:
+  RouteGeometry(double turn_radius, double cell_size_deg);
+
+  // waypoints must not be empty
+  void build(const Autopilot::WaypointSeq& waypoints);
+
+  // continue tracking from the leg ending at this waypoint
+  void seek(CORBA::ULong waypoint);
+
+  // lookahead in meters along the track
+  RouteProgress track(double lat, double lon, double lookahead);
+
+  bool has_legs() const { return !this->segments_.empty(); }
+  // meters along the track from the first to the last waypoint
+  double length() const { return this->length_; }
+  std::size_t segments() const { return this->segments_.size(); }
+  // number of grid lookups so far
+  uint64_t rejoins() const { return this->rejoins_; }
+
+ private:
+  struct Segment {
+    // tangent plane anchored at the start of the segment
+    LocalFrame plane;
+    // unit direction, east and north
+    double dir_east;
+    double dir_north;
+    double length;
+    // meters along the route at the start of the segment and at the end of
+    // its leg
+    double start;
+    double leg_end;
+    // switch to the next segment this many meters before the end
+    double wheel_over;
+    CORBA::ULong waypoint;
+  };
+
+  typedef int64_t CellKey;
+
+  // position relative to the start of segment i, along and right of it
+  void project(std::size_t i, double lat, double lon, double& along,
+               double& cross) const;
+  // distance to the closest point of segment i
+  double distance_to(std::size_t i, double lat, double lon) const;
+  Autopilot::Coordinates point_at(std::size_t i, double along) const;
+  CellKey cell_of(int64_t row, int64_t col) const;
+  void rejoin(double lat, double lon);
+
+  // longer legs are split, keeps the planar projection accurate
+  static constexpr double MAX_SEGMENT = 1000.0;
+  // legs shorter than this are treated as duplicate waypoints
+  static constexpr double MIN_LEG = 0.01;
+  // cross-track error (m) beyond which the route is rejoined
+  static constexpr double REJOIN_DISTANCE = 200.0;
+  // rejoin only considers segments within this distance (m)
+  static constexpr double REJOIN_SEARCH = 1000.0;
+  // segments at most this much further away than the nearest one still
+  // count as nearest when rejoining
+  static constexpr double REJOIN_SLACK = 50.0;
+
+  const double turn_radius_;
+  const double cell_size_;
+  const int64_t rows_;
+  const int64_t cols_;
+
+  std::vector<Segment> segments_;
+  std::unordered_map<CellKey, std::vector<uint32_t>> grid_;
+  double length_;
+  std::size_t current_;
+  uint64_t rejoins_;
+
+  // scratch for rejoin()
+  std::vector<uint32_t> candidates_;
+};
+
+#endif
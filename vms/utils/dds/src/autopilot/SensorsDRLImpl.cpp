@@ -10,7 +10,9 @@
 #include "PhysicalStateTypeSupportC.h"
 #include "PhysicalStateTypeSupportImpl.h"
 
-SensorsDataReaderListenerImpl::SensorsDataReaderListenerImpl() {
+SensorsDataReaderListenerImpl::SensorsDataReaderListenerImpl(
+    CoSimChannel* cosim)
+    : cosim_(cosim), stats_("Sensors") {
   PhysicalState::Sensors initial_readings;
   // don't send the initial readings to the AP controller
   this->new_readings_available_ = false;
@@ -31,14 +33,18 @@ CORBA::Boolean SensorsDataReaderListenerImpl::new_readings_available() {
 
 void SensorsDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void SensorsDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void SensorsDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void SensorsDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -47,7 +53,9 @@ void SensorsDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void SensorsDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void SensorsDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -61,22 +69,21 @@ void SensorsDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  PhysicalState::Sensors readings;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(readings, info);
-
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      ACE_Guard<ACE_Mutex> guard(this->lock_);
-      // assume that every new publication is a fresh set of readings
-      this->new_readings_available_ = true;
-      this->latest_readings_ = readings;
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<PhysicalState::SensorsSeq>(
+      reader_i.in(), this->stats_,
+      [this](const PhysicalState::Sensors &readings, const DDS::SampleInfo &) {
+        ACE_Guard<ACE_Mutex> guard(this->lock_);
+        // assume that every new publication is a fresh set of readings
+        this->new_readings_available_ = true;
+        this->latest_readings_ = readings;
+        if (this->cosim_ != nullptr) {
+          this->cosim_->count_received(COSIM_SENSORS);
+        }
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -8,12 +8,15 @@
 #include <dds/DdsDcpsSubscriptionC.h>
 #include <tao/Basic_Types.h>
 
+#include "../cosim/CoSimChannel.h"
+#include "../ReaderSupport.h"
 #include "PhysicalStateC.h"
 
 class SensorsDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
-  SensorsDataReaderListenerImpl();
+  // counts the readings taken on the co-simulation channel if given
+  explicit SensorsDataReaderListenerImpl(CoSimChannel* cosim = nullptr);
   virtual ~SensorsDataReaderListenerImpl();
 
   PhysicalState::Sensors get_readings();
@@ -51,6 +54,8 @@ class SensorsDataReaderListenerImpl
   PhysicalState::Sensors latest_readings_;
   CORBA::Boolean new_readings_available_;
   ACE_Mutex lock_;
+  CoSimChannel* cosim_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -0,0 +1,180 @@
+#include "TimerWheel.h"
+
+#include <ace/Basic_Types.h>
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(ACE_hrtime_t resolution, ACE_hrtime_t start)
+    : resolution_(resolution),
+      current_(start / resolution),
+      next_deadline_(ACE_UINT64_MAX),
+      size_(0),
+      free_(NONE),
+      occupied_{} {
+  this->heads_.fill(NONE);
+}
+
+uint32_t TimerWheel::list_for(uint64_t tick) const {
+  // the lowest level on which the timer shares all higher digits with the
+  // current tick
+  for (int level = 0; level < LEVELS; ++level) {
+    int shift = SLOT_BITS * (level + 1);
+    if ((tick >> shift) == (this->current_ >> shift)) {
+      return level * SLOTS +
+             ((tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+    }
+  }
+  return OVERFLOW_LIST;
+}
+
+void TimerWheel::link(uint32_t index) {
+  Node& node = this->nodes_[index];
+  node.list = this->list_for(node.tick);
+  node.prev = NONE;
+  node.next = this->heads_[node.list];
+  if (node.next != NONE) this->nodes_[node.next].prev = index;
+  this->heads_[node.list] = index;
+  if (node.list != OVERFLOW_LIST) {
+    this->occupied_[node.list / SLOTS] |= uint64_t(1) << (node.list % SLOTS);
+  }
+}
+
+void TimerWheel::unlink(uint32_t index) {
+  Node& node = this->nodes_[index];
+  if (node.prev != NONE) {
+    this->nodes_[node.prev].next = node.next;
+  } else {
+    this->heads_[node.list] = node.next;
+  }
+  if (node.next != NONE) this->nodes_[node.next].prev = node.prev;
+  if (this->heads_[node.list] == NONE && node.list != OVERFLOW_LIST) {
+    this->occupied_[node.list / SLOTS] &=
+        ~(uint64_t(1) << (node.list % SLOTS));
+  }
+}
+
+void TimerWheel::release(uint32_t index) {
+  Node& node = this->nodes_[index];
+  node.list = NONE;
+  ++node.generation;
+  node.next = this->free_;
+  this->free_ = index;
+  --this->size_;
+}
+
+TimerWheel::Handle TimerWheel::schedule(ACE_hrtime_t deadline,
+                                        uint32_t payload) {
+  uint32_t index = this->free_;
+  if (index != NONE) {
+    this->free_ = this->nodes_[index].next;
+  } else {
+    index = static_cast<uint32_t>(this->nodes_.size());
+    this->nodes_.push_back(Node{0, 0, 0, NONE, NONE, NONE});
+  }
+
+  // round up, a timer must never fire early
+  uint64_t tick = (deadline + this->resolution_ - 1) / this->resolution_;
+  tick = std::max(tick, this->current_);
+  Node& node = this->nodes_[index];
+  node.tick = tick;
+  node.payload = payload;
+  this->link(index);
+  ++this->size_;
+  this->next_deadline_ =
+      std::min(this->next_deadline_, tick * this->resolution_);
+
+  return (static_cast<Handle>(node.generation) << 32) | (index + 1);
+}
+
+bool TimerWheel::cancel(Handle handle) {
+  uint32_t index = static_cast<uint32_t>(handle & 0xffffffff) - 1;
+  if (handle == INVALID_HANDLE || index >= this->nodes_.size()) return false;
+  Node& node = this->nodes_[index];
+  if (node.list == NONE || node.generation != (handle >> 32)) return false;
+  this->unlink(index);
+  this->release(index);
+  // next_deadline_ may now be early, which only costs a spurious advance()
+  return true;
+}
+
+void TimerWheel::cascade(uint32_t list) {
+  uint32_t index = this->heads_[list];
+  this->heads_[list] = NONE;
+  if (list != OVERFLOW_LIST) {
+    this->occupied_[list / SLOTS] &= ~(uint64_t(1) << (list % SLOTS));
+  }
+  while (index != NONE) {
+    uint32_t next = this->nodes_[index].next;
+    this->link(index);
+    index = next;
+  }
+}
+
+void TimerWheel::fire_slot(uint32_t list, std::vector<uint32_t>& fired) {
+  uint32_t index = this->heads_[list];
+  if (index == NONE) return;
+  this->heads_[list] = NONE;
+  this->occupied_[0] &= ~(uint64_t(1) << list);
+  while (index != NONE) {
+    uint32_t next = this->nodes_[index].next;
+    fired.push_back(this->nodes_[index].payload);
+    this->release(index);
+    index = next;
+  }
+}
+
+void TimerWheel::update_next_deadline() {
+  this->next_deadline_ = ACE_UINT64_MAX;
+  if (this->size_ == 0) return;
+
+  // the next occupied slot on the lowest level that has one is the next
+  // tick that fires or cascades
+  for (int level = 0; level < LEVELS; ++level) {
+    int shift = SLOT_BITS * level;
+    uint32_t digit = (this->current_ >> shift) & (SLOTS - 1);
+    uint64_t mask = this->occupied_[level];
+    // the current slot of level 0 is due now, on the higher levels it has
+    // already been cascaded
+    mask &= level == 0 ? ~uint64_t(0) << digit
+                       : (digit == SLOTS - 1 ? 0 : ~uint64_t(0) << (digit + 1));
+    if (mask != 0) {
+      uint64_t block = (this->current_ >> (shift + SLOT_BITS))
+                       << (shift + SLOT_BITS);
+      uint64_t tick = block + (uint64_t(__builtin_ctzll(mask)) << shift);
+      this->next_deadline_ = tick * this->resolution_;
+      return;
+    }
+  }
+  // only the overflow list is left, look again once the top level wraps
+  int top = SLOT_BITS * LEVELS;
+  this->next_deadline_ =
+      (((this->current_ >> top) + 1) << top) * this->resolution_;
+}
+
+void TimerWheel::advance(ACE_hrtime_t now, std::vector<uint32_t>& fired) {
+  if (now < this->next_deadline_) return;
+
+  uint64_t target = now / this->resolution_;
+  while (true) {
+    this->fire_slot(this->current_ & (SLOTS - 1), fired);
+    this->update_next_deadline();
+    uint64_t next = this->next_deadline_ == ACE_UINT64_MAX
+                        ? UINT64_MAX
+                        : this->next_deadline_ / this->resolution_;
+    if (next > target) break;
+
+    // move to the next tick with work and bring down the timers of every
+    // level that wraps there
+    this->current_ = next;
+    if ((next & ((uint64_t(1) << (SLOT_BITS * LEVELS)) - 1)) == 0) {
+      this->cascade(OVERFLOW_LIST);
+    }
+    for (int level = LEVELS - 1; level > 0; --level) {
+      int shift = SLOT_BITS * level;
+      if ((next & ((uint64_t(1) << shift) - 1)) == 0) {
+        this->cascade(level * SLOTS + ((next >> shift) & (SLOTS - 1)));
+      }
+    }
+  }
+  this->current_ = std::max(this->current_, target);
+}
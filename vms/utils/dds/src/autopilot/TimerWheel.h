@@ -0,0 +1,82 @@
+#ifndef AUTOPILOT_TIMER_WHEEL_H
+#define AUTOPILOT_TIMER_WHEEL_H
+
+#include <ace/OS_NS_time.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Hierarchical timer wheel. Deadlines are kept in ticks of the given
+// resolution on LEVELS wheels of SLOTS slots each, every level covering
+// SLOTS times the span of the one below. Timers further out than the top
+// level wait in an overflow list. Scheduling and cancelling are O(1).
+//
+// advance() skips over empty slots with the per-level occupancy masks and
+// returns at once while nothing is due, so an idle wheel costs a compare
+// per call however far apart the deadlines are. Timers never fire before
+// their deadline and at most one tick after the time passed to advance().
+//
+// Nodes live in a pool that only grows, nothing is allocated once the wheel
+// has held its largest number of timers.
+class TimerWheel {
+ public:
+  typedef uint64_t Handle;
+  static constexpr Handle INVALID_HANDLE = 0;
+
+  // resolution in nanoseconds, start is the current time
+  TimerWheel(ACE_hrtime_t resolution, ACE_hrtime_t start);
+
+  // returns a handle to cancel the timer with, payload is passed back
+  // when it fires
+  Handle schedule(ACE_hrtime_t deadline, uint32_t payload);
+  // returns false if the timer already fired or was cancelled
+  bool cancel(Handle handle);
+
+  // fires all timers due at now, appending their payloads to fired in
+  // deadline order
+  void advance(ACE_hrtime_t now, std::vector<uint32_t>& fired);
+
+  // earliest time advance() can fire something, ACE_UINT64_MAX if idle
+  ACE_hrtime_t next_deadline() const { return this->next_deadline_; }
+  std::size_t size() const { return this->size_; }
+
+ private:
+  static constexpr int SLOT_BITS = 6;
+  static constexpr uint32_t SLOTS = 1 << SLOT_BITS;
+  static constexpr int LEVELS = 4;
+  static constexpr uint32_t NONE = UINT32_MAX;
+  // the overflow list is kept after the wheel slots
+  static constexpr uint32_t OVERFLOW_LIST = LEVELS * SLOTS;
+
+  struct Node {
+    uint64_t tick;
+    uint32_t payload;
+    uint32_t generation;
+    uint32_t prev;
+    uint32_t next;
+    uint32_t list;
+  };
+
+  uint32_t list_for(uint64_t tick) const;
+  void link(uint32_t node);
+  void unlink(uint32_t node);
+  void release(uint32_t node);
+  // moves the timers of a slot or the overflow list down the levels
+  void cascade(uint32_t list);
+  void fire_slot(uint32_t list, std::vector<uint32_t>& fired);
+  void update_next_deadline();
+
+  const ACE_hrtime_t resolution_;
+  uint64_t current_;
+  ACE_hrtime_t next_deadline_;
+  std::size_t size_;
+
+  std::vector<Node> nodes_;
+  uint32_t free_;
+  // list heads of all slots and of the overflow list
+  std::array<uint32_t, LEVELS * SLOTS + 1> heads_;
+  std::array<uint64_t, LEVELS> occupied_;
+};
+
+#endif
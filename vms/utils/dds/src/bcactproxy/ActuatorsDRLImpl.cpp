@@ -16,27 +16,45 @@
 
 
 ActuatorsDataReaderListenerImpl::ActuatorsDataReaderListenerImpl(
-    std::string bc_snd_addr, std::string bc_snd_port) {
+    std::string bc_snd_addr, std::string bc_snd_port, bool use_shm)
+    : stats_("Actuators") {
   // set up asio send socket
   boost::asio::ip::udp::resolver resolver(send_service);
   boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(),
                                               bc_snd_addr, bc_snd_port);
   bc_rcv_endpoint = *resolver.resolve(query);
   send_socket = new boost::asio::ip::udp::socket(send_service);
+
+  this->use_shm = false;
+  if (use_shm) {
+    if (shm_channel.open(SHM_ACTUATORS_CHANNEL,
+                         ShmChannel<ActuatorCommands>::PRODUCER)) {
+      ACE_ERROR((LM_ERROR,
+                 ACE_TEXT("ERROR: %N:%l: could not open shared memory channel "
+                          "%s, falling back to UDP\n"),
+                 SHM_ACTUATORS_CHANNEL));
+    } else {
+      this->use_shm = true;
+    }
+  }
 }
 
 ActuatorsDataReaderListenerImpl::~ActuatorsDataReaderListenerImpl() {}
 
 void ActuatorsDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void ActuatorsDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -45,7 +63,9 @@ void ActuatorsDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void ActuatorsDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -59,37 +79,39 @@ void ActuatorsDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  PhysicalState::Actuators actuators;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(actuators, info);
-
   ACE_Guard<ACE_Mutex> guard(this->lock_);
   // proxy for BC, forward message to BC
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      // build struct
-      
-          ActuatorCommands commands;
-          commands.rudder_angle = actuators.rudder_angle;
-          commands.engine_throttle_port = actuators.engine_throttle_port;
-          commands.engine_throttle_stbd = actuators.engine_throttle_stbd;
-          commands.ballast_tank_pump = actuators.ballast_tank_pump;
-          commands.thruster_throttle_bow = actuators.thruster_throttle_bow;
-          commands.thruster_throttle_stern = actuators.thruster_throttle_stern;
-          // serialize
-          std::ostringstream archive_stream;
-          boost::archive::text_oarchive archive(archive_stream);
-          archive << commands;
-          // send
-          if (!send_socket->is_open())
-            send_socket->open(boost::asio::ip::udp::v4());
-
-          send_socket->send_to(boost::asio::buffer(archive_stream.str()),
-                                bc_rcv_endpoint);
-    }
-  } else {
-    ACE_ERROR((LM_ERROR, ACE_TEXT("ERROR: %N:%l: on_data_available() - "
-                                  "take_next_sample failed!\n")));
+  const bool error = take_all<PhysicalState::ActuatorsSeq>(
+      reader_i.in(), this->stats_,
+      [this](const PhysicalState::Actuators &actuators,
+             const DDS::SampleInfo &) {
+        // build struct
+        ActuatorCommands commands;
+        commands.rudder_angle = actuators.rudder_angle;
+        commands.engine_throttle_port = actuators.engine_throttle_port;
+        commands.engine_throttle_stbd = actuators.engine_throttle_stbd;
+        commands.ballast_tank_pump = actuators.ballast_tank_pump;
+        commands.thruster_throttle_bow = actuators.thruster_throttle_bow;
+        commands.thruster_throttle_stern = actuators.thruster_throttle_stern;
+        if (use_shm) {
+          shm_channel.send(commands);
+          return;
+        }
+        // serialize
+        std::ostringstream archive_stream;
+        boost::archive::text_oarchive archive(archive_stream);
+        archive << commands;
+        // send
+        if (!send_socket->is_open())
+          send_socket->open(boost::asio::ip::udp::v4());
+
+        send_socket->send_to(boost::asio::buffer(archive_stream.str()),
+                             bc_rcv_endpoint);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -12,11 +12,15 @@
 #include <boost/asio/ip/udp.hpp>
 #include <string>
 
+#include "../BcProxyMessages.h"
+#include "../ReaderSupport.h"
+#include "../shm/ShmChannel.h"
+
 class ActuatorsDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
   ActuatorsDataReaderListenerImpl(std::string bc_snd_addr,
-                                  std::string bc_snd_port);
+                                  std::string bc_snd_port, bool use_shm);
   virtual ~ActuatorsDataReaderListenerImpl(void);
   // clang-format off
   virtual void on_requested_deadline_missed(
@@ -51,6 +55,10 @@ class ActuatorsDataReaderListenerImpl
   boost::asio::ip::udp::socket* send_socket;
   boost::asio::io_service send_service;
   boost::asio::ip::udp::endpoint bc_rcv_endpoint;
+  // shared memory transport for a co-located BC, UDP otherwise
+  bool use_shm;
+  ShmChannel<ActuatorCommands> shm_channel;
+  ReaderStats stats_;
 };
 
 #endif
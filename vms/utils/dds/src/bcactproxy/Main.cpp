@@ -25,10 +25,19 @@ int missing_arg(std::string arg) {
                    1);
 }
 
+int invalid_arg(std::string arg, std::string value) {
+  ACE_ERROR_RETURN((LM_ERROR,
+                    ACE_TEXT("ERROR: %N:%l: main() - invalid "
+                             "value %s for argument %s!\n"),
+                    value.c_str(), arg.c_str()),
+                   1);
+}
+
 int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
   // parse args to find the address/port we should use for the ASIO setup
   std::string bc_snd_addr = "localhost";
   std::string bc_snd_port = "10113";
+  bool use_shm = false;
   for (int i = 0; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "-bc-snd-addr") {
@@ -37,10 +46,22 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     } else if (arg == "-bc-snd-port") {
       if (i == argc - 1) return missing_arg(arg);
       bc_snd_port = argv[i + 1];
+    } else if (arg == "-transport") {
+      if (i == argc - 1) return missing_arg(arg);
+      std::string transport = argv[i + 1];
+      if (transport != "udp" && transport != "shm") {
+        return invalid_arg(arg, transport);
+      }
+      use_shm = transport == "shm";
     }
   }
-  ACE_DEBUG((LM_DEBUG, ACE_TEXT("Parsed args: send to BC on %s:%s\n"),
-             bc_snd_addr.c_str(), bc_snd_port.c_str()));
+  if (use_shm) {
+    ACE_DEBUG((LM_DEBUG,
+               ACE_TEXT("Parsed args: send to BC through shared memory\n")));
+  } else {
+    ACE_DEBUG((LM_DEBUG, ACE_TEXT("Parsed args: send to BC on %s:%s\n"),
+               bc_snd_addr.c_str(), bc_snd_port.c_str()));
+  }
   try {
     // Create the participant
     DDS::DomainParticipantFactory_var dpf =
@@ -91,11 +112,12 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     // Create the DataReader for the Actuators topic
     // Create the listener
     DDS::DataReaderListener_var actuators_listener(
-        new ActuatorsDataReaderListenerImpl(bc_snd_addr, bc_snd_port));
+        new ActuatorsDataReaderListenerImpl(bc_snd_addr, bc_snd_port,
+                                            use_shm));
 
     DDS::DataReaderQos reader_qos;
     subscriber->get_default_datareader_qos(reader_qos);
-    reader_qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
+    apply_profile(reader_qos, QOS_STATE);
 
     // Create the reader
     DDS::DataReader_var actuators_dr = subscriber->create_datareader(
@@ -9,11 +9,65 @@
 #include <iostream>
 #include <sstream>
 
+#include "../AsyncLog.h"
 #include "../BcProxyMessages.h"
+#include "../shm/ShmChannel.h"
 
+// convert a BC AIS message and publish it on the DDS topic
+static void forward_message(
+    const AivdmMessage& msg,
+    PhysicalState::AivdmMessageDataWriter_var& aivdm_dw) {
+  XLOG(LC_AIS, LL_DEBUG, "Received AIS for mmsi %i\n", msg.mmsi);
+
+  // build DDS AIS wrapper
+  PhysicalState::AivdmMessage proxied_message;
+  proxied_message.message = msg.message.c_str();
+  proxied_message.message_type = msg.message_type;
+  proxied_message.mmsi = msg.mmsi;
+  if (msg.navigation_status <= 15) {
+    proxied_message.navigation_status =
+        PhysicalState::NavigationStatus(msg.navigation_status);
+  } else {
+    proxied_message.navigation_status =
+        PhysicalState::NavigationStatus::NOT_DEFINED;
+  }
+  proxied_message.latitude = msg.latitude;
+  proxied_message.longitude = msg.longitude;
+  proxied_message.rate_of_turn = msg.rate_of_turn;
+  proxied_message.speed_over_ground = msg.speed_over_ground;
+  proxied_message.course_over_ground = msg.course_over_ground;
+  proxied_message.true_heading = msg.true_heading;
+
+  aivdm_dw->write(proxied_message, DDS::HANDLE_NIL);
+}
+
+// receive AIS messages from BC through shared memory
+static void shm_loop(ShmChannel<AivdmRecord>& channel,
+                     AisWorkerArgs* arguments) {
+  AivdmRecord record;
+  while (true) {
+    if (channel.receive(record, 1000)) {
+      forward_message(from_record(record), arguments->aivdm_dw);
+    }
+  }
+}
 
 void* ais_worker(void* args) {
   AisWorkerArgs* arguments = reinterpret_cast<AisWorkerArgs*>(args);
+  if (arguments->use_shm) {
+    // fall back to UDP like bc-act-proxy, BC does the same on its side
+    ShmChannel<AivdmRecord> channel;
+    if (channel.open(SHM_AIVDM_CHANNEL, ShmChannel<AivdmRecord>::CONSUMER)) {
+      ACE_ERROR((LM_ERROR,
+                 ACE_TEXT("ERROR: %N:%l: ais_worker() - could not open shared "
+                          "memory channel %s, falling back to UDP\n"),
+                 SHM_AIVDM_CHANNEL));
+    } else {
+      shm_loop(channel, arguments);
+      return nullptr;
+    }
+  }
+
   boost::asio::io_context io_context;
   boost::asio::ip::udp::socket receive_socket(io_context);
   receive_socket.open(boost::asio::ip::udp::v4());
@@ -35,30 +89,7 @@ void* ais_worker(void* args) {
       boost::archive::text_iarchive archive(archive_stream);
       archive >> aivdm_msg;
 
-      ACE_DEBUG(
-          (LM_DEBUG, ACE_TEXT("Received AIS for mmsi %i\n"), aivdm_msg.mmsi));
-
-      // build DDS AIS wrapper
-      PhysicalState::AivdmMessage proxied_message;
-      proxied_message.message = aivdm_msg.message.c_str();
-      proxied_message.message_type = aivdm_msg.message_type;
-      proxied_message.mmsi = aivdm_msg.mmsi;
-      if (aivdm_msg.navigation_status <= 15) {
-        proxied_message.navigation_status =
-            PhysicalState::NavigationStatus(aivdm_msg.navigation_status);
-      } else {
-        proxied_message.navigation_status =
-            PhysicalState::NavigationStatus::NOT_DEFINED;
-      }
-      proxied_message.latitude = aivdm_msg.latitude;
-      proxied_message.longitude = aivdm_msg.longitude;
-      proxied_message.rate_of_turn = aivdm_msg.rate_of_turn;
-      proxied_message.speed_over_ground = aivdm_msg.speed_over_ground;
-      proxied_message.course_over_ground = aivdm_msg.course_over_ground;
-      proxied_message.true_heading = aivdm_msg.true_heading;
-
-      DDS::ReturnCode_t s_error =
-        arguments->aivdm_dw->write(proxied_message, DDS::HANDLE_NIL);
+      forward_message(aivdm_msg, arguments->aivdm_dw);
     } catch (boost::archive::archive_exception& e) {
       ACE_ERROR((
           LM_ERROR,
@@ -11,6 +11,7 @@
 struct AisWorkerArgs {
   PhysicalState::AivdmMessageDataWriter_var aivdm_dw;
   int rcv_port;
+  bool use_shm;
 };
 void* ais_worker(void*);
 
@@ -16,6 +16,7 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/udp.hpp>
 
+#include "../ReaderSupport.h"
 #include "AisWorker.h"
 #include "PhysicalStateTypeSupportImpl.h"
 #include "SenWorker.h"
@@ -28,10 +29,19 @@ int missing_arg(std::string arg) {
                    1);
 }
 
+int invalid_arg(std::string arg, std::string value) {
+  ACE_ERROR_RETURN((LM_ERROR,
+                    ACE_TEXT("ERROR: %N:%l: main() - invalid "
+                             "value %s for argument %s!\n"),
+                    value.c_str(), arg.c_str()),
+                   1);
+}
+
 int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
   // parse args to find the address/port we should use for the ASIO setup
   std::string sensor_port = "10112";
   std::string ais_port = "10114";
+  bool use_shm = false;
 
   for (int i = 0; i < argc; ++i) {
     std::string arg = argv[i];
@@ -41,12 +51,24 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     } else if (arg == "-sensor-port") {
       if (i == argc - 1) return missing_arg(arg);
       sensor_port = argv[i + 1];
+    } else if (arg == "-transport") {
+      if (i == argc - 1) return missing_arg(arg);
+      std::string transport = argv[i + 1];
+      if (transport != "udp" && transport != "shm") {
+        return invalid_arg(arg, transport);
+      }
+      use_shm = transport == "shm";
     }
   }
-  ACE_DEBUG((LM_DEBUG,
-             ACE_TEXT("Parsed args: listen to BC sensors on 0.0.0.0:%s, AIS "
-                      "reports on 0.0.0.0:%s\n"),
-             sensor_port.c_str(), ais_port.c_str()));
+  if (use_shm) {
+    ACE_DEBUG((LM_DEBUG, ACE_TEXT("Parsed args: receive BC sensors and AIS "
+                                  "reports through shared memory\n")));
+  } else {
+    ACE_DEBUG((LM_DEBUG,
+               ACE_TEXT("Parsed args: listen to BC sensors on 0.0.0.0:%s, AIS "
+                        "reports on 0.0.0.0:%s\n"),
+               sensor_port.c_str(), ais_port.c_str()));
+  }
   try {
     // Create the participant
     DDS::DomainParticipantFactory_var dpf =
@@ -105,12 +127,19 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
     }
 
     // Create the DataWriter for the Sensors and AIS topic
+    DDS::DataWriterQos sensors_qos;
+    publisher->get_default_datawriter_qos(sensors_qos);
+    apply_profile(sensors_qos, QOS_STATE, SENSORS_DEADLINE_SEC);
+    DDS::DataWriterQos aivdm_qos;
+    publisher->get_default_datawriter_qos(aivdm_qos);
+    apply_profile(aivdm_qos, QOS_EVENTS);
+
     DDS::DataWriter_var sensors_base_dw =
-        publisher->create_datawriter(sensors_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(sensors_topic, sensors_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataWriter_var aivdm_base_dw =
-        publisher->create_datawriter(aivdm_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(aivdm_topic, aivdm_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     if (!sensors_base_dw || !aivdm_base_dw) {
@@ -135,10 +164,10 @@ int ACE_TMAIN(int argc, ACE_TCHAR *argv[]) {
 
     // set up workers for sen and ais forwarding
     SenWorkerArgs sen_worker_args =
-        SenWorkerArgs({sensors_dw, std::stoi(sensor_port)});
+        SenWorkerArgs({sensors_dw, std::stoi(sensor_port), use_shm});
 
     AisWorkerArgs ais_worker_args =
-        AisWorkerArgs({aivdm_dw, std::stoi(ais_port)});
+        AisWorkerArgs({aivdm_dw, std::stoi(ais_port), use_shm});
     // spawn threads
     ACE_Thread::spawn((ACE_THR_FUNC)sen_worker, &sen_worker_args);
     ACE_Thread::spawn((ACE_THR_FUNC)ais_worker, &ais_worker_args);
@@ -7,10 +7,92 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/udp.hpp>
 
+#include "../AsyncLog.h"
 #include "../BcProxyMessages.h"
+#include "../shm/ShmChannel.h"
+
+// convert a BC sensor report and publish it on the DDS topic
+static void forward_report(const SensorReport& report,
+                           PhysicalState::SensorsDataWriter_var& sensors_dw) {
+  // build DDS sensor report
+  PhysicalState::Sensors proxied_report;
+  proxied_report.bc_id = 123;
+  proxied_report.course_over_ground = report.course_over_ground;
+
+  proxied_report.gnss_1 = PhysicalState::Coordinates(
+      {report.gnss_1[0], report.gnss_1[1]});
+  proxied_report.gnss_2 = PhysicalState::Coordinates(
+      {report.gnss_2[0], report.gnss_2[1]});
+  proxied_report.gnss_3 = PhysicalState::Coordinates(
+      {report.gnss_3[0], report.gnss_3[1]});
+
+  proxied_report.heading = report.heading;
+  proxied_report.rate_of_turn = report.rate_of_turn;
+  proxied_report.rpm_port = report.rpm_port;
+  proxied_report.rpm_stbd = report.rpm_stbd;
+  proxied_report.rudder_angle = report.rudder_angle;
+  proxied_report.speed = report.speed;
+  proxied_report.speed_over_ground = report.speed_over_ground;
+  proxied_report.ship_depth = report.ship_depth;
+  proxied_report.depth_under_keel = report.depth_under_keel;
+  proxied_report.throttle_port = report.throttle_port;
+  proxied_report.throttle_stbd = report.throttle_stbd;
+  proxied_report.buoyancy = report.buoyancy;
+
+  XLOG(LC_SENSORS, LL_DEBUG, "Writing proxied sensor report\n"
+                             "    cog:           %f\n"
+                             "    gnss_1:        %f, %f\n"
+                             "    gnss_2:        %f, %f\n"
+                             "    gnss_3:        %f, %f\n"
+                             "    heading:       %f\n"
+                             "    rot:           %f\n"
+                             "    rpm_port:      %f\n"
+                             "    rpm_stbd:      %f\n"
+                             "    rudder:        %f\n"
+                             "    speed:         %f\n"
+                             "    sog:           %f\n"
+                             "    throttle_port: %f\n"
+                             "    throttle_stbd: %f\n",
+       proxied_report.course_over_ground, proxied_report.gnss_1.latitude,
+       proxied_report.gnss_1.longitude, proxied_report.gnss_2.latitude,
+       proxied_report.gnss_2.longitude, proxied_report.gnss_3.latitude,
+       proxied_report.gnss_3.longitude, proxied_report.heading,
+       proxied_report.rate_of_turn, proxied_report.rpm_port,
+       proxied_report.rpm_stbd, proxied_report.rudder_angle,
+       proxied_report.speed, proxied_report.speed_over_ground,
+       proxied_report.throttle_port, proxied_report.throttle_stbd);
+
+  sensors_dw->write(proxied_report, DDS::HANDLE_NIL);
+}
+
+// receive sensor reports from BC through shared memory
+static void shm_loop(ShmChannel<SensorReport>& channel,
+                     SenWorkerArgs* arguments) {
+  SensorReport report;
+  while (true) {
+    if (channel.receive(report, 1000)) {
+      forward_report(report, arguments->sensors_dw);
+    }
+  }
+}
 
 void* sen_worker(void* args) {
   SenWorkerArgs* arguments = reinterpret_cast<SenWorkerArgs*>(args);
+  if (arguments->use_shm) {
+    // fall back to UDP like bc-act-proxy, BC does the same on its side
+    ShmChannel<SensorReport> channel;
+    if (channel.open(SHM_SENSORS_CHANNEL,
+                     ShmChannel<SensorReport>::CONSUMER)) {
+      ACE_ERROR((LM_ERROR,
+                 ACE_TEXT("ERROR: %N:%l: sen_worker() - could not open shared "
+                          "memory channel %s, falling back to UDP\n"),
+                 SHM_SENSORS_CHANNEL));
+    } else {
+      shm_loop(channel, arguments);
+      return nullptr;
+    }
+  }
+
   boost::asio::io_context io_context;
   boost::asio::ip::udp::socket receive_socket(io_context);
   receive_socket.open(boost::asio::ip::udp::v4());
@@ -32,58 +114,7 @@ void* sen_worker(void* args) {
       boost::archive::text_iarchive archive(archive_stream);
       archive >> bc_sensor_report;
 
-      // build DDS sensor report
-      PhysicalState::Sensors proxied_report;
-      proxied_report.bc_id = 123;
-      proxied_report.course_over_ground = bc_sensor_report.course_over_ground;
-
-      proxied_report.gnss_1 = PhysicalState::Coordinates(
-          {bc_sensor_report.gnss_1[0], bc_sensor_report.gnss_1[1]});
-      proxied_report.gnss_2 = PhysicalState::Coordinates(
-          {bc_sensor_report.gnss_2[0], bc_sensor_report.gnss_2[1]});
-      proxied_report.gnss_3 = PhysicalState::Coordinates(
-          {bc_sensor_report.gnss_3[0], bc_sensor_report.gnss_3[1]});
-
-      proxied_report.heading = bc_sensor_report.heading;
-      proxied_report.rate_of_turn = bc_sensor_report.rate_of_turn;
-      proxied_report.rpm_port = bc_sensor_report.rpm_port;
-      proxied_report.rpm_stbd = bc_sensor_report.rpm_stbd;
-      proxied_report.rudder_angle = bc_sensor_report.rudder_angle;
-      proxied_report.speed = bc_sensor_report.speed;
-      proxied_report.speed_over_ground = bc_sensor_report.speed_over_ground;
-      proxied_report.ship_depth = bc_sensor_report.ship_depth;
-      proxied_report.depth_under_keel = bc_sensor_report.depth_under_keel;
-      proxied_report.throttle_port = bc_sensor_report.throttle_port;
-      proxied_report.throttle_stbd = bc_sensor_report.throttle_stbd;
-      proxied_report.buoyancy = bc_sensor_report.buoyancy;
-
-      ACE_DEBUG(
-          (LM_DEBUG,
-           ACE_TEXT("Writing proxied sensor report\n"
-                    "    cog:           %f\n"
-                    "    gnss_1:        %f, %f\n"
-                    "    gnss_2:        %f, %f\n"
-                    "    gnss_3:        %f, %f\n"
-                    "    heading:       %f\n"
-                    "    rot:           %f\n"
-                    "    rpm_port:      %f\n"
-                    "    rpm_stbd:      %f\n"
-                    "    rudder:        %f\n"
-                    "    speed:         %f\n"
-                    "    sog:           %f\n"
-                    "    throttle_port: %f\n"
-                    "    throttle_stbd: %f\n"),
-           proxied_report.course_over_ground, proxied_report.gnss_1.latitude,
-           proxied_report.gnss_1.longitude, proxied_report.gnss_2.latitude,
-           proxied_report.gnss_2.longitude, proxied_report.gnss_3.latitude,
-           proxied_report.gnss_3.longitude, proxied_report.heading,
-           proxied_report.rate_of_turn, proxied_report.rpm_port,
-           proxied_report.rpm_stbd, proxied_report.rudder_angle,
-           proxied_report.speed, proxied_report.speed_over_ground,
-           proxied_report.throttle_port, proxied_report.throttle_stbd));
-      
-      DDS::ReturnCode_t s_error =
-        arguments->sensors_dw->write(proxied_report, DDS::HANDLE_NIL);
+      forward_report(bc_sensor_report, arguments->sensors_dw);
     } catch (boost::archive::archive_exception& e) {
       ACE_ERROR((LM_ERROR,
                  ACE_TEXT("Archive exception while trying to deserialize "
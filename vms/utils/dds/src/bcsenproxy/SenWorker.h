@@ -11,6 +11,7 @@
 struct SenWorkerArgs {
   PhysicalState::SensorsDataWriter_var sensors_dw;
   int rcv_port;
+  bool use_shm;
 };
 void* sen_worker(void*);
 
@@ -12,7 +12,8 @@
 #include "AutopilotTypeSupportImpl.h"
 
 APReportDataReaderListenerImpl::APReportDataReaderListenerImpl(
-    std::string ccc_snd_addr, std::string ccc_snd_port) {
+    std::string ccc_snd_addr, std::string ccc_snd_port, TelemetryHub* hub)
+    : hub_(hub), stats_("APReport") {
   // set up asio send socket
   boost::asio::ip::udp::resolver resolver(send_service_);
   boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(),
@@ -23,14 +24,18 @@ APReportDataReaderListenerImpl::APReportDataReaderListenerImpl(
 
 void APReportDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void APReportDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void APReportDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void APReportDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -39,7 +44,9 @@ void APReportDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void APReportDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void APReportDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -53,50 +60,51 @@ void APReportDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::APReport report;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(report, info);
-
   // proxy for AP, forward message to CCC
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      // update protobuf
-      TelemetryReport telemetry_report{};
-      APReport *report_pb = telemetry_report.mutable_ap_report();
-      report_pb->mutable_active_waypoint()->mutable_coords()->set_latitude(
-          report.active_waypoint.coords.latitude);
-      report_pb->mutable_active_waypoint()->mutable_coords()->set_longitude(
-          report.active_waypoint.coords.longitude);
-
-      // WARNING: we're relying on the 1:1 match between enum values here
-      report_pb->set_state(AutopilotState(report.state));
-
-      report_pb->set_active_route_id(report.active_route_id);
-      report_pb->set_route_progress(report.route_progress);
-      report_pb->set_route_len(report.route_len);
-      report_pb->set_route_name(report.route_name);
-      report_pb->set_tgt_speed(report.tgt_speed);
-      report_pb->set_active_lp_id(report.active_lp_id);
-      report_pb->set_lp_dist(report.lp_dist);
-      report_pb->set_lp_name(report.lp_name);
-      report_pb->set_dp_name(report.dp_name);
-      report_pb->set_tgt_depth(report.tgt_depth);
-      report_pb->mutable_gnss_ap()->set_latitude(report.gnss_ap.latitude);
-      report_pb->mutable_gnss_ap()->set_longitude(report.gnss_ap.longitude);
-
-      // serialize and dump via UDP
-      if (!send_socket_->is_open())
-        send_socket_->open(boost::asio::ip::udp::v4());
-
-      send_socket_->send_to(
-          boost::asio::buffer(telemetry_report.SerializeAsString()),
-          this->ccc_rcv_endpoint_);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+  const bool error = take_all<Autopilot::APReportSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::APReport &report, const DDS::SampleInfo &) {
+        // update protobuf, built in the frame's arena and shared with the
+        // telemetry stream
+        std::shared_ptr<TelemetryFrame> frame = this->hub_->make_frame();
+        TelemetryReport &telemetry_report = *frame->report;
+        APReport *report_pb = telemetry_report.mutable_ap_report();
+        report_pb->mutable_active_waypoint()->mutable_coords()->set_latitude(
+            report.active_waypoint.coords.latitude);
+        report_pb->mutable_active_waypoint()->mutable_coords()->set_longitude(
+            report.active_waypoint.coords.longitude);
+
+        // WARNING: we're relying on the 1:1 match between enum values here
+        report_pb->set_state(AutopilotState(report.state));
+
+        report_pb->set_active_route_id(report.active_route_id);
+        report_pb->set_route_progress(report.route_progress);
+        report_pb->set_route_len(report.route_len);
+        report_pb->set_route_name(report.route_name);
+        report_pb->set_tgt_speed(report.tgt_speed);
+        report_pb->set_active_lp_id(report.active_lp_id);
+        report_pb->set_lp_dist(report.lp_dist);
+        report_pb->set_lp_name(report.lp_name);
+        report_pb->set_dp_name(report.dp_name);
+        report_pb->set_tgt_depth(report.tgt_depth);
+        report_pb->mutable_gnss_ap()->set_latitude(report.gnss_ap.latitude);
+        report_pb->mutable_gnss_ap()->set_longitude(report.gnss_ap.longitude);
+
+        // serialize and dump via UDP
+        if (!send_socket_->is_open())
+          send_socket_->open(boost::asio::ip::udp::v4());
+
+        serialize_frame(*frame, this->send_buffer_);
+        send_socket_->send_to(boost::asio::buffer(this->send_buffer_),
+                              this->ccc_rcv_endpoint_);
+
+        // coalesced per subscriber of the telemetry stream
+        this->hub_->publish(frame);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -15,7 +15,8 @@
 #include "PhysicalStateTypeSupportImpl.h"
 
 ActuatorsDataReaderListenerImpl::ActuatorsDataReaderListenerImpl(
-    std::string ccc_snd_addr, std::string ccc_snd_port) {
+    std::string ccc_snd_addr, std::string ccc_snd_port, TelemetryHub* hub)
+    : hub_(hub), stats_("Actuators") {
   // set up asio send socket
   boost::asio::ip::udp::resolver resolver(send_service_);
   boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(),
@@ -26,14 +27,18 @@ ActuatorsDataReaderListenerImpl::ActuatorsDataReaderListenerImpl(
 
 void ActuatorsDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void ActuatorsDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -42,7 +47,9 @@ void ActuatorsDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void ActuatorsDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void ActuatorsDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -56,35 +63,40 @@ void ActuatorsDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  PhysicalState::Actuators actuators;
-  DDS::SampleInfo info;
-
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(actuators, info);
-
   // proxy for AP, forward message to CCC
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      // update protobuf
-      TelemetryReport telemetry_report{};
-      ActuatorCmdReport* report_pb = telemetry_report.mutable_act_cmd_report();
-      report_pb->set_rudder_angle(actuators.rudder_angle);
-      report_pb->set_engine_throttle_port(actuators.engine_throttle_port);
-      report_pb->set_engine_throttle_stbd(actuators.engine_throttle_stbd);
-      report_pb->set_ballast_tank_pump(actuators.ballast_tank_pump);
-      report_pb->set_thruster_throttle_bow(actuators.thruster_throttle_bow);
-      report_pb->set_thruster_throttle_stern(
-          actuators.thruster_throttle_stern);
-
-      // serialize and dump via UDP
-      if (!send_socket_->is_open())
-        send_socket_->open(boost::asio::ip::udp::v4());
-
-      send_socket_->send_to(
-          boost::asio::buffer(telemetry_report.SerializeAsString()),
-          this->ccc_rcv_endpoint_);
-    }
-  } else {
-    ACE_ERROR((LM_ERROR, ACE_TEXT("ERROR: %N:%l: on_data_available() - "
-                                  "take_next_sample failed!\n")));
+  const bool error = take_all<PhysicalState::ActuatorsSeq>(
+      reader_i.in(), this->stats_,
+      [this](const PhysicalState::Actuators &actuators,
+             const DDS::SampleInfo &) {
+        // update protobuf, built in the frame's arena and shared with the
+        // telemetry stream
+        std::shared_ptr<TelemetryFrame> frame = this->hub_->make_frame();
+        TelemetryReport &telemetry_report = *frame->report;
+        ActuatorCmdReport* report_pb =
+            telemetry_report.mutable_act_cmd_report();
+        report_pb->set_rudder_angle(actuators.rudder_angle);
+        report_pb->set_engine_throttle_port(actuators.engine_throttle_port);
+        report_pb->set_engine_throttle_stbd(actuators.engine_throttle_stbd);
+        report_pb->set_ballast_tank_pump(actuators.ballast_tank_pump);
+        report_pb->set_thruster_throttle_bow(actuators.thruster_throttle_bow);
+        report_pb->set_thruster_throttle_stern(
+            actuators.thruster_throttle_stern);
+
+        // serialize and dump via UDP
+        if (!send_socket_->is_open())
+          send_socket_->open(boost::asio::ip::udp::v4());
+
+        serialize_frame(*frame, this->send_buffer_);
+        send_socket_->send_to(boost::asio::buffer(this->send_buffer_),
+                              this->ccc_rcv_endpoint_);
+
+        // coalesced per subscriber of the telemetry stream
+        this->hub_->publish(frame);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -11,13 +11,15 @@
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/udp.hpp>
 #include <string>
+#include "../ReaderSupport.h"
+#include "./TelemetryHub.h"
 #include "./messages.pb.h"
 
 class ActuatorsDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
   ActuatorsDataReaderListenerImpl(std::string ccc_snd_addr,
-                                  std::string ccc_snd_port);
+                                  std::string ccc_snd_port, TelemetryHub* hub);
   virtual ~ActuatorsDataReaderListenerImpl(void) = default;
   // clang-format off
   virtual void on_requested_deadline_missed(
@@ -51,6 +53,9 @@ class ActuatorsDataReaderListenerImpl
   boost::asio::ip::udp::socket* send_socket_;
   boost::asio::io_service send_service_;
   boost::asio::ip::udp::endpoint ccc_rcv_endpoint_;
+  std::string send_buffer_;  // serialized report, reused for every send
+  TelemetryHub* hub_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -12,6 +12,8 @@
 #include <boost/asio/ip/udp.hpp>
 #include <string>
 
+#include "../ReaderSupport.h"
+#include "./TelemetryHub.h"
 #include "./messages.pb.h"
 #include "PhysicalStateC.h"
 
@@ -19,7 +21,8 @@ class AivdmMessageDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
   AivdmMessageDataReaderListenerImpl(std::string ccc_snd_addr,
-                                     std::string ccc_snd_port);
+                                     std::string ccc_snd_port,
+                                     TelemetryHub* hub);
   ~AivdmMessageDataReaderListenerImpl() = default;
 
   // clang-format off
@@ -54,6 +57,9 @@ class AivdmMessageDataReaderListenerImpl
   boost::asio::ip::udp::socket* send_socket_;
   boost::asio::io_service send_service_;
   boost::asio::ip::udp::endpoint ccc_rcv_endpoint_;
+  std::string send_buffer_;  // serialized report, reused for every send
+  TelemetryHub* hub_;
+  ReaderStats stats_;
 };
 
 #endif
@@ -8,11 +8,15 @@
 #include <boost/asio/ip/udp.hpp>
 #include <string>
 
+#include "../ReaderSupport.h"
+#include "./TelemetryHub.h"
+
 class ColregStatusDataReaderListenerImpl
     : public virtual OpenDDS::DCPS::LocalObject<DDS::DataReaderListener> {
  public:
   ColregStatusDataReaderListenerImpl(std::string ccc_snd_addr,
-                                     std::string ccc_snd_port);
+                                     std::string ccc_snd_port,
+                                     TelemetryHub* hub);
   ~ColregStatusDataReaderListenerImpl() = default;
   // clang-format off
   virtual void on_requested_deadline_missed(
@@ -46,6 +50,9 @@ class ColregStatusDataReaderListenerImpl
   boost::asio::ip::udp::socket* send_socket_;
   boost::asio::io_service send_service_;
   boost::asio::ip::udp::endpoint ccc_rcv_endpoint_;
+  std::string send_buffer_;  // serialized report, reused for every send
+  TelemetryHub* hub_;
+  ReaderStats stats_;
 };
 
 #endif
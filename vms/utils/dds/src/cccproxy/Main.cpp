@@ -13,8 +13,10 @@
 #include <algorithm>
 #include <string>
 
+#include "../ReaderSupport.h"
 #include "./ActuatorsDRLImpl.h"
 #include "./SensorsDRLImpl.h"
+#include "./TelemetryHub.h"
 #include "./XLUUVServiceImpl.h"
 #include "APReportDRLImpl.h"
 #include "AivdmMessageDRLImpl.h"
@@ -215,9 +217,6 @@ int ACE_TMAIN(int argc, ACE_TCHAR* argv[]) {
     // create subscriber for all report topics
     DDS::Subscriber_var subscriber = participant->create_subscriber(
         SUBSCRIBER_QOS_DEFAULT, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
-    DDS::DataReaderQos reader_qos;
-    subscriber->get_default_datareader_qos(reader_qos);
-    reader_qos.reliability.kind = DDS::RELIABLE_RELIABILITY_QOS;
 
     if (!subscriber) {
       ACE_ERROR_RETURN(
@@ -226,53 +225,73 @@ int ACE_TMAIN(int argc, ACE_TCHAR* argv[]) {
           1);
     }
 
+    // state topics only forward their latest sample, reports are bounded
+    DDS::DataReaderQos sensors_qos;
+    subscriber->get_default_datareader_qos(sensors_qos);
+    apply_profile(sensors_qos, QOS_STATE, SENSORS_DEADLINE_SEC);
+    DDS::DataReaderQos actuators_qos;
+    subscriber->get_default_datareader_qos(actuators_qos);
+    apply_profile(actuators_qos, QOS_STATE);
+    DDS::DataReaderQos events_qos;
+    subscriber->get_default_datareader_qos(events_qos);
+    apply_profile(events_qos, QOS_EVENTS);
+
+    // fans telemetry out to StreamTelemetry clients next to the UDP reports
+    TelemetryHub telemetry_hub;
+
     // DataReaders
     DDS::DataReaderListener_var sensors_listener(
         new SensorsDataReaderListenerImpl(ccc_telemetry_host,
-                                          ccc_telemetry_port));
+                                          ccc_telemetry_port,
+                                          &telemetry_hub));
 
     DDS::DataReader_var sensors_dr = subscriber->create_datareader(
-        sensors_topic, reader_qos, sensors_listener,
+        sensors_topic, sensors_qos, sensors_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataReaderListener_var actuators_listener(
         new ActuatorsDataReaderListenerImpl(ccc_telemetry_host,
-                                            ccc_telemetry_port));
+                                            ccc_telemetry_port,
+                                            &telemetry_hub));
 
     DDS::DataReader_var actuators_dr = subscriber->create_datareader(
-        actuators_topic, reader_qos, actuators_listener,
+        actuators_topic, actuators_qos, actuators_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataReaderListener_var aivdm_listener(
         new AivdmMessageDataReaderListenerImpl(ccc_telemetry_host,
-                                               ccc_telemetry_port));
+                                               ccc_telemetry_port,
+                                               &telemetry_hub));
 
     DDS::DataReader_var aivdm_dr =
-        subscriber->create_datareader(aivdm_topic, reader_qos, aivdm_listener,
+        subscriber->create_datareader(aivdm_topic, events_qos, aivdm_listener,
                                       OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataReaderListener_var ap_report_listener(
         new APReportDataReaderListenerImpl(ccc_telemetry_host,
-                                           ccc_telemetry_port));
+                                           ccc_telemetry_port,
+                                           &telemetry_hub));
 
     DDS::DataReader_var ap_report_dr = subscriber->create_datareader(
-        ap_report_topic, reader_qos, ap_report_listener,
+        ap_report_topic, events_qos, ap_report_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataReaderListener_var colreg_status_listener(
         new ColregStatusDataReaderListenerImpl(ccc_telemetry_host,
-                                               ccc_telemetry_port));
+                                               ccc_telemetry_port,
+                                               &telemetry_hub));
 
     DDS::DataReader_var colreg_status_dr = subscriber->create_datareader(
-        colreg_status_topic, reader_qos, colreg_status_listener,
+        colreg_status_topic, events_qos, colreg_status_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     DDS::DataReaderListener_var ms_report_listener(
         new MissionReportDataReaderListenerImpl(ccc_telemetry_host,
-                                                ccc_telemetry_port));
+                                                ccc_telemetry_port,
+                                                &telemetry_hub));
 
     DDS::DataReader_var ms_report_dr = subscriber->create_datareader(
-        ms_report_topic, reader_qos, ms_report_listener,
+        ms_report_topic, events_qos, ms_report_listener,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     if (!actuators_dr || !aivdm_dr || !sensors_dr || !ap_report_dr ||
@@ -294,28 +313,32 @@ int ACE_TMAIN(int argc, ACE_TCHAR* argv[]) {
           1);
     }
 
-    // create the writers
+    // create the writers, commands are delivered reliably and in full
+    DDS::DataWriterQos command_writer_qos;
+    publisher->get_default_datawriter_qos(command_writer_qos);
+    apply_profile(command_writer_qos, QOS_COMMAND);
+
     DDS::DataWriter_var route_base_dw =
-        publisher->create_datawriter(route_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(route_topic, command_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var autopilot_command_base_dw =
         publisher->create_datawriter(autopilot_command_topic,
-                                     DATAWRITER_QOS_DEFAULT, 0,
+                                     command_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var loiter_position_base_dw = publisher->create_datawriter(
-        loiter_position_topic, DATAWRITER_QOS_DEFAULT, 0,
+        loiter_position_topic, command_writer_qos, 0,
         OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var dive_proc_base_dw =
-        publisher->create_datawriter(dive_proc_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(dive_proc_topic, command_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var mission_base_dw =
-        publisher->create_datawriter(mission_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(mission_topic, command_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var mission_cmd_base_dw =
-        publisher->create_datawriter(mission_cmd_topic, DATAWRITER_QOS_DEFAULT,
+        publisher->create_datawriter(mission_cmd_topic, command_writer_qos,
                                      0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
     DDS::DataWriter_var proc_act_base_dw =
-        publisher->create_datawriter(proc_act_topic, DATAWRITER_QOS_DEFAULT, 0,
+        publisher->create_datawriter(proc_act_topic, command_writer_qos, 0,
                                      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
 
     if (!route_base_dw || !autopilot_command_base_dw ||
@@ -355,7 +378,7 @@ int ACE_TMAIN(int argc, ACE_TCHAR* argv[]) {
     // start the gRPC service
     XLUUVServiceImpl service{
         route_dw,   autopilot_command_dw, loiter_position_dw, dive_proc_dw,
-        mission_dw, mission_cmd_dw,       proc_act_dw};
+        mission_dw, mission_cmd_dw,       proc_act_dw,        telemetry_hub};
     grpc::EnableDefaultHealthCheckService(true);
     // we're currently building without reflection and probably don't need it
     // grpc::reflection::InitProtoReflectionServerBuilderPlugin();
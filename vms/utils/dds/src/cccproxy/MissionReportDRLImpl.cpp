@@ -12,7 +12,8 @@
 #include "AutopilotTypeSupportImpl.h"
 
 MissionReportDataReaderListenerImpl::MissionReportDataReaderListenerImpl(
-    std::string ccc_snd_addr, std::string ccc_snd_port) {
+    std::string ccc_snd_addr, std::string ccc_snd_port, TelemetryHub* hub)
+    : hub_(hub), stats_("MissionReport") {
   // set up asio send socket
   boost::asio::ip::udp::resolver resolver(send_service_);
   boost::asio::ip::udp::resolver::query query(boost::asio::ip::udp::v4(),
@@ -23,14 +24,18 @@ MissionReportDataReaderListenerImpl::MissionReportDataReaderListenerImpl(
 
 void MissionReportDataReaderListenerImpl::on_requested_deadline_missed(
     DDS::DataReader_ptr reader,
-    const DDS::RequestedDeadlineMissedStatus &status) {}
+    const DDS::RequestedDeadlineMissedStatus &status) {
+  this->stats_.on_deadline_missed(status);
+}
 
 void MissionReportDataReaderListenerImpl::on_requested_incompatible_qos(
     DDS::DataReader_ptr reader,
     const DDS::RequestedIncompatibleQosStatus &status) {}
 
 void MissionReportDataReaderListenerImpl::on_sample_rejected(
-    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleRejectedStatus &status) {
+  this->stats_.on_sample_rejected(status);
+}
 
 void MissionReportDataReaderListenerImpl::on_liveliness_changed(
     DDS::DataReader_ptr reader, const DDS::LivelinessChangedStatus &status) {}
@@ -39,7 +44,9 @@ void MissionReportDataReaderListenerImpl::on_subscription_matched(
     DDS::DataReader_ptr reader, const DDS::SubscriptionMatchedStatus &status) {}
 
 void MissionReportDataReaderListenerImpl::on_sample_lost(
-    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {}
+    DDS::DataReader_ptr reader, const DDS::SampleLostStatus &status) {
+  this->stats_.on_sample_lost(status);
+}
 
 void MissionReportDataReaderListenerImpl::on_data_available(
     DDS::DataReader_ptr reader) {
@@ -53,38 +60,39 @@ void MissionReportDataReaderListenerImpl::on_data_available(
     ACE_OS::exit(1);
   }
 
-  Autopilot::MissionReport report;
-  DDS::SampleInfo info;
+  // proxy for BC, forward message to CCC
+  const bool error = take_all<Autopilot::MissionReportSeq>(
+      reader_i.in(), this->stats_,
+      [this](const Autopilot::MissionReport &report, const DDS::SampleInfo &) {
+        // update protobuf, built in the frame's arena and shared with the
+        // telemetry stream
+        std::shared_ptr<TelemetryFrame> frame = this->hub_->make_frame();
+        TelemetryReport &telemetry_report = *frame->report;
+        MissionReport* report_pb = telemetry_report.mutable_mission_report();
 
-  const DDS::ReturnCode_t error = reader_i->take_next_sample(report, info);
+        report_pb->set_name(report.name);
 
-  // proxy for BC, forward message to CCC
-  if (error == DDS::RETCODE_OK) {
-    if (info.valid_data) {
-      // update protobuf
-      TelemetryReport telemetry_report{};
-      MissionReport* report_pb = telemetry_report.mutable_mission_report();
-
-      report_pb->set_name(report.name);
-
-      // WARNING: we're relying on the 1:1 match between enum values here
-      report_pb->set_status(MissionStatus(report.status));
-
-      report_pb->set_progress(report.progress);
-      report_pb->set_length(report.length);
-
-      // serialize and dump via UDP
-      if (!send_socket_->is_open())
-        send_socket_->open(boost::asio::ip::udp::v4());
-
-      send_socket_->send_to(
-          boost::asio::buffer(telemetry_report.SerializeAsString()),
-          this->ccc_rcv_endpoint_);
-    }
-  } else {
-    ACE_ERROR((
-        LM_ERROR,
-        ACE_TEXT(
-            "ERROR: %N:%l: on_data_available() - take_next_sample failed!\n")));
+        // WARNING: we're relying on the 1:1 match between enum values here
+        report_pb->set_status(MissionStatus(report.status));
+
+        report_pb->set_progress(report.progress);
+        report_pb->set_length(report.length);
+
+        // serialize and dump via UDP
+        if (!send_socket_->is_open())
+          send_socket_->open(boost::asio::ip::udp::v4());
+
+        serialize_frame(*frame, this->send_buffer_);
+        send_socket_->send_to(boost::asio::buffer(this->send_buffer_),
+                              this->ccc_rcv_endpoint_);
+
+        // coalesced per subscriber of the telemetry stream
+        this->hub_->publish(frame);
+      });
+
+  if (error) {
+    ACE_ERROR(
+        (LM_ERROR,
+         ACE_TEXT("ERROR: %N:%l: on_data_available() - take failed!\n")));
   }
 }
@@ -0,0 +1,125 @@
+#include "TelemetryHub.h"
+
+#include <algorithm>
+
+static google::protobuf::ArenaOptions frame_arena_options(char* block,
+                                                          size_t size) {
+  google::protobuf::ArenaOptions options;
+  options.initial_block = block;
+  options.initial_block_size = size;
+  return options;
+}
+
+TelemetryFrame::TelemetryFrame()
+    : arena(frame_arena_options(this->block, sizeof(this->block))),
+      report(google::protobuf::Arena::CreateMessage<TelemetryReport>(
+          &this->arena)),
+      seq(0) {}
+
+void serialize_frame(const TelemetryFrame& frame, std::string& buffer) {
+  frame.report->SerializeToString(&buffer);
+}
+
+TelemetrySubscriber::TelemetrySubscriber(uint32_t max_rate_hz)
+    : min_interval_(Clock::duration::zero()),
+      next_flush_(Clock::now()),
+      closed_(false),
+      sent_(0),
+      coalesced_(0) {
+  if (max_rate_hz > 0) {
+    this->min_interval_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::seconds(1)) / max_rate_hz;
+  }
+}
+
+void TelemetrySubscriber::offer(
+    uint64_t slot, const std::shared_ptr<const TelemetryFrame>& frame) {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    if (this->closed_) return;
+    std::shared_ptr<const TelemetryFrame>& pending = this->pending_[slot];
+    if (pending) ++this->coalesced_;
+    pending = frame;
+  }
+  this->ready_.notify_one();
+}
+
+bool TelemetrySubscriber::take(
+    std::vector<std::shared_ptr<const TelemetryFrame>>& frames,
+    std::chrono::milliseconds timeout) {
+  Clock::time_point deadline = Clock::now() + timeout;
+  std::unique_lock<std::mutex> lock(this->mutex_);
+
+  // let updates coalesce until the next flush is due
+  if (this->next_flush_ > Clock::now()) {
+    this->ready_.wait_until(lock, std::min(this->next_flush_, deadline),
+                            [this] { return this->closed_; });
+    if (this->closed_ || Clock::now() < this->next_flush_) return false;
+  }
+  if (!this->ready_.wait_until(lock, deadline, [this] {
+        return this->closed_ || !this->pending_.empty();
+      }) ||
+      this->closed_) {
+    return false;
+  }
+
+  frames.clear();
+  for (auto& entry : this->pending_) frames.push_back(std::move(entry.second));
+  this->pending_.clear();
+  this->next_flush_ = Clock::now() + this->min_interval_;
+  this->sent_ += frames.size();
+  lock.unlock();
+
+  // deliver in publication order rather than slot order
+  std::sort(frames.begin(), frames.end(),
+            [](const std::shared_ptr<const TelemetryFrame>& a,
+               const std::shared_ptr<const TelemetryFrame>& b) {
+              return a->seq < b->seq;
+            });
+  return true;
+}
+
+void TelemetrySubscriber::close() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->closed_ = true;
+    this->pending_.clear();
+  }
+  this->ready_.notify_all();
+}
+
+TelemetryHub::TelemetryHub() : seq_(0) {}
+
+std::shared_ptr<TelemetryFrame> TelemetryHub::make_frame() {
+  std::shared_ptr<TelemetryFrame> frame = std::make_shared<TelemetryFrame>();
+  frame->seq = this->seq_.fetch_add(1, std::memory_order_relaxed);
+  return frame;
+}
+
+void TelemetryHub::publish(const std::shared_ptr<const TelemetryFrame>& frame,
+                           uint32_t key) {
+  // coalesce per report type and key, e.g. per AIS target
+  uint64_t slot =
+      (static_cast<uint64_t>(frame->report->report_case()) << 32) | key;
+
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  for (auto& subscriber : this->subscribers_) subscriber->offer(slot, frame);
+}
+
+std::shared_ptr<TelemetrySubscriber> TelemetryHub::subscribe(
+    uint32_t max_rate_hz) {
+  std::shared_ptr<TelemetrySubscriber> subscriber =
+      std::make_shared<TelemetrySubscriber>(max_rate_hz);
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->subscribers_.push_back(subscriber);
+  return subscriber;
+}
+
+void TelemetryHub::unsubscribe(
+    const std::shared_ptr<TelemetrySubscriber>& subscriber) {
+  subscriber->close();
+  std::lock_guard<std::mutex> lock(this->mutex_);
+  this->subscribers_.erase(std::remove(this->subscribers_.begin(),
+                                       this->subscribers_.end(), subscriber),
+                           this->subscribers_.end());
+}
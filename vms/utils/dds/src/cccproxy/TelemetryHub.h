@@ -0,0 +1,93 @@
+#ifndef CCCPROXY_TELEMETRY_HUB_H
+#define CCCPROXY_TELEMETRY_HUB_H
+
+#include <google/protobuf/arena.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./messages.pb.h"
+
+// A single telemetry report, allocated together with the protobuf arena that
+// backs it so that building a report takes a single heap allocation. Frames
+// are immutable once published and shared between the UDP path and all
+// stream subscribers.
+struct TelemetryFrame {
+  TelemetryFrame();
+  TelemetryFrame(const TelemetryFrame&) = delete;
+  TelemetryFrame& operator=(const TelemetryFrame&) = delete;
+
+  // initial arena block, large enough for any of the report types
+  alignas(8) char block[1024];
+  google::protobuf::Arena arena;
+  TelemetryReport* report;
+  uint64_t seq;
+};
+
+// Serialize a frame's report for the UDP send. Unlike SerializeAsString()
+// the buffer keeps its capacity between calls, so once it has grown to the
+// largest report this does not allocate.
+void serialize_frame(const TelemetryFrame& frame, std::string& buffer);
+
+// Pending reports of a single StreamTelemetry call. Only the latest report per
+// coalescing slot is kept, so a slow client gets fresh state instead of a
+// growing backlog.
+class TelemetrySubscriber {
+ public:
+  explicit TelemetrySubscriber(uint32_t max_rate_hz);
+
+  // replace the pending report for the slot
+  void offer(uint64_t slot, const std::shared_ptr<const TelemetryFrame>& frame);
+
+  // wait until reports are pending and the rate limit allows another flush,
+  // returns false on timeout or if the subscriber was closed
+  bool take(std::vector<std::shared_ptr<const TelemetryFrame>>& frames,
+            std::chrono::milliseconds timeout);
+
+  void close();
+
+  uint64_t sent() const { return this->sent_; }
+  uint64_t coalesced() const { return this->coalesced_; }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::map<uint64_t, std::shared_ptr<const TelemetryFrame>> pending_;
+  Clock::duration min_interval_;
+  Clock::time_point next_flush_;
+  bool closed_;
+  uint64_t sent_;
+  uint64_t coalesced_;
+};
+
+// Fans telemetry reports out to all StreamTelemetry subscribers.
+class TelemetryHub {
+ public:
+  TelemetryHub();
+
+  std::shared_ptr<TelemetryFrame> make_frame();
+
+  // hand a finished report to all subscribers, reports of the same type and
+  // key replace each other if a subscriber has not picked them up yet
+  void publish(const std::shared_ptr<const TelemetryFrame>& frame,
+               uint32_t key = 0);
+
+  std::shared_ptr<TelemetrySubscriber> subscribe(uint32_t max_rate_hz);
+  void unsubscribe(const std::shared_ptr<TelemetrySubscriber>& subscriber);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<TelemetrySubscriber>> subscribers_;
+  std::atomic<uint64_t> seq_;
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include "XLUUVServiceImpl.h"
 
+#include <ace/Log_Msg.h>
 #include <dds/DdsDcpsInfrastructureC.h>
 
+#include <vector>
+
 #include "AutopilotC.h"
 #include "google/protobuf/empty.pb.h"
 
@@ -12,14 +15,16 @@ XLUUVServiceImpl::XLUUVServiceImpl(
     const Autopilot::DiveProcedureDataWriter_var dp_dw,
     const Autopilot::MissionDataWriter_var mission_dw,
     const Autopilot::MissionCommandDataWriter_var ms_cmd_dw,
-    const Autopilot::ProcedureActivationDataWriter_var proc_act_dw)
+    const Autopilot::ProcedureActivationDataWriter_var proc_act_dw,
+    TelemetryHub& telemetry_hub)
     : route_dw_{route_dw},
       ap_cmd_dw_{ap_cmd_dw},
       lp_dw_{lp_dw},
       dp_dw_{dp_dw},
       mission_dw_{mission_dw},
       ms_cmd_dw_{ms_cmd_dw},
-      proc_act_dw_{proc_act_dw} {}
+      proc_act_dw_{proc_act_dw},
+      telemetry_hub_(telemetry_hub) {}
 
 grpc::Status XLUUVServiceImpl::SendMission(grpc::ServerContext* context,
                                          const ApMission* request,
@@ -170,3 +175,36 @@ grpc::Status XLUUVServiceImpl::ActivateDiveProcedure(
 
   return grpc::Status::OK;
 }
+
+grpc::Status XLUUVServiceImpl::StreamTelemetry(
+    grpc::ServerContext* context, const TelemetrySubscription* request,
+    grpc::ServerWriter<TelemetryReport>* writer) {
+  std::shared_ptr<TelemetrySubscriber> subscriber =
+      this->telemetry_hub_.subscribe(request->max_rate_hz());
+  ACE_DEBUG((LM_DEBUG,
+             ACE_TEXT("Telemetry stream to %s opened, max rate %u Hz\n"),
+             context->peer().c_str(), request->max_rate_hz()));
+
+  // blocking writes are the backpressure here, reports published meanwhile
+  // replace older pending ones instead of queueing up
+  std::vector<std::shared_ptr<const TelemetryFrame>> frames;
+  bool connected = true;
+  while (connected && !context->IsCancelled()) {
+    // wake up regularly to notice cancelled streams
+    if (!subscriber->take(frames, std::chrono::milliseconds(500))) continue;
+    for (const auto& frame : frames) {
+      if (!writer->Write(*frame->report)) {
+        connected = false;
+        break;
+      }
+    }
+  }
+
+  this->telemetry_hub_.unsubscribe(subscriber);
+  ACE_DEBUG((LM_DEBUG,
+             ACE_TEXT("Telemetry stream to %s closed, %Q reports sent, %Q "
+                      "coalesced\n"),
+             context->peer().c_str(), subscriber->sent(),
+             subscriber->coalesced()));
+  return grpc::Status::OK;
+}
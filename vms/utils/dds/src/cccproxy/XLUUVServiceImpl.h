@@ -3,6 +3,7 @@
 
 #include <grpcpp/support/status.h>
 
+#include "./TelemetryHub.h"
 #include "./messages.grpc.pb.h"
 #include "AutopilotTypeSupportC.h"
 class XLUUVServiceImpl final : public XLUUV::Service {
@@ -13,7 +14,8 @@ class XLUUVServiceImpl final : public XLUUV::Service {
                  const Autopilot::DiveProcedureDataWriter_var,
                  const Autopilot::MissionDataWriter_var,
                  const Autopilot::MissionCommandDataWriter_var,
-                 const Autopilot::ProcedureActivationDataWriter_var);
+                 const Autopilot::ProcedureActivationDataWriter_var,
+                 TelemetryHub&);
 
   grpc::Status SendMission(grpc::ServerContext*, const ApMission*,
                            google::protobuf::Empty*) override;
@@ -35,6 +37,9 @@ class XLUUVServiceImpl final : public XLUUV::Service {
   grpc::Status ActivateDiveProcedure(grpc::ServerContext*,
                                      const DiveProcedureId*,
                                      google::protobuf::Empty*) override;
+  grpc::Status StreamTelemetry(grpc::ServerContext*,
+                               const TelemetrySubscription*,
+                               grpc::ServerWriter<TelemetryReport>*) override;
 
  private:
   const Autopilot::RouteDataWriter_var route_dw_;
@@ -44,5 +49,6 @@ class XLUUVServiceImpl final : public XLUUV::Service {
   const Autopilot::MissionDataWriter_var mission_dw_;
   const Autopilot::MissionCommandDataWriter_var ms_cmd_dw_;
   const Autopilot::ProcedureActivationDataWriter_var proc_act_dw_;
+  TelemetryHub& telemetry_hub_;
 };
 #endif
@@ -0,0 +1,258 @@
+#include "Encounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "../autopilot/AutopilotController.h"
+#include "../autopilot/ControlClock.h"
+#include "../autopilot/LocalFrame.h"
+#include "../autopilot/Marmaths.h"
+
+namespace {
+
+const ACE_hrtime_t PERIOD = 250 * 1000000;
+const double DT = PERIOD * 1e-9;
+
+const double ORIGIN_LAT = 54.3;
+const double ORIGIN_LON = 10.1;
+const double ROUTE_LENGTH = 8000.0;
+const double PLANNED_SPEED_KNT = 8.0;
+
+// the thresholds AutopilotController acts on
+const double COLREG_RADIUS = AutopilotController::COLREG_DEFAULT_RADIUS;
+const double COLREG_CPAD = AutopilotController::COLREG_CPAD;
+const double COLREG_CPA_HORIZON = AutopilotController::COLREG_CPA_HORIZON;
+
+// own ship: speed follows throttle, rate of turn follows rudder and speed
+const double MAX_SPEED = 6.0;
+const double SPEED_TAU = 15.0;
+const double TURN_GAIN = 0.02;  // deg/s per degree of rudder and m/s
+const double TURN_TAU = 3.0;
+
+const double GNSS_SIGMA = 3.0;
+const double AIS_INTERVAL = 3.0;
+
+struct Ship {
+  double east;
+  double north;
+  double course;  // degrees
+  double speed;   // meters/s
+  double rot;     // degrees/s
+
+  double v_east() const {
+    return this->speed * std::sin(this->course * DEG_TO_RAD);
+  }
+  double v_north() const {
+    return this->speed * std::cos(this->course * DEG_TO_RAD);
+  }
+  void move(double dt) {
+    this->course = std::fmod(this->course + this->rot * dt + 360.0, 360.0);
+    this->east += this->v_east() * dt;
+    this->north += this->v_north() * dt;
+  }
+};
+
+// time to and distance at the closest point of approach
+void cpa(const Ship& own, const Ship& target, double& tcpa, double& dcpa) {
+  double rn = target.north - own.north;
+  double re = target.east - own.east;
+  double vn = target.v_north() - own.v_north();
+  double ve = target.v_east() - own.v_east();
+  double vv = vn * vn + ve * ve;
+  tcpa = vv > 1e-9 ? std::max(0.0, -(rn * vn + re * ve) / vv) : 0.0;
+  double cn = rn + vn * tcpa;
+  double ce = re + ve * tcpa;
+  dcpa = std::sqrt(cn * cn + ce * ce);
+}
+
+}  // namespace
+
+const char* encounter_name(EncounterType type) {
+  switch (type) {
+    case ET_HEAD_ON:
+      return "head-on";
+    case ET_CROSSING:
+      return "crossing";
+    case ET_OVERTAKING:
+      return "overtaking";
+    default:
+      return "unknown";
+  }
+}
+
+void CpuHistogram::add(uint64_t ns) {
+  std::size_t bucket = std::min<uint64_t>(ns / BUCKET_NS, BUCKETS - 1);
+  ++this->buckets_[bucket];
+  ++this->count_;
+  this->total_ += ns;
+  this->max_ = std::max(this->max_, ns);
+}
+
+void CpuHistogram::merge(const CpuHistogram& other) {
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    this->buckets_[i] += other.buckets_[i];
+  }
+  this->count_ += other.count_;
+  this->total_ += other.total_;
+  this->max_ = std::max(this->max_, other.max_);
+}
+
+uint64_t CpuHistogram::quantile(double q) const {
+  uint64_t rank = static_cast<uint64_t>(q * this->count_);
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < BUCKETS; ++i) {
+    seen += this->buckets_[i];
+    if (seen > rank) return (i + 1) * BUCKET_NS;
+  }
+  return this->max_;
+}
+
+double CpuHistogram::mean() const {
+  if (this->count_ == 0) return 0.0;
+  return static_cast<double>(this->total_) / this->count_;
+}
+
+EncounterResult run_encounter(EncounterType type, uint64_t seed,
+                              CpuHistogram& cpu) {
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::normal_distribution<double> gnss_noise(0.0, GNSS_SIGMA);
+  auto uniform = [&](double lo, double hi) {
+    return lo + (hi - lo) * unit(rng);
+  };
+
+  SimulatedClock clock;
+  AutopilotController ap(clock, PERIOD);
+  LocalFrame frame;
+  frame.anchor(ORIGIN_LAT, ORIGIN_LON);
+
+  Ship own{0.0, 0.0, uniform(0.0, 360.0), PLANNED_SPEED_KNT * KNT_TO_MS, 0.0};
+
+  // a single leg straight ahead
+  Autopilot::Route route;
+  route.id = 1;
+  route.name = "colreg-bench";
+  route.planned_speed = PLANNED_SPEED_KNT;
+  route.waypoints.length(1);
+  route.waypoints[0].name = "end";
+  frame.to_geodetic({ROUTE_LENGTH * std::sin(own.course * DEG_TO_RAD),
+                     ROUTE_LENGTH * std::cos(own.course * DEG_TO_RAD)},
+                    route.waypoints[0].coords.latitude,
+                    route.waypoints[0].coords.longitude);
+  ap.set_route(route);
+  ap.activate_procedure(
+      Autopilot::ProcedureActivation{Autopilot::PROC_ROUTE, 1}, false);
+  ap.update_state(Autopilot::AC_ROUTE_START, false);
+
+  // put the target where it meets own ship's undisturbed track after
+  // t_meet seconds, give or take a small miss distance
+  Ship target{0.0, 0.0, 0.0, 0.0, 0.0};
+  switch (type) {
+    case ET_HEAD_ON:
+      target.course = own.course + 180.0 + uniform(-10.0, 10.0);
+      target.speed = uniform(2.0, 6.0);
+      break;
+    case ET_CROSSING:
+      // from either side, up to 67.5 degrees off the beam
+      target.course = own.course + (unit(rng) < 0.5 ? 90.0 : -90.0) +
+                      uniform(-67.5, 67.5);
+      target.speed = uniform(2.0, 6.0);
+      break;
+    case ET_OVERTAKING:
+    default:
+      target.course = own.course + uniform(-10.0, 10.0);
+      target.speed = own.speed * uniform(0.3, 0.7);
+      break;
+  }
+  target.course = std::fmod(target.course + 720.0, 360.0);
+  double t_meet = uniform(150.0, 240.0);
+  double miss = uniform(-15.0, 15.0);
+  double meet_east = own.v_east() * t_meet +
+                     miss * std::cos(own.course * DEG_TO_RAD);
+  double meet_north = own.v_north() * t_meet -
+                      miss * std::sin(own.course * DEG_TO_RAD);
+  target.east = meet_east - target.v_east() * t_meet;
+  target.north = meet_north - target.v_north() * t_meet;
+  const CORBA::Long mmsi = 211000000 + static_cast<CORBA::Long>(seed % 100000);
+
+  EncounterResult result{type, 1e9, false, false, 0.0, 0};
+  double threat_time = -1.0;
+  double next_ais = uniform(0.0, AIS_INTERVAL);
+  double end_time = t_meet + 120.0;
+  std::vector<PhysicalState::AivdmMessage> ais(1);
+
+  for (double t = 0.0; t < end_time; t += DT) {
+    PhysicalState::Sensors sensors{};
+    PhysicalState::Coordinates* fixes[] = {&sensors.gnss_1, &sensors.gnss_2,
+                                           &sensors.gnss_3};
+    for (PhysicalState::Coordinates* fix : fixes) {
+      frame.to_geodetic(
+          {own.east + gnss_noise(rng), own.north + gnss_noise(rng)},
+          fix->latitude, fix->longitude);
+    }
+    sensors.course_over_ground = own.course;
+    sensors.heading = own.course;
+    sensors.speed_over_ground = own.speed;
+    sensors.speed = own.speed;
+    sensors.rate_of_turn = own.rot * DEG_TO_RAD;
+    ap.set_sensor_vals(sensors);
+
+    if (t >= next_ais) {
+      next_ais += AIS_INTERVAL;
+      PhysicalState::AivdmMessage& message = ais[0];
+      message.message_type = 1;
+      message.mmsi = mmsi;
+      message.navigation_status = PhysicalState::UNDERWAY_ENGINE;
+      frame.to_geodetic({target.east, target.north}, message.latitude,
+                        message.longitude);
+      message.course_over_ground = target.course;
+      message.true_heading = target.course;
+      message.speed_over_ground = target.speed;
+      message.rate_of_turn = 0.0;
+      ap.update_aivdm(ais);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    ap.execute();
+    auto stop = std::chrono::steady_clock::now();
+    cpu.add(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+                .count());
+    ++result.cycles;
+
+    PhysicalState::Actuators cmds = ap.get_actuator_cmds();
+    bool acting = ap.get_colreg_report().type != Autopilot::CR_INACTIVE;
+
+    double range = std::hypot(target.east - own.east, target.north - own.north);
+    result.min_separation = std::min(result.min_separation, range);
+    double tcpa;
+    double dcpa;
+    cpa(own, target, tcpa, dcpa);
+    if (threat_time < 0.0 && range <= COLREG_RADIUS &&
+        tcpa <= COLREG_CPA_HORIZON && dcpa < COLREG_CPAD) {
+      threat_time = t;
+      result.threat = true;
+    }
+    if (acting && !result.acted) {
+      result.acted = true;
+      if (threat_time >= 0.0) result.decision_latency = t - threat_time;
+    }
+
+    // own ship responds to the commands of this cycle
+    double throttle =
+        0.5 * (cmds.engine_throttle_port + cmds.engine_throttle_stbd);
+    own.speed += (throttle * MAX_SPEED - own.speed) * DT / SPEED_TAU;
+    own.speed = std::max(own.speed, 0.0);
+    double rot_target = TURN_GAIN * cmds.rudder_angle * own.speed;
+    own.rot += (rot_target - own.rot) * DT / TURN_TAU;
+    own.move(DT);
+    target.move(DT);
+    clock.advance(PERIOD);
+
+    // done once the ships have passed and are drawing apart
+    if (t > t_meet && tcpa == 0.0 && range > 2.0 * COLREG_RADIUS) break;
+  }
+  return result;
+}
@@ -0,0 +1,55 @@
+#ifndef COLREGBENCH_ENCOUNTER_H
+#define COLREGBENCH_ENCOUNTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum EncounterType { ET_HEAD_ON, ET_CROSSING, ET_OVERTAKING, ET_COUNT };
+
+const char* encounter_name(EncounterType type);
+
+// execute() durations in 100 ns buckets, the last bucket collects anything
+// from 1 ms up
+class CpuHistogram {
+ public:
+  static constexpr std::size_t BUCKETS = 10001;
+  static constexpr uint64_t BUCKET_NS = 100;
+
+  void add(uint64_t ns);
+  void merge(const CpuHistogram& other);
+  // upper bound of the bucket holding the quantile, in nanoseconds
+  uint64_t quantile(double q) const;
+  uint64_t count() const { return this->count_; }
+  double mean() const;
+  uint64_t max() const { return this->max_; }
+
+ private:
+  std::array<uint64_t, BUCKETS> buckets_{};
+  uint64_t count_ = 0;
+  uint64_t total_ = 0;
+  uint64_t max_ = 0;
+};
+
+struct EncounterResult {
+  EncounterType type;
+  // closest true distance between the ships over the run, meters
+  double min_separation;
+  // the true geometry called for action: in range, CPA under the COLREG
+  // distance and within the COLREG horizon
+  bool threat;
+  // COLREG took action at some point
+  bool acted;
+  // seconds from the threat arising to the first COLREG action, 0 if the
+  // autopilot acted before the true geometry required it
+  double decision_latency;
+  uint64_t cycles;
+};
+
+// Simulates one randomised encounter between own ship, following a straight
+// route under the autopilot, and a single target on a collision course. The
+// seed fixes the geometry, the noise and the AIS timing.
+EncounterResult run_encounter(EncounterType type, uint64_t seed,
+                              CpuHistogram& cpu);
+
+#endif
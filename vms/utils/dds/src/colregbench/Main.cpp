@@ -0,0 +1,189 @@
+// Offline Monte-Carlo bench for the autopilot's COLREG handling. Runs
+// randomised head-on, crossing and overtaking encounters against the
+// controller with a simulated clock and kinematic ship models, no DDS or
+// network involved, and reports separation, decision latency and the CPU
+// time of execute():
+//
+//   colreg-bench [-n encounters] [-seed seed] [-threads n] [-fail-missed]
+//                [-fail-below-cpad fraction] [-fail-cpu-tail ratio]
+//
+// The exit status is 1, so the bench can gate regressions, with
+// -fail-missed if the autopilot did not act on a threat, with
+// -fail-below-cpad if any encounter came closer than the given fraction of
+// the COLREG CPA distance and with -fail-cpu-tail if the 99th percentile of
+// execute() took longer than the given multiple of its median. The last one
+// compares the run with itself, absolute times depend on the machine.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../AsyncLog.h"
+#include "../autopilot/AutopilotController.h"
+#include "Encounter.h"
+
+namespace {
+
+// encounters closer than this count as close quarters in the report
+const double CLOSE_QUARTERS = 25.0;
+
+struct Summary {
+  std::vector<double> separations;
+  std::size_t threats = 0;
+  std::size_t acted = 0;
+  std::size_t missed = 0;  // threats without any COLREG action
+  double latency_sum = 0.0;
+  double latency_max = 0.0;
+  std::size_t close_quarters = 0;
+
+  void add(const EncounterResult& result) {
+    this->separations.push_back(result.min_separation);
+    if (result.min_separation < CLOSE_QUARTERS) ++this->close_quarters;
+    if (!result.threat) return;
+    ++this->threats;
+    if (!result.acted) {
+      ++this->missed;
+      return;
+    }
+    ++this->acted;
+    this->latency_sum += result.decision_latency;
+    this->latency_max = std::max(this->latency_max, result.decision_latency);
+  }
+
+  double separation_quantile(double q) {
+    if (this->separations.empty()) return 0.0;
+    std::size_t rank = static_cast<std::size_t>(q * (separations.size() - 1));
+    std::nth_element(this->separations.begin(),
+                     this->separations.begin() + rank, this->separations.end());
+    return this->separations[rank];
+  }
+};
+
+void print_summary(const char* name, Summary& summary) {
+  std::printf("%-11s %6zu %8.1f %8.1f %8.1f %6zu %7zu %8.2f %8.2f %6zu\n", name,
+              summary.separations.size(), summary.separation_quantile(0.0),
+              summary.separation_quantile(0.05),
+              summary.separation_quantile(0.5), summary.close_quarters,
+              summary.threats,
+              summary.acted ? summary.latency_sum / summary.acted : 0.0,
+              summary.latency_max, summary.missed);
+}
+
+int missing_arg(const std::string& arg) {
+  std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+  return 2;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::size_t encounters = 3000;
+  uint64_t seed = 1;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  bool fail_missed = false;
+  double fail_below_cpad = -1.0;
+  double fail_cpu_tail = -1.0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "-n") {
+      if (i == argc - 1) return missing_arg(arg);
+      encounters = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-seed") {
+      if (i == argc - 1) return missing_arg(arg);
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "-threads") {
+      if (i == argc - 1) return missing_arg(arg);
+      threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "-fail-missed") {
+      fail_missed = true;
+    } else if (arg == "-fail-below-cpad") {
+      if (i == argc - 1) return missing_arg(arg);
+      fail_below_cpad = std::atof(argv[++i]);
+    } else if (arg == "-fail-cpu-tail") {
+      if (i == argc - 1) return missing_arg(arg);
+      fail_cpu_tail = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "unknown argument %s\n", arg.c_str());
+      return 2;
+    }
+  }
+
+  // the controller logs every cycle at debug level, keep the bench quiet
+  // unless asked otherwise
+  if (std::getenv("XLUUV_LOG") == nullptr) {
+    xluuv_log::Logger::instance().configure("all=warning");
+  }
+
+  // encounter i always gets the same type and seed, whatever the number of
+  // threads
+  std::vector<EncounterResult> results(encounters);
+  std::vector<CpuHistogram> cpu(threads);
+  auto worker = [&](unsigned index) {
+    for (std::size_t i = index; i < encounters; i += threads) {
+      results[i] = run_encounter(static_cast<EncounterType>(i % ET_COUNT),
+                                 seed * 1000003 + i, cpu[index]);
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker, t);
+  worker(0);
+  for (std::thread& thread : pool) thread.join();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                              start)
+                    .count();
+
+  CpuHistogram total_cpu;
+  for (const CpuHistogram& histogram : cpu) total_cpu.merge(histogram);
+  Summary by_type[ET_COUNT];
+  Summary all;
+  double worst_separation = 1e9;
+  for (const EncounterResult& result : results) {
+    by_type[result.type].add(result);
+    all.add(result);
+    worst_separation = std::min(worst_separation, result.min_separation);
+  }
+
+  std::printf("%zu encounters in %.2f s on %u threads, %.0f encounters/s, "
+              "%.0f simulated cycles/s\n\n",
+              encounters, wall, threads, encounters / wall,
+              total_cpu.count() / wall);
+  std::printf("%-11s %6s %8s %8s %8s %6s %7s %8s %8s %6s\n", "encounter",
+              "runs", "min sep", "p5 sep", "p50 sep", "<25m", "threats",
+              "lat avg", "lat max", "missed");
+  for (int type = 0; type < ET_COUNT; ++type) {
+    print_summary(encounter_name(static_cast<EncounterType>(type)),
+                  by_type[type]);
+  }
+  print_summary("all", all);
+  std::printf("\nexecute() per decision: mean %.2f us, p50 %.1f us, "
+              "p99 %.1f us, max %.1f us\n",
+              total_cpu.mean() * 1e-3, total_cpu.quantile(0.5) * 1e-3,
+              total_cpu.quantile(0.99) * 1e-3, total_cpu.max() * 1e-3);
+
+  int status = 0;
+  if (fail_missed && all.missed > 0) {
+    std::printf("FAIL: %zu threats without any COLREG action\n", all.missed);
+    status = 1;
+  }
+  const double fail_below = fail_below_cpad * AutopilotController::COLREG_CPAD;
+  if (fail_below_cpad >= 0.0 && worst_separation < fail_below) {
+    std::printf("FAIL: closest encounter %.1f m is below %.1f m, %.2f of the "
+                "COLREG CPA distance\n",
+                worst_separation, fail_below, fail_below_cpad);
+    status = 1;
+  }
+  if (fail_cpu_tail >= 0.0 &&
+      total_cpu.quantile(0.99) > fail_cpu_tail * total_cpu.quantile(0.5)) {
+    std::printf("FAIL: p99 execute() time is above %.1f times the median\n",
+                fail_cpu_tail);
+    status = 1;
+  }
+  return status;
+}
@@ -0,0 +1,356 @@
+#ifndef COSIM_CHANNEL_H
+#define COSIM_CHANNEL_H
+
+// Lockstep co-simulation clock shared between BC and the DDS components on
+// one host. BC is the master: it publishes the simulated time in a POSIX
+// shared memory segment and only moves it on once every client is blocked
+// waiting for a later time and every message sent through BC, the proxies
+// and the autopilot has been taken by its consumer. Clients read the time
+// from the segment and block on a futex until the master grants the time
+// they wait for.
+//
+// Messages are tracked per stream with a sent and a received counter. The
+// producer counts before the master can next check, i.e. before blocking
+// for a client and any time before the next step for the master itself,
+// and the final consumer after taking. The proxies in between only forward
+// and take no part. Streams are only checked while a client is attached,
+// so components that do not run in lockstep do not hold the master up.
+//
+// A client that dies is noticed by its pid and dropped by the master, a
+// client that loses its master, to a crash or a clean close, gets an error
+// from wait_until(). Only available on Linux, open() fails elsewhere.
+//
+// BC builds against this header too, see COSIM_INCLUDE_DIR in its
+// CMakeLists.txt.
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <climits>
+#endif
+
+#define COSIM_CLOCK_SEGMENT "/xluuv-cosim-clock"
+
+// message streams between BC and the autopilot
+enum CoSimStream {
+  COSIM_SENSORS,
+  COSIM_ACTUATORS,
+  COSIM_AIVDM,
+  COSIM_STREAMS
+};
+
+class CoSimChannel {
+ public:
+  enum Role { MASTER, CLIENT };
+  static constexpr int MAX_CLIENTS = 8;
+
+  CoSimChannel()
+      : header_(nullptr), role_(CLIENT), slot_(-1), seen_master_(false) {}
+  ~CoSimChannel() { this->close(); }
+
+  CoSimChannel(const CoSimChannel&) = delete;
+  CoSimChannel& operator=(const CoSimChannel&) = delete;
+
+  // create or attach to the segment, returns true on error. Only tests
+  // need another segment than the one BC and the autopilot share.
+  bool open(Role role, const char* segment = COSIM_CLOCK_SEGMENT) {
+#ifdef __linux__
+    this->close();
+    int fd = shm_open(segment, O_CREAT | O_RDWR, 0660);
+    if (fd < 0) return true;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (static_cast<std::size_t>(st.st_size) < sizeof(Header) &&
+         ftruncate(fd, sizeof(Header)) != 0)) {
+      ::close(fd);
+      return true;
+    }
+    void* mem = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return true;
+
+    Header* header = static_cast<Header*>(mem);
+    uint32_t expected = 0;
+    if (!header->layout.compare_exchange_strong(expected, LAYOUT_TAG) &&
+        expected != LAYOUT_TAG) {
+      munmap(mem, sizeof(Header));
+      return true;
+    }
+    this->header_ = header;
+    this->role_ = role;
+    // a client that finds a master here must not wait for it to come back
+    this->seen_master_ = header->master_pid.load() != 0;
+
+    if (role == MASTER) {
+      // whatever a previous master left in flight is gone
+      this->resync();
+      this->header_->master_pid.store(getpid());
+    }
+    return false;
+#else
+    (void)role;
+    (void)segment;
+    return true;
+#endif
+  }
+
+  void close() {
+#ifdef __linux__
+    if (this->header_ == nullptr) return;
+    if (this->role_ == MASTER) {
+      this->header_->master_pid.store(0);
+      this->header_->epoch.fetch_add(1);
+      this->wake(this->header_->epoch);
+    } else {
+      this->detach();
+    }
+    munmap(this->header_, sizeof(Header));
+#endif
+    this->header_ = nullptr;
+  }
+
+  bool is_open() const { return this->header_ != nullptr; }
+
+  // simulated time in nanoseconds, 0 until a master published one
+  uint64_t time() const { return this->header_->time.load(); }
+
+  // called by the producer of a message and by its final consumer after
+  // taking it
+  void count_sent(CoSimStream stream) {
+    this->header_->sent[stream].fetch_add(1);
+  }
+  void count_received(CoSimStream stream) {
+    this->header_->received[stream].fetch_add(1);
+    this->notify_master();
+  }
+
+  // master side
+
+  // moves the time on and releases the clients waiting for it
+  void publish(uint64_t time) {
+    this->header_->time.store(time);
+    this->header_->epoch.fetch_add(1);
+    this->wake(this->header_->epoch);
+  }
+
+  // every client waits for a later time and nothing is in flight
+  bool settled() const {
+    uint64_t now = this->header_->time.load();
+    bool attached = false;
+    for (const Client& client : this->header_->clients) {
+      if (client.pid.load() == 0) continue;
+      attached = true;
+      if (client.wait_until.load() <= now) return false;
+    }
+    if (!attached) return true;
+    for (int i = 0; i < COSIM_STREAMS; ++i) {
+      const Header& header = *this->header_;
+      if (header.received[i].load() < header.sent[i].load()) return false;
+    }
+    return true;
+  }
+
+  // wait up to timeout_ms for settled(), returns false on timeout
+  bool wait_settled(int timeout_ms) {
+#ifdef __linux__
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (true) {
+      uint32_t progress = this->header_->progress.load();
+      if (this->settled()) return true;
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 +
+                        (now.tv_nsec - start.tv_nsec) / 1000000;
+      if (elapsed_ms >= timeout_ms) return false;
+      this->header_->master_waiting.store(1);
+      if (this->header_->progress.load() == progress) {
+        this->wait(this->header_->progress, progress, timeout_ms - elapsed_ms);
+      }
+      this->header_->master_waiting.store(0);
+    }
+#else
+    (void)timeout_ms;
+    return this->settled();
+#endif
+  }
+
+  // drops clients that died, returns their number
+  int reap() {
+    int reaped = 0;
+#ifdef __linux__
+    for (Client& client : this->header_->clients) {
+      uint32_t pid = client.pid.load();
+      if (pid != 0 && !alive(pid) &&
+          client.pid.compare_exchange_strong(pid, 0)) {
+        client.wait_until.store(0);
+        ++reaped;
+      }
+    }
+#endif
+    return reaped;
+  }
+
+  // forget messages that were lost on the way
+  void resync() {
+    for (int i = 0; i < COSIM_STREAMS; ++i) {
+      this->header_->received[i].store(this->header_->sent[i].load());
+    }
+  }
+
+  int clients() const {
+    int attached = 0;
+    for (const Client& client : this->header_->clients) {
+      if (client.pid.load() != 0) ++attached;
+    }
+    return attached;
+  }
+
+  // pid of a client that has not reached the current time, 0 if none
+  uint32_t lagging_client() const {
+    uint64_t now = this->header_->time.load();
+    for (const Client& client : this->header_->clients) {
+      uint32_t pid = client.pid.load();
+      if (pid != 0 && client.wait_until.load() <= now) return pid;
+    }
+    return 0;
+  }
+
+  // client side
+
+  // take part in the lockstep, returns true if all slots are taken
+  bool attach() {
+#ifdef __linux__
+    for (int i = 0; i < MAX_CLIENTS; ++i) {
+      // free slots wait for time 0, so the master holds the time until the
+      // first wait_until()
+      uint32_t expected = 0;
+      if (this->header_->clients[i].pid.compare_exchange_strong(expected,
+                                                                getpid())) {
+        this->slot_ = i;
+        return false;
+      }
+    }
+#endif
+    return true;
+  }
+
+  void detach() {
+    if (this->slot_ < 0) return;
+    this->header_->clients[this->slot_].wait_until.store(0);
+    this->header_->clients[this->slot_].pid.store(0);
+    this->slot_ = -1;
+    this->notify_master();
+  }
+
+  // block until the simulated time reaches the deadline, returns false if
+  // the master went away. Before any master attached the client waits for
+  // one, so either side may start first.
+  bool wait_until(uint64_t deadline) {
+    if (this->slot_ >= 0) {
+      this->header_->clients[this->slot_].wait_until.store(deadline);
+      this->notify_master();
+    }
+    while (true) {
+      uint32_t epoch = this->header_->epoch.load();
+      if (this->header_->time.load() >= deadline) return true;
+      // wake up regularly to check on the master
+      uint32_t master = this->header_->master_pid.load();
+      if (master != 0) {
+        if (!alive(master)) return false;
+        this->seen_master_ = true;
+      } else if (this->seen_master_) {
+        return false;  // closed, the time will not move on
+      }
+      this->wait(this->header_->epoch, epoch, 100);
+    }
+  }
+
+ private:
+  struct Client {
+    std::atomic<uint32_t> pid;
+    std::atomic<uint64_t> wait_until;
+  };
+
+  struct Header {
+    std::atomic<uint32_t> layout;
+    std::atomic<uint32_t> master_pid;
+    // bumped with every new time, clients wait on it
+    alignas(64) std::atomic<uint32_t> epoch;
+    std::atomic<uint64_t> time;
+    // bumped whenever a client blocks or a message is taken, the master
+    // waits on it
+    alignas(64) std::atomic<uint32_t> progress;
+    std::atomic<uint32_t> master_waiting;
+    alignas(64) std::atomic<uint64_t> sent[COSIM_STREAMS];
+    std::atomic<uint64_t> received[COSIM_STREAMS];
+    Client clients[MAX_CLIENTS];
+  };
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "futex word must be a plain 32 bit integer");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+                "shared counters must be lock free");
+
+  static constexpr uint32_t LAYOUT_TAG =
+      0x43530000u ^ static_cast<uint32_t>(sizeof(Header));
+
+  static bool alive(uint32_t pid) {
+#ifdef __linux__
+    return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+#else
+    (void)pid;
+    return true;
+#endif
+  }
+
+  void notify_master() {
+    this->header_->progress.fetch_add(1);
+    if (this->header_->master_waiting.load() != 0) {
+      this->wake(this->header_->progress);
+    }
+  }
+
+  void wait(std::atomic<uint32_t>& word, uint32_t expected, long timeout_ms) {
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT,
+            expected, &timeout, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    (void)timeout_ms;
+#endif
+  }
+
+  void wake(std::atomic<uint32_t>& word) {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+  }
+
+  Header* header_;
+  Role role_;
+  int slot_;
+  // a master was attached since open()
+  bool seen_master_;
+};
+
+#endif
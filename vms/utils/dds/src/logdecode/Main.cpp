@@ -0,0 +1,113 @@
+// Offline decoder for binary logs written by the asynchronous logger when
+// XLUUV_LOG_FILE is set. Prints one formatted line per record:
+//
+//   xluuv-logdecode autopilot.xlog [category...]
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../AsyncLog.h"
+
+using xluuv_log::LogRecord;
+
+template <typename T>
+bool get(std::FILE* in, T& value) {
+  return std::fread(&value, sizeof(value), 1, in) == 1;
+}
+
+bool read_record(std::FILE* in, LogRecord& record, uint32_t& fmt_id) {
+  if (!get(in, record.ts) || !get(in, record.category) ||
+      !get(in, record.level) || !get(in, record.nargs) || !get(in, fmt_id)) {
+    return false;
+  }
+  if (record.nargs > xluuv_log::LOG_MAX_ARGS) return false;
+  if (std::fread(record.arg_types, 1, record.nargs, in) != record.nargs ||
+      std::fread(record.args, sizeof(uint64_t), record.nargs, in) !=
+          record.nargs ||
+      !get(in, record.pool_used) ||
+      record.pool_used > xluuv_log::LOG_STRING_POOL ||
+      std::fread(record.pool, 1, record.pool_used, in) != record.pool_used) {
+    return false;
+  }
+  // guard against corrupted string offsets
+  for (uint8_t i = 0; i < record.nargs; ++i) {
+    if (record.arg_types[i] == xluuv_log::LA_STRING &&
+        record.args[i] >= record.pool_used) {
+      record.args[i] = 0;
+      record.pool[0] = '\0';
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s LOGFILE [category...]\n", argv[0]);
+    return 1;
+  }
+
+  std::FILE* in = std::fopen(argv[1], "rb");
+  if (in == nullptr) {
+    std::perror(argv[1]);
+    return 1;
+  }
+
+  char magic[5];
+  if (std::fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+      std::memcmp(magic, "XLOG\x01", sizeof(magic)) != 0) {
+    std::fprintf(stderr, "%s: not an xluuv binary log\n", argv[1]);
+    return 1;
+  }
+
+  std::vector<std::string> formats;
+  std::string line;
+  LogRecord record{};
+  uint64_t decoded = 0;
+
+  char tag;
+  while (get(in, tag)) {
+    if (tag == 'F') {
+      uint32_t id;
+      uint16_t len;
+      if (!get(in, id) || !get(in, len)) break;
+      std::string fmt(len, '\0');
+      if (std::fread(&fmt[0], 1, len, in) != len) break;
+      if (formats.size() <= id) formats.resize(id + 1);
+      formats[id] = fmt;
+    } else if (tag == 'R') {
+      uint32_t fmt_id;
+      if (!read_record(in, record, fmt_id)) break;
+      if (fmt_id >= formats.size()) {
+        std::fprintf(stderr, "unknown format id %u, aborting\n", fmt_id);
+        return 1;
+      }
+
+      const char* category = xluuv_log::category_name(record.category);
+      bool selected = argc == 2;
+      for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], category) == 0) selected = true;
+      }
+      if (!selected) continue;
+
+      line.clear();
+      xluuv_log::format_record(formats[fmt_id].c_str(), record, line);
+      uint64_t seconds = record.ts / UINT64_C(1000000000);
+      uint64_t nanos = record.ts % UINT64_C(1000000000);
+      std::printf("%" PRIu64 ".%09" PRIu64 " %-9s %-7s %s", seconds, nanos,
+                  category, xluuv_log::level_name(record.level), line.c_str());
+      if (line.empty() || line.back() != '\n') std::putchar('\n');
+      ++decoded;
+    } else {
+      std::fprintf(stderr, "corrupted log, unexpected tag 0x%02x\n",
+                   static_cast<unsigned char>(tag));
+      return 1;
+    }
+  }
+
+  std::fclose(in);
+  std::fprintf(stderr, "decoded %" PRIu64 " records\n", decoded);
+  return 0;
+}
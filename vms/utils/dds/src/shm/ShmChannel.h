@@ -0,0 +1,202 @@
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+
+// Shared memory transport between BC and the BC proxies for co-located
+// deployments. Each channel is a single-producer/single-consumer ring of
+// fixed-size slots in a POSIX shared memory segment, messages are copied in
+// as-is without any text encoding. A waiting consumer sleeps on a futex that
+// the producer only wakes when somebody is actually waiting.
+//
+// Both sides may start in any order and restart independently, the segment
+// is created by whoever opens it first and is never unlinked. Only available
+// on Linux, open() fails elsewhere so callers can fall back to UDP.
+//
+// BC builds against this header too, see SHM_INCLUDE_DIR in its
+// CMakeLists.txt. The messages are defined on each side, BcProxyMessages.h
+// here and BcProxyMessages.hpp in BC, which pin their field offsets.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <climits>
+#endif
+
+// well-known segment names, one per message stream
+#define SHM_SENSORS_CHANNEL "/xluuv-bc-sensors"
+#define SHM_ACTUATORS_CHANNEL "/xluuv-bc-actuators"
+#define SHM_AIVDM_CHANNEL "/xluuv-bc-aivdm"
+
+// part of every segment's layout tag, bump it whenever the header below or
+// a message sent through a channel changes, so that peers built before and
+// after refuse each other's segments instead of misreading them
+#define SHM_LAYOUT_VERSION 1u
+
+template <typename T, uint32_t SLOTS = 64>
+class ShmChannel {
+  static_assert((SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of 2");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "shared memory messages must be trivially copyable");
+
+ public:
+  enum Role { PRODUCER, CONSUMER };
+
+  ShmChannel() : header_(nullptr), slots_(nullptr), size_(0) {}
+  ~ShmChannel() { this->close(); }
+
+  ShmChannel(const ShmChannel&) = delete;
+  ShmChannel& operator=(const ShmChannel&) = delete;
+
+  // create or attach to the named segment, returns true on error
+  bool open(const std::string& name, Role role) {
+#ifdef __linux__
+    this->close();
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0660);
+    if (fd < 0) return true;
+
+    std::size_t size = sizeof(Header) + SLOTS * sizeof(T);
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        (static_cast<std::size_t>(st.st_size) < size &&
+         ftruncate(fd, size) != 0)) {
+      ::close(fd);
+      return true;
+    }
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED) return true;
+
+    // a fresh segment is zero filled, which already is an empty ring, so
+    // only the layout tag needs to be claimed
+    Header* header = static_cast<Header*>(mem);
+    uint32_t expected = 0;
+    if (!header->layout.compare_exchange_strong(expected, layout_tag()) &&
+        expected != layout_tag()) {
+      // written by a peer built with different message definitions
+      munmap(mem, size);
+      return true;
+    }
+
+    this->header_ = header;
+    this->slots_ = reinterpret_cast<T*>(static_cast<char*>(mem) +
+                                        sizeof(Header));
+    this->size_ = size;
+
+    // skip whatever a previous producer left behind
+    if (role == CONSUMER) {
+      this->header_->tail.store(this->header_->head.load());
+    }
+    return false;
+#else
+    (void)name;
+    (void)role;
+    return true;
+#endif
+  }
+
+  void close() {
+#ifdef __linux__
+    if (this->header_ != nullptr) munmap(this->header_, this->size_);
+#endif
+    this->header_ = nullptr;
+    this->slots_ = nullptr;
+  }
+
+  bool is_open() const { return this->header_ != nullptr; }
+
+  // returns false if the ring is full and the message was dropped
+  bool send(const T& message) {
+    uint32_t head = this->header_->head.load(std::memory_order_relaxed);
+    uint32_t tail = this->header_->tail.load(std::memory_order_acquire);
+    if (head - tail >= SLOTS) {
+      this->header_->dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    this->slots_[head & (SLOTS - 1)] = message;
+    // sequentially consistent so that either the consumer sees the new head
+    // or we see its waiter registration
+    this->header_->head.store(head + 1);
+    if (this->header_->waiters.load() != 0) this->wake();
+    return true;
+  }
+
+  // wait up to timeout_ms for the next message, returns false on timeout
+  bool receive(T& message, int timeout_ms) {
+    uint32_t tail = this->header_->tail.load(std::memory_order_relaxed);
+    uint32_t head = this->header_->head.load(std::memory_order_acquire);
+    if (head == tail) {
+      if (timeout_ms <= 0) return false;
+      this->header_->waiters.fetch_add(1);
+      if (this->header_->head.load() == tail) this->wait(tail, timeout_ms);
+      this->header_->waiters.fetch_sub(1);
+      head = this->header_->head.load(std::memory_order_acquire);
+      if (head == tail) return false;
+    }
+    message = this->slots_[tail & (SLOTS - 1)];
+    this->header_->tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t dropped() const {
+    return this->header_->dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Header {
+    std::atomic<uint32_t> layout;
+    std::atomic<uint32_t> dropped;
+    // producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<uint32_t> head;
+    std::atomic<uint32_t> waiters;
+    alignas(64) std::atomic<uint32_t> tail;
+  };
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                "futex word must be a plain 32 bit integer");
+  static_assert(offsetof(Header, dropped) == 4 &&
+                    offsetof(Header, head) == 64 &&
+                    offsetof(Header, waiters) == 68 &&
+                    offsetof(Header, tail) == 128 && sizeof(Header) == 192,
+                "changing the header needs a new SHM_LAYOUT_VERSION");
+
+  static constexpr uint32_t layout_tag() {
+    return 0x58534d00u ^ (SHM_LAYOUT_VERSION << 24) ^
+           (static_cast<uint32_t>(sizeof(T)) << 8) ^ SLOTS;
+  }
+
+  void wait(uint32_t expected, int timeout_ms) {
+#ifdef __linux__
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->header_->head),
+            FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+    (void)expected;
+    (void)timeout_ms;
+#endif
+  }
+
+  void wake() {
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&this->header_->head),
+            FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+  }
+
+  Header* header_;
+  T* slots_;
+  std::size_t size_;
+};
+
+#endif
@@ -0,0 +1,116 @@
+// Replays a synthetic AIS stream of an hour over 30000 MMSIs through the
+// target store. The targets held have to stay bounded by the time to live,
+// and every query has to return each target that a brute force search over
+// all fixes finds within range.
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "../autopilot/AisTargetStore.h"
+#include "../autopilot/Marmaths.h"
+#include "Check.h"
+
+namespace {
+
+const ACE_hrtime_t SECOND = 1000000000ull;
+const ACE_hrtime_t TTL = 180 * SECOND;
+const int MESSAGES_PER_SECOND = 20;
+const double RADIUS = 750.0;
+
+// whether a target, dead reckoned from its fix, is within the radius
+bool in_range(const AisTarget& target, ACE_hrtime_t now, double lat,
+              double lon) {
+  double elapsed = (now - target.fix_ts_) * 1e-9;
+  double north, east;
+  std::tie(north, east) = polar_to_cartesian(target.fix_cog_, target.fix_sog_);
+  double target_lat =
+      shift_lat(target.fix_lat_, target.fix_lon_, north * elapsed);
+  double target_lon =
+      shift_long(target.fix_lat_, target.fix_lon_, east * elapsed);
+  return distance_harvesine(lat, lon, target_lat, target_lon) <= RADIUS;
+}
+
+}  // namespace
+
+int main() {
+  AisTargetStore store(TTL, 0.01);
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> random_lat(53.5, 54.5);
+  std::uniform_real_distribution<double> random_lon(9.5, 11.0);
+  std::uniform_real_distribution<double> random_sog(0, 12);
+  std::uniform_real_distribution<double> random_cog(0, 360);
+
+  // the latest fix of every MMSI ever seen
+  std::map<CORBA::Long, AisTarget> reference;
+  std::size_t max_held = 0;
+  uint64_t in_range_count = 0;
+  uint64_t missed = 0;
+  uint64_t examined = 0;
+  bool ordered = true;
+  const double own_lat = 54.0;
+  const double own_lon = 10.2;
+
+  for (int second = 0; second < 3600; ++second) {
+    ACE_hrtime_t now = (second + 1) * SECOND;
+    for (int k = 0; k < MESSAGES_PER_SECOND; ++k) {
+      // 5000 MMSIs at a time, a new set of them every 10 minutes
+      PhysicalState::AivdmMessage message = PhysicalState::AivdmMessage();
+      message.mmsi = 200000000 + (second * MESSAGES_PER_SECOND + k) % 5000 +
+                     (second / 600) * 5000;
+      message.latitude = random_lat(rng);
+      message.longitude = random_lon(rng);
+      message.speed_over_ground = random_sog(rng);
+      message.course_over_ground = random_cog(rng);
+      store.update(message, now);
+      reference[message.mmsi] =
+          AisTarget{now,
+                    message.navigation_status,
+                    message.mmsi,
+                    message.latitude,
+                    message.longitude,
+                    0,
+                    message.course_over_ground,
+                    message.speed_over_ground};
+    }
+    store.evict_expired(now);
+    max_held = std::max(max_held, store.size());
+
+    std::vector<const AisTarget*> candidates;
+    store.query(own_lat, own_lon, RADIUS, candidates);
+    examined += candidates.size();
+    std::set<CORBA::Long> found;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+      found.insert(candidates[i]->mmsi);
+      if (i > 0) ordered &= candidates[i - 1]->mmsi < candidates[i]->mmsi;
+    }
+    for (const auto& entry : reference) {
+      const AisTarget& target = entry.second;
+      if (now - target.fix_ts_ > TTL) continue;
+      if (!in_range(target, now, own_lat, own_lon)) continue;
+      ++in_range_count;
+      if (found.count(target.mmsi) == 0) ++missed;
+    }
+  }
+
+  std::printf("%zu MMSIs seen, at most %zu held, %llu evicted, %llu of %llu "
+              "in range missed, %.1f examined per query\n",
+              reference.size(), max_held,
+              static_cast<unsigned long long>(store.evicted()),
+              static_cast<unsigned long long>(missed),
+              static_cast<unsigned long long>(in_range_count),
+              examined / 3600.0);
+  CHECK(reference.size() == 30000);
+  // the TTL's worth of messages, plus up to a second until the sweep
+  CHECK(max_held <= (180 + 1) * MESSAGES_PER_SECOND);
+  CHECK(store.evicted() > 0);
+  CHECK(in_range_count > 0);
+  CHECK(missed == 0);
+  CHECK(ordered);
+  CHECK(examined / 3600.0 < max_held / 10.0);
+  return xluuv_test::test_exit("ais-target-store-test");
+}
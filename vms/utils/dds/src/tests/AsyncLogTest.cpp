@@ -0,0 +1,161 @@
+// Formatting, levels, rate limits and the binary output of the asynchronous
+// logger, and the cost of a log call on the calling thread against formatting
+// and writing synchronously, as ACE_DEBUG did.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../AsyncLog.h"
+#include "Check.h"
+
+using namespace xluuv_log;
+
+namespace {
+
+const char* const BINARY_LOG = "async-log-test.xlog";
+
+std::string format(const char* fmt, const LogRecord& record) {
+  std::string out;
+  format_record(fmt, record, out);
+  return out;
+}
+
+void test_format() {
+  // a record as log() captures it
+  LogRecord record{};
+  record.arg_types[0] = LA_INT;
+  record.args[0] = static_cast<uint64_t>(static_cast<int64_t>(-42));
+  record.arg_types[1] = LA_UINT;
+  record.args[1] = 4000000000u;
+  double d = 12.3456;
+  record.arg_types[2] = LA_DOUBLE;
+  std::memcpy(&record.args[2], &d, sizeof(d));
+  std::strcpy(record.pool, "sensors");
+  record.pool_used = 8;
+  record.arg_types[3] = LA_STRING;
+  record.args[3] = 0;
+  record.nargs = 4;
+
+  CHECK(format("%d %u %.2f %s", record) == "-42 4000000000 12.35 sensors");
+  CHECK(format("%5ld|%-4lu|%08.3lf|%10s", record) ==
+        "  -42|4000000000|0012.346|   sensors");
+  CHECK(format("100%% %x", record) == "100% ffffffffffffffd6");
+  // missing arguments and ACE's own conversions are printed, not read
+  CHECK(format("%N %d %u %f %s %d", record) ==
+        "%N -42 4000000000 12.345600 sensors <?>");
+}
+
+void test_levels() {
+  Logger logger(64);
+  CHECK(logger.configure("all=info,sensors=debug:10,pid=off"));
+  CHECK(logger.enabled(LC_GENERAL, LL_INFO));
+  CHECK(!logger.enabled(LC_GENERAL, LL_DEBUG));
+  CHECK(logger.enabled(LC_SENSORS, LL_DEBUG));
+  CHECK(!logger.enabled(LC_PID, LL_ERROR));
+  CHECK(!logger.configure("nosuchcategory=info"));
+  CHECK(!logger.configure("ais=loud"));
+  logger.set_level(LC_PID, LL_TRACE);
+  CHECK(logger.enabled(LC_PID, LL_TRACE));
+}
+
+void test_rate_limit_and_binary() {
+  std::remove(BINARY_LOG);
+  {
+    Logger logger(64);
+    CHECK(logger.open_binary(BINARY_LOG));
+    logger.set_rate_limit(LC_AIS, 5);
+    // all within one second, so only the first 5 are let through
+    for (int i = 0; i < 50; ++i) {
+      logger.log(LC_AIS, LL_DEBUG, "ais %d from %s", i, "mmsi");
+    }
+    logger.log(LC_GENERAL, LL_INFO, "done %g", 1.5);
+    logger.flush();
+    LogStats stats = logger.stats();
+    CHECK(stats.written == 6);
+    CHECK(stats.dropped == 0);
+    CHECK(stats.suppressed[LC_AIS] == 45);
+    CHECK(stats.suppressed[LC_GENERAL] == 0);
+  }
+
+  std::FILE* file = std::fopen(BINARY_LOG, "rb");
+  CHECK(file != nullptr);
+  if (file == nullptr) return;
+  std::vector<char> data(4096);
+  data.resize(std::fread(data.data(), 1, data.size(), file));
+  std::fclose(file);
+  std::string contents(data.begin(), data.end());
+  CHECK(contents.compare(0, 5, std::string("XLOG\x01", 5)) == 0);
+  // each format string is written once, before its first record
+  CHECK(contents.find("ais %d from %s") != std::string::npos);
+  CHECK(contents.find("ais %d from %s") == contents.rfind("ais %d from %s"));
+  CHECK(contents.find("done %g") != std::string::npos);
+  std::remove(BINARY_LOG);
+}
+
+void test_full_ring_drops() {
+  Logger logger(8);
+  CHECK(logger.open_binary(BINARY_LOG));
+  // the worker may drain some records meanwhile, but not 10000 of them
+  for (int i = 0; i < 10000; ++i) logger.log(LC_GENERAL, LL_INFO, "%d", i);
+  logger.flush();
+  LogStats stats = logger.stats();
+  CHECK(stats.written + stats.dropped == 10000);
+  CHECK(stats.dropped > 0);
+  std::remove(BINARY_LOG);
+}
+
+// The cost on the calling thread of a typical sensor report line
+void benchmark_log_call() {
+  const int CALLS = 20000;
+  const int ROUNDS = 10;
+  double async_ns = 1e9;
+  double sync_ns = 1e9;
+
+  Logger logger(CALLS);
+  CHECK(logger.open_binary(BINARY_LOG));
+  for (int round = 0; round < ROUNDS; ++round) {
+    double ns = xluuv_test::time_per_call(CALLS, [&](int i) {
+      logger.log(LC_SENSORS, LL_DEBUG,
+                 "sensors: lat %f long %f heading %f speed %f depth %f id %d\n",
+                 50.1 + i * 1e-6, -9.9, 251.0, 8.0, 0.0, i);
+    });
+    logger.flush();
+    if (ns < async_ns) async_ns = ns;
+  }
+  CHECK(logger.stats().dropped == 0);
+  std::remove(BINARY_LOG);
+
+  std::FILE* null = std::fopen("/dev/null", "w");
+  CHECK(null != nullptr);
+  if (null == nullptr) return;
+  for (int round = 0; round < ROUNDS; ++round) {
+    double ns = xluuv_test::time_per_call(CALLS, [&](int i) {
+      char line[256];
+      int n = std::snprintf(
+          line, sizeof(line),
+          "sensors: lat %f long %f heading %f speed %f depth %f id %d\n",
+          50.1 + i * 1e-6, -9.9, 251.0, 8.0, 0.0, i);
+      std::fwrite(line, 1, n, null);
+      std::fflush(null);
+    });
+    if (ns < sync_ns) sync_ns = ns;
+  }
+  std::fclose(null);
+
+  std::printf("log call: %.1f ns async, %.1f ns formatted and written\n",
+              async_ns, sync_ns);
+  CHECK(async_ns < sync_ns);
+}
+
+}  // namespace
+
+int main() {
+  test_format();
+  test_levels();
+  test_rate_limit_and_binary();
+  test_full_ring_drops();
+  benchmark_log_call();
+  return xluuv_test::test_exit("async-log-test");
+}
@@ -0,0 +1,59 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+// Checks for the test programs in this directory. A failed check reports
+// where it failed and the program carries on, test_exit() then returns the
+// exit status ctest expects.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace xluuv_test {
+
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+inline int test_exit(const char* name) {
+  if (failures() > 0) {
+    std::fprintf(stderr, "%s: %d check(s) failed\n", name, failures());
+    return 1;
+  }
+  std::printf("%s: passed\n", name);
+  return 0;
+}
+
+// nanoseconds per call of f over n calls
+template <typename F>
+double time_per_call(int n, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; ++i) f(i);
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / n;
+}
+
+}  // namespace xluuv_test
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if (!(condition)) {                                                   \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+                   #condition);                                           \
+      ++::xluuv_test::failures();                                         \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_NEAR(a, b, tolerance)                                        \
+  do {                                                                     \
+    double check_a_ = (a), check_b_ = (b);                                 \
+    if (!(std::fabs(check_a_ - check_b_) <= (tolerance))) {                \
+      std::fprintf(stderr, "%s:%d: check failed: %s = %.9g, %s = %.9g\n",  \
+                   __FILE__, __LINE__, #a, check_a_, #b, check_b_);        \
+      ++::xluuv_test::failures();                                          \
+    }                                                                      \
+  } while (0)
+
+#endif
@@ -0,0 +1,179 @@
+// The lockstep clock between a master and a client in one process: the
+// client is released once the master publishes the time it waits for, it
+// waits for a master that is not there yet, and it gets an error promptly
+// when its master closes or dies while it waits.
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "../cosim/CoSimChannel.h"
+#include "Check.h"
+
+namespace {
+
+const uint64_t MS = 1000000;
+
+// per process, so that parallel ctest runs do not share segments
+std::string segment_name() {
+  return "/xluuv-test-cosim-" + std::to_string(getpid());
+}
+
+// waits on a thread of its own, so that the test can act as the master
+class Follower {
+ public:
+  Follower(CoSimChannel& channel, uint64_t deadline)
+      : result_(PENDING), thread_([this, &channel, deadline] {
+          this->result_ = channel.wait_until(deadline) ? GRANTED : FAILED;
+        }) {}
+  ~Follower() { this->thread_.join(); }
+
+  bool pending() const { return this->result_ == PENDING; }
+
+  // waits up to timeout_ms for the result, returns the ms it took
+  double join(int timeout_ms) {
+    auto start = std::chrono::steady_clock::now();
+    while (this->pending() &&
+           std::chrono::steady_clock::now() - start <
+               std::chrono::milliseconds(timeout_ms)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  }
+  bool granted() const { return this->result_ == GRANTED; }
+
+ private:
+  enum Result { PENDING, GRANTED, FAILED };
+  std::atomic<int> result_;
+  std::thread thread_;
+};
+
+void test_grant() {
+  std::string name = segment_name();
+  shm_unlink(name.c_str());
+  CoSimChannel master;
+  CoSimChannel client;
+  CHECK(!master.open(CoSimChannel::MASTER, name.c_str()));
+  CHECK(!client.open(CoSimChannel::CLIENT, name.c_str()));
+  if (!master.is_open() || !client.is_open()) return;
+  master.publish(1000 * MS);
+  CHECK(!client.attach());
+  CHECK(master.clients() == 1);
+
+  {
+    Follower follower(client, 1050 * MS);
+    // the client blocks for the next step, so the master may grant it
+    CHECK(master.wait_settled(1000));
+    CHECK(follower.pending());
+    // a message in flight holds the master
+    client.count_sent(COSIM_ACTUATORS);
+    CHECK(!master.settled());
+    client.count_received(COSIM_ACTUATORS);
+    CHECK(master.settled());
+    master.publish(1050 * MS);
+    follower.join(1000);
+    CHECK(follower.granted());
+  }
+  client.close();
+  CHECK(master.clients() == 0);
+  master.close();
+  shm_unlink(name.c_str());
+}
+
+// the autopilot may be started before BC
+void test_master_later() {
+  std::string name = segment_name();
+  shm_unlink(name.c_str());
+  CoSimChannel client;
+  CHECK(!client.open(CoSimChannel::CLIENT, name.c_str()));
+  if (!client.is_open()) return;
+  CHECK(!client.attach());
+  {
+    Follower follower(client, 1000 * MS);
+    // past a few of the regular checks on the master
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    CHECK(follower.pending());
+    CoSimChannel master;
+    CHECK(!master.open(CoSimChannel::MASTER, name.c_str()));
+    master.publish(1000 * MS);
+    follower.join(1000);
+    CHECK(follower.granted());
+    client.close();
+  }
+  shm_unlink(name.c_str());
+}
+
+// BC quits while the autopilot waits for the next step
+void test_master_closes() {
+  std::string name = segment_name();
+  shm_unlink(name.c_str());
+  CoSimChannel master;
+  CoSimChannel client;
+  CHECK(!master.open(CoSimChannel::MASTER, name.c_str()));
+  CHECK(!client.open(CoSimChannel::CLIENT, name.c_str()));
+  if (!master.is_open() || !client.is_open()) return;
+  master.publish(1000 * MS);
+  CHECK(!client.attach());
+  {
+    Follower follower(client, 1050 * MS);
+    CHECK(master.wait_settled(1000));
+    master.close();
+    double ms = follower.join(2000);
+    std::printf("master closed: follower released after %.2f ms\n", ms);
+    CHECK(!follower.pending());
+    CHECK(!follower.granted());
+    // woken by the close, not by the regular check on the master
+    CHECK(ms < 50.0);
+  }
+  // and it does not block on the next wait either
+  CHECK(!client.wait_until(1100 * MS));
+  client.close();
+  shm_unlink(name.c_str());
+}
+
+// BC crashes, its pid is left in the segment
+void test_master_dies() {
+  std::string name = segment_name();
+  shm_unlink(name.c_str());
+  CoSimChannel client;
+  CHECK(!client.open(CoSimChannel::CLIENT, name.c_str()));
+  if (!client.is_open()) return;
+  CHECK(!client.attach());
+  pid_t pid = fork();
+  if (pid == 0) {
+    CoSimChannel master;
+    if (master.open(CoSimChannel::MASTER, name.c_str())) _exit(2);
+    master.publish(1000 * MS);
+    _exit(0);  // without closing the channel
+  }
+  CHECK(pid > 0);
+  int status = -1;
+  waitpid(pid, &status, 0);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  {
+    Follower follower(client, 1050 * MS);
+    follower.join(2000);
+    CHECK(!follower.pending());
+    CHECK(!follower.granted());
+  }
+  client.close();
+  shm_unlink(name.c_str());
+}
+
+}  // namespace
+
+int main() {
+  test_grant();
+  test_master_later();
+  test_master_closes();
+  test_master_dies();
+  return xluuv_test::test_exit("cosim-channel-test");
+}
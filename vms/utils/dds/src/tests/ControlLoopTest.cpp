@@ -0,0 +1,137 @@
+// The control loop on a simulated clock: whole encounters repeat exactly for
+// a seed, cycles are released on the fixed grid and an overrun skips the
+// periods it covered. The PID anti-windup is checked on saturated outputs.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "../AsyncLog.h"
+#include "../autopilot/ControlClock.h"
+#include "../autopilot/LoopScheduler.h"
+#include "../autopilot/PidController.h"
+#include "../colregbench/Encounter.h"
+#include "Check.h"
+
+namespace {
+
+const ACE_hrtime_t MS = 1000000;
+const ACE_hrtime_t PERIOD = 250 * MS;
+
+// the same seed gives the same run, down to the last bit
+void test_deterministic_encounters() {
+  for (int type = 0; type < ET_COUNT; ++type) {
+    CpuHistogram cpu;
+    EncounterResult a =
+        run_encounter(static_cast<EncounterType>(type), 42, cpu);
+    EncounterResult b =
+        run_encounter(static_cast<EncounterType>(type), 42, cpu);
+    CHECK(a.cycles > 0);
+    CHECK(a.cycles == b.cycles);
+    CHECK(a.min_separation == b.min_separation);
+    CHECK(a.threat == b.threat);
+    CHECK(a.acted == b.acted);
+    CHECK(a.decision_latency == b.decision_latency);
+  }
+}
+
+void test_fixed_grid() {
+  SimulatedClock clock;
+  LoopScheduler scheduler(clock, PERIOD);
+  ACE_hrtime_t start = 0;
+  for (int i = 0; i < 200; ++i) {
+    ACE_hrtime_t now = scheduler.begin_cycle();
+    if (i == 0) start = now;
+    // cycle times vary, the releases must not
+    CHECK(now == start + i * PERIOD);
+    clock.advance((i % 7) * 20 * MS);
+    scheduler.end_cycle();
+  }
+  CHECK(scheduler.cycles() == 200);
+  CHECK(scheduler.overruns() == 0);
+  CHECK(scheduler.max_jitter() == 0);
+  CHECK(scheduler.max_execution() == 120 * MS);
+}
+
+void test_overrun() {
+  SimulatedClock clock;
+  LoopScheduler scheduler(clock, PERIOD);
+  ACE_hrtime_t start = scheduler.begin_cycle();
+  scheduler.end_cycle();
+
+  // running exactly up to the next release is not an overrun
+  CHECK(scheduler.begin_cycle() == start + PERIOD);
+  clock.advance(PERIOD);
+  scheduler.end_cycle();
+  CHECK(scheduler.overruns() == 0);
+
+  // 600 ms from the release at 500 ms covers the ones at 750 and 1000 ms
+  CHECK(scheduler.begin_cycle() == start + 2 * PERIOD);
+  clock.advance(600 * MS);
+  scheduler.end_cycle();
+  CHECK(scheduler.overruns() == 1);
+  CHECK(scheduler.skipped() == 2);
+
+  // and the loop resumes on the grid
+  CHECK(scheduler.begin_cycle() == start + 5 * PERIOD);
+  scheduler.end_cycle();
+  CHECK(scheduler.begin_cycle() == start + 6 * PERIOD);
+  scheduler.end_cycle();
+  CHECK(scheduler.overruns() == 1);
+  CHECK(scheduler.cycles() == 5);
+}
+
+// Runs the controller for a number of cycles against a fixed error
+double run_pid(PidController& pid, SimulatedClock& clock, double error,
+               int cycles) {
+  double output = 0.0;
+  for (int i = 0; i < cycles; ++i) {
+    output = pid.control(0.0, error, clock.now());
+    clock.advance(PERIOD);
+  }
+  return output;
+}
+
+void test_anti_windup() {
+  SimulatedClock clock;
+
+  // held deep in saturation for 100 s, the integral must not wind up, so
+  // the output leaves the limit on the first cycle the error reverses
+  PidController saturated(0.1, 0.05, 0.0, -1.0, 1.0);
+  CHECK(run_pid(saturated, clock, 100.0, 400) == 1.0);
+  double reversed = run_pid(saturated, clock, -5.0, 1);
+  CHECK(reversed < 0.0);
+  CHECK_NEAR(reversed, 0.1 * -5.0 + 0.05 * -5.0 * 0.25, 1e-9);
+
+  // an integral that drives the output into the limit stops there, and a
+  // small reversal moves the output straight back
+  PidController integrating(0.0, 1.0, 0.0, -1.0, 1.0);
+  CHECK(run_pid(integrating, clock, 0.5, 400) == 1.0);
+  CHECK_NEAR(run_pid(integrating, clock, -0.1, 1), 1.0 - 0.1 * 0.25, 1e-9);
+
+  // integrating away from the limit is not held
+  PidController inside(0.0, 1.0, 0.0, -1.0, 1.0);
+  CHECK_NEAR(run_pid(inside, clock, 0.5, 5), 4 * 0.5 * 0.25, 1e-9);
+
+  // a gap longer than the timeout starts the integral over
+  clock.advance(20000 * MS);
+  CHECK(run_pid(inside, clock, 0.5, 1) == 0.0);
+
+  // angular errors take the short way round
+  AngularPidController heading(0.01, 0.0, 0.0, -1.0, 1.0);
+  CHECK_NEAR(heading.control(350.0, 10.0, clock.now()), 0.2, 1e-9);
+  CHECK_NEAR(heading.control(10.0, 350.0, clock.now()), -0.2, 1e-9);
+}
+
+}  // namespace
+
+int main() {
+  // the controller logs every cycle at debug level
+  if (std::getenv("XLUUV_LOG") == nullptr) {
+    xluuv_log::Logger::instance().configure("all=warning");
+  }
+  test_deterministic_encounters();
+  test_fixed_grid();
+  test_overrun();
+  test_anti_windup();
+  return xluuv_test::test_exit("control-loop-test");
+}
@@ -0,0 +1,167 @@
+// CpaBatch against the stepped search it replaced and against hand-computed
+// head-on, crossing and overtaking encounters, and the cost per target of
+// both.
+
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "../autopilot/CpaEngine.h"
+#include "../autopilot/Marmaths.h"
+#include "Check.h"
+
+namespace {
+
+// The search execute_colreg used to do: step own ship and the target
+// forward a second at a time for up to 64 s, and keep the closest sample
+void stepped_cpa(double rel_north, double rel_east, double vel_north,
+                 double vel_east, double own_course, double own_speed,
+                 double& dcpa, double& tcpa) {
+  double own_north, own_east;
+  std::tie(own_north, own_east) = polar_to_cartesian(own_course, own_speed);
+  dcpa = DBL_MAX;
+  tcpa = 0;
+  for (int i = 0; i < 65; ++i) {
+    double distance = std::sqrt(std::pow(own_north * i - rel_north, 2) +
+                                std::pow(own_east * i - rel_east, 2));
+    if (distance >= dcpa) break;
+    dcpa = distance;
+    tcpa = i;
+    rel_north += vel_north;
+    rel_east += vel_east;
+  }
+}
+
+struct Encounter {
+  double rel_north, rel_east, vel_north, vel_east, own_course, own_speed;
+};
+
+std::vector<Encounter> random_encounters(int n) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> position(-750, 750);
+  std::uniform_real_distribution<double> speed(0, 12);
+  std::uniform_real_distribution<double> angle(0, 360);
+  std::vector<Encounter> encounters;
+  for (int i = 0; i < n; ++i) {
+    Encounter e;
+    e.rel_north = position(rng);
+    e.rel_east = position(rng);
+    std::tie(e.vel_north, e.vel_east) =
+        polar_to_cartesian(angle(rng), speed(rng));
+    e.own_course = angle(rng);
+    e.own_speed = speed(rng);
+    encounters.push_back(e);
+  }
+  return encounters;
+}
+
+void test_against_stepped() {
+  std::vector<Encounter> encounters = random_encounters(100000);
+  int compared = 0;
+  double worst_gap = 0;
+  for (const Encounter& e : encounters) {
+    CpaBatch batch;
+    batch.add(e.rel_north, e.rel_east, e.vel_north, e.vel_east);
+    batch.solve(e.own_course, e.own_speed);
+    double dcpa, tcpa;
+    stepped_cpa(e.rel_north, e.rel_east, e.vel_north, e.vel_east,
+                e.own_course, e.own_speed, dcpa, tcpa);
+    // past its horizon the stepped search has no answer to compare with
+    if (batch.tcpa(0) > 63) continue;
+    ++compared;
+    // it samples whole seconds, so it can only overshoot the true minimum
+    // and be up to a second off in time
+    CHECK(dcpa + 1e-9 >= batch.dcpa(0));
+    CHECK(std::fabs(tcpa - batch.tcpa(0)) <= 1.0 + 1e-9);
+    worst_gap = std::max(worst_gap, dcpa - batch.dcpa(0));
+  }
+  std::printf("%d encounters compared with the stepped search, it "
+              "overshot by up to %.2f m\n",
+              compared, worst_gap);
+  CHECK(compared > 80000);
+  CHECK(worst_gap < 10.0);
+}
+
+void test_analytic() {
+  CpaBatch batch;
+  // head-on: 1000 m ahead, closing at 10 m/s
+  batch.add(1000, 0, -5, 0);
+  // crossing from starboard at right angles, passes 500 m astern
+  batch.add(0, 500, 0, -5);
+  // overtaking a slower target 10 m off the track, beyond the old 64 s
+  // horizon
+  batch.add(200, 10, 2, 0);
+  // target astern and opening
+  batch.add(-100, 0, 0, 0);
+  // own ship heading north at 5 m/s
+  batch.solve(0.0, 5.0);
+
+  CHECK_NEAR(batch.tcpa(0), 100.0, 1e-9);
+  CHECK_NEAR(batch.dcpa(0), 0.0, 1e-9);
+  CHECK(batch.bow_crossing_time(0) < 0);  // already on the heading line
+
+  CHECK_NEAR(batch.tcpa(1), 50.0, 1e-9);
+  CHECK_NEAR(batch.dcpa(1), 250.0 * std::sqrt(2.0), 1e-9);
+  CHECK_NEAR(batch.bow_crossing_time(1), 100.0, 1e-9);
+  CHECK_NEAR(batch.bow_crossing_range(1), -500.0, 1e-9);
+
+  CHECK_NEAR(batch.tcpa(2), 200.0 / 3.0, 1e-9);
+  CHECK_NEAR(batch.dcpa(2), 10.0, 1e-9);
+  CHECK(batch.bow_crossing_time(2) < 0);  // runs parallel to it
+
+  CHECK_NEAR(batch.tcpa(3), 0.0, 1e-9);
+  CHECK_NEAR(batch.dcpa(3), 100.0, 1e-9);
+
+  // nothing moves relative to own ship
+  CpaBatch still;
+  still.add(300, 400, 0, 5);
+  still.solve(90.0, 5.0);
+  CHECK_NEAR(still.tcpa(0), 0.0, 1e-9);
+  CHECK_NEAR(still.dcpa(0), 500.0, 1e-9);
+}
+
+// Cost per target of a COLREG cycle with 64 targets in range
+void benchmark() {
+  const int TARGETS = 64;
+  const int CYCLES = 2000;
+  std::vector<Encounter> encounters = random_encounters(TARGETS);
+  double checksum = 0;
+
+  CpaBatch batch;
+  batch.reserve(TARGETS);
+  double batch_ns = xluuv_test::time_per_call(CYCLES, [&](int) {
+    batch.clear();
+    for (const Encounter& e : encounters) {
+      batch.add(e.rel_north, e.rel_east, e.vel_north, e.vel_east);
+    }
+    batch.solve(encounters[0].own_course, encounters[0].own_speed);
+    checksum += batch.dcpa(TARGETS - 1);
+  }) / TARGETS;
+
+  double stepped_ns = xluuv_test::time_per_call(CYCLES, [&](int) {
+    for (const Encounter& e : encounters) {
+      double dcpa, tcpa;
+      stepped_cpa(e.rel_north, e.rel_east, e.vel_north, e.vel_east,
+                  encounters[0].own_course, encounters[0].own_speed, dcpa,
+                  tcpa);
+      checksum += dcpa;
+    }
+  }) / TARGETS;
+
+  std::printf("per target: %.1f ns closed form, %.1f ns stepped (%g)\n",
+              batch_ns, stepped_ns, checksum);
+  CHECK(batch_ns < stepped_ns);
+}
+
+}  // namespace
+
+int main() {
+  test_against_stepped();
+  test_analytic();
+  benchmark();
+  return xluuv_test::test_exit("cpa-engine-test");
+}
@@ -0,0 +1,217 @@
+// LocalFrame distances and bearings against distance_harvesine() and
+// relative_bearing() around the mission area and at the edges of the planar
+// approximation, and the cost of both.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../autopilot/LocalFrame.h"
+#include "../autopilot/Marmaths.h"
+#include "Check.h"
+
+namespace {
+
+// the bounds LocalFrame.h documents
+const double MAX_RELATIVE_DISTANCE_ERROR = 1e-5;
+const double MAX_BEARING_ERROR = 0.001;
+// LocalFrame::PLANAR_RANGE and MAX_PLANAR_LAT
+const double PLANAR_RANGE = 10000.0;
+const double MAX_PLANAR_LAT = 75.0;
+
+// where the encounters of colreg-bench and control-loop-test take place
+const double MISSION_LAT = 54.3;
+const double MISSION_LON = 10.1;
+
+struct Pair {
+  EnuPoint from;
+  EnuPoint to;
+};
+
+// angle between two bearings in degrees, whichever way round is shorter
+double angle_between(double a, double b) {
+  double d = std::fmod(std::fabs(a - b), 360.0);
+  return std::min(d, 360.0 - d);
+}
+
+// pairs of points at up to max_range from the anchor, at least a meter
+// apart so the bearing is defined
+std::vector<Pair> random_pairs(int n, double max_range, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  auto point = [&]() {
+    double r = max_range * std::sqrt(unit(rng));
+    double a = 2.0 * M_PI * unit(rng);
+    return EnuPoint{r * std::sin(a), r * std::cos(a)};
+  };
+  std::vector<Pair> pairs;
+  while (static_cast<int>(pairs.size()) < n) {
+    Pair p{point(), point()};
+    if (std::hypot(p.to.east - p.from.east, p.to.north - p.from.north) < 1.0) {
+      continue;
+    }
+    pairs.push_back(p);
+  }
+  return pairs;
+}
+
+struct Errors {
+  double distance = 0.0;  // relative
+  double bearing = 0.0;   // degrees
+};
+
+// the largest errors of the frame against Marmaths over the pairs, both
+// given the same geodetic points
+Errors compare(const LocalFrame& frame, const std::vector<Pair>& pairs) {
+  Errors worst;
+  for (const Pair& p : pairs) {
+    double lat_a, lon_a, lat_b, lon_b;
+    frame.to_geodetic(p.from, lat_a, lon_a);
+    frame.to_geodetic(p.to, lat_b, lon_b);
+    EnuPoint from = frame.to_local(lat_a, lon_a);
+    EnuPoint to = frame.to_local(lat_b, lon_b);
+
+    double reference = distance_harvesine(lat_a, lon_a, lat_b, lon_b);
+    worst.distance =
+        std::max(worst.distance,
+                 std::fabs(frame.distance(from, to) - reference) / reference);
+    worst.bearing = std::max(
+        worst.bearing,
+        angle_between(frame.bearing(0.0, from, to),
+                      relative_bearing(0.0, lat_a, lon_a, lat_b, lon_b)));
+  }
+  return worst;
+}
+
+void check_within_bounds(const char* area, double lat, double lon,
+                         double max_range) {
+  LocalFrame frame;
+  frame.anchor(lat, lon);
+  Errors worst = compare(frame, random_pairs(20000, max_range, 3));
+  std::printf("%-22s %8.0f m: %.2e relative distance, %.6f deg bearing\n",
+              area, max_range, worst.distance, worst.bearing);
+  CHECK(worst.distance <= MAX_RELATIVE_DISTANCE_ERROR);
+  CHECK(worst.bearing <= MAX_BEARING_ERROR);
+}
+
+void test_mission_area() {
+  check_within_bounds("mission area", MISSION_LAT, MISSION_LON, 750.0);
+  check_within_bounds("mission area", MISSION_LAT, MISSION_LON, 2000.0);
+  check_within_bounds("mission area", MISSION_LAT, MISSION_LON,
+                      PLANAR_RANGE * 0.999);
+}
+
+void test_other_latitudes() {
+  check_within_bounds("equator", 0.0, 0.0, PLANAR_RANGE * 0.999);
+  check_within_bounds("southern hemisphere", -41.3, 174.8,
+                      PLANAR_RANGE * 0.999);
+  check_within_bounds("date line", 65.0, 179.95, PLANAR_RANGE * 0.999);
+  check_within_bounds("below planar limit", MAX_PLANAR_LAT - 0.01, 10.0,
+                      PLANAR_RANGE * 0.999);
+}
+
+// both points either side of PLANAR_RANGE: inside the frame is planar and
+// within bounds, outside it gives exactly what Marmaths gives
+void test_range_edge() {
+  LocalFrame frame;
+  frame.anchor(MISSION_LAT, MISSION_LON);
+  const double inside = PLANAR_RANGE - 1.0;
+  const double outside = PLANAR_RANGE + 1.0;
+  for (int i = 0; i < 360; ++i) {
+    double a = i * DEG_TO_RAD;
+    EnuPoint own{0.0, 0.0};
+    EnuPoint near{inside * std::sin(a), inside * std::cos(a)};
+    EnuPoint far{outside * std::sin(a), outside * std::cos(a)};
+    double lat_own, lon_own, lat_near, lon_near, lat_far, lon_far;
+    frame.to_geodetic(own, lat_own, lon_own);
+    frame.to_geodetic(near, lat_near, lon_near);
+    frame.to_geodetic(far, lat_far, lon_far);
+
+    double reference =
+        distance_harvesine(lat_own, lon_own, lat_near, lon_near);
+    CHECK(std::fabs(frame.distance(own, near) - reference) / reference <=
+          MAX_RELATIVE_DISTANCE_ERROR);
+    CHECK(angle_between(frame.bearing(0.0, own, near),
+                        relative_bearing(0.0, lat_own, lon_own, lat_near,
+                                         lon_near)) <= MAX_BEARING_ERROR);
+
+    // either end outside falls back
+    CHECK_NEAR(frame.distance(own, far),
+               distance_harvesine(lat_own, lon_own, lat_far, lon_far), 1e-9);
+    CHECK_NEAR(frame.distance(far, own),
+               distance_harvesine(lat_far, lon_far, lat_own, lon_own), 1e-9);
+    CHECK_NEAR(frame.bearing(30.0, own, far),
+               relative_bearing(30.0, lat_own, lon_own, lat_far, lon_far),
+               1e-9);
+    CHECK_NEAR(frame.bearing(30.0, far, near),
+               relative_bearing(30.0, lat_far, lon_far, lat_near, lon_near),
+               1e-9);
+  }
+}
+
+// a frame anchored at or past MAX_PLANAR_LAT always falls back, one just
+// below stays within bounds (test_other_latitudes)
+void test_latitude_edge() {
+  const double lats[] = {MAX_PLANAR_LAT, MAX_PLANAR_LAT + 5.0,
+                         -MAX_PLANAR_LAT, -MAX_PLANAR_LAT - 5.0};
+  for (double lat : lats) {
+    LocalFrame frame;
+    frame.anchor(lat, 10.0);
+    for (const Pair& p : random_pairs(1000, 2000.0, 5)) {
+      double lat_a, lon_a, lat_b, lon_b;
+      frame.to_geodetic(p.from, lat_a, lon_a);
+      frame.to_geodetic(p.to, lat_b, lon_b);
+      CHECK_NEAR(frame.distance(p.from, p.to),
+                 distance_harvesine(lat_a, lon_a, lat_b, lon_b), 1e-9);
+      CHECK_NEAR(frame.bearing(0.0, p.from, p.to),
+                 relative_bearing(0.0, lat_a, lon_a, lat_b, lon_b), 1e-9);
+    }
+  }
+}
+
+// Cost of a distance and a bearing between points already projected, as
+// execute_colreg asks for them, against the spherical functions on the
+// geodetic positions
+void benchmark() {
+  const int PAIRS = 1024;
+  const int CALLS = 2000000;
+  LocalFrame frame;
+  frame.anchor(MISSION_LAT, MISSION_LON);
+  std::vector<Pair> pairs = random_pairs(PAIRS, 750.0, 11);
+  std::vector<double> geodetic;
+  for (const Pair& p : pairs) {
+    double lat_a, lon_a, lat_b, lon_b;
+    frame.to_geodetic(p.from, lat_a, lon_a);
+    frame.to_geodetic(p.to, lat_b, lon_b);
+    geodetic.insert(geodetic.end(), {lat_a, lon_a, lat_b, lon_b});
+  }
+  double checksum = 0;
+
+  double frame_ns = xluuv_test::time_per_call(CALLS, [&](int i) {
+    const Pair& p = pairs[i % PAIRS];
+    checksum += frame.distance(p.from, p.to) + frame.bearing(0.0, p.from, p.to);
+  });
+  double spherical_ns = xluuv_test::time_per_call(CALLS, [&](int i) {
+    const double* g = &geodetic[4 * (i % PAIRS)];
+    checksum += distance_harvesine(g[0], g[1], g[2], g[3]) +
+                relative_bearing(0.0, g[0], g[1], g[2], g[3]);
+  });
+
+  std::printf("distance and bearing: %.1f ns local frame, %.1f ns "
+              "spherical (%g)\n",
+              frame_ns, spherical_ns, checksum);
+  CHECK(frame_ns < spherical_ns);
+}
+
+}  // namespace
+
+int main() {
+  test_mission_area();
+  test_other_latitudes();
+  test_range_edge();
+  test_latitude_edge();
+  benchmark();
+  return xluuv_test::test_exit("local-frame-test");
+}
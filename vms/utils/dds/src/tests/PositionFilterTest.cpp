@@ -0,0 +1,187 @@
+// Replays 30 minutes of noisy GNSS at 4 Hz through both position filters,
+// clean and with one source spoofed, and compares their errors against the
+// true track. Also checks that the Kalman filter restarts when every source
+// jumps at once, and measures the cost of an update.
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "../autopilot/GnssKalmanFilter.h"
+#include "../autopilot/LocalFrame.h"
+#include "../autopilot/Marmaths.h"
+#include "../autopilot/PositionEstimator.h"
+#include "Check.h"
+
+namespace {
+
+const ACE_hrtime_t PERIOD = 250000000ull;
+const int CYCLES = 30 * 60 * 4;
+const double GNSS_SIGMA = 3.0;
+const double ORIGIN_LAT = 54.3;
+const double ORIGIN_LON = 10.1;
+
+struct Sample {
+  PhysicalState::Sensors sensors;
+  EnuPoint truth;
+};
+
+// moves a fix of the given source at the given time, in meters
+typedef std::function<void(int source, double t, EnuPoint& fix)> Fault;
+
+// Own ship at 4 m/s, slowly weaving around a course of 60 degrees. The fixes
+// are sent as floats, as BC does.
+std::vector<Sample> make_stream(const LocalFrame& frame, const Fault& fault,
+                                unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::normal_distribution<double> noise(0.0, GNSS_SIGMA);
+  std::vector<Sample> stream(CYCLES);
+  EnuPoint own{0.0, 0.0};
+  const double speed = 4.0;
+  for (int i = 0; i < CYCLES; ++i) {
+    double t = i * PERIOD * 1e-9;
+    double course = 60.0 + 20.0 * std::sin(t / 120.0);
+    own.east += speed * 0.25 * std::sin(course * DEG_TO_RAD);
+    own.north += speed * 0.25 * std::cos(course * DEG_TO_RAD);
+
+    Sample& sample = stream[i];
+    sample.truth = own;
+    sample.sensors = PhysicalState::Sensors();
+    PhysicalState::Coordinates* fixes[] = {&sample.sensors.gnss_1,
+                                           &sample.sensors.gnss_2,
+                                           &sample.sensors.gnss_3};
+    for (int source = 0; source < 3; ++source) {
+      EnuPoint fix{own.east + noise(rng), own.north + noise(rng)};
+      if (fault) fault(source, t, fix);
+      frame.to_geodetic(fix, fixes[source]->latitude,
+                        fixes[source]->longitude);
+      fixes[source]->latitude = static_cast<float>(fixes[source]->latitude);
+      fixes[source]->longitude = static_cast<float>(fixes[source]->longitude);
+    }
+    sample.sensors.course_over_ground = course;
+    sample.sensors.heading = course;
+    sample.sensors.speed_over_ground = speed;
+    sample.sensors.speed = speed;
+  }
+  return stream;
+}
+
+struct Errors {
+  double rms;
+  double max;
+};
+
+// errors from the first cycle after skip onwards
+Errors replay(PositionEstimator& estimator, const LocalFrame& frame,
+              const std::vector<Sample>& stream, int skip = 0) {
+  double sum = 0.0;
+  double max = 0.0;
+  int count = 0;
+  for (int i = 0; i < CYCLES; ++i) {
+    Autopilot::Coordinates estimate =
+        estimator.update(stream[i].sensors, (i + 1) * PERIOD);
+    if (i < skip) continue;
+    double error = frame.distance(
+        frame.to_local(estimate.latitude, estimate.longitude),
+        stream[i].truth);
+    sum += error * error;
+    if (error > max) max = error;
+    ++count;
+  }
+  return {std::sqrt(sum / count), max};
+}
+
+// replays the stream through both filters, returns the Kalman filter's
+// errors
+Errors compare(const char* name, const LocalFrame& frame,
+               const std::vector<Sample>& stream) {
+  MedianVotingEstimator median;
+  GnssKalmanFilter kalman;
+  Errors median_errors = replay(median, frame, stream);
+  Errors kalman_errors = replay(kalman, frame, stream);
+  std::printf("%-32s median %5.2f/%5.2f m, kalman %5.2f/%5.2f m\n", name,
+              median_errors.rms, median_errors.max, kalman_errors.rms,
+              kalman_errors.max);
+  CHECK(kalman_errors.rms < median_errors.rms);
+  return kalman_errors;
+}
+
+void test_noisy_and_spoofed(const LocalFrame& frame) {
+  std::printf("RMS/max error over %d cycles:\n", CYCLES);
+  Errors nominal = compare("nominal", frame, make_stream(frame, Fault(), 1));
+  CHECK(nominal.rms < 1.0);
+
+  // one source jumps away and stays there
+  Errors jump = compare("one source jumps 170 m", frame,
+                        make_stream(frame,
+                                    [](int source, double t, EnuPoint& fix) {
+                                      if (source == 1 && t > 300.0) {
+                                        fix.east += 120.0;
+                                        fix.north += 120.0;
+                                      }
+                                    },
+                                    2));
+  CHECK(jump.rms < 1.0);
+  CHECK(jump.max < 5.0);
+
+  // one source is dragged off slowly, as a spoofer would
+  Errors drift = compare("one source drifts at 0.5 m/s", frame,
+                         make_stream(frame,
+                                     [](int source, double t, EnuPoint& fix) {
+                                       if (source == 2 && t > 300.0) {
+                                         fix.north += 0.5 * (t - 300.0);
+                                       }
+                                     },
+                                     3));
+  CHECK(drift.rms < 1.5);
+  CHECK(drift.max < 10.0);
+}
+
+// all sources move 200 m for 100 s, the filter has to follow them there and
+// back by restarting
+void test_restart(const LocalFrame& frame) {
+  std::vector<Sample> stream = make_stream(
+      frame,
+      [](int, double t, EnuPoint& fix) {
+        if (t > 600.0 && t < 700.0) fix.east += 200.0;
+      },
+      4);
+  GnssKalmanFilter kalman;
+  // from 60 s after the sources came back
+  Errors after = replay(kalman, frame, stream, 760 * 4);
+  std::printf("all sources jump for 100 s: %llu restarts, %.2f/%.2f m "
+              "afterwards\n",
+              static_cast<unsigned long long>(kalman.restarts()), after.rms,
+              after.max);
+  CHECK(kalman.restarts() >= 2);
+  CHECK(after.rms < 1.0);
+}
+
+void benchmark_update(const LocalFrame& frame) {
+  std::vector<Sample> stream = make_stream(frame, Fault(), 5);
+  MedianVotingEstimator median;
+  GnssKalmanFilter kalman;
+  double median_ns = xluuv_test::time_per_call(CYCLES, [&](int i) {
+    median.update(stream[i].sensors, (i + 1) * PERIOD);
+  });
+  double kalman_ns = xluuv_test::time_per_call(CYCLES, [&](int i) {
+    kalman.update(stream[i].sensors, (i + 1) * PERIOD);
+  });
+  std::printf("update: median %.0f ns, kalman %.0f ns\n", median_ns,
+              kalman_ns);
+  // a vanishing part of the 250 ms period either way
+  CHECK(kalman_ns < 20000.0);
+}
+
+}  // namespace
+
+int main() {
+  LocalFrame frame;
+  frame.anchor(ORIGIN_LAT, ORIGIN_LON);
+  test_noisy_and_spoofed(frame);
+  test_restart(frame);
+  benchmark_update(frame);
+  return xluuv_test::test_exit("position-filter-test");
+}
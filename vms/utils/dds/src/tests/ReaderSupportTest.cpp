@@ -0,0 +1,162 @@
+// A burst of samples on a state topic and on a command topic, written and
+// read in one participant over the RTPS configuration in rtps.ini. The
+// command reader has to hand over every sample in order, in batches of
+// TAKE_BATCH_SIZE, and the state reader only the latest one.
+//
+// reader-support-test -DCPSConfigFile ../rtps.ini
+
+#include <dds/DCPS/Marked_Default_Qos.h>
+#include <dds/DCPS/Service_Participant.h>
+#include <dds/DCPS/StaticIncludes.h>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../ReaderSupport.h"
+#include "Check.h"
+#include "PhysicalStateTypeSupportImpl.h"
+
+namespace {
+
+const unsigned BURST = 1000;
+
+struct Endpoints {
+  PhysicalState::SensorsDataWriter_var writer;
+  PhysicalState::SensorsDataReader_var reader;
+};
+
+bool create_endpoints(DDS::DomainParticipant_ptr participant,
+                      DDS::Publisher_ptr publisher,
+                      DDS::Subscriber_ptr subscriber, const char* topic_name,
+                      const char* type_name, QosProfile profile,
+                      Endpoints& endpoints) {
+  DDS::Topic_var topic = participant->create_topic(
+      topic_name, type_name, TOPIC_QOS_DEFAULT, 0,
+      OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+  if (!topic) return true;
+
+  DDS::DataWriterQos writer_qos;
+  publisher->get_default_datawriter_qos(writer_qos);
+  apply_profile(writer_qos, profile);
+  DDS::DataWriter_var writer = publisher->create_datawriter(
+      topic, writer_qos, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+
+  DDS::DataReaderQos reader_qos;
+  subscriber->get_default_datareader_qos(reader_qos);
+  apply_profile(reader_qos, profile);
+  DDS::DataReader_var reader = subscriber->create_datareader(
+      topic, reader_qos, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+
+  endpoints.writer = PhysicalState::SensorsDataWriter::_narrow(writer);
+  endpoints.reader = PhysicalState::SensorsDataReader::_narrow(reader);
+  if (!endpoints.writer || !endpoints.reader) return true;
+
+  // wait for discovery to match the two
+  for (int i = 0; i < 1000; ++i) {
+    DDS::PublicationMatchedStatus matched;
+    endpoints.writer->get_publication_matched_status(matched);
+    if (matched.current_count > 0) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return true;
+}
+
+void burst(Endpoints& endpoints) {
+  PhysicalState::Sensors sample = PhysicalState::Sensors();
+  sample.bc_id = 123;
+  for (unsigned i = 0; i < BURST; ++i) {
+    sample.course_over_ground = i;
+    CHECK(endpoints.writer->write(sample, DDS::HANDLE_NIL) ==
+          DDS::RETCODE_OK);
+  }
+}
+
+std::vector<double> take_burst(Endpoints& endpoints, ReaderStats& stats) {
+  std::vector<double> taken;
+  CHECK(!take_all<PhysicalState::SensorsSeq>(
+      endpoints.reader.in(), stats,
+      [&taken](const PhysicalState::Sensors& sample, const DDS::SampleInfo&) {
+        taken.push_back(sample.course_over_ground);
+      }));
+  return taken;
+}
+
+void run(DDS::DomainParticipant_ptr participant) {
+  PhysicalState::SensorsTypeSupport_var type_support =
+      new PhysicalState::SensorsTypeSupportImpl();
+  CHECK(type_support->register_type(participant, "") == DDS::RETCODE_OK);
+  CORBA::String_var type_name = type_support->get_type_name();
+
+  DDS::Publisher_var publisher = participant->create_publisher(
+      PUBLISHER_QOS_DEFAULT, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+  DDS::Subscriber_var subscriber = participant->create_subscriber(
+      SUBSCRIBER_QOS_DEFAULT, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+  CHECK(publisher && subscriber);
+  if (!publisher || !subscriber) return;
+
+  Endpoints state;
+  Endpoints command;
+  CHECK(!create_endpoints(participant, publisher, subscriber, "Burst State",
+                          type_name, QOS_STATE, state));
+  CHECK(!create_endpoints(participant, publisher, subscriber, "Burst Command",
+                          type_name, QOS_COMMAND, command));
+  if (!state.reader || !command.reader) return;
+
+  burst(state);
+  burst(command);
+  DDS::Duration_t timeout = {10, 0};
+  CHECK(command.writer->wait_for_acknowledgments(timeout) == DDS::RETCODE_OK);
+  // best effort has nothing to acknowledge, give it time to arrive
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  ReaderStats command_stats("Burst Command");
+  std::vector<double> commands = take_burst(command, command_stats);
+  CHECK(commands.size() == BURST);
+  for (size_t i = 0; i < commands.size(); ++i) CHECK(commands[i] == i);
+  // full batches and a short one that ends the take
+  CHECK(command_stats.batches() == (BURST + TAKE_BATCH_SIZE - 1) /
+                                       TAKE_BATCH_SIZE);
+  CHECK(command_stats.samples() == BURST);
+
+  ReaderStats state_stats("Burst State");
+  std::vector<double> states = take_burst(state, state_stats);
+  CHECK(states.size() == 1);
+  CHECK(!states.empty() && states.back() == BURST - 1);
+  CHECK(state_stats.batches() == 1);
+
+  std::printf("burst of %u: command reader took %zu in %llu take() calls, "
+              "state reader took %zu\n",
+              BURST, commands.size(),
+              static_cast<unsigned long long>(command_stats.batches()),
+              states.size());
+
+  // nothing left behind
+  CHECK(take_burst(command, command_stats).empty());
+  CHECK(take_burst(state, state_stats).empty());
+}
+
+}  // namespace
+
+int ACE_TMAIN(int argc, ACE_TCHAR* argv[]) {
+  try {
+    DDS::DomainParticipantFactory_var dpf =
+        TheParticipantFactoryWithArgs(argc, argv);
+    // a domain of its own, away from a running simulation
+    DDS::DomainParticipant_var participant = dpf->create_participant(
+        77, PARTICIPANT_QOS_DEFAULT, 0, OpenDDS::DCPS::DEFAULT_STATUS_MASK);
+    if (!participant) {
+      std::fprintf(stderr, "create_participant failed\n");
+      return 1;
+    }
+    run(participant);
+    participant->delete_contained_entities();
+    dpf->delete_participant(participant);
+    TheServiceParticipant->shutdown();
+  } catch (const CORBA::Exception& e) {
+    e._tao_print_exception("Exception caught in main():");
+    return 1;
+  }
+  return xluuv_test::test_exit("reader-support-test");
+}
@@ -0,0 +1,222 @@
+// Route tracking over a closed loop, routes with zero length legs and a
+// route of 5000 waypoints: legs are followed in order, closed loops are not
+// cut short when rejoining, duplicate waypoints are skipped, and building
+// and tracking stay cheap for large routes.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../autopilot/LocalFrame.h"
+#include "../autopilot/RouteGeometry.h"
+#include "Check.h"
+
+namespace {
+
+const double TURN_RADIUS = 60.0;
+const double CELL_DEG = 0.01;
+const double LOOKAHEAD = 60.0;
+
+LocalFrame make_frame() {
+  LocalFrame frame;
+  frame.anchor(54.3, 10.1);
+  return frame;
+}
+
+Autopilot::WaypointSeq make_route(const LocalFrame& frame,
+                                  const std::vector<EnuPoint>& points) {
+  Autopilot::WaypointSeq waypoints;
+  waypoints.length(points.size());
+  for (CORBA::ULong i = 0; i < waypoints.length(); ++i) {
+    frame.to_geodetic(points[i], waypoints[i].coords.latitude,
+                      waypoints[i].coords.longitude);
+  }
+  return waypoints;
+}
+
+RouteProgress track(RouteGeometry& route, const LocalFrame& frame,
+                    EnuPoint position) {
+  double lat, lon;
+  frame.to_geodetic(position, lat, lon);
+  return route.track(lat, lon, LOOKAHEAD);
+}
+
+// a square that ends where it starts
+void test_closed_loop() {
+  const double SIDE = 1900.0;
+  LocalFrame frame = make_frame();
+  RouteGeometry route(TURN_RADIUS, CELL_DEG);
+  route.build(make_route(
+      frame, {{0, 0}, {SIDE, 0}, {SIDE, SIDE}, {0, SIDE}, {0, 0}}));
+  // each leg split in two
+  CHECK(route.segments() == 8);
+  // measured in the tangent plane of each segment
+  CHECK_NEAR(route.length(), 4 * SIDE, 2.0);
+
+  // go round 10 m inside the loop, the legs come in order and none is
+  // skipped although the start and the end of the loop coincide
+  route.seek(1);
+  CORBA::ULong waypoint = 1;
+  bool in_order = true;
+  bool on_track = true;
+  for (double t = 0.0; t < 4 * SIDE - 100.0; t += 5.0) {
+    EnuPoint position;
+    if (t < SIDE) {
+      position = {t, 10.0};
+    } else if (t < 2 * SIDE) {
+      position = {SIDE - 10.0, t - SIDE};
+    } else if (t < 3 * SIDE) {
+      position = {3 * SIDE - t, SIDE - 10.0};
+    } else {
+      position = {10.0, 4 * SIDE - t};
+    }
+    RouteProgress progress = track(route, frame, position);
+    in_order &= progress.waypoint == waypoint ||
+                progress.waypoint == waypoint + 1;
+    waypoint = progress.waypoint;
+    // 10 m off, except while cutting the corners
+    double corner = std::abs(progress.along_track -
+                             std::round(progress.along_track / SIDE) * SIDE);
+    on_track &= std::abs(std::abs(progress.cross_track) - 10.0) < 0.5 ||
+                corner < TURN_RADIUS;
+    CHECK(progress.last_leg == (progress.waypoint == 4));
+  }
+  CHECK(in_order);
+  CHECK(on_track);
+  CHECK(waypoint == 4);
+  CHECK(route.rejoins() == 0);
+
+  // pushed off the track near the start, which is also the end, tracking
+  // rejoins the first leg and does not skip the loop
+  route.seek(1);
+  RouteProgress progress = track(route, frame, {-250.0, 50.0});
+  CHECK(route.rejoins() == 1);
+  CHECK(progress.waypoint == 1);
+  CHECK(progress.along_track < 0.0);
+  // while on the closing leg it stays on that leg
+  route.seek(4);
+  progress = track(route, frame, {-250.0, 50.0});
+  CHECK(progress.waypoint == 4);
+  CHECK(progress.last_leg);
+
+  // the lookahead point lies on the track
+  route.seek(1);
+  progress = track(route, frame, {1000.0, 30.0});
+  EnuPoint lookahead = frame.to_local(progress.lookahead.latitude,
+                                      progress.lookahead.longitude);
+  CHECK_NEAR(lookahead.east, 1000.0 + LOOKAHEAD, 0.01);
+  CHECK_NEAR(lookahead.north, 0.0, 0.01);
+}
+
+void test_degenerate_legs() {
+  LocalFrame frame = make_frame();
+  RouteGeometry route(TURN_RADIUS, CELL_DEG);
+  route.build(make_route(frame, {{0, 0},
+                                 {0, 0},
+                                 {1000, 0},
+                                 {1000, 0},
+                                 {1000, 0},
+                                 {1000, 1500},
+                                 {1000, 1500}}));
+  // two legs remain, the second split in two
+  CHECK(route.has_legs());
+  CHECK(route.segments() == 3);
+  CHECK_NEAR(route.length(), 2500.0, 0.1);
+
+  // the legs end at the last of each run of duplicates
+  route.seek(1);
+  RouteProgress progress = track(route, frame, {500.0, -3.0});
+  CHECK(progress.waypoint == 2);
+  CHECK_NEAR(progress.cross_track, 3.0, 0.01);
+  CHECK(!progress.last_leg);
+  progress = track(route, frame, {1003.0, 1495.0});
+  CHECK(progress.waypoint == 5);
+  CHECK(progress.last_leg);
+  CHECK_NEAR(progress.leg_end_distance, std::sqrt(3.0 * 3.0 + 5.0 * 5.0),
+             0.01);
+
+  // routes of one point, or only duplicates, have nothing to track
+  RouteGeometry duplicates(TURN_RADIUS, CELL_DEG);
+  duplicates.build(make_route(frame, {{0, 0}, {0, 0}, {0, 0}}));
+  CHECK(!duplicates.has_legs());
+  duplicates.build(make_route(frame, {{0, 0}}));
+  CHECK(!duplicates.has_legs());
+
+  // a long leg is split so that each segment stays planar
+  RouteGeometry long_leg(TURN_RADIUS, CELL_DEG);
+  long_leg.build(make_route(frame, {{0, 0}, {0, 9500}}));
+  CHECK(long_leg.segments() == 10);
+  CHECK_NEAR(long_leg.length(), 9500.0, 0.1);
+}
+
+// 5000 waypoints zigzagging with legs of 360 m
+void test_large_route() {
+  const int WAYPOINTS = 5000;
+  LocalFrame frame = make_frame();
+  std::vector<EnuPoint> points;
+  for (int i = 0; i < WAYPOINTS; ++i) {
+    points.push_back({i * 300.0 - 750000.0, (i % 2) * 200.0});
+  }
+  Autopilot::WaypointSeq waypoints = make_route(frame, points);
+
+  RouteGeometry route(TURN_RADIUS, CELL_DEG);
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  route.build(waypoints);
+  double build_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  CHECK(route.segments() == WAYPOINTS - 1);
+  CHECK_NEAR(route.length(), (WAYPOINTS - 1) * std::sqrt(300.0 * 300.0 +
+                                                         200.0 * 200.0),
+             (WAYPOINTS - 1) * 0.1);
+
+  // far from the current leg, the grid finds the leg nearby
+  route.seek(10);
+  RouteProgress progress =
+      track(route, frame, {3000 * 300.0 - 750000.0 + 100.0, 300.0});
+  CHECK(route.rejoins() == 1);
+  CHECK(progress.waypoint == 3001);
+
+  // follow the whole route, every waypoint is passed in order
+  std::vector<EnuPoint> path;
+  for (double x = 0.0; x < (WAYPOINTS - 1) * 300.0; x += 2.0) {
+    int leg = static_cast<int>(x / 300.0);
+    double f = (x - leg * 300.0) / 300.0;
+    double y0 = (leg % 2) * 200.0;
+    double y1 = ((leg + 1) % 2) * 200.0;
+    path.push_back({x - 750000.0, y0 + f * (y1 - y0) + 5.0});
+  }
+  std::vector<std::pair<double, double>> positions(path.size());
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    frame.to_geodetic(path[i], positions[i].first, positions[i].second);
+  }
+  route.seek(1);
+  CORBA::ULong waypoint = 1;
+  bool in_order = true;
+  double ns = xluuv_test::time_per_call(
+      static_cast<int>(positions.size()), [&](int i) {
+        RouteProgress p = route.track(positions[i].first,
+                                      positions[i].second, LOOKAHEAD);
+        in_order &= p.waypoint == waypoint || p.waypoint == waypoint + 1;
+        waypoint = p.waypoint;
+      });
+  CHECK(in_order);
+  CHECK(waypoint == WAYPOINTS - 1);
+  CHECK(route.rejoins() == 1);
+
+  std::printf("%d waypoints: built in %.2f ms, %.1f ns per track()\n",
+              WAYPOINTS, build_ms, ns);
+  // a cycle does not depend on the size of the route
+  CHECK(ns < 1000.0);
+}
+
+}  // namespace
+
+int main() {
+  test_closed_loop();
+  test_degenerate_legs();
+  test_large_route();
+  return xluuv_test::test_exit("route-geometry-test");
+}
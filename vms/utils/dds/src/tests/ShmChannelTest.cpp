@@ -0,0 +1,137 @@
+// Two processes on one shared memory channel: the child produces sensor
+// reports as fast as the ring takes them, the parent consumes them and checks
+// that they arrive complete and in order, and measures the latency from send
+// to receive. AIS records and a size mismatch are checked in-process.
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../BcProxyMessages.h"
+#include "../shm/ShmChannel.h"
+#include "Check.h"
+
+namespace {
+
+const int REPORTS = 200000;
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// per process, so that parallel ctest runs do not share segments
+std::string channel_name(const char* stream) {
+  return std::string("/xluuv-test-") + stream + "-" +
+         std::to_string(getpid());
+}
+
+int produce(const std::string& name) {
+  ShmChannel<SensorReport> channel;
+  if (channel.open(name, ShmChannel<SensorReport>::PRODUCER)) return 2;
+  SensorReport report{};
+  for (int i = 0; i < REPORTS;) {
+    report.depth = i;
+    report.speed = static_cast<double>(now_ns());
+    if (channel.send(report)) {
+      ++i;
+    } else {
+      std::this_thread::yield();  // ring full, BC would drop the report
+    }
+  }
+  return 0;
+}
+
+void test_two_processes() {
+  std::string name = channel_name("sensors");
+  shm_unlink(name.c_str());
+  // the consumer attaches first, it skips whatever is already in the ring
+  ShmChannel<SensorReport> channel;
+  CHECK(!channel.open(name, ShmChannel<SensorReport>::CONSUMER));
+  if (!channel.is_open()) return;
+
+  pid_t pid = fork();
+  if (pid == 0) _exit(produce(name));
+  CHECK(pid > 0);
+
+  std::vector<int64_t> latencies;
+  latencies.reserve(REPORTS);
+  int received = 0;
+  int out_of_order = 0;
+  SensorReport report;
+  while (received < REPORTS && channel.receive(report, 2000)) {
+    latencies.push_back(now_ns() - static_cast<int64_t>(report.speed));
+    if (report.depth != received) ++out_of_order;
+    ++received;
+  }
+  int status = -1;
+  waitpid(pid, &status, 0);
+  shm_unlink(name.c_str());
+
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  CHECK(received == REPORTS);
+  CHECK(out_of_order == 0);
+  if (latencies.empty()) return;
+  std::sort(latencies.begin(), latencies.end());
+  std::printf("%d reports, latency p50 %.1f us, p99 %.1f us\n", received,
+              latencies[latencies.size() / 2] / 1e3,
+              latencies[latencies.size() * 99 / 100] / 1e3);
+}
+
+void test_ais_records() {
+  std::string name = channel_name("aivdm");
+  shm_unlink(name.c_str());
+  ShmChannel<AivdmRecord> consumer;
+  ShmChannel<AivdmRecord> producer;
+  CHECK(!consumer.open(name, ShmChannel<AivdmRecord>::CONSUMER));
+  CHECK(!producer.open(name, ShmChannel<AivdmRecord>::PRODUCER));
+
+  AivdmMessage sent;
+  sent.message = "!AIVDM,1,1,,A,13u?etPv2;0n:dDPwUM1U1Cb069D,0*24";
+  sent.message_type = 1;
+  sent.mmsi = 265547250;
+  sent.navigation_status = 0;
+  sent.latitude = 50.0347;
+  sent.longitude = -9.974;
+  sent.rate_of_turn = -2;
+  sent.speed_over_ground = 13.9;
+  sent.course_over_ground = 40.4;
+  sent.true_heading = 41;
+  CHECK(producer.send(to_record(sent)));
+
+  AivdmRecord record;
+  CHECK(consumer.receive(record, 100));
+  AivdmMessage received = from_record(record);
+  CHECK(received.message == sent.message);
+  CHECK(received.mmsi == sent.mmsi);
+  CHECK(received.latitude == sent.latitude);
+  CHECK(received.true_heading == sent.true_heading);
+  // nothing more to take, and an empty ring times out
+  CHECK(!consumer.receive(record, 10));
+
+  // a full ring drops and counts instead of overwriting
+  for (int i = 0; i < 64; ++i) CHECK(producer.send(to_record(sent)));
+  CHECK(!producer.send(to_record(sent)));
+  CHECK(producer.dropped() == 1);
+
+  // a peer built with another message size is refused
+  ShmChannel<ActuatorCommands> other;
+  CHECK(other.open(name, ShmChannel<ActuatorCommands>::CONSUMER));
+  shm_unlink(name.c_str());
+}
+
+}  // namespace
+
+int main() {
+  test_ais_records();
+  test_two_processes();
+  return xluuv_test::test_exit("shm-channel-test");
+}
@@ -0,0 +1,217 @@
+// Coalescing and rate limits of the telemetry hub, heap allocations per
+// report on the UDP and stream paths, and a StreamTelemetry call over an
+// in-process gRPC channel that has to keep up with a publisher far faster
+// than its rate limit.
+
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cccproxy/TelemetryHub.h"
+#include "../cccproxy/XLUUVServiceImpl.h"
+#include "Check.h"
+
+namespace {
+std::atomic<uint64_t> allocations(0);
+}
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+const char* const AIS_SENTENCE =
+    "!AIVDM,1,1,,B,13u?etPv2;0n:dDPwUM1U1Cb069D,0*24\r\n";
+
+// as the listeners build them
+std::shared_ptr<TelemetryFrame> sensor_frame(TelemetryHub& hub, double cog) {
+  std::shared_ptr<TelemetryFrame> frame = hub.make_frame();
+  SensorReport* report = frame->report->mutable_sensor_report();
+  report->mutable_gnss_1()->set_latitude(50.0347);
+  report->mutable_gnss_1()->set_longitude(-9.974);
+  report->mutable_gnss_2()->set_latitude(50.0347);
+  report->mutable_gnss_2()->set_longitude(-9.974);
+  report->mutable_gnss_3()->set_latitude(50.0347);
+  report->mutable_gnss_3()->set_longitude(-9.974);
+  report->set_cog(cog);
+  report->set_heading(251);
+  report->set_sog(8);
+  return frame;
+}
+
+std::shared_ptr<TelemetryFrame> ais_frame(TelemetryHub& hub) {
+  std::shared_ptr<TelemetryFrame> frame = hub.make_frame();
+  frame->report->mutable_nmea_report()->mutable_msg()->assign(AIS_SENTENCE);
+  return frame;
+}
+
+void test_coalescing() {
+  TelemetryHub hub;
+  std::shared_ptr<TelemetrySubscriber> subscriber = hub.subscribe(10);
+  for (int i = 0; i < 1000; ++i) {
+    hub.publish(sensor_frame(hub, i));
+    hub.publish(ais_frame(hub), 235000000 + i % 3);
+  }
+
+  // one sensor report and one per AIS target, the latest of each
+  std::vector<std::shared_ptr<const TelemetryFrame>> frames;
+  CHECK(subscriber->take(frames, std::chrono::milliseconds(100)));
+  CHECK(frames.size() == 4);
+  CHECK(subscriber->coalesced() == 1996);
+  for (size_t i = 1; i < frames.size(); ++i) {
+    CHECK(frames[i - 1]->seq < frames[i]->seq);
+  }
+  int sensors = 0;
+  for (const auto& frame : frames) {
+    if (frame->report->has_sensor_report()) {
+      ++sensors;
+      CHECK(frame->report->sensor_report().cog() == 999);
+    }
+  }
+  CHECK(sensors == 1);
+
+  // at 10 Hz the next flush is held back for 100 ms
+  hub.publish(sensor_frame(hub, 1000));
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  CHECK(subscriber->take(frames, std::chrono::milliseconds(500)));
+  double waited_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  CHECK(waited_ms > 80);
+  CHECK(frames.size() == 1);
+
+  // nothing pending, and closed subscribers return straight away
+  CHECK(!subscriber->take(frames, std::chrono::milliseconds(150)));
+  hub.unsubscribe(subscriber);
+  CHECK(!subscriber->take(frames, std::chrono::milliseconds(500)));
+}
+
+// Heap allocations to build, publish and send reports of one kind, once the
+// send buffer has grown
+template <typename MakeFrame>
+double allocations_per_report(TelemetryHub& hub, MakeFrame make_frame,
+                              bool copy) {
+  const int REPORTS = 10000;
+  std::string send_buffer;
+  serialize_frame(*make_frame(0), send_buffer);
+  uint64_t before = allocations.load();
+  for (int i = 0; i < REPORTS; ++i) {
+    std::shared_ptr<TelemetryFrame> frame = make_frame(i);
+    if (copy) {
+      // as the UDP path used to send
+      send_buffer = frame->report->SerializeAsString();
+    } else {
+      serialize_frame(*frame, send_buffer);
+    }
+    hub.publish(frame, 235000000);
+  }
+  return static_cast<double>(allocations.load() - before) / REPORTS;
+}
+
+void test_allocations() {
+  TelemetryHub hub;
+  std::shared_ptr<TelemetrySubscriber> subscriber = hub.subscribe(0);
+  auto sensors = [&hub](int i) { return sensor_frame(hub, i); };
+  auto ais = [&hub](int) { return ais_frame(hub); };
+  double sensor_allocations = allocations_per_report(hub, sensors, false);
+  double ais_allocations = allocations_per_report(hub, ais, false);
+  std::printf("allocations per report: sensors %.2f (%.2f with "
+              "SerializeAsString), AIS %.2f (%.2f)\n",
+              sensor_allocations, allocations_per_report(hub, sensors, true),
+              ais_allocations, allocations_per_report(hub, ais, true));
+  // the frame with its arena, the send buffer and the subscriber's pending
+  // slot are reused
+  CHECK(sensor_allocations < 1.01);
+  // and the sentence, which is longer than the short string buffer
+  CHECK(ais_allocations < 2.01);
+  hub.unsubscribe(subscriber);
+}
+
+// A client limited to 20 Hz against a publisher at about 1 kHz
+void test_stream() {
+  TelemetryHub hub;
+  // StreamTelemetry only uses the hub, the DDS writers are left empty
+  XLUUVServiceImpl service(
+      Autopilot::RouteDataWriter_var(),
+      Autopilot::AutopilotCommandDataWriter_var(),
+      Autopilot::LoiterPositionDataWriter_var(),
+      Autopilot::DiveProcedureDataWriter_var(),
+      Autopilot::MissionDataWriter_var(),
+      Autopilot::MissionCommandDataWriter_var(),
+      Autopilot::ProcedureActivationDataWriter_var(), hub);
+  grpc::ServerBuilder builder;
+  builder.RegisterService(&service);
+  std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+  CHECK(server != nullptr);
+  if (server == nullptr) return;
+  std::unique_ptr<XLUUV::Stub> stub =
+      XLUUV::NewStub(server->InProcessChannel(grpc::ChannelArguments()));
+
+  const int PUBLISHED = 1000;
+  std::atomic<bool> done(false);
+  std::thread publisher([&] {
+    for (int i = 0; i < PUBLISHED; ++i) {
+      hub.publish(sensor_frame(hub, i));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // keep the last report coming in case the stream opened late
+    while (!done.load()) {
+      hub.publish(sensor_frame(hub, PUBLISHED - 1));
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+
+  grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now() +
+                       std::chrono::seconds(10));
+  TelemetrySubscription subscription;
+  subscription.set_max_rate_hz(20);
+  std::unique_ptr<grpc::ClientReader<TelemetryReport>> reader =
+      stub->StreamTelemetry(&context, subscription);
+  TelemetryReport report;
+  int received = 0;
+  double last = -1;
+  bool in_order = true;
+  while (reader->Read(&report)) {
+    ++received;
+    in_order &= report.sensor_report().cog() >= last;
+    last = report.sensor_report().cog();
+    if (last == PUBLISHED - 1) break;
+  }
+  context.TryCancel();
+  reader->Finish();
+  done.store(true);
+  publisher.join();
+  server->Shutdown();
+
+  std::printf("stream: %d published, %d received\n", PUBLISHED, received);
+  CHECK(last == PUBLISHED - 1);
+  CHECK(in_order);
+  // about a second at 20 Hz, with room for a slow machine
+  CHECK(received > 0);
+  CHECK(received < PUBLISHED / 10);
+}
+
+}  // namespace
+
+int main() {
+  test_coalescing();
+  test_allocations();
+  test_stream();
+  return xluuv_test::test_exit("telemetry-test");
+}
@@ -0,0 +1,188 @@
+// 10000 timers on the wheel against an ordered reference, on simulated time
+// with a fixed seed: cancels, deadlines in the past and beyond the top level
+// included, no timer may fire early, late or out of order. Then a mission of
+// 10000 items driven from the wheel's next deadline, and suspend/resume.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../AsyncLog.h"
+#include "../autopilot/AutopilotController.h"
+#include "../autopilot/ControlClock.h"
+#include "../autopilot/MissionController.h"
+#include "../autopilot/TimerWheel.h"
+#include "Check.h"
+
+namespace {
+
+const ACE_hrtime_t MS = 1000000;
+const ACE_hrtime_t SECOND = 1000 * MS;
+const int TIMERS = 10000;
+// when the reference test schedules its timers
+const ACE_hrtime_t SCHEDULED = 5 * SECOND;
+
+void test_against_reference() {
+  std::mt19937_64 rng(37);
+  // up to 4.6 hours, past the 64^4 ms of the top level
+  std::uniform_int_distribution<ACE_hrtime_t> delay(0, 16777 * SECOND);
+  std::uniform_int_distribution<ACE_hrtime_t> step(0, 600 * SECOND);
+  std::uniform_int_distribution<int> percent(0, 99);
+
+  ACE_hrtime_t now = SCHEDULED;
+  TimerWheel wheel(MS, now);
+  // deadline of each payload still pending, and the handles to cancel
+  std::map<uint32_t, ACE_hrtime_t> pending;
+  std::vector<std::pair<TimerWheel::Handle, uint32_t>> handles;
+  for (uint32_t i = 0; i < TIMERS; ++i) {
+    ACE_hrtime_t deadline;
+    if (percent(rng) < 5) {
+      deadline = now - std::min(now, delay(rng) % SECOND);  // already due
+    } else {
+      deadline = now + delay(rng);
+    }
+    handles.emplace_back(wheel.schedule(deadline, i), i);
+    pending[i] = deadline;
+  }
+  CHECK(wheel.size() == TIMERS);
+
+  uint64_t fired_count = 0;
+  uint64_t cancelled = 0;
+  bool early = false;
+  bool late = false;
+  bool ordered = true;
+  std::vector<uint32_t> fired;
+  while (!pending.empty()) {
+    now += step(rng);
+    // cancel a few, some of them twice or after they fired
+    for (int k = 0; k < 10; ++k) {
+      std::pair<TimerWheel::Handle, uint32_t> entry =
+          handles[rng() % handles.size()];
+      bool was_pending = pending.count(entry.second) > 0;
+      CHECK(wheel.cancel(entry.first) == was_pending);
+      if (was_pending) {
+        pending.erase(entry.second);
+        ++cancelled;
+      }
+    }
+
+    fired.clear();
+    wheel.advance(now, fired);
+    ACE_hrtime_t previous = 0;
+    for (uint32_t payload : fired) {
+      auto found = pending.find(payload);
+      CHECK(found != pending.end());
+      if (found == pending.end()) continue;
+      early |= found->second > now;
+      // deadlines round up to the next tick, those already past when
+      // scheduled are all due at once
+      ACE_hrtime_t due =
+          std::max((found->second + MS - 1) / MS * MS, SCHEDULED);
+      ordered &= due >= previous;
+      previous = due;
+      pending.erase(found);
+      ++fired_count;
+    }
+    // everything due by now has fired
+    for (const auto& entry : pending) {
+      late |= (entry.second + MS - 1) / MS * MS <= now;
+    }
+    CHECK(wheel.size() == pending.size());
+    CHECK(pending.empty() || wheel.next_deadline() <= now + 16777 * SECOND);
+  }
+  CHECK(!early);
+  CHECK(!late);
+  CHECK(ordered);
+  CHECK(fired_count + cancelled == TIMERS);
+  CHECK(wheel.size() == 0);
+  CHECK(wheel.next_deadline() == ACE_UINT64_MAX);
+  std::printf("%d timers: %llu fired, %llu cancelled\n", TIMERS,
+              static_cast<unsigned long long>(fired_count),
+              static_cast<unsigned long long>(cancelled));
+}
+
+Autopilot::Mission make_mission() {
+  Autopilot::Mission mission;
+  mission.id = 1;
+  mission.name = "timer-wheel-test";
+  mission.mission_items.length(TIMERS);
+  for (int i = 0; i < TIMERS; ++i) {
+    Autopilot::MissionItem& item = mission.mission_items[i];
+    item.until_completion = false;
+    item.timeout = 30 + i % 90;
+    if (i % 3 == 0) {
+      item.action.loiter_pos_id(i);
+    } else if (i % 3 == 1) {
+      item.action.dive_proc_id(i);
+    } else {
+      item.action.ap_cmd(Autopilot::AC_ROUTE_SUSPEND);
+    }
+  }
+  return mission;
+}
+
+// jumps from event to event until the mission is over
+void test_mission() {
+  SimulatedClock clock;
+  AutopilotController autopilot(clock, 250 * MS);
+  MissionController mission(&autopilot, clock);
+  mission.set_mission(make_mission());
+  mission.execute_command(Autopilot::MC_START);
+
+  ACE_hrtime_t start = clock.now();
+  uint64_t runs = 0;
+  bool finished = false;
+  // an event per item and the periodic reports in between
+  while (runs < 1000 * TIMERS) {
+    ACE_hrtime_t next = mission.next_event();
+    if (next == ACE_UINT64_MAX) break;
+    clock.sleep_until(next);
+    mission.run();
+    ++runs;
+    if (mission.is_report_available() &&
+        mission.get_report().status == Autopilot::MS_DISABLED) {
+      finished = true;
+      break;
+    }
+  }
+  double expected = 0.0;
+  for (int i = 0; i < TIMERS; ++i) expected += 30 + i % 90;
+  double simulated = (clock.now() - start) * 1e-9;
+  std::printf("mission of %d items: %.0f s simulated in %llu runs\n", TIMERS,
+              simulated, static_cast<unsigned long long>(runs));
+  CHECK(finished);
+  CHECK_NEAR(simulated, expected, 0.001 * TIMERS);
+
+  // suspended for 1000 s, 10 s into the 30 s timeout of the first item,
+  // the remaining 20 s are kept
+  mission.execute_command(Autopilot::MC_START);
+  start = clock.now();
+  clock.advance(10 * SECOND);
+  mission.run();
+  mission.execute_command(Autopilot::MC_SUSPEND);
+  clock.advance(1000 * SECOND);
+  mission.run();
+  mission.execute_command(Autopilot::MC_RESUME);
+  // reports may be due before the item times out
+  for (int i = 0; i < 100 && mission.get_report().progress == 1; ++i) {
+    clock.sleep_until(mission.next_event());
+    mission.run();
+  }
+  CHECK(mission.get_report().progress == 2);
+  CHECK_NEAR((clock.now() - start) * 1e-9, 1030.0, 0.001);
+}
+
+}  // namespace
+
+int main() {
+  // the controllers log every transition at debug level
+  if (std::getenv("XLUUV_LOG") == nullptr) {
+    xluuv_log::Logger::instance().configure("all=warning");
+  }
+  test_against_reference();
+  test_mission();
+  return xluuv_test::test_exit("timer-wheel-test");
+}